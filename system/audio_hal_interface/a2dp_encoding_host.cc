@@ -34,6 +34,8 @@
 #include "udrv/include/uipc.h"
 
 #define A2DP_DATA_READ_POLL_MS 10
+// Move the PCM to shared memory, when the audio server supports it
+#define A2DP_SHM_RING_PROPERTY "bluetooth.audio.host_shm_ring.enabled"
 #define A2DP_HOST_DATA_PATH "/var/run/bluetooth/audio/.a2dp_data"
 // TODO(b/198260375): Make A2DP data owner group configurable.
 #define A2DP_HOST_DATA_GROUP "bluetooth-audio"
@@ -57,6 +59,10 @@ static void btif_a2dp_data_cb([[maybe_unused]] tUIPC_CH_ID ch_id,
                  UIPC_REG_REMOVE_ACTIVE_READSET, NULL);
       UIPC_Ioctl(*a2dp_uipc, UIPC_CH_ID_AV_AUDIO, UIPC_SET_READ_POLL_TMO,
                  reinterpret_cast<void*>(A2DP_DATA_READ_POLL_MS));
+      if (osi_property_get_bool(A2DP_SHM_RING_PROPERTY, false)) {
+        UIPC_Ioctl(*a2dp_uipc, UIPC_CH_ID_AV_AUDIO, UIPC_SET_SHM_RING,
+                   reinterpret_cast<void*>(UIPC_SHM_DEFAULT_RING_SIZE));
+      }
 
       // Will start audio on btif_a2dp_on_started
 
@@ -40,6 +40,7 @@
 #include "osi/include/osi.h"  // UNUSED_ATTR
 #include "stack/include/acl_api.h"
 #include "stack/include/bt_hdr.h"
+#include "stack/include/btm_api.h"
 #include "stack/include/hiddefs.h"
 #include "stack/include/hidh_api.h"
 #include "types/bluetooth/uuid.h"
@@ -629,6 +630,11 @@ void bta_hh_open_cmpl_act(tBTA_HH_DEV_CB* p_cb, const tBTA_HH_DATA* p_data) {
                      "%s initiator:%s", (p_cb->is_le_device) ? "le" : "classic",
                      (p_cb->incoming_conn) ? "remote" : "local"));
 
+  /* send the HID reports ahead of the bulk data of the other links */
+  BTM_SetAclTxLatencyClass(
+      p_cb->addr, p_cb->is_le_device ? BT_TRANSPORT_LE : BT_TRANSPORT_BR_EDR,
+      BTM_ACL_TX_INTERACTIVE);
+
   if (!p_cb->is_le_device)
   {
     /* inform role manager */
@@ -23,6 +23,7 @@
 #include "bta/include/bta_le_audio_broadcaster_api.h"
 #include "bta/le_audio/broadcaster/state_machine.h"
 #include "bta/le_audio/content_control_id_keeper.h"
+#include "bta/le_audio/lc3_multi_channel_encoder.h"
 #include "bta/le_audio/le_audio_types.h"
 #include "bta/le_audio/le_audio_utils.h"
 #include "bta/le_audio/metrics_collector.h"
@@ -867,26 +868,23 @@ class LeAudioBroadcasterImpl : public LeAudioBroadcaster, public BigCallbacks {
         return;
       }
 
-      if (enc_audio_buffers_.size() != codec_wrapper_.GetNumChannels()) {
-        enc_audio_buffers_.resize(codec_wrapper_.GetNumChannels());
-      }
-
-      const int dt_us = codec_wrapper_.GetDataIntervalUs();
-      const int sr_hz = codec_wrapper_.GetSampleRate();
-      const auto encoder_bytes = lc3_encoder_size(dt_us, sr_hz);
-      const auto channel_bytes = codec_wrapper_.GetMaxSduSizePerChannel();
+      /* Large broadcasts encode their channels in parallel */
+      const int num_channels = codec_wrapper_.GetNumChannels();
+      const int num_workers =
+          num_channels > 2 ? std::min(num_channels, kMaxEncoderThreads) - 1
+                           : 0;
 
       /* TODO: We should act smart and reuse current configurations */
-      encoders_.clear();
-      encoders_mem_.clear();
-      while (encoders_.size() < codec_wrapper_.GetNumChannels()) {
-        auto& encoder_buf = enc_audio_buffers_.at(encoders_.size());
-        encoder_buf.resize(channel_bytes);
-
-        encoders_mem_.emplace_back(malloc(encoder_bytes), &std::free);
-        encoders_.emplace_back(
-            lc3_setup_encoder(dt_us, sr_hz, 0, encoders_mem_.back().get()));
-      }
+      encoder_.Setup({
+          .dt_us = static_cast<int>(codec_wrapper_.GetDataIntervalUs()),
+          .sr_hz = static_cast<int>(codec_wrapper_.GetSampleRate()),
+          .pcm_sr_hz = 0,
+          .pcm_bits_per_sample = codec_wrapper_.GetBitsPerSample(),
+          .pcm_num_channels = num_channels,
+          .num_channels = num_channels,
+          .octets_per_frame = codec_wrapper_.GetMaxSduSizePerChannel(),
+          .num_workers = num_workers,
+      });
     }
 
     const BroadcastCodecWrapper& getCurrentCodecConfig(void) const {
@@ -897,23 +895,9 @@ class LeAudioBroadcasterImpl : public LeAudioBroadcaster, public BigCallbacks {
       codec_wrapper_ = config;
     }
 
-    void encodeLc3Channel(lc3_encoder_t encoder,
-                          std::vector<uint8_t>& out_buffer,
-                          const std::vector<uint8_t>& data,
-                          int initial_channel_offset, int pitch_samples,
-                          int num_channels) {
-      auto encoder_status =
-          lc3_encode(encoder, LC3_PCM_FORMAT_S16,
-                     (int16_t*)(data.data() + initial_channel_offset),
-                     pitch_samples, out_buffer.size(), out_buffer.data());
-      if (encoder_status != 0) {
-        LOG_ERROR("Encoding error=%d", encoder_status);
-      }
-    }
-
     static void sendBroadcastData(
         const std::unique_ptr<BroadcastStateMachine>& broadcast,
-        std::vector<std::vector<uint8_t>>& encoded_channels) {
+        const Lc3MultiChannelEncoder& encoder) {
       auto const& config = broadcast->GetBigConfig();
       if (config == std::nullopt) {
         LOG_ERROR(
@@ -924,15 +908,16 @@ class LeAudioBroadcasterImpl : public LeAudioBroadcaster, public BigCallbacks {
         return;
       }
 
-      if (config->connection_handles.size() < encoded_channels.size()) {
+      if (config->connection_handles.size() <
+          static_cast<size_t>(encoder.GetNumChannels())) {
         LOG_ERROR("Not enough BIS'es to broadcast all channels!");
         return;
       }
 
-      for (uint8_t chan = 0; chan < encoded_channels.size(); ++chan) {
+      for (int chan = 0; chan < encoder.GetNumChannels(); ++chan) {
         IsoManager::GetInstance()->SendIsoData(config->connection_handles[chan],
-                                               encoded_channels[chan].data(),
-                                               encoded_channels[chan].size());
+                                               encoder.GetChannelData(chan),
+                                               encoder.GetOctetsPerFrame());
       }
     }
 
@@ -941,15 +926,12 @@ class LeAudioBroadcasterImpl : public LeAudioBroadcaster, public BigCallbacks {
 
       LOG_VERBOSE("Received %zu bytes.", data.size());
 
-      /* Constants for the channel data configuration */
-      const auto num_channels = codec_wrapper_.GetNumChannels();
-      const auto bytes_per_sample = (codec_wrapper_.GetBitsPerSample() / 8);
-
       /* Prepare encoded data for all channels */
-      for (uint8_t chan = 0; chan < num_channels; ++chan) {
-        /* TODO: Use encoder agnostic wrapper */
-        encodeLc3Channel(encoders_[chan], enc_audio_buffers_[chan], data,
-                         chan * bytes_per_sample, num_channels, num_channels);
+      /* TODO: Use encoder agnostic wrapper */
+      if (!encoder_.Encode(data.data(), data.size())) {
+        LOG_ERROR("Encoding error, data size=%zu expected=%zu", data.size(),
+                  encoder_.GetPcmIntervalSize());
+        return;
       }
 
       /* Currently there is no way to broadcast multiple distinct streams.
@@ -961,7 +943,7 @@ class LeAudioBroadcasterImpl : public LeAudioBroadcaster, public BigCallbacks {
         if ((broadcast->GetState() ==
              BroadcastStateMachine::State::STREAMING) &&
             !broadcast->IsMuted())
-          sendBroadcastData(broadcast, enc_audio_buffers_);
+          sendBroadcastData(broadcast, encoder_);
       }
       LOG_VERBOSE("All data sent.");
     }
@@ -1011,10 +993,11 @@ class LeAudioBroadcasterImpl : public LeAudioBroadcaster, public BigCallbacks {
     }
 
    private:
+    /* Upper bound of the threads encoding the channels of a broadcast */
+    static constexpr int kMaxEncoderThreads = 4;
+
     BroadcastCodecWrapper codec_wrapper_;
-    std::vector<lc3_encoder_t> encoders_;
-    std::vector<std::unique_ptr<void, decltype(&std::free)>> encoders_mem_;
-    std::vector<std::vector<uint8_t>> enc_audio_buffers_;
+    Lc3MultiChannelEncoder encoder_;
   } audio_receiver_;
 
   bluetooth::le_audio::LeAudioBroadcasterCallbacks* callbacks_;
@@ -43,6 +43,7 @@
 #include "gatt/bta_gattc_int.h"
 #include "gd/common/strings.h"
 #include "internal_include/stack_config.h"
+#include "lc3_multi_channel_encoder.h"
 #include "le_audio_set_configuration_provider.h"
 #include "le_audio_types.h"
 #include "le_audio_utils.h"
@@ -71,6 +72,7 @@ using bluetooth::le_audio::GroupStreamStatus;
 using le_audio::CodecManager;
 using le_audio::ContentControlIdKeeper;
 using le_audio::DeviceConnectState;
+using le_audio::Lc3MultiChannelEncoder;
 using le_audio::LeAudioCodecConfiguration;
 using le_audio::LeAudioDevice;
 using le_audio::LeAudioDeviceGroup;
@@ -159,13 +161,6 @@ std::ostream& operator<<(std::ostream& os, const AudioState& audio_state) {
 namespace {
 void le_audio_gattc_callback(tBTA_GATTC_EVT event, tBTA_GATTC* p_data);
 
-inline uint8_t bits_to_bytes_per_sample(uint8_t bits_per_sample) {
-  // 24 bit audio stream is sent as unpacked, each sample takes 4 bytes.
-  if (bits_per_sample == 24) return 4;
-
-  return bits_per_sample / 8;
-}
-
 inline lc3_pcm_format bits_to_lc3_bits(uint8_t bits_per_sample) {
   if (bits_per_sample == 16) return LC3_PCM_FORMAT_S16;
 
@@ -240,8 +235,6 @@ class LeAudioClientImpl : public LeAudioClient {
         in_call_(false),
         current_source_codec_config({0, 0, 0, 0, 0}),
         current_sink_codec_config({0, 0, 0, 0, 0}),
-        lc3_encoder_left_mem(nullptr),
-        lc3_encoder_right_mem(nullptr),
         lc3_decoder_left_mem(nullptr),
         lc3_decoder_right_mem(nullptr),
         lc3_decoder_left(nullptr),
@@ -1948,6 +1941,10 @@ class LeAudioClientImpl : public LeAudioClient {
 
     BTM_RequestPeerSCA(leAudioDevice->address_, transport);
 
+    /* The control point writes and notifications drive the streams */
+    BTM_SetAclTxLatencyClass(leAudioDevice->address_, transport,
+                             BTM_ACL_TX_ISOCHRONOUS_ADJACENT);
+
     if (leAudioDevice->GetConnectionState() ==
         DeviceConnectState::CONNECTING_AUTOCONNECT) {
       leAudioDevice->SetConnectionState(
@@ -2959,54 +2956,12 @@ class LeAudioClientImpl : public LeAudioClient {
     return true;
   }
 
-  // mix stero signal into mono
-  std::vector<uint8_t> mono_blend(const std::vector<uint8_t>& buf,
-                                  int bytes_per_sample, size_t frames) {
-    std::vector<uint8_t> mono_out;
-    mono_out.resize(frames * bytes_per_sample);
-
-    if (bytes_per_sample == 2) {
-      int16_t* out = (int16_t*)mono_out.data();
-      const int16_t* in = (int16_t*)(buf.data());
-      for (size_t i = 0; i < frames; ++i) {
-        int accum = 0;
-        accum += *in++;
-        accum += *in++;
-        accum /= 2;  // round to 0
-        *out++ = accum;
-      }
-    } else if (bytes_per_sample == 4) {
-      int32_t* out = (int32_t*)mono_out.data();
-      const int32_t* in = (int32_t*)(buf.data());
-      for (size_t i = 0; i < frames; ++i) {
-        int accum = 0;
-        accum += *in++;
-        accum += *in++;
-        accum /= 2;  // round to 0
-        *out++ = accum;
-      }
-    } else {
-      LOG_ERROR("Don't know how to mono blend that %d!", bytes_per_sample);
-    }
-    return mono_out;
-  }
-
   void PrepareAndSendToTwoCises(
       const std::vector<uint8_t>& data,
       struct le_audio::stream_configuration* stream_conf) {
     uint16_t byte_count = stream_conf->sink_octets_per_codec_frame;
     uint16_t left_cis_handle = 0;
     uint16_t right_cis_handle = 0;
-    uint16_t number_of_required_samples_per_channel;
-
-    int dt_us = current_source_codec_config.data_interval_us;
-    int af_hz = audio_framework_source_config.sample_rate;
-    number_of_required_samples_per_channel = lc3_frame_samples(dt_us, af_hz);
-
-    lc3_pcm_format bits_per_sample =
-        bits_to_lc3_bits(audio_framework_source_config.bits_per_sample);
-    uint8_t bytes_per_sample =
-        bits_to_bytes_per_sample(audio_framework_source_config.bits_per_sample);
 
     for (auto [cis_handle, audio_location] : stream_conf->sink_streams) {
       if (audio_location & le_audio::codec_spec_conf::kLeAudioLocationAnyLeft)
@@ -3015,38 +2970,28 @@ class LeAudioClientImpl : public LeAudioClient {
         right_cis_handle = cis_handle;
     }
 
-    if (data.size() < bytes_per_sample * 2 /* channels */ *
-                          number_of_required_samples_per_channel) {
-      LOG(ERROR) << __func__ << " Missing samples. Data size: " << +data.size()
-                 << " expected: "
-                 << bytes_per_sample * 2 *
-                        number_of_required_samples_per_channel;
+    if (byte_count != lc3_encoder_.GetOctetsPerFrame()) {
+      LOG_ERROR("Codec frame size %d, the encoder expects %d", byte_count,
+                lc3_encoder_.GetOctetsPerFrame());
       return;
     }
 
-    std::vector<uint8_t> chan_left_enc(byte_count, 0);
-    std::vector<uint8_t> chan_right_enc(byte_count, 0);
-
+    /* Since we always get two channels from framework, make it mono when
+     * streaming to a single CIS */
     bool mono = (left_cis_handle == 0) || (right_cis_handle == 0);
-
-    if (!mono) {
-      lc3_encode(lc3_encoder_left, bits_per_sample, data.data(), 2,
-                 chan_left_enc.size(), chan_left_enc.data());
-      lc3_encode(lc3_encoder_right, bits_per_sample,
-                 data.data() + bytes_per_sample, 2, chan_right_enc.size(),
-                 chan_right_enc.data());
-    } else {
-      std::vector<uint8_t> mono = mono_blend(
-          data, bytes_per_sample, number_of_required_samples_per_channel);
-      if (left_cis_handle) {
-        lc3_encode(lc3_encoder_left, bits_per_sample, mono.data(), 1,
-                   chan_left_enc.size(), chan_left_enc.data());
-      }
-
-      if (right_cis_handle) {
-        lc3_encode(lc3_encoder_right, bits_per_sample, mono.data(), 1,
-                   chan_right_enc.size(), chan_right_enc.data());
-      }
+    int left_source = mono ? Lc3MultiChannelEncoder::kSourceMonoMix : 0;
+    int right_source = mono ? Lc3MultiChannelEncoder::kSourceMonoMix : 1;
+    if (left_cis_handle == 0) left_source = Lc3MultiChannelEncoder::kSourceNone;
+    if (right_cis_handle == 0)
+      right_source = Lc3MultiChannelEncoder::kSourceNone;
+
+    lc3_encoder_.SetChannelSource(0, left_source);
+    lc3_encoder_.SetChannelSource(1, right_source);
+
+    if (!lc3_encoder_.Encode(data.data(), data.size())) {
+      LOG(ERROR) << __func__ << " Cannot encode, data size: " << +data.size()
+                 << " expected: " << +lc3_encoder_.GetPcmIntervalSize();
+      return;
     }
 
     DLOG(INFO) << __func__ << " left_cis_handle: " << +left_cis_handle
@@ -3054,11 +2999,11 @@ class LeAudioClientImpl : public LeAudioClient {
     /* Send data to the controller */
     if (left_cis_handle)
       IsoManager::GetInstance()->SendIsoData(
-          left_cis_handle, chan_left_enc.data(), chan_left_enc.size());
+          left_cis_handle, lc3_encoder_.GetChannelData(0), byte_count);
 
     if (right_cis_handle)
       IsoManager::GetInstance()->SendIsoData(
-          right_cis_handle, chan_right_enc.data(), chan_right_enc.size());
+          right_cis_handle, lc3_encoder_.GetChannelData(1), byte_count);
   }
 
   void PrepareAndSendToSingleCis(
@@ -3067,46 +3012,34 @@ class LeAudioClientImpl : public LeAudioClient {
     int num_channels = stream_conf->sink_num_of_channels;
     uint16_t byte_count = stream_conf->sink_octets_per_codec_frame;
     auto cis_handle = stream_conf->sink_streams.front().first;
-    uint16_t number_of_required_samples_per_channel;
 
-    int dt_us = current_source_codec_config.data_interval_us;
-    int af_hz = audio_framework_source_config.sample_rate;
-    number_of_required_samples_per_channel = lc3_frame_samples(dt_us, af_hz);
-    lc3_pcm_format bits_per_sample =
-        bits_to_lc3_bits(audio_framework_source_config.bits_per_sample);
-    uint8_t bytes_per_sample =
-        bits_to_bytes_per_sample(audio_framework_source_config.bits_per_sample);
-
-    if ((int)data.size() < (2 /* bytes per sample */ * num_channels *
-                            number_of_required_samples_per_channel)) {
-      LOG(ERROR) << __func__ << "Missing samples";
+    if (byte_count != lc3_encoder_.GetOctetsPerFrame()) {
+      LOG_ERROR("Codec frame size %d, the encoder expects %d", byte_count,
+                lc3_encoder_.GetOctetsPerFrame());
       return;
     }
-    std::vector<uint8_t> chan_encoded(num_channels * byte_count, 0);
 
     if (num_channels == 1) {
       /* Since we always get two channels from framework, lets make it mono here
        */
-      std::vector<uint8_t> mono = mono_blend(
-          data, bytes_per_sample, number_of_required_samples_per_channel);
-
-      auto err = lc3_encode(lc3_encoder_left, bits_per_sample, mono.data(), 1,
-                            byte_count, chan_encoded.data());
-
-      if (err < 0) {
-        LOG(ERROR) << " error while encoding, error code: " << +err;
-      }
+      lc3_encoder_.SetChannelSource(0, Lc3MultiChannelEncoder::kSourceMonoMix);
+      lc3_encoder_.SetChannelSource(1, Lc3MultiChannelEncoder::kSourceNone);
     } else {
-      lc3_encode(lc3_encoder_left, bits_per_sample, (const int16_t*)data.data(),
-                 2, byte_count, chan_encoded.data());
-      lc3_encode(lc3_encoder_right, bits_per_sample,
-                 (const int16_t*)data.data() + 1, 2, byte_count,
-                 chan_encoded.data() + byte_count);
+      lc3_encoder_.SetChannelSource(0, 0);
+      lc3_encoder_.SetChannelSource(1, 1);
     }
 
-    /* Send data to the controller */
-    IsoManager::GetInstance()->SendIsoData(cis_handle, chan_encoded.data(),
-                                           chan_encoded.size());
+    if (!lc3_encoder_.Encode(data.data(), data.size())) {
+      LOG(ERROR) << __func__ << " Cannot encode, data size: " << +data.size()
+                 << " expected: " << +lc3_encoder_.GetPcmIntervalSize();
+      return;
+    }
+
+    /* Send data to the controller, the frames of the channels follow each
+     * other in the encoder buffer */
+    uint16_t sdu_size = (num_channels == 1 ? 1 : 2) * byte_count;
+    IsoManager::GetInstance()->SendIsoData(
+        cis_handle, lc3_encoder_.GetChannelData(0), sdu_size);
   }
 
   const struct le_audio::stream_configuration* GetStreamSinkConfiguration(
@@ -3413,26 +3346,24 @@ class LeAudioClientImpl : public LeAudioClient {
         group->GetRemoteDelay(le_audio::types::kLeAudioDirectionSink);
     if (CodecManager::GetInstance()->GetCodecLocation() ==
         le_audio::types::CodecLocation::HOST) {
-      if (lc3_encoder_left_mem) {
+      if (lc3_encoder_.IsReady()) {
         LOG(WARNING)
             << " The encoder instance should have been already released.";
-        free(lc3_encoder_left_mem);
-        lc3_encoder_left_mem = nullptr;
-        free(lc3_encoder_right_mem);
-        lc3_encoder_right_mem = nullptr;
       }
-      int dt_us = current_source_codec_config.data_interval_us;
-      int sr_hz = current_source_codec_config.sample_rate;
-      int af_hz = audio_framework_source_config.sample_rate;
-      unsigned enc_size = lc3_encoder_size(dt_us, af_hz);
-
-      lc3_encoder_left_mem = malloc(enc_size);
-      lc3_encoder_right_mem = malloc(enc_size);
 
-      lc3_encoder_left =
-          lc3_setup_encoder(dt_us, sr_hz, af_hz, lc3_encoder_left_mem);
-      lc3_encoder_right =
-          lc3_setup_encoder(dt_us, sr_hz, af_hz, lc3_encoder_right_mem);
+      /* Left and right channels, from the two channels of the framework */
+      lc3_encoder_.Setup({
+          .dt_us =
+              static_cast<int>(current_source_codec_config.data_interval_us),
+          .sr_hz = static_cast<int>(current_source_codec_config.sample_rate),
+          .pcm_sr_hz =
+              static_cast<int>(audio_framework_source_config.sample_rate),
+          .pcm_bits_per_sample = audio_framework_source_config.bits_per_sample,
+          .pcm_num_channels = 2,
+          .num_channels = 2,
+          .octets_per_frame = stream_conf->sink_octets_per_codec_frame,
+          .num_workers = 0,
+      });
     }
 
     le_audio_source_hal_client_->UpdateRemoteDelay(remote_delay_ms);
@@ -3519,12 +3450,7 @@ class LeAudioClientImpl : public LeAudioClient {
   void SuspendAudio(void) {
     CancelStreamingRequest();
 
-    if (lc3_encoder_left_mem) {
-      free(lc3_encoder_left_mem);
-      lc3_encoder_left_mem = nullptr;
-      free(lc3_encoder_right_mem);
-      lc3_encoder_right_mem = nullptr;
-    }
+    lc3_encoder_.Release();
 
     if (lc3_decoder_left_mem) {
       free(lc3_decoder_left_mem);
@@ -5267,11 +5193,7 @@ class LeAudioClientImpl : public LeAudioClient {
       .data_interval_us = LeAudioCodecConfiguration::kInterval10000Us,
   };
 
-  void* lc3_encoder_left_mem;
-  void* lc3_encoder_right_mem;
-
-  lc3_encoder_t lc3_encoder_left;
-  lc3_encoder_t lc3_encoder_right;
+  Lc3MultiChannelEncoder lc3_encoder_;
 
   void* lc3_decoder_left_mem;
   void* lc3_decoder_right_mem;
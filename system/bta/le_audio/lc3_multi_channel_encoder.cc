@@ -0,0 +1,338 @@
+/*
+ * Copyright 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "lc3_multi_channel_encoder.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdlib>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "embdrv/lc3/include/lc3.h"
+#include "osi/include/log.h"
+
+namespace {
+
+/* Split the interleaved samples of the |num_channels| channels into planes
+ * of |num_samples| samples. The planes of the channels not used by any
+ * encoded channel are left untouched. The last plane receives the mono mix
+ * when requested, rounded toward 0. */
+template <typename T>
+void Deinterleave(const uint8_t* pcm, int num_channels, int num_samples,
+                  const std::vector<bool>& used, bool mono_mix,
+                  uint8_t* planes) {
+  const T* in = reinterpret_cast<const T*>(pcm);
+  T* out = reinterpret_cast<T*>(planes);
+
+  for (int ch = 0; ch < num_channels; ch++) {
+    if (!used[ch]) continue;
+
+    T* plane = out + ch * num_samples;
+    for (int i = 0; i < num_samples; i++) plane[i] = in[i * num_channels + ch];
+  }
+
+  if (!mono_mix) return;
+
+  T* plane = out + num_channels * num_samples;
+  for (int i = 0; i < num_samples; i++) {
+    int64_t accum = 0;
+    for (int ch = 0; ch < num_channels; ch++)
+      accum += in[i * num_channels + ch];
+    plane[i] = accum / num_channels;
+  }
+}
+
+}  // namespace
+
+namespace le_audio {
+
+struct Lc3MultiChannelEncoder::impl {
+  impl() : encoders_mem_(nullptr, &std::free) {}
+
+  ~impl() { Release(); }
+
+  bool Setup(const Config& config) {
+    Release();
+
+    int pcm_sr_hz = config.pcm_sr_hz ? config.pcm_sr_hz : config.sr_hz;
+    unsigned encoder_size = lc3_encoder_size(config.dt_us, pcm_sr_hz);
+    int num_samples = lc3_frame_samples(config.dt_us, pcm_sr_hz);
+
+    if (encoder_size == 0 || num_samples < 0 || config.num_channels <= 0 ||
+        config.pcm_num_channels <= 0 || config.num_workers < 0 ||
+        (config.pcm_bits_per_sample != 16 &&
+         config.pcm_bits_per_sample != 24)) {
+      LOG_ERROR("Invalid configuration");
+      return false;
+    }
+
+    config_ = config;
+    num_samples_ = num_samples;
+    format_ = config.pcm_bits_per_sample == 24 ? LC3_PCM_FORMAT_S24
+                                               : LC3_PCM_FORMAT_S16;
+    bytes_per_sample_ = config.pcm_bits_per_sample == 24 ? 4 : 2;
+
+    /* All the encoders in one allocation, aligned for each of them */
+    encoder_size = (encoder_size + alignof(std::max_align_t) - 1) &
+                   ~(alignof(std::max_align_t) - 1);
+    encoders_mem_.reset(malloc(encoder_size * config.num_channels));
+    if (!encoders_mem_) {
+      LOG_ERROR("Cannot allocate %d encoders", config.num_channels);
+      return false;
+    }
+
+    for (int ch = 0; ch < config.num_channels; ch++) {
+      encoders_.push_back(lc3_setup_encoder(
+          config.dt_us, config.sr_hz, config.pcm_sr_hz,
+          static_cast<uint8_t*>(encoders_mem_.get()) + ch * encoder_size));
+      if (encoders_.back() == nullptr) {
+        LOG_ERROR("Cannot setup the encoder, dt_us=%d sr_hz=%d", config.dt_us,
+                  config.sr_hz);
+        Release();
+        return false;
+      }
+    }
+
+    sources_.resize(config.num_channels);
+    for (int ch = 0; ch < config.num_channels; ch++)
+      sources_[ch] = ch < config.pcm_num_channels ? ch : kSourceMonoMix;
+
+    used_.resize(config.pcm_num_channels);
+    planes_.resize((config.pcm_num_channels + 1) * num_samples_ *
+                   bytes_per_sample_);
+    frames_.resize(config.num_channels * config.octets_per_frame);
+    results_.resize(config.num_channels);
+
+    /* No work for the new workers until the next call to Encode() */
+    stop_ = false;
+    next_channel_ = config.num_channels;
+    pending_ = 0;
+    for (int i = 0; i < config.num_workers; i++)
+      workers_.emplace_back(&impl::WorkerLoop, this);
+
+    return true;
+  }
+
+  void Release(void) {
+    if (!workers_.empty()) {
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+      }
+      work_cv_.notify_all();
+      for (auto& worker : workers_) worker.join();
+      workers_.clear();
+    }
+
+    encoders_.clear();
+    encoders_mem_.reset();
+    sources_.clear();
+    frames_.clear();
+    config_ = {};
+  }
+
+  bool IsReady(void) const { return !encoders_.empty(); }
+
+  bool Encode(const uint8_t* pcm, size_t pcm_size) {
+    if (!IsReady()) {
+      LOG_ERROR("Encoder is not set up");
+      return false;
+    }
+
+    if (pcm_size < GetPcmIntervalSize()) {
+      LOG_ERROR("Missing samples, size=%zu expected=%zu", pcm_size,
+                GetPcmIntervalSize());
+      return false;
+    }
+
+    /* Deinterleave once the channels used by the encoded channels */
+    bool mono_mix = false;
+    std::fill(used_.begin(), used_.end(), false);
+    for (int source : sources_) {
+      if (source == kSourceMonoMix)
+        mono_mix = true;
+      else if (source >= 0)
+        used_[source] = true;
+    }
+
+    if (format_ == LC3_PCM_FORMAT_S24)
+      Deinterleave<int32_t>(pcm, config_.pcm_num_channels, num_samples_,
+                            used_, mono_mix, planes_.data());
+    else
+      Deinterleave<int16_t>(pcm, config_.pcm_num_channels, num_samples_,
+                            used_, mono_mix, planes_.data());
+
+    /* Encode the channels, helped by the workers */
+    pending_ = config_.num_channels;
+    next_channel_ = 0;
+
+    if (!workers_.empty()) {
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        generation_++;
+      }
+      work_cv_.notify_all();
+    }
+
+    EncodeChannels();
+
+    if (!workers_.empty()) {
+      std::unique_lock<std::mutex> lock(mutex_);
+      done_cv_.wait(lock, [this] { return pending_ == 0; });
+    }
+
+    bool success = true;
+    for (int ch = 0; ch < config_.num_channels; ch++) {
+      if (results_[ch] != 0) {
+        LOG_ERROR("Encoding error=%d, channel=%d", results_[ch], ch);
+        success = false;
+      }
+    }
+
+    return success;
+  }
+
+  size_t GetPcmIntervalSize(void) const {
+    return static_cast<size_t>(num_samples_) * bytes_per_sample_ *
+           config_.pcm_num_channels;
+  }
+
+  Config config_ = {};
+  std::vector<int> sources_;
+  std::vector<uint8_t> frames_;
+
+ private:
+  void EncodeChannel(int ch) {
+    int source = sources_[ch];
+    int plane = source == kSourceMonoMix ? config_.pcm_num_channels : source;
+
+    if (source == kSourceNone) {
+      results_[ch] = 0;
+      return;
+    }
+
+    results_[ch] = lc3_encode(
+        encoders_[ch], format_,
+        planes_.data() + plane * num_samples_ * bytes_per_sample_, 1,
+        config_.octets_per_frame,
+        frames_.data() + ch * config_.octets_per_frame);
+  }
+
+  /* Encode the channels not yet taken by another thread */
+  void EncodeChannels(void) {
+    for (int ch = next_channel_++; ch < config_.num_channels;
+         ch = next_channel_++) {
+      EncodeChannel(ch);
+      if (--pending_ == 0 && !workers_.empty()) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        done_cv_.notify_one();
+      }
+    }
+  }
+
+  void WorkerLoop(void) {
+    /* Wait for the next interval, generation_ is not reset by Setup() */
+    uint64_t generation;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      generation = generation_;
+    }
+
+    for (;;) {
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        work_cv_.wait(lock,
+                      [&] { return stop_ || generation_ != generation; });
+        if (stop_) return;
+        generation = generation_;
+      }
+
+      EncodeChannels();
+    }
+  }
+
+  int num_samples_ = 0;
+  int bytes_per_sample_ = 2;
+  lc3_pcm_format format_ = LC3_PCM_FORMAT_S16;
+
+  std::unique_ptr<void, decltype(&std::free)> encoders_mem_;
+  std::vector<lc3_encoder_t> encoders_;
+  std::vector<bool> used_;
+  std::vector<uint8_t> planes_;
+  std::vector<int> results_;
+
+  std::vector<std::thread> workers_;
+  std::mutex mutex_;
+  std::condition_variable work_cv_;
+  std::condition_variable done_cv_;
+  uint64_t generation_ = 0;
+  bool stop_ = false;
+  std::atomic<int> next_channel_ = 0;
+  std::atomic<int> pending_ = 0;
+};
+
+Lc3MultiChannelEncoder::Lc3MultiChannelEncoder()
+    : pimpl_(std::make_unique<impl>()) {}
+
+Lc3MultiChannelEncoder::~Lc3MultiChannelEncoder() = default;
+
+bool Lc3MultiChannelEncoder::Setup(const Config& config) {
+  return pimpl_->Setup(config);
+}
+
+void Lc3MultiChannelEncoder::Release(void) { pimpl_->Release(); }
+
+bool Lc3MultiChannelEncoder::IsReady(void) const {
+  return pimpl_->IsReady();
+}
+
+void Lc3MultiChannelEncoder::SetChannelSource(int channel, int source) {
+  if (channel < 0 || channel >= static_cast<int>(pimpl_->sources_.size()) ||
+      source < kSourceNone || source >= pimpl_->config_.pcm_num_channels) {
+    LOG_ERROR("Invalid source=%d for channel=%d", source, channel);
+    return;
+  }
+
+  pimpl_->sources_[channel] = source;
+}
+
+int Lc3MultiChannelEncoder::GetChannelSource(int channel) const {
+  return pimpl_->sources_.at(channel);
+}
+
+bool Lc3MultiChannelEncoder::Encode(const uint8_t* pcm, size_t pcm_size) {
+  return pimpl_->Encode(pcm, pcm_size);
+}
+
+size_t Lc3MultiChannelEncoder::GetPcmIntervalSize(void) const {
+  return pimpl_->GetPcmIntervalSize();
+}
+
+int Lc3MultiChannelEncoder::GetNumChannels(void) const {
+  return pimpl_->config_.num_channels;
+}
+
+uint16_t Lc3MultiChannelEncoder::GetOctetsPerFrame(void) const {
+  return pimpl_->config_.octets_per_frame;
+}
+
+const uint8_t* Lc3MultiChannelEncoder::GetChannelData(int channel) const {
+  return pimpl_->frames_.data() + channel * pimpl_->config_.octets_per_frame;
+}
+
+}  // namespace le_audio
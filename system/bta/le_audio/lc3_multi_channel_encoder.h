@@ -0,0 +1,88 @@
+/*
+ * Copyright 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace le_audio {
+
+/* Encodes the channels of an SDU interval with LC3, from the interleaved PCM
+ * of the audio framework.
+ *
+ * The encoders, the deinterleaved PCM and the encoded frames are allocated
+ * once by Setup() and reused for every interval. The encoded frames of the
+ * channels are contiguous, in channel order, so that they can be handed to
+ * IsoManager::SendIsoData() without copy, one channel per CIS / BIS, or
+ * several channels in a single SDU.
+ *
+ * The channels can be encoded in parallel, on a small pool of worker
+ * threads owned by the encoder.
+ */
+class Lc3MultiChannelEncoder {
+ public:
+  /* Source of an encoded channel, that can also be an input PCM channel */
+  static constexpr int kSourceMonoMix = -1; /* Average of the PCM channels */
+  static constexpr int kSourceNone = -2;    /* Channel not encoded */
+
+  struct Config {
+    int dt_us;                  /* Frame duration, 7500 or 10000 us */
+    int sr_hz;                  /* Sample rate of the encoded stream */
+    int pcm_sr_hz;              /* Sample rate of the PCM, 0 for sr_hz */
+    int pcm_bits_per_sample;    /* 16, or 24 in 32 bits containers */
+    int pcm_num_channels;       /* Number of interleaved PCM channels */
+    int num_channels;           /* Number of encoded channels */
+    uint16_t octets_per_frame;  /* Size of an encoded channel frame */
+    int num_workers;            /* Worker threads, 0 encodes in the caller */
+  };
+
+  Lc3MultiChannelEncoder();
+  ~Lc3MultiChannelEncoder();
+
+  /* Allocate the encoders and buffers, return false on bad parameters.
+   * The channel sources default to the PCM channel of the same index, or
+   * the mono mix when there are fewer PCM channels. */
+  bool Setup(const Config& config);
+  void Release(void);
+  bool IsReady(void) const;
+
+  /* Select the source of an encoded channel, that applies from the next
+   * call to Encode() */
+  void SetChannelSource(int channel, int source);
+  int GetChannelSource(int channel) const;
+
+  /* Encode an interval of interleaved PCM into all the channels. Return
+   * false when there are not enough samples, or on encoding error. */
+  bool Encode(const uint8_t* pcm, size_t pcm_size);
+
+  /* Number of PCM bytes consumed by Encode() */
+  size_t GetPcmIntervalSize(void) const;
+
+  int GetNumChannels(void) const;
+  uint16_t GetOctetsPerFrame(void) const;
+
+  /* Encoded frame of a channel, followed by the frames of the next channels,
+   * valid until the next call to Encode() or Setup() */
+  const uint8_t* GetChannelData(int channel) const;
+
+ private:
+  struct impl;
+  std::unique_ptr<impl> pimpl_;
+};
+
+}  // namespace le_audio
@@ -0,0 +1,100 @@
+/*
+ * Copyright 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "bta/le_audio/lc3_multi_channel_encoder.h"
+#include "embdrv/lc3/include/lc3.h"
+
+using ::benchmark::State;
+using le_audio::Lc3MultiChannelEncoder;
+
+namespace {
+
+constexpr int kDtUs = 10000;
+constexpr int kSrHz = 48000;
+constexpr uint16_t kOctetsPerFrame = 120;
+
+std::vector<int16_t> MakePcm(int num_channels) {
+  std::vector<int16_t> pcm(lc3_frame_samples(kDtUs, kSrHz) * num_channels);
+  std::minstd_rand random;
+  std::uniform_int_distribution<int> noise(-4096, 4096);
+  for (auto& v : pcm) v = noise(random);
+  return pcm;
+}
+
+}  // namespace
+
+/* Encoding of the channels of an SDU interval, as done before the
+ * multi-channel encoder: one encoder and one fresh buffer per channel */
+static void BM_EncodePerChannel(State& state) {
+  int num_channels = state.range(0);
+  auto pcm = MakePcm(num_channels);
+
+  std::vector<std::vector<uint8_t>> mem(num_channels);
+  std::vector<lc3_encoder_t> encoders;
+  for (auto& m : mem) {
+    m.resize(lc3_encoder_size(kDtUs, kSrHz));
+    encoders.push_back(lc3_setup_encoder(kDtUs, kSrHz, 0, m.data()));
+  }
+
+  for (auto _ : state) {
+    for (int ch = 0; ch < num_channels; ch++) {
+      std::vector<uint8_t> frame(kOctetsPerFrame);
+      lc3_encode(encoders[ch], LC3_PCM_FORMAT_S16, pcm.data() + ch,
+                 num_channels, frame.size(), frame.data());
+      benchmark::DoNotOptimize(frame.data());
+    }
+  }
+
+  state.SetItemsProcessed(state.iterations());
+}
+
+static void BM_EncodeMultiChannel(State& state) {
+  int num_channels = state.range(0);
+  auto pcm = MakePcm(num_channels);
+
+  Lc3MultiChannelEncoder encoder;
+  encoder.Setup({
+      .dt_us = kDtUs,
+      .sr_hz = kSrHz,
+      .pcm_sr_hz = 0,
+      .pcm_bits_per_sample = 16,
+      .pcm_num_channels = num_channels,
+      .num_channels = num_channels,
+      .octets_per_frame = kOctetsPerFrame,
+      .num_workers = static_cast<int>(state.range(1)),
+  });
+
+  for (auto _ : state) {
+    encoder.Encode(reinterpret_cast<const uint8_t*>(pcm.data()),
+                   pcm.size() * sizeof(int16_t));
+    benchmark::DoNotOptimize(encoder.GetChannelData(0));
+  }
+
+  state.SetItemsProcessed(state.iterations());
+}
+
+/* Items are SDU intervals, the CPU time is accounted on all the threads */
+BENCHMARK(BM_EncodePerChannel)->Arg(2)->Arg(4)->Arg(8);
+BENCHMARK(BM_EncodeMultiChannel)
+    ->ArgsProduct({{2, 4, 8}, {0, 1, 3}})
+    ->MeasureProcessCPUTime()
+    ->UseRealTime();
@@ -0,0 +1,222 @@
+/*
+ * Copyright 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "lc3_multi_channel_encoder.h"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "embdrv/lc3/include/lc3.h"
+
+namespace le_audio {
+
+namespace {
+
+constexpr int kDtUs = 10000;
+constexpr int kSrHz = 48000;
+constexpr uint16_t kOctetsPerFrame = 100;
+constexpr int kNumIntervals = 4;
+
+Lc3MultiChannelEncoder::Config MakeConfig(int pcm_num_channels,
+                                          int num_channels, int num_workers) {
+  return {
+      .dt_us = kDtUs,
+      .sr_hz = kSrHz,
+      .pcm_sr_hz = 0,
+      .pcm_bits_per_sample = 16,
+      .pcm_num_channels = pcm_num_channels,
+      .num_channels = num_channels,
+      .octets_per_frame = kOctetsPerFrame,
+      .num_workers = num_workers,
+  };
+}
+
+/* Interleaved intervals of distinct ramps and noise on each channel */
+std::vector<int16_t> MakePcm(int num_channels) {
+  int ns = lc3_frame_samples(kDtUs, kSrHz);
+  std::vector<int16_t> pcm(kNumIntervals * ns * num_channels);
+  uint32_t seed = 1;
+
+  for (size_t i = 0; i < pcm.size(); i++) {
+    seed = seed * 1664525 + 1013904223;
+    int ch = i % num_channels;
+    pcm[i] = ((i / num_channels) * (ch + 3) * 97) % 16384 - 8192 +
+             (int)(seed >> 22) - 512;
+  }
+
+  return pcm;
+}
+
+/* Reference encoding of a channel, with its own encoder and the stride of
+ * the interleaved samples */
+std::vector<uint8_t> EncodeReference(const std::vector<int16_t>& pcm,
+                                     int num_channels, int channel) {
+  int ns = lc3_frame_samples(kDtUs, kSrHz);
+  std::vector<uint8_t> mem(lc3_encoder_size(kDtUs, kSrHz));
+  lc3_encoder_t encoder = lc3_setup_encoder(kDtUs, kSrHz, 0, mem.data());
+  std::vector<uint8_t> frames(kNumIntervals * kOctetsPerFrame);
+
+  for (int i = 0; i < kNumIntervals; i++)
+    lc3_encode(encoder, LC3_PCM_FORMAT_S16,
+               pcm.data() + i * ns * num_channels + channel, num_channels,
+               kOctetsPerFrame, frames.data() + i * kOctetsPerFrame);
+
+  return frames;
+}
+
+/* Encoded frames of all the intervals, channel after channel */
+std::vector<std::vector<uint8_t>> EncodeAll(Lc3MultiChannelEncoder& encoder,
+                                            const std::vector<int16_t>& pcm) {
+  size_t interval_size = encoder.GetPcmIntervalSize();
+  std::vector<std::vector<uint8_t>> frames(encoder.GetNumChannels());
+
+  for (int i = 0; i < kNumIntervals; i++) {
+    EXPECT_TRUE(encoder.Encode(
+        reinterpret_cast<const uint8_t*>(pcm.data()) + i * interval_size,
+        interval_size));
+
+    for (int ch = 0; ch < encoder.GetNumChannels(); ch++)
+      frames[ch].insert(frames[ch].end(), encoder.GetChannelData(ch),
+                        encoder.GetChannelData(ch) + kOctetsPerFrame);
+  }
+
+  return frames;
+}
+
+}  // namespace
+
+TEST(Lc3MultiChannelEncoderTest, SetupAndRelease) {
+  Lc3MultiChannelEncoder encoder;
+  ASSERT_FALSE(encoder.IsReady());
+
+  ASSERT_FALSE(encoder.Setup(MakeConfig(2, 0, 0)));
+  ASSERT_FALSE(encoder.IsReady());
+
+  ASSERT_TRUE(encoder.Setup(MakeConfig(2, 3, 0)));
+  ASSERT_TRUE(encoder.IsReady());
+  ASSERT_EQ(encoder.GetNumChannels(), 3);
+  ASSERT_EQ(encoder.GetOctetsPerFrame(), kOctetsPerFrame);
+  ASSERT_EQ(encoder.GetPcmIntervalSize(), 480u * 2 * sizeof(int16_t));
+  ASSERT_EQ(encoder.GetChannelSource(0), 0);
+  ASSERT_EQ(encoder.GetChannelSource(1), 1);
+  ASSERT_EQ(encoder.GetChannelSource(2), Lc3MultiChannelEncoder::kSourceMonoMix);
+  ASSERT_EQ(encoder.GetChannelData(1),
+            encoder.GetChannelData(0) + kOctetsPerFrame);
+
+  encoder.Release();
+  ASSERT_FALSE(encoder.IsReady());
+
+  std::vector<uint8_t> pcm(480 * 2 * sizeof(int16_t));
+  ASSERT_FALSE(encoder.Encode(pcm.data(), pcm.size()));
+}
+
+TEST(Lc3MultiChannelEncoderTest, MissingSamples) {
+  Lc3MultiChannelEncoder encoder;
+  ASSERT_TRUE(encoder.Setup(MakeConfig(2, 2, 0)));
+
+  std::vector<uint8_t> pcm(encoder.GetPcmIntervalSize() - 1);
+  ASSERT_FALSE(encoder.Encode(pcm.data(), pcm.size()));
+}
+
+TEST(Lc3MultiChannelEncoderTest, MatchesPerChannelEncoding) {
+  for (int num_channels : {1, 2, 4, 8}) {
+    SCOPED_TRACE(testing::Message() << "channels " << num_channels);
+
+    auto pcm = MakePcm(num_channels);
+    Lc3MultiChannelEncoder encoder;
+    ASSERT_TRUE(encoder.Setup(MakeConfig(num_channels, num_channels, 0)));
+
+    auto frames = EncodeAll(encoder, pcm);
+    for (int ch = 0; ch < num_channels; ch++)
+      ASSERT_EQ(frames[ch], EncodeReference(pcm, num_channels, ch));
+  }
+}
+
+TEST(Lc3MultiChannelEncoderTest, WorkersMatchSingleThread) {
+  for (int num_channels : {2, 5, 8}) {
+    SCOPED_TRACE(testing::Message() << "channels " << num_channels);
+
+    auto pcm = MakePcm(num_channels);
+    Lc3MultiChannelEncoder encoder;
+    ASSERT_TRUE(encoder.Setup(MakeConfig(num_channels, num_channels, 0)));
+    auto expected = EncodeAll(encoder, pcm);
+
+    for (int num_workers : {1, 3}) {
+      ASSERT_TRUE(
+          encoder.Setup(MakeConfig(num_channels, num_channels, num_workers)));
+      ASSERT_EQ(EncodeAll(encoder, pcm), expected);
+    }
+  }
+}
+
+TEST(Lc3MultiChannelEncoderTest, SetupAgainWithMoreChannels) {
+  auto pcm = MakePcm(8);
+
+  Lc3MultiChannelEncoder expected_encoder;
+  ASSERT_TRUE(expected_encoder.Setup(MakeConfig(8, 8, 0)));
+  auto expected = EncodeAll(expected_encoder, pcm);
+
+  /* The workers of the second setup, given time to start, must not pick up
+   * the channels left by the intervals of the first one. These would encode
+   * the last PCM channels, deinterleaved by the first setup. */
+  Lc3MultiChannelEncoder encoder;
+  ASSERT_TRUE(encoder.Setup(MakeConfig(8, 3, 2)));
+  for (int ch = 0; ch < 3; ch++) encoder.SetChannelSource(ch, 7 - ch);
+  EncodeAll(encoder, pcm);
+
+  ASSERT_TRUE(encoder.Setup(MakeConfig(8, 8, 3)));
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  ASSERT_EQ(EncodeAll(encoder, pcm), expected);
+}
+
+TEST(Lc3MultiChannelEncoderTest, MonoMix) {
+  auto pcm = MakePcm(2);
+
+  std::vector<int16_t> mono(pcm.size() / 2);
+  for (size_t i = 0; i < mono.size(); i++)
+    mono[i] = (pcm[2 * i] + pcm[2 * i + 1]) / 2;
+
+  Lc3MultiChannelEncoder encoder;
+  ASSERT_TRUE(encoder.Setup(MakeConfig(2, 2, 0)));
+  encoder.SetChannelSource(0, Lc3MultiChannelEncoder::kSourceMonoMix);
+  encoder.SetChannelSource(1, 0);
+
+  auto frames = EncodeAll(encoder, pcm);
+  ASSERT_EQ(frames[0], EncodeReference(mono, 1, 0));
+  ASSERT_EQ(frames[1], EncodeReference(pcm, 2, 0));
+}
+
+TEST(Lc3MultiChannelEncoderTest, SourceNone) {
+  auto pcm = MakePcm(2);
+
+  Lc3MultiChannelEncoder encoder;
+  ASSERT_TRUE(encoder.Setup(MakeConfig(2, 2, 0)));
+  encoder.SetChannelSource(0, Lc3MultiChannelEncoder::kSourceNone);
+  ASSERT_EQ(encoder.GetChannelSource(0), Lc3MultiChannelEncoder::kSourceNone);
+
+  auto frames = EncodeAll(encoder, pcm);
+  ASSERT_EQ(frames[1], EncodeReference(pcm, 2, 1));
+
+  /* Invalid sources are ignored */
+  encoder.SetChannelSource(1, 2);
+  encoder.SetChannelSource(2, 0);
+  ASSERT_EQ(encoder.GetChannelSource(1), 1);
+}
+
+}  // namespace le_audio
@@ -83,6 +83,13 @@ void BTM_RequestPeerSCA(RawAddress const& bd_addr, tBT_TRANSPORT transport) {
   btm_interface->RequestPeerSCA(bd_addr, transport);
 }
 
+void BTM_SetAclTxLatencyClass(RawAddress const& bd_addr,
+                              tBT_TRANSPORT transport,
+                              tBTM_ACL_TX_LATENCY_CLASS latency_class) {
+  LOG_ASSERT(btm_interface) << "Mock btm interface not set!";
+  btm_interface->SetAclTxLatencyClass(bd_addr, transport, latency_class);
+}
+
 uint16_t BTM_GetHCIConnHandle(RawAddress const& bd_addr,
                               tBT_TRANSPORT transport) {
   LOG_ASSERT(btm_interface) << "Mock btm interface not set!";
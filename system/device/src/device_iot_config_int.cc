@@ -269,7 +269,7 @@ void device_iot_config_restrict_device_num(config_t& config) {
   LOG_INFO("curr_num=%d, need_remove_num=%d", curr_num,
            need_remove_devices_num);
 
-  std::list<section_t>::iterator i = config.sections.begin();
+  auto i = config.sections.begin();
   while (i != config.sections.end()) {
     if (!RawAddress::IsValidAddress(i->name)) {
       ++i;
@@ -0,0 +1,115 @@
+/******************************************************************************
+ *
+ *  Copyright 2023 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include <lc3.h>
+
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+
+using ::benchmark::State;
+
+namespace {
+
+constexpr int kNumFrames = 100;
+
+// Voiced signal, harmonics of a 220 Hz pitch plus noise, so that all the
+// encoder tools (LTPF, TNS, noise filling) are exercised
+std::vector<int16_t> MakePcm(int dt_us, int sr_hz) {
+  int ns = lc3_frame_samples(dt_us, sr_hz);
+  std::vector<int16_t> pcm(ns * kNumFrames);
+  std::minstd_rand random;
+  std::uniform_int_distribution<int> noise(-512, 512);
+
+  for (size_t i = 0; i < pcm.size(); i++) {
+    double t = (double)i / sr_hz, v = 0;
+    for (int h = 1; h <= 8 && 220 * h < sr_hz / 2; h++)
+      v += 4000 / h * std::sin(2 * M_PI * 220 * h * t);
+    pcm[i] = (int16_t)(v + noise(random));
+  }
+
+  return pcm;
+}
+
+// Frame size of a stream at 2 bits per sample at 16 KHz, and above
+int FrameBytes(int dt_us, int sr_hz) {
+  int bitrate = sr_hz < 16000 ? 24000 : sr_hz * 2;
+  return lc3_frame_bytes(dt_us, bitrate);
+}
+
+}  // namespace
+
+static void BM_Encode(State& state) {
+  int dt_us = state.range(0), sr_hz = state.range(1);
+  int ns = lc3_frame_samples(dt_us, sr_hz);
+  int nbytes = FrameBytes(dt_us, sr_hz);
+
+  std::vector<uint8_t> mem(lc3_encoder_size(dt_us, sr_hz));
+  lc3_encoder_t encoder = lc3_setup_encoder(dt_us, sr_hz, 0, mem.data());
+  auto pcm = MakePcm(dt_us, sr_hz);
+  std::vector<uint8_t> frame(nbytes);
+
+  for (auto _ : state) {
+    for (int i = 0; i < kNumFrames; i++)
+      lc3_encode(encoder, LC3_PCM_FORMAT_S16, pcm.data() + i * ns, 1, nbytes, frame.data());
+    benchmark::DoNotOptimize(frame.data());
+  }
+
+  state.SetItemsProcessed(state.iterations() * kNumFrames);
+  state.counters["realtime_x"] = benchmark::Counter(
+      state.iterations() * kNumFrames * dt_us * 1e-6, benchmark::Counter::kIsRate);
+}
+
+static void BM_Decode(State& state) {
+  int dt_us = state.range(0), sr_hz = state.range(1);
+  int ns = lc3_frame_samples(dt_us, sr_hz);
+  int nbytes = FrameBytes(dt_us, sr_hz);
+
+  std::vector<uint8_t> encoder_mem(lc3_encoder_size(dt_us, sr_hz));
+  lc3_encoder_t encoder = lc3_setup_encoder(dt_us, sr_hz, 0, encoder_mem.data());
+  auto pcm = MakePcm(dt_us, sr_hz);
+  std::vector<uint8_t> frames(nbytes * kNumFrames);
+  for (int i = 0; i < kNumFrames; i++)
+    lc3_encode(encoder, LC3_PCM_FORMAT_S16, pcm.data() + i * ns, 1, nbytes, frames.data() + i * nbytes);
+
+  std::vector<uint8_t> mem(lc3_decoder_size(dt_us, sr_hz));
+  lc3_decoder_t decoder = lc3_setup_decoder(dt_us, sr_hz, 0, mem.data());
+
+  for (auto _ : state) {
+    for (int i = 0; i < kNumFrames; i++)
+      lc3_decode(decoder, frames.data() + i * nbytes, nbytes, LC3_PCM_FORMAT_S16, pcm.data() + i * ns, 1);
+    benchmark::DoNotOptimize(pcm.data());
+  }
+
+  state.SetItemsProcessed(state.iterations() * kNumFrames);
+  state.counters["realtime_x"] = benchmark::Counter(
+      state.iterations() * kNumFrames * dt_us * 1e-6, benchmark::Counter::kIsRate);
+}
+
+// Frame durations and samplerates of the LE Audio configurations
+static void FrameConfigurations(benchmark::internal::Benchmark* b) {
+  for (int dt_us : {7500, 10000})
+    for (int sr_hz : {8000, 16000, 24000, 32000, 48000})
+      b->Args({dt_us, sr_hz});
+}
+
+BENCHMARK(BM_Encode)->Apply(FrameConfigurations);
+BENCHMARK(BM_Decode)->Apply(FrameConfigurations);
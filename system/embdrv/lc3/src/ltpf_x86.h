@@ -0,0 +1,246 @@
+/******************************************************************************
+ *
+ *  Copyright 2023 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#if __SSE2__
+
+#include <immintrin.h>
+
+/**
+ * The SSE2 implementations are selected at build time, SSE2 being part of
+ * the x86-64 baseline. The AVX2 correlation is selected at run time, unless
+ * the build already targets AVX2.
+ *
+ * When `TEST_X86` is defined, the scalar implementations are kept,
+ * for the unit tests to check that the results are the same.
+ */
+
+#if __AVX2__
+#define LC3_X86_HAS_AVX2 1
+#elif defined(__GNUC__)
+#define LC3_X86_HAS_AVX2 __builtin_cpu_supports("avx2")
+#endif
+
+
+/**
+ * Import
+ */
+
+static inline int32_t filter_hp50(struct lc3_ltpf_hp50_state *, int32_t);
+
+
+/**
+ * Multiply accumulate of 16 bits vectors
+ * x, h, w         The 2 vectors of size `w`, multiple of 2
+ * return          Partial sums of products on the 4 lanes
+ *
+ * The sums wraps on 32 bits, as the scalar accumulation does
+ */
+LC3_HOT static inline __m128i sse_mac_s16(
+    const int16_t *x, const int16_t *h, int w)
+{
+    __m128i u = _mm_setzero_si128();
+    int k = 0;
+
+    for ( ; k + 8 <= w; k += 8)
+        u = _mm_add_epi32(u, _mm_madd_epi16(
+            _mm_loadu_si128((const __m128i *)(x + k)),
+            _mm_loadu_si128((const __m128i *)(h + k)) ));
+
+    if (k + 4 <= w) {
+        u = _mm_add_epi32(u, _mm_madd_epi16(
+            _mm_loadl_epi64((const __m128i *)(x + k)),
+            _mm_loadl_epi64((const __m128i *)(h + k)) ));
+        k += 4;
+    }
+
+    if (k + 2 <= w) {
+        int32_t x2, h2;
+        memcpy(&x2, x + k, sizeof(x2));
+        memcpy(&h2, h + k, sizeof(h2));
+        u = _mm_add_epi32(u, _mm_madd_epi16(
+            _mm_cvtsi32_si128(x2), _mm_cvtsi32_si128(h2) ));
+    }
+
+    return u;
+}
+
+/**
+ * Sum the 4 lanes of a 32 bits vector
+ */
+LC3_HOT static inline int32_t sse_addv_s32(__m128i u)
+{
+    u = _mm_add_epi32(u, _mm_shuffle_epi32(u, _MM_SHUFFLE(1, 0, 3, 2)));
+    u = _mm_add_epi32(u, _mm_shuffle_epi32(u, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtsi128_si32(u);
+}
+
+/**
+ * Resample from 8 / 16 / 32 KHz to 12.8 KHz Template
+ */
+#ifndef resample_x64k_12k8
+LC3_HOT static inline void sse_resample_x64k_12k8(const int p,
+    const int16_t *h, struct lc3_ltpf_hp50_state *hp50,
+    const int16_t *x, int16_t *y, int n)
+{
+    const int w = 2*(40 / p);
+
+    x -= w - 1;
+
+    for (int i = 0; i < 5*n; i += 5) {
+        const int16_t *hn = h + (i % p) * w;
+        const int16_t *xn = x + (i / p);
+
+        int32_t un = sse_addv_s32(sse_mac_s16(xn, hn, w));
+
+        int32_t yn = filter_hp50(hp50, un);
+        *(y++) = (yn + (1 << 15)) >> 16;
+    }
+}
+#ifndef TEST_X86
+#define resample_x64k_12k8 sse_resample_x64k_12k8
+#endif
+#endif /* resample_x64k_12k8 */
+
+/**
+ * Resample from 24 / 48 KHz to 12.8 KHz Template
+ */
+#ifndef resample_x192k_12k8
+LC3_HOT static inline void sse_resample_x192k_12k8(const int p,
+    const int16_t *h, struct lc3_ltpf_hp50_state *hp50,
+    const int16_t *x, int16_t *y, int n)
+{
+    const int w = 2*(120 / p);
+
+    x -= w - 1;
+
+    for (int i = 0; i < 15*n; i += 15) {
+        const int16_t *hn = h + (i % p) * w;
+        const int16_t *xn = x + (i / p);
+
+        int32_t un = sse_addv_s32(sse_mac_s16(xn, hn, w));
+
+        int32_t yn = filter_hp50(hp50, un);
+        *(y++) = (yn + (1 << 15)) >> 16;
+    }
+}
+#ifndef TEST_X86
+#define resample_x192k_12k8 sse_resample_x192k_12k8
+#endif
+#endif /* resample_x192k_12k8 */
+
+/**
+ * Return dot product of 2 vectors
+ *
+ * The sum of 2 products, computed on 32 bits, is in the range
+ * [-2^31 + 2^16, 2^31] : it wraps only for the upper bound.
+ * The sums are biased by -2^16 so they fit the 32 bits signed range,
+ * before being accumulated on 64 bits.
+ */
+#ifndef dot
+LC3_HOT static inline float sse_dot(const int16_t *a, const int16_t *b, int n)
+{
+    const __m128i bias = _mm_set1_epi32(1 << 16);
+    __m128i v = _mm_setzero_si128();
+
+    for (int i = 0; i < (n >> 3); i++, a += 8, b += 8) {
+        __m128i u = _mm_sub_epi32(_mm_madd_epi16(
+            _mm_loadu_si128((const __m128i *)a),
+            _mm_loadu_si128((const __m128i *)b) ), bias);
+
+        __m128i s = _mm_srai_epi32(u, 31);
+        v = _mm_add_epi64(v, _mm_unpacklo_epi32(u, s));
+        v = _mm_add_epi64(v, _mm_unpackhi_epi32(u, s));
+    }
+
+    int64_t v64[2];
+    _mm_storeu_si128((__m128i *)v64, v);
+
+    int32_t v32 = (v64[0] + v64[1] + (int64_t)n * (1 << 15) + (1 << 5)) >> 6;
+    return (float)v32;
+}
+#ifndef TEST_X86
+#define dot sse_dot
+#endif
+#endif /* dot */
+
+/**
+ * Return vector of correlations
+ */
+#ifndef correlate
+LC3_HOT static void sse_correlate(
+    const int16_t *a, const int16_t *b, int n, float *y, int nc)
+{
+    for (const float *ye = y + nc; y < ye; )
+        *(y++) = sse_dot(a, b--, n);
+}
+
+#ifdef LC3_X86_HAS_AVX2
+
+__attribute__((target("avx2")))
+LC3_HOT static void avx2_correlate(
+    const int16_t *a, const int16_t *b, int n, float *y, int nc)
+{
+    const __m256i bias = _mm256_set1_epi32(1 << 16);
+
+    for (const float *ye = y + nc; y < ye; b--) {
+        __m256i v = _mm256_setzero_si256();
+
+        for (int i = 0; i < n; i += 16) {
+            __m256i u = _mm256_sub_epi32(_mm256_madd_epi16(
+                _mm256_loadu_si256((const __m256i *)(a + i)),
+                _mm256_loadu_si256((const __m256i *)(b + i)) ), bias);
+
+            v = _mm256_add_epi64(v,
+                _mm256_cvtepi32_epi64(_mm256_castsi256_si128(u)));
+            v = _mm256_add_epi64(v,
+                _mm256_cvtepi32_epi64(_mm256_extracti128_si256(u, 1)));
+        }
+
+        __m128i v2 = _mm_add_epi64(
+            _mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+        v2 = _mm_add_epi64(v2, _mm_unpackhi_epi64(v2, v2));
+
+        int64_t v64[2];
+        _mm_storeu_si128((__m128i *)v64, v2);
+
+        int32_t v32 = (v64[0] + (int64_t)n * (1 << 15) + (1 << 5)) >> 6;
+        *(y++) = (float)v32;
+    }
+}
+
+#endif /* LC3_X86_HAS_AVX2 */
+
+LC3_HOT static void x86_correlate(
+    const int16_t *a, const int16_t *b, int n, float *y, int nc)
+{
+#ifdef LC3_X86_HAS_AVX2
+    if (LC3_X86_HAS_AVX2) {
+        avx2_correlate(a, b, n, y, nc);
+        return;
+    }
+#endif
+
+    sse_correlate(a, b, n, y, nc);
+}
+
+#ifndef TEST_X86
+#define correlate x86_correlate
+#endif
+#endif /* correlate */
+
+#endif /* __SSE2__ */
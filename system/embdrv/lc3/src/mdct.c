@@ -16,9 +16,25 @@
  *
  ******************************************************************************/
 
+/**
+ * The x86 kernels perform the operations of the scalar ones in the same
+ * order. Build the transforms with strict floating-point semantics,
+ * whatever the build flags (e.g. `-ffast-math`), so that the compiler
+ * does not reorder or fuse the scalar operations differently, and both
+ * give the same results.
+ */
+#if defined(__clang__)
+#pragma float_control(precise, on, push)
+#pragma clang fp contract(off)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC optimize ("no-fast-math", "fp-contract=off")
+#endif
+
 #include "tables.h"
 
 #include "mdct_neon.h"
+#include "mdct_x86.h"
 
 
 /* ----------------------------------------------------------------------------
@@ -449,3 +465,9 @@ void lc3_mdct_inverse(enum lc3_dt dt, enum lc3_srate sr,
 
     imdct_window(dt, sr, u.f, d, y);
 }
+
+#if defined(__clang__)
+#pragma float_control(pop)
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
@@ -0,0 +1,296 @@
+/******************************************************************************
+ *
+ *  Copyright 2023 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#if __SSE2__
+
+#include <emmintrin.h>
+
+/**
+ * The operations are performed in the order of the scalar implementations,
+ * a pair of complex numbers by vector, so that the results are the same.
+ *
+ * When `TEST_X86` is defined, the scalar implementations are kept,
+ * for the unit tests to check that the results are the same.
+ */
+
+
+/**
+ * Swap real and imaginary parts of complex numbers
+ */
+LC3_HOT static inline __m128 sse_cswap(__m128 x)
+{
+    return _mm_shuffle_ps(x, x, _MM_SHUFFLE(2, 3, 0, 1));
+}
+
+/**
+ * Split twiddles into real and imaginary parts
+ * w               Twiddles `a` and `b` as [ a.re, a.im, b.re, b.im ]
+ * w_re            Return [  a.re, a.re,  b.re, b.re ]
+ * w_im            Return [ -a.im, a.im, -b.im, b.im ]
+ */
+LC3_HOT static inline void sse_twiddles(__m128 w, __m128 *w_re, __m128 *w_im)
+{
+    const __m128 neg_re = _mm_castsi128_ps(
+        _mm_setr_epi32(INT32_MIN, 0, INT32_MIN, 0));
+
+    *w_re = _mm_shuffle_ps(w, w, _MM_SHUFFLE(2, 2, 0, 0));
+    *w_im = _mm_xor_ps(_mm_shuffle_ps(w, w, _MM_SHUFFLE(3, 3, 1, 1)), neg_re);
+}
+
+/**
+ * Complex multiply accumulate `y + x * w`, `w` splitted by `sse_twiddles()`
+ */
+LC3_HOT static inline __m128 sse_cmla(
+    __m128 y, __m128 x, __m128 w_re, __m128 w_im)
+{
+    y = _mm_add_ps(y, _mm_mul_ps(x, w_re));
+    return _mm_add_ps(y, _mm_mul_ps(sse_cswap(x), w_im));
+}
+
+/**
+ * Complex multiply subtract `y - x * w`, `w` splitted by `sse_twiddles()`
+ */
+LC3_HOT static inline __m128 sse_cmls(
+    __m128 y, __m128 x, __m128 w_re, __m128 w_im)
+{
+    y = _mm_sub_ps(y, _mm_mul_ps(x, w_re));
+    return _mm_sub_ps(y, _mm_mul_ps(sse_cswap(x), w_im));
+}
+
+/**
+ * Load and store a single complex number, in the low half of a vector
+ */
+LC3_HOT static inline __m128 sse_cload1(const struct lc3_complex *p)
+{
+    return _mm_castpd_ps(_mm_load_sd((const double *)p));
+}
+
+LC3_HOT static inline void sse_cstore1(struct lc3_complex *p, __m128 x)
+{
+    _mm_store_sd((double *)p, _mm_castps_pd(x));
+}
+
+
+/**
+ * FFT 5 Points
+ * The number of interleaved transform `n` assumed to be even
+ */
+#ifndef fft_5
+LC3_HOT static inline void sse_fft_5(
+    const struct lc3_complex *x, struct lc3_complex *y, int n)
+{
+    static const float cos1 =  0.3090169944;  /* cos(-2Pi 1/5) */
+    static const float cos2 = -0.8090169944;  /* cos(-2Pi 2/5) */
+
+    static const float sin1 = -0.9510565163;  /* sin(-2Pi 1/5) */
+    static const float sin2 = -0.5877852523;  /* sin(-2Pi 2/5) */
+
+    const __m128 c1 = _mm_set1_ps(cos1), c2 = _mm_set1_ps(cos2);
+    const __m128 s1 = _mm_setr_ps(-sin1, sin1, -sin1, sin1);
+    const __m128 s2 = _mm_setr_ps(-sin2, sin2, -sin2, sin2);
+
+    for (int i = 0; i < n; i += 2, x += 2, y += 10) {
+
+        __m128 x0 = _mm_loadu_ps((const float *)(x + 0*n));
+        __m128 x1 = _mm_loadu_ps((const float *)(x + 1*n));
+        __m128 x2 = _mm_loadu_ps((const float *)(x + 2*n));
+        __m128 x3 = _mm_loadu_ps((const float *)(x + 3*n));
+        __m128 x4 = _mm_loadu_ps((const float *)(x + 4*n));
+
+        __m128 s14 = _mm_add_ps(x1, x4);
+        __m128 s23 = _mm_add_ps(x2, x3);
+
+        __m128 d14 = sse_cswap(_mm_sub_ps(x1, x4));
+        __m128 d23 = sse_cswap(_mm_sub_ps(x2, x3));
+
+        __m128 y0, y1, y2, y3, y4;
+
+        y0 = _mm_add_ps(_mm_add_ps(x0, s14), s23);
+
+        y1 = _mm_add_ps(x0, _mm_mul_ps(s14, c1));
+        y1 = _mm_add_ps(y1, _mm_mul_ps(d14, s1));
+        y1 = _mm_add_ps(y1, _mm_mul_ps(s23, c2));
+        y1 = _mm_add_ps(y1, _mm_mul_ps(d23, s2));
+
+        y2 = _mm_add_ps(x0, _mm_mul_ps(s14, c2));
+        y2 = _mm_add_ps(y2, _mm_mul_ps(d14, s2));
+        y2 = _mm_add_ps(y2, _mm_mul_ps(s23, c1));
+        y2 = _mm_sub_ps(y2, _mm_mul_ps(d23, s1));
+
+        y3 = _mm_add_ps(x0, _mm_mul_ps(s14, c2));
+        y3 = _mm_sub_ps(y3, _mm_mul_ps(d14, s2));
+        y3 = _mm_add_ps(y3, _mm_mul_ps(s23, c1));
+        y3 = _mm_add_ps(y3, _mm_mul_ps(d23, s1));
+
+        y4 = _mm_add_ps(x0, _mm_mul_ps(s14, c1));
+        y4 = _mm_sub_ps(y4, _mm_mul_ps(d14, s1));
+        y4 = _mm_add_ps(y4, _mm_mul_ps(s23, c2));
+        y4 = _mm_sub_ps(y4, _mm_mul_ps(d23, s2));
+
+        _mm_storel_pi((__m64 *)(y + 0), y0);
+        _mm_storel_pi((__m64 *)(y + 1), y1);
+        _mm_storel_pi((__m64 *)(y + 2), y2);
+        _mm_storel_pi((__m64 *)(y + 3), y3);
+        _mm_storel_pi((__m64 *)(y + 4), y4);
+
+        _mm_storeh_pi((__m64 *)(y + 5), y0);
+        _mm_storeh_pi((__m64 *)(y + 6), y1);
+        _mm_storeh_pi((__m64 *)(y + 7), y2);
+        _mm_storeh_pi((__m64 *)(y + 8), y3);
+        _mm_storeh_pi((__m64 *)(y + 9), y4);
+    }
+}
+#ifndef TEST_X86
+#define fft_5 sse_fft_5
+#endif
+#endif /* fft_5 */
+
+/**
+ * FFT Butterfly 3 Points
+ */
+#ifndef fft_bf3
+LC3_HOT static inline void sse_fft_bf3(
+    const struct lc3_fft_bf3_twiddles *twiddles,
+    const struct lc3_complex *x, struct lc3_complex *y, int n)
+{
+    int n3 = twiddles->n3;
+    const struct lc3_complex (*w0_ptr)[2] = twiddles->t;
+    const struct lc3_complex (*w1_ptr)[2] = w0_ptr + n3;
+    const struct lc3_complex (*w2_ptr)[2] = w1_ptr + n3;
+
+    const struct lc3_complex *x0_ptr = x;
+    const struct lc3_complex *x1_ptr = x0_ptr + n*n3;
+    const struct lc3_complex *x2_ptr = x1_ptr + n*n3;
+
+    struct lc3_complex *y0_ptr = y;
+    struct lc3_complex *y1_ptr = y0_ptr + n3;
+    struct lc3_complex *y2_ptr = y1_ptr + n3;
+
+    for (int j, i = 0; i < n; i++,
+            y0_ptr += 3*n3, y1_ptr += 3*n3, y2_ptr += 3*n3) {
+
+        /* --- Process by pair --- */
+
+        for (j = 0; j < (n3 & ~1); j += 2,
+                x0_ptr += 2, x1_ptr += 2, x2_ptr += 2) {
+
+            __m128 x0 = _mm_loadu_ps((const float *)x0_ptr);
+            __m128 x1 = _mm_loadu_ps((const float *)x1_ptr);
+            __m128 x2 = _mm_loadu_ps((const float *)x2_ptr);
+
+            const struct lc3_complex (*w_ptr[3])[2] = { w0_ptr, w1_ptr, w2_ptr };
+            struct lc3_complex *y_ptr[3] = { y0_ptr, y1_ptr, y2_ptr };
+
+            for (int k = 0; k < 3; k++) {
+                __m128 w_lo = _mm_loadu_ps((const float *)w_ptr[k][j+0]);
+                __m128 w_hi = _mm_loadu_ps((const float *)w_ptr[k][j+1]);
+                __m128 w1_re, w1_im, w2_re, w2_im;
+
+                sse_twiddles(_mm_movelh_ps(w_lo, w_hi), &w1_re, &w1_im);
+                sse_twiddles(_mm_movehl_ps(w_hi, w_lo), &w2_re, &w2_im);
+
+                __m128 yn = sse_cmla(x0, x1, w1_re, w1_im);
+                yn = sse_cmla(yn, x2, w2_re, w2_im);
+                _mm_storeu_ps((float *)(y_ptr[k] + j), yn);
+            }
+        }
+
+        /* --- Last iteration --- */
+
+        if (n3 & 1) {
+
+            __m128 x0 = sse_cload1(x0_ptr++);
+            __m128 x1 = sse_cload1(x1_ptr++);
+            __m128 x2 = sse_cload1(x2_ptr++);
+
+            const struct lc3_complex (*w_ptr[3])[2] = { w0_ptr, w1_ptr, w2_ptr };
+            struct lc3_complex *y_ptr[3] = { y0_ptr, y1_ptr, y2_ptr };
+
+            for (int k = 0; k < 3; k++) {
+                __m128 w = _mm_loadu_ps((const float *)w_ptr[k][j]);
+                __m128 w1_re, w1_im, w2_re, w2_im;
+
+                sse_twiddles(w, &w1_re, &w1_im);
+                sse_twiddles(_mm_movehl_ps(w, w), &w2_re, &w2_im);
+
+                __m128 yn = sse_cmla(x0, x1, w1_re, w1_im);
+                yn = sse_cmla(yn, x2, w2_re, w2_im);
+                sse_cstore1(y_ptr[k] + j, yn);
+            }
+        }
+    }
+}
+#ifndef TEST_X86
+#define fft_bf3 sse_fft_bf3
+#endif
+#endif /* fft_bf3 */
+
+/**
+ * FFT Butterfly 2 Points
+ */
+#ifndef fft_bf2
+LC3_HOT static inline void sse_fft_bf2(
+    const struct lc3_fft_bf2_twiddles *twiddles,
+    const struct lc3_complex *x, struct lc3_complex *y, int n)
+{
+    int n2 = twiddles->n2;
+    const struct lc3_complex *w_ptr = twiddles->t;
+
+    const struct lc3_complex *x0_ptr = x;
+    const struct lc3_complex *x1_ptr = x0_ptr + n*n2;
+
+    struct lc3_complex *y0_ptr = y;
+    struct lc3_complex *y1_ptr = y0_ptr + n2;
+
+    for (int j, i = 0; i < n; i++, y0_ptr += 2*n2, y1_ptr += 2*n2) {
+
+        /* --- Process by pair --- */
+
+        for (j = 0; j < (n2 & ~1); j += 2, x0_ptr += 2, x1_ptr += 2) {
+
+            __m128 x0 = _mm_loadu_ps((const float *)x0_ptr);
+            __m128 x1 = _mm_loadu_ps((const float *)x1_ptr);
+            __m128 w_re, w_im;
+
+            sse_twiddles(_mm_loadu_ps((const float *)(w_ptr + j)), &w_re, &w_im);
+
+            _mm_storeu_ps((float *)(y0_ptr + j), sse_cmla(x0, x1, w_re, w_im));
+            _mm_storeu_ps((float *)(y1_ptr + j), sse_cmls(x0, x1, w_re, w_im));
+        }
+
+        /* --- Last iteration --- */
+
+        if (n2 & 1) {
+
+            __m128 x0 = sse_cload1(x0_ptr++);
+            __m128 x1 = sse_cload1(x1_ptr++);
+            __m128 w_re, w_im;
+
+            sse_twiddles(sse_cload1(w_ptr + j), &w_re, &w_im);
+
+            sse_cstore1(y0_ptr + j, sse_cmla(x0, x1, w_re, w_im));
+            sse_cstore1(y1_ptr + j, sse_cmls(x0, x1, w_re, w_im));
+        }
+    }
+}
+#ifndef TEST_X86
+#define fft_bf2 sse_fft_bf2
+#endif
+#endif /* fft_bf2 */
+
+#endif /* __SSE2__ */
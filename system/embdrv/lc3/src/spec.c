@@ -20,6 +20,8 @@
 #include "bits.h"
 #include "tables.h"
 
+#include "spec_x86.h"
+
 
 /* ----------------------------------------------------------------------------
  *  Global Gain / Quantization
@@ -205,6 +207,7 @@ static float unquantize_gain(int g_int)
  *   b0       0:positive or zero  1:negative
  *   b15..b1  Absolute value
  */
+#ifndef quantize
 LC3_HOT static void quantize(enum lc3_dt dt, enum lc3_srate sr,
     int g_int, float *x, uint16_t *xq, int *nq)
 {
@@ -228,6 +231,7 @@ LC3_HOT static void quantize(enum lc3_dt dt, enum lc3_srate sr,
         *nq = x0 || x1 ? ne : *nq - 2;
     }
 }
+#endif /* quantize */
 
 /**
  * Spectrum quantization inverse
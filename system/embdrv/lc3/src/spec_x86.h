@@ -0,0 +1,90 @@
+/******************************************************************************
+ *
+ *  Copyright 2023 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#if __SSE2__
+
+#include <emmintrin.h>
+
+/**
+ * When `TEST_X86` is defined, the scalar implementations are kept,
+ * for the unit tests to check that the results are the same.
+ */
+
+
+/**
+ * Import
+ */
+
+static float unquantize_gain(int);
+
+
+/**
+ * Spectrum quantization
+ *
+ * The number of coefficients is a multiple of 4
+ */
+#ifndef quantize
+LC3_HOT static void sse_quantize(enum lc3_dt dt, enum lc3_srate sr,
+    int g_int, float *x, uint16_t *xq, int *nq)
+{
+    float g_inv = 1 / unquantize_gain(g_int);
+    int ne = LC3_NE(dt, sr);
+
+    const __m128 vg_inv = _mm_set1_ps(g_inv);
+    const __m128 sign = _mm_set1_ps(-0.f);
+    const __m128 round = _mm_set1_ps(6.f/16);
+    const __m128 max = _mm_set1_ps(INT16_MAX);
+    const __m128i one = _mm_set1_epi32(1);
+    const __m128i bias = _mm_set1_epi32(1 << 15);
+
+    *nq = 0;
+
+    for (int i = 0; i < ne; i += 4) {
+        __m128 v = _mm_mul_ps(_mm_loadu_ps(x + i), vg_inv);
+        _mm_storeu_ps(x + i, v);
+
+        __m128i q = _mm_cvttps_epi32(
+            _mm_min_ps(_mm_add_ps(_mm_andnot_ps(sign, v), round), max));
+
+        /* --- Magnitude and sign, only set for non-zero values --- */
+
+        __m128i nz = _mm_cmpgt_epi32(q, _mm_setzero_si128());
+        __m128i neg = _mm_castps_si128(_mm_cmplt_ps(v, _mm_setzero_ps()));
+        __m128i s = _mm_and_si128(_mm_and_si128(nz, neg), one);
+
+        q = _mm_add_epi32(_mm_slli_epi32(q, 1), s);
+
+        /* --- Pack to unsigned 16 bits, using signed saturation --- */
+
+        q = _mm_packs_epi32(_mm_sub_epi32(q, bias), _mm_sub_epi32(q, bias));
+        q = _mm_xor_si128(q, _mm_set1_epi16(INT16_MIN));
+        _mm_storel_epi64((__m128i *)(xq + i), q);
+
+        /* --- Count up to the last non-zero pair --- */
+
+        int nz_mask = _mm_movemask_ps(_mm_castsi128_ps(nz));
+        if (nz_mask)
+            *nq = i + (nz_mask & 0xc ? 4 : 2);
+    }
+}
+#ifndef TEST_X86
+#define quantize sse_quantize
+#endif
+#endif /* quantize */
+
+#endif /* __SSE2__ */
@@ -0,0 +1,192 @@
+/******************************************************************************
+ *
+ *  Copyright 2023 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include <math.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <lc3.h>
+
+/**
+ * Encode and decode with the library, using the x86 kernels, and with
+ * the scalar kernels. The frames and the PCM must be the same, with the
+ * flags of the library build (e.g. `-O3 -ffast-math`).
+ */
+
+struct codec {
+    lc3_encoder_t (*setup_encoder)(int, int, int, void *);
+    int (*encode)(lc3_encoder_t, enum lc3_pcm_format,
+        const void *, int, int, void *);
+    lc3_decoder_t (*setup_decoder)(int, int, int, void *);
+    int (*decode)(lc3_decoder_t, const void *, int,
+        enum lc3_pcm_format, void *, int);
+};
+
+static const struct codec codec_x86 = {
+    lc3_setup_encoder, lc3_encode, lc3_setup_decoder, lc3_decode };
+
+/* -------------------------------------------------------------------------- */
+
+/**
+ * The modules having x86 kernels are built again with the scalar kernels,
+ * and their functions renamed. The other modules are shared with the
+ * library.
+ */
+
+#define TEST_X86
+
+#define lc3_frame_samples    lc3_scalar_frame_samples
+#define lc3_frame_bytes      lc3_scalar_frame_bytes
+#define lc3_resolve_bitrate  lc3_scalar_resolve_bitrate
+#define lc3_delay_samples    lc3_scalar_delay_samples
+#define lc3_encoder_size     lc3_scalar_encoder_size
+#define lc3_setup_encoder    lc3_scalar_setup_encoder
+#define lc3_encode           lc3_scalar_encode
+#define lc3_decoder_size     lc3_scalar_decoder_size
+#define lc3_setup_decoder    lc3_scalar_setup_decoder
+#define lc3_decode           lc3_scalar_decode
+
+#define lc3_ltpf_analyse     lc3_scalar_ltpf_analyse
+#define lc3_ltpf_synthesize  lc3_scalar_ltpf_synthesize
+#define lc3_ltpf_disable     lc3_scalar_ltpf_disable
+#define lc3_ltpf_get_nbits   lc3_scalar_ltpf_get_nbits
+#define lc3_ltpf_put_data    lc3_scalar_ltpf_put_data
+#define lc3_ltpf_get_data    lc3_scalar_ltpf_get_data
+
+#define lc3_mdct_forward     lc3_scalar_mdct_forward
+#define lc3_mdct_inverse     lc3_scalar_mdct_inverse
+
+#define lc3_spec_analyze     lc3_scalar_spec_analyze
+#define lc3_spec_put_side    lc3_scalar_spec_put_side
+#define lc3_spec_encode      lc3_scalar_spec_encode
+#define lc3_spec_get_side    lc3_scalar_spec_get_side
+#define lc3_spec_decode      lc3_scalar_spec_decode
+
+#include <lc3.c>
+
+#define synthesize ltpf_synthesize
+#include <ltpf.c>
+#undef synthesize
+
+#include <mdct.c>
+#include <spec.c>
+
+static const struct codec codec_scalar = {
+    lc3_setup_encoder, lc3_encode, lc3_setup_decoder, lc3_decode };
+
+/* -------------------------------------------------------------------------- */
+
+struct stream {
+    lc3_encoder_mem_48k_t encoder_mem;
+    lc3_decoder_mem_48k_t decoder_mem;
+    lc3_encoder_t encoder;
+    lc3_decoder_t decoder;
+};
+
+static void setup_stream(const struct codec *codec,
+    int dt_us, int sr_hz, struct stream *stream)
+{
+    stream->encoder = codec->setup_encoder(
+        dt_us, sr_hz, 0, &stream->encoder_mem);
+    stream->decoder = codec->setup_decoder(
+        dt_us, sr_hz, 0, &stream->decoder_mem);
+}
+
+/**
+ * Voiced signal, harmonics of a 220 Hz pitch plus noise, so that all the
+ * encoder tools (LTPF, TNS, noise filling) are exercised
+ */
+static void generate(int sr_hz, int ns, int frame, int16_t *pcm)
+{
+    const double two_pi = 6.28318530717958647692;
+
+    for (int i = 0; i < ns; i++) {
+        double t = (double)(frame * ns + i) / sr_hz, v = 0;
+        for (int h = 1; h <= 8 && 220 * h < sr_hz / 2; h++)
+            v += 4000 / h * sin(two_pi * 220 * h * t);
+        pcm[i] = (int16_t)(v + (rand() % 1025) - 512);
+    }
+}
+
+static int check_stream(int dt_us, int sr_hz)
+{
+    static const int frame_bytes[] =
+        { LC3_MIN_FRAME_BYTES, 40, 60, 80, 120, 160, LC3_MAX_FRAME_BYTES };
+    const int nframes = 100;
+
+    static struct stream x86, scalar;
+    setup_stream(&codec_x86, dt_us, sr_hz, &x86);
+    setup_stream(&codec_scalar, dt_us, sr_hz, &scalar);
+
+    int ns = lc3_frame_samples(dt_us, sr_hz);
+
+    for (int i = 0; i < nframes; i++) {
+        int16_t pcm[480], pcm_x86[480], pcm_scalar[480];
+        uint8_t frame_x86[LC3_MAX_FRAME_BYTES];
+        uint8_t frame_scalar[LC3_MAX_FRAME_BYTES];
+
+        int nbytes = frame_bytes[i % (sizeof(frame_bytes) / sizeof(int))];
+        generate(sr_hz, ns, i, pcm);
+
+        codec_x86.encode(x86.encoder,
+            LC3_PCM_FORMAT_S16, pcm, 1, nbytes, frame_x86);
+        codec_scalar.encode(scalar.encoder,
+            LC3_PCM_FORMAT_S16, pcm, 1, nbytes, frame_scalar);
+
+        if (memcmp(frame_x86, frame_scalar, nbytes) != 0)
+            return -1;
+
+        /* Lose a frame from time to time, to run the concealment */
+        const void *in = i % 10 == 9 ? NULL : frame_x86;
+
+        codec_x86.decode(x86.decoder,
+            in, nbytes, LC3_PCM_FORMAT_S16, pcm_x86, 1);
+        codec_scalar.decode(scalar.decoder,
+            in, nbytes, LC3_PCM_FORMAT_S16, pcm_scalar, 1);
+
+        if (memcmp(pcm_x86, pcm_scalar, ns * sizeof(*pcm)) != 0)
+            return -1;
+    }
+
+    return 0;
+}
+
+static int check_lc3(void)
+{
+    static const int dt_us[] = { 7500, 10000 };
+    static const int sr_hz[] = { 8000, 16000, 24000, 32000, 48000 };
+
+    for (int i = 0; i < 2; i++)
+        for (int j = 0; j < 5; j++)
+            if (check_stream(dt_us[i], sr_hz[j]) < 0)
+                return -1;
+
+    return 0;
+}
+
+int main()
+{
+    int r;
+
+    printf("Checking LC3 x86 bit-exactness... "); fflush(stdout);
+    printf("%s\n", (r = check_lc3()) == 0 ? "OK" : "Failed");
+
+    return r;
+}
@@ -0,0 +1,86 @@
+/******************************************************************************
+ *
+ *  Copyright 2023 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* -------------------------------------------------------------------------- */
+
+#define TEST_X86
+#include <mdct.c>
+
+/* -------------------------------------------------------------------------- */
+
+/**
+ * The x86 implementations perform the operations of the scalar ones,
+ * in the same order. The transforms are built with strict floating-point
+ * semantics, even with `-ffast-math`, so the results are the same.
+ */
+static int check_complex(
+    const struct lc3_complex *y, const struct lc3_complex *y_x86, int n)
+{
+    return memcmp(y, y_x86, n * sizeof(*y)) == 0 ? 0 : -1;
+}
+
+static int check_fft(void)
+{
+    struct lc3_complex x[240];
+    struct lc3_complex y[240] = { 0 }, y_x86[240] = { 0 };
+
+    for (int i = 0; i < 240; i++) {
+          x[i].re = (double)rand() / RAND_MAX;
+          x[i].im = (double)rand() / RAND_MAX;
+    }
+
+    fft_5(x, y, 240/5);
+    sse_fft_5(x, y_x86, 240/5);
+    if (check_complex(y, y_x86, 240) < 0)
+        return -1;
+
+    for (int i3 = 0; i3 < 2; i3++) {
+        int n = 240 / (5 * 3*(1 + 2*i3));
+
+        fft_bf3(lc3_fft_twiddles_bf3[i3], x, y, n);
+        sse_fft_bf3(lc3_fft_twiddles_bf3[i3], x, y_x86, n);
+        if (check_complex(y, y_x86, 240) < 0)
+            return -1;
+    }
+
+    for (int i2 = 0; i2 < 4; i2++) {
+        int n = 240 / (30 << i2);
+
+        fft_bf2(lc3_fft_twiddles_bf2[i2][1], x, y, n);
+        sse_fft_bf2(lc3_fft_twiddles_bf2[i2][1], x, y_x86, n);
+        if (check_complex(y, y_x86, 240) < 0)
+            return -1;
+    }
+
+    return 0;
+}
+
+int check_mdct(void)
+{
+    int ret;
+
+    if ((ret = check_fft()) < 0)
+        return ret;
+
+    return 0;
+}
@@ -0,0 +1,84 @@
+/******************************************************************************
+ *
+ *  Copyright 2023 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+/* -------------------------------------------------------------------------- */
+
+#define TEST_X86
+#include <spec.c>
+
+int lc3_bwdet_get_nbits(enum lc3_srate a)
+{ return (void)a, 0; }
+
+int lc3_sns_get_nbits(void)
+{ return 0; }
+
+int lc3_tns_get_nbits(const lc3_tns_data_t *a)
+{ return (void)a, 0; }
+
+int lc3_get_bits_left(const lc3_bits_t *a)
+{ return (void)a, 0; }
+
+void lc3_ac_read_renorm(lc3_bits_t *a)
+{ (void)a; }
+
+void lc3_ac_write_renorm(lc3_bits_t *a)
+{ (void)a; }
+
+/* -------------------------------------------------------------------------- */
+
+static int check_quantize(void)
+{
+    float x[LC3_MAX_NE], x_x86[LC3_MAX_NE];
+    uint16_t xq[LC3_MAX_NE], xq_x86[LC3_MAX_NE];
+    int nq, nq_x86;
+
+    for (int dt = 0; dt < LC3_NUM_DT; dt++)
+        for (int sr = 0; sr < LC3_NUM_SRATE; sr++) {
+            int ne = LC3_NE(dt, sr);
+
+            for (int i = 0; i < ne; i++)
+                x[i] = x_x86[i] = i < ne - 4*sr ?
+                    ((double)rand() / RAND_MAX - 0.5) * 1e5 : 0;
+
+            for (int g_int = -90; g_int < 90; g_int += 15) {
+                quantize(dt, sr, g_int, x, xq, &nq);
+                sse_quantize(dt, sr, g_int, x_x86, xq_x86, &nq_x86);
+
+                if (memcmp(x, x_x86, ne * sizeof(*x)) != 0 ||
+                    memcmp(xq, xq_x86, ne * sizeof(*xq)) != 0 ||
+                    nq != nq_x86)
+                    return -1;
+            }
+        }
+
+    return 0;
+}
+
+int check_spec(void)
+{
+    int ret;
+
+    if ((ret = check_quantize()) < 0)
+        return ret;
+
+    return 0;
+}
@@ -0,0 +1,96 @@
+/******************************************************************************
+ *
+ *  Copyright 2023 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include <string.h>
+
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "sbc_encoder.h"
+
+extern "C" {
+#include "sbc_enc_func_declare.h"
+}
+
+using ::benchmark::State;
+
+namespace {
+
+constexpr int kNumFrames = 100;
+constexpr int kNumOfBlocks = 16;
+
+// Music like signal, a few tones plus noise, on the 2 channels
+std::vector<int16_t> MakePcm(int sr_hz) {
+  std::vector<int16_t> pcm(kNumFrames * kNumOfBlocks * SUB_BANDS_8 * 2);
+  std::minstd_rand random;
+  std::uniform_int_distribution<int> noise(-512, 512);
+
+  for (size_t i = 0; i < pcm.size(); i++) {
+    double t = (double)(i / 2) / sr_hz;
+    double v = 8000 * std::sin(2 * M_PI * 440 * t) +
+               4000 * std::sin(2 * M_PI * (i & 1 ? 1250 : 3300) * t);
+    pcm[i] = (int16_t)(v + noise(random));
+  }
+
+  return pcm;
+}
+
+}  // namespace
+
+// Encode joint stereo, 8 subbands, 16 blocks, bitpool 53 frames, with the
+// portable functions (range 1 = 0) or the ones selected for the CPU
+static void BM_Encode(State& state) {
+  int sr_hz = state.range(0);
+  bool scalar = state.range(1) == 0;
+
+  SBC_ENC_PARAMS params;
+  memset(&params, 0, sizeof(params));
+  params.s16SamplingFreq = sr_hz == 48000 ? SBC_sf48000 : SBC_sf44100;
+  params.s16ChannelMode = SBC_JOINT_STEREO;
+  params.s16NumOfSubBands = SUB_BANDS_8;
+  params.s16NumOfBlocks = kNumOfBlocks;
+  params.s16AllocationMethod = SBC_LOUDNESS;
+  params.Format = SBC_FORMAT_GENERAL;
+  SBC_Encoder_Init(&params);
+  params.s16BitPool = 53;
+  if (scalar)
+    SbcEncDspInitScalar(&gstrEncDsp);
+  else
+    SbcEncDspInit(&gstrEncDsp);
+
+  auto pcm = MakePcm(sr_hz);
+  int ns = kNumOfBlocks * SUB_BANDS_8 * 2;
+  uint8_t frame[512];
+
+  for (auto _ : state) {
+    for (int i = 0; i < kNumFrames; i++)
+      SBC_Encode(&params, pcm.data() + i * ns, frame);
+    benchmark::DoNotOptimize(frame);
+  }
+
+  state.SetItemsProcessed(state.iterations() * kNumFrames);
+  state.counters["realtime_x"] = benchmark::Counter(
+      state.iterations() * kNumFrames * kNumOfBlocks * SUB_BANDS_8 /
+          (double)sr_hz,
+      benchmark::Counter::kIsRate);
+}
+
+BENCHMARK(BM_Encode)->ArgsProduct({{44100, 48000}, {0, 1}});
@@ -26,6 +26,26 @@
 #define SBC_FUNCDECLARE_H
 
 #include "sbc_encoder.h"
+
+/* The vector kernels implement the default fixed point options only */
+#if (SBC_VECTOR_OPT == TRUE && SBC_ARM_ASM_OPT == FALSE &&                  \
+     SBC_DSP_OPT == FALSE && SBC_IPAQ_OPT == TRUE &&                        \
+     SBC_IS_64_MULT_IN_WINDOW_ACCU == FALSE && SBC_FAST_DCT == TRUE &&      \
+     SBC_IS_64_MULT_IN_IDCT == FALSE && SBC_IS_64_MULT_IN_QUANTIZER == TRUE)
+#if defined(__SSE2__)
+#define SBC_VECTOR_X86 TRUE
+#elif defined(__ARM_NEON)
+#define SBC_VECTOR_NEON TRUE
+#endif
+#endif
+
+#ifndef SBC_VECTOR_X86
+#define SBC_VECTOR_X86 FALSE
+#endif
+#ifndef SBC_VECTOR_NEON
+#define SBC_VECTOR_NEON FALSE
+#endif
+
 /* Global data */
 #if (SBC_IS_64_MULT_IN_WINDOW_ACCU == FALSE)
 extern const int16_t gas32CoeffFor4SBs[];
@@ -35,6 +55,45 @@ extern const int32_t gas32CoeffFor4SBs[];
 extern const int32_t gas32CoeffFor8SBs[];
 #endif
 
+#if (SBC_VECTOR_X86 == TRUE || SBC_VECTOR_NEON == TRUE)
+/* Window coefficients of the vector kernels, the windowed sample j of a block
+ * is the sum over k of [k][j] * x[k * 2 * subbands + j] */
+extern const int16_t gas16WindowFor4SBs[5 * 8];
+extern const int16_t gas16WindowFor8SBs[5 * 16];
+#endif
+
+/* Signal processing functions, selected at run time for the CPU */
+typedef struct SBC_ENC_DSP_TAG {
+  /* Windowing of a block, from the history of samples of a channel */
+  void (*Window4)(const int16_t* ps16X, int32_t* ps32Y);
+  void (*Window8)(const int16_t* ps16X, int32_t* ps32Y);
+
+  /* DCT of |s32NumOfRows| windowed blocks to subband samples */
+  void (*Idct4)(const int32_t* ps32Y, int32_t s32NumOfRows, int32_t* ps32Sb);
+  void (*Idct8)(const int32_t* ps32Y, int32_t s32NumOfRows, int32_t* ps32Sb);
+
+  /* Maximum absolute value of the |s32NumOfCols| columns of the blocks of
+   * subband samples, for the scale factors */
+  void (*MaxAbs)(const int32_t* ps32Sb, int32_t s32NumOfCols,
+                 int32_t s32NumOfBlocks, int32_t* ps32Max);
+
+  /* Maximum absolute value of the (L + R) / 2 and (L - R) / 2 subband
+   * samples, for the joint stereo decision */
+  void (*MaxAbsJoint)(const int32_t* ps32Sb, int32_t s32NumOfSubBands,
+                      int32_t s32NumOfBlocks, int32_t* ps32MaxSum,
+                      int32_t* ps32MaxDiff);
+
+  /* Quantization of the subband samples, with the scale factors and bits
+   * of the |s32NumOfCols| columns. Columns without bits are left unset. */
+  void (*Quantize)(const int32_t* ps32Sb, int32_t s32NumOfCols,
+                   int32_t s32NumOfBlocks, const int16_t* ps16ScaleFactor,
+                   const int16_t* ps16Bits, uint16_t* pu16Quantized);
+} SBC_ENC_DSP;
+
+/* Selected once for all the encoders, by the first call to SBC_Encoder_Init()
+ * or SBC_Encode() */
+extern SBC_ENC_DSP gstrEncDsp;
+
 /* Global functions*/
 
 void sbc_enc_bit_alloc_mono(SBC_ENC_PARAMS* CodecParams);
@@ -50,6 +109,33 @@ void SBC_FastIDCT4(int32_t* x0, int32_t* pOutVect);
 
 uint32_t EncPacking(SBC_ENC_PARAMS* strEncParams, uint8_t* output);
 void EncQuantizer(SBC_ENC_PARAMS*);
+
+void SbcWindow4(const int16_t* ps16X, int32_t* ps32Y);
+void SbcWindow8(const int16_t* ps16X, int32_t* ps32Y);
+void SbcIdct4(const int32_t* ps32Y, int32_t s32NumOfRows, int32_t* ps32Sb);
+void SbcIdct8(const int32_t* ps32Y, int32_t s32NumOfRows, int32_t* ps32Sb);
+void SbcMaxAbs(const int32_t* ps32Sb, int32_t s32NumOfCols,
+               int32_t s32NumOfBlocks, int32_t* ps32Max);
+void SbcMaxAbsJoint(const int32_t* ps32Sb, int32_t s32NumOfSubBands,
+                    int32_t s32NumOfBlocks, int32_t* ps32MaxSum,
+                    int32_t* ps32MaxDiff);
+void SbcQuantize(const int32_t* ps32Sb, int32_t s32NumOfCols,
+                 int32_t s32NumOfBlocks, const int16_t* ps16ScaleFactor,
+                 const int16_t* ps16Bits, uint16_t* pu16Quantized);
+
+/* Select the portable functions, the vector ones are bit exact with them */
+void SbcEncDspInitScalar(SBC_ENC_DSP* pstrDsp);
+#if (SBC_VECTOR_X86 == TRUE)
+void SbcEncDspInitSse2(SBC_ENC_DSP* pstrDsp);
+void SbcEncDspInitAvx2(SBC_ENC_DSP* pstrDsp);
+bool SbcEncDspHasAvx2(void);
+#endif
+#if (SBC_VECTOR_NEON == TRUE)
+void SbcEncDspInitNeon(SBC_ENC_DSP* pstrDsp);
+#endif
+
+/* Select the fastest functions for the running CPU */
+void SbcEncDspInit(SBC_ENC_DSP* pstrDsp);
 #if (SBC_DSP_OPT == TRUE)
 int32_t SBC_Multiply_32_16_Simplified(int32_t s32In2Temp, int32_t s32In1Temp);
 #endif
@@ -150,6 +150,14 @@
 #define SBC_JOINT_STE_INCLUDED TRUE
 #endif
 
+/* Set SBC_VECTOR_OPT to FALSE to disable the SSE2 / AVX2 / NEON versions of
+ * the windowing, DCT, scale factor and quantizer computations. They are bit
+ * exact with the default fixed point options above, and are not used with
+ * other options. */
+#ifndef SBC_VECTOR_OPT
+#define SBC_VECTOR_OPT TRUE
+#endif
+
 #define MINIMUM_ENC_VX_BUFFER_SIZE (8 * 10 * 2)
 #ifndef ENC_VX_BUFFER_SIZE
 #define ENC_VX_BUFFER_SIZE (MINIMUM_ENC_VX_BUFFER_SIZE + 64)
@@ -197,10 +197,73 @@
 #define WIND_8_SUBBANDS_8_2 (int16_t)0x12CF /* 40 = 0x12CF6C75 */
 #endif
 
+#if (SBC_VECTOR_X86 == TRUE || SBC_VECTOR_NEON == TRUE)
+const int16_t gas16WindowFor4SBs[5 * 8] = {
+    0,                    WIND_4_SUBBANDS_1_0, WIND_4_SUBBANDS_2_0,
+    WIND_4_SUBBANDS_3_0,  WIND_4_SUBBANDS_4_0, WIND_4_SUBBANDS_3_4,
+    WIND_4_SUBBANDS_2_4,  WIND_4_SUBBANDS_1_4,
+
+    WIND_4_SUBBANDS_0_1,  WIND_4_SUBBANDS_1_1, WIND_4_SUBBANDS_2_1,
+    WIND_4_SUBBANDS_3_1,  WIND_4_SUBBANDS_4_1, WIND_4_SUBBANDS_3_3,
+    WIND_4_SUBBANDS_2_3,  WIND_4_SUBBANDS_1_3,
+
+    WIND_4_SUBBANDS_0_2,  WIND_4_SUBBANDS_1_2, WIND_4_SUBBANDS_2_2,
+    WIND_4_SUBBANDS_3_2,  WIND_4_SUBBANDS_4_2, WIND_4_SUBBANDS_3_2,
+    WIND_4_SUBBANDS_2_2,  WIND_4_SUBBANDS_1_2,
+
+    -WIND_4_SUBBANDS_0_2, WIND_4_SUBBANDS_1_3, WIND_4_SUBBANDS_2_3,
+    WIND_4_SUBBANDS_3_3,  WIND_4_SUBBANDS_4_1, WIND_4_SUBBANDS_3_1,
+    WIND_4_SUBBANDS_2_1,  WIND_4_SUBBANDS_1_1,
+
+    -WIND_4_SUBBANDS_0_1, WIND_4_SUBBANDS_1_4, WIND_4_SUBBANDS_2_4,
+    WIND_4_SUBBANDS_3_4,  WIND_4_SUBBANDS_4_0, WIND_4_SUBBANDS_3_0,
+    WIND_4_SUBBANDS_2_0,  WIND_4_SUBBANDS_1_0,
+};
+
+const int16_t gas16WindowFor8SBs[5 * 16] = {
+    0,                    WIND_8_SUBBANDS_1_0, WIND_8_SUBBANDS_2_0,
+    WIND_8_SUBBANDS_3_0,  WIND_8_SUBBANDS_4_0, WIND_8_SUBBANDS_5_0,
+    WIND_8_SUBBANDS_6_0,  WIND_8_SUBBANDS_7_0, WIND_8_SUBBANDS_8_0,
+    WIND_8_SUBBANDS_7_4,  WIND_8_SUBBANDS_6_4, WIND_8_SUBBANDS_5_4,
+    WIND_8_SUBBANDS_4_4,  WIND_8_SUBBANDS_3_4, WIND_8_SUBBANDS_2_4,
+    WIND_8_SUBBANDS_1_4,
+
+    WIND_8_SUBBANDS_0_1,  WIND_8_SUBBANDS_1_1, WIND_8_SUBBANDS_2_1,
+    WIND_8_SUBBANDS_3_1,  WIND_8_SUBBANDS_4_1, WIND_8_SUBBANDS_5_1,
+    WIND_8_SUBBANDS_6_1,  WIND_8_SUBBANDS_7_1, WIND_8_SUBBANDS_8_1,
+    WIND_8_SUBBANDS_7_3,  WIND_8_SUBBANDS_6_3, WIND_8_SUBBANDS_5_3,
+    WIND_8_SUBBANDS_4_3,  WIND_8_SUBBANDS_3_3, WIND_8_SUBBANDS_2_3,
+    WIND_8_SUBBANDS_1_3,
+
+    WIND_8_SUBBANDS_0_2,  WIND_8_SUBBANDS_1_2, WIND_8_SUBBANDS_2_2,
+    WIND_8_SUBBANDS_3_2,  WIND_8_SUBBANDS_4_2, WIND_8_SUBBANDS_5_2,
+    WIND_8_SUBBANDS_6_2,  WIND_8_SUBBANDS_7_2, WIND_8_SUBBANDS_8_2,
+    WIND_8_SUBBANDS_7_2,  WIND_8_SUBBANDS_6_2, WIND_8_SUBBANDS_5_2,
+    WIND_8_SUBBANDS_4_2,  WIND_8_SUBBANDS_3_2, WIND_8_SUBBANDS_2_2,
+    WIND_8_SUBBANDS_1_2,
+
+    -WIND_8_SUBBANDS_0_2, WIND_8_SUBBANDS_1_3, WIND_8_SUBBANDS_2_3,
+    WIND_8_SUBBANDS_3_3,  WIND_8_SUBBANDS_4_3, WIND_8_SUBBANDS_5_3,
+    WIND_8_SUBBANDS_6_3,  WIND_8_SUBBANDS_7_3, WIND_8_SUBBANDS_8_1,
+    WIND_8_SUBBANDS_7_1,  WIND_8_SUBBANDS_6_1, WIND_8_SUBBANDS_5_1,
+    WIND_8_SUBBANDS_4_1,  WIND_8_SUBBANDS_3_1, WIND_8_SUBBANDS_2_1,
+    WIND_8_SUBBANDS_1_1,
+
+    -WIND_8_SUBBANDS_0_1, WIND_8_SUBBANDS_1_4, WIND_8_SUBBANDS_2_4,
+    WIND_8_SUBBANDS_3_4,  WIND_8_SUBBANDS_4_4, WIND_8_SUBBANDS_5_4,
+    WIND_8_SUBBANDS_6_4,  WIND_8_SUBBANDS_7_4, WIND_8_SUBBANDS_8_0,
+    WIND_8_SUBBANDS_7_0,  WIND_8_SUBBANDS_6_0, WIND_8_SUBBANDS_5_0,
+    WIND_8_SUBBANDS_4_0,  WIND_8_SUBBANDS_3_0, WIND_8_SUBBANDS_2_0,
+    WIND_8_SUBBANDS_1_0,
+};
+#endif
+
 #if (SBC_USE_ARM_PRAGMA == TRUE)
 #pragma arm section zidata = "sbc_s32_analysis_section"
 #endif
-static int32_t s32DCTY[16] = {0};
+/* Windowed samples of the blocks of a frame, to be transformed together */
+static int32_t as32DCTY[SBC_MAX_NUM_OF_BLOCKS * SBC_MAX_NUM_OF_CHANNELS *
+                        SBC_MAX_NUM_OF_SUBBANDS * 2];
 static int32_t s32X[ENC_VX_BUFFER_SIZE / 2];
 static int16_t* s16X =
     (int16_t*)s32X; /* s16X must be 32 bits aligned cf  SHIFTUP_X8_2*/
@@ -1188,17 +1251,13 @@ static int16_t* s16X =
 static int16_t ShiftCounter = 0;
 extern int16_t EncMaxShiftCounter;
 /****************************************************************************
-* SbcAnalysisFilter - performs Analysis of the input audio stream
+* SbcWindow - performs the windowing of a block, |s16X| points to the
+* history of the channel
 *
 * RETURNS : N/A
 */
-void SbcAnalysisFilter4(SBC_ENC_PARAMS* pstrEncParams, int16_t* input) {
-  int16_t* ps16PcmBuf;
-  int32_t* ps32SbBuf;
-  int32_t s32Blk, s32Ch;
-  int32_t s32NumOfChannels, s32NumOfBlocks;
-  int32_t i, *ps32X, *ps32X2;
-  int32_t Offset, Offset2, ChOffset;
+void SbcWindow4(const int16_t* s16X, int32_t* s32DCTY) {
+  const int32_t ChOffset = 0;
 #if (SBC_ARM_ASM_OPT == TRUE)
   register int32_t s32Hi, s32Hi2;
 #else
@@ -1209,20 +1268,55 @@ void SbcAnalysisFilter4(SBC_ENC_PARAMS* pstrEncParams, int16_t* input) {
   register int32_t s32Temp, s32Temp2;
 #endif
 #else
-
 #if (SBC_IS_64_MULT_IN_WINDOW_ACCU == TRUE)
   int64_t s64Temp;
 #endif
+#endif
+#endif
+
+  WINDOW_PARTIAL_4
+}
 
+void SbcWindow8(const int16_t* s16X, int32_t* s32DCTY) {
+  const int32_t ChOffset = 0;
+#if (SBC_ARM_ASM_OPT == TRUE)
+  register int32_t s32Hi, s32Hi2;
+#else
+#if (SBC_IPAQ_OPT == TRUE)
+#if (SBC_IS_64_MULT_IN_WINDOW_ACCU == TRUE)
+  register int64_t s64Temp, s64Temp2;
+#else
+  register int32_t s32Temp, s32Temp2;
+#endif
+#else
+#if (SBC_IS_64_MULT_IN_WINDOW_ACCU == TRUE)
+  int64_t s64Temp;
+#endif
 #endif
 #endif
 
+  WINDOW_PARTIAL_8
+}
+
+/****************************************************************************
+* SbcAnalysisFilter - performs Analysis of the input audio stream
+*
+* RETURNS : N/A
+*/
+void SbcAnalysisFilter4(SBC_ENC_PARAMS* pstrEncParams, int16_t* input) {
+  int16_t* ps16PcmBuf;
+  int32_t* ps32DCTY;
+  int32_t s32Blk, s32Ch;
+  int32_t s32NumOfChannels, s32NumOfBlocks;
+  int32_t i, *ps32X, *ps32X2;
+  int32_t Offset, Offset2, ChOffset;
+
   s32NumOfChannels = pstrEncParams->s16NumOfChannels;
   s32NumOfBlocks = pstrEncParams->s16NumOfBlocks;
 
   ps16PcmBuf = input;
 
-  ps32SbBuf = pstrEncParams->s32SbBuffer;
+  ps32DCTY = as32DCTY;
   Offset2 = (int32_t)(EncMaxShiftCounter + 40);
   for (s32Blk = 0; s32Blk < s32NumOfBlocks; s32Blk++) {
     Offset = (int32_t)(EncMaxShiftCounter - ShiftCounter);
@@ -1257,11 +1351,8 @@ void SbcAnalysisFilter4(SBC_ENC_PARAMS* pstrEncParams, int16_t* input) {
     for (s32Ch = 0; s32Ch < s32NumOfChannels; s32Ch++) {
       ChOffset = s32Ch * Offset2 + Offset;
 
-      WINDOW_PARTIAL_4
-
-      SBC_FastIDCT4(s32DCTY, ps32SbBuf);
-
-      ps32SbBuf += SUB_BANDS_4;
+      gstrEncDsp.Window4(s16X + ChOffset, ps32DCTY);
+      ps32DCTY += SUB_BANDS_4 * 2;
     }
     if (s32NumOfChannels == 1) {
       if (ShiftCounter >= EncMaxShiftCounter) {
@@ -1279,39 +1370,27 @@ void SbcAnalysisFilter4(SBC_ENC_PARAMS* pstrEncParams, int16_t* input) {
       }
     }
   }
+
+  gstrEncDsp.Idct4(as32DCTY, s32NumOfBlocks * s32NumOfChannels,
+                   pstrEncParams->s32SbBuffer);
 }
 
 /* ////////////////////////////////////////////////////////////////////////// */
 void SbcAnalysisFilter8(SBC_ENC_PARAMS* pstrEncParams, int16_t* input) {
   int16_t* ps16PcmBuf;
-  int32_t* ps32SbBuf;
+  int32_t* ps32DCTY;
   int32_t s32Blk, s32Ch; /* counter for block*/
   int32_t Offset, Offset2;
   int32_t s32NumOfChannels, s32NumOfBlocks;
   int32_t i, *ps32X, *ps32X2;
   int32_t ChOffset;
-#if (SBC_ARM_ASM_OPT == TRUE)
-  register int32_t s32Hi, s32Hi2;
-#else
-#if (SBC_IPAQ_OPT == TRUE)
-#if (SBC_IS_64_MULT_IN_WINDOW_ACCU == TRUE)
-  register int64_t s64Temp, s64Temp2;
-#else
-  register int32_t s32Temp, s32Temp2;
-#endif
-#else
-#if (SBC_IS_64_MULT_IN_WINDOW_ACCU == TRUE)
-  int64_t s64Temp;
-#endif
-#endif
-#endif
 
   s32NumOfChannels = pstrEncParams->s16NumOfChannels;
   s32NumOfBlocks = pstrEncParams->s16NumOfBlocks;
 
   ps16PcmBuf = input;
 
-  ps32SbBuf = pstrEncParams->s32SbBuffer;
+  ps32DCTY = as32DCTY;
   Offset2 = (int32_t)(EncMaxShiftCounter + 80);
   for (s32Blk = 0; s32Blk < s32NumOfBlocks; s32Blk++) {
     Offset = (int32_t)(EncMaxShiftCounter - ShiftCounter);
@@ -1370,11 +1449,8 @@ void SbcAnalysisFilter8(SBC_ENC_PARAMS* pstrEncParams, int16_t* input) {
     for (s32Ch = 0; s32Ch < s32NumOfChannels; s32Ch++) {
       ChOffset = s32Ch * Offset2 + Offset;
 
-      WINDOW_PARTIAL_8
-
-      SBC_FastIDCT8(s32DCTY, ps32SbBuf);
-
-      ps32SbBuf += SUB_BANDS_8;
+      gstrEncDsp.Window8(s16X + ChOffset, ps32DCTY);
+      ps32DCTY += SUB_BANDS_8 * 2;
     }
     if (s32NumOfChannels == 1) {
       if (ShiftCounter >= EncMaxShiftCounter) {
@@ -1392,6 +1468,9 @@ void SbcAnalysisFilter8(SBC_ENC_PARAMS* pstrEncParams, int16_t* input) {
       }
     }
   }
+
+  gstrEncDsp.Idct8(as32DCTY, s32NumOfBlocks * s32NumOfChannels,
+                   pstrEncParams->s32SbBuffer);
 }
 
 void SbcAnalysisInit(void) {
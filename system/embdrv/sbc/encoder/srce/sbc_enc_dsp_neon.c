@@ -0,0 +1,351 @@
+/******************************************************************************
+ *
+ *  Copyright 2023 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+/******************************************************************************
+ *
+ *  NEON versions of the windowing, DCT, scale factor and quantizer
+ *  computations, bit exact with the portable versions. NEON is mandatory
+ *  on ARMv8, and on the ARMv7 Android ABI, the functions are selected at
+ *  build time.
+ *
+ ******************************************************************************/
+
+#include "sbc_dct.h"
+#include "sbc_enc_func_declare.h"
+#include "sbc_encoder.h"
+
+#if (SBC_VECTOR_NEON == TRUE)
+
+#include <arm_neon.h>
+
+/****************************************************************************
+ * Helpers
+ */
+
+/* Transpose the 4x4 matrix of 32 bits values in a, b, c and d */
+static inline void NeonTranspose(int32x4_t* a, int32x4_t* b, int32x4_t* c,
+                                 int32x4_t* d) {
+  int32x4x2_t ab = vtrnq_s32(*a, *b), cd = vtrnq_s32(*c, *d);
+
+  *a = vcombine_s32(vget_low_s32(ab.val[0]), vget_low_s32(cd.val[0]));
+  *b = vcombine_s32(vget_low_s32(ab.val[1]), vget_low_s32(cd.val[1]));
+  *c = vcombine_s32(vget_high_s32(ab.val[0]), vget_high_s32(cd.val[0]));
+  *d = vcombine_s32(vget_high_s32(ab.val[1]), vget_high_s32(cd.val[1]));
+}
+
+/* Return (int32_t)(((int64_t)c * x) >> 15) */
+static inline int32x4_t NeonIdctMult(int16_t c, int32x4_t x) {
+  const int32x2_t vc = vdup_n_s32(c);
+
+  return vcombine_s32(vshrn_n_s64(vmull_s32(vget_low_s32(x), vc), 15),
+                      vshrn_n_s64(vmull_s32(vget_high_s32(x), vc), 15));
+}
+
+/****************************************************************************
+ * Windowing, the accumulation wraps on 32 bits as the scalar one does
+ */
+
+static void SbcWindow4Neon(const int16_t* ps16X, int32_t* ps32Y) {
+  int32x4_t y0 = vdupq_n_s32(0), y1 = vdupq_n_s32(0);
+
+  for (int k = 0; k < 5; k++) {
+    int16x8_t x = vld1q_s16(ps16X + 8 * k);
+    int16x8_t c = vld1q_s16(gas16WindowFor4SBs + 8 * k);
+
+    y0 = vmlal_s16(y0, vget_low_s16(x), vget_low_s16(c));
+    y1 = vmlal_s16(y1, vget_high_s16(x), vget_high_s16(c));
+  }
+
+  vst1q_s32(ps32Y + 0, y0);
+  vst1q_s32(ps32Y + 4, y1);
+}
+
+static void SbcWindow8Neon(const int16_t* ps16X, int32_t* ps32Y) {
+  int32x4_t y0 = vdupq_n_s32(0), y1 = vdupq_n_s32(0);
+  int32x4_t y2 = vdupq_n_s32(0), y3 = vdupq_n_s32(0);
+
+  for (int k = 0; k < 5; k++) {
+    int16x8_t x0 = vld1q_s16(ps16X + 16 * k + 0);
+    int16x8_t c0 = vld1q_s16(gas16WindowFor8SBs + 16 * k + 0);
+    int16x8_t x1 = vld1q_s16(ps16X + 16 * k + 8);
+    int16x8_t c1 = vld1q_s16(gas16WindowFor8SBs + 16 * k + 8);
+
+    y0 = vmlal_s16(y0, vget_low_s16(x0), vget_low_s16(c0));
+    y1 = vmlal_s16(y1, vget_high_s16(x0), vget_high_s16(c0));
+    y2 = vmlal_s16(y2, vget_low_s16(x1), vget_low_s16(c1));
+    y3 = vmlal_s16(y3, vget_high_s16(x1), vget_high_s16(c1));
+  }
+
+  vst1q_s32(ps32Y + 0, y0);
+  vst1q_s32(ps32Y + 4, y1);
+  vst1q_s32(ps32Y + 8, y2);
+  vst1q_s32(ps32Y + 12, y3);
+}
+
+/****************************************************************************
+ * DCT, of 4 blocks at once
+ */
+
+/* Fast DCT of 4 blocks, as SBC_FastIDCT4(), x[k] holds the windowed
+ * sample k of the blocks */
+static inline void NeonFastIdct4(const int32x4_t* x, int32x4_t* y) {
+  int32x4_t x2, temp, tmp[8];
+
+  x2 = vshrq_n_s32(x[2], 1);
+  temp = vaddq_s32(x[0], x[4]);
+  tmp[0] = NeonIdctMult(SBC_COS_PI_SUR_4 >> 1, temp);
+  tmp[1] = vsubq_s32(x2, tmp[0]);
+  tmp[0] = vaddq_s32(tmp[0], x2);
+  temp = vaddq_s32(x[1], x[3]);
+  tmp[3] = NeonIdctMult(SBC_COS_3PI_SUR_8 >> 1, temp);
+  tmp[2] = NeonIdctMult(SBC_COS_PI_SUR_8 >> 1, temp);
+  temp = vsubq_s32(x[5], x[7]);
+  tmp[5] = NeonIdctMult(SBC_COS_3PI_SUR_8 >> 1, temp);
+  tmp[4] = NeonIdctMult(SBC_COS_PI_SUR_8 >> 1, temp);
+  tmp[6] = vaddq_s32(tmp[2], tmp[5]);
+  tmp[7] = vsubq_s32(tmp[3], tmp[4]);
+
+  y[0] = vaddq_s32(tmp[0], tmp[6]);
+  y[1] = vaddq_s32(tmp[1], tmp[7]);
+  y[2] = vsubq_s32(tmp[1], tmp[7]);
+  y[3] = vsubq_s32(tmp[0], tmp[6]);
+}
+
+/* Fast DCT of 4 blocks, as SBC_FastIDCT8(), x[k] holds the windowed
+ * sample k of the blocks */
+static inline void NeonFastIdct8(const int32x4_t* x, int32x4_t* y) {
+  int32x4_t x0, x1, x2, x3, x4, x5, x6, x7, temp;
+  int32x4_t res_even[4], res_odd[4];
+
+  x0 = NeonIdctMult(SBC_COS_PI_SUR_4, x[4]);
+  x1 = vshrq_n_s32(vaddq_s32(x[3], x[5]), 1);
+  x2 = vshrq_n_s32(vaddq_s32(x[2], x[6]), 1);
+  x3 = vshrq_n_s32(vaddq_s32(x[1], x[7]), 1);
+  x4 = vshrq_n_s32(vaddq_s32(x[0], x[8]), 1);
+  x5 = vshrq_n_s32(vsubq_s32(x[9], x[15]), 1);
+  x6 = vshrq_n_s32(vsubq_s32(x[10], x[14]), 1);
+  x7 = vshrq_n_s32(vsubq_s32(x[11], x[13]), 1);
+
+  /* 2-point IDCT of x0 and x4 */
+  temp = x0;
+  x0 = NeonIdctMult(SBC_COS_PI_SUR_4, vaddq_s32(x0, x4));
+  x4 = NeonIdctMult(SBC_COS_PI_SUR_4, vsubq_s32(temp, x4));
+
+  /* rearrangement and 2-point IDCT of x2 and x6 */
+  x2 = vsubq_s32(x2, x6);
+  x6 = NeonIdctMult(SBC_COS_PI_SUR_4, vshlq_n_s32(x6, 1));
+  temp = x2;
+  x2 = NeonIdctMult(SBC_COS_PI_SUR_8, vaddq_s32(x2, x6));
+  x6 = NeonIdctMult(SBC_COS_3PI_SUR_8, vsubq_s32(temp, x6));
+
+  /* 4-point IDCT of x0, x2, x4 and x6 */
+  res_even[0] = vaddq_s32(x0, x2);
+  res_even[1] = vaddq_s32(x4, x6);
+  res_even[2] = vsubq_s32(x4, x6);
+  res_even[3] = vsubq_s32(x0, x2);
+
+  /* rearrangement of x1, x3, x5 and x7 */
+  x7 = vshlq_n_s32(x7, 1);
+  x5 = vsubq_s32(vshlq_n_s32(x5, 1), x7);
+  x3 = vsubq_s32(vshlq_n_s32(x3, 1), x5);
+  x1 = vsubq_s32(x1, vshrq_n_s32(x3, 1));
+
+  /* two-dimensional IDCT of x1 and x5 */
+  x5 = NeonIdctMult(SBC_COS_PI_SUR_4, x5);
+  temp = x1;
+  x1 = vaddq_s32(x1, x5);
+  x5 = vsubq_s32(temp, x5);
+
+  /* rearrangement and 2-point IDCT of x3 and x7 */
+  x3 = vsubq_s32(x3, x7);
+  x7 = NeonIdctMult(SBC_COS_PI_SUR_4, vshlq_n_s32(x7, 1));
+  temp = x3;
+  x3 = NeonIdctMult(SBC_COS_PI_SUR_8, vaddq_s32(x3, x7));
+  x7 = NeonIdctMult(SBC_COS_3PI_SUR_8, vsubq_s32(temp, x7));
+
+  /* 4-point IDCT of x1, x3, x5 and x7, and post multiplication */
+  res_odd[0] = NeonIdctMult(SBC_COS_PI_SUR_16, vaddq_s32(x1, x3));
+  res_odd[1] = NeonIdctMult(SBC_COS_3PI_SUR_16, vaddq_s32(x5, x7));
+  res_odd[2] = NeonIdctMult(SBC_COS_5PI_SUR_16, vsubq_s32(x5, x7));
+  res_odd[3] = NeonIdctMult(SBC_COS_7PI_SUR_16, vsubq_s32(x1, x3));
+
+  y[0] = vaddq_s32(res_even[0], res_odd[0]);
+  y[1] = vaddq_s32(res_even[1], res_odd[1]);
+  y[2] = vaddq_s32(res_even[2], res_odd[2]);
+  y[3] = vaddq_s32(res_even[3], res_odd[3]);
+  y[7] = vsubq_s32(res_even[0], res_odd[0]);
+  y[6] = vsubq_s32(res_even[1], res_odd[1]);
+  y[5] = vsubq_s32(res_even[2], res_odd[2]);
+  y[4] = vsubq_s32(res_even[3], res_odd[3]);
+}
+
+static void SbcIdct4Neon(const int32_t* ps32Y, int32_t s32NumOfRows,
+                         int32_t* ps32Sb) {
+  for (; s32NumOfRows >= 4; s32NumOfRows -= 4) {
+    int32x4_t x[8], y[4];
+
+    for (int k = 0; k < 8; k += 4) {
+      for (int i = 0; i < 4; i++) x[k + i] = vld1q_s32(ps32Y + 8 * i + k);
+      NeonTranspose(&x[k + 0], &x[k + 1], &x[k + 2], &x[k + 3]);
+    }
+
+    NeonFastIdct4(x, y);
+
+    NeonTranspose(&y[0], &y[1], &y[2], &y[3]);
+    for (int i = 0; i < 4; i++) vst1q_s32(ps32Sb + 4 * i, y[i]);
+
+    ps32Y += 4 * 8;
+    ps32Sb += 4 * 4;
+  }
+
+  SbcIdct4(ps32Y, s32NumOfRows, ps32Sb);
+}
+
+static void SbcIdct8Neon(const int32_t* ps32Y, int32_t s32NumOfRows,
+                         int32_t* ps32Sb) {
+  for (; s32NumOfRows >= 4; s32NumOfRows -= 4) {
+    int32x4_t x[16], y[8];
+
+    for (int k = 0; k < 16; k += 4) {
+      for (int i = 0; i < 4; i++) x[k + i] = vld1q_s32(ps32Y + 16 * i + k);
+      NeonTranspose(&x[k + 0], &x[k + 1], &x[k + 2], &x[k + 3]);
+    }
+
+    NeonFastIdct8(x, y);
+
+    NeonTranspose(&y[0], &y[1], &y[2], &y[3]);
+    NeonTranspose(&y[4], &y[5], &y[6], &y[7]);
+    for (int i = 0; i < 4; i++) {
+      vst1q_s32(ps32Sb + 8 * i + 0, y[i]);
+      vst1q_s32(ps32Sb + 8 * i + 4, y[4 + i]);
+    }
+
+    ps32Y += 4 * 16;
+    ps32Sb += 4 * 8;
+  }
+
+  SbcIdct8(ps32Y, s32NumOfRows, ps32Sb);
+}
+
+/****************************************************************************
+ * Scale factors, the number of columns is a multiple of 4
+ */
+
+static void SbcMaxAbsNeon(const int32_t* ps32Sb, int32_t s32NumOfCols,
+                          int32_t s32NumOfBlocks, int32_t* ps32Max) {
+  for (int32_t s32Col = 0; s32Col < s32NumOfCols; s32Col += 4) {
+    const int32_t* ps32SbCol = ps32Sb + s32Col;
+    int32x4_t m = vdupq_n_s32(0);
+
+    for (int32_t s32Blk = 0; s32Blk < s32NumOfBlocks; s32Blk++) {
+      m = vmaxq_s32(m, vabsq_s32(vld1q_s32(ps32SbCol)));
+      ps32SbCol += s32NumOfCols;
+    }
+
+    vst1q_s32(ps32Max + s32Col, m);
+  }
+}
+
+static void SbcMaxAbsJointNeon(const int32_t* ps32Sb, int32_t s32NumOfSubBands,
+                               int32_t s32NumOfBlocks, int32_t* ps32MaxSum,
+                               int32_t* ps32MaxDiff) {
+  for (int32_t s32Sb = 0; s32Sb < s32NumOfSubBands; s32Sb += 4) {
+    const int32_t* ps32SbCol = ps32Sb + s32Sb;
+    int32x4_t ms = vdupq_n_s32(0), md = vdupq_n_s32(0);
+
+    for (int32_t s32Blk = 0; s32Blk < s32NumOfBlocks; s32Blk++) {
+      int32x4_t l = vld1q_s32(ps32SbCol);
+      int32x4_t r = vld1q_s32(ps32SbCol + s32NumOfSubBands);
+
+      ms = vmaxq_s32(ms, vabsq_s32(vshrq_n_s32(vaddq_s32(l, r), 1)));
+      md = vmaxq_s32(md, vabsq_s32(vshrq_n_s32(vsubq_s32(l, r), 1)));
+      ps32SbCol += s32NumOfSubBands << 1;
+    }
+
+    vst1q_s32(ps32MaxSum + s32Sb, ms);
+    vst1q_s32(ps32MaxDiff + s32Sb, md);
+  }
+}
+
+/****************************************************************************
+ * Quantizer, the number of columns is a multiple of 4
+ *
+ * Keeps the bits [sf + 14, sf + 29] of the 64 bits product of
+ * ((sb >> 2) + 2^(sf + 13)) by the levels, for a scale factor sf.
+ */
+
+static void SbcQuantizeNeon(const int32_t* ps32Sb, int32_t s32NumOfCols,
+                            int32_t s32NumOfBlocks,
+                            const int16_t* ps16ScaleFactor,
+                            const int16_t* ps16Bits, uint16_t* pu16Quantized) {
+  for (int32_t s32Col = 0; s32Col < s32NumOfCols; s32Col += 4) {
+    int32_t as32Offset[4], as32Levels[4];
+    int64_t as64Shift[4];
+    int32_t s32Bits = 0;
+
+    for (int i = 0; i < 4; i++) {
+      int32_t s32Sf = ps16ScaleFactor[s32Col + i];
+      int32_t s32LoopCount = ps16Bits[s32Col + i];
+
+      as32Offset[i] = (int32_t)((uint32_t)1 << (s32Sf + 13));
+      as32Levels[i] = (uint16_t)(((uint32_t)1 << s32LoopCount) - 1);
+      as64Shift[i] = -(s32Sf + 14);
+      s32Bits |= s32LoopCount;
+    }
+
+    if (s32Bits == 0) continue;
+
+    const int32x4_t offset = vld1q_s32(as32Offset);
+    const int32x4_t levels = vld1q_s32(as32Levels);
+    const int64x2_t shift_lo = vld1q_s64(as64Shift + 0);
+    const int64x2_t shift_hi = vld1q_s64(as64Shift + 2);
+
+    const int32_t* ps32SbCol = ps32Sb + s32Col;
+    uint16_t* pu16QuantizedCol = pu16Quantized + s32Col;
+
+    for (int32_t s32Blk = 0; s32Blk < s32NumOfBlocks; s32Blk++) {
+      int32x4_t t = vaddq_s32(vshrq_n_s32(vld1q_s32(ps32SbCol), 2), offset);
+
+      int64x2_t p_lo = vmull_s32(vget_low_s32(t), vget_low_s32(levels));
+      int64x2_t p_hi = vmull_s32(vget_high_s32(t), vget_high_s32(levels));
+
+      int32x4_t q = vcombine_s32(vmovn_s64(vshlq_s64(p_lo, shift_lo)),
+                                 vmovn_s64(vshlq_s64(p_hi, shift_hi)));
+      vst1_u16(pu16QuantizedCol, vreinterpret_u16_s16(vmovn_s32(q)));
+
+      ps32SbCol += s32NumOfCols;
+      pu16QuantizedCol += s32NumOfCols;
+    }
+  }
+}
+
+/****************************************************************************
+ * Selection of the functions
+ */
+
+void SbcEncDspInitNeon(SBC_ENC_DSP* pstrDsp) {
+  pstrDsp->Window4 = SbcWindow4Neon;
+  pstrDsp->Window8 = SbcWindow8Neon;
+  pstrDsp->Idct4 = SbcIdct4Neon;
+  pstrDsp->Idct8 = SbcIdct8Neon;
+  pstrDsp->MaxAbs = SbcMaxAbsNeon;
+  pstrDsp->MaxAbsJoint = SbcMaxAbsJointNeon;
+  pstrDsp->Quantize = SbcQuantizeNeon;
+}
+
+#endif /* SBC_VECTOR_NEON */
@@ -0,0 +1,624 @@
+/******************************************************************************
+ *
+ *  Copyright 2023 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+/******************************************************************************
+ *
+ *  SSE2 and AVX2 versions of the windowing, DCT, scale factor and quantizer
+ *  computations. The results are bit exact with the portable versions: the
+ *  32 bits arithmetic wraps as the scalar one does, and 64 bits products
+ *  are kept where the scalar code uses them.
+ *
+ *  SSE2 is part of the x86-64 baseline and of the Android x86 ABI, AVX2 is
+ *  selected at run time.
+ *
+ ******************************************************************************/
+
+#include "sbc_dct.h"
+#include "sbc_enc_func_declare.h"
+#include "sbc_encoder.h"
+
+#if (SBC_VECTOR_X86 == TRUE)
+
+#include <immintrin.h>
+
+/****************************************************************************
+ * SSE2 helpers
+ */
+
+/* Transpose the 4x4 matrix of 32 bits values in a, b, c and d */
+static inline void Sse2Transpose(__m128i* a, __m128i* b, __m128i* c,
+                                 __m128i* d) {
+  __m128i t0 = _mm_unpacklo_epi32(*a, *b), t1 = _mm_unpacklo_epi32(*c, *d);
+  __m128i t2 = _mm_unpackhi_epi32(*a, *b), t3 = _mm_unpackhi_epi32(*c, *d);
+
+  *a = _mm_unpacklo_epi64(t0, t1);
+  *b = _mm_unpackhi_epi64(t0, t1);
+  *c = _mm_unpacklo_epi64(t2, t3);
+  *d = _mm_unpackhi_epi64(t2, t3);
+}
+
+static inline __m128i Sse2Abs(__m128i v) {
+  __m128i s = _mm_srai_epi32(v, 31);
+  return _mm_sub_epi32(_mm_xor_si128(v, s), s);
+}
+
+static inline __m128i Sse2Max(__m128i a, __m128i b) {
+  __m128i m = _mm_cmpgt_epi32(a, b);
+  return _mm_or_si128(_mm_and_si128(m, a), _mm_andnot_si128(m, b));
+}
+
+/* Return (int32_t)(((int64_t)c * x) >> 15), for 0 <= c < 2^15
+ * With x = xh * 2^16 + xl, this is 2 * c * xh + ((c * xl) >> 15) */
+static inline __m128i Sse2IdctMult(int16_t c, __m128i x) {
+  const __m128i cl = _mm_set1_epi32(c);
+  const __m128i ch = _mm_set1_epi32((int32_t)c << 16);
+
+  __m128i h = _mm_madd_epi16(x, ch);
+  __m128i l = _mm_or_si128(_mm_mullo_epi16(x, cl),
+                           _mm_slli_epi32(_mm_mulhi_epu16(x, cl), 16));
+
+  return _mm_add_epi32(_mm_slli_epi32(h, 1), _mm_srli_epi32(l, 15));
+}
+
+/****************************************************************************
+ * SSE2 windowing
+ */
+
+static void SbcWindow4Sse2(const int16_t* ps16X, int32_t* ps32Y) {
+  __m128i y0 = _mm_setzero_si128(), y1 = _mm_setzero_si128();
+
+  for (int k = 0; k < 5; k++) {
+    __m128i x = _mm_loadu_si128((const __m128i*)(ps16X + 8 * k));
+    __m128i c = _mm_loadu_si128((const __m128i*)(gas16WindowFor4SBs + 8 * k));
+    __m128i lo = _mm_mullo_epi16(x, c), hi = _mm_mulhi_epi16(x, c);
+
+    y0 = _mm_add_epi32(y0, _mm_unpacklo_epi16(lo, hi));
+    y1 = _mm_add_epi32(y1, _mm_unpackhi_epi16(lo, hi));
+  }
+
+  _mm_storeu_si128((__m128i*)(ps32Y + 0), y0);
+  _mm_storeu_si128((__m128i*)(ps32Y + 4), y1);
+}
+
+static void SbcWindow8Sse2(const int16_t* ps16X, int32_t* ps32Y) {
+  __m128i y0 = _mm_setzero_si128(), y1 = _mm_setzero_si128();
+  __m128i y2 = _mm_setzero_si128(), y3 = _mm_setzero_si128();
+
+  for (int k = 0; k < 5; k++) {
+    const int16_t* x = ps16X + 16 * k;
+    const int16_t* c = gas16WindowFor8SBs + 16 * k;
+
+    __m128i x0 = _mm_loadu_si128((const __m128i*)(x + 0));
+    __m128i c0 = _mm_loadu_si128((const __m128i*)(c + 0));
+    __m128i lo0 = _mm_mullo_epi16(x0, c0), hi0 = _mm_mulhi_epi16(x0, c0);
+    y0 = _mm_add_epi32(y0, _mm_unpacklo_epi16(lo0, hi0));
+    y1 = _mm_add_epi32(y1, _mm_unpackhi_epi16(lo0, hi0));
+
+    __m128i x1 = _mm_loadu_si128((const __m128i*)(x + 8));
+    __m128i c1 = _mm_loadu_si128((const __m128i*)(c + 8));
+    __m128i lo1 = _mm_mullo_epi16(x1, c1), hi1 = _mm_mulhi_epi16(x1, c1);
+    y2 = _mm_add_epi32(y2, _mm_unpacklo_epi16(lo1, hi1));
+    y3 = _mm_add_epi32(y3, _mm_unpackhi_epi16(lo1, hi1));
+  }
+
+  _mm_storeu_si128((__m128i*)(ps32Y + 0), y0);
+  _mm_storeu_si128((__m128i*)(ps32Y + 4), y1);
+  _mm_storeu_si128((__m128i*)(ps32Y + 8), y2);
+  _mm_storeu_si128((__m128i*)(ps32Y + 12), y3);
+}
+
+/****************************************************************************
+ * SSE2 DCT, of 4 blocks at once
+ */
+
+/* Fast DCT of 4 blocks, as SBC_FastIDCT4(), x[k] holds the windowed
+ * sample k of the blocks */
+static inline void Sse2FastIdct4(const __m128i* x, __m128i* y) {
+  __m128i x2, temp, tmp[8];
+
+  x2 = _mm_srai_epi32(x[2], 1);
+  temp = _mm_add_epi32(x[0], x[4]);
+  tmp[0] = Sse2IdctMult(SBC_COS_PI_SUR_4 >> 1, temp);
+  tmp[1] = _mm_sub_epi32(x2, tmp[0]);
+  tmp[0] = _mm_add_epi32(tmp[0], x2);
+  temp = _mm_add_epi32(x[1], x[3]);
+  tmp[3] = Sse2IdctMult(SBC_COS_3PI_SUR_8 >> 1, temp);
+  tmp[2] = Sse2IdctMult(SBC_COS_PI_SUR_8 >> 1, temp);
+  temp = _mm_sub_epi32(x[5], x[7]);
+  tmp[5] = Sse2IdctMult(SBC_COS_3PI_SUR_8 >> 1, temp);
+  tmp[4] = Sse2IdctMult(SBC_COS_PI_SUR_8 >> 1, temp);
+  tmp[6] = _mm_add_epi32(tmp[2], tmp[5]);
+  tmp[7] = _mm_sub_epi32(tmp[3], tmp[4]);
+
+  y[0] = _mm_add_epi32(tmp[0], tmp[6]);
+  y[1] = _mm_add_epi32(tmp[1], tmp[7]);
+  y[2] = _mm_sub_epi32(tmp[1], tmp[7]);
+  y[3] = _mm_sub_epi32(tmp[0], tmp[6]);
+}
+
+/* Fast DCT of 4 blocks, as SBC_FastIDCT8(), x[k] holds the windowed
+ * sample k of the blocks */
+static inline void Sse2FastIdct8(const __m128i* x, __m128i* y) {
+  __m128i x0, x1, x2, x3, x4, x5, x6, x7, temp;
+  __m128i res_even[4], res_odd[4];
+
+  x0 = Sse2IdctMult(SBC_COS_PI_SUR_4, x[4]);
+  x1 = _mm_srai_epi32(_mm_add_epi32(x[3], x[5]), 1);
+  x2 = _mm_srai_epi32(_mm_add_epi32(x[2], x[6]), 1);
+  x3 = _mm_srai_epi32(_mm_add_epi32(x[1], x[7]), 1);
+  x4 = _mm_srai_epi32(_mm_add_epi32(x[0], x[8]), 1);
+  x5 = _mm_srai_epi32(_mm_sub_epi32(x[9], x[15]), 1);
+  x6 = _mm_srai_epi32(_mm_sub_epi32(x[10], x[14]), 1);
+  x7 = _mm_srai_epi32(_mm_sub_epi32(x[11], x[13]), 1);
+
+  /* 2-point IDCT of x0 and x4 */
+  temp = x0;
+  x0 = Sse2IdctMult(SBC_COS_PI_SUR_4, _mm_add_epi32(x0, x4));
+  x4 = Sse2IdctMult(SBC_COS_PI_SUR_4, _mm_sub_epi32(temp, x4));
+
+  /* rearrangement and 2-point IDCT of x2 and x6 */
+  x2 = _mm_sub_epi32(x2, x6);
+  x6 = Sse2IdctMult(SBC_COS_PI_SUR_4, _mm_slli_epi32(x6, 1));
+  temp = x2;
+  x2 = Sse2IdctMult(SBC_COS_PI_SUR_8, _mm_add_epi32(x2, x6));
+  x6 = Sse2IdctMult(SBC_COS_3PI_SUR_8, _mm_sub_epi32(temp, x6));
+
+  /* 4-point IDCT of x0, x2, x4 and x6 */
+  res_even[0] = _mm_add_epi32(x0, x2);
+  res_even[1] = _mm_add_epi32(x4, x6);
+  res_even[2] = _mm_sub_epi32(x4, x6);
+  res_even[3] = _mm_sub_epi32(x0, x2);
+
+  /* rearrangement of x1, x3, x5 and x7 */
+  x7 = _mm_slli_epi32(x7, 1);
+  x5 = _mm_sub_epi32(_mm_slli_epi32(x5, 1), x7);
+  x3 = _mm_sub_epi32(_mm_slli_epi32(x3, 1), x5);
+  x1 = _mm_sub_epi32(x1, _mm_srai_epi32(x3, 1));
+
+  /* two-dimensional IDCT of x1 and x5 */
+  x5 = Sse2IdctMult(SBC_COS_PI_SUR_4, x5);
+  temp = x1;
+  x1 = _mm_add_epi32(x1, x5);
+  x5 = _mm_sub_epi32(temp, x5);
+
+  /* rearrangement and 2-point IDCT of x3 and x7 */
+  x3 = _mm_sub_epi32(x3, x7);
+  x7 = Sse2IdctMult(SBC_COS_PI_SUR_4, _mm_slli_epi32(x7, 1));
+  temp = x3;
+  x3 = Sse2IdctMult(SBC_COS_PI_SUR_8, _mm_add_epi32(x3, x7));
+  x7 = Sse2IdctMult(SBC_COS_3PI_SUR_8, _mm_sub_epi32(temp, x7));
+
+  /* 4-point IDCT of x1, x3, x5 and x7, and post multiplication */
+  res_odd[0] = Sse2IdctMult(SBC_COS_PI_SUR_16, _mm_add_epi32(x1, x3));
+  res_odd[1] = Sse2IdctMult(SBC_COS_3PI_SUR_16, _mm_add_epi32(x5, x7));
+  res_odd[2] = Sse2IdctMult(SBC_COS_5PI_SUR_16, _mm_sub_epi32(x5, x7));
+  res_odd[3] = Sse2IdctMult(SBC_COS_7PI_SUR_16, _mm_sub_epi32(x1, x3));
+
+  y[0] = _mm_add_epi32(res_even[0], res_odd[0]);
+  y[1] = _mm_add_epi32(res_even[1], res_odd[1]);
+  y[2] = _mm_add_epi32(res_even[2], res_odd[2]);
+  y[3] = _mm_add_epi32(res_even[3], res_odd[3]);
+  y[7] = _mm_sub_epi32(res_even[0], res_odd[0]);
+  y[6] = _mm_sub_epi32(res_even[1], res_odd[1]);
+  y[5] = _mm_sub_epi32(res_even[2], res_odd[2]);
+  y[4] = _mm_sub_epi32(res_even[3], res_odd[3]);
+}
+
+static void SbcIdct4Sse2(const int32_t* ps32Y, int32_t s32NumOfRows,
+                         int32_t* ps32Sb) {
+  for (; s32NumOfRows >= 4; s32NumOfRows -= 4) {
+    __m128i x[8], y[4];
+
+    for (int k = 0; k < 8; k += 4) {
+      for (int i = 0; i < 4; i++)
+        x[k + i] = _mm_loadu_si128((const __m128i*)(ps32Y + 8 * i + k));
+      Sse2Transpose(&x[k + 0], &x[k + 1], &x[k + 2], &x[k + 3]);
+    }
+
+    Sse2FastIdct4(x, y);
+
+    Sse2Transpose(&y[0], &y[1], &y[2], &y[3]);
+    for (int i = 0; i < 4; i++)
+      _mm_storeu_si128((__m128i*)(ps32Sb + 4 * i), y[i]);
+
+    ps32Y += 4 * 8;
+    ps32Sb += 4 * 4;
+  }
+
+  SbcIdct4(ps32Y, s32NumOfRows, ps32Sb);
+}
+
+static void SbcIdct8Sse2(const int32_t* ps32Y, int32_t s32NumOfRows,
+                         int32_t* ps32Sb) {
+  for (; s32NumOfRows >= 4; s32NumOfRows -= 4) {
+    __m128i x[16], y[8];
+
+    for (int k = 0; k < 16; k += 4) {
+      for (int i = 0; i < 4; i++)
+        x[k + i] = _mm_loadu_si128((const __m128i*)(ps32Y + 16 * i + k));
+      Sse2Transpose(&x[k + 0], &x[k + 1], &x[k + 2], &x[k + 3]);
+    }
+
+    Sse2FastIdct8(x, y);
+
+    Sse2Transpose(&y[0], &y[1], &y[2], &y[3]);
+    Sse2Transpose(&y[4], &y[5], &y[6], &y[7]);
+    for (int i = 0; i < 4; i++) {
+      _mm_storeu_si128((__m128i*)(ps32Sb + 8 * i + 0), y[i]);
+      _mm_storeu_si128((__m128i*)(ps32Sb + 8 * i + 4), y[4 + i]);
+    }
+
+    ps32Y += 4 * 16;
+    ps32Sb += 4 * 8;
+  }
+
+  SbcIdct8(ps32Y, s32NumOfRows, ps32Sb);
+}
+
+/****************************************************************************
+ * SSE2 scale factors, the number of columns is a multiple of 4
+ */
+
+static void SbcMaxAbsSse2(const int32_t* ps32Sb, int32_t s32NumOfCols,
+                          int32_t s32NumOfBlocks, int32_t* ps32Max) {
+  for (int32_t s32Col = 0; s32Col < s32NumOfCols; s32Col += 4) {
+    const int32_t* ps32SbCol = ps32Sb + s32Col;
+    __m128i m = _mm_setzero_si128();
+
+    for (int32_t s32Blk = 0; s32Blk < s32NumOfBlocks; s32Blk++) {
+      m = Sse2Max(m, Sse2Abs(_mm_loadu_si128((const __m128i*)ps32SbCol)));
+      ps32SbCol += s32NumOfCols;
+    }
+
+    _mm_storeu_si128((__m128i*)(ps32Max + s32Col), m);
+  }
+}
+
+static void SbcMaxAbsJointSse2(const int32_t* ps32Sb, int32_t s32NumOfSubBands,
+                               int32_t s32NumOfBlocks, int32_t* ps32MaxSum,
+                               int32_t* ps32MaxDiff) {
+  for (int32_t s32Sb = 0; s32Sb < s32NumOfSubBands; s32Sb += 4) {
+    const int32_t* ps32SbCol = ps32Sb + s32Sb;
+    __m128i ms = _mm_setzero_si128(), md = _mm_setzero_si128();
+
+    for (int32_t s32Blk = 0; s32Blk < s32NumOfBlocks; s32Blk++) {
+      __m128i l = _mm_loadu_si128((const __m128i*)ps32SbCol);
+      __m128i r = _mm_loadu_si128((const __m128i*)(ps32SbCol + s32NumOfSubBands));
+
+      ms = Sse2Max(ms, Sse2Abs(_mm_srai_epi32(_mm_add_epi32(l, r), 1)));
+      md = Sse2Max(md, Sse2Abs(_mm_srai_epi32(_mm_sub_epi32(l, r), 1)));
+      ps32SbCol += s32NumOfSubBands << 1;
+    }
+
+    _mm_storeu_si128((__m128i*)(ps32MaxSum + s32Sb), ms);
+    _mm_storeu_si128((__m128i*)(ps32MaxDiff + s32Sb), md);
+  }
+}
+
+/****************************************************************************
+ * SSE2 quantizer, the number of columns is a multiple of 4
+ *
+ * The scalar quantizer keeps the bits [sf + 14, sf + 29] of the 64 bits
+ * product of ((sb >> 2) + 2^(sf + 13)) by the levels, for a scale factor sf.
+ * SSE2 has only an unsigned 32x32 bits multiplication, the product is
+ * corrected when the multiplicand is negative.
+ */
+
+static void SbcQuantizeSse2(const int32_t* ps32Sb, int32_t s32NumOfCols,
+                            int32_t s32NumOfBlocks,
+                            const int16_t* ps16ScaleFactor,
+                            const int16_t* ps16Bits, uint16_t* pu16Quantized) {
+  const __m128i mask_hi = _mm_set_epi32(-1, 0, -1, 0);
+
+  for (int32_t s32Col = 0; s32Col < s32NumOfCols; s32Col += 4) {
+    int32_t as32Offset[4], as32Levels[4];
+    __m128i shift[4];
+    int32_t s32Bits = 0;
+
+    for (int i = 0; i < 4; i++) {
+      int32_t s32Sf = ps16ScaleFactor[s32Col + i];
+      int32_t s32LoopCount = ps16Bits[s32Col + i];
+
+      as32Offset[i] = (int32_t)((uint32_t)1 << (s32Sf + 13));
+      as32Levels[i] = (uint16_t)(((uint32_t)1 << s32LoopCount) - 1);
+      shift[i] = _mm_cvtsi32_si128(s32Sf + 14);
+      s32Bits |= s32LoopCount;
+    }
+
+    if (s32Bits == 0) continue;
+
+    const __m128i offset = _mm_loadu_si128((const __m128i*)as32Offset);
+    const __m128i levels = _mm_loadu_si128((const __m128i*)as32Levels);
+    const __m128i levels_odd = _mm_srli_epi64(levels, 32);
+
+    const int32_t* ps32SbCol = ps32Sb + s32Col;
+    uint16_t* pu16QuantizedCol = pu16Quantized + s32Col;
+
+    for (int32_t s32Blk = 0; s32Blk < s32NumOfBlocks; s32Blk++) {
+      __m128i t = _mm_add_epi32(
+          _mm_srai_epi32(_mm_loadu_si128((const __m128i*)ps32SbCol), 2),
+          offset);
+      __m128i corr = _mm_and_si128(_mm_srai_epi32(t, 31), levels);
+
+      __m128i p02 = _mm_sub_epi64(_mm_mul_epu32(t, levels),
+                                  _mm_slli_epi64(corr, 32));
+      __m128i p13 =
+          _mm_sub_epi64(_mm_mul_epu32(_mm_srli_epi64(t, 32), levels_odd),
+                        _mm_and_si128(corr, mask_hi));
+
+      __m128i q02 = _mm_castpd_si128(
+          _mm_move_sd(_mm_castsi128_pd(_mm_srl_epi64(p02, shift[2])),
+                      _mm_castsi128_pd(_mm_srl_epi64(p02, shift[0]))));
+      __m128i q13 = _mm_castpd_si128(
+          _mm_move_sd(_mm_castsi128_pd(_mm_srl_epi64(p13, shift[3])),
+                      _mm_castsi128_pd(_mm_srl_epi64(p13, shift[1]))));
+
+      __m128i q = _mm_or_si128(_mm_andnot_si128(mask_hi, q02),
+                               _mm_slli_epi64(q13, 32));
+      q = _mm_srai_epi32(_mm_slli_epi32(q, 16), 16);
+      _mm_storel_epi64((__m128i*)pu16QuantizedCol, _mm_packs_epi32(q, q));
+
+      ps32SbCol += s32NumOfCols;
+      pu16QuantizedCol += s32NumOfCols;
+    }
+  }
+}
+
+/****************************************************************************
+ * AVX2 versions, of the 8 subbands windowing and DCT, and of the quantizer
+ */
+
+__attribute__((target("avx2"))) static inline void Avx2Transpose(__m256i* a,
+                                                                 __m256i* b,
+                                                                 __m256i* c,
+                                                                 __m256i* d) {
+  __m256i t0 = _mm256_unpacklo_epi32(*a, *b);
+  __m256i t1 = _mm256_unpacklo_epi32(*c, *d);
+  __m256i t2 = _mm256_unpackhi_epi32(*a, *b);
+  __m256i t3 = _mm256_unpackhi_epi32(*c, *d);
+
+  *a = _mm256_unpacklo_epi64(t0, t1);
+  *b = _mm256_unpackhi_epi64(t0, t1);
+  *c = _mm256_unpacklo_epi64(t2, t3);
+  *d = _mm256_unpackhi_epi64(t2, t3);
+}
+
+__attribute__((target("avx2"))) static inline __m256i Avx2IdctMult(
+    int16_t c, __m256i x) {
+  const __m256i cl = _mm256_set1_epi32(c);
+  const __m256i ch = _mm256_set1_epi32((int32_t)c << 16);
+
+  __m256i h = _mm256_madd_epi16(x, ch);
+  __m256i l = _mm256_or_si256(_mm256_mullo_epi16(x, cl),
+                              _mm256_slli_epi32(_mm256_mulhi_epu16(x, cl), 16));
+
+  return _mm256_add_epi32(_mm256_slli_epi32(h, 1), _mm256_srli_epi32(l, 15));
+}
+
+__attribute__((target("avx2"))) static void SbcWindow8Avx2(
+    const int16_t* ps16X, int32_t* ps32Y) {
+  __m256i y0 = _mm256_setzero_si256(), y1 = _mm256_setzero_si256();
+
+  for (int k = 0; k < 5; k++) {
+    __m256i x = _mm256_loadu_si256((const __m256i*)(ps16X + 16 * k));
+    __m256i c =
+        _mm256_loadu_si256((const __m256i*)(gas16WindowFor8SBs + 16 * k));
+    __m256i lo = _mm256_mullo_epi16(x, c), hi = _mm256_mulhi_epi16(x, c);
+
+    /* Samples 0 to 3 and 8 to 11, then 4 to 7 and 12 to 15 */
+    y0 = _mm256_add_epi32(y0, _mm256_unpacklo_epi16(lo, hi));
+    y1 = _mm256_add_epi32(y1, _mm256_unpackhi_epi16(lo, hi));
+  }
+
+  _mm256_storeu_si256((__m256i*)(ps32Y + 0),
+                      _mm256_permute2x128_si256(y0, y1, 0x20));
+  _mm256_storeu_si256((__m256i*)(ps32Y + 8),
+                      _mm256_permute2x128_si256(y0, y1, 0x31));
+}
+
+/* Fast DCT of 8 blocks, as Sse2FastIdct8() */
+__attribute__((target("avx2"))) static inline void Avx2FastIdct8(
+    const __m256i* x, __m256i* y) {
+  __m256i x0, x1, x2, x3, x4, x5, x6, x7, temp;
+  __m256i res_even[4], res_odd[4];
+
+  x0 = Avx2IdctMult(SBC_COS_PI_SUR_4, x[4]);
+  x1 = _mm256_srai_epi32(_mm256_add_epi32(x[3], x[5]), 1);
+  x2 = _mm256_srai_epi32(_mm256_add_epi32(x[2], x[6]), 1);
+  x3 = _mm256_srai_epi32(_mm256_add_epi32(x[1], x[7]), 1);
+  x4 = _mm256_srai_epi32(_mm256_add_epi32(x[0], x[8]), 1);
+  x5 = _mm256_srai_epi32(_mm256_sub_epi32(x[9], x[15]), 1);
+  x6 = _mm256_srai_epi32(_mm256_sub_epi32(x[10], x[14]), 1);
+  x7 = _mm256_srai_epi32(_mm256_sub_epi32(x[11], x[13]), 1);
+
+  temp = x0;
+  x0 = Avx2IdctMult(SBC_COS_PI_SUR_4, _mm256_add_epi32(x0, x4));
+  x4 = Avx2IdctMult(SBC_COS_PI_SUR_4, _mm256_sub_epi32(temp, x4));
+
+  x2 = _mm256_sub_epi32(x2, x6);
+  x6 = Avx2IdctMult(SBC_COS_PI_SUR_4, _mm256_slli_epi32(x6, 1));
+  temp = x2;
+  x2 = Avx2IdctMult(SBC_COS_PI_SUR_8, _mm256_add_epi32(x2, x6));
+  x6 = Avx2IdctMult(SBC_COS_3PI_SUR_8, _mm256_sub_epi32(temp, x6));
+
+  res_even[0] = _mm256_add_epi32(x0, x2);
+  res_even[1] = _mm256_add_epi32(x4, x6);
+  res_even[2] = _mm256_sub_epi32(x4, x6);
+  res_even[3] = _mm256_sub_epi32(x0, x2);
+
+  x7 = _mm256_slli_epi32(x7, 1);
+  x5 = _mm256_sub_epi32(_mm256_slli_epi32(x5, 1), x7);
+  x3 = _mm256_sub_epi32(_mm256_slli_epi32(x3, 1), x5);
+  x1 = _mm256_sub_epi32(x1, _mm256_srai_epi32(x3, 1));
+
+  x5 = Avx2IdctMult(SBC_COS_PI_SUR_4, x5);
+  temp = x1;
+  x1 = _mm256_add_epi32(x1, x5);
+  x5 = _mm256_sub_epi32(temp, x5);
+
+  x3 = _mm256_sub_epi32(x3, x7);
+  x7 = Avx2IdctMult(SBC_COS_PI_SUR_4, _mm256_slli_epi32(x7, 1));
+  temp = x3;
+  x3 = Avx2IdctMult(SBC_COS_PI_SUR_8, _mm256_add_epi32(x3, x7));
+  x7 = Avx2IdctMult(SBC_COS_3PI_SUR_8, _mm256_sub_epi32(temp, x7));
+
+  res_odd[0] = Avx2IdctMult(SBC_COS_PI_SUR_16, _mm256_add_epi32(x1, x3));
+  res_odd[1] = Avx2IdctMult(SBC_COS_3PI_SUR_16, _mm256_add_epi32(x5, x7));
+  res_odd[2] = Avx2IdctMult(SBC_COS_5PI_SUR_16, _mm256_sub_epi32(x5, x7));
+  res_odd[3] = Avx2IdctMult(SBC_COS_7PI_SUR_16, _mm256_sub_epi32(x1, x3));
+
+  y[0] = _mm256_add_epi32(res_even[0], res_odd[0]);
+  y[1] = _mm256_add_epi32(res_even[1], res_odd[1]);
+  y[2] = _mm256_add_epi32(res_even[2], res_odd[2]);
+  y[3] = _mm256_add_epi32(res_even[3], res_odd[3]);
+  y[7] = _mm256_sub_epi32(res_even[0], res_odd[0]);
+  y[6] = _mm256_sub_epi32(res_even[1], res_odd[1]);
+  y[5] = _mm256_sub_epi32(res_even[2], res_odd[2]);
+  y[4] = _mm256_sub_epi32(res_even[3], res_odd[3]);
+}
+
+/* The blocks 0 to 3 are processed in the low lanes, and the blocks 4 to 7
+ * in the high lanes */
+__attribute__((target("avx2"))) static void SbcIdct8Avx2(
+    const int32_t* ps32Y, int32_t s32NumOfRows, int32_t* ps32Sb) {
+  for (; s32NumOfRows >= 8; s32NumOfRows -= 8) {
+    __m256i x[16], y[8];
+
+    for (int k = 0; k < 16; k += 4) {
+      for (int i = 0; i < 4; i++)
+        x[k + i] = _mm256_inserti128_si256(
+            _mm256_castsi128_si256(
+                _mm_loadu_si128((const __m128i*)(ps32Y + 16 * i + k))),
+            _mm_loadu_si128((const __m128i*)(ps32Y + 16 * (4 + i) + k)), 1);
+      Avx2Transpose(&x[k + 0], &x[k + 1], &x[k + 2], &x[k + 3]);
+    }
+
+    Avx2FastIdct8(x, y);
+
+    Avx2Transpose(&y[0], &y[1], &y[2], &y[3]);
+    Avx2Transpose(&y[4], &y[5], &y[6], &y[7]);
+    for (int i = 0; i < 4; i++) {
+      _mm_storeu_si128((__m128i*)(ps32Sb + 8 * i + 0),
+                       _mm256_castsi256_si128(y[i]));
+      _mm_storeu_si128((__m128i*)(ps32Sb + 8 * i + 4),
+                       _mm256_castsi256_si128(y[4 + i]));
+      _mm_storeu_si128((__m128i*)(ps32Sb + 8 * (4 + i) + 0),
+                       _mm256_extracti128_si256(y[i], 1));
+      _mm_storeu_si128((__m128i*)(ps32Sb + 8 * (4 + i) + 4),
+                       _mm256_extracti128_si256(y[4 + i], 1));
+    }
+
+    ps32Y += 8 * 16;
+    ps32Sb += 8 * 8;
+  }
+
+  SbcIdct8Sse2(ps32Y, s32NumOfRows, ps32Sb);
+}
+
+/* AVX2 has a signed 32x32 bits multiplication and 64 bits shifts by lane,
+ * the columns are processed by 8, the remaining 4 with SSE2 */
+__attribute__((target("avx2"))) static void SbcQuantizeAvx2(
+    const int32_t* ps32Sb, int32_t s32NumOfCols, int32_t s32NumOfBlocks,
+    const int16_t* ps16ScaleFactor, const int16_t* ps16Bits,
+    uint16_t* pu16Quantized) {
+  int32_t s32Col;
+
+  for (s32Col = 0; s32Col + 8 <= s32NumOfCols; s32Col += 8) {
+    int32_t as32Offset[8], as32Levels[8];
+    int64_t as64Shift[8];
+    int32_t s32Bits = 0;
+
+    for (int i = 0; i < 8; i++) {
+      int32_t s32Sf = ps16ScaleFactor[s32Col + i];
+      int32_t s32LoopCount = ps16Bits[s32Col + i];
+
+      as32Offset[i] = (int32_t)((uint32_t)1 << (s32Sf + 13));
+      as32Levels[i] = (uint16_t)(((uint32_t)1 << s32LoopCount) - 1);
+      as64Shift[(i & 1) * 4 + (i >> 1)] = s32Sf + 14;
+      s32Bits |= s32LoopCount;
+    }
+
+    if (s32Bits == 0) continue;
+
+    const __m256i offset = _mm256_loadu_si256((const __m256i*)as32Offset);
+    const __m256i levels = _mm256_loadu_si256((const __m256i*)as32Levels);
+    const __m256i levels_odd = _mm256_srli_epi64(levels, 32);
+    const __m256i shift_even = _mm256_loadu_si256((const __m256i*)as64Shift);
+    const __m256i shift_odd =
+        _mm256_loadu_si256((const __m256i*)(as64Shift + 4));
+
+    const int32_t* ps32SbCol = ps32Sb + s32Col;
+    uint16_t* pu16QuantizedCol = pu16Quantized + s32Col;
+
+    for (int32_t s32Blk = 0; s32Blk < s32NumOfBlocks; s32Blk++) {
+      __m256i t = _mm256_add_epi32(
+          _mm256_srai_epi32(_mm256_loadu_si256((const __m256i*)ps32SbCol), 2),
+          offset);
+
+      __m256i q_even =
+          _mm256_srlv_epi64(_mm256_mul_epi32(t, levels), shift_even);
+      __m256i q_odd = _mm256_srlv_epi64(
+          _mm256_mul_epi32(_mm256_srli_epi64(t, 32), levels_odd), shift_odd);
+
+      __m256i q = _mm256_blend_epi32(q_even, _mm256_slli_epi64(q_odd, 32), 0xaa);
+      q = _mm256_srai_epi32(_mm256_slli_epi32(q, 16), 16);
+      q = _mm256_permute4x64_epi64(_mm256_packs_epi32(q, q),
+                                   _MM_SHUFFLE(3, 1, 2, 0));
+      _mm_storeu_si128((__m128i*)pu16QuantizedCol, _mm256_castsi256_si128(q));
+
+      ps32SbCol += s32NumOfCols;
+      pu16QuantizedCol += s32NumOfCols;
+    }
+  }
+
+  if (s32Col < s32NumOfCols)
+    SbcQuantizeSse2(ps32Sb + s32Col, 4, s32NumOfBlocks,
+                    ps16ScaleFactor + s32Col, ps16Bits + s32Col,
+                    pu16Quantized + s32Col);
+}
+
+/****************************************************************************
+ * Selection of the functions
+ */
+
+bool SbcEncDspHasAvx2(void) {
+#if defined(__AVX2__)
+  return true;
+#else
+  return __builtin_cpu_supports("avx2");
+#endif
+}
+
+void SbcEncDspInitSse2(SBC_ENC_DSP* pstrDsp) {
+  pstrDsp->Window4 = SbcWindow4Sse2;
+  pstrDsp->Window8 = SbcWindow8Sse2;
+  pstrDsp->Idct4 = SbcIdct4Sse2;
+  pstrDsp->Idct8 = SbcIdct8Sse2;
+  pstrDsp->MaxAbs = SbcMaxAbsSse2;
+  pstrDsp->MaxAbsJoint = SbcMaxAbsJointSse2;
+  pstrDsp->Quantize = SbcQuantizeSse2;
+}
+
+void SbcEncDspInitAvx2(SBC_ENC_DSP* pstrDsp) {
+  SbcEncDspInitSse2(pstrDsp);
+  pstrDsp->Window8 = SbcWindow8Avx2;
+  pstrDsp->Idct8 = SbcIdct8Avx2;
+  pstrDsp->Quantize = SbcQuantizeAvx2;
+}
+
+#endif /* SBC_VECTOR_X86 */
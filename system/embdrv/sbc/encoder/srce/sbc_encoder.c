@@ -23,16 +23,69 @@
  ******************************************************************************/
 
 #include "sbc_encoder.h"
+#include <pthread.h>
 #include <string.h>
 #include "bt_target.h"
 #include "sbc_enc_func_declare.h"
 
 int16_t EncMaxShiftCounter;
 
-#if (SBC_JOINT_STE_INCLUDED == TRUE)
-int32_t s32LRDiff[SBC_MAX_NUM_OF_BLOCKS] = {0};
-int32_t s32LRSum[SBC_MAX_NUM_OF_BLOCKS] = {0};
-#endif
+SBC_ENC_DSP gstrEncDsp;
+static pthread_once_t sbc_enc_dsp_once = PTHREAD_ONCE_INIT;
+
+static void SbcEncDspSelect(void) { SbcEncDspInit(&gstrEncDsp); }
+
+/****************************************************************************
+* SbcMaxAbs - finds the maximum absolute value of each subband
+*
+* RETURNS : N/A
+*/
+void SbcMaxAbs(const int32_t* ps32Sb, int32_t s32NumOfCols,
+               int32_t s32NumOfBlocks, int32_t* ps32Max) {
+  const int32_t* SbBuffer;
+  int32_t s32Col, s32Blk;
+  int32_t s32MaxValue;
+
+  for (s32Col = 0; s32Col < s32NumOfCols; s32Col++) {
+    SbBuffer = ps32Sb + s32Col;
+    s32MaxValue = 0;
+    for (s32Blk = s32NumOfBlocks; s32Blk > 0; s32Blk--) {
+      if (s32MaxValue < abs32(*SbBuffer)) s32MaxValue = abs32(*SbBuffer);
+      SbBuffer += s32NumOfCols;
+    }
+    ps32Max[s32Col] = s32MaxValue;
+  }
+}
+
+/****************************************************************************
+* SbcMaxAbsJoint - finds the maximum absolute value of the sum and
+* difference of the left and right channels of each subband
+*
+* RETURNS : N/A
+*/
+void SbcMaxAbsJoint(const int32_t* ps32Sb, int32_t s32NumOfSubBands,
+                    int32_t s32NumOfBlocks, int32_t* ps32MaxSum,
+                    int32_t* ps32MaxDiff) {
+  const int32_t* SbBuffer;
+  int32_t s32Sb, s32Blk;
+  int32_t s32Sum, s32Diff;
+  int32_t s32MaxValue, s32MaxValue2;
+
+  for (s32Sb = 0; s32Sb < s32NumOfSubBands; s32Sb++) {
+    SbBuffer = ps32Sb + s32Sb;
+    s32MaxValue = 0;
+    s32MaxValue2 = 0;
+    for (s32Blk = 0; s32Blk < s32NumOfBlocks; s32Blk++) {
+      s32Sum = (*SbBuffer + *(SbBuffer + s32NumOfSubBands)) >> 1;
+      if (abs32(s32Sum) > s32MaxValue) s32MaxValue = abs32(s32Sum);
+      s32Diff = (*SbBuffer - *(SbBuffer + s32NumOfSubBands)) >> 1;
+      if (abs32(s32Diff) > s32MaxValue2) s32MaxValue2 = abs32(s32Diff);
+      SbBuffer += s32NumOfSubBands << 1;
+    }
+    ps32MaxSum[s32Sb] = s32MaxValue;
+    ps32MaxDiff[s32Sb] = s32MaxValue2;
+  }
+}
 
 uint32_t SBC_Encode(SBC_ENC_PARAMS* pstrEncParams, int16_t* input,
                     uint8_t* output) {
@@ -40,18 +93,24 @@ uint32_t SBC_Encode(SBC_ENC_PARAMS* pstrEncParams, int16_t* input,
   int32_t s32Sb;                 /* counter for sub-band*/
   uint32_t u32Count, maxBit = 0; /* loop count*/
   int32_t s32MaxValue;           /* temp variable to store max value */
+  int32_t as32MaxValue[SBC_MAX_NUM_OF_CHANNELS * SBC_MAX_NUM_OF_SUBBANDS];
 
   int16_t* ps16ScfL;
-  int32_t* SbBuffer;
-  int32_t s32Blk; /* counter for block*/
   int32_t s32NumOfBlocks = pstrEncParams->s16NumOfBlocks;
 #if (SBC_JOINT_STE_INCLUDED == TRUE)
+  int32_t* SbBuffer;
+  int32_t s32Blk; /* counter for block*/
   int32_t s32MaxValue2;
+  int32_t as32MaxValue2[SBC_MAX_NUM_OF_SUBBANDS];
   uint32_t u32CountSum, u32CountDiff;
-  int32_t *pSum, *pDiff;
+  int32_t s32Left, s32Right;
 #endif
   register int32_t s32NumOfSubBands = pstrEncParams->s16NumOfSubBands;
 
+  /* Encoders set up without SBC_Encoder_Init(), as mSBC is, need the
+   * signal processing functions as well */
+  pthread_once(&sbc_enc_dsp_once, SbcEncDspSelect);
+
   /* SBC ananlysis filter*/
   if (s32NumOfSubBands == 4)
     SbcAnalysisFilter4(pstrEncParams, input);
@@ -61,14 +120,11 @@ uint32_t SBC_Encode(SBC_ENC_PARAMS* pstrEncParams, int16_t* input,
   /* compute the scale factor, and save the max */
   ps16ScfL = pstrEncParams->as16ScaleFactor;
   s32Ch = pstrEncParams->s16NumOfChannels * s32NumOfSubBands;
+  gstrEncDsp.MaxAbs(pstrEncParams->s32SbBuffer, s32Ch, s32NumOfBlocks,
+                    as32MaxValue);
 
   for (s32Sb = 0; s32Sb < s32Ch; s32Sb++) {
-    SbBuffer = pstrEncParams->s32SbBuffer + s32Sb;
-    s32MaxValue = 0;
-    for (s32Blk = s32NumOfBlocks; s32Blk > 0; s32Blk--) {
-      if (s32MaxValue < abs32(*SbBuffer)) s32MaxValue = abs32(*SbBuffer);
-      SbBuffer += s32Ch;
-    }
+    s32MaxValue = as32MaxValue[s32Sb];
 
     u32Count = (s32MaxValue > 0x800000) ? 9 : 0;
 
@@ -85,21 +141,11 @@ uint32_t SBC_Encode(SBC_ENC_PARAMS* pstrEncParams, int16_t* input,
     /* Calculate sum and differance  scale factors for making JS decision   */
     ps16ScfL = pstrEncParams->as16ScaleFactor;
     /* calculate the scale factor of Joint stereo max sum and diff */
+    gstrEncDsp.MaxAbsJoint(pstrEncParams->s32SbBuffer, s32NumOfSubBands,
+                           s32NumOfBlocks, as32MaxValue, as32MaxValue2);
     for (s32Sb = 0; s32Sb < s32NumOfSubBands - 1; s32Sb++) {
-      SbBuffer = pstrEncParams->s32SbBuffer + s32Sb;
-      s32MaxValue2 = 0;
-      s32MaxValue = 0;
-      pSum = s32LRSum;
-      pDiff = s32LRDiff;
-      for (s32Blk = 0; s32Blk < s32NumOfBlocks; s32Blk++) {
-        *pSum = (*SbBuffer + *(SbBuffer + s32NumOfSubBands)) >> 1;
-        if (abs32(*pSum) > s32MaxValue) s32MaxValue = abs32(*pSum);
-        pSum++;
-        *pDiff = (*SbBuffer - *(SbBuffer + s32NumOfSubBands)) >> 1;
-        if (abs32(*pDiff) > s32MaxValue2) s32MaxValue2 = abs32(*pDiff);
-        pDiff++;
-        SbBuffer += s32Ch;
-      }
+      s32MaxValue = as32MaxValue[s32Sb];
+      s32MaxValue2 = as32MaxValue2[s32Sb];
       u32Count = (s32MaxValue > 0x800000) ? 9 : 0;
       for (; u32Count < 15; u32Count++) {
         if (s32MaxValue <= (int32_t)(0x8000 << u32Count)) break;
@@ -120,16 +166,14 @@ uint32_t SBC_Encode(SBC_ENC_PARAMS* pstrEncParams, int16_t* input,
         *(ps16ScfL + s32NumOfSubBands) = (int16_t)u32CountDiff;
 
         SbBuffer = pstrEncParams->s32SbBuffer + s32Sb;
-        pSum = s32LRSum;
-        pDiff = s32LRDiff;
 
         for (s32Blk = 0; s32Blk < s32NumOfBlocks; s32Blk++) {
-          *SbBuffer = *pSum;
-          *(SbBuffer + s32NumOfSubBands) = *pDiff;
+          s32Left = *SbBuffer;
+          s32Right = *(SbBuffer + s32NumOfSubBands);
+          *SbBuffer = (s32Left + s32Right) >> 1;
+          *(SbBuffer + s32NumOfSubBands) = (s32Left - s32Right) >> 1;
 
           SbBuffer += s32NumOfSubBands << 1;
-          pSum++;
-          pDiff++;
         }
 
         pstrEncParams->as16Join[s32Sb] = 1;
@@ -254,5 +298,32 @@ void SBC_Encoder_Init(SBC_ENC_PARAMS* pstrEncParams) {
       EncMaxShiftCounter = ((ENC_VX_BUFFER_SIZE - 8 * 10 * 2) >> 4) << 3;
   }
 
+  pthread_once(&sbc_enc_dsp_once, SbcEncDspSelect);
   SbcAnalysisInit();
 }
+
+/****************************************************************************
+* SbcEncDspInit - selects the signal processing functions
+*
+* RETURNS : N/A
+*/
+void SbcEncDspInitScalar(SBC_ENC_DSP* pstrDsp) {
+  pstrDsp->Window4 = SbcWindow4;
+  pstrDsp->Window8 = SbcWindow8;
+  pstrDsp->Idct4 = SbcIdct4;
+  pstrDsp->Idct8 = SbcIdct8;
+  pstrDsp->MaxAbs = SbcMaxAbs;
+  pstrDsp->MaxAbsJoint = SbcMaxAbsJoint;
+  pstrDsp->Quantize = SbcQuantize;
+}
+
+void SbcEncDspInit(SBC_ENC_DSP* pstrDsp) {
+  SbcEncDspInitScalar(pstrDsp);
+#if (SBC_VECTOR_X86 == TRUE)
+  SbcEncDspInitSse2(pstrDsp);
+  if (SbcEncDspHasAvx2()) SbcEncDspInitAvx2(pstrDsp);
+#endif
+#if (SBC_VECTOR_NEON == TRUE)
+  SbcEncDspInitNeon(pstrDsp);
+#endif
+}
@@ -0,0 +1,200 @@
+/*
+ * Copyright 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <string.h>
+
+#include <string>
+#include <vector>
+
+#include "sbc_encoder.h"
+
+extern "C" {
+#include "sbc_enc_func_declare.h"
+}
+
+namespace {
+
+struct EncoderConfig {
+  int16_t sampling_freq;
+  int16_t channel_mode;
+  int16_t num_of_subbands;
+  int16_t num_of_blocks;
+  int16_t bitpool;
+  uint8_t format;
+  uint32_t golden_hash;
+};
+
+// The hashes of the first frames encoded by the portable fixed point code,
+// before the vector versions were introduced
+const EncoderConfig kConfigs[] = {
+    {SBC_sf44100, SBC_JOINT_STEREO, SUB_BANDS_8, SBC_BLOCK_3, 53,
+     SBC_FORMAT_GENERAL, 0x47ba14f0},
+    {SBC_sf48000, SBC_JOINT_STEREO, SUB_BANDS_8, SBC_BLOCK_3, 51,
+     SBC_FORMAT_GENERAL, 0x3f5338b9},
+    {SBC_sf44100, SBC_STEREO, SUB_BANDS_8, SBC_BLOCK_2, 35, SBC_FORMAT_GENERAL,
+     0xfef07547},
+    {SBC_sf48000, SBC_DUAL, SUB_BANDS_4, SBC_BLOCK_1, 32, SBC_FORMAT_GENERAL,
+     0x6657392c},
+    {SBC_sf32000, SBC_JOINT_STEREO, SUB_BANDS_4, SBC_BLOCK_0, 40,
+     SBC_FORMAT_GENERAL, 0xbcd8bfbd},
+    {SBC_sf44100, SBC_MONO, SUB_BANDS_4, SBC_BLOCK_3, 31, SBC_FORMAT_GENERAL,
+     0x29ce152b},
+    {SBC_sf16000, SBC_MONO, SUB_BANDS_8, 15, 26, SBC_FORMAT_MSBC, 0x198ff7c2},
+};
+
+constexpr int kNumFrames = 200;
+
+struct DspFunctions {
+  std::string name;
+  void (*init)(SBC_ENC_DSP*);
+};
+
+// The vector versions available on the running CPU
+std::vector<DspFunctions> VectorDspFunctions() {
+  std::vector<DspFunctions> dsp;
+#if (SBC_VECTOR_X86 == TRUE)
+  dsp.push_back({"sse2", SbcEncDspInitSse2});
+  if (SbcEncDspHasAvx2()) dsp.push_back({"avx2", SbcEncDspInitAvx2});
+#endif
+#if (SBC_VECTOR_NEON == TRUE)
+  dsp.push_back({"neon", SbcEncDspInitNeon});
+#endif
+  return dsp;
+}
+
+// Triangle wave and noise, with full scale frames, generated with integer
+// arithmetic only so that the input does not depend on the math library
+void FillPcm(int frame, std::vector<int16_t>& pcm, uint32_t& seed) {
+  for (size_t i = 0; i < pcm.size(); i++) {
+    seed = seed * 1664525 + 1013904223;
+    int32_t n = frame * (int32_t)pcm.size() + (int32_t)i;
+    int32_t tri = (n * 331) % 65536;
+    tri = (tri < 32768 ? tri : 65535 - tri) - 16384;
+    int32_t v = tri + (int32_t)(seed >> 18) - 8192;
+    if (i & 1) v = v / 2 - ((n * 1283) % 8192);
+    pcm[i] = (int16_t)v;
+  }
+
+  if (frame % 13 == 7)
+    for (size_t i = 0; i < pcm.size(); i++)
+      pcm[i] = (i & 2) ? INT16_MAX : INT16_MIN;
+}
+
+// Encode the test signal, with the given signal processing functions
+std::vector<uint8_t> Encode(const EncoderConfig& config,
+                            void (*init_dsp)(SBC_ENC_DSP*)) {
+  SBC_ENC_PARAMS params;
+  memset(&params, 0, sizeof(params));
+  params.s16SamplingFreq = config.sampling_freq;
+  params.s16ChannelMode = config.channel_mode;
+  params.s16NumOfSubBands = config.num_of_subbands;
+  params.s16NumOfBlocks = config.num_of_blocks;
+  params.s16AllocationMethod = SBC_LOUDNESS;
+  params.Format = config.format;
+  SBC_Encoder_Init(&params);
+  params.s16BitPool = config.bitpool;
+  // Override the functions selected for all the encoders
+  if (init_dsp == nullptr) init_dsp = SbcEncDspInit;
+  init_dsp(&gstrEncDsp);
+
+  int num_of_channels = config.channel_mode == SBC_MONO ? 1 : 2;
+  std::vector<int16_t> pcm(config.num_of_subbands * config.num_of_blocks *
+                           num_of_channels);
+  std::vector<uint8_t> frames;
+  uint8_t frame[512];
+  uint32_t seed = 1;
+
+  for (int i = 0; i < kNumFrames; i++) {
+    FillPcm(i, pcm, seed);
+    uint32_t size = SBC_Encode(&params, pcm.data(), frame);
+    frames.insert(frames.end(), frame, frame + size);
+  }
+
+  return frames;
+}
+
+uint32_t Hash(const std::vector<uint8_t>& data) {
+  uint32_t h = 2166136261u;
+  for (uint8_t v : data) h = (h ^ v) * 16777619u;
+  return h;
+}
+
+// Encode the test signal as the HFP mSBC encoder does, with its parameters
+// set up without SBC_Encoder_Init()
+std::vector<uint8_t> EncodeMsbcWithoutInit(const EncoderConfig& config) {
+  SBC_ENC_PARAMS params;
+  memset(&params, 0, sizeof(params));
+  params.s16SamplingFreq = config.sampling_freq;
+  params.s16ChannelMode = config.channel_mode;
+  params.s16NumOfSubBands = config.num_of_subbands;
+  params.s16NumOfChannels = 1;
+  params.s16NumOfBlocks = config.num_of_blocks;
+  params.s16AllocationMethod = SBC_LOUDNESS;
+  params.s16BitPool = config.bitpool;
+  params.Format = config.format;
+  SbcAnalysisInit();
+
+  std::vector<int16_t> pcm(config.num_of_subbands * config.num_of_blocks);
+  std::vector<uint8_t> frames;
+  uint8_t frame[512];
+  uint32_t seed = 1;
+
+  for (int i = 0; i < kNumFrames; i++) {
+    FillPcm(i, pcm, seed);
+    uint32_t size = SBC_Encode(&params, pcm.data(), frame);
+    frames.insert(frames.end(), frame, frame + size);
+  }
+
+  return frames;
+}
+
+}  // namespace
+
+TEST(LibSbcEncTest, encode_msbc_without_init) {
+  const auto& config = kConfigs[sizeof(kConfigs) / sizeof(kConfigs[0]) - 1];
+  ASSERT_EQ(config.format, SBC_FORMAT_MSBC);
+
+  // Declared first, so that the first frame selects the signal processing
+  // functions
+  auto frames = EncodeMsbcWithoutInit(config);
+  ASSERT_NE(gstrEncDsp.Window8, nullptr);
+
+  SbcEncDspInitScalar(&gstrEncDsp);
+  EXPECT_EQ(frames, EncodeMsbcWithoutInit(config));
+}
+
+TEST(LibSbcEncTest, encode_golden) {
+  for (const auto& config : kConfigs) {
+    SCOPED_TRACE(testing::Message() << "blocks " << config.num_of_blocks
+                                    << " mode " << config.channel_mode);
+    EXPECT_EQ(Hash(Encode(config, SbcEncDspInitScalar)), config.golden_hash);
+    EXPECT_EQ(Hash(Encode(config, nullptr)), config.golden_hash);
+  }
+}
+
+TEST(LibSbcEncTest, vector_dsp_bit_exact) {
+  for (const auto& config : kConfigs) {
+    auto expected = Encode(config, SbcEncDspInitScalar);
+
+    for (const auto& dsp : VectorDspFunctions()) {
+      SCOPED_TRACE(testing::Message() << dsp.name << " blocks "
+                                      << config.num_of_blocks << " mode "
+                                      << config.channel_mode);
+      EXPECT_EQ(Encode(config, dsp.init), expected);
+    }
+  }
+}
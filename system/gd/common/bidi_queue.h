@@ -58,7 +58,8 @@ class BidiQueueEnd : public ::bluetooth::os::IQueueEnqueue<TENQUEUE>, public ::b
   ::bluetooth::os::IQueueDequeue<TDEQUEUE>* rx_;
 };
 
-template <typename TUP, typename TDOWN>
+// QueueType can be swapped for ::bluetooth::os::SpscQueue when each direction has a single producer and consumer
+template <typename TUP, typename TDOWN, template <typename> class QueueType = ::bluetooth::os::Queue>
 class BidiQueue {
  public:
   explicit BidiQueue(size_t capacity)
@@ -76,8 +77,8 @@ class BidiQueue {
   }
 
  private:
-  ::bluetooth::os::Queue<TUP> up_queue_;
-  ::bluetooth::os::Queue<TDOWN> down_queue_;
+  QueueType<TUP> up_queue_;
+  QueueType<TDOWN> down_queue_;
   BidiQueueEnd<TDOWN, TUP> up_end_;
   BidiQueueEnd<TUP, TDOWN> down_end_;
 };
@@ -41,7 +41,8 @@ namespace common {
 // Template:
 //   - Key key
 //   - T value
-template <typename Key, typename T>
+//   - Hash hash function of the keys
+template <typename Key, typename T, typename Hash = std::hash<Key>>
 class ListMap {
  public:
   using value_type = std::pair<const Key, T>;
@@ -159,7 +160,7 @@ class ListMap {
   // - pos: element before which the content will be inserted
   // - other: another container to transfer the content from
   // - it: the element to transfer from other to *this
-  void splice(const_iterator pos, ListMap<Key, T>& other, const_iterator it) {
+  void splice(const_iterator pos, ListMap& other, const_iterator it) {
     if (&other != this) {
       auto map_node = other.key_map_.extract(it->first);
       key_map_.insert(std::move(map_node));
@@ -213,7 +214,7 @@ class ListMap {
 
  private:
   std::list<value_type> node_list_;
-  std::unordered_map<Key, iterator> key_map_;
+  std::unordered_map<Key, iterator, Hash> key_map_;
 };
 
 }  // namespace common
@@ -48,15 +48,16 @@ namespace common {
 // Template:
 //   - Key key type
 //   - T value type
+//   - Hash hash function of the keys
 // */
-template <typename Key, typename T>
+template <typename Key, typename T, typename Hash = std::hash<Key>>
 class LruCache {
  public:
-  using value_type = typename ListMap<Key, T>::value_type;
+  using value_type = typename ListMap<Key, T, Hash>::value_type;
   // different from c++17 node_type on purpose as we want node to be copyable
-  using node_type = typename ListMap<Key, T>::node_type;
-  using iterator = typename ListMap<Key, T>::iterator;
-  using const_iterator = typename ListMap<Key, T>::const_iterator;
+  using node_type = typename ListMap<Key, T, Hash>::node_type;
+  using iterator = typename ListMap<Key, T, Hash>::iterator;
+  using const_iterator = typename ListMap<Key, T, Hash>::const_iterator;
 
   // Constructor a LRU cache with |capacity|
   explicit LruCache(size_t capacity) : capacity_(capacity) {
@@ -190,6 +191,11 @@ class LruCache {
     return list_map_.size();
   }
 
+  // Return capacity of the cache
+  inline size_t capacity() const {
+    return capacity_;
+  }
+
   // Iterator interface for begin
   inline iterator begin() {
     return list_map_.begin();
@@ -212,7 +218,7 @@ class LruCache {
 
  private:
   size_t capacity_;
-  ListMap<Key, T> list_map_;
+  ListMap<Key, T, Hash> list_map_;
 };
 
 }  // namespace common
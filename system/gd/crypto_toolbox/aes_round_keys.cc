@@ -0,0 +1,362 @@
+/*
+ * Copyright 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/******************************************************************************
+ *
+ *  This file contains AES-128 and AES-CMAC with expanded keys, using the AES
+ *  instructions of the CPU when it has them: AES-NI on x86 and the ARMv8
+ *  cryptography extension on arm64. These instructions take the same time
+ *  whatever the key and data, unlike the table based implementation of aes.cc
+ *  which is used otherwise.
+ *
+ *  The legacy stack builds this file too, in place of its own copy.
+ *
+ ******************************************************************************/
+
+#include <algorithm>
+#include <cstring>
+
+#include "crypto_toolbox/aes.h"
+#include "crypto_toolbox/aes_round_keys.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <tmmintrin.h>
+#include <wmmintrin.h>
+#define CRYPTO_TOOLBOX_AES_NI
+#elif defined(__aarch64__) && defined(__linux__)
+#include <arm_neon.h>
+#include <asm/hwcap.h>
+#include <sys/auxv.h>
+#define CRYPTO_TOOLBOX_ARMV8_AES
+#endif
+
+namespace bluetooth {
+namespace crypto_toolbox {
+
+namespace {
+
+constexpr size_t kAes128Rounds = 10;
+
+/* The key and message bytes are in reverse order, see aes_128() */
+void aes_128_multi_key_portable(
+    const Aes128RoundKeys* keys, size_t count, const Octet16& message_reversed, Octet16* outputs) {
+  aes_context ctx;
+  ctx.rnd = kAes128Rounds;
+  for (size_t i = 0; i < count; i++) {
+    memcpy(ctx.ksch, keys[i].bytes, sizeof(keys[i].bytes));
+    aes_encrypt(message_reversed.data(), outputs[i].data(), &ctx);
+  }
+}
+
+/* Rb for AES-128 as block cipher, LSB as [0] */
+constexpr uint8_t kCmacRb = 0x87;
+
+/* This function computes the CMAC subkey K << 1, (+) Rb when the MSB of K is
+ * set, without branching on the key */
+Octet16 cmac_subkey(const Octet16& k) {
+  Octet16 output;
+  uint8_t carry = 0;
+  /* k[0] is LSB */
+  for (size_t i = 0; i < OCTET16_LEN; i++) {
+    output[i] = (k[i] << 1) | carry;
+    carry = k[i] >> 7;
+  }
+  output[0] ^= kCmacRb & (0 - carry);
+  return output;
+}
+
+/* This function computes the CBC-MAC of the |num_blocks| blocks of |blocks|
+ * followed by |last_block|. Blocks are in little endian order like the
+ * message, hence they are processed from the end of |blocks|. */
+Octet16 aes_128_cbc_mac_portable(
+    const Aes128RoundKeys& keys, const uint8_t* blocks, size_t num_blocks, const Octet16& last_block) {
+  aes_context ctx;
+  ctx.rnd = kAes128Rounds;
+  memcpy(ctx.ksch, keys.bytes, sizeof(keys.bytes));
+
+  /* in the byte order of aes.cc */
+  uint8_t x[OCTET16_LEN] = {0};
+  for (size_t k = num_blocks; k-- > 0;) {
+    const uint8_t* block = blocks + k * OCTET16_LEN;
+    for (size_t i = 0; i < OCTET16_LEN; i++) {
+      x[i] ^= block[OCTET16_LEN - 1 - i];
+    }
+    aes_encrypt(x, x, &ctx);
+  }
+  for (size_t i = 0; i < OCTET16_LEN; i++) {
+    x[i] ^= last_block[OCTET16_LEN - 1 - i];
+  }
+  aes_encrypt(x, x, &ctx);
+
+  Octet16 mac;
+  std::reverse_copy(x, x + OCTET16_LEN, mac.begin());
+  return mac;
+}
+
+#if defined(CRYPTO_TOOLBOX_AES_NI)
+
+/* Number of keys encrypted together, so that the latency of an AESENC is
+ * hidden by the ones of the other keys */
+constexpr size_t kAesNiBatch = 4;
+
+__attribute__((target("aes,sse2"))) inline __m128i round_key(const Aes128RoundKeys& keys, size_t round) {
+  return _mm_load_si128(reinterpret_cast<const __m128i*>(keys.bytes + round * OCTET16_LEN));
+}
+
+__attribute__((target("aes,sse2"))) void aes_128_multi_key_aes_ni(
+    const Aes128RoundKeys* keys, size_t count, const Octet16& message_reversed,
+    Octet16* outputs) {
+  const __m128i message = _mm_loadu_si128(reinterpret_cast<const __m128i*>(message_reversed.data()));
+  size_t i = 0;
+  for (; i + kAesNiBatch <= count; i += kAesNiBatch) {
+    __m128i state[kAesNiBatch];
+    for (size_t k = 0; k < kAesNiBatch; k++) {
+      state[k] = _mm_xor_si128(message, round_key(keys[i + k], 0));
+    }
+    for (size_t round = 1; round < kAes128Rounds; round++) {
+      for (size_t k = 0; k < kAesNiBatch; k++) {
+        state[k] = _mm_aesenc_si128(state[k], round_key(keys[i + k], round));
+      }
+    }
+    for (size_t k = 0; k < kAesNiBatch; k++) {
+      state[k] = _mm_aesenclast_si128(state[k], round_key(keys[i + k], kAes128Rounds));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(outputs[i + k].data()), state[k]);
+    }
+  }
+  for (; i < count; i++) {
+    __m128i state = _mm_xor_si128(message, round_key(keys[i], 0));
+    for (size_t round = 1; round < kAes128Rounds; round++) {
+      state = _mm_aesenc_si128(state, round_key(keys[i], round));
+    }
+    state = _mm_aesenclast_si128(state, round_key(keys[i], kAes128Rounds));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(outputs[i].data()), state);
+  }
+}
+
+__attribute__((target("aes,ssse3"))) Octet16 aes_128_cbc_mac_aes_ni(
+    const Aes128RoundKeys& keys, const uint8_t* blocks, size_t num_blocks, const Octet16& last_block) {
+  const __m128i reverse = _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+  __m128i round_keys[kAes128Rounds + 1];
+  for (size_t round = 0; round <= kAes128Rounds; round++) {
+    round_keys[round] = round_key(keys, round);
+  }
+
+  auto encrypt = [&](__m128i state) __attribute__((target("aes,ssse3"))) {
+    state = _mm_xor_si128(state, round_keys[0]);
+    for (size_t round = 1; round < kAes128Rounds; round++) {
+      state = _mm_aesenc_si128(state, round_keys[round]);
+    }
+    return _mm_aesenclast_si128(state, round_keys[kAes128Rounds]);
+  };
+
+  __m128i x = _mm_setzero_si128();
+  for (size_t k = num_blocks; k-- > 0;) {
+    __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(blocks + k * OCTET16_LEN));
+    x = encrypt(_mm_xor_si128(x, _mm_shuffle_epi8(block, reverse)));
+  }
+  __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(last_block.data()));
+  x = encrypt(_mm_xor_si128(x, _mm_shuffle_epi8(block, reverse)));
+
+  Octet16 mac;
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(mac.data()), _mm_shuffle_epi8(x, reverse));
+  return mac;
+}
+
+bool cpu_has_aes_ni() {
+  static const bool has_aes_ni = __builtin_cpu_supports("aes") && __builtin_cpu_supports("ssse3");
+  return has_aes_ni;
+}
+
+#endif
+
+#if defined(CRYPTO_TOOLBOX_ARMV8_AES)
+
+#if defined(__clang__)
+#define CRYPTO_TOOLBOX_TARGET_AES __attribute__((target("aes")))
+#else
+#define CRYPTO_TOOLBOX_TARGET_AES __attribute__((target("+crypto")))
+#endif
+
+/* Number of keys encrypted together, so that the latency of an AESE/AESMC pair
+ * is hidden by the ones of the other keys */
+constexpr size_t kArmv8AesBatch = 4;
+
+inline uint8x16_t round_key(const Aes128RoundKeys& keys, size_t round) {
+  return vld1q_u8(keys.bytes + round * OCTET16_LEN);
+}
+
+/* AESE adds the round key before SubBytes and ShiftRows, hence the last round
+ * key is added separately */
+CRYPTO_TOOLBOX_TARGET_AES inline uint8x16_t aes_128_encrypt_armv8(
+    const uint8x16_t round_keys[kAes128Rounds + 1], uint8x16_t state) {
+  for (size_t round = 0; round < kAes128Rounds - 1; round++) {
+    state = vaesmcq_u8(vaeseq_u8(state, round_keys[round]));
+  }
+  state = vaeseq_u8(state, round_keys[kAes128Rounds - 1]);
+  return veorq_u8(state, round_keys[kAes128Rounds]);
+}
+
+/* Reverses the order of the 16 bytes of |v| */
+inline uint8x16_t reverse_bytes(uint8x16_t v) {
+  v = vrev64q_u8(v);
+  return vextq_u8(v, v, 8);
+}
+
+CRYPTO_TOOLBOX_TARGET_AES void aes_128_multi_key_armv8(
+    const Aes128RoundKeys* keys, size_t count, const Octet16& message_reversed, Octet16* outputs) {
+  const uint8x16_t message = vld1q_u8(message_reversed.data());
+  size_t i = 0;
+  for (; i + kArmv8AesBatch <= count; i += kArmv8AesBatch) {
+    uint8x16_t state[kArmv8AesBatch];
+    for (size_t k = 0; k < kArmv8AesBatch; k++) {
+      state[k] = message;
+    }
+    for (size_t round = 0; round < kAes128Rounds - 1; round++) {
+      for (size_t k = 0; k < kArmv8AesBatch; k++) {
+        state[k] = vaesmcq_u8(vaeseq_u8(state[k], round_key(keys[i + k], round)));
+      }
+    }
+    for (size_t k = 0; k < kArmv8AesBatch; k++) {
+      state[k] = vaeseq_u8(state[k], round_key(keys[i + k], kAes128Rounds - 1));
+      vst1q_u8(outputs[i + k].data(), veorq_u8(state[k], round_key(keys[i + k], kAes128Rounds)));
+    }
+  }
+  for (; i < count; i++) {
+    uint8x16_t round_keys[kAes128Rounds + 1];
+    for (size_t round = 0; round <= kAes128Rounds; round++) {
+      round_keys[round] = round_key(keys[i], round);
+    }
+    vst1q_u8(outputs[i].data(), aes_128_encrypt_armv8(round_keys, message));
+  }
+}
+
+CRYPTO_TOOLBOX_TARGET_AES Octet16 aes_128_cbc_mac_armv8(
+    const Aes128RoundKeys& keys, const uint8_t* blocks, size_t num_blocks, const Octet16& last_block) {
+  uint8x16_t round_keys[kAes128Rounds + 1];
+  for (size_t round = 0; round <= kAes128Rounds; round++) {
+    round_keys[round] = round_key(keys, round);
+  }
+
+  uint8x16_t x = vdupq_n_u8(0);
+  for (size_t k = num_blocks; k-- > 0;) {
+    uint8x16_t block = vld1q_u8(blocks + k * OCTET16_LEN);
+    x = aes_128_encrypt_armv8(round_keys, veorq_u8(x, reverse_bytes(block)));
+  }
+  x = aes_128_encrypt_armv8(round_keys, veorq_u8(x, reverse_bytes(vld1q_u8(last_block.data()))));
+
+  Octet16 mac;
+  vst1q_u8(mac.data(), reverse_bytes(x));
+  return mac;
+}
+
+bool cpu_has_armv8_aes() {
+  static const bool has_armv8_aes = (getauxval(AT_HWCAP) & HWCAP_AES) != 0;
+  return has_armv8_aes;
+}
+
+#endif
+
+/* This function runs aes_128_multi_key() with the AES instructions of the CPU
+ * when it has them, on a message in reverse order */
+void aes_128_multi_key_reversed(
+    const Aes128RoundKeys* keys, size_t count, const Octet16& message_reversed, Octet16* outputs) {
+#if defined(CRYPTO_TOOLBOX_AES_NI)
+  if (cpu_has_aes_ni()) {
+    aes_128_multi_key_aes_ni(keys, count, message_reversed, outputs);
+    return;
+  }
+#endif
+#if defined(CRYPTO_TOOLBOX_ARMV8_AES)
+  if (cpu_has_armv8_aes()) {
+    aes_128_multi_key_armv8(keys, count, message_reversed, outputs);
+    return;
+  }
+#endif
+  aes_128_multi_key_portable(keys, count, message_reversed, outputs);
+}
+
+}  // namespace
+
+Aes128RoundKeys aes_128_expand_key(const Octet16& key) {
+  Octet16 key_reversed;
+  std::reverse_copy(key.begin(), key.end(), key_reversed.begin());
+
+  aes_context ctx;
+  aes_set_key(key_reversed.data(), key_reversed.size(), &ctx);
+
+  Aes128RoundKeys round_keys;
+  memcpy(round_keys.bytes, ctx.ksch, sizeof(round_keys.bytes));
+  return round_keys;
+}
+
+void aes_128_multi_key(const Aes128RoundKeys* keys, size_t count, const Octet16& message, Octet16* outputs) {
+  Octet16 message_reversed;
+  std::reverse_copy(message.begin(), message.end(), message_reversed.begin());
+
+  aes_128_multi_key_reversed(keys, count, message_reversed, outputs);
+
+  for (size_t i = 0; i < count; i++) {
+    std::reverse(outputs[i].begin(), outputs[i].end());
+  }
+}
+
+/** keys - expanded CMAC key
+ *  input - text to be signed in little endian byte order.
+ *  length - length of the input in byte.
+ */
+Octet16 aes_cmac(const Aes128RoundKeys& keys, const uint8_t* input, uint16_t length) {
+  /* n is number of rounds */
+  size_t n = (length + OCTET16_LEN - 1) / OCTET16_LEN;
+  if (n == 0) n = 1;
+  /* the last block Mn is at the beginning of the little endian input */
+  size_t last_length = length - (n - 1) * OCTET16_LEN;
+
+  /* generate the two subkeys */
+  Octet16 zero{};
+  Octet16 l;
+  aes_128_multi_key(&keys, 1, zero, &l);
+  Octet16 k1 = cmac_subkey(l);
+
+  Octet16 last_block{};
+  if (last_length > 0) {
+    std::copy(input, input + last_length, last_block.end() - last_length);
+  }
+  if (last_length == OCTET16_LEN) {
+    /* last block is complete block */
+    for (size_t i = 0; i < OCTET16_LEN; i++) last_block[i] ^= k1[i];
+  } else {
+    /* padding then xor with k2 */
+    Octet16 k2 = cmac_subkey(k1);
+    last_block[OCTET16_LEN - 1 - last_length] = 0x80;
+    for (size_t i = 0; i < OCTET16_LEN; i++) last_block[i] ^= k2[i];
+  }
+
+  const uint8_t* blocks = input + last_length;
+#if defined(CRYPTO_TOOLBOX_AES_NI)
+  if (cpu_has_aes_ni()) {
+    return aes_128_cbc_mac_aes_ni(keys, blocks, n - 1, last_block);
+  }
+#endif
+#if defined(CRYPTO_TOOLBOX_ARMV8_AES)
+  if (cpu_has_armv8_aes()) {
+    return aes_128_cbc_mac_armv8(keys, blocks, n - 1, last_block);
+  }
+#endif
+  return aes_128_cbc_mac_portable(keys, blocks, n - 1, last_block);
+}
+
+}  // namespace crypto_toolbox
+}  // namespace bluetooth
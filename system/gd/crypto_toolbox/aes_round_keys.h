@@ -0,0 +1,49 @@
+/*
+ * Copyright 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+// AES-128 with expanded keys. This is also the implementation of the crypto toolbox of the legacy stack, so it must
+// not depend on anything else in gd.
+namespace bluetooth {
+namespace crypto_toolbox {
+
+constexpr int OCTET16_LEN = 16;
+using Octet16 = std::array<uint8_t, OCTET16_LEN>;
+
+/* Round keys of an AES-128 key, to encrypt with the key many times without
+ * expanding it each time */
+struct Aes128RoundKeys {
+  alignas(16) uint8_t bytes[11 * OCTET16_LEN];
+};
+
+Aes128RoundKeys aes_128_expand_key(const Octet16& key);
+
+/* This function computes AES_128(keys[i], message) into |outputs[i]| for each
+ * of the |count| keys. Several keys are processed at once when the CPU has AES
+ * instructions. */
+void aes_128_multi_key(const Aes128RoundKeys* keys, size_t count, const Octet16& message, Octet16* outputs);
+
+/* This function computes the AES-CMAC of |input| like aes_cmac(), with a key
+ * that is already expanded */
+Octet16 aes_cmac(const Aes128RoundKeys& keys, const uint8_t* input, uint16_t length);
+
+}  // namespace crypto_toolbox
+}  // namespace bluetooth
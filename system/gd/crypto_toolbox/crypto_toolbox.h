@@ -21,12 +21,11 @@
 #include <cstdint>
 #include <cstring>
 
+#include "crypto_toolbox/aes_round_keys.h"
+
 namespace bluetooth {
 namespace crypto_toolbox {
 
-constexpr int OCTET16_LEN = 16;
-using Octet16 = std::array<uint8_t, OCTET16_LEN>;
-
 Octet16 c1(
     const Octet16& k,
     const Octet16& r,
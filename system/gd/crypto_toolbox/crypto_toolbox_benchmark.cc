@@ -0,0 +1,102 @@
+/*
+ * Copyright 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "crypto_toolbox/crypto_toolbox.h"
+
+using ::benchmark::State;
+
+namespace bluetooth {
+namespace crypto_toolbox {
+
+namespace {
+
+constexpr Octet16 kKey{0x3c, 0x4f, 0xcf, 0x09, 0x88, 0x15, 0xf7, 0xab, 0xa6, 0xd2, 0xae, 0x28, 0x16, 0x15, 0x7e, 0x2b};
+
+std::vector<uint8_t> MakeMessage(size_t length) {
+  std::vector<uint8_t> message(length);
+  for (size_t i = 0; i < length; i++) {
+    message[i] = static_cast<uint8_t>(i * 31 + 7);
+  }
+  return message;
+}
+
+}  // namespace
+
+// Signed writes are a few bytes, GATT database hashes cover the whole database
+static void BM_AesCmac(State& state) {
+  auto message = MakeMessage(state.range(0));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(aes_cmac(kKey, message.data(), message.size()));
+  }
+  state.SetBytesProcessed(state.iterations() * message.size());
+}
+BENCHMARK(BM_AesCmac)->Arg(16)->Arg(64)->Arg(1024)->Arg(16384)->Arg(65535);
+
+static void BM_AesCmacExpandedKey(State& state) {
+  auto message = MakeMessage(state.range(0));
+  Aes128RoundKeys round_keys = aes_128_expand_key(kKey);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(aes_cmac(round_keys, message.data(), message.size()));
+  }
+  state.SetBytesProcessed(state.iterations() * message.size());
+}
+BENCHMARK(BM_AesCmacExpandedKey)->Arg(16)->Arg(64)->Arg(1024)->Arg(16384)->Arg(65535);
+
+static void BM_F4(State& state) {
+  std::array<uint8_t, 32> u{0x01};
+  std::array<uint8_t, 32> v{0x02};
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(f4(u.data(), v.data(), kKey, 0x00));
+  }
+}
+BENCHMARK(BM_F4);
+
+static void BM_F5(State& state) {
+  std::array<uint8_t, 32> w{0x03};
+  Octet16 n1{0x04};
+  Octet16 n2{0x05};
+  std::array<uint8_t, 7> a1{0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06};
+  std::array<uint8_t, 7> a2{0x00, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16};
+  Octet16 mac_key;
+  Octet16 ltk;
+  for (auto _ : state) {
+    f5(w.data(), n1, n2, a1.data(), a2.data(), &mac_key, &ltk);
+    benchmark::DoNotOptimize(mac_key);
+    benchmark::DoNotOptimize(ltk);
+  }
+}
+BENCHMARK(BM_F5);
+
+static void BM_F6(State& state) {
+  Octet16 n1{0x04};
+  Octet16 n2{0x05};
+  Octet16 r{0x06};
+  std::array<uint8_t, 3> iocap{0x01, 0x01, 0x02};
+  std::array<uint8_t, 7> a1{0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06};
+  std::array<uint8_t, 7> a2{0x00, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16};
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(f6(kKey, n1, n2, r, iocap.data(), a1.data(), a2.data()));
+  }
+}
+BENCHMARK(BM_F6);
+
+}  // namespace crypto_toolbox
+}  // namespace bluetooth
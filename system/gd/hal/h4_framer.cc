@@ -0,0 +1,217 @@
+/*
+ * Copyright 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "hal/h4_framer.h"
+
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+#include <algorithm>
+#include <cstring>
+
+#include "os/log.h"
+#include "os/utils.h"
+
+namespace bluetooth {
+namespace hal {
+
+namespace {
+constexpr uint8_t kH4Command = 0x01;
+constexpr uint8_t kH4Acl = 0x02;
+constexpr uint8_t kH4Sco = 0x03;
+constexpr uint8_t kH4Event = 0x04;
+constexpr uint8_t kH4Iso = 0x05;
+
+constexpr size_t kH4HeaderSize = 1;
+constexpr size_t kHciCmdHeaderSize = 3;
+constexpr size_t kHciAclHeaderSize = 4;
+constexpr size_t kHciScoHeaderSize = 3;
+constexpr size_t kHciEvtHeaderSize = 2;
+constexpr size_t kHciIsoHeaderSize = 4;
+
+// Returns 0 for a type that doesn't start an HCI packet
+size_t header_size(uint8_t h4_type) {
+  switch (h4_type) {
+    case kH4Command:
+      return kHciCmdHeaderSize;
+    case kH4Acl:
+      return kHciAclHeaderSize;
+    case kH4Sco:
+      return kHciScoHeaderSize;
+    case kH4Event:
+      return kHciEvtHeaderSize;
+    case kH4Iso:
+      return kHciIsoHeaderSize;
+    default:
+      return 0;
+  }
+}
+
+// |header| points right after the H4 type byte
+size_t payload_size(uint8_t h4_type, const uint8_t* header) {
+  switch (h4_type) {
+    case kH4Command:
+      return header[2];
+    case kH4Acl:
+      return (header[3] << 8) + header[2];
+    case kH4Sco:
+      return header[2];
+    case kH4Event:
+      return header[1];
+    case kH4Iso:
+      return ((header[3] & 0x3f) << 8) + header[2];
+    default:
+      return 0;
+  }
+}
+}  // namespace
+
+H4Framer::H4Framer(size_t capacity) : buffer_(capacity) {}
+
+ssize_t H4Framer::ReadFrom(int fd) {
+  if (begin_ == end_) {
+    begin_ = end_ = 0;
+  } else if (buffer_.size() - end_ < buffer_.size() / 4) {
+    compact();
+  }
+  ssize_t received_size;
+  RUN_NO_INTR(received_size = recv(fd, buffer_.data() + end_, buffer_.size() - end_, MSG_DONTWAIT));
+  if (received_size > 0) {
+    end_ += received_size;
+  }
+  return received_size;
+}
+
+void H4Framer::Append(const uint8_t* data, size_t size) {
+  if (buffer_.size() - end_ < size) {
+    compact();
+    if (buffer_.size() - end_ < size) {
+      buffer_.resize(end_ + size);
+    }
+  }
+  std::memcpy(buffer_.data() + end_, data, size);
+  end_ += size;
+}
+
+bool H4Framer::Next(uint8_t* h4_type, HciPacket* packet) {
+  if (!resync()) {
+    return false;
+  }
+  size_t available = end_ - begin_;
+  const uint8_t* data = buffer_.data() + begin_;
+  size_t hci_header_size = header_size(data[0]);
+  if (available < kH4HeaderSize + hci_header_size) {
+    return false;
+  }
+  size_t packet_size = hci_header_size + payload_size(data[0], data + kH4HeaderSize);
+  if (available < kH4HeaderSize + packet_size) {
+    if (kH4HeaderSize + packet_size > buffer_.size()) {
+      // Only possible with a small capacity, make sure the rest of the packet can be read
+      compact();
+      buffer_.resize(kH4HeaderSize + packet_size);
+    }
+    return false;
+  }
+  *h4_type = data[0];
+  packet->assign(data + kH4HeaderSize, data + kH4HeaderSize + packet_size);
+  begin_ += kH4HeaderSize + packet_size;
+  return true;
+}
+
+bool H4Framer::resync() {
+  size_t first = begin_;
+  while (begin_ < end_ && header_size(buffer_[begin_]) == 0) {
+    begin_++;
+  }
+  if (begin_ != first) {
+    LOG_WARN("Dropped %zu bytes starting with unexpected H4 packet type 0x%02x", begin_ - first, buffer_[first]);
+    dropped_bytes_ += begin_ - first;
+  }
+  return begin_ < end_;
+}
+
+void H4Framer::compact() {
+  if (begin_ == 0) {
+    return;
+  }
+  std::memmove(buffer_.data(), buffer_.data() + begin_, end_ - begin_);
+  end_ -= begin_;
+  begin_ = 0;
+}
+
+void H4OutgoingQueue::Push(uint8_t h4_type, HciPacket packet) {
+  packets_.push_back({h4_type, std::move(packet)});
+}
+
+ssize_t H4OutgoingQueue::WriteTo(int fd) {
+  iovec iov[2 * kMaxPacketsPerSyscall];
+  int iovcnt = 0;
+  size_t offset = front_offset_;
+  size_t count = std::min(packets_.size(), kMaxPacketsPerSyscall);
+  for (auto it = packets_.begin(); it != packets_.begin() + count; it++) {
+    if (offset == 0) {
+      iov[iovcnt++] = {&it->h4_type, kH4HeaderSize};
+      offset = kH4HeaderSize;
+    }
+    if (offset - kH4HeaderSize < it->data.size()) {
+      iov[iovcnt++] = {it->data.data() + offset - kH4HeaderSize, it->data.size() - (offset - kH4HeaderSize)};
+    }
+    offset = 0;
+  }
+
+  ssize_t written;
+  RUN_NO_INTR(written = writev(fd, iov, iovcnt));
+  if (written <= 0) {
+    return written;
+  }
+
+  size_t to_consume = written;
+  while (to_consume > 0) {
+    size_t remaining = kH4HeaderSize + packets_.front().data.size() - front_offset_;
+    if (to_consume < remaining) {
+      front_offset_ += to_consume;
+      break;
+    }
+    to_consume -= remaining;
+    packets_.pop_front();
+    front_offset_ = 0;
+  }
+  return written;
+}
+
+int H4OutgoingQueue::SendTo(int fd) {
+  ASSERT_LOG(front_offset_ == 0, "Queue was partially written to a stream socket");
+  size_t count = std::min(packets_.size(), kMaxPacketsPerSyscall);
+  iovec iov[2 * kMaxPacketsPerSyscall];
+  mmsghdr messages[kMaxPacketsPerSyscall] = {};
+  for (size_t i = 0; i < count; i++) {
+    Packet& packet = packets_[i];
+    iov[2 * i] = {&packet.h4_type, kH4HeaderSize};
+    iov[2 * i + 1] = {packet.data.data(), packet.data.size()};
+    messages[i].msg_hdr.msg_iov = &iov[2 * i];
+    messages[i].msg_hdr.msg_iovlen = 2;
+  }
+
+  int sent;
+  RUN_NO_INTR(sent = sendmmsg(fd, messages, count, 0));
+  for (int i = 0; i < sent; i++) {
+    packets_.pop_front();
+  }
+  return sent;
+}
+
+}  // namespace hal
+}  // namespace bluetooth
@@ -0,0 +1,114 @@
+/*
+ * Copyright 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <sys/types.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+#include "hal/hci_hal.h"
+
+namespace bluetooth {
+namespace hal {
+
+// Splits an H4 byte stream into HCI packets. Data is read in large chunks into a reusable buffer, so a single read()
+// usually yields several packets, and a packet split across reads is completed by the next one.
+class H4Framer {
+ public:
+  // Enough for the largest ACL packet (H4 type, 4 byte header, 16 bit length) plus a full read of the next ones
+  static constexpr size_t kDefaultCapacity = 128 * 1024;
+
+  explicit H4Framer(size_t capacity = kDefaultCapacity);
+
+  H4Framer(const H4Framer&) = delete;
+  H4Framer& operator=(const H4Framer&) = delete;
+
+  // Read whatever |fd| has available without blocking. Returns the result of recv(): the number of bytes read, 0 on
+  // EOF and -1 on error (EAGAIN when there was nothing to read).
+  ssize_t ReadFrom(int fd);
+
+  // Append bytes received by other means
+  void Append(const uint8_t* data, size_t size);
+
+  // Extract the next complete packet, without its H4 type byte. Returns false if more data is needed. Bytes that
+  // don't start with a known H4 type are dropped, so the stream can resynchronize on the next packet.
+  bool Next(uint8_t* h4_type, HciPacket* packet);
+
+  // Bytes of partial packets held until the rest arrives
+  size_t BufferedSize() const {
+    return end_ - begin_;
+  }
+
+  // Bytes dropped so far because they didn't start with a known H4 type
+  size_t DroppedSize() const {
+    return dropped_bytes_;
+  }
+
+ private:
+  // Drop the bytes up to the next known H4 type. Returns false if there is nothing left to parse.
+  bool resync();
+
+  // Move the unparsed bytes to the front of the buffer, to make room at the end
+  void compact();
+
+  std::vector<uint8_t> buffer_;
+  size_t begin_ = 0;
+  size_t end_ = 0;
+  size_t dropped_bytes_ = 0;
+};
+
+// Outgoing H4 packets, written with as few syscalls as possible: one writev() for a stream socket, or one sendmmsg()
+// with a datagram per packet for a socket that preserves message boundaries. The H4 type byte is sent from a separate
+// iovec, so packets don't need to be shifted to make room for it.
+class H4OutgoingQueue {
+ public:
+  // Upper bound on the packets sent by a single syscall
+  static constexpr size_t kMaxPacketsPerSyscall = 64;
+
+  void Push(uint8_t h4_type, HciPacket packet);
+
+  bool IsEmpty() const {
+    return packets_.empty();
+  }
+
+  size_t Size() const {
+    return packets_.size();
+  }
+
+  // Write as much as possible of the queue to a stream socket. A packet that is only partially written is finished
+  // by the next call. Returns the result of writev().
+  ssize_t WriteTo(int fd);
+
+  // Send queued packets to a message oriented socket, one datagram each. Returns the number of packets sent, or -1.
+  int SendTo(int fd);
+
+ private:
+  struct Packet {
+    uint8_t h4_type;
+    HciPacket data;
+  };
+
+  std::deque<Packet> packets_;
+  // Bytes of the front packet, counting its H4 type, already written to a stream socket
+  size_t front_offset_ = 0;
+};
+
+}  // namespace hal
+}  // namespace bluetooth
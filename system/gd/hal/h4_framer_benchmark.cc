@@ -0,0 +1,193 @@
+/*
+ * Copyright 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <thread>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "hal/h4_framer.h"
+
+using ::benchmark::State;
+
+namespace bluetooth {
+namespace hal {
+
+// Compares the per packet H4 socket I/O of the host HAL with the batched H4Framer and H4OutgoingQueue, over a
+// socketpair standing in for the rootcanal connection. state.range(0) is the ACL payload size.
+
+namespace {
+constexpr uint8_t kH4Acl = 0x02;
+constexpr int kPacketsPerIteration = 10000;
+
+HciPacket make_acl_packet(size_t payload_size) {
+  HciPacket packet(4 + payload_size, 0x5a);
+  packet[2] = payload_size & 0xff;
+  packet[3] = payload_size >> 8;
+  return packet;
+}
+
+std::vector<uint8_t> make_h4_stream(size_t payload_size, int count) {
+  HciPacket packet = make_acl_packet(payload_size);
+  std::vector<uint8_t> stream;
+  for (int i = 0; i < count; i++) {
+    stream.push_back(kH4Acl);
+    stream.insert(stream.end(), packet.begin(), packet.end());
+  }
+  return stream;
+}
+
+bool recv_all(int fd, uint8_t* data, size_t size, int64_t* syscalls) {
+  while (size > 0) {
+    ssize_t received = recv(fd, data, size, 0);
+    (*syscalls)++;
+    if (received <= 0) return false;
+    data += received;
+    size -= received;
+  }
+  return true;
+}
+
+void write_all(int fd, const std::vector<uint8_t>& data) {
+  size_t written = 0;
+  while (written < data.size()) {
+    ssize_t result = write(fd, data.data() + written, data.size() - written);
+    if (result <= 0) return;
+    written += result;
+  }
+}
+
+void drain(int fd, size_t size) {
+  std::vector<uint8_t> buffer(64 * 1024);
+  while (size > 0) {
+    ssize_t result = read(fd, buffer.data(), std::min(size, buffer.size()));
+    if (result <= 0) return;
+    size -= result;
+  }
+}
+
+void report(State& state, int64_t syscalls) {
+  int64_t packets = state.iterations() * kPacketsPerIteration;
+  state.counters["syscalls_per_packet"] = static_cast<double>(syscalls) / packets;
+  state.counters["packets_per_second"] = benchmark::Counter(static_cast<double>(packets), benchmark::Counter::kIsRate);
+  state.SetBytesProcessed(packets * (1 + 4 + state.range(0)));
+}
+}  // namespace
+
+static void BM_H4ReceivePerPacket(State& state) {
+  std::vector<uint8_t> stream = make_h4_stream(state.range(0), kPacketsPerIteration);
+  int64_t syscalls = 0;
+  for (auto _ : state) {
+    int fds[2];
+    socketpair(AF_UNIX, SOCK_STREAM, 0, fds);
+    std::thread writer(write_all, fds[1], std::cref(stream));
+    // Same sequence of reads as the host HAL did: H4 type, HCI header, then payload
+    uint8_t buf[1 + 4 + 65535];
+    for (int i = 0; i < kPacketsPerIteration; i++) {
+      recv_all(fds[0], buf, 1, &syscalls);
+      recv_all(fds[0], buf + 1, 4, &syscalls);
+      recv_all(fds[0], buf + 5, (buf[4] << 8) + buf[3], &syscalls);
+      HciPacket packet(buf + 1, buf + 5 + (buf[4] << 8) + buf[3]);
+      benchmark::DoNotOptimize(packet);
+    }
+    writer.join();
+    close(fds[0]);
+    close(fds[1]);
+  }
+  report(state, syscalls);
+}
+
+static void BM_H4ReceiveFramer(State& state) {
+  std::vector<uint8_t> stream = make_h4_stream(state.range(0), kPacketsPerIteration);
+  int64_t syscalls = 0;
+  for (auto _ : state) {
+    int fds[2];
+    socketpair(AF_UNIX, SOCK_STREAM, 0, fds);
+    std::thread writer(write_all, fds[1], std::cref(stream));
+    H4Framer framer;
+    int received = 0;
+    while (received < kPacketsPerIteration) {
+      // Stands in for the reactor wakeup
+      pollfd poll_fd = {fds[0], POLLIN, 0};
+      poll(&poll_fd, 1, -1);
+      framer.ReadFrom(fds[0]);
+      syscalls += 2;
+      uint8_t h4_type;
+      HciPacket packet;
+      while (framer.Next(&h4_type, &packet)) {
+        benchmark::DoNotOptimize(packet);
+        received++;
+      }
+    }
+    writer.join();
+    close(fds[0]);
+    close(fds[1]);
+  }
+  report(state, syscalls);
+}
+
+static void BM_H4SendPerPacket(State& state) {
+  HciPacket acl = make_acl_packet(state.range(0));
+  int64_t syscalls = 0;
+  for (auto _ : state) {
+    int fds[2];
+    socketpair(AF_UNIX, SOCK_STREAM, 0, fds);
+    std::thread reader(drain, fds[1], kPacketsPerIteration * (1 + acl.size()));
+    for (int i = 0; i < kPacketsPerIteration; i++) {
+      HciPacket packet = acl;
+      packet.insert(packet.cbegin(), kH4Acl);
+      write(fds[0], packet.data(), packet.size());
+      syscalls++;
+    }
+    reader.join();
+    close(fds[0]);
+    close(fds[1]);
+  }
+  report(state, syscalls);
+}
+
+static void BM_H4SendCoalesced(State& state) {
+  HciPacket acl = make_acl_packet(state.range(0));
+  int64_t syscalls = 0;
+  for (auto _ : state) {
+    int fds[2];
+    socketpair(AF_UNIX, SOCK_STREAM, 0, fds);
+    std::thread reader(drain, fds[1], kPacketsPerIteration * (1 + acl.size()));
+    H4OutgoingQueue queue;
+    for (int i = 0; i < kPacketsPerIteration; i++) {
+      queue.Push(kH4Acl, acl);
+    }
+    while (!queue.IsEmpty()) {
+      queue.WriteTo(fds[0]);
+      syscalls++;
+    }
+    reader.join();
+    close(fds[0]);
+    close(fds[1]);
+  }
+  report(state, syscalls);
+}
+
+BENCHMARK(BM_H4ReceivePerPacket)->Arg(27)->Arg(251)->Arg(1021)->UseRealTime();
+BENCHMARK(BM_H4ReceiveFramer)->Arg(27)->Arg(251)->Arg(1021)->UseRealTime();
+BENCHMARK(BM_H4SendPerPacket)->Arg(27)->Arg(251)->Arg(1021)->UseRealTime();
+BENCHMARK(BM_H4SendCoalesced)->Arg(27)->Arg(251)->Arg(1021)->UseRealTime();
+
+}  // namespace hal
+}  // namespace bluetooth
@@ -0,0 +1,253 @@
+/*
+ * Copyright 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "hal/h4_framer.h"
+
+#include <fcntl.h>
+#include <gtest/gtest.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <vector>
+
+namespace bluetooth {
+namespace hal {
+namespace {
+
+constexpr uint8_t kH4Acl = 0x02;
+constexpr uint8_t kH4Sco = 0x03;
+constexpr uint8_t kH4Event = 0x04;
+constexpr uint8_t kH4Iso = 0x05;
+
+using H4Packet = std::vector<uint8_t>;
+
+H4Packet make_h4_evt_pkt(uint8_t parameter_total_length) {
+  H4Packet pkt(1 + 2 + parameter_total_length, 0x01);
+  pkt[0] = kH4Event;
+  pkt[2] = parameter_total_length;
+  return pkt;
+}
+
+H4Packet make_h4_acl_pkt(uint16_t payload_size) {
+  H4Packet pkt(1 + 4 + payload_size, 0x02);
+  pkt[0] = kH4Acl;
+  pkt[3] = payload_size & 0xff;
+  pkt[4] = payload_size >> 8;
+  return pkt;
+}
+
+H4Packet make_h4_sco_pkt(uint8_t payload_size) {
+  H4Packet pkt(1 + 3 + payload_size, 0x03);
+  pkt[0] = kH4Sco;
+  pkt[3] = payload_size;
+  return pkt;
+}
+
+H4Packet make_h4_iso_pkt(uint16_t payload_size) {
+  H4Packet pkt(1 + 4 + payload_size, 0x05);
+  pkt[0] = kH4Iso;
+  pkt[3] = payload_size & 0xff;
+  pkt[4] = 0xc0 | (payload_size >> 8);
+  return pkt;
+}
+
+void expect_next(H4Framer* framer, const H4Packet& expected) {
+  uint8_t h4_type = 0;
+  HciPacket packet;
+  ASSERT_TRUE(framer->Next(&h4_type, &packet));
+  ASSERT_EQ(h4_type, expected[0]);
+  ASSERT_EQ(packet, HciPacket(expected.begin() + 1, expected.end()));
+}
+
+H4Packet read_all(int fd, size_t size) {
+  H4Packet data(size);
+  size_t bytes_read = 0;
+  while (bytes_read < size) {
+    ssize_t result = read(fd, data.data() + bytes_read, size - bytes_read);
+    if (result <= 0) break;
+    bytes_read += result;
+  }
+  data.resize(bytes_read);
+  return data;
+}
+
+TEST(H4FramerTest, multiple_packets_in_one_chunk) {
+  H4Framer framer;
+  std::vector<H4Packet> packets = {make_h4_evt_pkt(3), make_h4_acl_pkt(300), make_h4_sco_pkt(60), make_h4_iso_pkt(5)};
+  H4Packet stream;
+  for (const auto& packet : packets) {
+    stream.insert(stream.end(), packet.begin(), packet.end());
+  }
+  framer.Append(stream.data(), stream.size());
+  for (const auto& packet : packets) {
+    expect_next(&framer, packet);
+  }
+  uint8_t h4_type;
+  HciPacket packet;
+  ASSERT_FALSE(framer.Next(&h4_type, &packet));
+  ASSERT_EQ(framer.BufferedSize(), 0u);
+}
+
+TEST(H4FramerTest, packet_split_across_chunks) {
+  H4Framer framer;
+  H4Packet acl = make_h4_acl_pkt(1021);
+  uint8_t h4_type;
+  HciPacket packet;
+  for (size_t i = 0; i + 1 < acl.size(); i++) {
+    framer.Append(&acl[i], 1);
+    ASSERT_FALSE(framer.Next(&h4_type, &packet)) << "at byte " << i;
+  }
+  framer.Append(&acl.back(), 1);
+  expect_next(&framer, acl);
+}
+
+TEST(H4FramerTest, packet_larger_than_capacity) {
+  H4Framer framer(16);
+  H4Packet acl = make_h4_acl_pkt(1000);
+  H4Packet evt = make_h4_evt_pkt(2);
+  framer.Append(acl.data(), 10);
+  uint8_t h4_type;
+  HciPacket packet;
+  ASSERT_FALSE(framer.Next(&h4_type, &packet));
+  framer.Append(acl.data() + 10, acl.size() - 10);
+  framer.Append(evt.data(), evt.size());
+  expect_next(&framer, acl);
+  expect_next(&framer, evt);
+}
+
+TEST(H4FramerTest, unknown_type_is_dropped) {
+  H4Framer framer;
+  H4Packet evt = make_h4_evt_pkt(4);
+  H4Packet acl = make_h4_acl_pkt(8);
+  H4Packet garbage = {0x00, 0xff, 0x42};
+  H4Packet stream = garbage;
+  stream.insert(stream.end(), evt.begin(), evt.end());
+  stream.push_back(0x07);
+  stream.insert(stream.end(), acl.begin(), acl.end());
+  framer.Append(stream.data(), stream.size());
+  expect_next(&framer, evt);
+  expect_next(&framer, acl);
+  ASSERT_EQ(framer.DroppedSize(), garbage.size() + 1);
+
+  uint8_t h4_type;
+  HciPacket packet;
+  framer.Append(garbage.data(), garbage.size());
+  ASSERT_FALSE(framer.Next(&h4_type, &packet));
+  ASSERT_EQ(framer.BufferedSize(), 0u);
+  ASSERT_EQ(framer.DroppedSize(), 2 * garbage.size() + 1);
+}
+
+TEST(H4FramerTest, read_from_socket) {
+  int fds[2];
+  ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+  std::vector<H4Packet> packets = {make_h4_evt_pkt(10), make_h4_acl_pkt(27), make_h4_acl_pkt(1021)};
+  for (const auto& packet : packets) {
+    ASSERT_EQ(write(fds[1], packet.data(), packet.size()), static_cast<ssize_t>(packet.size()));
+  }
+
+  H4Framer framer;
+  ASSERT_GT(framer.ReadFrom(fds[0]), 0);
+  for (const auto& packet : packets) {
+    expect_next(&framer, packet);
+  }
+  ASSERT_EQ(framer.ReadFrom(fds[0]), -1);
+  ASSERT_EQ(errno, EAGAIN);
+
+  close(fds[1]);
+  ASSERT_EQ(framer.ReadFrom(fds[0]), 0);
+  close(fds[0]);
+}
+
+TEST(H4OutgoingQueueTest, write_coalesces_packets) {
+  int fds[2];
+  ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+  H4OutgoingQueue queue;
+  queue.Push(0x01, {0x03, 0x0c, 0x00});
+  queue.Push(kH4Acl, {0x01, 0x00, 0x02, 0x00, 0xaa, 0xbb});
+  ASSERT_EQ(queue.WriteTo(fds[0]), 11);
+  ASSERT_TRUE(queue.IsEmpty());
+  ASSERT_EQ(read_all(fds[1], 11), H4Packet({0x01, 0x03, 0x0c, 0x00, kH4Acl, 0x01, 0x00, 0x02, 0x00, 0xaa, 0xbb}));
+  close(fds[0]);
+  close(fds[1]);
+}
+
+TEST(H4OutgoingQueueTest, partial_write_resumes) {
+  int fds[2];
+  ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+  int send_buffer_size = 4096;
+  ASSERT_EQ(setsockopt(fds[0], SOL_SOCKET, SO_SNDBUF, &send_buffer_size, sizeof(send_buffer_size)), 0);
+  ASSERT_EQ(fcntl(fds[0], F_SETFL, O_NONBLOCK), 0);
+
+  H4OutgoingQueue queue;
+  H4Packet expected;
+  for (int i = 0; i < 100; i++) {
+    H4Packet acl = make_h4_acl_pkt(1000 + i);
+    acl[5] = i;
+    expected.insert(expected.end(), acl.begin(), acl.end());
+    queue.Push(acl[0], HciPacket(acl.begin() + 1, acl.end()));
+  }
+
+  H4Framer framer;
+  size_t total_written = 0;
+  while (!queue.IsEmpty()) {
+    ssize_t written = queue.WriteTo(fds[0]);
+    if (written == -1) {
+      ASSERT_EQ(errno, EAGAIN);
+    } else {
+      total_written += written;
+    }
+    framer.ReadFrom(fds[1]);
+  }
+  while (framer.ReadFrom(fds[1]) > 0) {
+  }
+  ASSERT_EQ(total_written, expected.size());
+
+  for (int i = 0; i < 100; i++) {
+    uint8_t h4_type;
+    HciPacket packet;
+    ASSERT_TRUE(framer.Next(&h4_type, &packet));
+    ASSERT_EQ(packet.size(), 4u + 1000 + i);
+    ASSERT_EQ(packet[4], i);
+  }
+  close(fds[0]);
+  close(fds[1]);
+}
+
+TEST(H4OutgoingQueueTest, send_keeps_packet_boundaries) {
+  int fds[2];
+  ASSERT_EQ(socketpair(AF_UNIX, SOCK_SEQPACKET, 0, fds), 0);
+  H4OutgoingQueue queue;
+  std::vector<H4Packet> packets = {make_h4_acl_pkt(10), make_h4_sco_pkt(20), make_h4_iso_pkt(30)};
+  for (const auto& packet : packets) {
+    queue.Push(packet[0], HciPacket(packet.begin() + 1, packet.end()));
+  }
+  ASSERT_EQ(queue.SendTo(fds[0]), 3);
+  ASSERT_TRUE(queue.IsEmpty());
+
+  for (const auto& packet : packets) {
+    H4Packet received(2048);
+    ssize_t received_size = recv(fds[1], received.data(), received.size(), 0);
+    ASSERT_EQ(received_size, static_cast<ssize_t>(packet.size()));
+    received.resize(received_size);
+    ASSERT_EQ(received, packet);
+  }
+  close(fds[0]);
+  close(fds[1]);
+}
+
+}  // namespace
+}  // namespace hal
+}  // namespace bluetooth
@@ -26,9 +26,9 @@
 #include <chrono>
 #include <csignal>
 #include <mutex>
-#include <queue>
 
 #include "gd/common/init_flags.h"
+#include "hal/h4_framer.h"
 #include "hal/hci_hal.h"
 #include "hal/mgmt.h"
 #include "hal/snoop_logger.h"
@@ -52,6 +52,7 @@ constexpr uint8_t kHciScoHeaderSize = 3;
 constexpr uint8_t kHciEvtHeaderSize = 2;
 constexpr uint8_t kHciIsoHeaderSize = 4;
 constexpr int kBufSize = 1024 + 4 + 1;  // DeviceProperties::acl_data_packet_size_ + ACL header + H4 header
+constexpr int kMaxPacketsPerRead = 16;
 
 constexpr uint8_t BTPROTO_HCI = 1;
 constexpr uint16_t HCI_CHANNEL_USER = 1;
@@ -236,8 +237,7 @@ class HciHalHost : public HciHal {
     ASSERT(sock_fd_ != INVALID_FD);
     std::vector<uint8_t> packet = std::move(command);
     btsnoop_logger_->Capture(packet, SnoopLogger::Direction::OUTGOING, SnoopLogger::PacketType::CMD);
-    packet.insert(packet.cbegin(), kH4Command);
-    write_to_fd(packet);
+    write_to_fd(kH4Command, std::move(packet));
   }
 
   void sendAclData(HciPacket data) override {
@@ -245,8 +245,7 @@ class HciHalHost : public HciHal {
     ASSERT(sock_fd_ != INVALID_FD);
     std::vector<uint8_t> packet = std::move(data);
     btsnoop_logger_->Capture(packet, SnoopLogger::Direction::OUTGOING, SnoopLogger::PacketType::ACL);
-    packet.insert(packet.cbegin(), kH4Acl);
-    write_to_fd(packet);
+    write_to_fd(kH4Acl, std::move(packet));
   }
 
   void sendScoData(HciPacket data) override {
@@ -254,8 +253,7 @@ class HciHalHost : public HciHal {
     ASSERT(sock_fd_ != INVALID_FD);
     std::vector<uint8_t> packet = std::move(data);
     btsnoop_logger_->Capture(packet, SnoopLogger::Direction::OUTGOING, SnoopLogger::PacketType::SCO);
-    packet.insert(packet.cbegin(), kH4Sco);
-    write_to_fd(packet);
+    write_to_fd(kH4Sco, std::move(packet));
   }
 
   void sendIsoData(HciPacket data) override {
@@ -263,8 +261,7 @@ class HciHalHost : public HciHal {
     ASSERT(sock_fd_ != INVALID_FD);
     std::vector<uint8_t> packet = std::move(data);
     btsnoop_logger_->Capture(packet, SnoopLogger::Direction::OUTGOING, SnoopLogger::PacketType::ISO);
-    packet.insert(packet.cbegin(), kH4Iso);
-    write_to_fd(packet);
+    write_to_fd(kH4Iso, std::move(packet));
   }
 
   uint16_t getMsftOpcode() override {
@@ -325,27 +322,27 @@ class HciHalHost : public HciHal {
   bluetooth::os::Thread hci_incoming_thread_ =
       bluetooth::os::Thread("hci_incoming_thread", bluetooth::os::Thread::Priority::NORMAL);
   bluetooth::os::Reactor::Reactable* reactable_ = nullptr;
-  std::queue<std::vector<uint8_t>> hci_outgoing_queue_;
+  H4OutgoingQueue hci_outgoing_queue_;
+  // Room for kMaxPacketsPerRead packets of kBufSize, reused across reads
+  std::vector<uint8_t> incoming_buffer_ = std::vector<uint8_t>(kMaxPacketsPerRead * kBufSize);
   SnoopLogger* btsnoop_logger_ = nullptr;
 
-  void write_to_fd(HciPacket packet) {
-    // TODO: replace this with new queue when it's ready
-    hci_outgoing_queue_.emplace(packet);
-    if (hci_outgoing_queue_.size() == 1) {
+  void write_to_fd(uint8_t h4_type, HciPacket packet) {
+    hci_outgoing_queue_.Push(h4_type, std::move(packet));
+    if (hci_outgoing_queue_.Size() == 1) {
       hci_incoming_thread_.GetReactor()->ModifyRegistration(reactable_, os::Reactor::REACT_ON_READ_WRITE);
     }
   }
 
   void send_packet_ready() {
     std::lock_guard<std::mutex> lock(api_mutex_);
-    if (hci_outgoing_queue_.empty()) return;
-    auto packet_to_send = hci_outgoing_queue_.front();
-    auto bytes_written = write(sock_fd_, (void*)packet_to_send.data(), packet_to_send.size());
-    hci_outgoing_queue_.pop();
-    if (bytes_written == -1) {
+    if (hci_outgoing_queue_.IsEmpty()) return;
+    // The user channel takes one packet per write, send everything queued so far as a batch of datagrams
+    auto packets_sent = hci_outgoing_queue_.SendTo(sock_fd_);
+    if (packets_sent == -1) {
       abort();
     }
-    if (hci_outgoing_queue_.empty()) {
+    if (hci_outgoing_queue_.IsEmpty()) {
       hci_incoming_thread_.GetReactor()->ModifyRegistration(reactable_, os::Reactor::REACT_ON_READ_ONLY);
     }
   }
@@ -358,17 +355,37 @@ class HciHalHost : public HciHal {
         return;
       }
     }
-    uint8_t buf[kBufSize] = {};
 
-    ssize_t received_size;
-    RUN_NO_INTR(received_size = read(sock_fd_, buf, kBufSize));
-    ASSERT_LOG(received_size != -1, "Can't receive from socket: %s", strerror(errno));
+    // Each message on the user channel is one H4 packet, pick up all the ones already waiting in one syscall
+    iovec iov[kMaxPacketsPerRead];
+    mmsghdr messages[kMaxPacketsPerRead] = {};
+    for (int i = 0; i < kMaxPacketsPerRead; i++) {
+      iov[i] = {incoming_buffer_.data() + i * kBufSize, kBufSize};
+      messages[i].msg_hdr.msg_iov = &iov[i];
+      messages[i].msg_hdr.msg_iovlen = 1;
+    }
+    int received_count;
+    RUN_NO_INTR(received_count = recvmmsg(sock_fd_, messages, kMaxPacketsPerRead, MSG_DONTWAIT, nullptr));
+    if (received_count == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+      return;
+    }
+    ASSERT_LOG(received_count != -1, "Can't receive from socket: %s", strerror(errno));
+
+    for (int i = 0; i < received_count; i++) {
+      if (!handle_incoming_packet(incoming_buffer_.data() + i * kBufSize, messages[i].msg_len)) {
+        return;
+      }
+    }
+  }
+
+  // Returns false when the rest of the batch should be dropped
+  bool handle_incoming_packet(const uint8_t* buf, ssize_t received_size) {
     if (received_size == 0) {
       LOG_WARN("Can't read H4 header. EOF received");
       // First close sock fd before raising sigint
       close(sock_fd_);
       raise(SIGINT);
-      return;
+      return false;
     }
 
     if (buf[0] == kH4Event) {
@@ -389,7 +406,7 @@ class HciHalHost : public HciHal {
         std::lock_guard<std::mutex> incoming_packet_callback_lock(incoming_packet_callback_mutex_);
         if (incoming_packet_callback_ == nullptr) {
           LOG_INFO("Dropping an event after processing");
-          return;
+          return false;
         }
         incoming_packet_callback_->hciEventReceived(receivedHciPacket);
       }
@@ -414,7 +431,7 @@ class HciHalHost : public HciHal {
         std::lock_guard<std::mutex> incoming_packet_callback_lock(incoming_packet_callback_mutex_);
         if (incoming_packet_callback_ == nullptr) {
           LOG_INFO("Dropping an ACL packet after processing");
-          return;
+          return false;
         }
         incoming_packet_callback_->aclDataReceived(receivedHciPacket);
       }
@@ -438,7 +455,7 @@ class HciHalHost : public HciHal {
         std::lock_guard<std::mutex> incoming_packet_callback_lock(incoming_packet_callback_mutex_);
         if (incoming_packet_callback_ == nullptr) {
           LOG_INFO("Dropping a SCO packet after processing");
-          return;
+          return false;
         }
         incoming_packet_callback_->scoDataReceived(receivedHciPacket);
       }
@@ -462,12 +479,12 @@ class HciHalHost : public HciHal {
         std::lock_guard<std::mutex> incoming_packet_callback_lock(incoming_packet_callback_mutex_);
         if (incoming_packet_callback_ == nullptr) {
           LOG_INFO("Dropping a ISO packet after processing");
-          return;
+          return false;
         }
         incoming_packet_callback_->isoDataReceived(receivedHciPacket);
       }
     }
-    memset(buf, 0, kBufSize);
+    return true;
   }
 };
 
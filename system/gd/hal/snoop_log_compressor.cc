@@ -0,0 +1,124 @@
+/*
+ * Copyright 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "hal/snoop_log_compressor.h"
+
+#include <unistd.h>
+
+#include <cstring>
+
+#include "os/log.h"
+#include "os/utils.h"
+
+namespace bluetooth {
+namespace hal {
+
+namespace {
+constexpr size_t kOutputBufferSize = 32 * 1024;
+// Window bits for a gzip header and trailer instead of zlib ones
+constexpr int kGzipWindowBits = 15 + 16;
+constexpr int kMemLevel = 8;
+}  // namespace
+
+SnoopLogCompressor::SnoopLogCompressor(int level) : level_(level), output_(kOutputBufferSize) {}
+
+SnoopLogCompressor::~SnoopLogCompressor() {
+  if (stream_initialized_) {
+    deflateEnd(&stream_);
+  }
+}
+
+void SnoopLogCompressor::Open(int fd) {
+  ASSERT_LOG(!IsOpen(), "Previous stream was not closed");
+  if (!stream_initialized_) {
+    int result = deflateInit2(&stream_, level_, Z_DEFLATED, kGzipWindowBits, kMemLevel, Z_DEFAULT_STRATEGY);
+    ASSERT_LOG(result == Z_OK, "deflateInit2 failed: %d", result);
+    stream_initialized_ = true;
+  } else {
+    // Keeps the allocated window and hash tables
+    deflateReset(&stream_);
+  }
+  fd_ = fd;
+  compressed_size_ = 0;
+  uncompressed_size_ = 0;
+  stream_.next_out = output_.data();
+  stream_.avail_out = output_.size();
+}
+
+bool SnoopLogCompressor::Write(const iovec* data, size_t count) {
+  ASSERT(IsOpen());
+  for (size_t i = 0; i < count; i++) {
+    stream_.next_in = static_cast<Bytef*>(data[i].iov_base);
+    stream_.avail_in = data[i].iov_len;
+    uncompressed_size_ += data[i].iov_len;
+    while (stream_.avail_in > 0) {
+      if (!deflate_and_write(Z_NO_FLUSH)) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+bool SnoopLogCompressor::Flush() {
+  ASSERT(IsOpen());
+  return deflate_and_write(Z_SYNC_FLUSH);
+}
+
+bool SnoopLogCompressor::Close() {
+  if (!IsOpen()) {
+    return true;
+  }
+  bool success = deflate_and_write(Z_FINISH);
+  fd_ = -1;
+  return success;
+}
+
+bool SnoopLogCompressor::deflate_and_write(int flush) {
+  while (true) {
+    int result = deflate(&stream_, flush);
+    if (result == Z_STREAM_ERROR) {
+      LOG_ERROR("deflate failed");
+      return false;
+    }
+
+    // Only write full buffers until asked to flush, unless deflate needs the room
+    size_t pending = output_.size() - stream_.avail_out;
+    bool done = stream_.avail_out != 0 && (flush != Z_NO_FLUSH || stream_.avail_in == 0);
+    if (pending > 0 && (stream_.avail_out == 0 || (done && flush != Z_NO_FLUSH))) {
+      size_t written = 0;
+      while (written < pending) {
+        ssize_t result;
+        RUN_NO_INTR(result = write(fd_, output_.data() + written, pending - written));
+        if (result <= 0) {
+          LOG_ERROR("Failed to write compressed snoop log, error: \"%s\"", strerror(errno));
+          // Drop the buffer rather than retrying forever
+          break;
+        }
+        written += result;
+      }
+      compressed_size_ += pending;
+      stream_.next_out = output_.data();
+      stream_.avail_out = output_.size();
+    }
+    if (done) {
+      return true;
+    }
+  }
+}
+
+}  // namespace hal
+}  // namespace bluetooth
@@ -0,0 +1,81 @@
+/*
+ * Copyright 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <sys/uio.h>
+#include <zlib.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace bluetooth {
+namespace hal {
+
+// Streams btsnoop records into a gzip file, which Wireshark and zcat read directly. Each Flush() ends a deflate block
+// on a byte boundary and writes it out, so a file cut short by a crash decompresses up to the last flush.
+class SnoopLogCompressor {
+ public:
+  // Favor CPU time over compression ratio, most of the gain comes from the repetitive headers anyway
+  static constexpr int kDefaultLevel = Z_BEST_SPEED;
+
+  explicit SnoopLogCompressor(int level = kDefaultLevel);
+  ~SnoopLogCompressor();
+
+  SnoopLogCompressor(const SnoopLogCompressor&) = delete;
+  SnoopLogCompressor& operator=(const SnoopLogCompressor&) = delete;
+
+  // Start a new gzip stream written to |fd|, which stays owned by the caller
+  void Open(int fd);
+
+  // Compress |data|. Compressed output is written whenever a full buffer is available.
+  bool Write(const iovec* data, size_t count);
+
+  // Write out everything compressed so far
+  bool Flush();
+
+  // Terminate the gzip stream, the file descriptor is not closed
+  bool Close();
+
+  bool IsOpen() const {
+    return fd_ != -1;
+  }
+
+  // Bytes written to the current file so far
+  size_t CompressedSize() const {
+    return compressed_size_;
+  }
+
+  // Bytes given to Write() for the current file so far
+  size_t UncompressedSize() const {
+    return uncompressed_size_;
+  }
+
+ private:
+  bool deflate_and_write(int flush);
+
+  int level_;
+  z_stream stream_ = {};
+  bool stream_initialized_ = false;
+  int fd_ = -1;
+  std::vector<uint8_t> output_;
+  size_t compressed_size_ = 0;
+  size_t uncompressed_size_ = 0;
+};
+
+}  // namespace hal
+}  // namespace bluetooth
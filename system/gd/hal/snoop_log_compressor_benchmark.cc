@@ -0,0 +1,232 @@
+/*
+ * Copyright 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <cstdlib>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "common/circular_buffer.h"
+#include "hal/snoop_log_compressor.h"
+#include "hal/snoop_logger.h"
+#include "hal/snooz_buffer.h"
+
+using ::benchmark::State;
+
+namespace bluetooth {
+namespace hal {
+
+// Compares the btsnoop full mode file writes with the compressed, size rotated mode, and the stringstream based snooz
+// history with SnoozBuffer, on a synthetic trace of an A2DP stream with concurrent LE scanning.
+
+namespace {
+constexpr size_t kTraceRecords = 10000;
+constexpr size_t kRecordsPerWrite = 64;
+constexpr size_t kMaxBytesPerFile = 4 * 1024 * 1024;
+constexpr size_t kSnoozMaxBytesPerPacket = 150;
+constexpr size_t kSnoozMaxPackets = 256 * 1024 / kSnoozMaxBytesPerPacket;
+
+struct Record {
+  SnoopLogger::PacketHeaderType header;
+  std::vector<uint8_t> payload;
+};
+
+// Per 20 ms: 3 A2DP media packets of 2 SBC frames with their Number Of Completed Packets events, and 5 LE
+// advertising reports from a handful of advertisers
+std::vector<Record> make_trace() {
+  std::mt19937 random(42);
+  std::vector<Record> trace;
+  uint64_t timestamp_us = 0x00dcddb30f2f8000ULL + 1700000000000000ULL;
+  uint16_t sequence = 0;
+  auto add = [&](SnoopLogger::PacketType type, uint32_t flags, std::vector<uint8_t> payload) {
+    uint32_t length = payload.size() + 1;
+    Record record;
+    record.header = {
+        .length_original = htonl(length),
+        .length_captured = htonl(length),
+        .flags = htonl(flags),
+        .dropped_packets = 0,
+        .timestamp = 0,
+        .type = static_cast<uint8_t>(type)};
+    uint64_t timestamp = timestamp_us;
+    for (int i = 7; i >= 0; i--) {
+      reinterpret_cast<uint8_t*>(&record.header.timestamp)[i] = timestamp & 0xff;
+      timestamp >>= 8;
+    }
+    record.payload = std::move(payload);
+    trace.push_back(std::move(record));
+  };
+
+  while (trace.size() < kTraceRecords) {
+    for (int i = 0; i < 3; i++) {
+      // ACL + L2CAP + AVDTP headers, then SBC frames which don't compress
+      std::vector<uint8_t> acl = {0x01, 0x20, 0xb2, 0x02, 0xae, 0x02, 0x41, 0x00, 0x80, 0x60,
+                                  static_cast<uint8_t>(sequence >> 8), static_cast<uint8_t>(sequence)};
+      sequence++;
+      while (acl.size() < 4 + 0x2b2) {
+        acl.push_back(random());
+      }
+      add(SnoopLogger::PacketType::ACL, 0, std::move(acl));
+      timestamp_us += 2000 + random() % 500;
+      add(SnoopLogger::PacketType::EVT, 3, {0x13, 0x05, 0x01, 0x01, 0x00, 0x01, 0x00});
+      timestamp_us += 3000 + random() % 1000;
+    }
+    for (int i = 0; i < 5; i++) {
+      uint8_t advertiser = random() % 8;
+      std::vector<uint8_t> report = {0x3e, 0x2b, 0x0d, 0x01, 0x13, 0x00, 0x00, advertiser, 0x5a, 0xa5,
+                                     0x11, 0x22, 0x33, 0x01, 0x00, 0xff, 0x7f, static_cast<uint8_t>(0xc0 + random() % 20),
+                                     0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x11, 0x02, 0x01, 0x06,
+                                     0x0d, 0xff, 0x4c, 0x00, 0x10, 0x07, advertiser, 0x1f, 0x2e, 0x3d, 0x4c, 0x5b,
+                                     0x6a};
+      add(SnoopLogger::PacketType::EVT, 3, std::move(report));
+      timestamp_us += 1000 + random() % 500;
+    }
+  }
+  return trace;
+}
+
+int open_log_file(const std::string& path) {
+  return open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, S_IRUSR | S_IWUSR);
+}
+
+void rewind_log_file(int fd) {
+  ftruncate(fd, 0);
+  lseek(fd, 0, SEEK_SET);
+}
+
+std::string log_path(const char* name) {
+  const char* tmp = getenv("TMPDIR");
+  return std::string(tmp != nullptr ? tmp : "/tmp") + "/" + name;
+}
+
+void report(State& state, const std::vector<Record>& trace, size_t bytes_written) {
+  int64_t bytes = 0;
+  for (const auto& record : trace) {
+    bytes += sizeof(record.header) + record.payload.size();
+  }
+  state.counters["packets_per_second"] =
+      benchmark::Counter(static_cast<double>(state.iterations() * trace.size()), benchmark::Counter::kIsRate);
+  state.counters["disk_bytes_per_input_byte"] = static_cast<double>(bytes_written) / (state.iterations() * bytes);
+  state.SetBytesProcessed(state.iterations() * bytes);
+}
+}  // namespace
+
+static void BM_SnoopLogWriteUncompressed(State& state) {
+  std::vector<Record> trace = make_trace();
+  std::string path = log_path("snoop_log_benchmark_uncompressed.log");
+  int fd = open_log_file(path);
+  size_t bytes_written = 0;
+  for (auto _ : state) {
+    rewind_log_file(fd);
+    for (size_t i = 0; i < trace.size(); i += kRecordsPerWrite) {
+      iovec iov[2 * kRecordsPerWrite];
+      size_t count = 0;
+      for (size_t j = i; j < std::min(i + kRecordsPerWrite, trace.size()); j++) {
+        iov[count++] = {&trace[j].header, sizeof(trace[j].header)};
+        iov[count++] = {trace[j].payload.data(), trace[j].payload.size()};
+      }
+      ssize_t written = writev(fd, iov, count);
+      bytes_written += written > 0 ? written : 0;
+    }
+  }
+  close(fd);
+  unlink(path.c_str());
+  report(state, trace, bytes_written);
+}
+
+static void BM_SnoopLogWriteCompressed(State& state) {
+  std::vector<Record> trace = make_trace();
+  std::string path = log_path("snoop_log_benchmark_compressed.log.gz");
+  int fd = open_log_file(path);
+  SnoopLogCompressor compressor(state.range(0));
+  size_t bytes_written = 0;
+  for (auto _ : state) {
+    rewind_log_file(fd);
+    compressor.Open(fd);
+    for (size_t i = 0; i < trace.size(); i += kRecordsPerWrite) {
+      // Same rotation as SnoopLogger::WriteRecords
+      if (compressor.CompressedSize() >= kMaxBytesPerFile) {
+        compressor.Close();
+        bytes_written += compressor.CompressedSize();
+        rewind_log_file(fd);
+        compressor.Open(fd);
+      }
+      iovec iov[2 * kRecordsPerWrite];
+      size_t count = 0;
+      for (size_t j = i; j < std::min(i + kRecordsPerWrite, trace.size()); j++) {
+        iov[count++] = {&trace[j].header, sizeof(trace[j].header)};
+        iov[count++] = {trace[j].payload.data(), trace[j].payload.size()};
+      }
+      compressor.Write(iov, count);
+      // The writer thread flushes once per wakeup, so at most once per batch
+      compressor.Flush();
+    }
+    compressor.Close();
+    bytes_written += compressor.CompressedSize();
+  }
+  close(fd);
+  unlink(path.c_str());
+  report(state, trace, bytes_written);
+}
+
+static void BM_SnoozPushStringstream(State& state) {
+  std::vector<Record> trace = make_trace();
+  common::CircularBuffer<std::string> buffer(kSnoozMaxPackets);
+  for (auto _ : state) {
+    for (const auto& record : trace) {
+      std::stringstream ss;
+      ss.write(reinterpret_cast<const char*>(&record.header), sizeof(record.header));
+      ss.write(
+          reinterpret_cast<const char*>(record.payload.data()),
+          std::min(record.payload.size(), kSnoozMaxBytesPerPacket - sizeof(record.header)));
+      buffer.Push(ss.str());
+    }
+  }
+  state.counters["packets_per_second"] =
+      benchmark::Counter(static_cast<double>(state.iterations() * trace.size()), benchmark::Counter::kIsRate);
+}
+
+static void BM_SnoozPushBuffer(State& state) {
+  std::vector<Record> trace = make_trace();
+  SnoozBuffer buffer(kSnoozMaxPackets * kSnoozMaxBytesPerPacket);
+  for (auto _ : state) {
+    for (const auto& record : trace) {
+      buffer.Push(
+          &record.header,
+          sizeof(record.header),
+          record.payload.data(),
+          std::min(record.payload.size(), kSnoozMaxBytesPerPacket - sizeof(record.header)));
+    }
+  }
+  state.counters["packets_per_second"] =
+      benchmark::Counter(static_cast<double>(state.iterations() * trace.size()), benchmark::Counter::kIsRate);
+  state.counters["retained_packets"] = buffer.RecordCount();
+}
+
+BENCHMARK(BM_SnoopLogWriteUncompressed)->UseRealTime();
+BENCHMARK(BM_SnoopLogWriteCompressed)->Arg(Z_BEST_SPEED)->Arg(Z_DEFAULT_COMPRESSION)->UseRealTime();
+BENCHMARK(BM_SnoozPushStringstream);
+BENCHMARK(BM_SnoozPushBuffer);
+
+}  // namespace hal
+}  // namespace bluetooth
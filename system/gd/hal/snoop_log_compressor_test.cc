@@ -0,0 +1,136 @@
+/*
+ * Copyright 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "hal/snoop_log_compressor.h"
+
+#include <fcntl.h>
+#include <gtest/gtest.h>
+#include <unistd.h>
+#include <zlib.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+namespace bluetooth {
+namespace hal {
+namespace {
+
+class SnoopLogCompressorTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    const testing::TestInfo* const test_info = testing::UnitTest::GetInstance()->current_test_info();
+    path_ = std::filesystem::temp_directory_path() / (std::string(test_info->name()) + "_btsnoop_hci.log.gz");
+    fd_ = open(path_.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, S_IRUSR | S_IWUSR);
+    ASSERT_NE(fd_, -1);
+  }
+
+  void TearDown() override {
+    close(fd_);
+    std::filesystem::remove(path_);
+  }
+
+  std::vector<uint8_t> ReadCompressed() {
+    std::ifstream file(path_, std::ios::binary);
+    return std::vector<uint8_t>(std::istreambuf_iterator<char>(file), {});
+  }
+
+  // Inflates the file as far as it goes, like a reader of a file cut short by a crash
+  std::vector<uint8_t> Decompress() {
+    std::vector<uint8_t> compressed = ReadCompressed();
+    z_stream stream = {};
+    EXPECT_EQ(inflateInit2(&stream, 15 + 16), Z_OK);
+    stream.next_in = compressed.data();
+    stream.avail_in = compressed.size();
+    std::vector<uint8_t> output;
+    uint8_t buffer[4096];
+    int result;
+    do {
+      stream.next_out = buffer;
+      stream.avail_out = sizeof(buffer);
+      result = inflate(&stream, Z_NO_FLUSH);
+      output.insert(output.end(), buffer, buffer + sizeof(buffer) - stream.avail_out);
+    } while (result == Z_OK && stream.avail_out == 0);
+    inflateEnd(&stream);
+    return output;
+  }
+
+  std::filesystem::path path_;
+  int fd_ = -1;
+};
+
+std::vector<uint8_t> make_records(size_t count) {
+  std::vector<uint8_t> data;
+  for (size_t i = 0; i < count; i++) {
+    // Mostly constant headers followed by a varying payload, like HCI traffic
+    uint8_t record[] = {0x00, 0x00, 0x00, 0x2a, 0x00, 0x00, 0x00, 0x2a, 0x02, 0x01, 0x20, 0x00,
+                        static_cast<uint8_t>(i), static_cast<uint8_t>(i >> 8), 0x40, 0x00};
+    data.insert(data.end(), std::begin(record), std::end(record));
+  }
+  return data;
+}
+
+TEST_F(SnoopLogCompressorTest, close_produces_valid_gzip) {
+  std::vector<uint8_t> data = make_records(1000);
+  SnoopLogCompressor compressor;
+  compressor.Open(fd_);
+  iovec iov[] = {{data.data(), 100}, {data.data() + 100, data.size() - 100}};
+  ASSERT_TRUE(compressor.Write(iov, 2));
+  ASSERT_TRUE(compressor.Close());
+  ASSERT_FALSE(compressor.IsOpen());
+
+  ASSERT_EQ(compressor.UncompressedSize(), data.size());
+  ASSERT_EQ(compressor.CompressedSize(), std::filesystem::file_size(path_));
+  ASSERT_LT(compressor.CompressedSize(), data.size() / 4);
+  ASSERT_EQ(Decompress(), data);
+}
+
+TEST_F(SnoopLogCompressorTest, flush_makes_data_readable_before_close) {
+  std::vector<uint8_t> data = make_records(100);
+  SnoopLogCompressor compressor;
+  compressor.Open(fd_);
+  iovec iov = {data.data(), data.size()};
+  ASSERT_TRUE(compressor.Write(&iov, 1));
+  ASSERT_TRUE(compressor.Flush());
+
+  ASSERT_EQ(compressor.CompressedSize(), std::filesystem::file_size(path_));
+  ASSERT_EQ(Decompress(), data);
+  ASSERT_TRUE(compressor.Close());
+}
+
+TEST_F(SnoopLogCompressorTest, reopen_starts_a_new_stream) {
+  std::vector<uint8_t> data = make_records(10);
+  SnoopLogCompressor compressor;
+  compressor.Open(fd_);
+  iovec iov = {data.data(), data.size()};
+  ASSERT_TRUE(compressor.Write(&iov, 1));
+  ASSERT_TRUE(compressor.Close());
+
+  ASSERT_EQ(ftruncate(fd_, 0), 0);
+  ASSERT_EQ(lseek(fd_, 0, SEEK_SET), 0);
+  compressor.Open(fd_);
+  ASSERT_EQ(compressor.CompressedSize(), 0u);
+  ASSERT_TRUE(compressor.Write(&iov, 1));
+  ASSERT_TRUE(compressor.Close());
+  ASSERT_EQ(Decompress(), data);
+}
+
+}  // namespace
+}  // namespace hal
+}  // namespace bluetooth
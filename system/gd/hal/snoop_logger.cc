@@ -17,14 +17,15 @@
 #include "hal/snoop_logger.h"
 
 #include <arpa/inet.h>
+#include <fcntl.h>
 #include <sys/stat.h>
+#include <unistd.h>
 
 #include <algorithm>
 #include <bitset>
 #include <chrono>
-#include <sstream>
+#include <cstring>
 
-#include "common/circular_buffer.h"
 #include "common/init_flags.h"
 #include "common/strings.h"
 #include "hal/snoop_logger_common.h"
@@ -34,6 +35,8 @@
 #include "os/log.h"
 #include "os/parameter_provider.h"
 #include "os/system_properties.h"
+#include "os/utils.h"
+#include "snoop_logger_generated.h"
 
 namespace bluetooth {
 #ifdef USE_FAKE_TIMERS
@@ -330,6 +333,23 @@ std::string get_last_log_path(std::string log_file_path) {
   return log_file_path.append(".last");
 }
 
+// Compressed logs are named btsnoop_hci.log.gz, btsnoop_hci.log.1.gz, ... from the newest to the oldest
+std::string get_compressed_log_path(std::string log_file_path, size_t index) {
+  if (index > 0) {
+    log_file_path.append(".").append(std::to_string(index));
+  }
+  return log_file_path.append(".gz");
+}
+
+void delete_compressed_btsnoop_files(const std::string& log_path) {
+  // Rotated files are numbered without gaps
+  for (size_t index = 0; os::FileExists(get_compressed_log_path(log_path, index)); index++) {
+    if (!os::RemoveFile(get_compressed_log_path(log_path, index))) {
+      LOG_ERROR("Failed to remove compressed log file at \"%s\"", get_compressed_log_path(log_path, index).c_str());
+    }
+  }
+}
+
 void delete_btsnoop_files(const std::string& log_path) {
   LOG_INFO("Deleting logs if they exist");
   if (os::FileExists(log_path)) {
@@ -432,6 +452,8 @@ size_t get_btsnooz_packet_length_to_write(
 
 // system properties
 const std::string SnoopLogger::kBtSnoopMaxPacketsPerFileProperty = "persist.bluetooth.btsnoopsize";
+const std::string SnoopLogger::kBtSnoopMaxBytesPerCompressedFileProperty = "persist.bluetooth.btsnoopcompressedsize";
+const std::string SnoopLogger::kBtSnoopMaxCompressedFilesProperty = "persist.bluetooth.btsnoopcompressedfiles";
 const std::string SnoopLogger::kIsDebuggableProperty = "ro.debuggable";
 const std::string SnoopLogger::kBtSnoopLogModeProperty = "persist.bluetooth.btsnooplogmode";
 const std::string SnoopLogger::kBtSnoopDefaultLogModeProperty = "persist.bluetooth.btsnoopdefaultmode";
@@ -457,6 +479,8 @@ const std::string SnoopLogger::kSoCManufacturerProperty = "ro.soc.manufacturer";
 const std::string SnoopLogger::kBtSnoopLogModeDisabled = "disabled";
 const std::string SnoopLogger::kBtSnoopLogModeFiltered = "filtered";
 const std::string SnoopLogger::kBtSnoopLogModeFull = "full";
+// Same content as full, gzip compressed and rotated by size
+const std::string SnoopLogger::kBtSnoopLogModeCompressed = "compressed";
 // ro.soc.manufacturer
 const std::string SnoopLogger::kSoCManufacturerQualcomm = "Qualcomm";
 
@@ -485,11 +509,16 @@ SnoopLogger::SnoopLogger(
     bool qualcomm_debug_log_enabled,
     const std::chrono::milliseconds snooz_log_life_time,
     const std::chrono::milliseconds snooz_log_delete_alarm_interval,
-    bool snoop_log_persists)
+    bool snoop_log_persists,
+    size_t max_bytes_per_compressed_file,
+    size_t max_compressed_files)
     : snoop_log_path_(std::move(snoop_log_path)),
       snooz_log_path_(std::move(snooz_log_path)),
       max_packets_per_file_(max_packets_per_file),
-      btsnooz_buffer_(max_packets_per_buffer),
+      max_bytes_per_compressed_file_(max_bytes_per_compressed_file),
+      max_compressed_files_(std::max<size_t>(max_compressed_files, 1)),
+      // Records are stored with their actual size, so the buffer holds more packets than this in practice
+      btsnooz_buffer_(max_packets_per_buffer * kDefaultBtSnoozMaxBytesPerPacket),
       qualcomm_debug_log_enabled_(qualcomm_debug_log_enabled),
       snooz_log_life_time_(snooz_log_life_time),
       snooz_log_delete_alarm_interval_(snooz_log_delete_alarm_interval),
@@ -506,21 +535,33 @@ SnoopLogger::SnoopLogger(
     EnableFilters();
     // delete unfiltered logs
     delete_btsnoop_files(get_btsnoop_log_path(snoop_log_path_, false));
+    delete_compressed_btsnoop_files(snoop_log_path_);
     // delete snooz logs
     delete_btsnoop_files(snooz_log_path_);
   } else if (btsnoop_mode_ == kBtSnoopLogModeFull) {
     LOG_INFO("Snoop Logs full mode enabled");
     if (!snoop_log_persists) {
-      // delete filtered logs
+      // delete filtered and compressed logs
       delete_btsnoop_files(get_btsnoop_log_path(snoop_log_path_, true));
+      delete_compressed_btsnoop_files(snoop_log_path_);
+      // delete snooz logs
+      delete_btsnoop_files(snooz_log_path_);
+    }
+  } else if (btsnoop_mode_ == kBtSnoopLogModeCompressed) {
+    LOG_INFO("Snoop Logs compressed mode enabled");
+    if (!snoop_log_persists) {
+      // delete both filtered and unfiltered uncompressed logs
+      delete_btsnoop_files(get_btsnoop_log_path(snoop_log_path_, true));
+      delete_btsnoop_files(get_btsnoop_log_path(snoop_log_path_, false));
       // delete snooz logs
       delete_btsnoop_files(snooz_log_path_);
     }
   } else {
     LOG_INFO("Snoop Logs disabled");
-    // delete both filtered and unfiltered logs
+    // delete filtered, unfiltered and compressed logs
     delete_btsnoop_files(get_btsnoop_log_path(snoop_log_path_, true));
     delete_btsnoop_files(get_btsnoop_log_path(snoop_log_path_, false));
+    delete_compressed_btsnoop_files(snoop_log_path_);
   }
 
   snoop_logger_socket_thread_ = nullptr;
@@ -530,16 +571,60 @@ SnoopLogger::SnoopLogger(
 }
 
 void SnoopLogger::CloseCurrentSnoopLogFile() {
-  std::lock_guard<std::recursive_mutex> lock(file_mutex_);
-  if (btsnoop_ostream_.is_open()) {
-    btsnoop_ostream_.flush();
-    btsnoop_ostream_.close();
+  if (compressor_.IsOpen() && !compressor_.Close()) {
+    LOG_ERROR("Failed to terminate compressed snoop log");
+  }
+  if (btsnoop_fd_ != -1) {
+    close(btsnoop_fd_);
+    btsnoop_fd_ = -1;
   }
   packet_counter_ = 0;
 }
 
+void SnoopLogger::OpenNextCompressedSnoopLogFile() {
+  CloseCurrentSnoopLogFile();
+
+  // Shift the previous files by one, dropping the oldest
+  auto oldest_file_path = get_compressed_log_path(snoop_log_path_, max_compressed_files_ - 1);
+  if (os::FileExists(oldest_file_path) && !os::RemoveFile(oldest_file_path)) {
+    LOG_ERROR("Failed to remove oldest compressed log file at \"%s\"", oldest_file_path.c_str());
+  }
+  for (size_t index = max_compressed_files_ - 1; index > 0; index--) {
+    auto file_path = get_compressed_log_path(snoop_log_path_, index - 1);
+    if (os::FileExists(file_path) && !os::RenameFile(file_path, get_compressed_log_path(snoop_log_path_, index))) {
+      LOG_ERROR("Unable to rename existing compressed snoop log \"%s\"", file_path.c_str());
+    }
+  }
+
+  auto file_path = get_compressed_log_path(snoop_log_path_, 0);
+  mode_t prevmask = umask(0);
+  RUN_NO_INTR(
+      btsnoop_fd_ = open(
+          file_path.c_str(),
+          O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC,
+          S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP | S_IROTH | S_IWOTH));
+#ifdef USE_FAKE_TIMERS
+  file_creation_time = fake_timerfd_get_clock();
+#endif
+  if (btsnoop_fd_ == -1) {
+    LOG_ALWAYS_FATAL("Unable to open snoop log at \"%s\", error: \"%s\"", file_path.c_str(), strerror(errno));
+  }
+  umask(prevmask);
+  compressor_.Open(btsnoop_fd_);
+  iovec file_header = {
+      const_cast<SnoopLoggerCommon::FileHeaderType*>(&SnoopLoggerCommon::kBtSnoopFileHeader),
+      sizeof(SnoopLoggerCommon::FileHeaderType)};
+  if (!compressor_.Write(&file_header, 1)) {
+    LOG_ALWAYS_FATAL("Unable to write file header to \"%s\"", file_path.c_str());
+  }
+}
+
 void SnoopLogger::OpenNextSnoopLogFile() {
-  std::lock_guard<std::recursive_mutex> lock(file_mutex_);
+  if (btsnoop_mode_ == kBtSnoopLogModeCompressed) {
+    OpenNextCompressedSnoopLogFile();
+    return;
+  }
+
   CloseCurrentSnoopLogFile();
 
   auto last_file_path = get_last_log_path(snoop_log_path_);
@@ -556,22 +641,155 @@ void SnoopLogger::OpenNextSnoopLogFile() {
   }
 
   mode_t prevmask = umask(0);
-  // do not use std::ios::app as we want override the existing file
-  btsnoop_ostream_.open(snoop_log_path_, std::ios::binary | std::ios::out);
+  // do not use O_APPEND as we want override the existing file
+  RUN_NO_INTR(
+      btsnoop_fd_ = open(
+          snoop_log_path_.c_str(),
+          O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC,
+          S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP | S_IROTH | S_IWOTH));
 #ifdef USE_FAKE_TIMERS
   file_creation_time = fake_timerfd_get_clock();
 #endif
-  if (!btsnoop_ostream_.good()) {
+  if (btsnoop_fd_ == -1) {
     LOG_ALWAYS_FATAL("Unable to open snoop log at \"%s\", error: \"%s\"", snoop_log_path_.c_str(), strerror(errno));
   }
   umask(prevmask);
-  if (!btsnoop_ostream_.write(
-          reinterpret_cast<const char*>(&SnoopLoggerCommon::kBtSnoopFileHeader),
-          sizeof(SnoopLoggerCommon::FileHeaderType))) {
+  ssize_t written;
+  RUN_NO_INTR(
+      written = write(btsnoop_fd_, &SnoopLoggerCommon::kBtSnoopFileHeader, sizeof(SnoopLoggerCommon::FileHeaderType)));
+  if (written != sizeof(SnoopLoggerCommon::FileHeaderType)) {
     LOG_ALWAYS_FATAL("Unable to write file header to \"%s\", error: \"%s\"", snoop_log_path_.c_str(), strerror(errno));
   }
-  if (!btsnoop_ostream_.flush()) {
-    LOG_ERROR("Failed to flush, error: \"%s\"", strerror(errno));
+}
+
+size_t SnoopLogger::FilterRecords(const iovec* records, size_t count, iovec* filtered) {
+  size_t filtered_count = 0;
+  for (size_t i = 0; i < count; i++) {
+    // Filter each record with the filters in place when it was captured
+    ApplyFilterChanges(filtered_records_++);
+
+    PacketHeaderType header;
+    std::memcpy(&header, records[i].iov_base, sizeof(PacketHeaderType));
+    if (header.type != PacketType::ACL) {
+      filtered[filtered_count++] = records[i];
+      continue;
+    }
+
+    const uint8_t* payload = static_cast<const uint8_t*>(records[i].iov_base) + sizeof(PacketHeaderType);
+    HciPacket& packet = filter_packets_[i];
+    packet.assign(payload, payload + records[i].iov_len - sizeof(PacketHeaderType));
+    Direction direction = (ntohl(header.flags) & 1) ? Direction::INCOMING : Direction::OUTGOING;
+    uint32_t length = ntohl(header.length_original);
+    FilterCapturedPacket(packet, direction, PacketType::ACL, length, header);
+    if (length == 0) {
+      continue;
+    }
+
+    std::vector<uint8_t>& record = filter_records_[i];
+    // Long packets may have been truncated by Capture()
+    size_t payload_size = std::min<size_t>(length - PACKET_TYPE_LENGTH, packet.size());
+    header.length_captured = htonl(payload_size + PACKET_TYPE_LENGTH);
+    record.resize(sizeof(PacketHeaderType) + payload_size);
+    std::memcpy(record.data(), &header, sizeof(PacketHeaderType));
+    std::memcpy(record.data() + sizeof(PacketHeaderType), packet.data(), payload_size);
+    filtered[filtered_count++] = {record.data(), record.size()};
+  }
+  ApplyFilterChanges(filtered_records_);
+  return filtered_count;
+}
+
+void SnoopLogger::ChangeFilters(std::function<void()> change) {
+  {
+    std::lock_guard<std::mutex> lock(filter_changes_mutex_);
+    if (defer_filter_changes_) {
+      filter_changes_.emplace_back(snoop_logger_writer_->GetPushedRecords(), std::move(change));
+      return;
+    }
+  }
+  change();
+}
+
+void SnoopLogger::ApplyFilterChanges(size_t records) {
+  std::lock_guard<std::mutex> lock(filter_changes_mutex_);
+  while (!filter_changes_.empty() && filter_changes_.front().first <= records) {
+    filter_changes_.front().second();
+    filter_changes_.pop_front();
+  }
+}
+
+void SnoopLogger::WriteRecords(const iovec* records, size_t count) {
+  iovec filtered[SnoopLoggerWriter::kMaxRecordsPerWrite];
+  if (btsnoop_mode_ == kBtSnoopLogModeFiltered) {
+    count = FilterRecords(records, count, filtered);
+    records = filtered;
+  }
+
+  if (btsnoop_mode_ == kBtSnoopLogModeCompressed) {
+    // The compressed size only grows as deflate output is written out, files end up slightly over the limit
+    if (compressor_.CompressedSize() >= max_bytes_per_compressed_file_) {
+      OpenNextSnoopLogFile();
+    }
+    if (!compressor_.Write(records, count)) {
+      LOG_ERROR("Failed to compress packets for btsnoop");
+    }
+    WriteRecordsToSocket(records, count);
+    packet_counter_ += count;
+    return;
+  }
+
+  while (count > 0) {
+    if (packet_counter_ >= max_packets_per_file_ && packet_counter_ > 0) {
+      OpenNextSnoopLogFile();
+    }
+    size_t batch = std::min(count, std::max<size_t>(max_packets_per_file_ - packet_counter_, 1));
+
+    // write() to a regular file only stops short on error, but handle partial writes anyway
+    iovec iov[SnoopLoggerWriter::kMaxRecordsPerWrite];
+    std::copy(records, records + batch, iov);
+    iovec* remaining = iov;
+    size_t remaining_count = batch;
+    while (remaining_count > 0) {
+      ssize_t written;
+      RUN_NO_INTR(written = writev(btsnoop_fd_, remaining, remaining_count));
+      if (written <= 0) {
+        LOG_ERROR("Failed to write packets for btsnoop, error: \"%s\"", strerror(errno));
+        break;
+      }
+      while (remaining_count > 0 && static_cast<size_t>(written) >= remaining->iov_len) {
+        written -= remaining->iov_len;
+        remaining++;
+        remaining_count--;
+      }
+      if (remaining_count > 0) {
+        remaining->iov_base = static_cast<uint8_t*>(remaining->iov_base) + written;
+        remaining->iov_len -= written;
+      }
+    }
+
+    WriteRecordsToSocket(records, batch);
+    packet_counter_ += batch;
+    records += batch;
+    count -= batch;
+  }
+}
+
+void SnoopLogger::WriteRecordsToSocket(const iovec* records, size_t count) {
+  SnoopLoggerSocketInterface* socket = socket_.load();
+  if (socket == nullptr) {
+    return;
+  }
+  for (size_t i = 0; i < count; i++) {
+    socket->Write(records[i].iov_base, sizeof(PacketHeaderType));
+    socket->Write(
+        static_cast<uint8_t*>(records[i].iov_base) + sizeof(PacketHeaderType),
+        records[i].iov_len - sizeof(PacketHeaderType));
+  }
+}
+
+void SnoopLogger::FlushRecords() {
+  // Uncompressed records are already written
+  if (compressor_.IsOpen() && !compressor_.Flush()) {
+    LOG_ERROR("Failed to flush compressed snoop log");
   }
 }
 
@@ -881,17 +1099,18 @@ void SnoopLogger::AcceptlistL2capChannel(
       !IsFilterEnabled(kBtSnoopLogFilterProfileRfcommProperty)) {
     return;
   }
-
   LOG_DEBUG(
       "Acceptlisting l2cap channel: conn_handle=%d, local cid=%d, remote cid=%d",
       conn_handle,
       local_cid,
       remote_cid);
-  std::lock_guard<std::mutex> lock(filter_tracker_list_mutex);
+  ChangeFilters([conn_handle, local_cid, remote_cid]() {
+    std::lock_guard<std::mutex> lock(filter_tracker_list_mutex);
 
-  // This will create the entry if there is no associated filter with the
-  // connection.
-  filter_tracker_list[conn_handle].AddL2capCid(local_cid, remote_cid);
+    // This will create the entry if there is no associated filter with the
+    // connection.
+    filter_tracker_list[conn_handle].AddL2capCid(local_cid, remote_cid);
+  });
 }
 
 void SnoopLogger::AcceptlistRfcommDlci(uint16_t conn_handle, uint16_t local_cid, uint8_t dlci) {
@@ -899,11 +1118,12 @@ void SnoopLogger::AcceptlistRfcommDlci(uint16_t conn_handle, uint16_t local_cid,
       !IsFilterEnabled(kBtSnoopLogFilterProfileRfcommProperty)) {
     return;
   }
-
   LOG_DEBUG("Acceptlisting rfcomm channel: local cid=%d, dlci=%d", local_cid, dlci);
-  std::lock_guard<std::mutex> lock(filter_tracker_list_mutex);
+  ChangeFilters([conn_handle, dlci]() {
+    std::lock_guard<std::mutex> lock(filter_tracker_list_mutex);
 
-  filter_tracker_list[conn_handle].AddRfcommDlci(dlci);
+    filter_tracker_list[conn_handle].AddRfcommDlci(dlci);
+  });
 }
 
 void SnoopLogger::AddRfcommL2capChannel(
@@ -912,16 +1132,17 @@ void SnoopLogger::AddRfcommL2capChannel(
       !IsFilterEnabled(kBtSnoopLogFilterProfileRfcommProperty)) {
     return;
   }
-
   LOG_DEBUG(
       "Rfcomm data going over l2cap channel: conn_handle=%d local cid=%d remote cid=%d",
       conn_handle,
       local_cid,
       remote_cid);
-  std::lock_guard<std::mutex> lock(filter_tracker_list_mutex);
+  ChangeFilters([conn_handle, local_cid, remote_cid]() {
+    std::lock_guard<std::mutex> lock(filter_tracker_list_mutex);
 
-  filter_tracker_list[conn_handle].SetRfcommCid(local_cid, remote_cid);
-  local_cid_to_acl.insert({local_cid, conn_handle});
+    filter_tracker_list[conn_handle].SetRfcommCid(local_cid, remote_cid);
+    local_cid_to_acl.insert({local_cid, conn_handle});
+  });
 }
 
 void SnoopLogger::ClearL2capAcceptlist(
@@ -930,15 +1151,16 @@ void SnoopLogger::ClearL2capAcceptlist(
       !IsFilterEnabled(kBtSnoopLogFilterProfileRfcommProperty)) {
     return;
   }
-
   LOG_DEBUG(
       "Clearing acceptlist from l2cap channel. conn_handle=%d local cid=%d remote cid=%d",
       conn_handle,
       local_cid,
       remote_cid);
-  std::lock_guard<std::mutex> lock(filter_tracker_list_mutex);
+  ChangeFilters([conn_handle, local_cid, remote_cid]() {
+    std::lock_guard<std::mutex> lock(filter_tracker_list_mutex);
 
-  filter_tracker_list[conn_handle].RemoveL2capCid(local_cid, remote_cid);
+    filter_tracker_list[conn_handle].RemoveL2capCid(local_cid, remote_cid);
+  });
 }
 
 bool SnoopLogger::IsA2dpMediaChannel(uint16_t conn_handle, uint16_t cid, bool is_local_cid) {
@@ -980,16 +1202,17 @@ void SnoopLogger::AddA2dpMediaChannel(
       !IsFilterEnabled(kBtSnoopLogFilterProfileA2dpProperty)) {
     return;
   }
-
-  if (!SnoopLogger::IsA2dpMediaChannel(conn_handle, local_cid, true)) {
-    LOG_INFO(
-        "Add A2DP media channel filtering. conn_handle=%d local cid=%d remote cid=%d",
-        conn_handle,
-        local_cid,
-        remote_cid);
-    std::lock_guard<std::mutex> lock(a2dpMediaChannels_mutex);
-    a2dpMediaChannels.push_back({conn_handle, local_cid, remote_cid});
-  }
+  ChangeFilters([this, conn_handle, local_cid, remote_cid]() {
+    if (!SnoopLogger::IsA2dpMediaChannel(conn_handle, local_cid, true)) {
+      LOG_INFO(
+          "Add A2DP media channel filtering. conn_handle=%d local cid=%d remote cid=%d",
+          conn_handle,
+          local_cid,
+          remote_cid);
+      std::lock_guard<std::mutex> lock(a2dpMediaChannels_mutex);
+      a2dpMediaChannels.push_back({conn_handle, local_cid, remote_cid});
+    }
+  });
 }
 
 void SnoopLogger::RemoveA2dpMediaChannel(uint16_t conn_handle, uint16_t local_cid) {
@@ -997,16 +1220,17 @@ void SnoopLogger::RemoveA2dpMediaChannel(uint16_t conn_handle, uint16_t local_ci
       !IsFilterEnabled(kBtSnoopLogFilterProfileA2dpProperty)) {
     return;
   }
-
-  std::lock_guard<std::mutex> lock(a2dpMediaChannels_mutex);
-  a2dpMediaChannels.erase(
-      std::remove_if(
-          a2dpMediaChannels.begin(),
-          a2dpMediaChannels.end(),
-          [conn_handle, local_cid](auto& el) {
-            return (el.conn_handle == conn_handle && el.local_cid == local_cid);
-          }),
-      a2dpMediaChannels.end());
+  ChangeFilters([conn_handle, local_cid]() {
+    std::lock_guard<std::mutex> lock(a2dpMediaChannels_mutex);
+    a2dpMediaChannels.erase(
+        std::remove_if(
+            a2dpMediaChannels.begin(),
+            a2dpMediaChannels.end(),
+            [conn_handle, local_cid](auto& el) {
+              return (el.conn_handle == conn_handle && el.local_cid == local_cid);
+            }),
+        a2dpMediaChannels.end());
+  });
 }
 
 void SnoopLogger::SetRfcommPortOpen(
@@ -1016,43 +1240,44 @@ void SnoopLogger::SetRfcommPortOpen(
        !IsFilterEnabled(kBtSnoopLogFilterProfileMapModeProperty))) {
     return;
   }
+  ChangeFilters([this, conn_handle, local_cid, dlci, uuid, flow]() {
+    std::lock_guard<std::mutex> lock(profiles_filter_mutex);
 
-  std::lock_guard<std::mutex> lock(profiles_filter_mutex);
-
-  profile_type_t profile = FILTER_PROFILE_NONE;
-  auto& filters = profiles_filter_table[conn_handle];
-  {
-    filters.SetupProfilesFilter(
-        IsFilterEnabled(kBtSnoopLogFilterProfilePbapModeProperty),
-        IsFilterEnabled(kBtSnoopLogFilterProfileMapModeProperty));
-  }
-
-  LOG_INFO(
-      "RFCOMM port is opened: handle=%d(0x%x),"
-      " lcid=%d(0x%x), dlci=%d(0x%x), uuid=%d(0x%x)%s",
-      conn_handle,
-      conn_handle,
-      local_cid,
-      local_cid,
-      dlci,
-      dlci,
-      uuid,
-      uuid,
-      flow ? " Credit Based Flow Control enabled" : "");
+    profile_type_t profile = FILTER_PROFILE_NONE;
+    auto& filters = profiles_filter_table[conn_handle];
+    {
+      filters.SetupProfilesFilter(
+          IsFilterEnabled(kBtSnoopLogFilterProfilePbapModeProperty),
+          IsFilterEnabled(kBtSnoopLogFilterProfileMapModeProperty));
+    }
 
-  if (uuid == PROFILE_UUID_PBAP || (dlci >> 1) == PROFILE_SCN_PBAP) {
-    profile = FILTER_PROFILE_PBAP;
-  } else if (uuid == PROFILE_UUID_MAP || (dlci >> 1) == PROFILE_SCN_MAP) {
-    profile = FILTER_PROFILE_MAP;
-  } else if (uuid == PROFILE_UUID_HFP_HS) {
-    profile = FILTER_PROFILE_HFP_HS;
-  } else if (uuid == PROFILE_UUID_HFP_HF) {
-    profile = FILTER_PROFILE_HFP_HF;
-  }
+    LOG_INFO(
+        "RFCOMM port is opened: handle=%d(0x%x),"
+        " lcid=%d(0x%x), dlci=%d(0x%x), uuid=%d(0x%x)%s",
+        conn_handle,
+        conn_handle,
+        local_cid,
+        local_cid,
+        dlci,
+        dlci,
+        uuid,
+        uuid,
+        flow ? " Credit Based Flow Control enabled" : "");
+
+    if (uuid == PROFILE_UUID_PBAP || (dlci >> 1) == PROFILE_SCN_PBAP) {
+      profile = FILTER_PROFILE_PBAP;
+    } else if (uuid == PROFILE_UUID_MAP || (dlci >> 1) == PROFILE_SCN_MAP) {
+      profile = FILTER_PROFILE_MAP;
+    } else if (uuid == PROFILE_UUID_HFP_HS) {
+      profile = FILTER_PROFILE_HFP_HS;
+    } else if (uuid == PROFILE_UUID_HFP_HF) {
+      profile = FILTER_PROFILE_HFP_HF;
+    }
 
-  if (profile >= 0) {
-    filters.ProfileRfcommOpen(profile, local_cid, dlci, uuid, flow);
-  }
+    if (profile >= 0) {
+      filters.ProfileRfcommOpen(profile, local_cid, dlci, uuid, flow);
+    }
+  });
 }
 
 void SnoopLogger::SetRfcommPortClose(
@@ -1062,10 +1287,6 @@ void SnoopLogger::SetRfcommPortClose(
        !IsFilterEnabled(kBtSnoopLogFilterProfileMapModeProperty))) {
     return;
   }
-
-  std::lock_guard<std::mutex> lock(profiles_filter_mutex);
-
-  auto& filters = profiles_filter_table[handle];
   LOG_INFO(
       "RFCOMM port is closed: handle=%d(0x%x),"
       " lcid=%d(0x%x), dlci=%d(0x%x), uuid=%d(0x%x)",
@@ -1077,8 +1298,12 @@ void SnoopLogger::SetRfcommPortClose(
       dlci,
       uuid,
       uuid);
+  ChangeFilters([handle, local_cid, dlci]() {
+    std::lock_guard<std::mutex> lock(profiles_filter_mutex);
 
-  filters.ProfileRfcommClose(filters.DlciToProfile(true, local_cid, dlci));
+    auto& filters = profiles_filter_table[handle];
+    filters.ProfileRfcommClose(filters.DlciToProfile(true, local_cid, dlci));
+  });
 }
 
 void SnoopLogger::SetL2capChannelOpen(
@@ -1088,40 +1313,41 @@ void SnoopLogger::SetL2capChannelOpen(
        !IsFilterEnabled(kBtSnoopLogFilterProfileMapModeProperty))) {
     return;
   }
+  ChangeFilters([this, handle, local_cid, remote_cid, psm, flow]() {
+    std::lock_guard<std::mutex> lock(profiles_filter_mutex);
+    profile_type_t profile = FILTER_PROFILE_NONE;
+    auto& filters = profiles_filter_table[handle];
+    {
+      filters.SetupProfilesFilter(
+          IsFilterEnabled(kBtSnoopLogFilterProfilePbapModeProperty),
+          IsFilterEnabled(kBtSnoopLogFilterProfileMapModeProperty));
+    }
 
-  std::lock_guard<std::mutex> lock(profiles_filter_mutex);
-  profile_type_t profile = FILTER_PROFILE_NONE;
-  auto& filters = profiles_filter_table[handle];
-  {
-    filters.SetupProfilesFilter(
-        IsFilterEnabled(kBtSnoopLogFilterProfilePbapModeProperty),
-        IsFilterEnabled(kBtSnoopLogFilterProfileMapModeProperty));
-  }
-
-  LOG_INFO(
-      "L2CAP channel is opened: handle=%d(0x%x), lcid=%d(0x%x),"
-      " rcid=%d(0x%x), psm=0x%x%s",
-      handle,
-      handle,
-      local_cid,
-      local_cid,
-      remote_cid,
-      remote_cid,
-      psm,
-      flow ? " Standard or Enhanced Control enabled" : "");
-
-  if (psm == PROFILE_PSM_RFCOMM) {
-    filters.ch_rfc_l = local_cid;
-    filters.ch_rfc_r = remote_cid;
-  } else if (psm == PROFILE_PSM_PBAP) {
-    profile = FILTER_PROFILE_PBAP;
-  } else if (psm == PROFILE_PSM_MAP) {
-    profile = FILTER_PROFILE_MAP;
-  }
+    LOG_INFO(
+        "L2CAP channel is opened: handle=%d(0x%x), lcid=%d(0x%x),"
+        " rcid=%d(0x%x), psm=0x%x%s",
+        handle,
+        handle,
+        local_cid,
+        local_cid,
+        remote_cid,
+        remote_cid,
+        psm,
+        flow ? " Standard or Enhanced Control enabled" : "");
+
+    if (psm == PROFILE_PSM_RFCOMM) {
+      filters.ch_rfc_l = local_cid;
+      filters.ch_rfc_r = remote_cid;
+    } else if (psm == PROFILE_PSM_PBAP) {
+      profile = FILTER_PROFILE_PBAP;
+    } else if (psm == PROFILE_PSM_MAP) {
+      profile = FILTER_PROFILE_MAP;
+    }
 
-  if (profile >= 0) {
-    filters.ProfileL2capOpen(profile, local_cid, remote_cid, psm, flow);
-  }
+    if (profile >= 0) {
+      filters.ProfileL2capOpen(profile, local_cid, remote_cid, psm, flow);
+    }
+  });
 }
 
 void SnoopLogger::SetL2capChannelClose(uint16_t handle, uint16_t local_cid, uint16_t remote_cid) {
@@ -1130,11 +1356,6 @@ void SnoopLogger::SetL2capChannelClose(uint16_t handle, uint16_t local_cid, uint
        !IsFilterEnabled(kBtSnoopLogFilterProfileMapModeProperty))) {
     return;
   }
-
-  std::lock_guard<std::mutex> lock(profiles_filter_mutex);
-
-  auto& filters = profiles_filter_table[handle];
-
   LOG_INFO(
       "L2CAP channel is closed: handle=%d(0x%x), lcid=%d(0x%x),"
       " rcid=%d(0x%x)",
@@ -1144,8 +1365,13 @@ void SnoopLogger::SetL2capChannelClose(uint16_t handle, uint16_t local_cid, uint
       local_cid,
       remote_cid,
       remote_cid);
+  ChangeFilters([handle, local_cid]() {
+    std::lock_guard<std::mutex> lock(profiles_filter_mutex);
 
-  filters.ProfileL2capClose(filters.CidToProfile(true, local_cid));
+    auto& filters = profiles_filter_table[handle];
+
+    filters.ProfileL2capClose(filters.CidToProfile(true, local_cid));
+  });
 }
 
 void SnoopLogger::FilterCapturedPacket(
@@ -1221,58 +1447,29 @@ void SnoopLogger::Capture(HciPacket& packet, Direction direction, PacketType typ
                              .dropped_packets = 0,
                              .timestamp = htonll(timestamp_us + kBtSnoopEpochDelta),
                              .type = static_cast<uint8_t>(type)};
-  {
-    std::lock_guard<std::recursive_mutex> lock(file_mutex_);
-    if (btsnoop_mode_ == kBtSnoopLogModeDisabled) {
-      // btsnoop disabled, log in-memory btsnooz log only
-      std::stringstream ss;
-      size_t included_length = get_btsnooz_packet_length_to_write(packet, type, qualcomm_debug_log_enabled_);
-      header.length_captured = htonl(included_length + /* type byte */ PACKET_TYPE_LENGTH);
-      if (!ss.write(reinterpret_cast<const char*>(&header), sizeof(PacketHeaderType))) {
-        LOG_ERROR("Failed to write packet header for btsnooz, error: \"%s\"", strerror(errno));
-      }
-      if (!ss.write(reinterpret_cast<const char*>(packet.data()), included_length)) {
-        LOG_ERROR("Failed to write packet payload for btsnooz, error: \"%s\"", strerror(errno));
-      }
-      btsnooz_buffer_.Push(ss.str());
-      return;
-    }
-
-    FilterCapturedPacket(packet, direction, type, length, header);
-
-    if (length == 0) {
-      return;
-    } else if (length != ntohl(header.length_original)) {
-      header.length_captured = htonl(length);
-    }
-
-    packet_counter_++;
-    if (packet_counter_ > max_packets_per_file_) {
-      OpenNextSnoopLogFile();
-    }
-    if (!btsnoop_ostream_.write(reinterpret_cast<const char*>(&header), sizeof(PacketHeaderType))) {
-      LOG_ERROR("Failed to write packet header for btsnoop, error: \"%s\"", strerror(errno));
-    }
-    if (!btsnoop_ostream_.write(reinterpret_cast<const char*>(packet.data()), length - 1)) {
-      LOG_ERROR("Failed to write packet payload for btsnoop, error: \"%s\"", strerror(errno));
-    }
-
-    if (socket_ != nullptr) {
-      socket_->Write(&header, sizeof(PacketHeaderType));
-      socket_->Write(packet.data(), packet.size());
-    }
+  // No lock: the mode and the writer only change in Start() and Stop(), while the HAL can't capture packets
+  if (btsnoop_mode_ == kBtSnoopLogModeDisabled) {
+    // btsnoop disabled, log in-memory btsnooz log only
+    size_t included_length = get_btsnooz_packet_length_to_write(packet, type, qualcomm_debug_log_enabled_);
+    header.length_captured = htonl(included_length + /* type byte */ PACKET_TYPE_LENGTH);
+    btsnooz_buffer_.Push(&header, sizeof(PacketHeaderType), packet.data(), included_length);
+    return;
+  }
 
-    // std::ofstream::flush() pushes user data into kernel memory. The data will be written even if this process
-    // crashes. However, data will be lost if there is a kernel panic, which is out of scope of BT snoop log.
-    // NOTE: std::ofstream::write() followed by std::ofstream::flush() has similar effect as UNIX write(fd, data, len)
-    //       as write() syscall dumps data into kernel memory directly
-    if (!btsnoop_ostream_.flush()) {
-      LOG_ERROR("Failed to flush, error: \"%s\"", strerror(errno));
-    }
+  if (snoop_logger_writer_ == nullptr) {
+    return;
   }
+  // Records are copied to preallocated slots of the writer, longer packets are truncated
+  size_t captured_length =
+      std::min(packet.size(), SnoopLoggerWriter::kMaxRecordSize - sizeof(PacketHeaderType));
+  header.length_captured = htonl(captured_length + /* type byte */ PACKET_TYPE_LENGTH);
+  // The writer thread filters the record and writes it to the file and the socket. Once written, data is in kernel
+  // memory and survives a crash of this process, which happens at most SnoopLoggerWriter::kDefaultFlushInterval after
+  // capture. Data will be lost if there is a kernel panic, which is out of scope of BT snoop log.
+  snoop_logger_writer_->Push(&header, sizeof(PacketHeaderType), packet.data(), captured_length);
 }
 
-void SnoopLogger::DumpSnoozLogToFile(const std::vector<std::string>& data) const {
+void SnoopLogger::DumpSnoozLogToFile(const std::vector<uint8_t>& data) const {
   std::lock_guard<std::recursive_mutex> lock(file_mutex_);
   if (btsnoop_mode_ != kBtSnoopLogModeDisabled) {
     LOG_DEBUG("btsnoop log is enabled, skip dumping btsnooz log");
@@ -1304,10 +1501,8 @@ void SnoopLogger::DumpSnoozLogToFile(const std::vector<std::string>& data) const
           sizeof(SnoopLoggerCommon::FileHeaderType))) {
     LOG_ALWAYS_FATAL("Unable to write file header to \"%s\", error: \"%s\"", snooz_log_path_.c_str(), strerror(errno));
   }
-  for (const auto& packet : data) {
-    if (!btsnooz_ostream.write(packet.data(), packet.size())) {
-      LOG_ERROR("Failed to write packet payload for btsnooz, error: \"%s\"", strerror(errno));
-    }
+  if (!btsnooz_ostream.write(reinterpret_cast<const char*>(data.data()), data.size())) {
+    LOG_ERROR("Failed to write packet payload for btsnooz, error: \"%s\"", strerror(errno));
   }
   if (!btsnooz_ostream.flush()) {
     LOG_ERROR("Failed to flush, error: \"%s\"", strerror(errno));
@@ -1322,9 +1517,17 @@ void SnoopLogger::Start() {
   std::lock_guard<std::recursive_mutex> lock(file_mutex_);
   if (btsnoop_mode_ != kBtSnoopLogModeDisabled) {
     OpenNextSnoopLogFile();
+    snoop_logger_writer_ = std::make_unique<SnoopLoggerWriter>(
+        [this](const iovec* records, size_t count) { WriteRecords(records, count); },
+        SnoopLoggerWriter::kDefaultCapacity,
+        SnoopLoggerWriter::kDefaultFlushInterval,
+        [this]() { FlushRecords(); });
+    snoop_logger_writer_->Start();
 
     if (btsnoop_mode_ == kBtSnoopLogModeFiltered) {
       EnableFilters();
+      std::lock_guard<std::mutex> filter_changes_lock(filter_changes_mutex_);
+      defer_filter_changes_ = true;
     }
 
     if (bluetooth::common::InitFlags::IsSnoopLoggerSocketEnabled()) {
@@ -1349,6 +1552,18 @@ void SnoopLogger::Start() {
 void SnoopLogger::Stop() {
   std::lock_guard<std::recursive_mutex> lock(file_mutex_);
   LOG_DEBUG("Closing btsnoop log data at %s", snoop_log_path_.c_str());
+  if (snoop_logger_writer_ != nullptr) {
+    // Writes every captured packet
+    snoop_logger_writer_->Stop();
+    // Filter changes made after the last captured packet
+    std::lock_guard<std::mutex> filter_changes_lock(filter_changes_mutex_);
+    defer_filter_changes_ = false;
+    for (auto& change : filter_changes_) {
+      change.second();
+    }
+    filter_changes_.clear();
+    filtered_records_ = 0;
+  }
   CloseCurrentSnoopLogFile();
 
   if (snoop_logger_socket_thread_ != nullptr) {
@@ -1358,6 +1573,8 @@ void SnoopLogger::Stop() {
     socket_ = nullptr;
   }
 
+  snoop_logger_writer_.reset();
+
   btsnoop_mode_.clear();
   // Disable all filters
   DisableFilters();
@@ -1374,7 +1591,28 @@ void SnoopLogger::Stop() {
 DumpsysDataFinisher SnoopLogger::GetDumpsysData(flatbuffers::FlatBufferBuilder* builder) const {
   LOG_DEBUG("Dumping btsnooz log data to %s", snooz_log_path_.c_str());
   DumpSnoozLogToFile(btsnooz_buffer_.Pull());
-  return Module::GetDumpsysData(builder);
+
+  auto title = builder->CreateString("----- Snoop Logger Dumpsys -----");
+  auto mode = builder->CreateString(btsnoop_mode_);
+  SnoopLoggerDataBuilder snoop_logger_builder(*builder);
+  snoop_logger_builder.add_title(title);
+  snoop_logger_builder.add_mode(mode);
+  {
+    std::lock_guard<std::recursive_mutex> lock(file_mutex_);
+    if (snoop_logger_writer_ != nullptr) {
+      // Make sure the btsnoop log collected with this dump is complete
+      snoop_logger_writer_->Flush();
+      snoop_logger_builder.add_written_records(snoop_logger_writer_->GetWrittenRecords());
+      snoop_logger_builder.add_dropped_records(snoop_logger_writer_->GetDroppedRecords());
+      snoop_logger_builder.add_queue_depth(snoop_logger_writer_->GetQueueDepth());
+      snoop_logger_builder.add_max_queue_depth(snoop_logger_writer_->GetMaxQueueDepth());
+    }
+  }
+  auto dumpsys_data = snoop_logger_builder.Finish();
+
+  return [dumpsys_data](DumpsysDataBuilder* dumpsys_builder) {
+    dumpsys_builder->add_snoop_logger_dumpsys_data(dumpsys_data);
+  };
 }
 
 size_t SnoopLogger::GetMaxPacketsPerFile() {
@@ -1392,6 +1630,36 @@ size_t SnoopLogger::GetMaxPacketsPerFile() {
   return max_packets_per_file;
 }
 
+size_t SnoopLogger::GetMaxBytesPerCompressedFile() {
+  // Allow override max bytes per compressed file via system property
+  auto max_bytes_per_file = kDefaultMaxBytesPerCompressedFile;
+  {
+    auto max_bytes_per_file_prop = os::GetSystemProperty(kBtSnoopMaxBytesPerCompressedFileProperty);
+    if (max_bytes_per_file_prop) {
+      auto max_bytes_per_file_number = common::Uint64FromString(max_bytes_per_file_prop.value());
+      if (max_bytes_per_file_number) {
+        max_bytes_per_file = max_bytes_per_file_number.value();
+      }
+    }
+  }
+  return max_bytes_per_file;
+}
+
+size_t SnoopLogger::GetMaxCompressedFiles() {
+  // Allow override max number of compressed files via system property
+  auto max_files = kDefaultMaxCompressedFiles;
+  {
+    auto max_files_prop = os::GetSystemProperty(kBtSnoopMaxCompressedFilesProperty);
+    if (max_files_prop) {
+      auto max_files_number = common::Uint64FromString(max_files_prop.value());
+      if (max_files_number) {
+        max_files = max_files_number.value();
+      }
+    }
+  }
+  return max_files;
+}
+
 size_t SnoopLogger::GetMaxPacketsPerBuffer() {
   // We want to use at most 256 KB memory for btsnooz log for release builds
   // and 512 KB memory for userdebug/eng builds
@@ -1438,10 +1706,16 @@ std::string SnoopLogger::GetBtSnoopMode() {
 }
 
 void SnoopLogger::RegisterSocket(SnoopLoggerSocketInterface* socket) {
-  std::lock_guard<std::recursive_mutex> lock(file_mutex_);
   socket_ = socket;
 }
 
+void SnoopLogger::Flush() {
+  std::lock_guard<std::recursive_mutex> lock(file_mutex_);
+  if (snoop_logger_writer_ != nullptr) {
+    snoop_logger_writer_->Flush();
+  }
+}
+
 bool SnoopLogger::IsBtSnoopLogPersisted() {
   auto is_debuggable = os::GetSystemPropertyBool(kIsDebuggableProperty, false);
   return is_debuggable && os::GetSystemPropertyBool(kBtSnoopLogPersists, false);
@@ -1468,7 +1742,9 @@ const ModuleFactory SnoopLogger::Factory = ModuleFactory([]() {
       IsQualcommDebugLogEnabled(),
       kBtSnoozLogLifeTime,
       kBtSnoozLogDeleteRepeatingAlarmInterval,
-      IsBtSnoopLogPersisted());
+      IsBtSnoopLogPersisted(),
+      GetMaxBytesPerCompressedFile(),
+      GetMaxCompressedFiles());
 });
 
 }  // namespace hal
@@ -16,16 +16,23 @@
 
 #pragma once
 
+#include <sys/uio.h>
+
+#include <atomic>
+#include <deque>
 #include <fstream>
+#include <functional>
 #include <iostream>
 #include <mutex>
 #include <string>
 #include <unordered_map>
 #include <unordered_set>
 
-#include "common/circular_buffer.h"
 #include "hal/hci_hal.h"
+#include "hal/snoop_log_compressor.h"
 #include "hal/snoop_logger_socket_thread.h"
+#include "hal/snoop_logger_writer.h"
+#include "hal/snooz_buffer.h"
 #include "hal/syscall_wrapper_impl.h"
 #include "module.h"
 #include "os/repeating_alarm.h"
@@ -142,6 +149,8 @@ class SnoopLogger : public ::bluetooth::Module {
   static const ModuleFactory Factory;
 
   static const std::string kBtSnoopMaxPacketsPerFileProperty;
+  static const std::string kBtSnoopMaxBytesPerCompressedFileProperty;
+  static const std::string kBtSnoopMaxCompressedFilesProperty;
   static const std::string kIsDebuggableProperty;
   static const std::string kBtSnoopLogModeProperty;
   static const std::string kBtSnoopLogPersists;
@@ -156,6 +165,7 @@ class SnoopLogger : public ::bluetooth::Module {
   static const std::string kBtSnoopLogModeDisabled;
   static const std::string kBtSnoopLogModeFiltered;
   static const std::string kBtSnoopLogModeFull;
+  static const std::string kBtSnoopLogModeCompressed;
 
   static const std::string kSoCManufacturerQualcomm;
 
@@ -194,6 +204,11 @@ class SnoopLogger : public ::bluetooth::Module {
   // Changes to this value is only effective after restarting Bluetooth
   static size_t GetMaxPacketsPerFile();
 
+  // Returns the size at which a compressed log file is rotated, and the number of compressed files kept
+  // Changes to these values are only effective after restarting Bluetooth
+  static size_t GetMaxBytesPerCompressedFile();
+  static size_t GetMaxCompressedFiles();
+
   static size_t GetMaxPacketsPerBuffer();
 
   // Get snoop logger mode based on current system setup
@@ -262,6 +277,9 @@ class SnoopLogger : public ::bluetooth::Module {
 
   void RegisterSocket(SnoopLoggerSocketInterface* socket);
 
+  // Block until every packet captured so far has been written to the btsnoop log
+  void Flush();
+
  protected:
   // Packet type length
   static const size_t PACKET_TYPE_LENGTH;
@@ -270,6 +288,9 @@ class SnoopLogger : public ::bluetooth::Module {
   static const uint32_t L2CAP_HEADER_SIZE;
   // Max packet data size when headersfiltered option enabled
   static const size_t MAX_HCI_ACL_LEN;
+  // Compressed btsnoop files are rotated by size, keeping the most recent ones up to a total disk budget
+  static constexpr size_t kDefaultMaxBytesPerCompressedFile = 4 * 1024 * 1024;
+  static constexpr size_t kDefaultMaxCompressedFiles = 16;
 
   void ListDependencies(ModuleList* list) const override;
   void Start() override;
@@ -288,10 +309,26 @@ class SnoopLogger : public ::bluetooth::Module {
       bool qualcomm_debug_log_enabled,
       const std::chrono::milliseconds snooz_log_life_time,
       const std::chrono::milliseconds snooz_log_delete_alarm_interval,
-      bool snoop_log_persists);
+      bool snoop_log_persists,
+      size_t max_bytes_per_compressed_file = kDefaultMaxBytesPerCompressedFile,
+      size_t max_compressed_files = kDefaultMaxCompressedFiles);
+  // The btsnoop log file is owned by the writer thread while it runs
   void CloseCurrentSnoopLogFile();
   void OpenNextSnoopLogFile();
-  void DumpSnoozLogToFile(const std::vector<std::string>& data) const;
+  void OpenNextCompressedSnoopLogFile();
+  // Callbacks of |snoop_logger_writer_|, run on its thread
+  void WriteRecords(const iovec* records, size_t count);
+  // Apply the snoop log filters to |records|, of at most SnoopLoggerWriter::kMaxRecordsPerWrite. Returns the number
+  // of records left in |filtered|.
+  size_t FilterRecords(const iovec* records, size_t count, iovec* filtered);
+  void WriteRecordsToSocket(const iovec* records, size_t count);
+  void FlushRecords();
+  void DumpSnoozLogToFile(const std::vector<uint8_t>& data) const;
+  // Run |change| to the filters. Records are filtered on the writer thread, so while it runs the change is queued,
+  // and made once the records captured before it are filtered
+  void ChangeFilters(std::function<void()> change);
+  // Make the queued filter changes that came before the first |records| captured records, on the writer thread
+  void ApplyFilterChanges(size_t records);
   // Enable filters according to their sysprops
   void EnableFilters();
   // Disable all filters
@@ -332,21 +369,35 @@ class SnoopLogger : public ::bluetooth::Module {
       PacketHeaderType header);
 
   std::unique_ptr<SnoopLoggerSocketThread> snoop_logger_socket_thread_;
+  std::unique_ptr<SnoopLoggerWriter> snoop_logger_writer_;
 
  private:
   static std::string btsnoop_mode_;
   std::string snoop_log_path_;
   std::string snooz_log_path_;
-  std::ofstream btsnoop_ostream_;
+  int btsnoop_fd_ = -1;
   size_t max_packets_per_file_;
-  common::CircularBuffer<std::string> btsnooz_buffer_;
+  size_t max_bytes_per_compressed_file_;
+  size_t max_compressed_files_;
+  SnoopLogCompressor compressor_;
+  SnoozBuffer btsnooz_buffer_;
   bool qualcomm_debug_log_enabled_ = false;
   size_t packet_counter_ = 0;
   mutable std::recursive_mutex file_mutex_;
+  // Filtered copies of the records of a write, reused by FilterRecords()
+  HciPacket filter_packets_[SnoopLoggerWriter::kMaxRecordsPerWrite];
+  std::vector<uint8_t> filter_records_[SnoopLoggerWriter::kMaxRecordsPerWrite];
+  // Records seen by FilterRecords() since Start(), on the writer thread
+  size_t filtered_records_ = 0;
+  std::mutex filter_changes_mutex_;
+  // Set while filtering happens on the writer thread
+  bool defer_filter_changes_ = false;
+  // Queued filter changes, along with the number of records captured before each of them
+  std::deque<std::pair<size_t, std::function<void()>>> filter_changes_;
   std::unique_ptr<os::RepeatingAlarm> alarm_;
   std::chrono::milliseconds snooz_log_life_time_;
   std::chrono::milliseconds snooz_log_delete_alarm_interval_;
-  SnoopLoggerSocketInterface* socket_;
+  std::atomic<SnoopLoggerSocketInterface*> socket_;
   SyscallWrapperImpl syscall_if;
   bool snoop_log_persists = false;
 };
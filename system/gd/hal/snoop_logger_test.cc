@@ -21,6 +21,7 @@
 #include <netinet/in.h>
 #include <sys/socket.h>
 
+#include <fstream>
 #include <future>
 #include <unordered_map>
 
@@ -129,7 +130,9 @@ class TestSnoopLoggerModule : public SnoopLogger {
       size_t max_packets_per_file,
       const std::string& btsnoop_mode,
       bool qualcomm_debug_log_enabled,
-      bool snoop_log_persists)
+      bool snoop_log_persists,
+      size_t max_bytes_per_compressed_file = kDefaultMaxBytesPerCompressedFile,
+      size_t max_compressed_files = kDefaultMaxCompressedFiles)
       : SnoopLogger(
             std::move(snoop_log_path),
             std::move(snooz_log_path),
@@ -139,7 +142,9 @@ class TestSnoopLoggerModule : public SnoopLogger {
             qualcomm_debug_log_enabled,
             20ms,
             5ms,
-            snoop_log_persists) {}
+            snoop_log_persists,
+            max_bytes_per_compressed_file,
+            max_compressed_files) {}
 
   std::string ToString() const override {
     return std::string("TestSnoopLoggerModule");
@@ -180,6 +185,9 @@ class SnoopLoggerModuleTest : public Test {
     temp_snoop_log_last_ = temp_dir_ / (std::string(test_info->name()) + "_btsnoop_hci.log.last");
     temp_snooz_log_ = temp_dir_ / (std::string(test_info->name()) + "_btsnooz_hci.log");
     temp_snooz_log_last_ = temp_dir_ / (std::string(test_info->name()) + "_btsnooz_hci.log.last");
+    temp_snoop_log_compressed_ = temp_dir_ / (std::string(test_info->name()) + "_btsnoop_hci.log.gz");
+    temp_snoop_log_compressed_1_ = temp_dir_ / (std::string(test_info->name()) + "_btsnoop_hci.log.1.gz");
+    temp_snoop_log_compressed_2_ = temp_dir_ / (std::string(test_info->name()) + "_btsnoop_hci.log.2.gz");
     temp_snoop_log_filtered =
         temp_dir_ / (std::string(test_info->name()) + "_btsnoop_hci.log.filtered");
     temp_snoop_log_filtered_last =
@@ -218,6 +226,9 @@ class SnoopLoggerModuleTest : public Test {
   std::filesystem::path temp_snoop_log_last_;
   std::filesystem::path temp_snooz_log_;
   std::filesystem::path temp_snooz_log_last_;
+  std::filesystem::path temp_snoop_log_compressed_;
+  std::filesystem::path temp_snoop_log_compressed_1_;
+  std::filesystem::path temp_snoop_log_compressed_2_;
   std::filesystem::path temp_snoop_log_filtered;
   std::filesystem::path temp_snoop_log_filtered_last;
 
@@ -241,6 +252,11 @@ class SnoopLoggerModuleTest : public Test {
     if (std::filesystem::exists(temp_snooz_log_last_)) {
       ASSERT_TRUE(std::filesystem::remove(temp_snooz_log_last_));
     }
+    for (const auto& path : {temp_snoop_log_compressed_, temp_snoop_log_compressed_1_, temp_snoop_log_compressed_2_}) {
+      if (std::filesystem::exists(path)) {
+        ASSERT_TRUE(std::filesystem::remove(path));
+      }
+    }
   }
 };
 
@@ -303,6 +319,67 @@ TEST_F(SnoopLoggerModuleTest, capture_one_packet_test) {
       sizeof(SnoopLoggerCommon::FileHeaderType) + sizeof(SnoopLogger::PacketHeaderType) + kInformationRequest.size());
 }
 
+TEST_F(SnoopLoggerModuleTest, flush_writes_captured_packets_test) {
+  // Actual test
+  auto* snoop_logger = new TestSnoopLoggerModule(
+      temp_snoop_log_.string(),
+      temp_snooz_log_.string(),
+      10,
+      SnoopLogger::kBtSnoopLogModeFull,
+      false,
+      false);
+  test_registry->InjectTestModule(&SnoopLogger::Factory, snoop_logger);
+
+  for (int i = 0; i < 3; i++) {
+    snoop_logger->Capture(kInformationRequest, SnoopLogger::Direction::OUTGOING, SnoopLogger::PacketType::CMD);
+  }
+  snoop_logger->Flush();
+
+  // Packets are in the file while the module is still running
+  ASSERT_EQ(
+      std::filesystem::file_size(temp_snoop_log_),
+      sizeof(SnoopLoggerCommon::FileHeaderType) +
+          (sizeof(SnoopLogger::PacketHeaderType) + kInformationRequest.size()) * 3);
+
+  test_registry->StopAll();
+}
+
+TEST_F(SnoopLoggerModuleTest, compressed_snoop_log_rotates_by_size_test) {
+  // Rotate as soon as anything was written, keep two files
+  auto* snoop_logger = new TestSnoopLoggerModule(
+      temp_snoop_log_.string(),
+      temp_snooz_log_.string(),
+      10,
+      SnoopLogger::kBtSnoopLogModeCompressed,
+      false,
+      false,
+      1,
+      2);
+  test_registry->InjectTestModule(&SnoopLogger::Factory, snoop_logger);
+
+  // The first flush writes the file header and the packet, each following one rotates the files
+  for (int i = 0; i < 3; i++) {
+    snoop_logger->Capture(kInformationRequest, SnoopLogger::Direction::OUTGOING, SnoopLogger::PacketType::CMD);
+    snoop_logger->Flush();
+  }
+
+  test_registry->StopAll();
+
+  // Verify states after test
+  ASSERT_FALSE(std::filesystem::exists(temp_snoop_log_));
+  ASSERT_TRUE(std::filesystem::exists(temp_snoop_log_compressed_));
+  ASSERT_TRUE(std::filesystem::exists(temp_snoop_log_compressed_1_));
+  ASSERT_FALSE(std::filesystem::exists(temp_snoop_log_compressed_2_));
+  for (const auto& path : {temp_snoop_log_compressed_, temp_snoop_log_compressed_1_}) {
+    // gzip magic number
+    std::ifstream file(path, std::ios::binary);
+    uint8_t magic[2] = {};
+    file.read(reinterpret_cast<char*>(magic), sizeof(magic));
+    ASSERT_EQ(magic[0], 0x1f);
+    ASSERT_EQ(magic[1], 0x8b);
+  }
+}
+
 TEST_F(SnoopLoggerModuleTest, capture_hci_cmd_btsnooz_test) {
   // Actual test
   auto* snoop_logger = new TestSnoopLoggerModule(
@@ -752,6 +829,49 @@ TEST_F(SnoopLoggerModuleTest, a2dp_packets_filtered_negative_test) {
   ASSERT_TRUE(std::filesystem::remove(temp_snoop_log_filtered));
 }
 
+TEST_F(SnoopLoggerModuleTest, a2dp_packets_filtered_with_channels_at_capture_time_test) {
+  // Actual test
+  uint16_t conn_handle = 0x000b;
+  uint16_t local_cid = 0x0001;
+  uint16_t remote_cid = 0xa040;
+
+  ASSERT_TRUE(
+      bluetooth::os::SetSystemProperty(SnoopLogger::kBtSnoopLogFilterProfileA2dpProperty, "true"));
+
+  auto* snoop_logger = new TestSnoopLoggerModule(
+      temp_snoop_log_.string(),
+      temp_snooz_log_.string(),
+      10,
+      SnoopLogger::kBtSnoopLogModeFiltered,
+      false,
+      false);
+
+  TestModuleRegistry test_registry;
+  test_registry.InjectTestModule(&SnoopLogger::Factory, snoop_logger);
+
+  // Channel is removed before the writer thread filters the first packet
+  snoop_logger->AddA2dpMediaChannel(conn_handle, local_cid, remote_cid);
+  snoop_logger->Capture(
+      kA2dpMediaPacket, SnoopLogger::Direction::OUTGOING, SnoopLogger::PacketType::ACL);
+  snoop_logger->RemoveA2dpMediaChannel(conn_handle, local_cid);
+  snoop_logger->Capture(
+      kA2dpMediaPacket, SnoopLogger::Direction::OUTGOING, SnoopLogger::PacketType::ACL);
+
+  test_registry.StopAll();
+
+  ASSERT_TRUE(
+      bluetooth::os::SetSystemProperty(SnoopLogger::kBtSnoopLogFilterProfileA2dpProperty, "false"));
+
+  // Verify states after test
+  ASSERT_TRUE(std::filesystem::exists(temp_snoop_log_filtered));
+  // Only the first packet is filtered
+  ASSERT_EQ(
+      std::filesystem::file_size(temp_snoop_log_filtered),
+      sizeof(SnoopLoggerCommon::FileHeaderType) + sizeof(SnoopLogger::PacketHeaderType) +
+          kA2dpMediaPacket.size());
+  ASSERT_TRUE(std::filesystem::remove(temp_snoop_log_filtered));
+}
+
 TEST_F(SnoopLoggerModuleTest, headers_filtered_test) {
   ASSERT_TRUE(
       bluetooth::os::SetSystemProperty(SnoopLogger::kBtSnoopLogFilterHeadersProperty, "true"));
@@ -1584,6 +1704,7 @@ TEST_F(SnoopLoggerModuleTest, custom_socket_interface_register_logging_enabled_t
 
   snoop_logger->RegisterSocket(&mock);
   snoop_logger->Capture(kQualcommConnectionRequest, SnoopLogger::Direction::OUTGOING, SnoopLogger::PacketType::ACL);
+  snoop_logger->Flush();
 
   ASSERT_TRUE(mock.write_called);
 
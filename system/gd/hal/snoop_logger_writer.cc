@@ -0,0 +1,194 @@
+/*
+ * Copyright 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "hal/snoop_logger_writer.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "os/log.h"
+
+namespace bluetooth {
+namespace hal {
+
+namespace {
+size_t round_up_to_power_of_two(size_t value) {
+  size_t result = 2;
+  while (result < value) {
+    result <<= 1;
+  }
+  return result;
+}
+}  // namespace
+
+SnoopLoggerWriter::SnoopLoggerWriter(
+    WriteCallback write_callback,
+    size_t capacity,
+    std::chrono::milliseconds flush_interval,
+    FlushCallback flush_callback)
+    : write_callback_(std::move(write_callback)),
+      flush_callback_(std::move(flush_callback)),
+      flush_interval_(flush_interval),
+      slots_(new Slot[round_up_to_power_of_two(capacity)]),
+      mask_(round_up_to_power_of_two(capacity) - 1) {
+  for (size_t i = 0; i <= mask_; i++) {
+    slots_[i].sequence.store(i, std::memory_order_relaxed);
+  }
+}
+
+SnoopLoggerWriter::~SnoopLoggerWriter() {
+  Stop();
+}
+
+void SnoopLoggerWriter::Start() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  ASSERT_LOG(!running_ && !thread_running_, "Snoop logger writer already started");
+  running_ = true;
+  thread_running_ = true;
+  thread_ = std::thread(&SnoopLoggerWriter::run, this);
+}
+
+void SnoopLoggerWriter::Stop() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!running_) {
+      return;
+    }
+    running_ = false;
+  }
+  wakeup_cv_.notify_one();
+  thread_.join();
+}
+
+bool SnoopLoggerWriter::Push(const void* header, size_t header_size, const void* payload, size_t payload_size) {
+  if (header_size + payload_size > kMaxRecordSize) {
+    dropped_records_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+  size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+  Slot* slot;
+  while (true) {
+    slot = &slots_[pos & mask_];
+    size_t sequence = slot->sequence.load(std::memory_order_acquire);
+    intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+    if (diff == 0) {
+      if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+        break;
+      }
+    } else if (diff < 0) {
+      // The slot still holds a record from the previous lap: the ring is full
+      dropped_records_.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    } else {
+      pos = enqueue_pos_.load(std::memory_order_relaxed);
+    }
+  }
+
+  slot->size = header_size + payload_size;
+  std::memcpy(slot->record, header, header_size);
+  std::memcpy(slot->record + header_size, payload, payload_size);
+  slot->sequence.store(pos + 1, std::memory_order_release);
+
+  // Slots are released before |dequeue_pos_| is updated, so the depth can be overestimated
+  size_t dequeue_pos = dequeue_pos_.load(std::memory_order_relaxed);
+  size_t depth = std::min(pos + 1 > dequeue_pos ? pos + 1 - dequeue_pos : 0, mask_ + 1);
+  size_t max_depth = max_queue_depth_.load(std::memory_order_relaxed);
+  while (depth > max_depth && !max_queue_depth_.compare_exchange_weak(max_depth, depth, std::memory_order_relaxed)) {
+  }
+  // Don't wait for the next periodic flush if the ring is about to overflow
+  if (depth == (mask_ + 1) / 2) {
+    wakeup();
+  }
+  return true;
+}
+
+void SnoopLoggerWriter::Flush() {
+  size_t target = enqueue_pos_.load(std::memory_order_acquire);
+  std::unique_lock<std::mutex> lock(mutex_);
+  if (!thread_running_) {
+    // Nothing else consumes the ring
+    drain();
+    return;
+  }
+  wakeup_requested_ = true;
+  wakeup_cv_.notify_one();
+  flushed_cv_.wait(
+      lock, [this, target] { return dequeue_pos_.load(std::memory_order_acquire) >= target || !thread_running_; });
+}
+
+void SnoopLoggerWriter::wakeup() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    wakeup_requested_ = true;
+  }
+  wakeup_cv_.notify_one();
+}
+
+void SnoopLoggerWriter::run() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    lock.unlock();
+    size_t written = drain();
+    lock.lock();
+    if (written > 0) {
+      flushed_cv_.notify_all();
+    }
+    if (!running_ && GetQueueDepth() == 0) {
+      break;
+    }
+    wakeup_cv_.wait_for(lock, flush_interval_, [this] { return wakeup_requested_ || !running_; });
+    wakeup_requested_ = false;
+  }
+  thread_running_ = false;
+  flushed_cv_.notify_all();
+}
+
+size_t SnoopLoggerWriter::drain() {
+  size_t total = 0;
+  size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+  iovec iov[kMaxRecordsPerWrite];
+  while (true) {
+    size_t count = 0;
+    while (count < kMaxRecordsPerWrite) {
+      Slot& slot = slots_[(pos + count) & mask_];
+      if (slot.sequence.load(std::memory_order_acquire) != pos + count + 1) {
+        break;
+      }
+      iov[count] = {slot.record, slot.size};
+      count++;
+    }
+    if (count == 0) {
+      break;
+    }
+
+    write_callback_(iov, count);
+
+    for (size_t i = 0; i < count; i++) {
+      slots_[(pos + i) & mask_].sequence.store(pos + i + mask_ + 1, std::memory_order_release);
+    }
+    pos += count;
+    dequeue_pos_.store(pos, std::memory_order_release);
+    written_records_.fetch_add(count, std::memory_order_relaxed);
+    total += count;
+  }
+  if (total > 0 && flush_callback_) {
+    flush_callback_();
+  }
+  return total;
+}
+
+}  // namespace hal
+}  // namespace bluetooth
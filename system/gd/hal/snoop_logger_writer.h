@@ -0,0 +1,132 @@
+/*
+ * Copyright 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <sys/uio.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace bluetooth {
+namespace hal {
+
+// Moves btsnoop file I/O off the threads capturing packets. Capturing threads serialize each record into a bounded
+// lock-free multi-producer ring; a dedicated thread drains it in batches and hands them to the write callback, one
+// iovec per record, then calls the optional flush callback once the ring is empty. The writer wakes up every
+// |flush_interval|, or as soon as the ring is half full, so a record reaches the kernel at most |flush_interval| after
+// it was captured even if the process crashes afterwards. Slots are allocated up front, so pushing a record never
+// allocates: when the ring is full, or the record is bigger than a slot, it is dropped rather than blocking the
+// capturing thread.
+class SnoopLoggerWriter {
+ public:
+  using WriteCallback = std::function<void(const iovec* records, size_t count)>;
+  using FlushCallback = std::function<void()>;
+
+  static constexpr size_t kDefaultCapacity = 1024;
+  static constexpr std::chrono::milliseconds kDefaultFlushInterval = std::chrono::milliseconds(50);
+  // Upper bound on the records handed to a single write callback
+  static constexpr size_t kMaxRecordsPerWrite = 64;
+  // Size of a slot of the ring, bigger records are dropped
+  static constexpr size_t kMaxRecordSize = 2048;
+
+  // |capacity| is rounded up to a power of two
+  explicit SnoopLoggerWriter(
+      WriteCallback write_callback,
+      size_t capacity = kDefaultCapacity,
+      std::chrono::milliseconds flush_interval = kDefaultFlushInterval,
+      FlushCallback flush_callback = nullptr);
+  ~SnoopLoggerWriter();
+
+  SnoopLoggerWriter(const SnoopLoggerWriter&) = delete;
+  SnoopLoggerWriter& operator=(const SnoopLoggerWriter&) = delete;
+
+  void Start();
+
+  // Write every queued record, then stop the writer thread
+  void Stop();
+
+  // Queue a record made of |header| followed by |payload|. Safe to call from any thread, never blocks. Returns false
+  // if the record was dropped because the ring is full or it is bigger than kMaxRecordSize.
+  bool Push(const void* header, size_t header_size, const void* payload, size_t payload_size);
+
+  // Block until every record pushed before this call has been handed to the write callback
+  void Flush();
+
+  // Records pushed so far, which is also the position in the ring of the next record pushed
+  size_t GetPushedRecords() const {
+    return enqueue_pos_.load(std::memory_order_acquire);
+  }
+  uint64_t GetWrittenRecords() const {
+    return written_records_.load(std::memory_order_relaxed);
+  }
+  uint64_t GetDroppedRecords() const {
+    return dropped_records_.load(std::memory_order_relaxed);
+  }
+  size_t GetQueueDepth() const {
+    size_t dequeue_pos = dequeue_pos_.load(std::memory_order_acquire);
+    return enqueue_pos_.load(std::memory_order_acquire) - dequeue_pos;
+  }
+  size_t GetMaxQueueDepth() const {
+    return max_queue_depth_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  struct Slot {
+    // Equal to the position of the next record stored in this slot while it is free, to that position + 1 once the
+    // record is published
+    std::atomic<size_t> sequence;
+    size_t size;
+    uint8_t record[kMaxRecordSize];
+  };
+
+  void run();
+  // Hand every published record to the write callback. Returns the number of records written.
+  size_t drain();
+  void wakeup();
+
+  WriteCallback write_callback_;
+  FlushCallback flush_callback_;
+  std::chrono::milliseconds flush_interval_;
+  std::unique_ptr<Slot[]> slots_;
+  size_t mask_;
+
+  alignas(64) std::atomic<size_t> enqueue_pos_ = 0;
+  alignas(64) std::atomic<size_t> dequeue_pos_ = 0;
+  std::atomic<uint64_t> written_records_ = 0;
+  std::atomic<uint64_t> dropped_records_ = 0;
+  std::atomic<size_t> max_queue_depth_ = 0;
+
+  std::mutex mutex_;
+  std::condition_variable wakeup_cv_;
+  std::condition_variable flushed_cv_;
+  bool wakeup_requested_ = false;
+  // Set by Start() and cleared by Stop()
+  bool running_ = false;
+  // Whether the writer thread still consumes the ring, it only exits once the ring is empty
+  bool thread_running_ = false;
+  std::thread thread_;
+};
+
+}  // namespace hal
+}  // namespace bluetooth
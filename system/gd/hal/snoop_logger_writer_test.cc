@@ -0,0 +1,192 @@
+/*
+ * Copyright 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "hal/snoop_logger_writer.h"
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace std::chrono_literals;
+
+namespace bluetooth {
+namespace hal {
+namespace {
+
+struct Record {
+  uint32_t producer;
+  uint32_t index;
+};
+
+class SnoopLoggerWriterTest : public ::testing::Test {
+ protected:
+  SnoopLoggerWriter::WriteCallback Collect() {
+    return [this](const iovec* records, size_t count) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      max_batch_ = std::max(max_batch_, count);
+      for (size_t i = 0; i < count; i++) {
+        ASSERT_EQ(records[i].iov_len, sizeof(Record));
+        Record record;
+        std::memcpy(&record, records[i].iov_base, sizeof(Record));
+        records_.push_back(record);
+      }
+    };
+  }
+
+  static bool Push(SnoopLoggerWriter* writer, uint32_t producer, uint32_t index) {
+    // Header and payload are concatenated into a single record
+    return writer->Push(&producer, sizeof(producer), &index, sizeof(index));
+  }
+
+  std::mutex mutex_;
+  std::vector<Record> records_;
+  size_t max_batch_ = 0;
+};
+
+TEST_F(SnoopLoggerWriterTest, flush_writes_records_in_order) {
+  SnoopLoggerWriter writer(Collect(), 1024, 10s);
+  writer.Start();
+  for (uint32_t i = 0; i < 200; i++) {
+    ASSERT_TRUE(Push(&writer, 0, i));
+  }
+  writer.Flush();
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ASSERT_EQ(records_.size(), 200u);
+    for (uint32_t i = 0; i < 200; i++) {
+      ASSERT_EQ(records_[i].index, i);
+    }
+    ASSERT_LE(max_batch_, SnoopLoggerWriter::kMaxRecordsPerWrite);
+  }
+  ASSERT_EQ(writer.GetWrittenRecords(), 200u);
+  ASSERT_EQ(writer.GetQueueDepth(), 0u);
+  writer.Stop();
+}
+
+TEST_F(SnoopLoggerWriterTest, periodic_flush) {
+  SnoopLoggerWriter writer(Collect(), 1024, 5ms);
+  writer.Start();
+  ASSERT_TRUE(Push(&writer, 0, 0));
+  for (int i = 0; i < 200 && writer.GetWrittenRecords() == 0; i++) {
+    std::this_thread::sleep_for(5ms);
+  }
+  ASSERT_EQ(writer.GetWrittenRecords(), 1u);
+  writer.Stop();
+}
+
+TEST_F(SnoopLoggerWriterTest, stop_writes_queued_records) {
+  SnoopLoggerWriter writer(Collect(), 1024, 10s);
+  writer.Start();
+  for (uint32_t i = 0; i < 100; i++) {
+    ASSERT_TRUE(Push(&writer, 0, i));
+  }
+  writer.Stop();
+  ASSERT_EQ(records_.size(), 100u);
+  ASSERT_EQ(writer.GetWrittenRecords(), 100u);
+}
+
+TEST_F(SnoopLoggerWriterTest, flush_callback_follows_written_records) {
+  size_t flushed_records = 0;
+  int flushes = 0;
+  // Not started, so records are written by Flush() on this thread
+  SnoopLoggerWriter writer(Collect(), 1024, 10s, [&]() {
+    flushed_records = records_.size();
+    flushes++;
+  });
+  writer.Flush();
+  ASSERT_EQ(flushes, 0);
+
+  for (uint32_t i = 0; i < 100; i++) {
+    ASSERT_TRUE(Push(&writer, 0, i));
+  }
+  writer.Flush();
+  // Called once, after every record was handed to the write callback
+  ASSERT_EQ(flushes, 1);
+  ASSERT_EQ(flushed_records, 100u);
+}
+
+TEST_F(SnoopLoggerWriterTest, drop_when_full) {
+  // Not started, so nothing drains the ring until Flush()
+  SnoopLoggerWriter writer(Collect(), 4);
+  for (uint32_t i = 0; i < 6; i++) {
+    ASSERT_EQ(Push(&writer, 0, i), i < 4);
+  }
+  ASSERT_EQ(writer.GetDroppedRecords(), 2u);
+  ASSERT_EQ(writer.GetQueueDepth(), 4u);
+  ASSERT_EQ(writer.GetMaxQueueDepth(), 4u);
+
+  writer.Flush();
+  ASSERT_EQ(records_.size(), 4u);
+  ASSERT_EQ(writer.GetQueueDepth(), 0u);
+
+  // Slots are reused once written
+  ASSERT_TRUE(Push(&writer, 0, 6));
+  writer.Flush();
+  ASSERT_EQ(records_.back().index, 6u);
+  ASSERT_EQ(writer.GetWrittenRecords(), 5u);
+}
+
+TEST_F(SnoopLoggerWriterTest, drop_when_bigger_than_slot) {
+  SnoopLoggerWriter writer(Collect(), 4);
+  std::vector<uint8_t> payload(SnoopLoggerWriter::kMaxRecordSize);
+  uint32_t producer = 0;
+  ASSERT_FALSE(writer.Push(&producer, sizeof(producer), payload.data(), payload.size()));
+  ASSERT_EQ(writer.GetDroppedRecords(), 1u);
+  ASSERT_EQ(writer.GetPushedRecords(), 0u);
+
+  // Doesn't take a slot
+  ASSERT_TRUE(Push(&writer, 0, 0));
+  ASSERT_EQ(writer.GetPushedRecords(), 1u);
+  writer.Flush();
+  ASSERT_EQ(records_.size(), 1u);
+}
+
+TEST_F(SnoopLoggerWriterTest, concurrent_producers) {
+  constexpr uint32_t kProducers = 4;
+  constexpr uint32_t kRecordsPerProducer = 20000;
+  SnoopLoggerWriter writer(Collect(), 256, 1ms);
+  writer.Start();
+  std::vector<std::thread> producers;
+  for (uint32_t producer = 0; producer < kProducers; producer++) {
+    producers.emplace_back([&writer, producer] {
+      for (uint32_t i = 0; i < kRecordsPerProducer; i++) {
+        Push(&writer, producer, i);
+      }
+    });
+  }
+  for (auto& producer : producers) {
+    producer.join();
+  }
+  writer.Stop();
+
+  ASSERT_EQ(writer.GetWrittenRecords() + writer.GetDroppedRecords(), kProducers * kRecordsPerProducer);
+  ASSERT_EQ(records_.size(), writer.GetWrittenRecords());
+  ASSERT_LE(writer.GetMaxQueueDepth(), 256u);
+  // Records from a given producer are written in order
+  std::vector<int64_t> last_index(kProducers, -1);
+  for (const auto& record : records_) {
+    ASSERT_LT(record.producer, kProducers);
+    ASSERT_GT(static_cast<int64_t>(record.index), last_index[record.producer]);
+    last_index[record.producer] = record.index;
+  }
+}
+
+}  // namespace
+}  // namespace hal
+}  // namespace bluetooth
@@ -0,0 +1,94 @@
+/*
+ * Copyright 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "hal/snooz_buffer.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "os/log.h"
+
+namespace bluetooth {
+namespace hal {
+
+namespace {
+constexpr size_t kLengthPrefixSize = sizeof(uint16_t);
+}  // namespace
+
+SnoozBuffer::SnoozBuffer(size_t capacity) : arena_(capacity) {
+  ASSERT(capacity > kLengthPrefixSize);
+}
+
+void SnoozBuffer::Push(const void* header, size_t header_size, const void* payload, size_t payload_size) {
+  size_t record_size = std::min(header_size + payload_size, std::min(kMaxRecordSize, arena_.size() - kLengthPrefixSize));
+  header_size = std::min(header_size, record_size);
+  payload_size = record_size - header_size;
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  while (arena_.size() - used_ < kLengthPrefixSize + record_size) {
+    evict_oldest();
+  }
+  size_t tail = (head_ + used_) % arena_.size();
+  uint16_t length = record_size;
+  write_at(tail, &length, kLengthPrefixSize);
+  write_at((tail + kLengthPrefixSize) % arena_.size(), header, header_size);
+  write_at((tail + kLengthPrefixSize + header_size) % arena_.size(), payload, payload_size);
+  used_ += kLengthPrefixSize + record_size;
+  record_count_++;
+}
+
+std::vector<uint8_t> SnoozBuffer::Pull() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::vector<uint8_t> records(used_ - record_count_ * kLengthPrefixSize);
+  size_t offset = head_;
+  size_t position = 0;
+  for (size_t i = 0; i < record_count_; i++) {
+    uint16_t length;
+    read_at(offset, &length, kLengthPrefixSize);
+    read_at((offset + kLengthPrefixSize) % arena_.size(), records.data() + position, length);
+    position += length;
+    offset = (offset + kLengthPrefixSize + length) % arena_.size();
+  }
+  return records;
+}
+
+size_t SnoozBuffer::RecordCount() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return record_count_;
+}
+
+void SnoozBuffer::write_at(size_t offset, const void* data, size_t size) {
+  size_t first = std::min(size, arena_.size() - offset);
+  std::memcpy(arena_.data() + offset, data, first);
+  std::memcpy(arena_.data(), static_cast<const uint8_t*>(data) + first, size - first);
+}
+
+void SnoozBuffer::read_at(size_t offset, void* data, size_t size) const {
+  size_t first = std::min(size, arena_.size() - offset);
+  std::memcpy(data, arena_.data() + offset, first);
+  std::memcpy(static_cast<uint8_t*>(data) + first, arena_.data(), size - first);
+}
+
+void SnoozBuffer::evict_oldest() {
+  uint16_t length;
+  read_at(head_, &length, kLengthPrefixSize);
+  head_ = (head_ + kLengthPrefixSize + length) % arena_.size();
+  used_ -= kLengthPrefixSize + length;
+  record_count_--;
+}
+
+}  // namespace hal
+}  // namespace bluetooth
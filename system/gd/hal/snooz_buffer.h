@@ -0,0 +1,62 @@
+/*
+ * Copyright 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace bluetooth {
+namespace hal {
+
+// In-memory btsnooz history: variable size records stored back to back in a byte arena allocated once, the oldest
+// records being overwritten when it is full. Each record costs its size plus a 2 byte length prefix, with no
+// allocation on the capture path.
+class SnoozBuffer {
+ public:
+  // Records larger than this are truncated
+  static constexpr size_t kMaxRecordSize = UINT16_MAX;
+
+  explicit SnoozBuffer(size_t capacity);
+
+  SnoozBuffer(const SnoozBuffer&) = delete;
+  SnoozBuffer& operator=(const SnoozBuffer&) = delete;
+
+  // Append a record made of |header| followed by |payload|
+  void Push(const void* header, size_t header_size, const void* payload, size_t payload_size);
+
+  // Take a snapshot of the records, oldest first, concatenated without their length prefix
+  std::vector<uint8_t> Pull() const;
+
+  size_t RecordCount() const;
+
+ private:
+  void write_at(size_t offset, const void* data, size_t size);
+  void read_at(size_t offset, void* data, size_t size) const;
+  void evict_oldest();
+
+  std::vector<uint8_t> arena_;
+  // Offset of the oldest record
+  size_t head_ = 0;
+  size_t used_ = 0;
+  size_t record_count_ = 0;
+  mutable std::mutex mutex_;
+};
+
+}  // namespace hal
+}  // namespace bluetooth
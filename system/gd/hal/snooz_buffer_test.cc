@@ -0,0 +1,83 @@
+/*
+ * Copyright 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "hal/snooz_buffer.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <vector>
+
+namespace bluetooth {
+namespace hal {
+namespace {
+
+void push(SnoozBuffer* buffer, uint8_t header, const std::vector<uint8_t>& payload) {
+  buffer->Push(&header, sizeof(header), payload.data(), payload.size());
+}
+
+TEST(SnoozBufferTest, empty) {
+  SnoozBuffer buffer(64);
+  ASSERT_EQ(buffer.RecordCount(), 0u);
+  ASSERT_TRUE(buffer.Pull().empty());
+}
+
+TEST(SnoozBufferTest, records_are_concatenated_in_order) {
+  SnoozBuffer buffer(64);
+  push(&buffer, 0x01, {0x10, 0x11});
+  push(&buffer, 0x02, {});
+  push(&buffer, 0x03, {0x30});
+
+  ASSERT_EQ(buffer.RecordCount(), 3u);
+  ASSERT_EQ(buffer.Pull(), std::vector<uint8_t>({0x01, 0x10, 0x11, 0x02, 0x03, 0x30}));
+}
+
+TEST(SnoozBufferTest, oldest_records_are_overwritten) {
+  // Each record takes 2 bytes of length prefix + 4 bytes
+  SnoozBuffer buffer(20);
+  for (uint8_t i = 0; i < 5; i++) {
+    push(&buffer, i, {i, i, i});
+  }
+
+  ASSERT_EQ(buffer.RecordCount(), 3u);
+  ASSERT_EQ(buffer.Pull(), std::vector<uint8_t>({2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4}));
+}
+
+TEST(SnoozBufferTest, records_wrap_around_the_arena) {
+  SnoozBuffer buffer(16);
+  push(&buffer, 0x01, {0x10, 0x11, 0x12, 0x13});
+  push(&buffer, 0x02, {0x20, 0x21, 0x22, 0x23});
+  // Evicts the first record and is stored across the end of the arena
+  push(&buffer, 0x03, {0x30, 0x31, 0x32, 0x33});
+
+  ASSERT_EQ(buffer.RecordCount(), 2u);
+  ASSERT_EQ(
+      buffer.Pull(), std::vector<uint8_t>({0x02, 0x20, 0x21, 0x22, 0x23, 0x03, 0x30, 0x31, 0x32, 0x33}));
+}
+
+TEST(SnoozBufferTest, record_larger_than_arena_is_truncated) {
+  SnoozBuffer buffer(8);
+  push(&buffer, 0x01, {0x10});
+  push(&buffer, 0x02, {0x20, 0x21, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27});
+
+  ASSERT_EQ(buffer.RecordCount(), 1u);
+  ASSERT_EQ(buffer.Pull(), std::vector<uint8_t>({0x02, 0x20, 0x21, 0x22, 0x23, 0x24}));
+}
+
+}  // namespace
+}  // namespace hal
+}  // namespace bluetooth
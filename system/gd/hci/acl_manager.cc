@@ -368,6 +368,12 @@ void AclManager::WriteDefaultLinkPolicySettings(uint16_t default_link_policy_set
   CallOn(pimpl_->classic_impl_, &classic_impl::write_default_link_policy_settings, default_link_policy_settings);
 }
 
+void AclManager::SetAclTxSchedulingParameters(
+    uint16_t handle, acl_manager::LatencyClass latency_class, uint8_t weight) {
+  CallOn(
+      pimpl_->round_robin_scheduler_, &RoundRobinScheduler::SetLinkSchedulingParameters, handle, latency_class, weight);
+}
+
 void AclManager::OnAdvertisingSetTerminated(
     ErrorCode status,
     uint16_t conn_handle,
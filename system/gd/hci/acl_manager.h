@@ -25,6 +25,7 @@
 #include "hci/acl_manager/connection_callbacks.h"
 #include "hci/acl_manager/le_acceptlist_callbacks.h"
 #include "hci/acl_manager/le_connection_callbacks.h"
+#include "hci/acl_manager/weighted_fair_queue.h"
 #include "hci/address.h"
 #include "hci/address_with_type.h"
 #include "hci/distance_measurement_manager.h"
@@ -131,6 +132,9 @@ public:
  virtual uint16_t ReadDefaultLinkPolicySettings();
  virtual void WriteDefaultLinkPolicySettings(uint16_t default_link_policy_settings);
 
+ // Set the latency class and weight of the link used to schedule its ACL data against the other links
+ virtual void SetAclTxSchedulingParameters(uint16_t handle, acl_manager::LatencyClass latency_class, uint8_t weight);
+
  // Callback from Advertising Manager to notify the advitiser (local) address
  virtual void OnAdvertisingSetTerminated(
      ErrorCode status,
@@ -20,6 +20,7 @@
 
 #include "common/bidi_queue.h"
 #include "hci/hci_packets.h"
+#include "os/spsc_queue.h"
 
 namespace bluetooth {
 namespace hci {
@@ -39,7 +40,8 @@ class AclConnection {
 
   virtual bool ReadRemoteVersionInformation() = 0;
 
-  using Queue = common::BidiQueue<PacketView<kLittleEndian>, BasePacketBuilder>;
+  // Each direction has one producer and one consumer: the ACL manager handler and the client of the connection
+  using Queue = common::BidiQueue<PacketView<kLittleEndian>, BasePacketBuilder, os::SpscQueue>;
   using QueueUpEnd = common::BidiQueueEnd<BasePacketBuilder, PacketView<kLittleEndian>>;
   using QueueDownEnd = common::BidiQueueEnd<PacketView<kLittleEndian>, BasePacketBuilder>;
   virtual QueueUpEnd* GetAclQueueEnd() const;
@@ -16,21 +16,55 @@
 
 #include "hci/acl_manager/acl_fragmenter.h"
 
+#include <algorithm>
+
 #include "os/log.h"
-#include "packet/fragmenting_inserter.h"
+#include "packet/bit_inserter.h"
 
 namespace bluetooth {
 namespace hci {
 namespace acl_manager {
 
+namespace {
+
+class AclFragmentBuilder : public packet::BasePacketBuilder {
+ public:
+  AclFragmentBuilder(std::shared_ptr<const std::vector<uint8_t>> packet, size_t offset, size_t length)
+      : packet_(std::move(packet)), offset_(offset), length_(length) {}
+
+  size_t size() const override {
+    return length_;
+  }
+
+  void Serialize(packet::BitInserter& it) const override {
+    it.insert_bytes(packet_->data() + offset_, length_);
+  }
+
+ private:
+  std::shared_ptr<const std::vector<uint8_t>> packet_;
+  size_t offset_;
+  size_t length_;
+};
+
+}  // namespace
+
 AclFragmenter::AclFragmenter(size_t mtu, std::unique_ptr<packet::BasePacketBuilder> packet)
     : mtu_(mtu), packet_(std::move(packet)) {}
 
-std::vector<std::unique_ptr<packet::RawBuilder>> AclFragmenter::GetFragments() {
-  std::vector<std::unique_ptr<packet::RawBuilder>> to_return;
-  packet::FragmentingInserter fragmenting_inserter(mtu_, std::back_insert_iterator(to_return));
-  packet_->Serialize(fragmenting_inserter);
-  fragmenting_inserter.finalize();
+std::vector<std::unique_ptr<packet::BasePacketBuilder>> AclFragmenter::GetFragments() {
+  ASSERT(mtu_ > 0);
+  auto bytes = std::make_shared<std::vector<uint8_t>>();
+  bytes->reserve(packet_->size());
+  {
+    packet::BitInserter it(*bytes);
+    packet_->Serialize(it);
+  }
+
+  std::vector<std::unique_ptr<packet::BasePacketBuilder>> to_return;
+  to_return.reserve((bytes->size() + mtu_ - 1) / mtu_);
+  for (size_t offset = 0; offset < bytes->size(); offset += mtu_) {
+    to_return.push_back(std::make_unique<AclFragmentBuilder>(bytes, offset, std::min(mtu_, bytes->size() - offset)));
+  }
   return to_return;
 }
 
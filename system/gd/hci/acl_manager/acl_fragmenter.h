@@ -23,7 +23,6 @@
 #include <vector>
 
 #include "packet/base_packet_builder.h"
-#include "packet/raw_builder.h"
 
 namespace bluetooth {
 namespace hci {
@@ -34,7 +33,8 @@ class AclFragmenter {
   AclFragmenter(size_t mtu, std::unique_ptr<packet::BasePacketBuilder> input);
   virtual ~AclFragmenter() = default;
 
-  std::vector<std::unique_ptr<packet::RawBuilder>> GetFragments();
+  // The packet is serialized once, fragments refer to ranges of the serialized bytes
+  std::vector<std::unique_ptr<packet::BasePacketBuilder>> GetFragments();
 
  private:
   size_t mtu_;
@@ -19,8 +19,10 @@
 #include <cstddef>
 #include <cstdint>
 #include <memory>
+#include <optional>
 
 #include "hci/acl_manager/acl_connection.h"
+#include "hci/acl_manager/reassembly_buffer_pool.h"
 #include "hci/address_with_type.h"
 #include "os/handler.h"
 #include "os/log.h"
@@ -34,14 +36,6 @@ constexpr size_t kMaxQueuedPacketsPerConnection = 10;
 constexpr size_t kL2capBasicFrameHeaderSize = 4;
 
 namespace {
-class PacketViewForRecombination : public packet::PacketView<packet::kLittleEndian> {
- public:
-  PacketViewForRecombination(const PacketView& packetView) : PacketView(packetView) {}
-  void AppendPacketView(packet::PacketView<packet::kLittleEndian> to_append) {
-    Append(to_append);
-  }
-};
-
 // Per spec 5.1 Vol 2 Part B 5.3, ACL link shall carry L2CAP data. Therefore, an ACL packet shall contain L2CAP PDU.
 // This function returns the PDU size of the L2CAP data if it's a starting packet. Returns 0 if it's invalid.
 uint16_t GetL2capPduSize(AclView packet) {
@@ -61,8 +55,9 @@ struct assembler {
   AddressWithType address_with_type_;
   AclConnection::QueueDownEnd* down_end_;
   os::Handler* handler_;
-  PacketViewForRecombination recombination_stage_{
-      PacketView<packet::kLittleEndian>(std::make_shared<std::vector<uint8_t>>())};
+  // PDUs spanning several ACL packets are copied into a single buffer from the pool, sized from the L2CAP length
+  ReassemblyBufferPool buffer_pool_;
+  std::shared_ptr<std::vector<uint8_t>> recombination_buffer_;
   size_t remaining_sdu_continuation_packet_size_ = 0;
   std::shared_ptr<std::atomic_bool> enqueue_registered_ = std::make_shared<std::atomic_bool>(false);
   std::queue<packet::PacketView<packet::kLittleEndian>> incoming_queue_;
@@ -71,6 +66,8 @@ struct assembler {
     if (enqueue_registered_->exchange(false)) {
       down_end_->UnregisterEnqueue();
     }
+    const ReassemblyBufferPool::Statistics& statistics = buffer_pool_.GetStatistics();
+    LOG_DEBUG("Reassembly buffer pool hits:%zu misses:%zu", statistics.hits, statistics.misses);
   }
 
   // Invoked from some external Queue Reactable context
@@ -84,46 +81,62 @@ struct assembler {
   }
 
   void on_incoming_packet(AclView packet) {
+    std::optional<PacketView<packet::kLittleEndian>> payload = recombine(packet);
+    if (!payload.has_value()) {
+      return;
+    }
+    if (incoming_queue_.size() > kMaxQueuedPacketsPerConnection) {
+      LOG_ERROR("Dropping packet from %s due to congestion",
+                 ADDRESS_TO_LOGGABLE_CSTR(address_with_type_));
+      return;
+    }
+
+    incoming_queue_.push(payload.value());
+    if (!enqueue_registered_->exchange(true)) {
+      down_end_->RegisterEnqueue(handler_,
+                                 common::Bind(&assembler::on_le_incoming_data_ready, common::Unretained(this)));
+    }
+  }
+
+  // Return the L2CAP PDU completed by the ACL packet, if any. The PDU is a single fragment view.
+  std::optional<PacketView<packet::kLittleEndian>> recombine(AclView packet) {
     PacketView<packet::kLittleEndian> payload = packet.GetPayload();
     size_t payload_size = payload.size();
     auto broadcast_flag = packet.GetBroadcastFlag();
     if (broadcast_flag == BroadcastFlag::ACTIVE_PERIPHERAL_BROADCAST) {
       LOG_WARN("Dropping broadcast from remote");
-      return;
+      return std::nullopt;
     }
     auto packet_boundary_flag = packet.GetPacketBoundaryFlag();
     if (packet_boundary_flag == PacketBoundaryFlag::FIRST_NON_AUTOMATICALLY_FLUSHABLE) {
       LOG_ERROR("Controller is not allowed to send FIRST_NON_AUTOMATICALLY_FLUSHABLE to host except loopback mode");
-      return;
+      return std::nullopt;
     }
     if (packet_boundary_flag == PacketBoundaryFlag::CONTINUING_FRAGMENT) {
-      if (remaining_sdu_continuation_packet_size_ < payload_size) {
+      if (recombination_buffer_ == nullptr || remaining_sdu_continuation_packet_size_ < payload_size) {
         LOG_WARN("Remote sent unexpected L2CAP PDU. Drop the entire L2CAP PDU");
-        recombination_stage_ =
-            PacketViewForRecombination(PacketView<packet::kLittleEndian>(std::make_shared<std::vector<uint8_t>>()));
+        recombination_buffer_.reset();
         remaining_sdu_continuation_packet_size_ = 0;
-        return;
+        return std::nullopt;
       }
       remaining_sdu_continuation_packet_size_ -= payload_size;
-      recombination_stage_.AppendPacketView(payload);
+      payload.AppendTo(recombination_buffer_.get());
       if (remaining_sdu_continuation_packet_size_ != 0) {
-        return;
-      } else {
-        payload = recombination_stage_;
-        recombination_stage_ =
-            PacketViewForRecombination(PacketView<packet::kLittleEndian>(std::make_shared<std::vector<uint8_t>>()));
+        return std::nullopt;
       }
+      std::shared_ptr<const std::vector<uint8_t>> pdu = std::move(recombination_buffer_);
+      return PacketView<packet::kLittleEndian>(pdu);
     } else if (packet_boundary_flag == PacketBoundaryFlag::FIRST_AUTOMATICALLY_FLUSHABLE) {
-      if (recombination_stage_.size() > 0) {
+      if (recombination_buffer_ != nullptr) {
         LOG_ERROR("Controller sent a starting packet without finishing previous packet. Drop previous one.");
+        recombination_buffer_.reset();
       }
       size_t l2cap_pdu_size = GetL2capPduSize(packet);
       if (l2cap_pdu_size == 0) {
         LOG_WARN("dropping an invalid L2CAP packet");
-        return;
+        return std::nullopt;
       }
 
-      remaining_sdu_continuation_packet_size_ = l2cap_pdu_size - (payload_size - kL2capBasicFrameHeaderSize);
       if ((payload_size - kL2capBasicFrameHeaderSize) > l2cap_pdu_size) {
         LOG_WARN(
             "Remote presented mismatched packet sizes payload_size:%zu l2cap_pdu_size:%zu",
@@ -135,21 +148,12 @@ struct assembler {
             l2cap_pdu_size - (payload_size - kL2capBasicFrameHeaderSize);
       }
       if (remaining_sdu_continuation_packet_size_ > 0) {
-        recombination_stage_ = payload;
-        return;
+        recombination_buffer_ = buffer_pool_.Acquire(kL2capBasicFrameHeaderSize + l2cap_pdu_size);
+        payload.AppendTo(recombination_buffer_.get());
+        return std::nullopt;
       }
     }
-    if (incoming_queue_.size() > kMaxQueuedPacketsPerConnection) {
-      LOG_ERROR("Dropping packet from %s due to congestion",
-                 ADDRESS_TO_LOGGABLE_CSTR(address_with_type_));
-      return;
-    }
-
-    incoming_queue_.push(payload);
-    if (!enqueue_registered_->exchange(true)) {
-      down_end_->RegisterEnqueue(handler_,
-                                 common::Bind(&assembler::on_le_incoming_data_ready, common::Unretained(this)));
-    }
+    return payload;
   }
 };
 
@@ -0,0 +1,113 @@
+/*
+ * Copyright 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "hci/acl_manager/assembler.h"
+#include "hci/hci_packets.h"
+#include "packet/bit_inserter.h"
+#include "packet/raw_builder.h"
+
+using ::benchmark::State;
+
+namespace bluetooth {
+namespace hci {
+namespace acl_manager {
+
+namespace {
+
+constexpr uint16_t kHandle = 0x0001;
+// Number of PDUs held by the upper layers at any time
+constexpr size_t kPdusInFlight = 3;
+constexpr size_t kNumPdus = 64;
+
+AclView MakeAclView(PacketBoundaryFlag packet_boundary_flag, std::vector<uint8_t> payload) {
+  auto raw_builder = std::make_unique<packet::RawBuilder>();
+  raw_builder->AddOctets(payload);
+  auto builder =
+      AclBuilder::Create(kHandle, packet_boundary_flag, BroadcastFlag::POINT_TO_POINT, std::move(raw_builder));
+  auto bytes = std::make_shared<std::vector<uint8_t>>();
+  packet::BitInserter inserter(*bytes);
+  builder->Serialize(inserter);
+  auto view = AclView::Create(packet::PacketView<packet::kLittleEndian>(bytes));
+  ASSERT(view.IsValid());
+  return view;
+}
+
+// Inbound stream of L2CAP basic frames of |pdu_size| bytes, split into ACL packets of |acl_mtu| bytes
+std::vector<AclView> MakeInboundStream(size_t pdu_size, size_t acl_mtu) {
+  std::vector<AclView> stream;
+  for (size_t n = 0; n < kNumPdus; n++) {
+    std::vector<uint8_t> pdu{(uint8_t)pdu_size, (uint8_t)(pdu_size >> 8), 0x40, 0x00};
+    for (size_t i = 0; i < pdu_size; i++) {
+      pdu.push_back(n + i);
+    }
+    auto packet_boundary_flag = PacketBoundaryFlag::FIRST_AUTOMATICALLY_FLUSHABLE;
+    for (size_t offset = 0; offset < pdu.size(); offset += acl_mtu) {
+      size_t end = std::min(pdu.size(), offset + acl_mtu);
+      std::vector<uint8_t> payload(pdu.begin() + offset, pdu.begin() + end);
+      stream.push_back(MakeAclView(packet_boundary_flag, std::move(payload)));
+      packet_boundary_flag = PacketBoundaryFlag::CONTINUING_FRAGMENT;
+    }
+  }
+  return stream;
+}
+
+}  // namespace
+
+// Reassemble the stream as the ACL manager does, and copy the PDUs out as the legacy stack shim does
+static void BM_ReassembleInboundStream(State& state) {
+  auto stream = MakeInboundStream(state.range(0), state.range(1));
+  assembler assembler(AddressWithType(), nullptr, nullptr);
+  std::deque<packet::PacketView<packet::kLittleEndian>> upper_layer;
+  std::vector<uint8_t> copy;
+  uint64_t checksum = 0;
+  for (auto _ : state) {
+    for (const auto& packet : stream) {
+      auto pdu = assembler.recombine(packet);
+      if (!pdu.has_value()) {
+        continue;
+      }
+      copy.clear();
+      pdu->AppendTo(&copy);
+      checksum += copy.back();
+      upper_layer.push_back(pdu.value());
+      if (upper_layer.size() > kPdusInFlight) {
+        upper_layer.pop_front();
+      }
+    }
+  }
+  benchmark::DoNotOptimize(checksum);
+  state.SetBytesProcessed(state.iterations() * kNumPdus * state.range(0));
+  const auto& statistics = assembler.buffer_pool_.GetStatistics();
+  state.counters["pool_hits"] = benchmark::Counter(statistics.hits);
+  state.counters["pool_misses"] = benchmark::Counter(statistics.misses);
+}
+BENCHMARK(BM_ReassembleInboundStream)
+    // A2DP sink over 2-DH5 packets
+    ->Args({895, 679})
+    // OPP / FTP receive over 3-DH5 packets
+    ->Args({4096, 1021})
+    // LE CoC over LE Data Length Extension packets
+    ->Args({1000, 251});
+
+}  // namespace acl_manager
+}  // namespace hci
+}  // namespace bluetooth
@@ -0,0 +1,66 @@
+/*
+ * Copyright 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "hci/acl_manager/reassembly_buffer_pool.h"
+
+#include <algorithm>
+#include <atomic>
+
+namespace bluetooth {
+namespace hci {
+namespace acl_manager {
+
+std::shared_ptr<std::vector<uint8_t>> ReassemblyBufferPool::Acquire(size_t size) {
+  auto size_class = std::lower_bound(kSizeClasses.begin(), kSizeClasses.end(), size);
+  if (size_class == kSizeClasses.end()) {
+    statistics_.misses++;
+    auto buffer = std::make_shared<std::vector<uint8_t>>();
+    buffer->reserve(size);
+    return buffer;
+  }
+
+  // A buffer only referenced by the pool is not used by any packet view
+  auto& buffers = buffers_[size_class - kSizeClasses.begin()];
+  for (auto& buffer : buffers) {
+    if (buffer.use_count() == 1) {
+      // Order the writes to the buffer after the reads of the thread which released it
+      std::atomic_thread_fence(std::memory_order_acquire);
+      statistics_.hits++;
+      buffer->clear();
+      return buffer;
+    }
+  }
+
+  statistics_.misses++;
+  auto buffer = std::make_shared<std::vector<uint8_t>>();
+  buffer->reserve(*size_class);
+  if (buffers.size() < kMaxBuffersPerSizeClass) {
+    buffers.push_back(buffer);
+  }
+  return buffer;
+}
+
+size_t ReassemblyBufferPool::GetPooledBufferCount() const {
+  size_t count = 0;
+  for (const auto& buffers : buffers_) {
+    count += buffers.size();
+  }
+  return count;
+}
+
+}  // namespace acl_manager
+}  // namespace hci
+}  // namespace bluetooth
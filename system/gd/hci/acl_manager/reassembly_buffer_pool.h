@@ -0,0 +1,67 @@
+/*
+ * Copyright 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace bluetooth {
+namespace hci {
+namespace acl_manager {
+
+// Pool of the buffers L2CAP PDUs are reassembled into.
+//
+// Buffers are grouped in size classes, and a buffer can be reused once all the packet views of the PDU it holds are
+// released by the upper layers. Buffers larger than the largest size class are not pooled.
+//
+// Performance:
+//   - Acquire() is O(kMaxBuffersPerSizeClass) and does not allocate when a buffer of the size class is free
+//   - NOT THREAD SAFE, buffers can however be released from any thread
+class ReassemblyBufferPool {
+ public:
+  // Capacity of the buffers of each size class
+  static constexpr std::array<size_t, 4> kSizeClasses = {256, 1024, 4096, 16384};
+  static constexpr size_t kMaxBuffersPerSizeClass = 4;
+
+  struct Statistics {
+    // Buffers reused from the pool
+    size_t hits{0};
+    // Buffers allocated since no buffer of the size class was free
+    size_t misses{0};
+  };
+
+  // Return an empty buffer with capacity for at least |size| bytes
+  std::shared_ptr<std::vector<uint8_t>> Acquire(size_t size);
+
+  const Statistics& GetStatistics() const {
+    return statistics_;
+  }
+
+  // Number of buffers held by the pool, free or in use
+  size_t GetPooledBufferCount() const;
+
+ private:
+  std::array<std::vector<std::shared_ptr<std::vector<uint8_t>>>, kSizeClasses.size()> buffers_;
+  Statistics statistics_;
+};
+
+}  // namespace acl_manager
+}  // namespace hci
+}  // namespace bluetooth
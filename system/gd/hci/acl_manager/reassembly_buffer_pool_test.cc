@@ -0,0 +1,80 @@
+/*
+ * Copyright 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "hci/acl_manager/reassembly_buffer_pool.h"
+
+#include <gtest/gtest.h>
+
+namespace bluetooth {
+namespace hci {
+namespace acl_manager {
+namespace {
+
+TEST(ReassemblyBufferPoolTest, size_classes) {
+  ReassemblyBufferPool pool;
+  ASSERT_GE(pool.Acquire(1)->capacity(), 256u);
+  ASSERT_GE(pool.Acquire(256)->capacity(), 256u);
+  ASSERT_GE(pool.Acquire(257)->capacity(), 1024u);
+  ASSERT_GE(pool.Acquire(16384)->capacity(), 16384u);
+  ASSERT_TRUE(pool.Acquire(0)->empty());
+}
+
+TEST(ReassemblyBufferPoolTest, reuse_released_buffers) {
+  ReassemblyBufferPool pool;
+  auto buffer = pool.Acquire(1000);
+  buffer->assign(1000, 0xaa);
+  const uint8_t* data = buffer->data();
+  buffer.reset();
+
+  buffer = pool.Acquire(700);
+  ASSERT_EQ(buffer->data(), data);
+  ASSERT_TRUE(buffer->empty());
+  ASSERT_EQ(pool.GetStatistics().hits, 1u);
+  ASSERT_EQ(pool.GetStatistics().misses, 1u);
+}
+
+TEST(ReassemblyBufferPoolTest, do_not_reuse_buffers_in_use) {
+  ReassemblyBufferPool pool;
+  std::shared_ptr<const std::vector<uint8_t>> in_use = pool.Acquire(1000);
+  auto buffer = pool.Acquire(1000);
+  ASSERT_NE(buffer, in_use);
+  ASSERT_EQ(pool.GetStatistics().hits, 0u);
+  ASSERT_EQ(pool.GetStatistics().misses, 2u);
+
+  // Buffers of other size classes are not used either
+  buffer.reset();
+  ASSERT_EQ(pool.Acquire(100)->capacity(), 256u);
+  ASSERT_EQ(pool.GetStatistics().misses, 3u);
+}
+
+TEST(ReassemblyBufferPoolTest, limit_pooled_buffers) {
+  ReassemblyBufferPool pool;
+  std::vector<std::shared_ptr<std::vector<uint8_t>>> buffers;
+  for (size_t i = 0; i < ReassemblyBufferPool::kMaxBuffersPerSizeClass + 2; i++) {
+    buffers.push_back(pool.Acquire(1000));
+  }
+  ASSERT_EQ(pool.GetPooledBufferCount(), ReassemblyBufferPool::kMaxBuffersPerSizeClass);
+
+  // Larger PDUs are not pooled
+  buffers.push_back(pool.Acquire(65535));
+  ASSERT_GE(buffers.back()->capacity(), 65535u);
+  ASSERT_EQ(pool.GetPooledBufferCount(), ReassemblyBufferPool::kMaxBuffersPerSizeClass);
+}
+
+}  // namespace
+}  // namespace acl_manager
+}  // namespace hci
+}  // namespace bluetooth
@@ -18,9 +18,12 @@
 
 #include <stdint.h>
 
+#include <map>
+#include <queue>
+
 #include "common/bidi_queue.h"
-#include "common/multi_priority_queue.h"
 #include "hci/acl_manager.h"
+#include "hci/acl_manager/weighted_fair_queue.h"
 #include "hci/controller.h"
 #include "hci/hci_packets.h"
 #include "os/handler.h"
@@ -29,6 +32,8 @@ namespace bluetooth {
 namespace hci {
 namespace acl_manager {
 
+// Schedules the ACL packets of the links with a weighted fair queue, see WeightedFairQueue. The packets of the
+// selected link are fragmented and the fragments are all sent before the next packet is selected.
 class RoundRobinScheduler {
  public:
   RoundRobinScheduler(
@@ -37,24 +42,36 @@ class RoundRobinScheduler {
 
   enum ConnectionType { CLASSIC, LE };
 
+  // Packets dequeued in advance from each link, so that the link can be served in its turn
+  static constexpr size_t kMaxQueuedPacketsPerLink = 2;
+
   struct acl_queue_handler {
     ConnectionType connection_type_;
     std::shared_ptr<acl_manager::AclConnection::Queue> queue_;
     bool dequeue_is_registered_ = false;
-    uint16_t number_of_sent_packets_ = 0;  // Track credits
-    bool high_priority_ = false;           // For A2dp use
   };
 
   void Register(ConnectionType connection_type, uint16_t handle,
                 std::shared_ptr<acl_manager::AclConnection::Queue> queue);
   void Unregister(uint16_t handle);
+  // High priority links are in the ISOCHRONOUS_ADJACENT latency class, for A2DP
   void SetLinkPriority(uint16_t handle, bool high_priority);
+  void SetLinkSchedulingParameters(uint16_t handle, LatencyClass latency_class, uint8_t weight);
   uint16_t GetCredits();
   uint16_t GetLeCredits();
 
  private:
-  void start_round_robin();
+  struct acl_fragment {
+    ConnectionType connection_type_;
+    uint16_t handle_;
+    std::unique_ptr<AclBuilder> packet_;
+  };
+
+  static AclBuffer buffer_of(ConnectionType connection_type);
+  void schedule();
   void buffer_packet(uint16_t acl_handle);
+  void fragment_packet(uint16_t handle, std::unique_ptr<packet::BasePacketBuilder> packet);
+  void update_dequeue_registrations();
   void unregister_all_connections();
   void send_next_fragment();
   std::unique_ptr<AclBuilder> handle_enqueue_next_fragment();
@@ -63,19 +80,14 @@ class RoundRobinScheduler {
   os::Handler* handler_ = nullptr;
   Controller* controller_ = nullptr;
   std::map<uint16_t, acl_queue_handler> acl_queue_handlers_;
-  common::MultiPriorityQueue<std::pair<ConnectionType, std::unique_ptr<AclBuilder>>, 2> fragments_to_send_;
-  uint16_t max_acl_packet_credits_ = 0;
-  uint16_t acl_packet_credits_ = 0;
-  uint16_t le_max_acl_packet_credits_ = 0;
-  uint16_t le_acl_packet_credits_ = 0;
+  WeightedFairQueue<std::unique_ptr<packet::BasePacketBuilder>> packets_to_send_;
+  std::queue<acl_fragment> fragments_to_send_;
   size_t hci_mtu_{0};
   size_t le_hci_mtu_{0};
   std::atomic_bool enqueue_registered_ = false;
   common::BidiQueueEnd<AclBuilder, AclView>* hci_queue_end_ = nullptr;
-  // first register queue end for the Round-robin schedule
-  std::map<uint16_t, acl_queue_handler>::iterator starting_point_;
 };
 
 }  // namespace acl_manager
 }  // namespace hci
-}  // namespace bluetooth
\ No newline at end of file
+}  // namespace bluetooth
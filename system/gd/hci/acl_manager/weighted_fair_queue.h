@@ -0,0 +1,351 @@
+/*
+ * Copyright 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <array>
+#include <map>
+#include <optional>
+#include <queue>
+#include <utility>
+#include <vector>
+
+#include "os/log.h"
+
+namespace bluetooth {
+namespace hci {
+namespace acl_manager {
+
+// Latency classes of the ACL links. The links of a class are served before the links of the next classes.
+enum class LatencyClass : uint8_t {
+  ISOCHRONOUS_ADJACENT = 0,  // e.g. A2DP streaming or LE Audio control
+  INTERACTIVE = 1,           // e.g. HID reports
+  BULK = 2,                  // e.g. file transfers
+};
+
+struct LinkSchedulingParameters {
+  LatencyClass latency_class = LatencyClass::BULK;
+  // Share of the controller buffers and number of fragments sent per round, relative to the links of the same class
+  uint8_t weight = 1;
+};
+
+// Controller buffers, with their own credits
+enum class AclBuffer : uint8_t { CLASSIC = 0, LE = 1 };
+
+// Packet scheduler of the ACL links, and accounting of the controller buffer credits.
+//
+// The links of the same latency class are served with deficit round robin: each link sends in turn up to |weight|
+// fragments, the fragments of a packet exceeding the turn are paid in the next rounds. Costs are counted in fragments
+// as each fragment holds one controller buffer whatever its size.
+//
+// A link can only have a packet scheduled when a credit is available in its buffer, and while it holds less than its
+// share of the buffer, unless the credits left exceed what the other busy links of the buffer are missing from their
+// share. A link is busy while it has packets queued or sent but not completed. The last credit of a buffer is reserved
+// to the latency sensitive links of the buffer while one of them is busy, and until the controller completes a full
+// buffer of packets after they all become idle, so that periodic traffic keeps the reservation between its bursts
+// while idle links do not hold it for the bulk links.
+//
+// Performance:
+//   - Push() and credit accounting are O(log(number of links))
+//   - Pop() is O(number of links)
+//   - NOT THREAD SAFE
+template <typename T>
+class WeightedFairQueue {
+ public:
+  static constexpr size_t kNumLatencyClasses = 3;
+  // Credits reserved to the latency sensitive links
+  static constexpr uint16_t kReservedCredits = 1;
+  // Buffers with less credits do not reserve any
+  static constexpr uint16_t kMinCreditsForReservation = 4;
+
+  // Set the number of packets the controller can buffer. All the credits are available.
+  void SetBufferCredits(AclBuffer buffer, uint16_t max_credits) {
+    buffers_[index(buffer)].max_credits = max_credits;
+    buffers_[index(buffer)].credits = max_credits;
+  }
+
+  void AddLink(uint16_t handle, AclBuffer buffer, LinkSchedulingParameters parameters = {}) {
+    ASSERT(links_.count(handle) == 0);
+    parameters.weight = std::max<uint8_t>(parameters.weight, 1);
+    links_.emplace(handle, Link{buffer, parameters});
+    rings_[index(parameters.latency_class)].handles.push_back(handle);
+  }
+
+  // Remove a link, dropping its queued packets and reclaiming the credits of its outstanding packets
+  void RemoveLink(uint16_t handle) {
+    auto link = links_.find(handle);
+    ASSERT(link != links_.end());
+    return_credits(link->second.buffer, link->second.outstanding_packets);
+    remove_from_ring(handle, link->second.parameters.latency_class);
+    links_.erase(link);
+  }
+
+  bool HasLink(uint16_t handle) const {
+    return links_.count(handle) != 0;
+  }
+
+  // Return false if the link is unknown
+  bool SetLinkParameters(uint16_t handle, LinkSchedulingParameters parameters) {
+    auto link = links_.find(handle);
+    if (link == links_.end()) {
+      return false;
+    }
+    parameters.weight = std::max<uint8_t>(parameters.weight, 1);
+    if (parameters.latency_class != link->second.parameters.latency_class) {
+      remove_from_ring(handle, link->second.parameters.latency_class);
+      rings_[index(parameters.latency_class)].handles.push_back(handle);
+      link->second.deficit = 0;
+    }
+    link->second.parameters = parameters;
+    return true;
+  }
+
+  std::optional<LinkSchedulingParameters> GetLinkParameters(uint16_t handle) const {
+    auto link = links_.find(handle);
+    if (link == links_.end()) {
+      return std::nullopt;
+    }
+    return link->second.parameters;
+  }
+
+  // Queue a packet of the link, |cost| is the number of fragments of the packet
+  void Push(uint16_t handle, T packet, uint16_t cost) {
+    auto link = links_.find(handle);
+    ASSERT(link != links_.end());
+    link->second.packets.push(std::make_pair(std::move(packet), std::max<uint16_t>(cost, 1)));
+  }
+
+  size_t GetQueueSize(uint16_t handle) const {
+    auto link = links_.find(handle);
+    return link == links_.end() ? 0 : link->second.packets.size();
+  }
+
+  // Return the next packet to send and its link, if any link can send
+  std::optional<std::pair<uint16_t, T>> Pop() {
+    update_buffers();
+    for (auto& ring : rings_) {
+      if (!has_eligible_link(ring)) {
+        continue;
+      }
+      // Terminates as the deficit of an eligible link grows at each of its turns
+      while (true) {
+        uint16_t handle = ring.handles[ring.cursor];
+        Link& link = links_.at(handle);
+        if (link.packets.empty() || !is_eligible(link)) {
+          end_turn(ring);
+          continue;
+        }
+        if (!ring.turn_started) {
+          // Carry at most one turn of unused fragments
+          int32_t quantum = link.parameters.weight;
+          link.deficit = std::min(link.deficit, quantum) + quantum;
+          ring.turn_started = true;
+        }
+        if (link.deficit <= 0) {
+          end_turn(ring);
+          continue;
+        }
+        auto packet = std::move(link.packets.front());
+        link.packets.pop();
+        link.deficit -= packet.second;
+        if (link.deficit <= 0) {
+          end_turn(ring);
+        }
+        return std::make_pair(handle, std::move(packet.first));
+      }
+    }
+    return std::nullopt;
+  }
+
+  // Account a fragment sent to the controller, |handle| may have been removed
+  void ConsumeCredit(AclBuffer buffer, uint16_t handle) {
+    ASSERT(buffers_[index(buffer)].credits > 0);
+    buffers_[index(buffer)].credits--;
+    auto link = links_.find(handle);
+    if (link != links_.end()) {
+      link->second.outstanding_packets++;
+    }
+  }
+
+  // Account packets completed by the controller
+  void CompletePackets(uint16_t handle, uint16_t credits) {
+    auto link = links_.find(handle);
+    ASSERT(link != links_.end());
+    if (link->second.outstanding_packets >= credits) {
+      link->second.outstanding_packets -= credits;
+    } else {
+      LOG_WARN("receive more credits than we sent");
+      link->second.outstanding_packets = 0;
+    }
+    return_credits(link->second.buffer, credits);
+  }
+
+  uint16_t GetCredits(AclBuffer buffer) const {
+    return buffers_[index(buffer)].credits;
+  }
+
+  uint16_t GetOutstandingPackets(uint16_t handle) const {
+    auto link = links_.find(handle);
+    return link == links_.end() ? 0 : link->second.outstanding_packets;
+  }
+
+ private:
+  struct Link {
+    AclBuffer buffer;
+    LinkSchedulingParameters parameters;
+    std::queue<std::pair<T, uint16_t>> packets{};
+    // Fragments sent but not completed
+    uint16_t outstanding_packets = 0;
+    // Fragments the link can still send in its turn
+    int32_t deficit = 0;
+  };
+
+  struct Buffer {
+    uint16_t max_credits = 0;
+    uint16_t credits = 0;
+    // State of the links of the buffer, computed by update_buffers()
+    uint32_t busy_weight = 0;
+    uint32_t missing_credits = 0;
+    // Credits to complete before the reservation of the latency sensitive links is released, once they are all idle
+    uint32_t reservation_hold = 0;
+  };
+
+  // Links of a latency class in round robin order
+  struct Ring {
+    std::vector<uint16_t> handles;
+    size_t cursor = 0;
+    bool turn_started = false;
+  };
+
+  static size_t index(AclBuffer buffer) {
+    return static_cast<size_t>(buffer);
+  }
+
+  static size_t index(LatencyClass latency_class) {
+    return static_cast<size_t>(latency_class);
+  }
+
+  void return_credits(AclBuffer buffer, uint16_t credits) {
+    Buffer& b = buffers_[index(buffer)];
+    b.credits += credits;
+    b.reservation_hold -= std::min<uint32_t>(b.reservation_hold, credits);
+    if (b.credits > b.max_credits) {
+      b.credits = b.max_credits;
+      LOG_WARN(
+          "%s packet credits overflow due to receive %hx credits", buffer == AclBuffer::LE ? "le acl" : "acl", credits);
+    }
+  }
+
+  void remove_from_ring(uint16_t handle, LatencyClass latency_class) {
+    Ring& ring = rings_[index(latency_class)];
+    auto it = std::find(ring.handles.begin(), ring.handles.end(), handle);
+    ASSERT(it != ring.handles.end());
+    size_t position = it - ring.handles.begin();
+    ring.handles.erase(it);
+    if (position < ring.cursor) {
+      ring.cursor--;
+    } else if (position == ring.cursor) {
+      ring.turn_started = false;
+    }
+    if (ring.cursor >= ring.handles.size()) {
+      ring.cursor = 0;
+    }
+  }
+
+  void end_turn(Ring& ring) {
+    ring.turn_started = false;
+    ring.cursor = (ring.cursor + 1) % ring.handles.size();
+  }
+
+  bool has_eligible_link(const Ring& ring) const {
+    for (uint16_t handle : ring.handles) {
+      const Link& link = links_.at(handle);
+      if (!link.packets.empty() && is_eligible(link)) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  bool is_busy(const Link& link) const {
+    return !link.packets.empty() || link.outstanding_packets > 0;
+  }
+
+  // Weighted share of the buffer credits of a busy link
+  uint32_t share(const Link& link) const {
+    const Buffer& buffer = buffers_[index(link.buffer)];
+    return std::max<uint32_t>(1, uint32_t{buffer.max_credits} * link.parameters.weight / buffer.busy_weight);
+  }
+
+  // Credits a busy link needs to fill its share
+  uint32_t missing_credits(const Link& link) const {
+    uint32_t link_share = share(link);
+    return link.outstanding_packets < link_share ? link_share - link.outstanding_packets : 0;
+  }
+
+  // Aggregate the state of the links of each buffer, which doesn't change during a Pop(), so that is_eligible() is O(1)
+  void update_buffers() {
+    for (Buffer& buffer : buffers_) {
+      buffer.busy_weight = 0;
+      buffer.missing_credits = 0;
+    }
+    for (const auto& [handle, link] : links_) {
+      Buffer& buffer = buffers_[index(link.buffer)];
+      if (is_busy(link)) {
+        buffer.busy_weight += link.parameters.weight;
+      }
+      if (is_busy(link) && link.parameters.latency_class != LatencyClass::BULK) {
+        buffer.reservation_hold = buffer.max_credits;
+      }
+    }
+    for (const auto& [handle, link] : links_) {
+      if (is_busy(link)) {
+        buffers_[index(link.buffer)].missing_credits += missing_credits(link);
+      }
+    }
+  }
+
+  // |link| must have packets queued
+  bool is_eligible(const Link& link) const {
+    const Buffer& buffer = buffers_[index(link.buffer)];
+    if (buffer.credits == 0) {
+      return false;
+    }
+
+    if (link.parameters.latency_class == LatencyClass::BULK && buffer.reservation_hold > 0 &&
+        buffer.max_credits >= kMinCreditsForReservation && buffer.credits <= kReservedCredits) {
+      return false;
+    }
+
+    if (link.outstanding_packets < share(link)) {
+      return true;
+    }
+
+    // Lend the credits the other busy links do not need to fill their share, the link itself is not missing any
+    return buffer.credits > buffer.missing_credits;
+  }
+
+  std::map<uint16_t, Link> links_;
+  std::array<Buffer, 2> buffers_;
+  std::array<Ring, kNumLatencyClasses> rings_;
+};
+
+}  // namespace acl_manager
+}  // namespace hci
+}  // namespace bluetooth
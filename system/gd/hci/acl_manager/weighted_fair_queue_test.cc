@@ -0,0 +1,470 @@
+/*
+ * Copyright 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "hci/acl_manager/weighted_fair_queue.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <deque>
+#include <string>
+#include <vector>
+
+namespace bluetooth {
+namespace hci {
+namespace acl_manager {
+namespace {
+
+constexpr uint16_t kHandleA = 0x01;
+constexpr uint16_t kHandleB = 0x02;
+constexpr uint16_t kHandleC = 0x03;
+
+class WeightedFairQueueTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    queue_.SetBufferCredits(AclBuffer::CLASSIC, 8);
+    queue_.SetBufferCredits(AclBuffer::LE, 8);
+  }
+
+  // Pop a packet and send it as a single fragment
+  uint16_t PopAndSend() {
+    auto packet = queue_.Pop();
+    if (!packet.has_value()) {
+      return 0;
+    }
+    queue_.ConsumeCredit(packet->second, packet->first);
+    return packet->first;
+  }
+
+  std::vector<uint16_t> PopAll() {
+    std::vector<uint16_t> handles;
+    for (auto packet = queue_.Pop(); packet.has_value(); packet = queue_.Pop()) {
+      handles.push_back(packet->first);
+    }
+    return handles;
+  }
+
+  // The packets carry the buffer of their link, for PopAndSend
+  WeightedFairQueue<AclBuffer> queue_;
+};
+
+TEST_F(WeightedFairQueueTest, round_robin_between_links) {
+  queue_.AddLink(kHandleA, AclBuffer::CLASSIC);
+  queue_.AddLink(kHandleB, AclBuffer::CLASSIC);
+  for (int i = 0; i < 3; i++) {
+    queue_.Push(kHandleA, AclBuffer::CLASSIC, 1);
+    queue_.Push(kHandleB, AclBuffer::CLASSIC, 1);
+  }
+  ASSERT_EQ(PopAll(), std::vector<uint16_t>({kHandleA, kHandleB, kHandleA, kHandleB, kHandleA, kHandleB}));
+}
+
+TEST_F(WeightedFairQueueTest, weighted_round_robin) {
+  queue_.AddLink(kHandleA, AclBuffer::CLASSIC, {LatencyClass::BULK, 3});
+  queue_.AddLink(kHandleB, AclBuffer::CLASSIC, {LatencyClass::BULK, 1});
+  for (int i = 0; i < 6; i++) {
+    queue_.Push(kHandleA, AclBuffer::CLASSIC, 1);
+  }
+  for (int i = 0; i < 2; i++) {
+    queue_.Push(kHandleB, AclBuffer::CLASSIC, 1);
+  }
+  ASSERT_EQ(
+      PopAll(),
+      std::vector<uint16_t>({kHandleA, kHandleA, kHandleA, kHandleB, kHandleA, kHandleA, kHandleA, kHandleB}));
+}
+
+TEST_F(WeightedFairQueueTest, fragmented_packets_paid_in_next_rounds) {
+  queue_.AddLink(kHandleA, AclBuffer::CLASSIC);
+  queue_.AddLink(kHandleB, AclBuffer::CLASSIC);
+  for (int i = 0; i < 2; i++) {
+    queue_.Push(kHandleA, AclBuffer::CLASSIC, 3);
+  }
+  for (int i = 0; i < 6; i++) {
+    queue_.Push(kHandleB, AclBuffer::CLASSIC, 1);
+  }
+  ASSERT_EQ(
+      PopAll(),
+      std::vector<uint16_t>({kHandleA, kHandleB, kHandleB, kHandleB, kHandleA, kHandleB, kHandleB, kHandleB}));
+}
+
+TEST_F(WeightedFairQueueTest, latency_classes_served_in_order) {
+  queue_.AddLink(kHandleA, AclBuffer::CLASSIC, {LatencyClass::BULK, 4});
+  queue_.AddLink(kHandleB, AclBuffer::CLASSIC, {LatencyClass::INTERACTIVE, 1});
+  queue_.AddLink(kHandleC, AclBuffer::LE, {LatencyClass::ISOCHRONOUS_ADJACENT, 1});
+  queue_.Push(kHandleA, AclBuffer::CLASSIC, 1);
+  queue_.Push(kHandleA, AclBuffer::CLASSIC, 1);
+  queue_.Push(kHandleB, AclBuffer::CLASSIC, 1);
+  queue_.Push(kHandleC, AclBuffer::LE, 1);
+  ASSERT_EQ(PopAll(), std::vector<uint16_t>({kHandleC, kHandleB, kHandleA, kHandleA}));
+}
+
+TEST_F(WeightedFairQueueTest, change_latency_class) {
+  queue_.AddLink(kHandleA, AclBuffer::CLASSIC);
+  queue_.AddLink(kHandleB, AclBuffer::CLASSIC);
+  ASSERT_TRUE(queue_.SetLinkParameters(kHandleB, {LatencyClass::ISOCHRONOUS_ADJACENT, 1}));
+  ASSERT_FALSE(queue_.SetLinkParameters(kHandleC, {LatencyClass::ISOCHRONOUS_ADJACENT, 1}));
+  queue_.Push(kHandleA, AclBuffer::CLASSIC, 1);
+  queue_.Push(kHandleB, AclBuffer::CLASSIC, 1);
+  ASSERT_EQ(PopAll(), std::vector<uint16_t>({kHandleB, kHandleA}));
+}
+
+TEST_F(WeightedFairQueueTest, wait_for_credits) {
+  queue_.AddLink(kHandleA, AclBuffer::CLASSIC);
+  queue_.AddLink(kHandleB, AclBuffer::LE);
+  for (int i = 0; i < 9; i++) {
+    queue_.Push(kHandleA, AclBuffer::CLASSIC, 1);
+  }
+  for (int i = 0; i < 8; i++) {
+    ASSERT_EQ(PopAndSend(), kHandleA);
+  }
+  ASSERT_EQ(queue_.GetCredits(AclBuffer::CLASSIC), 0);
+  ASSERT_EQ(queue_.GetOutstandingPackets(kHandleA), 8);
+
+  // The LE buffer is not full
+  queue_.Push(kHandleB, AclBuffer::LE, 1);
+  ASSERT_EQ(PopAndSend(), kHandleB);
+  ASSERT_EQ(PopAndSend(), 0);
+
+  queue_.CompletePackets(kHandleA, 2);
+  ASSERT_EQ(queue_.GetCredits(AclBuffer::CLASSIC), 2);
+  ASSERT_EQ(PopAndSend(), kHandleA);
+}
+
+TEST_F(WeightedFairQueueTest, share_credits_between_busy_links) {
+  queue_.SetBufferCredits(AclBuffer::CLASSIC, 4);
+  queue_.AddLink(kHandleA, AclBuffer::CLASSIC);
+  queue_.AddLink(kHandleB, AclBuffer::CLASSIC);
+  for (int i = 0; i < 4; i++) {
+    queue_.Push(kHandleA, AclBuffer::CLASSIC, 1);
+  }
+
+  // A link alone can use all the credits
+  ASSERT_EQ(PopAndSend(), kHandleA);
+  ASSERT_EQ(PopAndSend(), kHandleA);
+  ASSERT_EQ(PopAndSend(), kHandleA);
+
+  // The credit left goes to the other busy link
+  queue_.Push(kHandleB, AclBuffer::CLASSIC, 1);
+  queue_.Push(kHandleB, AclBuffer::CLASSIC, 1);
+  ASSERT_EQ(PopAndSend(), kHandleB);
+  ASSERT_EQ(PopAndSend(), 0);
+
+  // As do the credits returned, until the other link gets its share
+  queue_.CompletePackets(kHandleA, 1);
+  ASSERT_EQ(PopAndSend(), kHandleB);
+  queue_.CompletePackets(kHandleA, 1);
+  ASSERT_EQ(PopAndSend(), kHandleA);
+}
+
+TEST_F(WeightedFairQueueTest, reserve_credits_for_latency_sensitive_links) {
+  queue_.AddLink(kHandleA, AclBuffer::CLASSIC);
+  queue_.AddLink(kHandleB, AclBuffer::CLASSIC, {LatencyClass::INTERACTIVE, 1});
+
+  // The latency sensitive link is idle, so the last credit is not reserved
+  for (int i = 0; i < 8; i++) {
+    queue_.Push(kHandleA, AclBuffer::CLASSIC, 1);
+  }
+  for (int i = 0; i < 8; i++) {
+    ASSERT_EQ(PopAndSend(), kHandleA);
+  }
+  queue_.CompletePackets(kHandleA, 8);
+
+  // The latency sensitive link has packets queued over its share, the bulk link can't take the last credit
+  for (int i = 0; i < 8; i++) {
+    queue_.Push(kHandleA, AclBuffer::CLASSIC, 1);
+  }
+  for (int i = 0; i < 5; i++) {
+    queue_.Push(kHandleB, AclBuffer::CLASSIC, 1);
+  }
+  for (int i = 0; i < 4; i++) {
+    ASSERT_EQ(PopAndSend(), kHandleB);
+  }
+  for (int i = 0; i < 3; i++) {
+    ASSERT_EQ(PopAndSend(), kHandleA);
+  }
+  ASSERT_EQ(PopAndSend(), 0);
+
+  queue_.CompletePackets(kHandleB, 1);
+  ASSERT_EQ(PopAndSend(), kHandleB);
+
+  // The latency sensitive link is idle, the reservation is held until a full buffer of packets completes
+  queue_.CompletePackets(kHandleB, 4);
+  queue_.CompletePackets(kHandleA, 3);
+  for (int i = 0; i < 3; i++) {
+    queue_.Push(kHandleA, AclBuffer::CLASSIC, 1);
+  }
+  for (int i = 0; i < 7; i++) {
+    ASSERT_EQ(PopAndSend(), kHandleA);
+  }
+  ASSERT_EQ(PopAndSend(), 0);
+
+  queue_.CompletePackets(kHandleA, 1);
+  queue_.Push(kHandleA, AclBuffer::CLASSIC, 1);
+  ASSERT_EQ(PopAndSend(), kHandleA);
+  ASSERT_EQ(PopAndSend(), kHandleA);
+  ASSERT_EQ(queue_.GetCredits(AclBuffer::CLASSIC), 0);
+}
+
+TEST_F(WeightedFairQueueTest, remove_link) {
+  queue_.AddLink(kHandleA, AclBuffer::CLASSIC);
+  queue_.AddLink(kHandleB, AclBuffer::CLASSIC);
+  queue_.Push(kHandleA, AclBuffer::CLASSIC, 1);
+  queue_.Push(kHandleA, AclBuffer::CLASSIC, 1);
+  queue_.Push(kHandleB, AclBuffer::CLASSIC, 1);
+  ASSERT_EQ(PopAndSend(), kHandleA);
+
+  // Reclaim the credits and drop the packets of the link
+  queue_.RemoveLink(kHandleA);
+  ASSERT_FALSE(queue_.HasLink(kHandleA));
+  ASSERT_EQ(queue_.GetCredits(AclBuffer::CLASSIC), 8);
+  ASSERT_EQ(PopAll(), std::vector<uint16_t>({kHandleB}));
+}
+
+TEST_F(WeightedFairQueueTest, credits_overflow) {
+  queue_.AddLink(kHandleA, AclBuffer::CLASSIC);
+  queue_.Push(kHandleA, AclBuffer::CLASSIC, 1);
+  ASSERT_EQ(PopAndSend(), kHandleA);
+  queue_.CompletePackets(kHandleA, 3);
+  ASSERT_EQ(queue_.GetCredits(AclBuffer::CLASSIC), 8);
+  ASSERT_EQ(queue_.GetOutstandingPackets(kHandleA), 0);
+}
+
+// Simulation of the ACL links of a phone, reporting the throughput and the queueing delay of each link. The host
+// side is modelled after RoundRobinScheduler: each link has up to two packets dequeued in advance, and the fragments
+// of the selected packet are all sent before the next packet is selected. The controller transmits the fragments of
+// its links in round robin, one at a time, and completes them right after.
+class AclSchedulingSimulation {
+ public:
+  struct Source {
+    std::string name;
+    uint16_t handle;
+    AclBuffer buffer;
+    LinkSchedulingParameters parameters;
+    size_t packet_size;
+    // Zero for links that always have data to send
+    uint64_t period_us;
+  };
+
+  struct Report {
+    std::string name;
+    double throughput_kbps;
+    double p99_delay_ms;
+    double max_delay_ms;
+  };
+
+  static constexpr uint64_t kTickUs = 25;
+  static constexpr size_t kQueuedPacketsPerLink = 2;
+  static constexpr size_t kClassicMtu = 1021;
+  static constexpr size_t kLeMtu = 251;
+
+  explicit AclSchedulingSimulation(std::vector<Source> sources) : sources_(std::move(sources)) {
+    queue_.SetBufferCredits(AclBuffer::CLASSIC, 8);
+    queue_.SetBufferCredits(AclBuffer::LE, 8);
+    for (const auto& source : sources_) {
+      queue_.AddLink(source.handle, source.buffer, source.parameters);
+      links_.push_back(Link{});
+    }
+  }
+
+  std::vector<Report> Run(uint64_t duration_us) {
+    for (now_us_ = 0; now_us_ < duration_us; now_us_ += kTickUs) {
+      generate_packets();
+      transmit();
+      schedule();
+    }
+    std::vector<Report> reports;
+    for (size_t i = 0; i < sources_.size(); i++) {
+      auto& delays = links_[i].delays_us;
+      double p99 = 0;
+      double max = 0;
+      if (!delays.empty()) {
+        size_t p99_index = delays.size() * 99 / 100;
+        std::nth_element(delays.begin(), delays.begin() + p99_index, delays.end());
+        p99 = delays[p99_index] / 1000.0;
+        max = *std::max_element(delays.begin(), delays.end()) / 1000.0;
+      }
+      reports.push_back(
+          {sources_[i].name, links_[i].transmitted_bytes * 8.0 * 1000.0 / duration_us, p99, max});
+    }
+    return reports;
+  }
+
+ private:
+  struct Link {
+    // Arrival time of the packets not yet dequeued by the scheduler
+    std::deque<uint64_t> upper_queue;
+    uint64_t next_arrival_us = 0;
+    // Fragments in the controller: the arrival time of the packet, and whether it is the last fragment
+    std::deque<std::pair<uint64_t, bool>> controller_queue;
+    uint64_t transmitted_bytes = 0;
+    std::vector<uint64_t> delays_us;
+  };
+
+  struct Packet {
+    uint64_t arrival_us;
+    size_t source;
+  };
+
+  size_t mtu(const Source& source) const {
+    return source.buffer == AclBuffer::CLASSIC ? kClassicMtu : kLeMtu;
+  }
+
+  uint16_t number_of_fragments(const Source& source) const {
+    return (source.packet_size + mtu(source) - 1) / mtu(source);
+  }
+
+  void generate_packets() {
+    for (size_t i = 0; i < sources_.size(); i++) {
+      Link& link = links_[i];
+      if (sources_[i].period_us == 0) {
+        while (link.upper_queue.size() < 4) {
+          link.upper_queue.push_back(now_us_);
+        }
+      } else if (now_us_ >= link.next_arrival_us) {
+        link.upper_queue.push_back(now_us_);
+        link.next_arrival_us += sources_[i].period_us;
+      }
+    }
+  }
+
+  // Dequeue from the links with room and credits, then send the fragments while credits are available
+  void schedule() {
+    while (true) {
+      for (size_t i = 0; i < sources_.size(); i++) {
+        Link& link = links_[i];
+        while (!link.upper_queue.empty() && queue_.GetQueueSize(sources_[i].handle) < kQueuedPacketsPerLink &&
+               queue_.GetCredits(sources_[i].buffer) > 0) {
+          queue_.Push(sources_[i].handle, Packet{link.upper_queue.front(), i}, number_of_fragments(sources_[i]));
+          link.upper_queue.pop_front();
+        }
+      }
+      if (fragments_left_ == 0) {
+        auto packet = queue_.Pop();
+        if (!packet.has_value()) {
+          return;
+        }
+        current_packet_ = packet->second;
+        fragments_left_ = number_of_fragments(sources_[current_packet_.source]);
+      }
+      const Source& source = sources_[current_packet_.source];
+      if (queue_.GetCredits(source.buffer) == 0) {
+        return;
+      }
+      queue_.ConsumeCredit(source.buffer, source.handle);
+      fragments_left_--;
+      links_[current_packet_.source].controller_queue.push_back({current_packet_.arrival_us, fragments_left_ == 0});
+    }
+  }
+
+  // The radio transmits one fragment at a time, from each link in turn
+  void transmit() {
+    if (now_us_ < radio_busy_until_us_) {
+      return;
+    }
+    if (transmitting_ < sources_.size()) {
+      Link& link = links_[transmitting_];
+      const Source& source = sources_[transmitting_];
+      auto fragment = link.controller_queue.front();
+      link.controller_queue.pop_front();
+      if (fragment.second) {
+        link.delays_us.push_back(now_us_ - fragment.first);
+      }
+      queue_.CompletePackets(source.handle, 1);
+      transmitting_ = sources_.size();
+    }
+    for (size_t n = 0; n < sources_.size(); n++) {
+      size_t i = (next_radio_link_ + n) % sources_.size();
+      if (links_[i].controller_queue.empty()) {
+        continue;
+      }
+      const Source& source = sources_[i];
+      size_t fragment_size = std::min(source.packet_size, mtu(source));
+      links_[i].transmitted_bytes += fragment_size;
+      radio_busy_until_us_ = now_us_ + airtime_us(source.buffer, fragment_size);
+      transmitting_ = i;
+      next_radio_link_ = i + 1;
+      return;
+    }
+  }
+
+  // BR/EDR 3-DH5 packets and their return slot, or LE 2M PHY connection events
+  static uint64_t airtime_us(AclBuffer buffer, size_t size) {
+    if (buffer == AclBuffer::CLASSIC) {
+      return 625 + size * 3;
+    }
+    return 300 + size * 4;
+  }
+
+  std::vector<Source> sources_;
+  std::vector<Link> links_;
+  WeightedFairQueue<Packet> queue_;
+  uint64_t now_us_ = 0;
+  Packet current_packet_{};
+  uint16_t fragments_left_ = 0;
+  uint64_t radio_busy_until_us_ = 0;
+  size_t transmitting_ = SIZE_MAX;
+  size_t next_radio_link_ = 0;
+};
+
+std::vector<AclSchedulingSimulation::Report> RunMixedLoad(bool use_latency_classes) {
+  auto parameters = [&](LatencyClass latency_class, uint8_t weight) {
+    return use_latency_classes ? LinkSchedulingParameters{latency_class, weight} : LinkSchedulingParameters{};
+  };
+  AclSchedulingSimulation simulation({
+      // SBC high quality, 328 kbps
+      {"A2DP", 0x01, AclBuffer::CLASSIC, parameters(LatencyClass::ISOCHRONOUS_ADJACENT, 1), 660, 16000},
+      // HID mouse reporting every 11.25 ms
+      {"HID", 0x02, AclBuffer::CLASSIC, parameters(LatencyClass::INTERACTIVE, 1), 16, 11250},
+      // OBEX file transfer
+      {"FTP", 0x03, AclBuffer::CLASSIC, parameters(LatencyClass::BULK, 1), 1021, 0},
+      // LE Audio control point writes
+      {"LEA control", 0x40, AclBuffer::LE, parameters(LatencyClass::ISOCHRONOUS_ADJACENT, 1), 40, 10000},
+      // GATT bulk transfer
+      {"GATT", 0x41, AclBuffer::LE, parameters(LatencyClass::BULK, 1), 495, 0},
+  });
+  auto reports = simulation.Run(10000000);
+  for (const auto& report : reports) {
+    printf(
+        "[%s] %-12s throughput %8.1f kbps, p99 delay %7.2f ms, max delay %7.2f ms\n",
+        use_latency_classes ? "classes " : "baseline",
+        report.name.c_str(),
+        report.throughput_kbps,
+        report.p99_delay_ms,
+        report.max_delay_ms);
+  }
+  return reports;
+}
+
+TEST(AclSchedulingSimulationTest, mixed_load) {
+  auto baseline = RunMixedLoad(false);
+  auto reports = RunMixedLoad(true);
+
+  // A2DP keeps up with the codec rate, and the latency sensitive links wait less than with plain round robin
+  ASSERT_GT(reports[0].throughput_kbps, 320);
+  ASSERT_LT(reports[0].p99_delay_ms, 16);
+  ASSERT_LE(reports[0].p99_delay_ms, baseline[0].p99_delay_ms);
+  ASSERT_LE(reports[1].p99_delay_ms, baseline[1].p99_delay_ms);
+  ASSERT_LE(reports[3].p99_delay_ms, baseline[3].p99_delay_ms);
+
+  // The bulk links still get most of the remaining bandwidth
+  ASSERT_GT(reports[2].throughput_kbps, baseline[2].throughput_kbps * 0.8);
+  ASSERT_GT(reports[4].throughput_kbps, baseline[4].throughput_kbps * 0.8);
+}
+
+}  // namespace
+}  // namespace acl_manager
+}  // namespace hci
+}  // namespace bluetooth
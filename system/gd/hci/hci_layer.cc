@@ -23,6 +23,7 @@
 #include "os/alarm.h"
 #include "os/metrics.h"
 #include "os/queue.h"
+#include "os/spsc_queue.h"
 #include "packet/packet_builder.h"
 #include "storage/storage_module.h"
 
@@ -122,25 +123,28 @@ struct HciLayer::impl {
   void on_outbound_acl_ready() {
     auto packet = acl_queue_.GetDownEnd()->TryDequeue();
     std::vector<uint8_t> bytes;
+    bytes.reserve(packet->size());
     BitInserter bi(bytes);
     packet->Serialize(bi);
-    hal_->sendAclData(bytes);
+    hal_->sendAclData(std::move(bytes));
   }
 
   void on_outbound_sco_ready() {
     auto packet = sco_queue_.GetDownEnd()->TryDequeue();
     std::vector<uint8_t> bytes;
+    bytes.reserve(packet->size());
     BitInserter bi(bytes);
     packet->Serialize(bi);
-    hal_->sendScoData(bytes);
+    hal_->sendScoData(std::move(bytes));
   }
 
   void on_outbound_iso_ready() {
     auto packet = iso_queue_.GetDownEnd()->TryDequeue();
     std::vector<uint8_t> bytes;
+    bytes.reserve(packet->size());
     BitInserter bi(bytes);
     packet->Serialize(bi);
-    hal_->sendIsoData(bytes);
+    hal_->sendIsoData(std::move(bytes));
   }
 
   template <typename TResponse>
@@ -433,8 +437,8 @@ struct HciLayer::impl {
   Alarm* hci_timeout_alarm_{nullptr};
   Alarm* hci_abort_alarm_{nullptr};
 
-  // Acl packets
-  BidiQueue<AclView, AclBuilder> acl_queue_{3 /* TODO: Set queue depth */};
+  // Acl packets, only ever produced and consumed by the HCI and ACL manager handlers
+  BidiQueue<AclView, AclBuilder, os::SpscQueue> acl_queue_{3 /* TODO: Set queue depth */};
   os::EnqueueBuffer<AclView> incoming_acl_buffer_{acl_queue_.GetDownEnd()};
 
   // SCO packets
@@ -0,0 +1,103 @@
+/*
+ * Copyright 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "hci/le_scanning_deduplicator.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <memory>
+
+#include "hci/hci_packets.h"
+#include "os/log.h"
+
+namespace bluetooth::hci {
+
+namespace {
+
+// 64-bit FNV-1a parameters.
+constexpr uint64_t kFnvOffsetBasis = 0xcbf29ce484222325;
+constexpr uint64_t kFnvPrime = 0x100000001b3;
+
+}  // namespace
+
+LeScanningDeduplicator::LeScanningDeduplicator(
+    size_t cache_capacity, std::unique_ptr<common::Timestamper> timestamper)
+    : cache_(std::max<size_t>(cache_capacity, 1)), timestamper_(std::move(timestamper)) {}
+
+void LeScanningDeduplicator::SetParameters(Parameters parameters) {
+  if (parameters.IsEnabled() != parameters_.IsEnabled()) {
+    LOG_INFO("%s advertising report deduplication", parameters.IsEnabled() ? "Enabling" : "Disabling");
+  }
+  parameters_ = parameters;
+  if (!parameters_.IsEnabled()) {
+    cache_.clear();
+  }
+}
+
+bool LeScanningDeduplicator::ShouldReport(
+    uint16_t event_type,
+    uint8_t address_type,
+    Address address,
+    uint8_t advertising_sid,
+    int8_t rssi,
+    const std::vector<uint8_t>& advertising_data) {
+  if (!parameters_.IsEnabled() || address_type == (uint8_t)DirectAdvertisingAddressType::NO_ADDRESS_PROVIDED) {
+    return true;
+  }
+
+  AdvertiserKey key{address, address_type, advertising_sid};
+  LastReport report{HashPayload(event_type, advertising_data), timestamper_->GetTimestamp(), rssi};
+
+  auto it = cache_.find(key);
+  if (it != cache_.end()) {
+    const LastReport& last_report = it->second;
+    bool payload_changed = report.payload_hash != last_report.payload_hash;
+    bool interval_elapsed = report.timestamp - last_report.timestamp >= parameters_.report_interval.count();
+    bool rssi_changed = parameters_.rssi_threshold != 0 &&
+                        std::abs(report.rssi - last_report.rssi) >= parameters_.rssi_threshold;
+    if (!payload_changed && !interval_elapsed && !rssi_changed) {
+      statistics_.suppressed_reports++;
+      return false;
+    }
+    it->second = report;
+  } else {
+    cache_.insert_or_assign(key, report);
+  }
+
+  statistics_.forwarded_reports++;
+  return true;
+}
+
+bool LeScanningDeduplicator::AdvertiserKey::operator==(const AdvertiserKey& other) const {
+  return address == other.address && address_type == other.address_type && sid == other.sid;
+}
+
+std::size_t LeScanningDeduplicator::AdvertiserKeyHash::operator()(const AdvertiserKey& key) const {
+  std::size_t seed = std::hash<Address>{}(key.address);
+  uint16_t type_and_sid = (key.address_type << 8) | key.sid;
+  return seed ^ (std::hash<uint16_t>{}(type_and_sid) + 0x9e3779b9 + (seed << 6) + (seed >> 2));
+}
+
+uint64_t LeScanningDeduplicator::HashPayload(uint16_t event_type, const std::vector<uint8_t>& advertising_data) {
+  uint64_t hash = kFnvOffsetBasis;
+  hash = (hash ^ (event_type & 0xff)) * kFnvPrime;
+  hash = (hash ^ (event_type >> 8)) * kFnvPrime;
+  for (uint8_t byte : advertising_data) {
+    hash = (hash ^ byte) * kFnvPrime;
+  }
+  return hash;
+}
+
+}  // namespace bluetooth::hci
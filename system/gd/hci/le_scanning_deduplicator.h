@@ -0,0 +1,133 @@
+/*
+ * Copyright 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "common/circular_buffer.h"
+#include "common/lru_cache.h"
+#include "hci/address.h"
+
+namespace bluetooth::hci {
+
+/// The LE Scanning deduplicator drops the complete advertising reports
+/// that bring nothing new since the last report forwarded for the same
+/// advertiser, so that scanning with the controller duplicate filter
+/// disabled does not flood the upper layers with identical reports.
+/// A report is forwarded when:
+/// - the advertising data or the event type changed, or
+/// - the reporting interval elapsed since the last forwarded report, or
+/// - the RSSI moved by at least the RSSI threshold.
+
+class LeScanningDeduplicator {
+ public:
+  /// Default number of advertisers whose last report is remembered.
+  static constexpr size_t kDefaultCacheCapacity = 256;
+
+  struct Parameters {
+    /// Minimum delay between two identical reports of the same
+    /// advertiser. Zero disables the deduplication.
+    std::chrono::milliseconds report_interval{0};
+    /// Minimum RSSI change forwarding an otherwise identical report.
+    /// Zero ignores the RSSI changes.
+    uint8_t rssi_threshold{0};
+
+    bool IsEnabled() const {
+      return report_interval.count() > 0;
+    }
+  };
+
+  /// Counters of the deduplication, reported in dumpsys.
+  struct Statistics {
+    /// Reports forwarded while the deduplication was enabled.
+    uint64_t forwarded_reports{0};
+    /// Reports dropped as duplicates of the last forwarded report.
+    uint64_t suppressed_reports{0};
+  };
+
+  explicit LeScanningDeduplicator(
+      size_t cache_capacity = kDefaultCacheCapacity,
+      std::unique_ptr<common::Timestamper> timestamper = std::make_unique<common::TimestamperInMilliseconds>());
+  LeScanningDeduplicator(const LeScanningDeduplicator&) = delete;
+  LeScanningDeduplicator& operator=(const LeScanningDeduplicator&) = delete;
+
+  /// Configure the deduplication. The remembered reports are dropped
+  /// when the deduplication is disabled.
+  void SetParameters(Parameters parameters);
+
+  /// Process a complete advertising report, as returned by the
+  /// LE Scanning reassembler.
+  /// Returns true if the report should be forwarded to the scanners.
+  bool ShouldReport(
+      uint16_t event_type,
+      uint8_t address_type,
+      Address address,
+      uint8_t advertising_sid,
+      int8_t rssi,
+      const std::vector<uint8_t>& advertising_data);
+
+  const Parameters& GetParameters() const {
+    return parameters_;
+  }
+
+  const Statistics& GetStatistics() const {
+    return statistics_;
+  }
+
+  size_t GetCacheSize() const {
+    return cache_.size();
+  }
+
+  size_t GetCacheCapacity() const {
+    return cache_.capacity();
+  }
+
+ private:
+  /// Identifies the advertising set of an advertiser. Anonymous
+  /// advertisers are never deduplicated.
+  struct AdvertiserKey {
+    Address address;
+    uint8_t address_type;
+    uint8_t sid;
+
+    bool operator==(const AdvertiserKey& other) const;
+  };
+
+  struct AdvertiserKeyHash {
+    std::size_t operator()(const AdvertiserKey& key) const;
+  };
+
+  /// Last report forwarded for an advertiser.
+  struct LastReport {
+    /// Hash of the event type and advertising data.
+    uint64_t payload_hash;
+    long long timestamp;
+    int8_t rssi;
+  };
+
+  /// Hash the event type and advertising data of a report.
+  static uint64_t HashPayload(uint16_t event_type, const std::vector<uint8_t>& advertising_data);
+
+  Parameters parameters_;
+  common::LruCache<AdvertiserKey, LastReport, AdvertiserKeyHash> cache_;
+  std::unique_ptr<common::Timestamper> timestamper_;
+  Statistics statistics_;
+};
+
+}  // namespace bluetooth::hci
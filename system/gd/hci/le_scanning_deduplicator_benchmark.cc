@@ -0,0 +1,128 @@
+/*
+ * Copyright 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "hci/hci_packets.h"
+#include "hci/le_scanning_deduplicator.h"
+
+using ::benchmark::State;
+
+namespace bluetooth {
+namespace hci {
+
+namespace {
+
+// Event type fields.
+constexpr uint16_t kLegacy = 0x10;
+constexpr uint16_t kComplete = 0x0;
+
+constexpr uint8_t kSidNotPresent = 0xff;
+
+// Number of advertisers in the synthetic trace, as seen in crowded places
+constexpr uint16_t kNumAdvertisers = 200;
+// Every advertiser advertises every 100ms during 10s
+constexpr long long kAdvertisingIntervalMs = 100;
+constexpr long long kTraceDurationMs = 10000;
+// One advertiser in 10 updates its data every second, e.g. a sensor
+constexpr long long kDataUpdateIntervalMs = 1000;
+
+struct AdvertisingReport {
+  long long timestamp;
+  Address address;
+  int8_t rssi;
+  std::vector<uint8_t> advertising_data;
+};
+
+class FakeTimestamper : public common::Timestamper {
+ public:
+  explicit FakeTimestamper(const long long* timestamp) : timestamp_(timestamp) {}
+  long long GetTimestamp() const override {
+    return *timestamp_;
+  }
+
+ private:
+  const long long* timestamp_;
+};
+
+// Manufacturer Specific Data of 31 bytes, with a counter for advertisers updating their data
+std::vector<uint8_t> MakeAdvertisingData(uint16_t index, uint8_t counter) {
+  std::vector<uint8_t> data{30, 0xff};
+  for (size_t i = 2; i < 31; i++) {
+    data.push_back(index + i);
+  }
+  data.back() = counter;
+  return data;
+}
+
+// Reports of all the advertisers in time order, the RSSI of each advertiser jittering by
+// a few dB around its mean value
+std::vector<AdvertisingReport> MakeAdvertisingTrace() {
+  std::vector<AdvertisingReport> trace;
+  for (long long now = 0; now < kTraceDurationMs; now += kAdvertisingIntervalMs) {
+    for (uint16_t index = 0; index < kNumAdvertisers; index++) {
+      Address address({0xc0, 0x01, 0x02, 0x03, (uint8_t)(index >> 8), (uint8_t)index});
+      int8_t rssi = -50 - (index % 40) + (int8_t)((now / kAdvertisingIntervalMs * 7 + index) % 5);
+      uint8_t counter = index % 10 == 0 ? now / kDataUpdateIntervalMs : 0;
+      trace.push_back({now, address, rssi, MakeAdvertisingData(index, counter)});
+    }
+  }
+  return trace;
+}
+
+}  // namespace
+
+static void BM_ReplayAdvertisingTrace(State& state) {
+  auto trace = MakeAdvertisingTrace();
+  long long now = 0;
+  LeScanningDeduplicator deduplicator(
+      LeScanningDeduplicator::kDefaultCacheCapacity, std::make_unique<FakeTimestamper>(&now));
+  deduplicator.SetParameters(
+      {.report_interval = std::chrono::milliseconds(state.range(0)), .rssi_threshold = (uint8_t)state.range(1)});
+  uint64_t forwarded_reports = 0;
+  long long trace_start = 0;
+  for (auto _ : state) {
+    for (const auto& report : trace) {
+      now = trace_start + report.timestamp;
+      if (deduplicator.ShouldReport(
+              kLegacy | kComplete,
+              (uint8_t)AddressType::RANDOM_DEVICE_ADDRESS,
+              report.address,
+              kSidNotPresent,
+              report.rssi,
+              report.advertising_data)) {
+        forwarded_reports++;
+      }
+    }
+    trace_start += kTraceDurationMs;
+  }
+  state.SetItemsProcessed(state.iterations() * trace.size());
+  state.counters["forwarded_reports"] = benchmark::Counter(forwarded_reports, benchmark::Counter::kAvgIterations);
+  state.counters["suppressed_reports"] =
+      benchmark::Counter(deduplicator.GetStatistics().suppressed_reports, benchmark::Counter::kAvgIterations);
+}
+BENCHMARK(BM_ReplayAdvertisingTrace)
+    ->Args({0, 0})
+    ->Args({1000, 0})
+    ->Args({1000, 10})
+    ->Args({5000, 10});
+
+}  // namespace hci
+}  // namespace bluetooth
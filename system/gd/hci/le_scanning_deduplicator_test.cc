@@ -0,0 +1,170 @@
+/*
+ * Copyright 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "hci/le_scanning_deduplicator.h"
+
+#include <gtest/gtest.h>
+
+#include "hci/hci_packets.h"
+
+using namespace bluetooth;
+using namespace std::chrono_literals;
+
+namespace bluetooth::hci {
+
+// Event type fields.
+static constexpr uint16_t kScannable = 0x2;
+static constexpr uint16_t kLegacy = 0x10;
+static constexpr uint16_t kComplete = 0x0;
+
+// Defaults for other fields.
+static constexpr uint8_t kSidNotPresent = 0xff;
+static constexpr uint8_t kPublic = (uint8_t)AddressType::PUBLIC_DEVICE_ADDRESS;
+static constexpr uint8_t kAnonymous = (uint8_t)DirectAdvertisingAddressType::NO_ADDRESS_PROVIDED;
+
+// Test addresses.
+static const Address kTestAddress = Address({0, 1, 2, 3, 4, 5});
+static const Address kOtherTestAddress = Address({0, 1, 2, 3, 4, 6});
+
+static const std::vector<uint8_t> kTestData = {0x2, 0x1, 0x6};
+static const std::vector<uint8_t> kOtherTestData = {0x2, 0x1, 0x4};
+
+class FakeTimestamper : public common::Timestamper {
+ public:
+  explicit FakeTimestamper(long long* timestamp) : timestamp_(timestamp) {}
+  long long GetTimestamp() const override {
+    return *timestamp_;
+  }
+
+ private:
+  long long* timestamp_;
+};
+
+class LeScanningDeduplicatorTest : public ::testing::Test {
+ public:
+  LeScanningDeduplicatorTest()
+      : deduplicator_(
+            LeScanningDeduplicator::kDefaultCacheCapacity, std::make_unique<FakeTimestamper>(&timestamp_)) {
+    deduplicator_.SetParameters({.report_interval = 1000ms, .rssi_threshold = 10});
+  }
+
+  bool ShouldReport(
+      Address address,
+      int8_t rssi,
+      const std::vector<uint8_t>& advertising_data,
+      uint8_t address_type = kPublic,
+      uint8_t advertising_sid = kSidNotPresent) {
+    return deduplicator_.ShouldReport(
+        kLegacy | kComplete, address_type, address, advertising_sid, rssi, advertising_data);
+  }
+
+  long long timestamp_{0};
+  LeScanningDeduplicator deduplicator_;
+};
+
+TEST_F(LeScanningDeduplicatorTest, disabled) {
+  deduplicator_.SetParameters({});
+  ASSERT_TRUE(ShouldReport(kTestAddress, -60, kTestData));
+  ASSERT_TRUE(ShouldReport(kTestAddress, -60, kTestData));
+  ASSERT_EQ(deduplicator_.GetCacheSize(), 0u);
+  ASSERT_EQ(deduplicator_.GetStatistics().suppressed_reports, 0u);
+}
+
+TEST_F(LeScanningDeduplicatorTest, suppress_identical_reports) {
+  ASSERT_TRUE(ShouldReport(kTestAddress, -60, kTestData));
+  ASSERT_FALSE(ShouldReport(kTestAddress, -60, kTestData));
+  timestamp_ += 999;
+  ASSERT_FALSE(ShouldReport(kTestAddress, -55, kTestData));
+  ASSERT_EQ(deduplicator_.GetStatistics().forwarded_reports, 1u);
+  ASSERT_EQ(deduplicator_.GetStatistics().suppressed_reports, 2u);
+}
+
+TEST_F(LeScanningDeduplicatorTest, report_after_interval) {
+  ASSERT_TRUE(ShouldReport(kTestAddress, -60, kTestData));
+  timestamp_ += 500;
+  ASSERT_FALSE(ShouldReport(kTestAddress, -60, kTestData));
+  // The interval is counted from the last forwarded report.
+  timestamp_ += 500;
+  ASSERT_TRUE(ShouldReport(kTestAddress, -60, kTestData));
+  timestamp_ += 500;
+  ASSERT_FALSE(ShouldReport(kTestAddress, -60, kTestData));
+}
+
+TEST_F(LeScanningDeduplicatorTest, report_changed_payload) {
+  ASSERT_TRUE(ShouldReport(kTestAddress, -60, kTestData));
+  ASSERT_TRUE(ShouldReport(kTestAddress, -60, kOtherTestData));
+  ASSERT_FALSE(ShouldReport(kTestAddress, -60, kOtherTestData));
+
+  // The event type is part of the payload.
+  ASSERT_TRUE(deduplicator_.ShouldReport(
+      kLegacy | kScannable | kComplete, kPublic, kTestAddress, kSidNotPresent, -60, kOtherTestData));
+}
+
+TEST_F(LeScanningDeduplicatorTest, report_rssi_change) {
+  ASSERT_TRUE(ShouldReport(kTestAddress, -60, kTestData));
+  ASSERT_FALSE(ShouldReport(kTestAddress, -51, kTestData));
+  ASSERT_TRUE(ShouldReport(kTestAddress, -70, kTestData));
+  ASSERT_FALSE(ShouldReport(kTestAddress, -61, kTestData));
+  ASSERT_TRUE(ShouldReport(kTestAddress, -80, kTestData));
+
+  // RSSI changes are ignored without threshold.
+  deduplicator_.SetParameters({.report_interval = 1000ms, .rssi_threshold = 0});
+  ASSERT_FALSE(ShouldReport(kTestAddress, -20, kTestData));
+}
+
+TEST_F(LeScanningDeduplicatorTest, distinct_advertisers) {
+  ASSERT_TRUE(ShouldReport(kTestAddress, -60, kTestData));
+  ASSERT_TRUE(ShouldReport(kOtherTestAddress, -60, kTestData));
+  ASSERT_TRUE(ShouldReport(kTestAddress, -60, kTestData, (uint8_t)AddressType::RANDOM_DEVICE_ADDRESS));
+  ASSERT_TRUE(ShouldReport(kTestAddress, -60, kTestData, kPublic, 1));
+  ASSERT_TRUE(ShouldReport(kTestAddress, -60, kTestData, kPublic, 2));
+  ASSERT_FALSE(ShouldReport(kTestAddress, -60, kTestData, kPublic, 2));
+  ASSERT_EQ(deduplicator_.GetCacheSize(), 5u);
+}
+
+TEST_F(LeScanningDeduplicatorTest, anonymous_advertisers_are_reported) {
+  ASSERT_TRUE(ShouldReport(Address::kEmpty, -60, kTestData, kAnonymous, 1));
+  ASSERT_TRUE(ShouldReport(Address::kEmpty, -60, kTestData, kAnonymous, 1));
+  ASSERT_EQ(deduplicator_.GetCacheSize(), 0u);
+}
+
+TEST_F(LeScanningDeduplicatorTest, evict_least_recently_reported) {
+  LeScanningDeduplicator deduplicator(2, std::make_unique<FakeTimestamper>(&timestamp_));
+  deduplicator.SetParameters({.report_interval = 1000ms});
+  auto should_report = [&](Address address) {
+    return deduplicator.ShouldReport(kLegacy | kComplete, kPublic, address, kSidNotPresent, -60, kTestData);
+  };
+
+  ASSERT_TRUE(should_report(Address({0, 1, 2, 3, 4, 1})));
+  ASSERT_TRUE(should_report(Address({0, 1, 2, 3, 4, 2})));
+  ASSERT_FALSE(should_report(Address({0, 1, 2, 3, 4, 1})));
+  ASSERT_TRUE(should_report(Address({0, 1, 2, 3, 4, 3})));
+  ASSERT_EQ(deduplicator.GetCacheSize(), 2u);
+
+  // The second advertiser was evicted, the first one is still remembered.
+  ASSERT_FALSE(should_report(Address({0, 1, 2, 3, 4, 1})));
+  ASSERT_TRUE(should_report(Address({0, 1, 2, 3, 4, 2})));
+}
+
+TEST_F(LeScanningDeduplicatorTest, disabling_forgets_reports) {
+  ASSERT_TRUE(ShouldReport(kTestAddress, -60, kTestData));
+  deduplicator_.SetParameters({});
+  ASSERT_EQ(deduplicator_.GetCacheSize(), 0u);
+  deduplicator_.SetParameters({.report_interval = 1000ms});
+  ASSERT_TRUE(ShouldReport(kTestAddress, -60, kTestData));
+}
+
+}  // namespace bluetooth::hci
@@ -15,7 +15,9 @@
  */
 #include "hci/le_scanning_manager.h"
 
+#include <future>
 #include <memory>
+#include <mutex>
 #include <unordered_map>
 
 #include "hci/acl_manager.h"
@@ -23,9 +25,11 @@
 #include "hci/hci_layer.h"
 #include "hci/hci_packets.h"
 #include "hci/le_periodic_sync_manager.h"
+#include "hci/le_scanning_deduplicator.h"
 #include "hci/le_scanning_interface.h"
 #include "hci/le_scanning_reassembler.h"
 #include "hci/vendor_specific_event_manager.h"
+#include "hci_le_scanning_manager_generated.h"
 #include "module.h"
 #include "os/handler.h"
 #include "os/log.h"
@@ -57,6 +61,7 @@ constexpr uint8_t kDataStatusBits = 5;
 
 // system properties
 const std::string kLeRxPathLossCompProperty = "bluetooth.hardware.radio.le_rx_path_loss_comp_db";
+const std::string kLeScanReassemblyCacheSizeProperty = "bluetooth.core.le.scan_reassembly_cache_size";
 
 const ModuleFactory LeScanningManager::Factory = ModuleFactory([]() { return new LeScanningManager(); });
 
@@ -69,6 +74,7 @@ enum class ScanApiType {
 struct Scanner {
   Uuid app_uuid;
   bool in_use;
+  LeScanningDeduplicator::Parameters deduplication_parameters;
 };
 
 class NullScanningCallback : public ScanningCallback {
@@ -218,6 +224,7 @@ struct LeScanningManager::impl : public LeAddressManagerCallback {
     for (size_t i = 0; i < scanners_.size(); i++) {
       scanners_[i].app_uuid = Uuid::kEmpty;
       scanners_[i].in_use = false;
+      scanners_[i].deduplication_parameters = {};
     }
     batch_scan_config_.current_state = BatchScanState::DISABLED_STATE;
     batch_scan_config_.ref_value = kInvalidScannerId;
@@ -331,13 +338,17 @@ struct LeScanningManager::impl : public LeAddressManagerCallback {
       LOG_INFO("Dropping invalid advertising event");
       return;
     }
-    std::vector<LeAdvertisingResponseRaw> reports = event_view.GetResponses();
-    if (reports.empty()) {
+    // The reports are decoded one at a time into the same element, this runs for every report while scanning
+    auto reports = event_view.GetResponsesRange();
+    auto report_it = reports.begin();
+    const auto reports_end = reports.end();
+    if (report_it == reports_end) {
       LOG_INFO("Zero results in advertising event");
       return;
     }
 
-    for (LeAdvertisingResponseRaw report : reports) {
+    for (; report_it != reports_end; ++report_it) {
+      const LeAdvertisingResponseRaw& report = *report_it;
       uint16_t extended_event_type = 0;
       switch (report.event_type_) {
         case AdvertisingEventType::ADV_IND:
@@ -388,13 +399,16 @@ struct LeScanningManager::impl : public LeAddressManagerCallback {
       return;
     }
 
-    std::vector<LeExtendedAdvertisingResponseRaw> reports = event_view.GetResponses();
-    if (reports.empty()) {
+    auto reports = event_view.GetResponsesRange();
+    auto report_it = reports.begin();
+    const auto reports_end = reports.end();
+    if (report_it == reports_end) {
       LOG_INFO("Zero results in advertising event");
       return;
     }
 
-    for (LeExtendedAdvertisingResponseRaw& report : reports) {
+    for (; report_it != reports_end; ++report_it) {
+      const LeExtendedAdvertisingResponseRaw& report = *report_it;
       uint16_t event_type = report.connectable_ | (report.scannable_ << kScannableBit) |
                             (report.directed_ << kDirectedBit) | (report.scan_response_ << kScanResponseBit) |
                             (report.legacy_ << kLegacyBit) | ((uint16_t)report.data_status_ << kDataStatusBits);
@@ -430,11 +444,15 @@ struct LeScanningManager::impl : public LeAddressManagerCallback {
     // TODO(b/275754998): Improve the decision on what to do with scan responses: Only when used
     // with hardware-filtering features should we ignore waiting for scan response, and make sure
     // scan responses are still reported too.
-    scanning_reassembler_.SetIgnoreScanResponses(
-        filter_policy_ == LeScanningFilterPolicy::FILTER_ACCEPT_LIST_ONLY);
+    std::optional<std::vector<uint8_t>> complete_advertising_data;
+    {
+      const std::lock_guard<std::mutex> lock(dumpsys_mutex_);
+      scanning_reassembler_.SetIgnoreScanResponses(
+          filter_policy_ == LeScanningFilterPolicy::FILTER_ACCEPT_LIST_ONLY);
 
-    auto complete_advertising_data = scanning_reassembler_.ProcessAdvertisingReport(
-        event_type, address_type, address, advertising_sid, advertising_data);
+      complete_advertising_data = scanning_reassembler_.ProcessAdvertisingReport(
+          event_type, address_type, address, advertising_sid, advertising_data);
+    }
 
     if (complete_advertising_data.has_value()) {
       switch (address_type) {
@@ -448,6 +466,16 @@ struct LeScanningManager::impl : public LeAddressManagerCallback {
           break;
       }
 
+      // Drop the reports bringing nothing new since the last report of
+      // the same advertiser, when all the scanners agreed to it.
+      {
+        const std::lock_guard<std::mutex> lock(dumpsys_mutex_);
+        if (!scanning_deduplicator_.ShouldReport(
+                event_type, address_type, address, advertising_sid, rssi, complete_advertising_data.value())) {
+          return;
+        }
+      }
+
       scanning_callbacks_->OnScanResult(
           event_type,
           address_type,
@@ -518,6 +546,8 @@ struct LeScanningManager::impl : public LeAddressManagerCallback {
       if (!scanners_[i].in_use) {
         scanners_[i].app_uuid = app_uuid;
         scanners_[i].in_use = true;
+        scanners_[i].deduplication_parameters = {};
+        update_deduplication_parameters();
         scanning_callbacks_->OnScannerRegistered(app_uuid, i, ScanningCallback::ScanningStatus::SUCCESS);
         return;
       }
@@ -536,6 +566,8 @@ struct LeScanningManager::impl : public LeAddressManagerCallback {
     if (scanners_[scanner_id].in_use) {
       scanners_[scanner_id].in_use = false;
       scanners_[scanner_id].app_uuid = Uuid::kEmpty;
+      scanners_[scanner_id].deduplication_parameters = {};
+      update_deduplication_parameters();
     } else {
       LOG_WARN("Unregister scanner with unused scanner id");
     }
@@ -638,6 +670,44 @@ struct LeScanningManager::impl : public LeAddressManagerCallback {
     scanning_callbacks_->OnSetScannerParameterComplete(scanner_id, ScanningCallback::SUCCESS);
   }
 
+  void set_scan_deduplication_parameters(ScannerId scanner_id, uint32_t report_interval_ms, uint8_t rssi_threshold) {
+    if (scanner_id <= 0 || scanner_id > kMaxAppNum || !scanners_[scanner_id].in_use) {
+      LOG_WARN("Invalid scanner id %d", scanner_id);
+      return;
+    }
+    scanners_[scanner_id].deduplication_parameters = {
+        .report_interval = std::chrono::milliseconds(report_interval_ms), .rssi_threshold = rssi_threshold};
+    update_deduplication_parameters();
+  }
+
+  // All the scanners get the same scan results, the reports are
+  // deduplicated only when all the registered scanners enabled the
+  // deduplication, with the shortest interval and smallest threshold.
+  void update_deduplication_parameters() {
+    std::optional<LeScanningDeduplicator::Parameters> parameters;
+    for (uint8_t i = 1; i <= kMaxAppNum; i++) {
+      if (!scanners_[i].in_use) {
+        continue;
+      }
+      const LeScanningDeduplicator::Parameters& scanner_parameters = scanners_[i].deduplication_parameters;
+      if (!scanner_parameters.IsEnabled()) {
+        parameters = LeScanningDeduplicator::Parameters{};
+        break;
+      }
+      if (!parameters.has_value()) {
+        parameters = scanner_parameters;
+        continue;
+      }
+      parameters->report_interval = std::min(parameters->report_interval, scanner_parameters.report_interval);
+      if (parameters->rssi_threshold == 0 ||
+          (scanner_parameters.rssi_threshold != 0 && scanner_parameters.rssi_threshold < parameters->rssi_threshold)) {
+        parameters->rssi_threshold = scanner_parameters.rssi_threshold;
+      }
+    }
+    const std::lock_guard<std::mutex> lock(dumpsys_mutex_);
+    scanning_deduplicator_.SetParameters(parameters.value_or(LeScanningDeduplicator::Parameters{}));
+  }
+
   void set_scan_filter_policy(LeScanningFilterPolicy filter_policy) {
     filter_policy_ = filter_policy;
   }
@@ -1634,7 +1704,10 @@ struct LeScanningManager::impl : public LeAddressManagerCallback {
   bool is_scanning_ = false;
   bool scan_on_resume_ = false;
   bool paused_ = false;
-  LeScanningReassembler scanning_reassembler_;
+  LeScanningReassembler scanning_reassembler_{os::GetSystemPropertyUint32(
+      kLeScanReassemblyCacheSizeProperty, LeScanningReassembler::kDefaultCacheCapacity)};
+  LeScanningDeduplicator scanning_deduplicator_;
+  mutable std::mutex dumpsys_mutex_;
   bool is_filter_supported_ = false;
   bool is_ad_type_filter_supported_ = false;
   bool is_batch_scan_supported_ = false;
@@ -1652,6 +1725,10 @@ struct LeScanningManager::impl : public LeAddressManagerCallback {
   uint16_t total_num_of_advt_tracked_ = 0x00;
   int8_t le_rx_path_loss_comp_ = 0;
 
+  void Dump(
+      std::promise<flatbuffers::Offset<LeScanningManagerData>> promise,
+      flatbuffers::FlatBufferBuilder* fb_builder) const;
+
   static void check_status(CommandCompleteView view) {
     switch (view.GetCommandOpCode()) {
       case (OpCode::LE_SET_SCAN_ENABLE): {
@@ -1707,6 +1784,57 @@ std::string LeScanningManager::ToString() const {
   return "Le Scanning Manager";
 }
 
+void LeScanningManager::impl::Dump(
+    std::promise<flatbuffers::Offset<LeScanningManagerData>> promise,
+    flatbuffers::FlatBufferBuilder* fb_builder) const {
+  const std::lock_guard<std::mutex> lock(dumpsys_mutex_);
+  const LeScanningReassembler::Statistics& statistics = scanning_reassembler_.GetStatistics();
+
+  auto title = fb_builder->CreateString("----- Le Scanning Manager Dumpsys -----");
+
+  LeScanningReassemblerDataBuilder reassembler_builder(*fb_builder);
+  reassembler_builder.add_cache_capacity(scanning_reassembler_.GetCacheCapacity());
+  reassembler_builder.add_cache_size(scanning_reassembler_.GetCacheSize());
+  reassembler_builder.add_reassembled_reports(statistics.reassembled_reports);
+  reassembler_builder.add_evictions(statistics.evictions);
+  reassembler_builder.add_expirations(statistics.expirations);
+  reassembler_builder.add_orphan_scan_responses(statistics.orphan_scan_responses);
+  auto reassembler_data = reassembler_builder.Finish();
+
+  const LeScanningDeduplicator::Parameters& deduplication_parameters = scanning_deduplicator_.GetParameters();
+  const LeScanningDeduplicator::Statistics& deduplication_statistics = scanning_deduplicator_.GetStatistics();
+  LeScanningDeduplicatorDataBuilder deduplicator_builder(*fb_builder);
+  deduplicator_builder.add_report_interval_ms(deduplication_parameters.report_interval.count());
+  deduplicator_builder.add_rssi_threshold(deduplication_parameters.rssi_threshold);
+  deduplicator_builder.add_cache_capacity(scanning_deduplicator_.GetCacheCapacity());
+  deduplicator_builder.add_cache_size(scanning_deduplicator_.GetCacheSize());
+  deduplicator_builder.add_forwarded_reports(deduplication_statistics.forwarded_reports);
+  deduplicator_builder.add_suppressed_reports(deduplication_statistics.suppressed_reports);
+  auto deduplicator_data = deduplicator_builder.Finish();
+
+  LeScanningManagerDataBuilder builder(*fb_builder);
+  builder.add_title(title);
+  builder.add_reassembler(reassembler_data);
+  builder.add_deduplicator(deduplicator_data);
+
+  flatbuffers::Offset<LeScanningManagerData> dumpsys_data = builder.Finish();
+  promise.set_value(dumpsys_data);
+}
+
+DumpsysDataFinisher LeScanningManager::GetDumpsysData(flatbuffers::FlatBufferBuilder* fb_builder) const {
+  ASSERT(fb_builder != nullptr);
+
+  std::promise<flatbuffers::Offset<LeScanningManagerData>> promise;
+  auto future = promise.get_future();
+  pimpl_->Dump(std::move(promise), fb_builder);
+
+  auto dumpsys_data = future.get();
+
+  return [dumpsys_data](DumpsysDataBuilder* dumpsys_builder) {
+    dumpsys_builder->add_hci_le_scanning_manager_dumpsys_data(dumpsys_data);
+  };
+}
+
 void LeScanningManager::RegisterScanner(Uuid app_uuid) {
   CallOn(pimpl_.get(), &impl::register_scanner, app_uuid);
 }
@@ -1724,6 +1852,11 @@ void LeScanningManager::SetScanParameters(
   CallOn(pimpl_.get(), &impl::set_scan_parameters, scanner_id, scan_type, scan_interval[0], scan_window[0]);
 }
 
+void LeScanningManager::SetScanDeduplicationParameters(
+    ScannerId scanner_id, uint32_t report_interval_ms, uint8_t rssi_threshold) {
+  CallOn(pimpl_.get(), &impl::set_scan_deduplication_parameters, scanner_id, report_interval_ms, rssi_threshold);
+}
+
 void LeScanningManager::SetScanFilterPolicy(LeScanningFilterPolicy filter_policy) {
   CallOn(pimpl_.get(), &impl::set_scan_filter_policy, filter_policy);
 }
@@ -56,6 +56,13 @@ class LeScanningManager : public bluetooth::Module {
 
   virtual void SetScanFilterPolicy(LeScanningFilterPolicy filter_policy);
 
+  /* Report deduplication of |scanner_id|, a zero interval disables it. The
+   * scanners share the scan results, so the reports are only deduplicated when
+   * all the registered scanners enabled it, with the shortest interval and the
+   * smallest RSSI threshold of all of them. */
+  virtual void SetScanDeduplicationParameters(
+      ScannerId scanner_id, uint32_t report_interval_ms, uint8_t rssi_threshold);
+
   /* Scan filter */
   virtual void ScanFilterEnable(bool enable);
 
@@ -107,6 +114,8 @@ class LeScanningManager : public bluetooth::Module {
 
   std::string ToString() const override;
 
+  DumpsysDataFinisher GetDumpsysData(flatbuffers::FlatBufferBuilder* builder) const override;  // Module
+
  private:
   struct impl;
   std::unique_ptr<impl> pimpl_;
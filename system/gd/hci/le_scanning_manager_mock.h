@@ -54,6 +54,7 @@ class MockLeScanningManager : public LeScanningManager {
   MOCK_METHOD(void, Scan, (bool));
   MOCK_METHOD(void, SetScanParameters,
               (ScannerId, LeScanType, std::vector<uint32_t>, std::vector<uint32_t>));
+  MOCK_METHOD(void, SetScanDeduplicationParameters, (ScannerId, uint32_t, uint8_t));
   MOCK_METHOD(void, ScanFilterEnable, (bool));
   MOCK_METHOD(void, ScanFilterParameterSetup, (ApcfAction, uint8_t, AdvertisingFilterParameter));
   MOCK_METHOD(void, ScanFilterAdd, (uint8_t, std::vector<AdvertisingPacketContentFilterCommand>));
@@ -695,6 +695,41 @@ TEST_F(LeScanningManagerExtendedTest, drop_insignificant_bytes_test) {
   test_hci_layer_->IncomingLeMetaEvent(LeExtendedAdvertisingReportBuilder::Create({scan_response_report}));
 }
 
+TEST_F(LeScanningManagerExtendedTest, deduplicate_identical_reports_test) {
+  // Register a scanner deduplicating the reports
+  Uuid app_uuid = Uuid::From16Bit(0x1234);
+  EXPECT_CALL(mock_callbacks_, OnScannerRegistered(app_uuid, 1, ScanningCallback::ScanningStatus::SUCCESS));
+  le_scanning_manager->RegisterScanner(app_uuid);
+  le_scanning_manager->SetScanDeduplicationParameters(1, 60000, 10);
+
+  // Enable scan
+  le_scanning_manager->Scan(true);
+  ASSERT_EQ(OpCode::LE_SET_EXTENDED_SCAN_PARAMETERS, test_hci_layer_->GetCommand().GetOpCode());
+  test_hci_layer_->IncomingEvent(LeSetExtendedScanParametersCompleteBuilder::Create(uint8_t{1}, ErrorCode::SUCCESS));
+  ASSERT_EQ(OpCode::LE_SET_EXTENDED_SCAN_ENABLE, test_hci_layer_->GetCommand().GetOpCode());
+  test_hci_layer_->IncomingEvent(LeSetExtendedScanEnableCompleteBuilder::Create(uint8_t{1}, ErrorCode::SUCCESS));
+
+  LeExtendedAdvertisingResponse report{};
+  report.connectable_ = 1;
+  report.scannable_ = 0;
+  report.address_type_ = DirectAdvertisingAddressType::PUBLIC_DEVICE_ADDRESS;
+  report.rssi_ = -60;
+  Address::FromString("12:34:56:78:9a:bc", report.address_);
+  LengthAndData flags_data{};
+  flags_data.data_.push_back(static_cast<uint8_t>(GapDataType::FLAGS));
+  flags_data.data_.push_back(0x34);
+  report.advertising_data_ = {flags_data};
+
+  // The repeated report is dropped, the report with a different RSSI is not
+  auto moved_report = report;
+  moved_report.rssi_ = -75;
+  EXPECT_CALL(mock_callbacks_, OnScanResult).Times(2);
+
+  test_hci_layer_->IncomingLeMetaEvent(LeExtendedAdvertisingReportBuilder::Create({report}));
+  test_hci_layer_->IncomingLeMetaEvent(LeExtendedAdvertisingReportBuilder::Create({report}));
+  test_hci_layer_->IncomingLeMetaEvent(LeExtendedAdvertisingReportBuilder::Create({moved_report}));
+}
+
 }  // namespace
 }  // namespace hci
 }  // namespace bluetooth
@@ -15,6 +15,8 @@
  */
 #include "hci/le_scanning_reassembler.h"
 
+#include <algorithm>
+#include <cstring>
 #include <memory>
 #include <unordered_map>
 
@@ -32,6 +34,10 @@
 
 namespace bluetooth::hci {
 
+LeScanningReassembler::LeScanningReassembler(
+    size_t cache_capacity, std::unique_ptr<common::Timestamper> timestamper)
+    : cache_(std::max<size_t>(cache_capacity, 1)), timestamper_(std::move(timestamper)) {}
+
 std::optional<std::vector<uint8_t>> LeScanningReassembler::ProcessAdvertisingReport(
     uint16_t event_type,
     uint8_t address_type,
@@ -50,10 +56,15 @@ std::optional<std::vector<uint8_t>> LeScanningReassembler::ProcessAdvertisingRep
   }
 
   AdvertisingKey key(address, DirectAdvertisingAddressType(address_type), advertising_sid);
+  long long now = timestamper_->GetTimestamp();
+  ExpireFragments(now);
 
   // Ignore scan responses received without a matching advertising event.
   if (is_scan_response && (ignore_scan_responses_ || !ContainsFragment(key))) {
     LOG_INFO("Ignoring scan response received without advertising event");
+    if (!ignore_scan_responses_) {
+      statistics_.orphan_scan_responses++;
+    }
     return {};
   }
 
@@ -66,12 +77,11 @@ std::optional<std::vector<uint8_t>> LeScanningReassembler::ProcessAdvertisingRep
   }
 
   // Concatenate the data with existing fragments.
-  std::list<AdvertisingFragment>::iterator advertising_fragment =
-      AppendFragment(key, advertising_data);
+  AdvertisingFragment& advertising_fragment = AppendFragment(key, advertising_data, now);
 
   // Trim the advertising data when the complete payload is received.
   if (data_status != DataStatus::CONTINUING) {
-    advertising_fragment->data = TrimAdvertisingData(advertising_fragment->data);
+    TrimAdvertisingData(&advertising_fragment.data);
   }
 
   // TODO(b/272120114) waiting for a scan response here is prone to failure as the
@@ -89,8 +99,9 @@ std::optional<std::vector<uint8_t>> LeScanningReassembler::ProcessAdvertisingRep
 
   // Otherwise the full advertising report has been reassembled,
   // removed the cache entry and return the complete advertising data.
-  std::vector<uint8_t> complete_advertising_data = std::move(advertising_fragment->data);
-  cache_.erase(advertising_fragment);
+  std::vector<uint8_t> complete_advertising_data(advertising_fragment.data.begin(), advertising_fragment.data.end());
+  RemoveFragment(key);
+  statistics_.reassembled_reports++;
   return complete_advertising_data;
 }
 
@@ -98,24 +109,31 @@ std::optional<std::vector<uint8_t>> LeScanningReassembler::ProcessAdvertisingRep
 /// GAP Data entries.
 std::vector<uint8_t> LeScanningReassembler::TrimAdvertisingData(
     const std::vector<uint8_t>& advertising_data) {
+  std::vector<uint8_t> significant_advertising_data(advertising_data);
+  TrimAdvertisingData(&significant_advertising_data);
+  return significant_advertising_data;
+}
+
+/// Same as above, in place: the significant entries are moved to the
+/// front of the data.
+void LeScanningReassembler::TrimAdvertisingData(std::vector<uint8_t>* advertising_data) {
   // Remove empty and overflowing entries from the advertising data.
-  std::vector<uint8_t> significant_advertising_data;
-  for (size_t offset = 0; offset < advertising_data.size();) {
-    size_t remaining_size = advertising_data.size() - offset;
-    uint8_t entry_size = advertising_data[offset];
+  uint8_t* data = advertising_data->data();
+  size_t size = advertising_data->size();
+  size_t significant_size = 0;
+  for (size_t offset = 0; offset < size;) {
+    size_t remaining_size = size - offset;
+    uint8_t entry_size = data[offset];
 
     if (entry_size != 0 && entry_size < remaining_size) {
-      significant_advertising_data.push_back(entry_size);
-      significant_advertising_data.insert(
-          significant_advertising_data.end(),
-          advertising_data.begin() + offset + 1,
-          advertising_data.begin() + offset + 1 + entry_size);
+      std::memmove(data + significant_size, data + offset, entry_size + 1);
+      significant_size += entry_size + 1;
     }
 
     offset += entry_size + 1;
   }
 
-  return significant_advertising_data;
+  advertising_data->resize(significant_size);
 }
 
 LeScanningReassembler::AdvertisingKey::AdvertisingKey(
@@ -132,48 +150,73 @@ LeScanningReassembler::AdvertisingKey::AdvertisingKey(
   }
 }
 
-bool LeScanningReassembler::AdvertisingKey::operator==(const AdvertisingKey& other) {
+bool LeScanningReassembler::AdvertisingKey::operator==(const AdvertisingKey& other) const {
   return address == other.address && sid == other.sid;
 }
 
+std::size_t LeScanningReassembler::AdvertisingKeyHash::operator()(const AdvertisingKey& key) const {
+  std::size_t seed = std::hash<std::optional<AddressWithType>>{}(key.address);
+  return seed ^ (std::hash<std::optional<uint8_t>>{}(key.sid) + 0x9e3779b9 + (seed << 6) + (seed >> 2));
+}
+
 /// Append to the current advertising data of the selected advertiser.
 /// If the advertiser is unknown a new entry is added, optionally by
-/// dropping the oldest advertiser.
-std::list<LeScanningReassembler::AdvertisingFragment>::iterator
-LeScanningReassembler::AppendFragment(const AdvertisingKey& key, const std::vector<uint8_t>& data) {
-  auto it = FindFragment(key);
+/// dropping the least recently updated advertiser.
+LeScanningReassembler::AdvertisingFragment& LeScanningReassembler::AppendFragment(
+    const AdvertisingKey& key, const std::vector<uint8_t>& data, long long now) {
+  auto it = cache_.find(key);
   if (it != cache_.end()) {
-    it->data.insert(it->data.end(), data.cbegin(), data.cend());
-    return it;
+    it->second.data.insert(it->second.data.end(), data.cbegin(), data.cend());
+    it->second.timestamp = now;
+    return it->second;
   }
 
-  if (cache_.size() > kMaximumCacheSize) {
-    cache_.pop_back();
+  std::vector<uint8_t> buffer;
+  if (!buffer_pool_.empty()) {
+    buffer = std::move(buffer_pool_.back());
+    buffer_pool_.pop_back();
   }
+  buffer.assign(data.cbegin(), data.cend());
 
-  cache_.emplace_front(key, data);
-  return cache_.begin();
+  auto [inserted, success, evicted] = cache_.try_emplace(key, AdvertisingFragment{std::move(buffer), now});
+  if (evicted) {
+    LOG_DEBUG("Dropping incomplete advertising data of the least recently updated advertiser");
+    statistics_.evictions++;
+    ReleaseBuffer(std::move(evicted->second.data));
+  }
+  return inserted->second;
 }
 
 void LeScanningReassembler::RemoveFragment(const AdvertisingKey& key) {
-  auto it = FindFragment(key);
-  if (it != cache_.end()) {
-    cache_.erase(it);
+  auto fragment = cache_.extract(key);
+  if (fragment) {
+    ReleaseBuffer(std::move(fragment->second.data));
   }
 }
 
 bool LeScanningReassembler::ContainsFragment(const AdvertisingKey& key) {
-  return FindFragment(key) != cache_.end();
+  return cache_.contains(key);
 }
 
-std::list<LeScanningReassembler::AdvertisingFragment>::iterator LeScanningReassembler::FindFragment(
-    const AdvertisingKey& key) {
-  for (auto it = cache_.begin(); it != cache_.end(); it++) {
-    if (it->key == key) {
-      return it;
+/// Drop the advertising data that was not updated for kFragmentTimeout.
+/// The least recently updated advertisers are at the back of the cache.
+void LeScanningReassembler::ExpireFragments(long long now) {
+  while (cache_.size() > 0) {
+    auto oldest = std::prev(cache_.end());
+    if (now - oldest->second.timestamp <= kFragmentTimeout.count()) {
+      break;
     }
+    statistics_.expirations++;
+    ReleaseBuffer(std::move(oldest->second.data));
+    cache_.erase(oldest);
+  }
+}
+
+void LeScanningReassembler::ReleaseBuffer(std::vector<uint8_t> buffer) {
+  if (buffer_pool_.size() < cache_.capacity()) {
+    buffer.clear();
+    buffer_pool_.push_back(std::move(buffer));
   }
-  return cache_.end();
 }
 
 }  // namespace bluetooth::hci
@@ -17,11 +17,14 @@
 
 #include <gtest/gtest_prod.h>
 
+#include <chrono>
 #include <cstdint>
-#include <list>
+#include <memory>
 #include <optional>
 #include <vector>
 
+#include "common/circular_buffer.h"
+#include "common/lru_cache.h"
 #include "hci/address_with_type.h"
 #include "hci/hci_packets.h"
 
@@ -35,7 +38,31 @@ namespace bluetooth::hci {
 
 class LeScanningReassembler {
  public:
-  LeScanningReassembler(){};
+  /// Default number of advertisers whose data can be reassembled
+  /// at the same time.
+  static constexpr size_t kDefaultCacheCapacity = 64;
+
+  /// Incomplete advertising data is dropped when it was not completed
+  /// within this delay, e.g. when the scan response never came.
+  static constexpr std::chrono::milliseconds kFragmentTimeout = std::chrono::seconds(2);
+
+  /// Counters of the reassembly, reported in dumpsys.
+  struct Statistics {
+    /// Advertising reports completed and returned.
+    uint64_t reassembled_reports{0};
+    /// Incomplete advertising data dropped to make room for another
+    /// advertiser.
+    uint64_t evictions{0};
+    /// Incomplete advertising data dropped after kFragmentTimeout.
+    uint64_t expirations{0};
+    /// Scan responses dropped because the advertising data was not
+    /// in the cache.
+    uint64_t orphan_scan_responses{0};
+  };
+
+  explicit LeScanningReassembler(
+      size_t cache_capacity = kDefaultCacheCapacity,
+      std::unique_ptr<common::Timestamper> timestamper = std::make_unique<common::TimestamperInMilliseconds>());
   LeScanningReassembler(const LeScanningReassembler&) = delete;
   LeScanningReassembler& operator=(const LeScanningReassembler&) = delete;
 
@@ -57,6 +84,18 @@ class LeScanningReassembler {
     ignore_scan_responses_ = ignore_scan_responses;
   }
 
+  const Statistics& GetStatistics() const {
+    return statistics_;
+  }
+
+  size_t GetCacheSize() const {
+    return cache_.size();
+  }
+
+  size_t GetCacheCapacity() const {
+    return cache_.capacity();
+  }
+
  private:
   /// Determine if scan responses should be processed or ignored.
   bool ignore_scan_responses_{false};
@@ -83,16 +122,18 @@ class LeScanningReassembler {
     std::optional<uint8_t> sid;
 
     AdvertisingKey(Address address, DirectAdvertisingAddressType address_type, uint8_t sid);
-    bool operator==(const AdvertisingKey& other);
+    bool operator==(const AdvertisingKey& other) const;
+  };
+
+  struct AdvertisingKeyHash {
+    std::size_t operator()(const AdvertisingKey& key) const;
   };
 
   /// Packs incomplete advertising data.
   struct AdvertisingFragment {
-    AdvertisingKey key;
     std::vector<uint8_t> data;
-
-    AdvertisingFragment(const AdvertisingKey& key, const std::vector<uint8_t>& data)
-        : key(key), data(data.begin(), data.end()) {}
+    /// Time of the last report appended to the data.
+    long long timestamp;
   };
 
   /// Advertising cache for de-fragmenting extended advertising reports,
@@ -100,19 +141,27 @@ class LeScanningReassembler {
   /// applicable.
   /// The cached advertising data is removed as soon as the complete
   /// advertisement is got (including the scan response).
-  static constexpr size_t kMaximumCacheSize = 16;
-  std::list<AdvertisingFragment> cache_;
+  /// Advertisers are ordered from the most to the least recently updated,
+  /// hence the oldest fragments are the first to be evicted or expired.
+  common::LruCache<AdvertisingKey, AdvertisingFragment, AdvertisingKeyHash> cache_;
+  std::unique_ptr<common::Timestamper> timestamper_;
+  Statistics statistics_;
+
+  /// Buffers of the advertising data removed from the cache, reused for
+  /// the next advertisers so that the data is not reallocated as it grows.
+  std::vector<std::vector<uint8_t>> buffer_pool_;
 
   /// Advertising cache management methods.
-  std::list<AdvertisingFragment>::iterator AppendFragment(
-      const AdvertisingKey& key, const std::vector<uint8_t>& data);
+  AdvertisingFragment& AppendFragment(const AdvertisingKey& key, const std::vector<uint8_t>& data, long long now);
   void RemoveFragment(const AdvertisingKey& key);
   bool ContainsFragment(const AdvertisingKey& key);
-  std::list<AdvertisingFragment>::iterator FindFragment(const AdvertisingKey& key);
+  void ExpireFragments(long long now);
+  void ReleaseBuffer(std::vector<uint8_t> buffer);
 
   /// Trim the advertising data by removing empty or overflowing
   /// GAP Data entries.
   static std::vector<uint8_t> TrimAdvertisingData(const std::vector<uint8_t>& advertising_data);
+  static void TrimAdvertisingData(std::vector<uint8_t>* advertising_data);
 
   FRIEND_TEST(LeScanningReassemblerTest, trim_advertising_data);
 };
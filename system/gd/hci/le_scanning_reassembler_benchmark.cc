@@ -0,0 +1,153 @@
+/*
+ * Copyright 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "hci/le_scanning_reassembler.h"
+
+using ::benchmark::State;
+
+namespace bluetooth {
+namespace hci {
+
+namespace {
+
+// Event type fields.
+constexpr uint16_t kScannable = 0x2;
+constexpr uint16_t kScanResponse = 0x8;
+constexpr uint16_t kLegacy = 0x10;
+constexpr uint16_t kComplete = 0x0;
+constexpr uint16_t kContinuation = 0x20;
+
+constexpr uint8_t kSidNotPresent = 0xff;
+
+// Number of advertisers in the synthetic trace, as seen in crowded places
+constexpr uint16_t kNumAdvertisers = 500;
+// Number of advertisers whose reports are interleaved at any time
+constexpr size_t kNumAdvertisersInFlight = 100;
+
+struct AdvertisingReport {
+  uint16_t event_type;
+  uint8_t address_type;
+  Address address;
+  uint8_t advertising_sid;
+  std::vector<uint8_t> advertising_data;
+};
+
+// Well formed advertising data of |size| bytes made of Manufacturer Specific Data entries
+std::vector<uint8_t> MakeAdvertisingData(size_t size, uint8_t seed) {
+  std::vector<uint8_t> data;
+  while (data.size() < size) {
+    size_t entry_size = std::min<size_t>(size - data.size(), 31);
+    if (entry_size < 2) {
+      data.push_back(0);
+      continue;
+    }
+    data.push_back(entry_size - 1);
+    data.push_back(0xff);
+    for (size_t i = 2; i < entry_size; i++) {
+      data.push_back(seed + i);
+    }
+  }
+  return data;
+}
+
+// Reports of one advertising event of advertiser |index|:
+// - 40% scannable legacy advertisers, followed by the scan response
+// - 30% non scannable legacy advertisers
+// - 30% extended advertisers, with 600 bytes of data in 3 reports
+std::deque<AdvertisingReport> MakeAdvertisingEvent(uint16_t index) {
+  Address address({0xc0, 0x01, 0x02, 0x03, (uint8_t)(index >> 8), (uint8_t)index});
+  uint8_t address_type = (uint8_t)AddressType::RANDOM_DEVICE_ADDRESS;
+  std::deque<AdvertisingReport> reports;
+  switch (index % 10) {
+    case 0:
+    case 1:
+    case 2:
+    case 3:
+      reports.push_back({kLegacy | kScannable | kComplete, address_type, address, kSidNotPresent,
+                         MakeAdvertisingData(31, index)});
+      reports.push_back({kLegacy | kScannable | kScanResponse | kComplete, address_type, address, kSidNotPresent,
+                         MakeAdvertisingData(31, index + 1)});
+      break;
+    case 4:
+    case 5:
+    case 6:
+      reports.push_back({kLegacy | kComplete, address_type, address, kSidNotPresent, MakeAdvertisingData(31, index)});
+      break;
+    default: {
+      auto data = MakeAdvertisingData(600, index);
+      for (size_t offset = 0; offset < data.size(); offset += 200) {
+        bool last = offset + 200 >= data.size();
+        reports.push_back({(uint16_t)(last ? kComplete : kContinuation), address_type, address, (uint8_t)(index % 16),
+                           std::vector<uint8_t>(data.begin() + offset, data.begin() + offset + 200)});
+      }
+      break;
+    }
+  }
+  return reports;
+}
+
+// Reports of one advertising event of each advertiser, the controller interleaving the reports of
+// kNumAdvertisersInFlight advertisers at a time
+std::vector<AdvertisingReport> MakeAdvertisingTrace() {
+  std::vector<AdvertisingReport> trace;
+  std::deque<std::deque<AdvertisingReport>> in_flight;
+  uint16_t next_advertiser = 0;
+  while (next_advertiser < kNumAdvertisers || !in_flight.empty()) {
+    while (in_flight.size() < kNumAdvertisersInFlight && next_advertiser < kNumAdvertisers) {
+      in_flight.push_back(MakeAdvertisingEvent(next_advertiser++));
+    }
+    auto event = std::move(in_flight.front());
+    in_flight.pop_front();
+    trace.push_back(std::move(event.front()));
+    event.pop_front();
+    if (!event.empty()) {
+      in_flight.push_back(std::move(event));
+    }
+  }
+  return trace;
+}
+
+}  // namespace
+
+static void BM_ReplayCrowdedAdvertisingTrace(State& state) {
+  auto trace = MakeAdvertisingTrace();
+  LeScanningReassembler reassembler(state.range(0));
+  uint64_t complete_reports = 0;
+  for (auto _ : state) {
+    for (const auto& report : trace) {
+      auto data = reassembler.ProcessAdvertisingReport(
+          report.event_type, report.address_type, report.address, report.advertising_sid, report.advertising_data);
+      if (data.has_value()) {
+        complete_reports++;
+      }
+    }
+  }
+  const auto& statistics = reassembler.GetStatistics();
+  state.SetItemsProcessed(state.iterations() * trace.size());
+  state.counters["complete_reports"] = benchmark::Counter(complete_reports, benchmark::Counter::kAvgIterations);
+  state.counters["evictions"] = benchmark::Counter(statistics.evictions, benchmark::Counter::kAvgIterations);
+  state.counters["orphan_scan_responses"] =
+      benchmark::Counter(statistics.orphan_scan_responses, benchmark::Counter::kAvgIterations);
+}
+BENCHMARK(BM_ReplayCrowdedAdvertisingTrace)->Arg(16)->Arg(LeScanningReassembler::kDefaultCacheCapacity)->Arg(256);
+
+}  // namespace hci
+}  // namespace bluetooth
@@ -41,6 +41,21 @@ static constexpr uint8_t kSidNotPresent = 0xff;
 // Test addresses.
 static const Address kTestAddress = Address({0, 1, 2, 3, 4, 5});
 
+static Address MakeTestAddress(uint16_t index) {
+  return Address({0, 1, 2, 3, (uint8_t)(index >> 8), (uint8_t)index});
+}
+
+class FakeTimestamper : public common::Timestamper {
+ public:
+  explicit FakeTimestamper(long long* timestamp) : timestamp_(timestamp) {}
+  long long GetTimestamp() const override {
+    return *timestamp_;
+  }
+
+ private:
+  long long* timestamp_;
+};
+
 class LeScanningReassemblerTest : public ::testing::Test {
  public:
   LeScanningReassembler reassembler_;
@@ -324,4 +339,133 @@ TEST_F(LeScanningReassemblerTest, interleaved_advertising) {
       std::vector<uint8_t>({0x2, 0x3, 0x3}));
 }
 
+TEST_F(LeScanningReassemblerTest, many_interleaved_advertisers) {
+  // Fragments of more advertisers than the previous fixed cache size
+  // of 16 are all kept.
+  constexpr uint16_t kNumAdvertisers = 48;
+  for (uint16_t i = 0; i < kNumAdvertisers; i++) {
+    ASSERT_FALSE(reassembler_
+                     .ProcessAdvertisingReport(
+                         kContinuation,
+                         (uint8_t)AddressType::RANDOM_DEVICE_ADDRESS,
+                         MakeTestAddress(i),
+                         kSidNotPresent,
+                         {0x2, (uint8_t)i})
+                     .has_value());
+  }
+  ASSERT_EQ(reassembler_.GetCacheSize(), kNumAdvertisers);
+
+  for (uint16_t i = 0; i < kNumAdvertisers; i++) {
+    ASSERT_EQ(
+        reassembler_.ProcessAdvertisingReport(
+            kComplete,
+            (uint8_t)AddressType::RANDOM_DEVICE_ADDRESS,
+            MakeTestAddress(i),
+            kSidNotPresent,
+            {(uint8_t)i}),
+        std::vector<uint8_t>({0x2, (uint8_t)i, (uint8_t)i}));
+  }
+  ASSERT_EQ(reassembler_.GetCacheSize(), 0u);
+  ASSERT_EQ(reassembler_.GetStatistics().reassembled_reports, kNumAdvertisers);
+  ASSERT_EQ(reassembler_.GetStatistics().evictions, 0u);
+}
+
+TEST_F(LeScanningReassemblerTest, evict_least_recently_updated) {
+  LeScanningReassembler reassembler(2);
+
+  for (uint16_t i = 0; i < 2; i++) {
+    ASSERT_FALSE(reassembler
+                     .ProcessAdvertisingReport(
+                         kContinuation,
+                         (uint8_t)AddressType::PUBLIC_DEVICE_ADDRESS,
+                         MakeTestAddress(i),
+                         kSidNotPresent,
+                         {0x3, (uint8_t)i})
+                     .has_value());
+  }
+
+  // Advertiser 0 is updated, advertiser 1 becomes the least recently
+  // updated one and is evicted by advertiser 2.
+  ASSERT_FALSE(reassembler
+                   .ProcessAdvertisingReport(
+                       kContinuation,
+                       (uint8_t)AddressType::PUBLIC_DEVICE_ADDRESS,
+                       MakeTestAddress(0),
+                       kSidNotPresent,
+                       {0xa})
+                   .has_value());
+  ASSERT_FALSE(reassembler
+                   .ProcessAdvertisingReport(
+                       kContinuation,
+                       (uint8_t)AddressType::PUBLIC_DEVICE_ADDRESS,
+                       MakeTestAddress(2),
+                       kSidNotPresent,
+                       {0x2, 0x2})
+                   .has_value());
+  ASSERT_EQ(reassembler.GetCacheSize(), 2u);
+  ASSERT_EQ(reassembler.GetStatistics().evictions, 1u);
+
+  ASSERT_EQ(
+      reassembler.ProcessAdvertisingReport(
+          kComplete, (uint8_t)AddressType::PUBLIC_DEVICE_ADDRESS, MakeTestAddress(0), kSidNotPresent, {0xb}),
+      std::vector<uint8_t>({0x3, 0x0, 0xa, 0xb}));
+
+  // The data of advertiser 1 restarts from the last fragment.
+  ASSERT_EQ(
+      reassembler.ProcessAdvertisingReport(
+          kComplete, (uint8_t)AddressType::PUBLIC_DEVICE_ADDRESS, MakeTestAddress(1), kSidNotPresent, {0x1, 0x1}),
+      std::vector<uint8_t>({0x1, 0x1}));
+}
+
+TEST_F(LeScanningReassemblerTest, expire_incomplete_advertising) {
+  long long timestamp = 0;
+  LeScanningReassembler reassembler(
+      LeScanningReassembler::kDefaultCacheCapacity, std::make_unique<FakeTimestamper>(&timestamp));
+
+  ASSERT_FALSE(reassembler
+                   .ProcessAdvertisingReport(
+                       kLegacy | kScannable | kComplete,
+                       (uint8_t)AddressType::PUBLIC_DEVICE_ADDRESS,
+                       kTestAddress,
+                       kSidNotPresent,
+                       {0x1, 0x2})
+                   .has_value());
+
+  // The scan response is still matched before the timeout.
+  timestamp += LeScanningReassembler::kFragmentTimeout.count();
+  ASSERT_EQ(
+      reassembler.ProcessAdvertisingReport(
+          kLegacy | kScannable | kScanResponse | kComplete,
+          (uint8_t)AddressType::PUBLIC_DEVICE_ADDRESS,
+          kTestAddress,
+          kSidNotPresent,
+          {0x1, 0x3}),
+      std::vector<uint8_t>({0x1, 0x2, 0x1, 0x3}));
+
+  ASSERT_FALSE(reassembler
+                   .ProcessAdvertisingReport(
+                       kLegacy | kScannable | kComplete,
+                       (uint8_t)AddressType::PUBLIC_DEVICE_ADDRESS,
+                       kTestAddress,
+                       kSidNotPresent,
+                       {0x1, 0x2})
+                   .has_value());
+
+  // After the timeout the advertising data is dropped, and the scan
+  // response has no matching advertising data.
+  timestamp += LeScanningReassembler::kFragmentTimeout.count() + 1;
+  ASSERT_FALSE(reassembler
+                   .ProcessAdvertisingReport(
+                       kLegacy | kScannable | kScanResponse | kComplete,
+                       (uint8_t)AddressType::PUBLIC_DEVICE_ADDRESS,
+                       kTestAddress,
+                       kSidNotPresent,
+                       {0x1, 0x3})
+                   .has_value());
+  ASSERT_EQ(reassembler.GetCacheSize(), 0u);
+  ASSERT_EQ(reassembler.GetStatistics().expirations, 1u);
+  ASSERT_EQ(reassembler.GetStatistics().orphan_scan_responses, 1u);
+  ASSERT_EQ(reassembler.GetStatistics().reassembled_reports, 1u);
+}
+
 }  // namespace bluetooth::hci
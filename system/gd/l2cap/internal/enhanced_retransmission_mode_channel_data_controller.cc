@@ -16,11 +16,11 @@
 
 #include "l2cap/internal/enhanced_retransmission_mode_channel_data_controller.h"
 
-#include <map>
 #include <queue>
 #include <vector>
 
 #include "common/bind.h"
+#include "l2cap/internal/enhanced_retransmission_mode_tx_window.h"
 #include "l2cap/internal/ilink.h"
 #include "os/alarm.h"
 #include "packet/fragmenting_inserter.h"
@@ -40,7 +40,11 @@ ErtmController::~ErtmController() {
 
 struct ErtmController::impl {
   impl(ErtmController* controller, os::Handler* handler)
-      : controller_(controller), handler_(handler), retrans_timer_(handler), monitor_timer_(handler) {}
+      : controller_(controller),
+        handler_(handler),
+        unacked_list_(controller->remote_tx_window_),
+        retrans_timer_(handler),
+        monitor_timer_(handler) {}
 
   ErtmController* controller_;
   os::Handler* handler_;
@@ -78,13 +82,20 @@ struct ErtmController::impl {
   bool remote_busy_ = false;
   bool local_busy_ = false;
   int unacked_frames_ = 0;
-  // TODO: Instead of having a map, we may consider about a better data structure
-  // Map from TxSeq to (SAR, SDU size for START packet, information payload)
-  std::map<uint8_t, std::tuple<SegmentationAndReassembly, uint16_t, std::shared_ptr<packet::RawBuilder>>> unacked_list_;
+  struct UnackedFrame {
+    SegmentationAndReassembly sar = SegmentationAndReassembly::UNSEGMENTED;
+    // SDU size for START packet
+    uint16_t sdu_size = 0;
+    // Shared with the copies of the frame waiting to be sent
+    std::shared_ptr<packet::RawBuilder> payload;
+    // Number of times the frame was sent
+    int retry_count = 0;
+  };
+  // Frames from ExpectedAckSeq to NextTxSeq - 1, indexed by TxSeq
+  ErtmTxWindow<UnackedFrame> unacked_list_;
   // Stores (SAR, SDU size for START packet, information payload)
   std::queue<std::tuple<SegmentationAndReassembly, uint16_t, std::unique_ptr<packet::RawBuilder>>> pending_frames_;
   int retry_count_ = 0;
-  std::map<uint8_t /* tx_seq, */, int /* count */> retry_i_frames_;
   bool rnr_sent_ = false;
   bool rej_actioned_ = false;
   bool srej_actioned_ = false;
@@ -471,7 +482,7 @@ struct ErtmController::impl {
   }
 
   bool rem_window_not_full() {
-    return unacked_frames_ < controller_->remote_tx_window_;
+    return unacked_frames_ < controller_->remote_tx_window_ && !unacked_list_.full();
   }
 
   bool rem_window_full() {
@@ -483,7 +494,8 @@ struct ErtmController::impl {
   }
 
   bool retry_i_frames_less_than_max_transmit(uint8_t req_seq) {
-    return retry_i_frames_[req_seq] < controller_->local_max_transmit_;
+    return !unacked_list_.Contains(req_seq) ||
+           unacked_list_.Get(req_seq).retry_count < controller_->local_max_transmit_;
   }
 
   bool retry_count_less_than_max_transmit() {
@@ -599,16 +611,15 @@ struct ErtmController::impl {
 
   void send_data(SegmentationAndReassembly sar, uint16_t sdu_size, std::unique_ptr<packet::RawBuilder> segment,
                  Final f = Final::NOT_SET) {
-    std::shared_ptr<packet::RawBuilder> shared_segment(segment.release());
-    unacked_list_.emplace(std::piecewise_construct, std::forward_as_tuple(next_tx_seq_),
-                          std::forward_as_tuple(sar, sdu_size, shared_segment));
+    ASSERT(unacked_list_.GetNextSeq() == next_tx_seq_);
+    UnackedFrame& frame =
+        unacked_list_.Push({sar, sdu_size, std::shared_ptr<packet::RawBuilder>(std::move(segment)), 1});
 
     std::unique_ptr<CopyablePacketBuilder> copyable_packet_builder =
-        std::make_unique<CopyablePacketBuilder>(std::get<2>(unacked_list_.find(next_tx_seq_)->second));
+        std::make_unique<CopyablePacketBuilder>(frame.payload);
     _send_i_frame(sar, std::move(copyable_packet_builder), buffer_seq_, next_tx_seq_, sdu_size, f);
     unacked_frames_++;
     frames_sent_++;
-    retry_i_frames_[next_tx_seq_] = 1;
     next_tx_seq_ = (next_tx_seq_ + 1) % kMaxTxWin;
     start_retrans_timer();
   }
@@ -618,11 +629,7 @@ struct ErtmController::impl {
   }
 
   void process_req_seq(uint8_t req_seq) {
-    for (int i = expected_ack_seq_; i < req_seq; i++) {
-      unacked_list_.erase(i);
-      retry_i_frames_[i] = 0;
-    }
-    unacked_frames_ -= ((req_seq - expected_ack_seq_) + kMaxTxWin) % kMaxTxWin;
+    unacked_frames_ -= unacked_list_.AcknowledgeUpTo(req_seq);
     expected_ack_seq_ = req_seq;
     if (unacked_frames_ == 0) {
       stop_retrans_timer();
@@ -751,19 +758,19 @@ struct ErtmController::impl {
   void retransmit_i_frames(uint8_t req_seq, Poll p = Poll::NOT_SET) {
     uint8_t i = req_seq;
     Final f = (p == Poll::NOT_SET ? Final::NOT_SET : Final::POLL_RESPONSE);
-    while (unacked_list_.find(i) != unacked_list_.end()) {
-      if (retry_i_frames_[i] == controller_->local_max_transmit_) {
+    while (unacked_list_.Contains(i)) {
+      UnackedFrame& frame = unacked_list_.Get(i);
+      if (frame.retry_count == controller_->local_max_transmit_) {
         CloseChannel();
         return;
       }
       std::unique_ptr<CopyablePacketBuilder> copyable_packet_builder =
-          std::make_unique<CopyablePacketBuilder>(std::get<2>(unacked_list_.find(i)->second));
-      _send_i_frame(std::get<0>(unacked_list_.find(i)->second), std::move(copyable_packet_builder), buffer_seq_, i,
-                    std::get<1>(unacked_list_.find(i)->second), f);
-      retry_i_frames_[i]++;
+          std::make_unique<CopyablePacketBuilder>(frame.payload);
+      _send_i_frame(frame.sar, std::move(copyable_packet_builder), buffer_seq_, i, frame.sdu_size, f);
+      frame.retry_count++;
       frames_sent_++;
       f = Final::NOT_SET;
-      i++;
+      i = (i + 1) % kMaxTxWin;
     }
     if (i != req_seq) {
       start_retrans_timer();
@@ -772,15 +779,15 @@ struct ErtmController::impl {
 
   void retransmit_requested_i_frame(uint8_t req_seq, Poll p) {
     Final f = p == Poll::POLL ? Final::POLL_RESPONSE : Final::NOT_SET;
-    if (unacked_list_.find(req_seq) == unacked_list_.end()) {
+    if (!unacked_list_.Contains(req_seq)) {
       LOG_ERROR("Received invalid SREJ");
       return;
     }
+    UnackedFrame& frame = unacked_list_.Get(req_seq);
     std::unique_ptr<CopyablePacketBuilder> copyable_packet_builder =
-        std::make_unique<CopyablePacketBuilder>(std::get<2>(unacked_list_.find(req_seq)->second));
-    _send_i_frame(std::get<0>(unacked_list_.find(req_seq)->second), std::move(copyable_packet_builder), buffer_seq_,
-                  req_seq, std::get<1>(unacked_list_.find(req_seq)->second), f);
-    retry_i_frames_[req_seq]++;
+        std::make_unique<CopyablePacketBuilder>(frame.payload);
+    _send_i_frame(frame.sar, std::move(copyable_packet_builder), buffer_seq_, req_seq, frame.sdu_size, f);
+    frame.retry_count++;
     start_retrans_timer();
   }
 
@@ -1039,6 +1046,7 @@ void ErtmController::send_pdu(std::unique_ptr<packet::BasePacketBuilder> pdu) {
 void ErtmController::SetRetransmissionAndFlowControlOptions(
     const RetransmissionAndFlowControlConfigurationOption& option) {
   remote_tx_window_ = option.tx_window_size_;
+  pimpl_->unacked_list_.SetCapacity(remote_tx_window_);
   local_max_transmit_ = option.max_transmit_;
   local_retransmit_timeout_ms_ = option.retransmission_time_out_;
   local_monitor_timeout_ms_ = option.monitor_time_out_;
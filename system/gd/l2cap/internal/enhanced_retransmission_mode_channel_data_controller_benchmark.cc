@@ -0,0 +1,213 @@
+/*
+ * Copyright 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <chrono>
+#include <future>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "common/bidi_queue.h"
+#include "common/bind.h"
+#include "l2cap/internal/enhanced_retransmission_mode_channel_data_controller.h"
+#include "l2cap/internal/ilink.h"
+#include "l2cap/internal/scheduler.h"
+#include "os/handler.h"
+#include "os/thread.h"
+#include "packet/bit_inserter.h"
+#include "packet/raw_builder.h"
+
+using ::benchmark::State;
+
+namespace bluetooth {
+namespace l2cap {
+namespace internal {
+
+namespace {
+
+constexpr Cid kSenderCid = 0x40;
+constexpr Cid kReceiverCid = 0x41;
+constexpr size_t kSdusPerIteration = 100;
+
+class LoopbackLink : public ILink {
+ public:
+  void SendDisconnectionRequest(Cid local_cid, Cid remote_cid) override {
+    disconnected_ = true;
+  }
+  hci::AddressWithType GetDevice() const override {
+    return hci::AddressWithType();
+  }
+
+  bool disconnected_ = false;
+};
+
+// Deliver the PDUs of a controller to its peer on the handler, dropping |loss_permille| of them
+class LoopbackScheduler : public Scheduler {
+ public:
+  LoopbackScheduler(os::Handler* handler, uint32_t loss_permille) : handler_(handler), loss_permille_(loss_permille) {}
+
+  void Connect(ErtmController* from, ErtmController* to) {
+    from_ = from;
+    to_ = to;
+  }
+
+  void Disconnect() {
+    Connect(nullptr, nullptr);
+  }
+
+  void OnPacketsReady(Cid cid, int number_packets) override {
+    handler_->Post(common::BindOnce(&LoopbackScheduler::deliver, common::Unretained(this), number_packets));
+  }
+
+  size_t dropped_pdus_ = 0;
+
+ private:
+  void deliver(int number_packets) {
+    for (int i = 0; i < number_packets && from_ != nullptr; i++) {
+      auto pdu = from_->GetNextPacket();
+      if (random_() % 1000 < loss_permille_) {
+        dropped_pdus_++;
+        continue;
+      }
+      auto bytes = std::make_shared<std::vector<uint8_t>>();
+      bytes->reserve(pdu->size());
+      packet::BitInserter inserter(*bytes);
+      pdu->Serialize(inserter);
+      to_->OnPdu(packet::PacketView<packet::kLittleEndian>(bytes));
+    }
+  }
+
+  os::Handler* handler_;
+  uint32_t loss_permille_;
+  std::minstd_rand random_;
+  ErtmController* from_ = nullptr;
+  ErtmController* to_ = nullptr;
+};
+
+std::unique_ptr<packet::BasePacketBuilder> MakeSdu(size_t size) {
+  auto builder = std::make_unique<packet::RawBuilder>(size);
+  builder->AddOctets(std::vector<uint8_t>(size, 0x5a));
+  return builder;
+}
+
+}  // namespace
+
+class BM_ErtmLoopback : public ::benchmark::Fixture {
+ public:
+  void on_sdu_received() {
+    receiver_channel_queue_.GetUpEnd()->TryDequeue();
+    if (--sdus_to_receive_ == 0) {
+      sdus_received_.set_value();
+    }
+  }
+
+ protected:
+  void SetUp(State& st) override {
+    ::benchmark::Fixture::SetUp(st);
+    thread_ = new os::Thread("ertm_loopback_thread", os::Thread::Priority::NORMAL);
+    handler_ = new os::Handler(thread_);
+  }
+
+  void TearDown(State& st) override {
+    handler_->Clear();
+    delete handler_;
+    delete thread_;
+    ::benchmark::Fixture::TearDown(st);
+  }
+
+  void sync_handler() {
+    std::promise<void> promise;
+    auto future = promise.get_future();
+    handler_->Post(common::BindOnce(&std::promise<void>::set_value, common::Unretained(&promise)));
+    future.wait();
+  }
+
+  os::Thread* thread_ = nullptr;
+  os::Handler* handler_ = nullptr;
+  common::BidiQueue<Scheduler::UpperEnqueue, Scheduler::UpperDequeue> sender_channel_queue_{10};
+  common::BidiQueue<Scheduler::UpperEnqueue, Scheduler::UpperDequeue> receiver_channel_queue_{10};
+  size_t sdus_to_receive_ = 0;
+  std::promise<void> sdus_received_;
+};
+
+// Send SDUs of |state.range(0)| bytes through a lossy loopback, |state.range(1)| PDUs in 1000 being dropped.
+// Lost frames are recovered with REJ, or with the retransmission timer for the last frames of a burst.
+BENCHMARK_DEFINE_F(BM_ErtmLoopback, send_sdus)(State& state) {
+  LoopbackLink link;
+  LoopbackScheduler sender_scheduler(handler_, state.range(1));
+  LoopbackScheduler receiver_scheduler(handler_, state.range(1));
+  ErtmController sender(
+      &link, kSenderCid, kReceiverCid, sender_channel_queue_.GetDownEnd(), handler_, &sender_scheduler);
+  ErtmController receiver(
+      &link, kReceiverCid, kSenderCid, receiver_channel_queue_.GetDownEnd(), handler_, &receiver_scheduler);
+  sender_scheduler.Connect(&sender, &receiver);
+  receiver_scheduler.Connect(&receiver, &sender);
+
+  RetransmissionAndFlowControlConfigurationOption option;
+  option.mode_ = RetransmissionAndFlowControlModeOption::ENHANCED_RETRANSMISSION;
+  option.tx_window_size_ = 10;
+  option.max_transmit_ = 255;
+  option.retransmission_time_out_ = 10;
+  option.monitor_time_out_ = 20;
+  option.maximum_pdu_size_ = 1010;
+  sender.SetRetransmissionAndFlowControlOptions(option);
+  receiver.SetRetransmissionAndFlowControlOptions(option);
+
+  receiver_channel_queue_.GetUpEnd()->RegisterDequeue(
+      handler_, common::Bind(&BM_ErtmLoopback::on_sdu_received, common::Unretained(this)));
+
+  for (auto _ : state) {
+    sdus_to_receive_ = kSdusPerIteration;
+    sdus_received_ = std::promise<void>();
+    auto future = sdus_received_.get_future();
+    handler_->Post(common::BindOnce(
+        [](ErtmController* sender, size_t sdu_size) {
+          for (size_t i = 0; i < kSdusPerIteration; i++) {
+            sender->OnSdu(MakeSdu(sdu_size));
+          }
+        },
+        &sender,
+        state.range(0)));
+    if (future.wait_for(std::chrono::seconds(10)) != std::future_status::ready) {
+      state.SkipWithError("SDUs not received");
+      break;
+    }
+  }
+
+  // Stop the loopback before the controllers go away, PDUs of the last iteration may still be in flight
+  receiver_channel_queue_.GetUpEnd()->UnregisterDequeue();
+  handler_->Post(common::BindOnce(&LoopbackScheduler::Disconnect, common::Unretained(&sender_scheduler)));
+  handler_->Post(common::BindOnce(&LoopbackScheduler::Disconnect, common::Unretained(&receiver_scheduler)));
+  sync_handler();
+  state.SetBytesProcessed(state.iterations() * kSdusPerIteration * state.range(0));
+  state.counters["dropped_pdus"] =
+      benchmark::Counter(sender_scheduler.dropped_pdus_ + receiver_scheduler.dropped_pdus_);
+  if (link.disconnected_) {
+    state.SkipWithError("Channel closed");
+  }
+}
+
+BENCHMARK_REGISTER_F(BM_ErtmLoopback, send_sdus)
+    ->Args({1000, 0})
+    ->Args({4000, 0})
+    ->Args({4000, 10})
+    ->Args({4000, 50})
+    ->UseRealTime();
+
+}  // namespace internal
+}  // namespace l2cap
+}  // namespace bluetooth
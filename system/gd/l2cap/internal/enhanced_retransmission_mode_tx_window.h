@@ -0,0 +1,140 @@
+/*
+ * Copyright 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "os/log.h"
+
+namespace bluetooth {
+namespace l2cap {
+namespace internal {
+
+// Frames sent and not acknowledged yet by the remote, indexed by their modulo 64 TxSeq.
+//
+// The frames have consecutive sequence numbers, from the oldest one, ExpectedAckSeq, to the newest one,
+// NextTxSeq - 1. They are stored in a ring sized from the TxWindow of the remote, so that sending and acknowledging
+// a frame does not allocate.
+//
+// Performance:
+//   - Push(), Contains(), Get() and acknowledging a frame are O(1)
+//   - NOT THREAD SAFE
+template <typename T>
+class ErtmTxWindow {
+ public:
+  // Modulus of the sequence numbers, we don't support extended window
+  static constexpr uint8_t kMaxTxWin = 64;
+
+  explicit ErtmTxWindow(size_t capacity) : frames_(clamp_capacity(capacity)) {}
+
+  // Resize the ring for a new TxWindow, keeping the frames sent. The window cannot shrink below the number of frames.
+  void SetCapacity(size_t capacity) {
+    capacity = std::max(clamp_capacity(capacity), size_);
+    if (capacity == frames_.size()) {
+      return;
+    }
+    std::vector<T> frames(capacity);
+    for (size_t i = 0; i < size_; i++) {
+      frames[i] = std::move(frames_[(head_ + i) % frames_.size()]);
+    }
+    frames_ = std::move(frames);
+    head_ = 0;
+  }
+
+  size_t capacity() const {
+    return frames_.size();
+  }
+
+  size_t size() const {
+    return size_;
+  }
+
+  bool empty() const {
+    return size_ == 0;
+  }
+
+  bool full() const {
+    return size_ == frames_.size();
+  }
+
+  // Sequence number of the oldest frame, or of the next frame when empty
+  uint8_t GetFirstSeq() const {
+    return first_seq_;
+  }
+
+  // Sequence number of the next frame
+  uint8_t GetNextSeq() const {
+    return (first_seq_ + size_) % kMaxTxWin;
+  }
+
+  // Store the frame sent with the next sequence number, and return it
+  T& Push(T frame) {
+    ASSERT(!full());
+    T& slot = frames_[(head_ + size_) % frames_.size()];
+    slot = std::move(frame);
+    size_++;
+    return slot;
+  }
+
+  bool Contains(uint8_t seq) const {
+    return offset_of(seq) < size_;
+  }
+
+  T& Get(uint8_t seq) {
+    ASSERT(Contains(seq));
+    return frames_[(head_ + offset_of(seq)) % frames_.size()];
+  }
+
+  // Release the frames acknowledged by |req_seq|, up to |req_seq| - 1, and return how many were released
+  size_t AcknowledgeUpTo(uint8_t req_seq) {
+    size_t count = offset_of(req_seq);
+    if (count > size_) {
+      LOG_WARN("ReqSeq %hhu is outside of the window [%hhu, %hhu]", req_seq, first_seq_, GetNextSeq());
+      return 0;
+    }
+    for (size_t i = 0; i < count; i++) {
+      frames_[head_] = T();
+      head_ = (head_ + 1) % frames_.size();
+    }
+    size_ -= count;
+    first_seq_ = req_seq % kMaxTxWin;
+    return count;
+  }
+
+ private:
+  // The ring must not hold more frames than sequence numbers can tell apart
+  static size_t clamp_capacity(size_t capacity) {
+    return std::clamp<size_t>(capacity, 1, kMaxTxWin - 1);
+  }
+
+  size_t offset_of(uint8_t seq) const {
+    return (seq + kMaxTxWin - first_seq_) % kMaxTxWin;
+  }
+
+  std::vector<T> frames_;
+  size_t head_ = 0;
+  size_t size_ = 0;
+  uint8_t first_seq_ = 0;
+};
+
+}  // namespace internal
+}  // namespace l2cap
+}  // namespace bluetooth
@@ -0,0 +1,123 @@
+/*
+ * Copyright 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "l2cap/internal/enhanced_retransmission_mode_tx_window.h"
+
+#include <gtest/gtest.h>
+
+#include <memory>
+
+namespace bluetooth {
+namespace l2cap {
+namespace internal {
+namespace {
+
+TEST(ErtmTxWindowTest, push_and_acknowledge) {
+  ErtmTxWindow<int> window(10);
+  ASSERT_TRUE(window.empty());
+  ASSERT_EQ(window.GetNextSeq(), 0);
+  for (int i = 0; i < 5; i++) {
+    window.Push(i);
+  }
+  ASSERT_EQ(window.size(), 5u);
+  ASSERT_EQ(window.GetNextSeq(), 5);
+  ASSERT_TRUE(window.Contains(4));
+  ASSERT_FALSE(window.Contains(5));
+  ASSERT_EQ(window.Get(3), 3);
+
+  ASSERT_EQ(window.AcknowledgeUpTo(3), 3u);
+  ASSERT_EQ(window.GetFirstSeq(), 3);
+  ASSERT_FALSE(window.Contains(2));
+  ASSERT_EQ(window.Get(3), 3);
+  ASSERT_EQ(window.AcknowledgeUpTo(3), 0u);
+  ASSERT_EQ(window.AcknowledgeUpTo(5), 2u);
+  ASSERT_TRUE(window.empty());
+}
+
+TEST(ErtmTxWindowTest, sequence_wraps_around) {
+  ErtmTxWindow<int> window(10);
+  int seq = 0;
+  for (int round = 0; round < 20; round++) {
+    for (int i = 0; i < 7; i++) {
+      ASSERT_EQ(window.GetNextSeq(), seq % ErtmTxWindow<int>::kMaxTxWin);
+      window.Push(seq++);
+    }
+    uint8_t first_seq = window.GetFirstSeq();
+    for (int i = 0; i < 7; i++) {
+      uint8_t frame_seq = (first_seq + i) % ErtmTxWindow<int>::kMaxTxWin;
+      ASSERT_EQ(window.Get(frame_seq) % ErtmTxWindow<int>::kMaxTxWin, frame_seq);
+    }
+    ASSERT_EQ(window.AcknowledgeUpTo(window.GetNextSeq()), 7u);
+  }
+}
+
+TEST(ErtmTxWindowTest, full_window) {
+  ErtmTxWindow<int> window(3);
+  window.Push(0);
+  window.Push(1);
+  ASSERT_FALSE(window.full());
+  window.Push(2);
+  ASSERT_TRUE(window.full());
+  ASSERT_DEATH(window.Push(3), "");
+}
+
+TEST(ErtmTxWindowTest, reject_req_seq_outside_of_window) {
+  ErtmTxWindow<int> window(10);
+  window.Push(0);
+  window.Push(1);
+  ASSERT_EQ(window.AcknowledgeUpTo(5), 0u);
+  ASSERT_EQ(window.AcknowledgeUpTo(63), 0u);
+  ASSERT_EQ(window.size(), 2u);
+}
+
+TEST(ErtmTxWindowTest, release_acknowledged_frames) {
+  ErtmTxWindow<std::shared_ptr<int>> window(10);
+  auto frame = std::make_shared<int>(0);
+  window.Push(frame);
+  ASSERT_EQ(frame.use_count(), 2);
+  window.AcknowledgeUpTo(1);
+  ASSERT_EQ(frame.use_count(), 1);
+}
+
+TEST(ErtmTxWindowTest, set_capacity) {
+  ErtmTxWindow<int> window(4);
+  for (int i = 0; i < 4; i++) {
+    window.Push(i);
+  }
+  window.AcknowledgeUpTo(2);
+  window.Push(4);
+  window.Push(5);
+
+  // The frames keep their sequence numbers
+  window.SetCapacity(8);
+  ASSERT_EQ(window.capacity(), 8u);
+  for (int i = 2; i < 6; i++) {
+    ASSERT_EQ(window.Get(i), i);
+  }
+  window.Push(6);
+  ASSERT_EQ(window.Get(6), 6);
+
+  // The window cannot shrink below its frames, nor grow beyond the sequence numbers
+  window.SetCapacity(1);
+  ASSERT_EQ(window.capacity(), 5u);
+  window.SetCapacity(100);
+  ASSERT_EQ(window.capacity(), 63u);
+}
+
+}  // namespace
+}  // namespace internal
+}  // namespace l2cap
+}  // namespace bluetooth
@@ -23,14 +23,14 @@
 #include "common/callback.h"
 #include "os/handler.h"
 #include "os/thread.h"
+#include "os/timer_service.h"
 #include "os/utils.h"
 
 namespace bluetooth {
 namespace os {
 
-// A single-shot alarm for reactor-based thread, implemented by Linux timerfd.
-// When it's constructed, it will register a reactable on the specified thread; when it's destroyed, it will unregister
-// itself from the thread.
+// A single-shot alarm for reactor-based thread, backed by the timer service of the handler's thread, which
+// multiplexes all alarms of that thread onto a single timerfd.
 class Alarm {
  public:
   // Create and register a single-shot alarm on a given handler
@@ -39,7 +39,7 @@ class Alarm {
   Alarm(const Alarm&) = delete;
   Alarm& operator=(const Alarm&) = delete;
 
-  // Unregister this alarm from the thread and release resource
+  // Cancel this alarm and release resource
   ~Alarm();
 
   // Schedule the alarm with given delay
@@ -49,12 +49,9 @@ class Alarm {
   void Cancel();
 
  private:
-  common::OnceClosure task_;
   Handler* handler_;
-  int fd_ = 0;
-  Reactor::Reactable* token_;
-  mutable std::mutex mutex_;
-  void on_fire();
+  TimerService* timer_service_;
+  TimerService::Timer timer_;
 };
 
 }  // namespace os
@@ -14,9 +14,14 @@
  * limitations under the License.
  */
 
+#include <algorithm>
 #include <chrono>
+#include <filesystem>
 #include <future>
+#include <mutex>
+#include <random>
 #include <unordered_map>
+#include <vector>
 
 #include "benchmark/benchmark.h"
 #include "common/bind.h"
@@ -26,6 +31,7 @@
 
 using ::benchmark::State;
 using ::bluetooth::common::Bind;
+using ::bluetooth::common::BindOnce;
 using ::bluetooth::os::Alarm;
 using ::bluetooth::os::Handler;
 using ::bluetooth::os::RepeatingAlarm;
@@ -140,3 +146,138 @@ BENCHMARK_REGISTER_F(BM_ReactableAlarm, periodic_accuracy)
     ->Args({2000, 15, 20})
     ->Iterations(1)
     ->UseRealTime();
+
+class BM_ConcurrentAlarms : public ::benchmark::Fixture {
+ protected:
+  void SetUp(State& st) override {
+    ::benchmark::Fixture::SetUp(st);
+    thread_ = std::make_unique<Thread>("timer_benchmark", Thread::Priority::REAL_TIME);
+    handler_ = std::make_unique<Handler>(thread_.get());
+  }
+
+  void TearDown(State& st) override {
+    alarms_.clear();
+    handler_->Clear();
+    handler_ = nullptr;
+    thread_->Stop();
+    thread_ = nullptr;
+    ::benchmark::Fixture::TearDown(st);
+  }
+
+  static int64_t CountOpenFds() {
+    return std::distance(
+        std::filesystem::directory_iterator("/proc/self/fd"), std::filesystem::directory_iterator());
+  }
+
+  void Arm(size_t index, std::chrono::milliseconds delay) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!armed_[index]) {
+      remaining_++;
+    }
+    armed_[index] = true;
+    generation_[index]++;
+    expected_[index] = std::chrono::steady_clock::now() + delay;
+    alarms_[index]->Schedule(
+        BindOnce(&BM_ConcurrentAlarms::AlarmFired, bluetooth::common::Unretained(this), index, generation_[index]),
+        delay);
+  }
+
+  void Disarm(size_t index) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    alarms_[index]->Cancel();
+    if (armed_[index]) {
+      remaining_--;
+    }
+    armed_[index] = false;
+  }
+
+  void AlarmFired(size_t index, int generation) {
+    auto now = std::chrono::steady_clock::now();
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!armed_[index] || generation != generation_[index]) {
+      stale_fires_++;
+      return;
+    }
+    armed_[index] = false;
+    auto jitter = std::chrono::duration_cast<std::chrono::microseconds>(now - expected_[index]).count();
+    total_jitter_us_ += jitter;
+    max_jitter_us_ = std::max(max_jitter_us_, jitter);
+    fired_++;
+    if (--remaining_ == 0) {
+      all_fired_.set_value();
+    }
+  }
+
+  std::mutex mutex_;
+  std::vector<std::unique_ptr<Alarm>> alarms_;
+  std::vector<bool> armed_;
+  std::vector<int> generation_;
+  std::vector<std::chrono::steady_clock::time_point> expected_;
+  int64_t remaining_ = 0;
+  int64_t fired_ = 0;
+  int64_t stale_fires_ = 0;
+  int64_t total_jitter_us_ = 0;
+  int64_t max_jitter_us_ = 0;
+  std::promise<void> all_fired_;
+  std::unique_ptr<Thread> thread_;
+  std::unique_ptr<Handler> handler_;
+};
+
+// Arm state.range(0) alarms with random delays, then cancel or reschedule state.range(1) random alarms while they are
+// pending, and wait for the survivors to fire
+BENCHMARK_DEFINE_F(BM_ConcurrentAlarms, random_churn)(State& state) {
+  auto num_alarms = static_cast<size_t>(state.range(0));
+  auto num_churn_operations = state.range(1);
+  std::mt19937 random(1234);
+  std::uniform_int_distribution<int> delay_ms(200, 1000);
+  int64_t fds_before = CountOpenFds();
+  int64_t fds_with_alarms = 0;
+  double total_schedule_ns = 0;
+  int64_t schedule_operations = 0;
+
+  for (auto _ : state) {
+    all_fired_ = std::promise<void>();
+    auto all_fired = all_fired_.get_future();
+    alarms_.clear();
+    for (size_t i = 0; i < num_alarms; i++) {
+      alarms_.push_back(std::make_unique<Alarm>(handler_.get()));
+    }
+    armed_.assign(num_alarms, false);
+    generation_.assign(num_alarms, 0);
+    expected_.assign(num_alarms, std::chrono::steady_clock::time_point());
+    remaining_ = fired_ = stale_fires_ = total_jitter_us_ = max_jitter_us_ = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < num_alarms; i++) {
+      Arm(i, std::chrono::milliseconds(delay_ms(random)));
+    }
+    for (int64_t i = 0; i < num_churn_operations; i++) {
+      size_t index = random() % num_alarms;
+      if (random() % 4 == 0) {
+        Disarm(index);
+      } else {
+        Arm(index, std::chrono::milliseconds(delay_ms(random)));
+        schedule_operations++;
+      }
+    }
+    total_schedule_ns += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    schedule_operations += num_alarms;
+    fds_with_alarms = CountOpenFds();
+    all_fired.wait();
+  }
+
+  state.counters["fds_per_alarm"] = static_cast<double>(fds_with_alarms - fds_before) / num_alarms;
+  state.counters["open_fds"] = fds_with_alarms;
+  state.counters["schedule_ns"] = total_schedule_ns / schedule_operations;
+  state.counters["fired"] = fired_;
+  state.counters["stale_fires"] = stale_fires_;
+  state.counters["avg_jitter_us"] = fired_ > 0 ? static_cast<double>(total_jitter_us_) / fired_ : 0;
+  state.counters["max_jitter_us"] = max_jitter_us_;
+};
+
+BENCHMARK_REGISTER_F(BM_ConcurrentAlarms, random_churn)
+    ->Args({100, 1000})
+    ->Args({1000, 10000})
+    ->Args({10000, 100000})
+    ->Iterations(1)
+    ->UseRealTime();
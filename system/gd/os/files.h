@@ -41,6 +41,11 @@ std::optional<std::string> ReadSmallFile(const std::string& path);
 // Return true on success, false on failure
 bool WriteToFile(const std::string& path, const std::string& data);
 
+// Append |data| to the file at |path|, creating it if needed, and sync it to storage media before returning. Unlike
+// WriteToFile(), a failure may leave part of |data| at the end of the file
+// Return true on success, false on failure
+bool AppendToFile(const std::string& path, const std::string& data);
+
 // Remove file and print error message if failed
 // Print error log when file is failed to be removed, hence user should make sure file exists before calling this
 // Return true on success, false on failure (e.g. file not exist, failed to remove, etc)
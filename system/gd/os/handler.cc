@@ -28,12 +28,24 @@ namespace bluetooth {
 namespace os {
 using common::OnceClosure;
 
-Handler::Handler(Thread* thread) : tasks_(new std::queue<OnceClosure>()), thread_(thread) {
+Handler::Handler(Thread* thread)
+    : tasks_(new std::queue<OnceClosure>()), cleared_(std::make_shared<std::atomic_bool>(false)), thread_(thread) {
   event_ = thread_->GetReactor()->NewEvent();
   reactable_ = thread_->GetReactor()->Register(
       event_->Id(), common::Bind(&Handler::handle_next_event, common::Unretained(this)), common::Closure());
 }
 
+Handler::Handler(Thread* thread, size_t max_tasks_per_wakeup)
+    : tasks_(new std::queue<OnceClosure>()),
+      max_tasks_per_wakeup_(max_tasks_per_wakeup),
+      cleared_(std::make_shared<std::atomic_bool>(false)),
+      thread_(thread) {
+  ASSERT_LOG(max_tasks_per_wakeup_ > 0, "Batched handlers must run at least one task per wakeup");
+  event_ = thread_->GetReactor()->NewEvent();
+  reactable_ = thread_->GetReactor()->Register(
+      event_->Id(), common::Bind(&Handler::handle_next_batch, common::Unretained(this)), common::Closure());
+}
+
 Handler::~Handler() {
   {
     std::lock_guard<std::mutex> lock(mutex_);
@@ -43,15 +55,21 @@ Handler::~Handler() {
 }
 
 void Handler::Post(OnceClosure closure) {
+  bool needs_notify = true;
   {
     std::lock_guard<std::mutex> lock(mutex_);
     if (was_cleared()) {
       LOG_WARN("Posting to a handler which has been cleared");
       return;
     }
+    if (max_tasks_per_wakeup_ > 0) {
+      needs_notify = tasks_->empty();
+    }
     tasks_->emplace(std::move(closure));
   }
-  event_->Notify();
+  if (needs_notify) {
+    event_->Notify();
+  }
 }
 
 void Handler::Clear() {
@@ -60,6 +78,7 @@ void Handler::Clear() {
     std::lock_guard<std::mutex> lock(mutex_);
     ASSERT_LOG(!was_cleared(), "Handlers must only be cleared once");
     std::swap(tasks_, tmp);
+    *cleared_ = true;
   }
   delete tmp;
 
@@ -91,5 +110,36 @@ void Handler::handle_next_event() {
   std::move(closure).Run();
 }
 
+void Handler::handle_next_batch() {
+  std::queue<common::OnceClosure> batch;
+  std::shared_ptr<std::atomic_bool> cleared;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    // A notification is outstanding whenever tasks_ is non-empty, each wakeup consumes one
+    event_->Read();
+    if (was_cleared()) {
+      return;
+    }
+    if (tasks_->size() <= max_tasks_per_wakeup_) {
+      std::swap(*tasks_, batch);
+    } else {
+      for (size_t i = 0; i < max_tasks_per_wakeup_; i++) {
+        batch.emplace(std::move(tasks_->front()));
+        tasks_->pop();
+      }
+      // Yield to the other reactables of this thread, and come back for the rest
+      event_->Notify();
+    }
+    cleared = cleared_;
+  }
+
+  // The handler may be cleared and destroyed by one of the tasks, so only local state is used from here on
+  while (!batch.empty() && !*cleared) {
+    common::OnceClosure closure = std::move(batch.front());
+    batch.pop();
+    std::move(closure).Run();
+  }
+}
+
 }  // namespace os
 }  // namespace bluetooth
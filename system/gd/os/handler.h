@@ -16,6 +16,7 @@
 
 #pragma once
 
+#include <atomic>
 #include <functional>
 #include <memory>
 #include <mutex>
@@ -38,6 +39,11 @@ class Handler : public common::IPostableContext {
   // Create and register a handler on given thread
   explicit Handler(Thread* thread);
 
+  // Create and register a handler on given thread which drains its queue in batches. The reactor is only notified
+  // when the queue goes from empty to non-empty, and each wakeup runs at most max_tasks_per_wakeup closures before
+  // yielding back to the reactor so other reactables on the same thread are not starved.
+  Handler(Thread* thread, size_t max_tasks_per_wakeup);
+
   Handler(const Handler&) = delete;
   Handler& operator=(const Handler&) = delete;
 
@@ -93,6 +99,9 @@ class Handler : public common::IPostableContext {
   template <typename T>
   friend class Queue;
 
+  template <typename T>
+  friend class SpscQueue;
+
   friend class Alarm;
 
   friend class RepeatingAlarm;
@@ -102,11 +111,16 @@ class Handler : public common::IPostableContext {
     return tasks_ == nullptr;
   };
   std::queue<common::OnceClosure>* tasks_;
+  // Zero means one task per wakeup with one notification per posted closure
+  const size_t max_tasks_per_wakeup_ = 0;
+  // Shared with a running batch, which must not touch the handler once one of its tasks cleared it
+  std::shared_ptr<std::atomic_bool> cleared_;
   Thread* thread_;
   std::unique_ptr<Reactor::Event> event_;
   Reactor::Reactable* reactable_;
   mutable std::mutex mutex_;
   void handle_next_event();
+  void handle_next_batch();
 };
 
 }  // namespace os
@@ -18,6 +18,7 @@
 
 #include <future>
 #include <thread>
+#include <vector>
 
 #include "common/bind.h"
 #include "common/callback.h"
@@ -116,6 +117,95 @@ TEST_F(HandlerTest, callback_with_promise) {
   handler_->Clear();
 }
 
+class BatchedHandlerTest : public ::testing::Test {
+ protected:
+  static constexpr size_t kMaxTasksPerWakeup = 4;
+  void SetUp() override {
+    thread_ = new Thread("test_thread", Thread::Priority::NORMAL);
+    handler_ = new Handler(thread_, kMaxTasksPerWakeup);
+  }
+  void TearDown() override {
+    delete handler_;
+    delete thread_;
+  }
+
+  Handler* handler_;
+  Thread* thread_;
+};
+
+TEST_F(BatchedHandlerTest, post_task_invoked) {
+  std::promise<void> closure_ran;
+  auto future = closure_ran.get_future();
+  handler_->Post(common::BindOnce(&std::promise<void>::set_value, common::Unretained(&closure_ran)));
+  future.wait();
+  handler_->Clear();
+}
+
+TEST_F(BatchedHandlerTest, tasks_run_in_order_across_batches) {
+  constexpr size_t kNumTasks = 10 * kMaxTasksPerWakeup + 1;
+  std::vector<int> order;
+  std::promise<void> all_ran;
+  auto future = all_ran.get_future();
+  for (size_t i = 0; i < kNumTasks; i++) {
+    handler_->Post(common::BindOnce(
+        [](std::vector<int>* order, int i, std::promise<void>* all_ran) {
+          order->push_back(i);
+          if (order->size() == kNumTasks) {
+            all_ran->set_value();
+          }
+        },
+        common::Unretained(&order),
+        static_cast<int>(i),
+        common::Unretained(&all_ran)));
+  }
+  future.wait();
+  for (size_t i = 0; i < kNumTasks; i++) {
+    ASSERT_EQ(order[i], static_cast<int>(i));
+  }
+  handler_->Clear();
+}
+
+TEST_F(BatchedHandlerTest, post_from_running_task) {
+  std::promise<void> inner_ran;
+  auto future = inner_ran.get_future();
+  handler_->Post(common::BindOnce(
+      [](Handler* handler, std::promise<void>* inner_ran) {
+        handler->Post(common::BindOnce(&std::promise<void>::set_value, common::Unretained(inner_ran)));
+      },
+      common::Unretained(handler_),
+      common::Unretained(&inner_ran)));
+  future.wait();
+  handler_->Clear();
+}
+
+TEST_F(BatchedHandlerTest, post_task_cleared) {
+  std::promise<void> closure_started;
+  auto closure_started_future = closure_started.get_future();
+  std::promise<void> closure_can_continue;
+  auto can_continue_future = closure_can_continue.get_future();
+  std::promise<void> closure_finished;
+  auto closure_finished_future = closure_finished.get_future();
+  handler_->Post(common::BindOnce(
+      [](std::promise<void> closure_started,
+         std::future<void> can_continue_future,
+         std::promise<void> closure_finished) {
+        closure_started.set_value();
+        can_continue_future.wait();
+        closure_finished.set_value();
+      },
+      std::move(closure_started),
+      std::move(can_continue_future),
+      std::move(closure_finished)));
+  // Queued in the same batch as the blocked closure, must be discarded by Clear()
+  handler_->Post(common::BindOnce([]() { ASSERT_TRUE(false); }));
+  closure_started_future.wait();
+  handler_->Post(common::BindOnce([]() { ASSERT_TRUE(false); }));
+  handler_->Clear();
+  closure_can_continue.set_value();
+  closure_finished_future.wait();
+  handler_->WaitUntilStopped(std::chrono::milliseconds(2000));
+}
+
 // For Death tests, all the threading needs to be done in the ASSERT_DEATH call
 class HandlerDeathTest : public ::testing::Test {
  protected:
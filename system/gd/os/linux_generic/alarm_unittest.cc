@@ -17,6 +17,7 @@
 #include "os/alarm.h"
 
 #include <future>
+#include <memory>
 
 #include "common/bind.h"
 #include "gtest/gtest.h"
@@ -50,9 +51,9 @@ class AlarmTest : public ::testing::Test {
     handler_->Post(common::BindOnce(fake_timerfd_advance, ms));
   }
   Alarm* alarm_;
+  Handler* handler_;
 
  private:
-  Handler* handler_;
   Thread* thread_;
 };
 
@@ -99,6 +100,64 @@ TEST_F(AlarmTest, delete_while_alarm_armed) {
   std::this_thread::sleep_for(std::chrono::milliseconds(10));
 }
 
+TEST_F(AlarmTest, cancel_alarm_expiring_on_the_same_tick_from_callback) {
+  Alarm other(handler_);
+  int fired = 0;
+  alarm_->Schedule(BindOnce(
+                       [](Alarm* other, int* fired) {
+                         other->Cancel();
+                         (*fired)++;
+                       },
+                       common::Unretained(&other),
+                       common::Unretained(&fired)),
+                   std::chrono::milliseconds(10));
+  other.Schedule(BindOnce(
+                     [](Alarm* other, int* fired) {
+                       other->Cancel();
+                       (*fired)++;
+                     },
+                     common::Unretained(alarm_),
+                     common::Unretained(&fired)),
+                 std::chrono::milliseconds(10));
+  std::promise<void> promise;
+  auto future = promise.get_future();
+  Alarm last(handler_);
+  last.Schedule(
+      BindOnce(&std::promise<void>::set_value, common::Unretained(&promise)), std::chrono::milliseconds(20));
+  fake_timer_advance(20);
+  future.get();
+  ASSERT_EQ(fired, 1);
+}
+
+TEST_F(AlarmTest, delete_alarm_expiring_on_the_same_tick_from_callback) {
+  auto first = std::make_unique<Alarm>(handler_);
+  auto second = std::make_unique<Alarm>(handler_);
+  int fired = 0;
+  first->Schedule(BindOnce(
+                      [](std::unique_ptr<Alarm>* other, int* fired) {
+                        other->reset();
+                        (*fired)++;
+                      },
+                      common::Unretained(&second),
+                      common::Unretained(&fired)),
+                  std::chrono::milliseconds(10));
+  second->Schedule(BindOnce(
+                       [](std::unique_ptr<Alarm>* other, int* fired) {
+                         other->reset();
+                         (*fired)++;
+                       },
+                       common::Unretained(&first),
+                       common::Unretained(&fired)),
+                   std::chrono::milliseconds(10));
+  std::promise<void> promise;
+  auto future = promise.get_future();
+  alarm_->Schedule(
+      BindOnce(&std::promise<void>::set_value, common::Unretained(&promise)), std::chrono::milliseconds(20));
+  fake_timer_advance(20);
+  future.get();
+  ASSERT_EQ(fired, 1);
+}
+
 }  // namespace
 }  // namespace os
 }  // namespace bluetooth
@@ -0,0 +1,159 @@
+/*
+ * Copyright 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+template <typename T>
+SpscQueue<T>::SpscQueue(size_t capacity)
+    : capacity_(capacity),
+      ring_(capacity > 1 ? size_t{1} << (64 - __builtin_clzll(capacity - 1)) : 1),
+      mask_(ring_.size() - 1) {
+  if (capacity_ > 0) {
+    enqueue_.event_.Notify();
+  }
+};
+
+template <typename T>
+SpscQueue<T>::~SpscQueue() {
+  ASSERT_LOG(enqueue_.handler_ == nullptr, "Enqueue is not unregistered");
+  ASSERT_LOG(dequeue_.handler_ == nullptr, "Dequeue is not unregistered");
+};
+
+template <typename T>
+void SpscQueue<T>::RegisterEnqueue(Handler* handler, EnqueueCallback callback) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  ASSERT(enqueue_.handler_ == nullptr);
+  ASSERT(enqueue_.reactable_ == nullptr);
+  enqueue_.handler_ = handler;
+  enqueue_.reactable_ = enqueue_.handler_->thread_->GetReactor()->Register(
+      enqueue_.event_.Id(),
+      base::Bind(&SpscQueue<T>::EnqueueCallbackInternal, base::Unretained(this), std::move(callback)),
+      base::Closure());
+}
+
+template <typename T>
+void SpscQueue<T>::UnregisterEnqueue() {
+  Reactor* reactor = nullptr;
+  Reactor::Reactable* to_unregister = nullptr;
+  bool wait_for_unregister = false;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ASSERT(enqueue_.reactable_ != nullptr);
+    reactor = enqueue_.handler_->thread_->GetReactor();
+    wait_for_unregister = (!enqueue_.handler_->thread_->IsSameThread());
+    to_unregister = enqueue_.reactable_;
+    enqueue_.reactable_ = nullptr;
+    enqueue_.handler_ = nullptr;
+  }
+  reactor->Unregister(to_unregister);
+  if (wait_for_unregister) {
+    reactor->WaitForUnregisteredReactable(std::chrono::milliseconds(1000));
+  }
+}
+
+template <typename T>
+void SpscQueue<T>::RegisterDequeue(Handler* handler, DequeueCallback callback) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  ASSERT(dequeue_.handler_ == nullptr);
+  ASSERT(dequeue_.reactable_ == nullptr);
+  dequeue_.handler_ = handler;
+  dequeue_.reactable_ = dequeue_.handler_->thread_->GetReactor()->Register(
+      dequeue_.event_.Id(),
+      base::Bind(&SpscQueue<T>::DequeueCallbackInternal, base::Unretained(this), std::move(callback)),
+      base::Closure());
+}
+
+template <typename T>
+void SpscQueue<T>::UnregisterDequeue() {
+  Reactor* reactor = nullptr;
+  Reactor::Reactable* to_unregister = nullptr;
+  bool wait_for_unregister = false;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ASSERT(dequeue_.reactable_ != nullptr);
+    reactor = dequeue_.handler_->thread_->GetReactor();
+    wait_for_unregister = (!dequeue_.handler_->thread_->IsSameThread());
+    to_unregister = dequeue_.reactable_;
+    dequeue_.reactable_ = nullptr;
+    dequeue_.handler_ = nullptr;
+  }
+  reactor->Unregister(to_unregister);
+  if (wait_for_unregister) {
+    reactor->WaitForUnregisteredReactable(std::chrono::milliseconds(1000));
+  }
+}
+
+template <typename T>
+std::unique_ptr<T> SpscQueue<T>::TryDequeue() {
+  size_t head = head_.load(std::memory_order_relaxed);
+  size_t tail = tail_.load(std::memory_order_acquire);
+
+  if (head == tail) {
+    ResetUnless(&dequeue_.event_, [this]() { return consumer_sees_data(); });
+    return nullptr;
+  }
+
+  std::unique_ptr<T> data = std::move(ring_[head & mask_]);
+  head_.store(head + 1, std::memory_order_release);
+  // Pairs with the fence in EnqueueCallbackInternal, so that at least one side sees the other's update
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  tail = tail_.load(std::memory_order_acquire);
+
+  // The producer resets its event when it fills the queue and waits for this transition
+  if (tail - head == capacity_) {
+    enqueue_.event_.Notify();
+  }
+  if (head + 1 == tail) {
+    ResetUnless(&dequeue_.event_, [this]() { return consumer_sees_data(); });
+  }
+
+  return data;
+}
+
+template <typename T>
+void SpscQueue<T>::DequeueCallbackInternal(DequeueCallback callback) {
+  // A notification racing with the reset of a drained queue can leave the event set while empty. Swallow it here so
+  // that, as with Queue, the callback always finds something to dequeue.
+  if (!consumer_sees_data()) {
+    ResetUnless(&dequeue_.event_, [this]() { return consumer_sees_data(); });
+    return;
+  }
+  callback.Run();
+}
+
+template <typename T>
+void SpscQueue<T>::EnqueueCallbackInternal(EnqueueCallback callback) {
+  size_t tail = tail_.load(std::memory_order_relaxed);
+  size_t head = head_.load(std::memory_order_acquire);
+  if (tail - head == capacity_) {
+    ResetUnless(&enqueue_.event_, [this]() { return producer_sees_space(); });
+    return;
+  }
+
+  std::unique_ptr<T> data = callback.Run();
+  ASSERT(data != nullptr);
+  ring_[tail & mask_] = std::move(data);
+  tail_.store(tail + 1, std::memory_order_release);
+  // Pairs with the fence in TryDequeue, so that at least one side sees the other's update
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  head = head_.load(std::memory_order_acquire);
+
+  // The consumer resets its event when it drains the queue and waits for this transition
+  if (tail + 1 - head == 1) {
+    dequeue_.event_.Notify();
+  }
+  if (tail + 1 - head == capacity_) {
+    ResetUnless(&enqueue_.event_, [this]() { return producer_sees_space(); });
+  }
+}
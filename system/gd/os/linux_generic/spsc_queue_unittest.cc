@@ -0,0 +1,179 @@
+/*
+ * Copyright 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "os/spsc_queue.h"
+
+#include <chrono>
+#include <future>
+#include <memory>
+#include <string>
+
+#include "common/bind.h"
+#include "gtest/gtest.h"
+#include "os/reactor.h"
+
+using namespace std::chrono_literals;
+
+namespace bluetooth {
+namespace os {
+namespace {
+
+constexpr int kQueueSize = 10;
+
+class SpscQueueTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    enqueue_thread_ = new Thread("enqueue_thread", Thread::Priority::NORMAL);
+    enqueue_handler_ = new Handler(enqueue_thread_);
+    dequeue_thread_ = new Thread("dequeue_thread", Thread::Priority::NORMAL);
+    dequeue_handler_ = new Handler(dequeue_thread_);
+  }
+  void TearDown() override {
+    enqueue_handler_->Clear();
+    delete enqueue_handler_;
+    delete enqueue_thread_;
+    dequeue_handler_->Clear();
+    delete dequeue_handler_;
+    delete dequeue_thread_;
+  }
+
+  // Enqueue |count| increasing integers from the enqueue thread, unregistering after the last one
+  void StartEnqueue(SpscQueue<int>* queue, int count) {
+    next_to_enqueue_ = 0;
+    enqueue_count_ = count;
+    enqueue_handler_->Post(common::BindOnce(
+        [](SpscQueue<int>* queue, Handler* handler, SpscQueueTest* test) {
+          queue->RegisterEnqueue(
+              handler, common::Bind(&SpscQueueTest::EnqueueCallback, common::Unretained(test), common::Unretained(queue)));
+        },
+        common::Unretained(queue),
+        common::Unretained(enqueue_handler_),
+        common::Unretained(this)));
+  }
+
+  std::unique_ptr<int> EnqueueCallback(SpscQueue<int>* queue) {
+    auto data = std::make_unique<int>(next_to_enqueue_++);
+    if (next_to_enqueue_ == enqueue_count_) {
+      queue->UnregisterEnqueue();
+    }
+    return data;
+  }
+
+  void sync_handler(Thread* thread) {
+    ASSERT_TRUE(thread->GetReactor()->WaitForIdle(2s));
+  }
+
+  Thread* enqueue_thread_;
+  Handler* enqueue_handler_;
+  Thread* dequeue_thread_;
+  Handler* dequeue_handler_;
+  int next_to_enqueue_ = 0;
+  int enqueue_count_ = 0;
+};
+
+TEST_F(SpscQueueTest, try_dequeue_empty) {
+  SpscQueue<int> queue(kQueueSize);
+  EXPECT_EQ(queue.TryDequeue(), nullptr);
+}
+
+TEST_F(SpscQueueTest, enqueue_stops_when_full) {
+  SpscQueue<int> queue(kQueueSize);
+  StartEnqueue(&queue, kQueueSize * 3);
+  sync_handler(enqueue_thread_);
+  EXPECT_EQ(next_to_enqueue_, kQueueSize);
+
+  // Draining one element wakes the producer up for exactly one more
+  EXPECT_EQ(*queue.TryDequeue(), 0);
+  sync_handler(enqueue_thread_);
+  EXPECT_EQ(next_to_enqueue_, kQueueSize + 1);
+
+  enqueue_handler_->Post(common::BindOnce(&SpscQueue<int>::UnregisterEnqueue, common::Unretained(&queue)));
+  sync_handler(enqueue_thread_);
+  for (int i = 1; i <= kQueueSize; i++) {
+    EXPECT_EQ(*queue.TryDequeue(), i);
+  }
+  EXPECT_EQ(queue.TryDequeue(), nullptr);
+}
+
+TEST_F(SpscQueueTest, dequeue_callback_not_invoked_when_empty) {
+  SpscQueue<int> queue(kQueueSize);
+  int invocations = 0;
+  queue.RegisterDequeue(
+      dequeue_handler_, common::Bind([](int* invocations) { (*invocations)++; }, common::Unretained(&invocations)));
+  std::this_thread::sleep_for(20ms);
+  sync_handler(dequeue_thread_);
+  EXPECT_EQ(invocations, 0);
+  queue.UnregisterDequeue();
+}
+
+TEST_F(SpscQueueTest, dequeue_registered_after_enqueue) {
+  SpscQueue<int> queue(kQueueSize);
+  StartEnqueue(&queue, kQueueSize / 2);
+  sync_handler(enqueue_thread_);
+
+  std::promise<void> done;
+  auto done_future = done.get_future();
+  int expected = 0;
+  queue.RegisterDequeue(
+      dequeue_handler_,
+      common::Bind(
+          [](SpscQueue<int>* queue, int* expected, std::promise<void>* done) {
+            auto data = queue->TryDequeue();
+            ASSERT_NE(data, nullptr);
+            ASSERT_EQ(*data, (*expected)++);
+            if (*expected == kQueueSize / 2) {
+              queue->UnregisterDequeue();
+              done->set_value();
+            }
+          },
+          common::Unretained(&queue),
+          common::Unretained(&expected),
+          common::Unretained(&done)));
+  done_future.wait();
+  EXPECT_EQ(queue.TryDequeue(), nullptr);
+}
+
+TEST_F(SpscQueueTest, concurrent_transfer_keeps_order) {
+  constexpr int kNumItems = 100000;
+  for (size_t capacity : {1, 3, kQueueSize, 1024}) {
+    SpscQueue<int> queue(capacity);
+    std::promise<void> done;
+    auto done_future = done.get_future();
+    int expected = 0;
+    queue.RegisterDequeue(
+        dequeue_handler_,
+        common::Bind(
+            [](SpscQueue<int>* queue, int* expected, std::promise<void>* done) {
+              auto data = queue->TryDequeue();
+              ASSERT_NE(data, nullptr);
+              ASSERT_EQ(*data, (*expected)++);
+              if (*expected == kNumItems) {
+                queue->UnregisterDequeue();
+                done->set_value();
+              }
+            },
+            common::Unretained(&queue),
+            common::Unretained(&expected),
+            common::Unretained(&done)));
+    StartEnqueue(&queue, kNumItems);
+    ASSERT_EQ(done_future.wait_for(10s), std::future_status::ready) << "capacity " << capacity;
+    sync_handler(enqueue_thread_);
+  }
+}
+
+}  // namespace
+}  // namespace os
+}  // namespace bluetooth
@@ -24,6 +24,7 @@
 #include <cstring>
 
 #include "os/log.h"
+#include "os/timer_service.h"
 
 namespace bluetooth {
 namespace os {
@@ -72,6 +73,14 @@ Reactor* Thread::GetReactor() const {
   return &reactor_;
 }
 
+TimerService* Thread::GetTimerService() const {
+  std::lock_guard<std::mutex> lock(timer_service_mutex_);
+  if (timer_service_ == nullptr) {
+    timer_service_ = std::make_unique<TimerService>(&reactor_);
+  }
+  return timer_service_.get();
+}
+
 std::string Thread::GetThreadName() const {
   return name_;
 }
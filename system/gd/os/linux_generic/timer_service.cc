@@ -0,0 +1,228 @@
+/*
+ * Copyright 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "os/timer_service.h"
+
+#include <sys/timerfd.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <vector>
+
+#include "common/bind.h"
+#include "os/linux_generic/linux.h"
+#include "os/log.h"
+#include "os/utils.h"
+
+#ifdef __ANDROID__
+#define ALARM_CLOCK CLOCK_BOOTTIME_ALARM
+#else
+#define ALARM_CLOCK CLOCK_BOOTTIME
+#endif
+
+namespace bluetooth {
+namespace os {
+
+namespace {
+constexpr uint64_t kNanosPerTick = 1000000;
+
+uint64_t ticks_to_nanos(uint64_t ticks) {
+  return ticks * kNanosPerTick;
+}
+
+// Round up so that a timer never fires before its delay has fully elapsed
+uint64_t nanos_to_expiry_tick(uint64_t nanos) {
+  return (nanos + kNanosPerTick - 1) / kNanosPerTick;
+}
+}  // namespace
+
+TimerService::TimerService(Reactor* reactor)
+    : reactor_(reactor), fd_(TIMERFD_CREATE(ALARM_CLOCK, TFD_NONBLOCK)), wheel_(now_ns() / kNanosPerTick) {
+  ASSERT_LOG(fd_ != -1, "cannot create timerfd: %s", strerror(errno));
+
+  reactable_ = reactor_->Register(
+      fd_, common::Bind(&TimerService::on_fire, common::Unretained(this)), common::Closure());
+}
+
+TimerService::~TimerService() {
+  reactor_->Unregister(reactable_);
+
+  int close_status;
+  RUN_NO_INTR(close_status = TIMERFD_CLOSE(fd_));
+  ASSERT(close_status != -1);
+}
+
+void TimerService::Schedule(Timer* timer, common::OnceClosure task, std::chrono::milliseconds delay) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  uint64_t now = now_ns();
+  catch_up_idle_wheel_locked(now);
+  forget_firing_locked(timer);
+  timer->task_ = std::move(task);
+  timer->repeating_task_ = common::Closure();
+  timer->period_ms_ = 0;
+  wheel_.Schedule(timer, nanos_to_expiry_tick(now + ticks_to_nanos(delay.count())));
+  rearm_locked(now);
+}
+
+void TimerService::SchedulePeriodic(Timer* timer, common::Closure task, std::chrono::milliseconds period) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (period.count() <= 0) {
+    // Same as a periodic timerfd with a zero interval: disarmed
+    forget_firing_locked(timer);
+    wheel_.Cancel(timer);
+    return;
+  }
+  uint64_t now = now_ns();
+  catch_up_idle_wheel_locked(now);
+  forget_firing_locked(timer);
+  timer->task_ = common::OnceClosure();
+  timer->repeating_task_ = std::move(task);
+  timer->period_ms_ = period.count();
+  wheel_.Schedule(timer, nanos_to_expiry_tick(now + ticks_to_nanos(period.count())));
+  rearm_locked(now);
+}
+
+void TimerService::Cancel(Timer* timer) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  // The timerfd is left armed; a wakeup with nothing to run is cheaper than a syscall on every cancel
+  forget_firing_locked(timer);
+  wheel_.Cancel(timer);
+}
+
+size_t TimerService::GetScheduledTimerCount() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return wheel_.Size();
+}
+
+uint64_t TimerService::now_ns() const {
+#ifdef USE_FAKE_TIMERS
+  return ticks_to_nanos(fake_timer::fake_timerfd_get_clock());
+#else
+  timespec now;
+  clock_gettime(CLOCK_BOOTTIME, &now);
+  return static_cast<uint64_t>(now.tv_sec) * 1000000000 + now.tv_nsec;
+#endif
+}
+
+void TimerService::catch_up_idle_wheel_locked(uint64_t now) {
+  // The wheel only advances when the timerfd fires. Move an empty wheel to the present so new timers don't need to
+  // cascade through slots that are already in the past.
+  if (wheel_.Size() == 0) {
+    std::vector<TimerWheel::Entry*> expired;
+    wheel_.Advance(now / kNanosPerTick, &expired);
+  }
+}
+
+void TimerService::rearm_locked(uint64_t now) {
+  auto next_tick = wheel_.GetNextEventTick();
+  if (!next_tick.has_value()) {
+    // Leave the timerfd armed, on_fire() disarms it when there is nothing left to run
+    return;
+  }
+  if (armed_tick_.has_value() && *armed_tick_ <= *next_tick) {
+    return;
+  }
+  uint64_t next_ns = ticks_to_nanos(*next_tick);
+  uint64_t delay_ns = next_ns > now ? next_ns - now : 0;
+  if (delay_ns == 0) {
+    // A zero itimerspec would disarm the timer instead, wait for one tick
+    delay_ns = kNanosPerTick;
+  }
+  itimerspec timer_itimerspec{
+      {/* interval for periodic timer */},
+      {static_cast<time_t>(delay_ns / 1000000000), static_cast<long>(delay_ns % 1000000000)}};
+  int result = TIMERFD_SETTIME(fd_, 0, &timer_itimerspec, nullptr);
+  ASSERT(result == 0);
+  armed_tick_ = next_tick;
+}
+
+void TimerService::forget_firing_locked(Timer* timer) {
+  // The timer may be cancelled, rescheduled or destroyed by an earlier task of the same pass, it must not run then
+  for (auto& firing : firing_) {
+    if (firing == timer) {
+      firing = nullptr;
+    }
+  }
+}
+
+void TimerService::on_fire() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    // Expirations may already have been reset by a concurrent rearm, the wheel decides what is due
+    uint64_t times_invoked;
+    ssize_t bytes_read;
+    RUN_NO_INTR(bytes_read = read(fd_, &times_invoked, sizeof(uint64_t)));
+    ASSERT(bytes_read == static_cast<ssize_t>(sizeof(uint64_t)) || errno == EAGAIN);
+    armed_tick_.reset();
+
+    uint64_t now = now_ns();
+    uint64_t now_tick = now / kNanosPerTick;
+    std::vector<TimerWheel::Entry*> expired;
+    // Periodic timers rescheduled at or before now_tick expire again in the next pass
+    for (wheel_.Advance(now_tick, &expired); !expired.empty(); wheel_.Advance(now_tick, &expired)) {
+      for (auto* entry : expired) {
+        Timer* timer = static_cast<Timer*>(entry);
+        firing_.push_back(timer);
+        if (timer->period_ms_ == 0) {
+          continue;
+        }
+        uint64_t next_tick = timer->GetExpiryTick() + timer->period_ms_;
+#ifndef USE_FAKE_TIMERS
+        // Like a periodic timerfd, fire once for all the periods that were missed, e.g. across a suspend
+        if (next_tick <= now_tick) {
+          next_tick += (now_tick - next_tick) / timer->period_ms_ * timer->period_ms_ + timer->period_ms_;
+        }
+#endif
+        wheel_.Schedule(timer, next_tick);
+      }
+      expired.clear();
+    }
+
+    if (!wheel_.GetNextEventTick().has_value()) {
+      itimerspec disarm_itimerspec{/* disarm timer */};
+      int result = TIMERFD_SETTIME(fd_, 0, &disarm_itimerspec, nullptr);
+      ASSERT(result == 0);
+    } else {
+      rearm_locked(now);
+    }
+  }
+
+  for (size_t i = 0;; i++) {
+    common::OnceClosure task;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (i >= firing_.size()) {
+        firing_.clear();
+        return;
+      }
+      Timer* timer = firing_[i];
+      if (timer == nullptr) {
+        continue;
+      }
+      if (timer->period_ms_ == 0) {
+        task = std::move(timer->task_);
+      } else {
+        task = common::OnceClosure(timer->repeating_task_);
+      }
+    }
+    std::move(task).Run();
+  }
+}
+
+}  // namespace os
+}  // namespace bluetooth
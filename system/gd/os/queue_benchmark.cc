@@ -14,11 +14,15 @@
  * limitations under the License.
  */
 
+#include <algorithm>
+#include <chrono>
 #include <future>
+#include <vector>
 
 #include "benchmark/benchmark.h"
 #include "os/handler.h"
 #include "os/queue.h"
+#include "os/spsc_queue.h"
 #include "os/thread.h"
 
 using ::benchmark::State;
@@ -37,6 +41,8 @@ class BM_QueuePerformance : public ::benchmark::Fixture {
   }
 
   void TearDown(State& st) override {
+    enqueue_handler_->Clear();
+    dequeue_handler_->Clear();
     delete enqueue_handler_;
     delete enqueue_thread_;
     delete dequeue_handler_;
@@ -54,13 +60,14 @@ class BM_QueuePerformance : public ::benchmark::Fixture {
   Handler* dequeue_handler_;
 };
 
+template <typename QueueType>
 class TestEnqueueEnd {
  public:
-  explicit TestEnqueueEnd(int64_t count, Queue<std::string>* queue, Handler* handler, std::promise<void>* promise)
+  explicit TestEnqueueEnd(int64_t count, QueueType* queue, Handler* handler, std::promise<void>* promise)
       : count_(count), handler_(handler), queue_(queue), promise_(promise) {}
 
   void RegisterEnqueue() {
-    handler_->Post(common::BindOnce(&TestEnqueueEnd::handle_register_enqueue, common::Unretained(this)));
+    handler_->Post(common::BindOnce(&TestEnqueueEnd<QueueType>::handle_register_enqueue, common::Unretained(this)));
   }
 
   void push(std::string data) {
@@ -95,22 +102,23 @@ class TestEnqueueEnd {
 
  private:
   Handler* handler_;
-  Queue<std::string>* queue_;
+  QueueType* queue_;
   std::promise<void>* promise_;
   std::mutex mutex_;
 
   void handle_register_enqueue() {
-    queue_->RegisterEnqueue(handler_, common::Bind(&TestEnqueueEnd::EnqueueCallbackForTest, common::Unretained(this)));
+    queue_->RegisterEnqueue(handler_, common::Bind(&TestEnqueueEnd<QueueType>::EnqueueCallbackForTest, common::Unretained(this)));
   }
 };
 
+template <typename QueueType>
 class TestDequeueEnd {
  public:
-  explicit TestDequeueEnd(int64_t count, Queue<std::string>* queue, Handler* handler, std::promise<void>* promise)
+  explicit TestDequeueEnd(int64_t count, QueueType* queue, Handler* handler, std::promise<void>* promise)
       : count_(count), handler_(handler), queue_(queue), promise_(promise) {}
 
   void RegisterDequeue() {
-    handler_->Post(common::BindOnce(&TestDequeueEnd::handle_register_dequeue, common::Unretained(this)));
+    handler_->Post(common::BindOnce(&TestDequeueEnd<QueueType>::handle_register_dequeue, common::Unretained(this)));
   }
 
   void DequeueCallbackForTest() {
@@ -129,11 +137,11 @@ class TestDequeueEnd {
 
  private:
   Handler* handler_;
-  Queue<std::string>* queue_;
+  QueueType* queue_;
   std::promise<void>* promise_;
 
   void handle_register_dequeue() {
-    queue_->RegisterDequeue(handler_, common::Bind(&TestDequeueEnd::DequeueCallbackForTest, common::Unretained(this)));
+    queue_->RegisterDequeue(handler_, common::Bind(&TestDequeueEnd<QueueType>::DequeueCallbackForTest, common::Unretained(this)));
   }
 };
 
@@ -145,12 +153,12 @@ BENCHMARK_DEFINE_F(BM_QueuePerformance, send_packet_vary_by_packet_num)(State& s
     // register dequeue
     std::promise<void> dequeue_promise;
     auto dequeue_future = dequeue_promise.get_future();
-    TestDequeueEnd test_dequeue_end(num_data_to_send_, &queue, enqueue_handler_, &dequeue_promise);
+    TestDequeueEnd<Queue<std::string>> test_dequeue_end(num_data_to_send_, &queue, enqueue_handler_, &dequeue_promise);
     test_dequeue_end.RegisterDequeue();
 
     // Push data to enqueue end buffer and register enqueue
     std::promise<void> enqueue_promise;
-    TestEnqueueEnd test_enqueue_end(num_data_to_send_, &queue, enqueue_handler_, &enqueue_promise);
+    TestEnqueueEnd<Queue<std::string>> test_enqueue_end(num_data_to_send_, &queue, enqueue_handler_, &enqueue_promise);
     for (int i = 0; i < num_data_to_send_; i++) {
       std::string data = std::to_string(1);
       test_enqueue_end.push(std::move(data));
@@ -179,12 +187,12 @@ BENCHMARK_DEFINE_F(BM_QueuePerformance, send_10000_packet_vary_by_packet_size)(S
     // register dequeue
     std::promise<void> dequeue_promise;
     auto dequeue_future = dequeue_promise.get_future();
-    TestDequeueEnd test_dequeue_end(num_data_to_send_, &queue, enqueue_handler_, &dequeue_promise);
+    TestDequeueEnd<Queue<std::string>> test_dequeue_end(num_data_to_send_, &queue, enqueue_handler_, &dequeue_promise);
     test_dequeue_end.RegisterDequeue();
 
     // Push data to enqueue end buffer and register enqueue
     std::promise<void> enqueue_promise;
-    TestEnqueueEnd test_enqueue_end(num_data_to_send_, &queue, enqueue_handler_, &enqueue_promise);
+    TestEnqueueEnd<Queue<std::string>> test_enqueue_end(num_data_to_send_, &queue, enqueue_handler_, &enqueue_promise);
     for (int i = 0; i < num_data_to_send_; i++) {
       std::string data = std::string(packet_size, 'x');
       test_enqueue_end.push(std::move(data));
@@ -202,5 +210,96 @@ BENCHMARK_REGISTER_F(BM_QueuePerformance, send_10000_packet_vary_by_packet_size)
     ->Iterations(100)
     ->UseRealTime();
 
+// Moves |num_packets| timestamps from the enqueue thread to the dequeue thread, recording how long each one waited
+template <typename QueueType>
+class TimestampTransfer {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  TimestampTransfer(QueueType* queue, int64_t num_packets, std::vector<int64_t>* latencies_ns)
+      : queue_(queue), num_packets_(num_packets), latencies_ns_(latencies_ns) {}
+
+  void Run(Handler* enqueue_handler, Handler* dequeue_handler) {
+    auto future = promise_.get_future();
+    queue_->RegisterDequeue(dequeue_handler, common::Bind(&TimestampTransfer::dequeue, common::Unretained(this)));
+    enqueue_handler->Post(common::BindOnce(
+        &TimestampTransfer::register_enqueue, common::Unretained(this), common::Unretained(enqueue_handler)));
+    future.wait();
+    // The last enqueue callback may still be returning, let it finish before the queue goes away
+    std::promise<void> enqueue_idle;
+    auto enqueue_idle_future = enqueue_idle.get_future();
+    enqueue_handler->Post(
+        common::BindOnce(&std::promise<void>::set_value, common::Unretained(&enqueue_idle)));
+    enqueue_idle_future.wait();
+  }
+
+ private:
+  void register_enqueue(Handler* handler) {
+    queue_->RegisterEnqueue(handler, common::Bind(&TimestampTransfer::enqueue, common::Unretained(this)));
+  }
+
+  std::unique_ptr<Clock::time_point> enqueue() {
+    if (++enqueued_ == num_packets_) {
+      queue_->UnregisterEnqueue();
+    }
+    return std::make_unique<Clock::time_point>(Clock::now());
+  }
+
+  void dequeue() {
+    auto sent = queue_->TryDequeue();
+    latencies_ns_->push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - *sent).count());
+    if (++dequeued_ == num_packets_) {
+      queue_->UnregisterDequeue();
+      promise_.set_value();
+    }
+  }
+
+  QueueType* queue_;
+  int64_t num_packets_;
+  std::vector<int64_t>* latencies_ns_;
+  int64_t enqueued_ = 0;
+  int64_t dequeued_ = 0;
+  std::promise<void> promise_;
+};
+
+// Sends state.range(0) packets across threads through a queue of state.range(1) entries
+template <typename QueueType>
+void cross_thread_transfer(State& state, Handler* enqueue_handler, Handler* dequeue_handler) {
+  int64_t num_packets = state.range(0);
+  std::vector<int64_t> latencies_ns;
+  for (auto _ : state) {
+    QueueType queue(state.range(1));
+    TimestampTransfer<QueueType> transfer(&queue, num_packets, &latencies_ns);
+    transfer.Run(enqueue_handler, dequeue_handler);
+  }
+
+  std::sort(latencies_ns.begin(), latencies_ns.end());
+  state.counters["packets_per_second"] =
+      benchmark::Counter(static_cast<double>(state.iterations() * num_packets), benchmark::Counter::kIsRate);
+  state.counters["p50_latency_us"] = latencies_ns[latencies_ns.size() / 2] / 1000.0;
+  state.counters["p99_latency_us"] = latencies_ns[latencies_ns.size() * 99 / 100] / 1000.0;
+}
+
+BENCHMARK_DEFINE_F(BM_QueuePerformance, queue_cross_thread_transfer)(State& state) {
+  cross_thread_transfer<Queue<std::chrono::steady_clock::time_point>>(state, enqueue_handler_, dequeue_handler_);
+}
+
+BENCHMARK_DEFINE_F(BM_QueuePerformance, spsc_queue_cross_thread_transfer)(State& state) {
+  cross_thread_transfer<SpscQueue<std::chrono::steady_clock::time_point>>(state, enqueue_handler_, dequeue_handler_);
+}
+
+// {number of packets, queue capacity}; 10 matches the HCI and L2CAP queues
+BENCHMARK_REGISTER_F(BM_QueuePerformance, queue_cross_thread_transfer)
+    ->Args({10000, 10})
+    ->Args({10000, 1000})
+    ->Iterations(20)
+    ->UseRealTime();
+
+BENCHMARK_REGISTER_F(BM_QueuePerformance, spsc_queue_cross_thread_transfer)
+    ->Args({10000, 10})
+    ->Args({10000, 1000})
+    ->Iterations(20)
+    ->UseRealTime();
+
 }  // namespace os
 }  // namespace bluetooth
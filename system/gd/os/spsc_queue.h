@@ -0,0 +1,110 @@
+/*
+ * Copyright 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "common/bind.h"
+#include "common/callback.h"
+#include "os/handler.h"
+#include "os/log.h"
+#include "os/queue.h"
+#include "os/reactor.h"
+
+namespace bluetooth {
+namespace os {
+
+// A drop-in replacement for |Queue| when there is a single producer and a single consumer at any time, i.e. the
+// enqueue callback and TryDequeue() are each only ever invoked from one thread at a time. Data lives in a lock-free
+// ring, and the reactor is only woken up through the two events when the queue crosses the empty or full boundary,
+// instead of two eventfd operations and a lock for every item.
+template <typename T>
+class SpscQueue : public IQueueEnqueue<T>, public IQueueDequeue<T> {
+ public:
+  using EnqueueCallback = common::Callback<std::unique_ptr<T>()>;
+  using DequeueCallback = common::Callback<void()>;
+  // Create a queue with |capacity| is the maximum number of messages a queue can contain
+  explicit SpscQueue(size_t capacity);
+  ~SpscQueue();
+  // Same contract as Queue::RegisterEnqueue
+  void RegisterEnqueue(Handler* handler, EnqueueCallback callback) override;
+  // Same contract as Queue::UnregisterEnqueue
+  void UnregisterEnqueue() override;
+  // Same contract as Queue::RegisterDequeue
+  void RegisterDequeue(Handler* handler, DequeueCallback callback) override;
+  // Same contract as Queue::UnregisterDequeue
+  void UnregisterDequeue() override;
+
+  // Try to dequeue an item from this queue. Return nullptr when there is nothing in the queue.
+  std::unique_ptr<T> TryDequeue() override;
+
+ private:
+  void EnqueueCallbackInternal(EnqueueCallback callback);
+  void DequeueCallbackInternal(DequeueCallback callback);
+
+  // Only accurate on the consumer thread, which owns head_
+  bool consumer_sees_data() const {
+    return tail_.load(std::memory_order_acquire) != head_.load(std::memory_order_relaxed);
+  }
+
+  // Only accurate on the producer thread, which owns tail_
+  bool producer_sees_space() const {
+    return tail_.load(std::memory_order_relaxed) - head_.load(std::memory_order_acquire) < capacity_;
+  }
+
+  // Reset |event| now that its condition looked false, unless it became true again in the meantime. The other side
+  // only notifies on the transition, so re-checking after the reset is what keeps a wakeup from being lost.
+  template <typename Condition>
+  void ResetUnless(Reactor::Event* event, Condition condition) {
+    event->Clear();
+    if (condition()) {
+      event->Notify();
+    }
+  }
+
+  const size_t capacity_;
+  // Ring storage, sized to a power of two so that indexes are a mask away from the running counters
+  std::vector<std::unique_ptr<T>> ring_;
+  const size_t mask_;
+  // Running count of dequeued items, only written by the consumer
+  alignas(64) std::atomic<size_t> head_{0};
+  // Running count of enqueued items, only written by the producer
+  alignas(64) std::atomic<size_t> tail_{0};
+
+  // Guards registration only, never taken on the data path
+  std::mutex mutex_;
+
+  class QueueEndpoint {
+   public:
+    Reactor::Event event_;
+    Handler* handler_ = nullptr;
+    Reactor::Reactable* reactable_ = nullptr;
+  };
+
+  // Readable while the queue is not full
+  QueueEndpoint enqueue_;
+  // Readable while the queue is not empty
+  QueueEndpoint dequeue_;
+};
+
+#include "os/linux_generic/spsc_queue.tpp"
+
+}  // namespace os
+}  // namespace bluetooth
@@ -14,6 +14,7 @@
  * limitations under the License.
  */
 
+#include <chrono>
 #include <future>
 #include <memory>
 #include <thread>
@@ -36,6 +37,7 @@ class BM_ThreadPerformance : public ::benchmark::Fixture {
     benchmark::Fixture::SetUp(st);
     counter_promise_ = std::promise<void>();
     counter_ = 0;
+    total_latency_ = std::chrono::steady_clock::duration::zero();
   }
   void TearDown(State& st) override {
     benchmark::Fixture::TearDown(st);
@@ -51,6 +53,12 @@ class BM_ThreadPerformance : public ::benchmark::Fixture {
     counter_promise_.set_value();
   }
 
+  void callback_latency(std::chrono::steady_clock::time_point posted_at) {
+    total_latency_ += std::chrono::steady_clock::now() - posted_at;
+    callback_batch();
+  }
+
+  std::chrono::steady_clock::duration total_latency_;
   int64_t num_messages_to_send_;
   int64_t counter_;
   std::promise<void> counter_promise_;
@@ -64,6 +72,7 @@ class BM_ReactorThread : public BM_ThreadPerformance {
     handler_ = std::make_unique<Handler>(thread_.get());
   }
   void TearDown(State& st) override {
+    handler_->Clear();
     handler_ = nullptr;
     thread_->Stop();
     thread_ = nullptr;
@@ -95,6 +104,32 @@ BENCHMARK_REGISTER_F(BM_ReactorThread, batch_enque_dequeue)
     ->Iterations(1)
     ->UseRealTime();
 
+BENCHMARK_DEFINE_F(BM_ReactorThread, post_to_run_latency)(State& state) {
+  for (auto _ : state) {
+    num_messages_to_send_ = state.range(0);
+    counter_ = 0;
+    counter_promise_ = std::promise<void>();
+    std::future<void> counter_future = counter_promise_.get_future();
+    for (int i = 0; i < num_messages_to_send_; i++) {
+      handler_->Post(BindOnce(
+          &BM_ReactorThread_post_to_run_latency_Benchmark::callback_latency,
+          bluetooth::common::Unretained(this),
+          std::chrono::steady_clock::now()));
+    }
+    counter_future.wait();
+  }
+  state.counters["tasks_per_second"] =
+      benchmark::Counter(state.iterations() * num_messages_to_send_, benchmark::Counter::kIsRate);
+  state.counters["avg_latency_us"] =
+      std::chrono::duration<double, std::micro>(total_latency_).count() / num_messages_to_send_;
+};
+
+BENCHMARK_REGISTER_F(BM_ReactorThread, post_to_run_latency)
+    ->Arg(1000)
+    ->Arg(100000)
+    ->Iterations(1)
+    ->UseRealTime();
+
 BENCHMARK_DEFINE_F(BM_ReactorThread, sequential_execution)(State& state) {
   for (auto _ : state) {
     num_messages_to_send_ = state.range(0);
@@ -115,3 +150,70 @@ BENCHMARK_REGISTER_F(BM_ReactorThread, sequential_execution)
     ->Arg(100000)
     ->Iterations(1)
     ->UseRealTime();
+
+class BM_BatchedReactorThread : public BM_ThreadPerformance {
+ protected:
+  static constexpr size_t kMaxTasksPerWakeup = 64;
+  void SetUp(State& st) override {
+    BM_ThreadPerformance::SetUp(st);
+    thread_ = std::make_unique<Thread>("BM_BatchedReactorThread thread", Thread::Priority::NORMAL);
+    handler_ = std::make_unique<Handler>(thread_.get(), kMaxTasksPerWakeup);
+  }
+  void TearDown(State& st) override {
+    handler_->Clear();
+    handler_ = nullptr;
+    thread_->Stop();
+    thread_ = nullptr;
+    BM_ThreadPerformance::TearDown(st);
+  }
+  std::unique_ptr<Thread> thread_;
+  std::unique_ptr<Handler> handler_;
+};
+
+BENCHMARK_DEFINE_F(BM_BatchedReactorThread, batch_enque_dequeue)(State& state) {
+  for (auto _ : state) {
+    num_messages_to_send_ = state.range(0);
+    counter_ = 0;
+    counter_promise_ = std::promise<void>();
+    std::future<void> counter_future = counter_promise_.get_future();
+    for (int i = 0; i < num_messages_to_send_; i++) {
+      handler_->Post(BindOnce(
+          &BM_BatchedReactorThread_batch_enque_dequeue_Benchmark::callback_batch, bluetooth::common::Unretained(this)));
+    }
+    counter_future.wait();
+  }
+};
+
+BENCHMARK_REGISTER_F(BM_BatchedReactorThread, batch_enque_dequeue)
+    ->Arg(10)
+    ->Arg(1000)
+    ->Arg(10000)
+    ->Arg(100000)
+    ->Iterations(1)
+    ->UseRealTime();
+
+BENCHMARK_DEFINE_F(BM_BatchedReactorThread, post_to_run_latency)(State& state) {
+  for (auto _ : state) {
+    num_messages_to_send_ = state.range(0);
+    counter_ = 0;
+    counter_promise_ = std::promise<void>();
+    std::future<void> counter_future = counter_promise_.get_future();
+    for (int i = 0; i < num_messages_to_send_; i++) {
+      handler_->Post(BindOnce(
+          &BM_BatchedReactorThread_post_to_run_latency_Benchmark::callback_latency,
+          bluetooth::common::Unretained(this),
+          std::chrono::steady_clock::now()));
+    }
+    counter_future.wait();
+  }
+  state.counters["tasks_per_second"] =
+      benchmark::Counter(state.iterations() * num_messages_to_send_, benchmark::Counter::kIsRate);
+  state.counters["avg_latency_us"] =
+      std::chrono::duration<double, std::micro>(total_latency_).count() / num_messages_to_send_;
+};
+
+BENCHMARK_REGISTER_F(BM_BatchedReactorThread, post_to_run_latency)
+    ->Arg(1000)
+    ->Arg(100000)
+    ->Iterations(1)
+    ->UseRealTime();
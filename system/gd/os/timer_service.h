@@ -0,0 +1,90 @@
+/*
+ * Copyright 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+#include "common/callback.h"
+#include "os/reactor.h"
+#include "os/timer_wheel.h"
+#include "os/utils.h"
+
+namespace bluetooth {
+namespace os {
+
+// Multiplexes all the alarms of a reactor thread onto a single timerfd. Timers are kept in a TimerWheel, so
+// scheduling and cancelling don't need a syscall unless the earliest deadline of the thread moves forward. Expired
+// tasks run on the reactor thread, one at a time and without any lock held.
+class TimerService {
+ public:
+  // A timer slot owned by an Alarm or RepeatingAlarm. Must be cancelled before it is destroyed.
+  class Timer : private TimerWheel::Entry {
+   public:
+    Timer() = default;
+    Timer(const Timer&) = delete;
+    Timer& operator=(const Timer&) = delete;
+
+   private:
+    friend class TimerService;
+    common::OnceClosure task_;
+    common::Closure repeating_task_;
+    uint64_t period_ms_ = 0;
+  };
+
+  explicit TimerService(Reactor* reactor);
+
+  TimerService(const TimerService&) = delete;
+  TimerService& operator=(const TimerService&) = delete;
+
+  ~TimerService();
+
+  // Run task once after delay, replacing whatever timer was scheduled before
+  void Schedule(Timer* timer, common::OnceClosure task, std::chrono::milliseconds delay);
+
+  // Run task every period, replacing whatever timer was scheduled before
+  void SchedulePeriodic(Timer* timer, common::Closure task, std::chrono::milliseconds period);
+
+  // Cancel the timer. No-op if it's not armed.
+  void Cancel(Timer* timer);
+
+  // Number of timers currently armed on this thread
+  size_t GetScheduledTimerCount() const;
+
+ private:
+  uint64_t now_ns() const;
+  void catch_up_idle_wheel_locked(uint64_t now);
+  void rearm_locked(uint64_t now_ns);
+  void forget_firing_locked(Timer* timer);
+  void on_fire();
+
+  Reactor* reactor_;
+  int fd_;
+  Reactor::Reactable* reactable_;
+  mutable std::mutex mutex_;
+  TimerWheel wheel_;
+  // Tick the timerfd is currently armed for, if any
+  std::optional<uint64_t> armed_tick_;
+  // Timers expired in the current on_fire() pass. Nulled when cancelled or rescheduled before their task runs.
+  std::vector<Timer*> firing_;
+};
+
+}  // namespace os
+}  // namespace bluetooth
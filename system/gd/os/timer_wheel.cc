@@ -0,0 +1,177 @@
+/*
+ * Copyright 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "os/timer_wheel.h"
+
+namespace bluetooth {
+namespace os {
+
+namespace {
+constexpr uint64_t kSlotMask = TimerWheel::kSlotsPerLevel - 1;
+
+constexpr int level_shift(int level) {
+  return level * TimerWheel::kBitsPerLevel;
+}
+
+inline uint64_t rotate_right(uint64_t bits, int count) {
+  return (bits >> count) | (bits << ((64 - count) & 63));
+}
+}  // namespace
+
+TimerWheel::TimerWheel(uint64_t now_tick) : now_tick_(now_tick) {}
+
+void TimerWheel::Schedule(Entry* entry, uint64_t expiry_tick) {
+  if (entry->IsScheduled()) {
+    unlink(entry);
+  } else {
+    size_++;
+  }
+  entry->expiry_tick_ = expiry_tick;
+  insert(entry);
+}
+
+void TimerWheel::Cancel(Entry* entry) {
+  if (!entry->IsScheduled()) {
+    return;
+  }
+  unlink(entry);
+  size_--;
+}
+
+void TimerWheel::Advance(uint64_t now_tick, std::vector<Entry*>* expired) {
+  drain(&expired_, expired);
+  for (auto next = next_slot_tick(); next.has_value() && *next <= now_tick; next = next_slot_tick()) {
+    now_tick_ = *next;
+    // Cascade the slots starting at this tick from the top down, so entries can fall through several levels at once
+    for (int level = kLevels - 1; level > 0; level--) {
+      if ((now_tick_ & ((uint64_t{1} << level_shift(level)) - 1)) != 0) {
+        continue;
+      }
+      uint64_t index = (now_tick_ >> level_shift(level)) & kSlotMask;
+      if ((occupied_[level] & (uint64_t{1} << index)) == 0) {
+        continue;
+      }
+      Entry* entry = slots_[level][index].head;
+      slots_[level][index] = Slot();
+      occupied_[level] &= ~(uint64_t{1} << index);
+      while (entry != nullptr) {
+        Entry* next_entry = entry->next_;
+        entry->slot_ = nullptr;
+        insert(entry);
+        entry = next_entry;
+      }
+    }
+    drain(&expired_, expired);
+    uint64_t index = now_tick_ & kSlotMask;
+    if ((occupied_[0] & (uint64_t{1} << index)) != 0) {
+      drain(&slots_[0][index], expired);
+    }
+  }
+  if (now_tick > now_tick_) {
+    now_tick_ = now_tick;
+  }
+}
+
+std::optional<uint64_t> TimerWheel::GetNextEventTick() const {
+  if (expired_.head != nullptr) {
+    return now_tick_;
+  }
+  return next_slot_tick();
+}
+
+void TimerWheel::insert(Entry* entry) {
+  if (entry->expiry_tick_ <= now_tick_) {
+    link(&expired_, entry);
+    return;
+  }
+  uint64_t delta = entry->expiry_tick_ - now_tick_;
+  uint64_t slot_tick = entry->expiry_tick_;
+  if (delta > kMaxDeltaTicks) {
+    slot_tick = now_tick_ + kMaxDeltaTicks;
+    delta = kMaxDeltaTicks;
+  }
+  int level = 0;
+  while (level < kLevels - 1 && delta >= (uint64_t{1} << level_shift(level + 1))) {
+    level++;
+  }
+  uint64_t index = (slot_tick >> level_shift(level)) & kSlotMask;
+  link(&slots_[level][index], entry);
+  occupied_[level] |= uint64_t{1} << index;
+}
+
+void TimerWheel::link(Slot* slot, Entry* entry) {
+  entry->slot_ = slot;
+  entry->next_ = nullptr;
+  entry->prev_ = slot->tail;
+  if (slot->tail != nullptr) {
+    slot->tail->next_ = entry;
+  } else {
+    slot->head = entry;
+  }
+  slot->tail = entry;
+}
+
+void TimerWheel::unlink(Entry* entry) {
+  Slot* slot = entry->slot_;
+  if (entry->prev_ != nullptr) {
+    entry->prev_->next_ = entry->next_;
+  } else {
+    slot->head = entry->next_;
+  }
+  if (entry->next_ != nullptr) {
+    entry->next_->prev_ = entry->prev_;
+  } else {
+    slot->tail = entry->prev_;
+  }
+  entry->slot_ = nullptr;
+  entry->prev_ = nullptr;
+  entry->next_ = nullptr;
+
+  if (slot->head == nullptr && slot != &expired_) {
+    auto offset = static_cast<size_t>(slot - &slots_[0][0]);
+    occupied_[offset / kSlotsPerLevel] &= ~(uint64_t{1} << (offset % kSlotsPerLevel));
+  }
+}
+
+void TimerWheel::drain(Slot* slot, std::vector<Entry*>* expired) {
+  while (slot->head != nullptr) {
+    Entry* entry = slot->head;
+    unlink(entry);
+    size_--;
+    expired->push_back(entry);
+  }
+}
+
+std::optional<uint64_t> TimerWheel::next_slot_tick() const {
+  std::optional<uint64_t> next;
+  for (int level = 0; level < kLevels; level++) {
+    if (occupied_[level] == 0) {
+      continue;
+    }
+    // Slots are searched starting right after the current one; an occupied current slot is a full rotation away
+    uint64_t current_slot = now_tick_ >> level_shift(level);
+    int start = static_cast<int>((current_slot + 1) & kSlotMask);
+    uint64_t distance = __builtin_ctzll(rotate_right(occupied_[level], start)) + 1;
+    uint64_t tick = (current_slot + distance) << level_shift(level);
+    if (!next.has_value() || tick < *next) {
+      next = tick;
+    }
+  }
+  return next;
+}
+
+}  // namespace os
+}  // namespace bluetooth
@@ -0,0 +1,113 @@
+/*
+ * Copyright 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace bluetooth {
+namespace os {
+
+// A hierarchical timer wheel with millisecond ticks. Entries are intrusive, so scheduling and cancelling are O(1) and
+// never allocate. Each level has 64 slots, and each level's slot spans the whole range of the level below it. Entries
+// far in the future are cascaded down one level at a time as the wheel advances, so expiry stays exact to the tick.
+// Not thread safe.
+class TimerWheel {
+ public:
+  class Entry;
+
+  struct Slot {
+    Entry* head = nullptr;
+    Entry* tail = nullptr;
+  };
+
+  // Embedded in the object being scheduled. Must be cancelled before it is destroyed.
+  class Entry {
+   public:
+    Entry() = default;
+    Entry(const Entry&) = delete;
+    Entry& operator=(const Entry&) = delete;
+
+    bool IsScheduled() const {
+      return slot_ != nullptr;
+    }
+
+    uint64_t GetExpiryTick() const {
+      return expiry_tick_;
+    }
+
+   private:
+    friend class TimerWheel;
+    uint64_t expiry_tick_ = 0;
+    Slot* slot_ = nullptr;
+    Entry* prev_ = nullptr;
+    Entry* next_ = nullptr;
+  };
+
+  static constexpr int kBitsPerLevel = 6;
+  static constexpr int kSlotsPerLevel = 1 << kBitsPerLevel;
+  static constexpr int kLevels = 6;
+  // Entries further out than this are parked in the last slot of the top level and re-placed when it cascades
+  static constexpr uint64_t kMaxDeltaTicks = (uint64_t{1} << (kBitsPerLevel * kLevels)) - 1;
+
+  explicit TimerWheel(uint64_t now_tick);
+
+  TimerWheel(const TimerWheel&) = delete;
+  TimerWheel& operator=(const TimerWheel&) = delete;
+
+  // Schedule entry to expire at expiry_tick, rescheduling it if already scheduled. Entries scheduled in the past
+  // expire on the next Advance().
+  void Schedule(Entry* entry, uint64_t expiry_tick);
+
+  // Remove entry from the wheel. No-op if it's not scheduled.
+  void Cancel(Entry* entry);
+
+  // Advance the wheel to now_tick and append every expired entry to expired, in expiry order. Expired entries are no
+  // longer scheduled when this returns.
+  void Advance(uint64_t now_tick, std::vector<Entry*>* expired);
+
+  // The next tick at which Advance() has work to do, either an expiry or a cascade of a higher level slot. Empty if
+  // there are no entries scheduled.
+  std::optional<uint64_t> GetNextEventTick() const;
+
+  uint64_t GetCurrentTick() const {
+    return now_tick_;
+  }
+
+  size_t Size() const {
+    return size_;
+  }
+
+ private:
+  void insert(Entry* entry);
+  void link(Slot* slot, Entry* entry);
+  void unlink(Entry* entry);
+  void drain(Slot* slot, std::vector<Entry*>* expired);
+  std::optional<uint64_t> next_slot_tick() const;
+
+  uint64_t now_tick_;
+  size_t size_ = 0;
+  // Entries whose expiry tick has already been reached
+  Slot expired_;
+  Slot slots_[kLevels][kSlotsPerLevel];
+  uint64_t occupied_[kLevels] = {};
+};
+
+}  // namespace os
+}  // namespace bluetooth
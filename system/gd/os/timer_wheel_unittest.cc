@@ -0,0 +1,173 @@
+/*
+ * Copyright 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "os/timer_wheel.h"
+
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace bluetooth {
+namespace os {
+namespace {
+
+using Entry = TimerWheel::Entry;
+
+std::vector<Entry*> AdvanceTo(TimerWheel* wheel, uint64_t tick) {
+  std::vector<Entry*> expired;
+  wheel->Advance(tick, &expired);
+  return expired;
+}
+
+TEST(TimerWheelTest, empty) {
+  TimerWheel wheel(0);
+  ASSERT_FALSE(wheel.GetNextEventTick().has_value());
+  ASSERT_TRUE(AdvanceTo(&wheel, 1000).empty());
+  ASSERT_EQ(wheel.GetCurrentTick(), 1000u);
+}
+
+TEST(TimerWheelTest, expire_exact_tick) {
+  TimerWheel wheel(100);
+  Entry entry;
+  wheel.Schedule(&entry, 110);
+  ASSERT_TRUE(entry.IsScheduled());
+  ASSERT_EQ(wheel.GetNextEventTick(), 110u);
+  ASSERT_TRUE(AdvanceTo(&wheel, 109).empty());
+  auto expired = AdvanceTo(&wheel, 110);
+  ASSERT_EQ(expired.size(), 1u);
+  ASSERT_EQ(expired[0], &entry);
+  ASSERT_FALSE(entry.IsScheduled());
+  ASSERT_EQ(wheel.Size(), 0u);
+}
+
+TEST(TimerWheelTest, schedule_in_the_past_expires_on_next_advance) {
+  TimerWheel wheel(100);
+  Entry entry;
+  wheel.Schedule(&entry, 50);
+  ASSERT_EQ(wheel.GetNextEventTick(), 100u);
+  auto expired = AdvanceTo(&wheel, 100);
+  ASSERT_EQ(expired.size(), 1u);
+}
+
+TEST(TimerWheelTest, cancel) {
+  TimerWheel wheel(0);
+  Entry entry;
+  wheel.Schedule(&entry, 10);
+  wheel.Cancel(&entry);
+  ASSERT_FALSE(entry.IsScheduled());
+  ASSERT_FALSE(wheel.GetNextEventTick().has_value());
+  ASSERT_TRUE(AdvanceTo(&wheel, 100).empty());
+  wheel.Cancel(&entry);
+}
+
+TEST(TimerWheelTest, reschedule) {
+  TimerWheel wheel(0);
+  Entry entry;
+  wheel.Schedule(&entry, 10);
+  wheel.Schedule(&entry, 5000);
+  ASSERT_EQ(wheel.Size(), 1u);
+  ASSERT_TRUE(AdvanceTo(&wheel, 4999).empty());
+  ASSERT_EQ(AdvanceTo(&wheel, 5000).size(), 1u);
+}
+
+TEST(TimerWheelTest, far_entries_cascade_to_exact_tick) {
+  const uint64_t delays[] = {63, 64, 65, 4095, 4096, 4097, 262143, 262144, 3600 * 1000, TimerWheel::kMaxDeltaTicks};
+  for (uint64_t start : {0ull, 37ull, 4095ull, 1000000007ull}) {
+    for (uint64_t delay : delays) {
+      TimerWheel wheel(start);
+      Entry entry;
+      wheel.Schedule(&entry, start + delay);
+      ASSERT_TRUE(AdvanceTo(&wheel, start + delay - 1).empty()) << "start " << start << " delay " << delay;
+      ASSERT_EQ(AdvanceTo(&wheel, start + delay).size(), 1u) << "start " << start << " delay " << delay;
+    }
+  }
+}
+
+TEST(TimerWheelTest, beyond_max_delta) {
+  TimerWheel wheel(0);
+  Entry entry;
+  uint64_t expiry = TimerWheel::kMaxDeltaTicks * 3 + 17;
+  wheel.Schedule(&entry, expiry);
+  ASSERT_TRUE(AdvanceTo(&wheel, expiry - 1).empty());
+  ASSERT_EQ(AdvanceTo(&wheel, expiry).size(), 1u);
+}
+
+TEST(TimerWheelTest, next_event_tick_never_after_expiry) {
+  TimerWheel wheel(12345);
+  Entry entry;
+  wheel.Schedule(&entry, 12345 + 100000);
+  uint64_t wakeups = 0;
+  while (entry.IsScheduled()) {
+    auto next = wheel.GetNextEventTick();
+    ASSERT_TRUE(next.has_value());
+    ASSERT_LE(*next, entry.GetExpiryTick());
+    AdvanceTo(&wheel, *next);
+    wakeups++;
+  }
+  ASSERT_LE(wakeups, static_cast<uint64_t>(TimerWheel::kLevels));
+}
+
+TEST(TimerWheelTest, random_churn_matches_reference) {
+  constexpr int kNumEntries = 2000;
+  std::mt19937_64 random(42);
+  TimerWheel wheel(random() % 100000);
+  std::vector<std::unique_ptr<Entry>> entries;
+  std::map<Entry*, uint64_t> reference;
+  for (int i = 0; i < kNumEntries; i++) {
+    entries.push_back(std::make_unique<Entry>());
+  }
+  uint64_t now = wheel.GetCurrentTick();
+  for (int round = 0; round < 200; round++) {
+    for (int i = 0; i < 100; i++) {
+      Entry* entry = entries[random() % kNumEntries].get();
+      if (random() % 4 == 0) {
+        wheel.Cancel(entry);
+        reference.erase(entry);
+      } else {
+        uint64_t expiry = now + random() % (random() % 2 ? 100 : 500000);
+        wheel.Schedule(entry, expiry);
+        reference[entry] = expiry;
+      }
+    }
+    ASSERT_EQ(wheel.Size(), reference.size());
+    now += random() % 20000;
+    auto expired = AdvanceTo(&wheel, now);
+    uint64_t last_expiry = 0;
+    for (auto* entry : expired) {
+      ASSERT_EQ(reference.count(entry), 1u);
+      ASSERT_LE(reference[entry], now);
+      ASSERT_GE(reference[entry], last_expiry);
+      last_expiry = std::max(last_expiry, reference[entry]);
+      reference.erase(entry);
+    }
+    for (const auto& [entry, expiry] : reference) {
+      ASSERT_GT(expiry, now);
+      ASSERT_TRUE(entry->IsScheduled());
+    }
+  }
+  for (auto& entry : entries) {
+    wheel.Cancel(entry.get());
+  }
+  ASSERT_EQ(wheel.Size(), 0u);
+}
+
+}  // namespace
+}  // namespace os
+}  // namespace bluetooth
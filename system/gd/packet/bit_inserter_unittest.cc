@@ -78,5 +78,24 @@ TEST(BitInserterTest, observerTest) {
   ASSERT_EQ(result.size(), copy.size());
 }
 
+TEST(BitInserterTest, insertBytesTest) {
+  std::vector<uint8_t> bytes;
+  BitInserter it(bytes);
+  std::vector<uint8_t> copy;
+  it.RegisterObserver(ByteObserver([&copy](uint8_t byte) { copy.push_back(byte); }, []() { return 0; }));
+
+  std::vector<uint8_t> to_insert = {0x01, 0x23, 0x45};
+  it.insert_bytes(to_insert.data(), to_insert.size());
+  // Unaligned bytes are shifted like with insert_byte()
+  it.insert_bits(0b1010, 4);
+  it.insert_bytes(to_insert.data(), to_insert.size());
+  it.insert_bits(0b0101, 4);
+  std::vector<uint8_t> result = {0x01, 0x23, 0x45, 0x1a, 0x30, 0x52, 0x54};
+
+  ASSERT_EQ(result, bytes);
+  ASSERT_EQ(result, copy);
+  it.UnregisterObserver();
+}
+
 }  // namespace packet
 }  // namespace bluetooth
@@ -42,12 +42,12 @@ class EndianInserter {
   template <typename FixedWidthPODType, typename std::enable_if<std::is_pod<FixedWidthPODType>::value, int>::type = 0>
   void insert(FixedWidthPODType value, BitInserter& it) const {
     uint8_t* raw_bytes = (uint8_t*)&value;
+    if (little_endian == true) {
+      it.insert_bytes(raw_bytes, sizeof(FixedWidthPODType));
+      return;
+    }
     for (size_t i = 0; i < sizeof(FixedWidthPODType); i++) {
-      if (little_endian == true) {
-        it.insert_byte(raw_bytes[i]);
-      } else {
-        it.insert_byte(raw_bytes[sizeof(FixedWidthPODType) - i - 1]);
-      }
+      it.insert_byte(raw_bytes[sizeof(FixedWidthPODType) - i - 1]);
     }
   }
 
@@ -57,12 +57,12 @@ class EndianInserter {
       typename std::enable_if<std::is_base_of<CustomFieldFixedSizeInterface<T>, T>::value, int>::type = 0>
   void insert(const T& value, BitInserter& it) const {
     auto* raw_bytes = value.data();
+    if (little_endian == true) {
+      it.insert_bytes(raw_bytes, CustomFieldFixedSizeInterface<T>::length());
+      return;
+    }
     for (size_t i = 0; i < CustomFieldFixedSizeInterface<T>::length(); i++) {
-      if (little_endian == true) {
-        it.insert_byte(raw_bytes[i]);
-      } else {
-        it.insert_byte(raw_bytes[CustomFieldFixedSizeInterface<T>::length() - i - 1]);
-      }
+      it.insert_byte(raw_bytes[CustomFieldFixedSizeInterface<T>::length() - i - 1]);
     }
   }
 
@@ -72,6 +72,10 @@ class EndianInserter {
   void insert(FixedWidthIntegerType value, BitInserter& it, size_t num_bits) const {
     ASSERT(num_bits <= (sizeof(FixedWidthIntegerType) * 8));
 
+    if (little_endian == true && num_bits % 8 == 0) {
+      it.insert_bytes((uint8_t*)&value, num_bits / 8);
+      return;
+    }
     for (size_t i = 0; i < num_bits / 8; i++) {
       if (little_endian == true) {
         it.insert_byte(static_cast<uint8_t>(static_cast<uint64_t>(value) >> (i * 8)));
@@ -97,6 +101,10 @@ class EndianInserter {
   void insert_vector(const std::vector<FixedWidthIntegerType>& vec, BitInserter& it) const {
     static_assert(std::is_pod<FixedWidthIntegerType>::value,
                   "EndianInserter::insert requires a vector with elements of a fixed-size.");
+    if (sizeof(FixedWidthIntegerType) == 1) {
+      it.insert_bytes((const uint8_t*)vec.data(), vec.size());
+      return;
+    }
     for (const auto& element : vec) {
       insert(element, it);
     }
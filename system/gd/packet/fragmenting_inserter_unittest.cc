@@ -121,6 +121,28 @@ TEST(FragmentingInserterTest, testMtuBoundaries) {
   ASSERT_EQ(kPacketSize, fragments_mtu_is_more[0]->size());
 }
 
+TEST(FragmentingInserterTest, insertBytesTest) {
+  std::vector<uint8_t> counts;
+  for (size_t i = 0; i < 10; i++) {
+    counts.push_back(static_cast<uint8_t>(i));
+  }
+  std::vector<std::unique_ptr<RawBuilder>> fragments;
+  FragmentingInserter it(4, std::back_insert_iterator(fragments));
+  it.insert_byte(0xff);
+  it.insert_bytes(counts.data(), counts.size());
+  it.finalize();
+
+  ASSERT_EQ(3ul, fragments.size());
+  std::vector<uint8_t> bytes;
+  BitInserter bit_inserter(bytes);
+  for (const auto& fragment : fragments) {
+    ASSERT_LE(fragment->size(), 4ul);
+    fragment->Serialize(bit_inserter);
+  }
+  std::vector<uint8_t> result = {0xff, 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09};
+  ASSERT_EQ(result, bytes);
+}
+
 constexpr size_t kPacketSize = 128;
 class FragmentingTest : public ::testing::TestWithParam<size_t> {
  public:
@@ -22,11 +22,19 @@ namespace bluetooth {
 namespace packet {
 
 template <bool little_endian>
-Iterator<little_endian>::Iterator(const std::forward_list<View>& data, size_t offset) {
-  data_ = data;
-  index_ = offset;
-  begin_ = 0;
-  end_ = 0;
+Iterator<little_endian>::Iterator(const std::forward_list<View>& data, size_t offset)
+    : index_(offset), begin_(0), end_(0) {
+  if (data.empty()) {
+    // Nothing to read, e.g. the end of a StructRange, which is created on every loop iteration: don't allocate
+    return;
+  }
+  if (std::next(data.begin()) == data.end()) {
+    contiguous_view_.emplace(data.front());
+    contiguous_data_ = contiguous_view_->data();
+    end_ = contiguous_view_->size();
+    return;
+  }
+  fragments_ = std::make_shared<const std::forward_list<View>>(data);
   for (auto& view : data) {
     end_ += view.size();
   }
@@ -83,7 +91,9 @@ Iterator<little_endian>& Iterator<little_endian>::operator=(const Iterator<littl
   if (this == &itr) {
     return *this;
   }
-  this->data_ = itr.data_;
+  this->fragments_ = itr.fragments_;
+  this->contiguous_view_ = itr.contiguous_view_;
+  this->contiguous_data_ = itr.contiguous_data_;
   this->begin_ = itr.begin_;
   this->end_ = itr.end_;
   this->index_ = itr.index_;
@@ -128,9 +138,12 @@ uint8_t Iterator<little_endian>::operator*() const {
       index_,
       begin_,
       end_);
+  if (contiguous_data_ != nullptr) {
+    return contiguous_data_[index_];
+  }
   size_t index = index_;
 
-  for (auto view : data_) {
+  for (const auto& view : *fragments_) {
     if (index < view.size()) {
       return view[index];
     }
@@ -17,8 +17,10 @@
 #pragma once
 
 #include <cstdint>
+#include <cstring>
 #include <forward_list>
 #include <memory>
+#include <optional>
 #include <type_traits>
 
 #include "packet/custom_field_fixed_size_interface.h"
@@ -83,6 +85,10 @@ class Iterator : public IteratorTraits {
     FixedWidthPODType extracted_value{};
     uint8_t* value_ptr = (uint8_t*)&extracted_value;
 
+    if (HasContiguousBytes(sizeof(FixedWidthPODType))) {
+      CopyContiguousBytes(value_ptr, sizeof(FixedWidthPODType));
+      return extracted_value;
+    }
     for (size_t i = 0; i < sizeof(FixedWidthPODType); i++) {
       size_t index = (little_endian ? i : sizeof(FixedWidthPODType) - i - 1);
       value_ptr[index] = this->operator*();
@@ -94,6 +100,10 @@ class Iterator : public IteratorTraits {
   template <typename T, typename std::enable_if<std::is_base_of_v<CustomFieldFixedSizeInterface<T>, T>, int>::type = 0>
   T extract() {
     T extracted_value{};
+    if (HasContiguousBytes(CustomFieldFixedSizeInterface<T>::length())) {
+      CopyContiguousBytes(extracted_value.data(), CustomFieldFixedSizeInterface<T>::length());
+      return extracted_value;
+    }
     for (size_t i = 0; i < CustomFieldFixedSizeInterface<T>::length(); i++) {
       size_t index = (little_endian ? i : CustomFieldFixedSizeInterface<T>::length() - i - 1);
       extracted_value.data()[index] = this->operator*();
@@ -103,7 +113,28 @@ class Iterator : public IteratorTraits {
   }
 
  private:
-  std::forward_list<View> data_;
+  bool HasContiguousBytes(size_t length) const {
+    return contiguous_data_ != nullptr && index_ >= begin_ && end_ > index_ && end_ - index_ >= length;
+  }
+
+  // Copy the next |length| bytes to |value| in host order, with a single load for the common field sizes
+  void CopyContiguousBytes(uint8_t* value, size_t length) {
+    const uint8_t* bytes = contiguous_data_ + index_;
+    if (little_endian) {
+      std::memcpy(value, bytes, length);
+    } else {
+      for (size_t i = 0; i < length; i++) {
+        value[length - i - 1] = bytes[i];
+      }
+    }
+    index_ += length;
+  }
+
+  // Fragments of the packet when it spans several buffers, shared between copies of the iterator
+  std::shared_ptr<const std::forward_list<View>> fragments_;
+  // Single fragment of the packet when it is contiguous, which most packets are
+  std::optional<View> contiguous_view_;
+  const uint8_t* contiguous_data_ = nullptr;
   size_t index_;
   size_t begin_;
   size_t end_;
@@ -44,6 +44,7 @@ class PacketBuilder : public BasePacketBuilder, protected EndianInserter<little_
   // Serialize the packet to a byte vector.
   std::vector<uint8_t> SerializeToBytes() const {
     std::vector<uint8_t> output;
+    output.reserve(size());
     BitInserter it(output);
     Serialize(it);
     return output;
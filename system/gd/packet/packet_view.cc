@@ -26,7 +26,7 @@ namespace packet {
 template <bool little_endian>
 PacketView<little_endian>::PacketView(const std::forward_list<class View> fragments)
     : fragments_(fragments), length_(0) {
-  for (auto fragment : fragments_) {
+  for (const auto& fragment : fragments_) {
     length_ += fragment.size();
   }
 }
@@ -68,6 +68,13 @@ size_t PacketView<little_endian>::size() const {
   return length_;
 }
 
+template <bool little_endian>
+void PacketView<little_endian>::AppendTo(std::vector<uint8_t>* buffer) const {
+  for (const View& fragment : fragments_) {
+    buffer->insert(buffer->end(), fragment.data(), fragment.data() + fragment.size());
+  }
+}
+
 template <bool little_endian>
 std::forward_list<View> PacketView<little_endian>::GetSubviewList(size_t begin, size_t end) const {
   ASSERT(begin <= end);
@@ -18,6 +18,7 @@
 
 #include <cstdint>
 #include <forward_list>
+#include <vector>
 
 #include "packet/iterator.h"
 #include "packet/view.h"
@@ -47,6 +48,9 @@ class PacketView {
 
   size_t size() const;
 
+  // Append the bytes of the packet to |buffer|, one fragment at a time
+  void AppendTo(std::vector<uint8_t>* buffer) const;
+
   PacketView<true> GetLittleEndianSubview(size_t begin, size_t end) const;
   PacketView<false> GetBigEndianSubview(size_t begin, size_t end) const;
 
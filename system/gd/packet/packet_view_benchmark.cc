@@ -0,0 +1,227 @@
+/*
+ * Copyright 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <forward_list>
+#include <memory>
+#include <new>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "hci/hci_packets.h"
+#include "l2cap/l2cap_packets.h"
+#include "packet/packet_view.h"
+
+using ::benchmark::State;
+
+// Count the allocations made by the benchmarked code
+static std::atomic<size_t> num_allocations{0};
+
+void* operator new(size_t size) {
+  num_allocations.fetch_add(1, std::memory_order_relaxed);
+  void* ptr = std::malloc(size == 0 ? 1 : size);
+  if (ptr == nullptr) {
+    throw std::bad_alloc();
+  }
+  return ptr;
+}
+
+void operator delete(void* ptr) noexcept {
+  std::free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+  std::free(ptr);
+}
+
+namespace bluetooth {
+namespace packet {
+
+namespace {
+
+// HCI traces captured while scanning with a connected LE peer sending notifications
+
+// LE Extended Advertising Report with 31 bytes of advertising data
+const std::vector<uint8_t> kLeExtendedAdvertisingReport = {
+    0x3e, 0x39, 0x0d, 0x01, 0x13, 0x00, 0x01, 0x5a, 0x3c, 0x11, 0x9b, 0x2e, 0x7d, 0x01, 0x00, 0xff, 0x7f,
+    0xc4, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x1f, 0x02, 0x01, 0x1a, 0x0a, 0xff, 0x4c,
+    0x00, 0x10, 0x05, 0x03, 0x1c, 0x2e, 0x7a, 0x44, 0x10, 0x09, 0x42, 0x75, 0x64, 0x73, 0x20, 0x50, 0x72,
+    0x6f, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20};
+
+// Same event with the report repeated |num_reports| times, as sent by controllers batching reports
+std::vector<uint8_t> MakeLeExtendedAdvertisingReports(uint8_t num_reports) {
+  constexpr size_t kHeaderSize = 4;
+  std::vector<uint8_t> bytes(kLeExtendedAdvertisingReport.begin(), kLeExtendedAdvertisingReport.begin() + kHeaderSize);
+  for (uint8_t i = 0; i < num_reports; i++) {
+    bytes.insert(bytes.end(), kLeExtendedAdvertisingReport.begin() + kHeaderSize, kLeExtendedAdvertisingReport.end());
+  }
+  bytes[1] = static_cast<uint8_t>(bytes.size() - 2);
+  bytes[3] = num_reports;
+  return bytes;
+}
+
+// Number Of Completed Packets for two connections
+const std::vector<uint8_t> kNumberOfCompletedPackets = {
+    0x13, 0x09, 0x02, 0x40, 0x00, 0x01, 0x00, 0x41, 0x00, 0x02, 0x00};
+
+// ACL packet carrying an ATT Handle Value Notification on the LE ATT channel
+const std::vector<uint8_t> kAclAttNotification = {
+    0x40, 0x20, 0x1b, 0x00, 0x17, 0x00, 0x04, 0x00, 0x1b, 0x12, 0x00, 0x00, 0x01, 0x02, 0x03, 0x04,
+    0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f, 0x10, 0x11, 0x12, 0x13};
+
+PacketView<kLittleEndian> MakePacketView(const std::vector<uint8_t>& bytes) {
+  return PacketView<kLittleEndian>(std::make_shared<const std::vector<uint8_t>>(bytes));
+}
+
+// Same bytes, split in two fragments as after L2CAP reassembly
+PacketView<kLittleEndian> MakeFragmentedPacketView(const std::vector<uint8_t>& bytes) {
+  size_t half = bytes.size() / 2;
+  auto first = std::make_shared<const std::vector<uint8_t>>(bytes.begin(), bytes.begin() + half);
+  auto second = std::make_shared<const std::vector<uint8_t>>(bytes.begin() + half, bytes.end());
+  return PacketView<kLittleEndian>(
+      std::forward_list<View>{View(first, 0, first->size()), View(second, 0, second->size())});
+}
+
+void ExtractAll(State& state, const PacketView<kLittleEndian>& packet) {
+  for (auto _ : state) {
+    auto it = packet.begin();
+    uint32_t sum = 0;
+    while (it.NumBytesRemaining() >= sizeof(uint32_t)) {
+      sum += it.extract<uint16_t>();
+      sum += it.extract<uint16_t>();
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetBytesProcessed(state.iterations() * packet.size());
+}
+
+void ParseLeExtendedAdvertisingReport(State& state, const PacketView<kLittleEndian>& packet) {
+  for (auto _ : state) {
+    auto report = hci::LeExtendedAdvertisingReportRawView::Create(
+        hci::LeMetaEventView::Create(hci::EventView::Create(packet)));
+    if (!report.IsValid()) {
+      state.SkipWithError("Invalid LE Extended Advertising Report");
+      return;
+    }
+    for (const auto& response : report.GetResponses()) {
+      benchmark::DoNotOptimize(response.address_);
+      benchmark::DoNotOptimize(response.rssi_);
+      benchmark::DoNotOptimize(response.advertising_data_.size());
+    }
+  }
+}
+
+template <typename GetResponses>
+void ParseLeExtendedAdvertisingReports(State& state, GetResponses get_responses) {
+  auto packet = MakePacketView(MakeLeExtendedAdvertisingReports(state.range(0)));
+  size_t allocations = num_allocations.load(std::memory_order_relaxed);
+  for (auto _ : state) {
+    auto report = hci::LeExtendedAdvertisingReportRawView::Create(
+        hci::LeMetaEventView::Create(hci::EventView::Create(packet)));
+    if (!report.IsValid()) {
+      state.SkipWithError("Invalid LE Extended Advertising Report");
+      return;
+    }
+    for (const auto& response : get_responses(report)) {
+      benchmark::DoNotOptimize(response.address_);
+      benchmark::DoNotOptimize(response.rssi_);
+      benchmark::DoNotOptimize(response.advertising_data_.size());
+    }
+  }
+  state.counters["allocations"] = benchmark::Counter(
+      num_allocations.load(std::memory_order_relaxed) - allocations, benchmark::Counter::kAvgIterations);
+}
+
+void ParseAclAttNotification(State& state, const PacketView<kLittleEndian>& packet) {
+  for (auto _ : state) {
+    auto acl = hci::AclView::Create(packet);
+    if (!acl.IsValid()) {
+      state.SkipWithError("Invalid ACL packet");
+      return;
+    }
+    benchmark::DoNotOptimize(acl.GetHandle());
+    auto basic_frame = l2cap::BasicFrameView::Create(acl.GetPayload());
+    if (!basic_frame.IsValid()) {
+      state.SkipWithError("Invalid L2CAP basic frame");
+      return;
+    }
+    benchmark::DoNotOptimize(basic_frame.GetChannelId());
+    auto payload = basic_frame.GetPayload();
+    benchmark::DoNotOptimize(payload.begin().extract<uint8_t>());
+  }
+}
+
+}  // namespace
+
+static void BM_ExtractContiguous(State& state) {
+  ExtractAll(state, MakePacketView(kLeExtendedAdvertisingReport));
+}
+BENCHMARK(BM_ExtractContiguous);
+
+static void BM_ExtractFragmented(State& state) {
+  ExtractAll(state, MakeFragmentedPacketView(kLeExtendedAdvertisingReport));
+}
+BENCHMARK(BM_ExtractFragmented);
+
+static void BM_ParseLeExtendedAdvertisingReport(State& state) {
+  ParseLeExtendedAdvertisingReport(state, MakePacketView(kLeExtendedAdvertisingReport));
+}
+BENCHMARK(BM_ParseLeExtendedAdvertisingReport);
+
+static void BM_GetLeExtendedAdvertisingResponses(State& state) {
+  ParseLeExtendedAdvertisingReports(state, [](hci::LeExtendedAdvertisingReportRawView& report) {
+    return report.GetResponses();
+  });
+}
+BENCHMARK(BM_GetLeExtendedAdvertisingResponses)->Arg(1)->Arg(4);
+
+static void BM_GetLeExtendedAdvertisingResponsesRange(State& state) {
+  ParseLeExtendedAdvertisingReports(state, [](hci::LeExtendedAdvertisingReportRawView& report) {
+    return report.GetResponsesRange();
+  });
+}
+BENCHMARK(BM_GetLeExtendedAdvertisingResponsesRange)->Arg(1)->Arg(4);
+
+static void BM_ParseNumberOfCompletedPackets(State& state) {
+  auto packet = MakePacketView(kNumberOfCompletedPackets);
+  for (auto _ : state) {
+    auto event = hci::NumberOfCompletedPacketsView::Create(hci::EventView::Create(packet));
+    if (!event.IsValid()) {
+      state.SkipWithError("Invalid Number Of Completed Packets");
+      return;
+    }
+    for (const auto& completed_packets : event.GetCompletedPackets()) {
+      benchmark::DoNotOptimize(completed_packets.connection_handle_);
+      benchmark::DoNotOptimize(completed_packets.host_num_of_completed_packets_);
+    }
+  }
+}
+BENCHMARK(BM_ParseNumberOfCompletedPackets);
+
+static void BM_ParseAclAttNotification(State& state) {
+  ParseAclAttNotification(state, MakePacketView(kAclAttNotification));
+}
+BENCHMARK(BM_ParseAclAttNotification);
+
+static void BM_ParseFragmentedAclAttNotification(State& state) {
+  ParseAclAttNotification(state, MakeFragmentedPacketView(kAclAttNotification));
+}
+BENCHMARK(BM_ParseFragmentedAclAttNotification);
+
+}  // namespace packet
+}  // namespace bluetooth
@@ -157,6 +157,13 @@ TEST(IteratorExtractTest, extractBeTest) {
   ASSERT_EQ(0x16, general_case.extract<uint8_t>());
 }
 
+TEST(IteratorEmptyTest, emptyDataTest) {
+  Iterator<true> empty(std::forward_list<View>(), 0);
+  ASSERT_EQ(0u, empty.NumBytesRemaining());
+  ASSERT_TRUE(empty == Iterator<true>(std::forward_list<View>(), 0));
+  ASSERT_DEATH(*empty, "");
+}
+
 TYPED_TEST(IteratorTest, extractBoundsDeathTest) {
   auto bounds_test = this->packet->end();
 
@@ -552,6 +559,37 @@ TEST_F(PacketViewMultiViewTest, arrayOperatorTest) {
   ASSERT_DEATH(multi_view[single_view.size()], "");
 }
 
+TEST_F(PacketViewMultiViewTest, appendToTest) {
+  std::vector<uint8_t> single_bytes{0xff};
+  std::vector<uint8_t> multi_bytes{0xff};
+  single_view.AppendTo(&single_bytes);
+  multi_view.AppendTo(&multi_bytes);
+  ASSERT_EQ(single_bytes.size(), single_view.size() + 1);
+  ASSERT_EQ(single_bytes, multi_bytes);
+  for (size_t i = 0; i < single_view.size(); i++) {
+    ASSERT_EQ(single_bytes[i + 1], single_view[i]);
+  }
+}
+
+TEST_F(PacketViewMultiViewTest, extractTest) {
+  auto single_itr = single_view.begin();
+  auto multi_itr = multi_view.begin();
+  // Fields straddling the fragment boundaries
+  ASSERT_EQ(single_itr.extract<uint16_t>(), multi_itr.extract<uint16_t>());
+  ASSERT_EQ(single_itr.extract<uint32_t>(), multi_itr.extract<uint32_t>());
+  ASSERT_EQ(single_itr.extract<uint64_t>(), multi_itr.extract<uint64_t>());
+  ASSERT_EQ(single_itr.extract<Address>(), multi_itr.extract<Address>());
+  ASSERT_EQ(single_itr.NumBytesRemaining(), multi_itr.NumBytesRemaining());
+}
+
+TEST_F(PacketViewMultiViewTest, extractSubrangeDeathTest) {
+  auto single_itr = single_view.begin().Subrange(4, 3);
+  auto multi_itr = multi_view.begin().Subrange(4, 3);
+  ASSERT_EQ(single_itr.extract<uint16_t>(), multi_itr.extract<uint16_t>());
+  ASSERT_DEATH(single_itr.extract<uint16_t>(), "");
+  ASSERT_DEATH(multi_itr.extract<uint16_t>(), "");
+}
+
 TEST_F(PacketViewMultiViewAppendTest, sizeTestAppend) {
   ASSERT_EQ(single_view.size(), multi_view.size());
 }
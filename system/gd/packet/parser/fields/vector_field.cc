@@ -18,6 +18,7 @@
 
 #include "fields/count_field.h"
 #include "fields/custom_field.h"
+#include "fields/struct_field.h"
 #include "util.h"
 
 const std::string VectorField::kFieldType = "VectorField";
@@ -108,6 +109,10 @@ std::string VectorField::GetDataType() const {
 }
 
 void VectorField::GenExtractor(std::ostream& s, int num_leading_bits, bool for_struct) const {
+  if (for_struct) {
+    // The struct may be reused to parse several elements, keep the capacity but not the previous values
+    s << GetName() << "_ptr->clear();";
+  }
   s << "auto " << element_field_->GetName() << "_it = " << GetName() << "_it;";
   if (size_field_ != nullptr && size_field_->GetFieldType() == CountField::kFieldType) {
     s << "size_t " << element_field_->GetName() << "_count = ";
@@ -163,6 +168,25 @@ void VectorField::GenGetter(std::ostream& s, Size start_offset, Size end_offset)
 
   s << "return " << GetName() << "_value;";
   s << "}\n";
+
+  if (element_field_->GetFieldType() != StructField::kFieldType) {
+    return;
+  }
+  // Range that decodes the structs while iterating, without building a vector
+  s << "auto " << GetGetterFunctionName() << "Range() {";
+  s << "ASSERT(was_validated_);";
+  s << "size_t end_index = size();";
+  s << "auto to_bound = begin();";
+  GenBounds(s, start_offset, end_offset, GetSize());
+  s << "size_t " << element_field_->GetName() << "_count = ";
+  if (size_field_ != nullptr && size_field_->GetFieldType() == CountField::kFieldType) {
+    s << "Get" << util::UnderscoreToCamelCase(size_field_->GetName()) << "();";
+  } else {
+    s << "SIZE_MAX;";
+  }
+  s << "return ::bluetooth::packet::MakeStructRange<" << element_field_->GetDataType() << ">(" << GetName() << "_it, "
+    << element_field_->GetName() << "_count, " << (element_size_.empty() ? 1 : element_size_.bytes()) << ");";
+  s << "}\n";
 }
 
 std::string VectorField::GetBuilderParameterType() const {
@@ -197,6 +221,11 @@ void VectorField::GenParameterValidator(std::ostream&) const {
 }
 
 void VectorField::GenInserter(std::ostream& s) const {
+  if (element_field_->GetFieldType() == ScalarField::kFieldType && element_size_.bits() == 8) {
+    // Byte arrays are copied in one go
+    s << "i.insert_bytes(" << GetName() << "_.data(), " << GetName() << "_.size());";
+    return;
+  }
   s << "for (const auto& val_ : " << GetName() << "_) {";
   element_field_->GenInserter(s);
   s << "}\n";
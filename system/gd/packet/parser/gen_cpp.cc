@@ -93,6 +93,7 @@ bool generate_cpp_headers_one_file(
 #include "packet/packet_builder.h"
 #include "packet/packet_struct.h"
 #include "packet/packet_view.h"
+#include "packet/struct_range.h"
 #include "packet/checksum_type_checker.h"
 #include "packet/custom_type_checker.h"
 #include "os/log.h"
@@ -995,6 +995,22 @@ TEST(GeneratedPacketTest, testVectorOfStruct) {
   }
 }
 
+TEST(GeneratedPacketTest, testVectorOfStructRange) {
+  auto packet_bytes = std::make_shared<std::vector<uint8_t>>(array_or_vector_of_struct);
+  PacketView<kLittleEndian> packet_bytes_view(packet_bytes);
+  auto view = VectorOfStructView::Create(packet_bytes_view);
+  ASSERT_TRUE(view.IsValid());
+  auto array = view.GetArray();
+  size_t i = 0;
+  for (const auto& element : view.GetArrayRange()) {
+    ASSERT_LT(i, array.size());
+    ASSERT_EQ(array[i].id_, element.id_);
+    ASSERT_EQ(array[i].count_, element.count_);
+    i++;
+  }
+  ASSERT_EQ(array.size(), i);
+}
+
 TEST(GeneratedPacketTest, testArrayOfStruct) {
   std::array<TwoRelatedNumbers, 4> count_array;
   for (uint8_t i = 1; i < 5; i++) {
@@ -1762,6 +1778,27 @@ TEST(GeneratedPacketTest, testOneLengthTypeValueStruct) {
   }
 }
 
+TEST(GeneratedPacketTest, testOneLengthTypeValueStructRange) {
+  // Elements of different sizes are decoded into the same struct
+  std::vector<uint8_t> truncated(one_length_type_value_struct);
+  truncated.pop_back();
+  for (const auto& bytes : {one_length_type_value_struct, truncated}) {
+    auto packet_bytes = std::make_shared<std::vector<uint8_t>>(bytes);
+    PacketView<kLittleEndian> packet_bytes_view(packet_bytes);
+    auto view = OneLengthTypeValueStructView::Create(packet_bytes_view);
+    ASSERT_TRUE(view.IsValid());
+    auto one = view.GetOneArray();
+    size_t i = 0;
+    for (const auto& entry : view.GetOneArrayRange()) {
+      ASSERT_LT(i, one.size());
+      ASSERT_EQ(one[i].type_, entry.type_);
+      ASSERT_EQ(one[i].value_, entry.value_);
+      i++;
+    }
+    ASSERT_EQ(one.size(), i);
+  }
+}
+
 vector<uint8_t> one_length_type_value_struct_padded_10{
     0x20,                                                        // _size_(payload),
     0x14,                                                        // valid bytes
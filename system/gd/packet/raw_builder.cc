@@ -44,7 +44,7 @@ bool RawBuilder::AddOctets(const std::vector<uint8_t>& bytes) {
 }
 
 bool RawBuilder::AddOctets(size_t octets, uint64_t value) {
-  std::vector<uint8_t> val_vector;
+  uint8_t bytes[sizeof(uint64_t)];
 
   uint64_t v = value;
 
@@ -52,14 +52,22 @@ bool RawBuilder::AddOctets(size_t octets, uint64_t value) {
     return false;
   }
   for (size_t i = 0; i < octets; i++) {
-    val_vector.push_back(v & 0xff);
+    bytes[i] = v & 0xff;
     v = v >> 8;
   }
 
   if (v != 0) {
     return false;
   }
-  return AddOctets(octets, val_vector);
+  return AddOctets(bytes, octets);
+}
+
+bool RawBuilder::AddOctets(const uint8_t* bytes, size_t length) {
+  if (payload_.size() + length > max_bytes_) {
+    return false;
+  }
+  payload_.insert(payload_.end(), bytes, bytes + length);
+  return true;
 }
 
 bool RawBuilder::AddOctets1(uint8_t value) {
@@ -91,9 +99,7 @@ bool RawBuilder::CanAddOctets(size_t num_bytes) const {
 }
 
 void RawBuilder::Serialize(BitInserter& it) const {
-  for (const auto& val : payload_) {
-    insert(val, it);
-  }
+  it.insert_bytes(payload_.data(), payload_.size());
 }
 
 size_t RawBuilder::size() const {
@@ -59,6 +59,10 @@ class RawBuilder : public PacketBuilder<true> {
 
   bool AddOctets(const std::vector<uint8_t>& bytes);
 
+  // Add |length| bytes from |bytes| to the payload.  Return true if:
+  // - the new size of the payload is still <= |max_bytes_|
+  bool AddOctets(const uint8_t* bytes, size_t length);
+
   bool AddOctets1(uint8_t value);
   bool AddOctets2(uint16_t value);
   bool AddOctets3(uint32_t value);
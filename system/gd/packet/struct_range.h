@@ -0,0 +1,123 @@
+/*
+ * Copyright 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+
+#include "packet/iterator.h"
+
+namespace bluetooth {
+namespace packet {
+
+// Forward range over the elements of a repeated struct field, decoded one at a time while iterating.
+//
+// Unlike the std::vector returned by the regular getter, a single element is kept alive: it is overwritten when the
+// iterator is incremented, so that containers inside of it keep their capacity from one element to the next.
+template <typename T, bool little_endian>
+class StructRange {
+ public:
+  static constexpr size_t kNoCount = SIZE_MAX;
+
+  // |min_element_size| is the number of bytes that must remain for another element to be decoded
+  StructRange(Iterator<little_endian> it, size_t count, size_t min_element_size)
+      : it_(it), count_(count), min_element_size_(min_element_size) {}
+
+  class const_iterator {
+   public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = T;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const T*;
+    using reference = const T&;
+
+    const T& operator*() const {
+      return element_;
+    }
+    const T* operator->() const {
+      return &element_;
+    }
+
+    const_iterator& operator++() {
+      Next();
+      return *this;
+    }
+
+    bool operator==(const const_iterator& other) const {
+      return done_ == other.done_ && (done_ || it_ == other.it_);
+    }
+    bool operator!=(const const_iterator& other) const {
+      return !(*this == other);
+    }
+
+   private:
+    friend class StructRange;
+
+    // The end iterator, cheap to create: an Iterator over no data doesn't allocate
+    const_iterator() : it_(std::forward_list<View>(), 0), count_(0), min_element_size_(0), done_(true) {}
+
+    const_iterator(Iterator<little_endian> it, size_t count, size_t min_element_size)
+        : it_(it), count_(count), min_element_size_(min_element_size) {
+      Next();
+    }
+
+    void Next() {
+      if (count_ == 0 || it_.NumBytesRemaining() < min_element_size_) {
+        done_ = true;
+        return;
+      }
+      if (count_ != kNoCount) {
+        count_--;
+      }
+      size_t remaining = it_.NumBytesRemaining();
+      auto next = T::Parse(&element_, it_);
+      if (remaining - next.NumBytesRemaining() != element_.size()) {
+        // Truncated element, the fields that were not reached must have their default value like with a new element
+        element_ = T();
+        next = T::Parse(&element_, it_);
+      }
+      it_ = next;
+    }
+
+    Iterator<little_endian> it_;
+    size_t count_;
+    size_t min_element_size_;
+    bool done_{false};
+    T element_;
+  };
+
+  const_iterator begin() const {
+    return const_iterator(it_, count_, min_element_size_);
+  }
+  const_iterator end() const {
+    return const_iterator();
+  }
+
+ private:
+  Iterator<little_endian> it_;
+  size_t count_;
+  size_t min_element_size_;
+};
+
+template <typename T, bool little_endian>
+StructRange<T, little_endian> MakeStructRange(Iterator<little_endian> it, size_t count, size_t min_element_size) {
+  return StructRange<T, little_endian>(it, count, min_element_size);
+}
+
+}  // namespace packet
+}  // namespace bluetooth
@@ -16,8 +16,7 @@
 
 #include "storage/config_cache.h"
 
-#include <ios>
-#include <sstream>
+#include <algorithm>
 #include <utility>
 
 #include "hci/enum_helper.h"
@@ -65,16 +64,36 @@ ConfigCache::ConfigCache(size_t temp_device_capacity, std::unordered_set<std::st
       temporary_devices_(temp_device_capacity) {}
 
 void ConfigCache::SetPersistentConfigChangedCallback(std::function<void()> persistent_config_changed_callback) {
-  std::lock_guard<std::recursive_mutex> lock(mutex_);
+  std::unique_lock<std::shared_mutex> lock(mutex_);
   persistent_config_changed_callback_ = std::move(persistent_config_changed_callback);
 }
 
+void ConfigCache::EnableChangeRecording() {
+  std::unique_lock<std::shared_mutex> lock(mutex_);
+  is_recording_changes_ = true;
+}
+
+std::optional<std::vector<ConfigCache::Change>> ConfigCache::TakeRecordedChanges() {
+  std::unique_lock<std::shared_mutex> lock(mutex_);
+  std::vector<Change> changes;
+  changes.swap(recorded_changes_);
+  if (has_unrecorded_changes_) {
+    has_unrecorded_changes_ = false;
+    return std::nullopt;
+  }
+  return changes;
+}
+
 ConfigCache::ConfigCache(ConfigCache&& other) noexcept
     : persistent_config_changed_callback_(nullptr),
       persistent_property_names_(std::move(other.persistent_property_names_)),
+      property_names_(std::move(other.property_names_)),
       information_sections_(std::move(other.information_sections_)),
       persistent_devices_(std::move(other.persistent_devices_)),
-      temporary_devices_(std::move(other.temporary_devices_)) {
+      temporary_devices_(std::move(other.temporary_devices_)),
+      is_recording_changes_(other.is_recording_changes_),
+      has_unrecorded_changes_(other.has_unrecorded_changes_),
+      recorded_changes_(std::move(other.recorded_changes_)) {
   ASSERT_LOG(
       other.persistent_config_changed_callback_ == nullptr,
       "Can't assign after setting the callback");
@@ -84,25 +103,62 @@ ConfigCache& ConfigCache::operator=(ConfigCache&& other) noexcept {
   if (&other == this) {
     return *this;
   }
-  std::lock_guard<std::recursive_mutex> my_lock(mutex_);
-  std::lock_guard<std::recursive_mutex> others_lock(other.mutex_);
+  std::unique_lock<std::shared_mutex> my_lock(mutex_);
+  std::unique_lock<std::shared_mutex> others_lock(other.mutex_);
   ASSERT_LOG(
       other.persistent_config_changed_callback_ == nullptr,
       "Can't assign after setting the callback");
   persistent_config_changed_callback_ = {};
   persistent_property_names_ = std::move(other.persistent_property_names_);
+  property_names_ = std::move(other.property_names_);
   information_sections_ = std::move(other.information_sections_);
   persistent_devices_ = std::move(other.persistent_devices_);
   temporary_devices_ = std::move(other.temporary_devices_);
+  is_recording_changes_ = other.is_recording_changes_;
+  has_unrecorded_changes_ = other.has_unrecorded_changes_;
+  recorded_changes_ = std::move(other.recorded_changes_);
   return *this;
 }
 
+bool ConfigCache::SectionsEqual(const FlatSection& lhs, const ConfigCache& rhs_cache, const FlatSection& rhs) const {
+  // property ids are specific to each config cache, hence properties are compared by name
+  if (lhs.size() != rhs.size()) {
+    return false;
+  }
+  std::vector<std::pair<const std::string*, std::string_view>> lhs_properties;
+  lhs_properties.reserve(lhs.size());
+  lhs.ForEach([&](PropertyId id, std::string_view value) {
+    lhs_properties.emplace_back(&property_names_.Name(id), value);
+  });
+  size_t index = 0;
+  bool equal = true;
+  rhs.ForEach([&](PropertyId id, std::string_view value) {
+    equal = equal && *lhs_properties[index].first == rhs_cache.property_names_.Name(id) &&
+            lhs_properties[index].second == value;
+    index++;
+  });
+  return equal;
+}
+
 bool ConfigCache::operator==(const ConfigCache& rhs) const {
-  std::lock_guard<std::recursive_mutex> my_lock(mutex_);
-  std::lock_guard<std::recursive_mutex> others_lock(rhs.mutex_);
+  std::shared_lock<std::shared_mutex> my_lock(mutex_);
+  std::shared_lock<std::shared_mutex> others_lock(rhs.mutex_);
+  auto sections_equal = [this, &rhs](const auto& lhs_sections, const auto& rhs_sections) {
+    return lhs_sections.size() == rhs_sections.size() &&
+           std::equal(
+               lhs_sections.begin(),
+               lhs_sections.end(),
+               rhs_sections.begin(),
+               [this, &rhs](const auto& lhs_section, const auto& rhs_section) {
+                 return lhs_section.first == rhs_section.first &&
+                        SectionsEqual(lhs_section.second, rhs, rhs_section.second);
+               });
+  };
   return persistent_property_names_ == rhs.persistent_property_names_ &&
-         information_sections_ == rhs.information_sections_ && persistent_devices_ == rhs.persistent_devices_ &&
-         temporary_devices_ == rhs.temporary_devices_;
+         sections_equal(information_sections_, rhs.information_sections_) &&
+         sections_equal(persistent_devices_, rhs.persistent_devices_) &&
+         temporary_devices_.capacity() == rhs.temporary_devices_.capacity() &&
+         sections_equal(temporary_devices_, rhs.temporary_devices_);
 }
 
 bool ConfigCache::operator!=(const ConfigCache& rhs) const {
@@ -110,13 +166,15 @@ bool ConfigCache::operator!=(const ConfigCache& rhs) const {
 }
 
 void ConfigCache::Clear() {
-  std::lock_guard<std::recursive_mutex> lock(mutex_);
+  std::unique_lock<std::shared_mutex> lock(mutex_);
   if (information_sections_.size() > 0) {
     information_sections_.clear();
+    RecordUnrecordableChange();
     PersistentConfigChangedCallback();
   }
   if (persistent_devices_.size() > 0) {
     persistent_devices_.clear();
+    RecordUnrecordableChange();
     PersistentConfigChangedCallback();
   }
   if (temporary_devices_.size() > 0) {
@@ -124,83 +182,155 @@ void ConfigCache::Clear() {
   }
 }
 
-bool ConfigCache::HasSection(const std::string& section) const {
-  std::lock_guard<std::recursive_mutex> lock(mutex_);
-  return information_sections_.contains(section) || persistent_devices_.contains(section) ||
-         temporary_devices_.contains(section);
+std::optional<ConfigCache::DeviceKey> ConfigCache::ToDeviceKey(const std::string& section) {
+  // XX:XX:XX:XX:XX:XX
+  if (section.size() != 17) {
+    return std::nullopt;
+  }
+  DeviceKey address = 0;
+  DeviceKey upper_case_digits = 0;
+  int digit = 0;
+  for (size_t i = 0; i < section.size(); i++) {
+    char c = section[i];
+    if (i % 3 == 2) {
+      if (c != ':') {
+        return std::nullopt;
+      }
+      continue;
+    }
+    DeviceKey value;
+    if (c >= '0' && c <= '9') {
+      value = c - '0';
+    } else if (c >= 'a' && c <= 'f') {
+      value = c - 'a' + 10;
+    } else if (c >= 'A' && c <= 'F') {
+      value = c - 'A' + 10;
+      upper_case_digits |= DeviceKey{1} << digit;
+    } else {
+      return std::nullopt;
+    }
+    address = (address << 4) | value;
+    digit++;
+  }
+  return address | (upper_case_digits << 48);
 }
 
-bool ConfigCache::HasProperty(const std::string& section, const std::string& property) const {
-  std::lock_guard<std::recursive_mutex> lock(mutex_);
-  auto section_iter = information_sections_.find(section);
-  if (section_iter != information_sections_.end()) {
-    return section_iter->second.find(property) != section_iter->second.end();
-  }
-  section_iter = persistent_devices_.find(section);
-  if (section_iter != persistent_devices_.end()) {
-    return section_iter->second.find(property) != section_iter->second.end();
+std::string ConfigCache::ToSectionName(DeviceKey key) {
+  std::string section(17, ':');
+  for (int digit = 0; digit < 12; digit++) {
+    int value = (key >> (44 - 4 * digit)) & 0xf;
+    bool is_upper_case = (key >> (48 + digit)) & 1;
+    char c = value < 10 ? '0' + value : (is_upper_case ? 'A' : 'a') + value - 10;
+    section[digit / 2 * 3 + digit % 2] = c;
   }
-  section_iter = temporary_devices_.find(section);
-  if (section_iter != temporary_devices_.end()) {
-    return section_iter->second.find(property) != section_iter->second.end();
+  return section;
+}
+
+const FlatSection* ConfigCache::FindPersistentSectionLocked(
+    const std::string& section, std::optional<DeviceKey> key) const {
+  if (!key) {
+    auto section_iter = information_sections_.find(section);
+    return section_iter != information_sections_.end() ? &section_iter->second : nullptr;
   }
-  return false;
+  auto section_iter = persistent_devices_.find(*key);
+  return section_iter != persistent_devices_.end() ? &section_iter->second : nullptr;
 }
 
-std::optional<std::string> ConfigCache::GetProperty(const std::string& section, const std::string& property) const {
-  std::lock_guard<std::recursive_mutex> lock(mutex_);
-  auto section_iter = information_sections_.find(section);
-  if (section_iter != information_sections_.end()) {
-    auto property_iter = section_iter->second.find(property);
-    if (property_iter != section_iter->second.end()) {
-      return property_iter->second;
+template <typename Observer>
+auto ConfigCache::ObserveSection(const std::string& section, Observer observer) const {
+  auto key = ToDeviceKey(section);
+  {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    const FlatSection* properties = FindPersistentSectionLocked(section, key);
+    if (properties != nullptr || !key) {
+      return observer(properties, key.has_value());
     }
   }
-  section_iter = persistent_devices_.find(section);
-  if (section_iter != persistent_devices_.end()) {
-    auto property_iter = section_iter->second.find(property);
-    if (property_iter != section_iter->second.end()) {
-      std::string value = property_iter->second;
-      if (os::ParameterProvider::GetBtKeystoreInterface() != nullptr && value == kEncryptedStr) {
-        return os::ParameterProvider::GetBtKeystoreInterface()->get_key(section + "-" + property);
-      }
-      return value;
-    }
+  // finding a temporary device moves it in the LRU order, which requires the exclusive lock. The device might also
+  // have become persistent in between
+  std::unique_lock<std::shared_mutex> lock(mutex_);
+  const FlatSection* properties = FindPersistentSectionLocked(section, key);
+  if (properties != nullptr) {
+    return observer(properties, true);
   }
-  section_iter = temporary_devices_.find(section);
-  if (section_iter != temporary_devices_.end()) {
-    auto property_iter = section_iter->second.find(property);
-    if (property_iter != section_iter->second.end()) {
-      return property_iter->second;
-    }
+  auto section_iter = temporary_devices_.find(*key);
+  return observer(section_iter != temporary_devices_.end() ? &section_iter->second : nullptr, false);
+}
+
+std::optional<std::string_view> ConfigCache::GetValueLocked(
+    const FlatSection& properties, const std::string& property) const {
+  auto id = property_names_.Find(property);
+  if (!id) {
+    return std::nullopt;
   }
-  return std::nullopt;
+  return properties.Get(*id);
+}
+
+bool ConfigCache::HasSection(const std::string& section) const {
+  return ObserveSection(section, [](const FlatSection* properties, bool) { return properties != nullptr; });
+}
+
+bool ConfigCache::HasProperty(const std::string& section, const std::string& property) const {
+  return ObserveSection(section, [this, &property](const FlatSection* properties, bool) {
+    return properties != nullptr && GetValueLocked(*properties, property).has_value();
+  });
+}
+
+std::optional<std::string> ConfigCache::GetProperty(const std::string& section, const std::string& property) const {
+  return ObserveSection(
+      section,
+      [this, &section, &property](
+          const FlatSection* properties, bool is_persistent_device) -> std::optional<std::string> {
+        if (properties == nullptr) {
+          return std::nullopt;
+        }
+        auto value = GetValueLocked(*properties, property);
+        if (!value) {
+          return std::nullopt;
+        }
+        if (is_persistent_device && os::ParameterProvider::GetBtKeystoreInterface() != nullptr &&
+            *value == kEncryptedStr) {
+          return os::ParameterProvider::GetBtKeystoreInterface()->get_key(section + "-" + property);
+        }
+        return std::string(*value);
+      });
 }
 
 void ConfigCache::SetProperty(std::string section, std::string property, std::string value) {
-  std::lock_guard<std::recursive_mutex> lock(mutex_);
+  std::unique_lock<std::shared_mutex> lock(mutex_);
+  SetPropertyLocked(std::move(section), std::move(property), std::move(value));
+}
+
+void ConfigCache::SetPropertyLocked(std::string section, std::string property, std::string value) {
   TrimAfterNewLine(section);
   TrimAfterNewLine(property);
   TrimAfterNewLine(value);
   ASSERT_LOG(!section.empty(), "Empty section name not allowed");
   ASSERT_LOG(!property.empty(), "Empty property name not allowed");
-  if (!IsDeviceSection(section)) {
+  PropertyId id = property_names_.Intern(property);
+  auto key = ToDeviceKey(section);
+  if (!key) {
     auto section_iter = information_sections_.find(section);
     if (section_iter == information_sections_.end()) {
-      section_iter = information_sections_.try_emplace_back(section, common::ListMap<std::string, std::string>{}).first;
+      section_iter = information_sections_.try_emplace_back(section, FlatSection{}).first;
     }
-    section_iter->second.insert_or_assign(property, std::move(value));
+    RecordChange(MutationEntry::EntryType::SET, section, property, value);
+    section_iter->second.Set(id, value);
     PersistentConfigChangedCallback();
     return;
   }
-  auto section_iter = persistent_devices_.find(section);
+  auto section_iter = persistent_devices_.find(*key);
   if (section_iter == persistent_devices_.end() && IsPersistentProperty(property)) {
     // move paired devices or create new paired device when a link key is set
-    auto section_properties = temporary_devices_.extract(section);
+    auto section_properties = temporary_devices_.extract(*key);
     if (section_properties) {
-      section_iter = persistent_devices_.try_emplace_back(section, std::move(section_properties->second)).first;
+      // properties of the temporary device are written to disk from now on
+      section_properties->second.ForEach([&](PropertyId property_id, std::string_view property_value) {
+        RecordChange(MutationEntry::EntryType::SET, section, property_names_.Name(property_id), property_value);
+      });
+      section_iter = persistent_devices_.try_emplace_back(*key, std::move(section_properties->second)).first;
     } else {
-      section_iter = persistent_devices_.try_emplace_back(section, common::ListMap<std::string, std::string>{}).first;
+      section_iter = persistent_devices_.try_emplace_back(*key, FlatSection{}).first;
     }
   }
   if (section_iter != persistent_devices_.end()) {
@@ -212,57 +342,81 @@ void ConfigCache::SetProperty(std::string section, std::string property, std::st
         value = kEncryptedStr;
       }
     }
-    section_iter->second.insert_or_assign(property, std::move(value));
+    RecordChange(MutationEntry::EntryType::SET, section, property, value);
+    section_iter->second.Set(id, value);
     PersistentConfigChangedCallback();
     return;
   }
-  section_iter = temporary_devices_.find(section);
-  if (section_iter == temporary_devices_.end()) {
-    auto triple = temporary_devices_.try_emplace(section, common::ListMap<std::string, std::string>{});
-    section_iter = std::get<0>(triple);
+  auto temp_section_iter = temporary_devices_.find(*key);
+  if (temp_section_iter == temporary_devices_.end()) {
+    auto triple = temporary_devices_.try_emplace(*key, FlatSection{});
+    temp_section_iter = std::get<0>(triple);
   }
-  section_iter->second.insert_or_assign(property, std::move(value));
+  temp_section_iter->second.Set(id, value);
 }
 
 bool ConfigCache::RemoveSection(const std::string& section) {
-  std::lock_guard<std::recursive_mutex> lock(mutex_);
+  std::unique_lock<std::shared_mutex> lock(mutex_);
+  return RemoveSectionLocked(section);
+}
+
+bool ConfigCache::RemoveSectionLocked(const std::string& section) {
   // sections are unique among all three maps, hence removing from one of them is enough
-  if (information_sections_.extract(section) || persistent_devices_.extract(section)) {
-    PersistentConfigChangedCallback();
-    return true;
-  } else {
-    return temporary_devices_.extract(section).has_value();
+  auto key = ToDeviceKey(section);
+  if (!key) {
+    if (!information_sections_.extract(section)) {
+      return false;
+    }
+  } else if (!persistent_devices_.extract(*key)) {
+    return temporary_devices_.extract(*key).has_value();
   }
+  RecordChange(MutationEntry::EntryType::REMOVE_SECTION, section);
+  PersistentConfigChangedCallback();
+  return true;
 }
 
 bool ConfigCache::RemoveProperty(const std::string& section, const std::string& property) {
-  std::lock_guard<std::recursive_mutex> lock(mutex_);
-  auto section_iter = information_sections_.find(section);
-  if (section_iter != information_sections_.end()) {
-    auto value = section_iter->second.extract(property);
+  std::unique_lock<std::shared_mutex> lock(mutex_);
+  return RemovePropertyLocked(section, property);
+}
+
+bool ConfigCache::RemovePropertyLocked(const std::string& section, const std::string& property) {
+  auto id = property_names_.Find(property);
+  auto extract_property = [&id](FlatSection& properties) -> std::optional<std::string> {
+    return id ? properties.Extract(*id) : std::nullopt;
+  };
+  auto key = ToDeviceKey(section);
+  if (!key) {
+    auto section_iter = information_sections_.find(section);
+    if (section_iter == information_sections_.end()) {
+      return false;
+    }
+    auto value = extract_property(section_iter->second);
     // if section is empty after removal, remove the whole section as empty section is not allowed
-    if (section_iter->second.size() == 0) {
+    if (section_iter->second.empty()) {
       information_sections_.erase(section_iter);
     }
     if (value.has_value()) {
+      RecordChange(MutationEntry::EntryType::REMOVE_PROPERTY, section, property);
       PersistentConfigChangedCallback();
       return true;
     } else {
       return false;
     }
   }
-  section_iter = persistent_devices_.find(section);
+  auto section_iter = persistent_devices_.find(*key);
   if (section_iter != persistent_devices_.end()) {
-    auto value = section_iter->second.extract(property);
+    auto value = extract_property(section_iter->second);
     // if section is empty after removal, remove the whole section as empty section is not allowed
-    if (section_iter->second.size() == 0) {
+    if (section_iter->second.empty()) {
       persistent_devices_.erase(section_iter);
     } else if (value && IsPersistentProperty(property)) {
       // move unpaired device
-      auto section_properties = persistent_devices_.extract(section);
-      temporary_devices_.insert_or_assign(section, std::move(section_properties->second));
+      auto section_properties = persistent_devices_.extract(*key);
+      temporary_devices_.insert_or_assign(*key, std::move(section_properties->second));
     }
     if (value.has_value()) {
+      RecordChange(MutationEntry::EntryType::REMOVE_PROPERTY, section, property);
       PersistentConfigChangedCallback();
       if (os::ParameterProvider::GetBtKeystoreInterface() != nullptr && os::ParameterProvider::IsCommonCriteriaMode() &&
           InEncryptKeyNameList(property)) {
@@ -273,11 +427,11 @@ bool ConfigCache::RemoveProperty(const std::string& section, const std::string&
       return false;
     }
   }
-  section_iter = temporary_devices_.find(section);
-  if (section_iter != temporary_devices_.end()) {
-    auto value = section_iter->second.extract(property);
-    if (section_iter->second.size() == 0) {
-      temporary_devices_.erase(section_iter);
+  auto temp_section_iter = temporary_devices_.find(*key);
+  if (temp_section_iter != temporary_devices_.end()) {
+    auto value = extract_property(temp_section_iter->second);
+    if (temp_section_iter->second.empty()) {
+      temporary_devices_.erase(temp_section_iter);
     }
     return value.has_value();
   }
@@ -285,27 +439,29 @@ bool ConfigCache::RemoveProperty(const std::string& section, const std::string&
 }
 
 void ConfigCache::ConvertEncryptOrDecryptKeyIfNeeded() {
-  std::lock_guard<std::recursive_mutex> lock(mutex_);
+  std::unique_lock<std::shared_mutex> lock(mutex_);
   LOG_INFO("%s", __func__);
-  auto persistent_sections = GetPersistentSections();
+  auto persistent_sections = GetPersistentSectionsLocked();
   for (const auto& section : persistent_sections) {
-    auto section_iter = persistent_devices_.find(section);
+    auto section_iter = persistent_devices_.find(*ToDeviceKey(section));
     for (const auto& property : kEncryptKeyNameList) {
-      auto property_iter = section_iter->second.find(std::string(property));
-      if (property_iter != section_iter->second.end()) {
-        bool is_encrypted = property_iter->second == kEncryptedStr;
-        if ((!property_iter->second.empty()) && os::ParameterProvider::GetBtKeystoreInterface() != nullptr &&
+      auto value = GetValueLocked(section_iter->second, std::string(property));
+      if (value) {
+        // copied as setting the property below invalidates the view
+        std::string value_str(*value);
+        bool is_encrypted = value_str == kEncryptedStr;
+        if ((!value_str.empty()) && os::ParameterProvider::GetBtKeystoreInterface() != nullptr &&
             os::ParameterProvider::IsCommonCriteriaMode() && !is_encrypted) {
           if (os::ParameterProvider::GetBtKeystoreInterface()->set_encrypt_key_or_remove_key(
-                  section + "-" + std::string(property), property_iter->second)) {
-            SetProperty(section, std::string(property), kEncryptedStr);
+                  section + "-" + std::string(property), value_str)) {
+            SetPropertyLocked(section, std::string(property), kEncryptedStr);
           }
         }
         if (os::ParameterProvider::GetBtKeystoreInterface() != nullptr && is_encrypted) {
-          std::string value_str =
+          std::string decrypted_value_str =
               os::ParameterProvider::GetBtKeystoreInterface()->get_key(section + "-" + std::string(property));
           if (!os::ParameterProvider::IsCommonCriteriaMode()) {
-            SetProperty(section, std::string(property), value_str);
+            SetPropertyLocked(section, std::string(property), decrypted_value_str);
           }
         }
       }
@@ -314,7 +470,7 @@ void ConfigCache::ConvertEncryptOrDecryptKeyIfNeeded() {
 }
 
 bool ConfigCache::IsDeviceSection(const std::string& section) {
-  return hci::Address::IsValidAddress(section);
+  return ToDeviceKey(section).has_value();
 }
 
 bool ConfigCache::IsPersistentProperty(const std::string& property) const {
@@ -322,22 +478,37 @@ bool ConfigCache::IsPersistentProperty(const std::string& property) const {
 }
 
 void ConfigCache::RemoveSectionWithProperty(const std::string& property) {
-  std::lock_guard<std::recursive_mutex> lock(mutex_);
+  std::unique_lock<std::shared_mutex> lock(mutex_);
+  auto id = property_names_.Find(property);
+  if (!id) {
+    return;
+  }
   size_t num_persistent_removed = 0;
-  for (auto* config_section : {&information_sections_, &persistent_devices_}) {
-    for (auto it = config_section->begin(); it != config_section->end();) {
-      if (it->second.contains(property)) {
-        LOG_INFO("Removing persistent section %s with property %s", it->first.c_str(), property.c_str());
-        it = config_section->erase(it);
-        num_persistent_removed++;
-        continue;
-      }
-      it++;
+  for (auto it = information_sections_.begin(); it != information_sections_.end();) {
+    if (it->second.Contains(*id)) {
+      LOG_INFO("Removing persistent section %s with property %s", it->first.c_str(), property.c_str());
+      RecordChange(MutationEntry::EntryType::REMOVE_SECTION, it->first);
+      it = information_sections_.erase(it);
+      num_persistent_removed++;
+      continue;
+    }
+    it++;
+  }
+  for (auto it = persistent_devices_.begin(); it != persistent_devices_.end();) {
+    if (it->second.Contains(*id)) {
+      auto section = ToSectionName(it->first);
+      LOG_INFO("Removing persistent section %s with property %s", section.c_str(), property.c_str());
+      RecordChange(MutationEntry::EntryType::REMOVE_SECTION, section);
+      it = persistent_devices_.erase(it);
+      num_persistent_removed++;
+      continue;
     }
+    it++;
   }
   for (auto it = temporary_devices_.begin(); it != temporary_devices_.end();) {
-    if (it->second.contains(property)) {
-      LOG_INFO("Removing temporary section %s with property %s", it->first.c_str(), property.c_str());
+    if (it->second.Contains(*id)) {
+      LOG_INFO(
+          "Removing temporary section %s with property %s", ToSectionName(it->first).c_str(), property.c_str());
       it = temporary_devices_.erase(it);
       continue;
     }
@@ -349,29 +520,33 @@ void ConfigCache::RemoveSectionWithProperty(const std::string& property) {
 }
 
 std::vector<std::string> ConfigCache::GetPersistentSections() const {
-  std::lock_guard<std::recursive_mutex> lock(mutex_);
+  std::shared_lock<std::shared_mutex> lock(mutex_);
+  return GetPersistentSectionsLocked();
+}
+
+std::vector<std::string> ConfigCache::GetPersistentSectionsLocked() const {
   std::vector<std::string> paired_devices;
   paired_devices.reserve(persistent_devices_.size());
   for (const auto& elem : persistent_devices_) {
-    paired_devices.emplace_back(elem.first);
+    paired_devices.emplace_back(ToSectionName(elem.first));
   }
   return paired_devices;
 }
 
 void ConfigCache::Commit(std::queue<MutationEntry>& mutation_entries) {
-  std::lock_guard<std::recursive_mutex> lock(mutex_);
+  std::unique_lock<std::shared_mutex> lock(mutex_);
   while (!mutation_entries.empty()) {
     auto entry = std::move(mutation_entries.front());
     mutation_entries.pop();
     switch (entry.entry_type) {
       case MutationEntry::EntryType::SET:
-        SetProperty(std::move(entry.section), std::move(entry.property), std::move(entry.value));
+        SetPropertyLocked(std::move(entry.section), std::move(entry.property), std::move(entry.value));
         break;
       case MutationEntry::EntryType::REMOVE_PROPERTY:
-        RemoveProperty(entry.section, entry.property);
+        RemovePropertyLocked(entry.section, entry.property);
         break;
       case MutationEntry::EntryType::REMOVE_SECTION:
-        RemoveSection(entry.section);
+        RemoveSectionLocked(entry.section);
         break;
         // do not write a default case so that when a new enum is defined, compilation would fail automatically
     }
@@ -379,38 +554,48 @@ void ConfigCache::Commit(std::queue<MutationEntry>& mutation_entries) {
 }
 
 std::string ConfigCache::SerializeToLegacyFormat() const {
-  std::lock_guard<std::recursive_mutex> lock(mutex_);
-  std::stringstream serialized;
-  for (const auto* config_section : {&information_sections_, &persistent_devices_}) {
-    for (const auto& section : *config_section) {
-      serialized << "[" << section.first << "]" << std::endl;
-      for (const auto& property : section.second) {
-        serialized << property.first << " = " << property.second << std::endl;
-      }
-      serialized << std::endl;
-    }
-  }
-  return serialized.str();
+  std::shared_lock<std::shared_mutex> lock(mutex_);
+  std::string serialized;
+  auto serialize_section = [this, &serialized](const std::string& section, const FlatSection& properties) {
+    serialized.append("[").append(section).append("]\n");
+    properties.ForEach([this, &serialized](PropertyId id, std::string_view value) {
+      serialized.append(property_names_.Name(id)).append(" = ").append(value).append("\n");
+    });
+    serialized.append("\n");
+  };
+  for (const auto& section : information_sections_) {
+    serialize_section(section.first, section.second);
+  }
+  for (const auto& section : persistent_devices_) {
+    serialize_section(ToSectionName(section.first), section.second);
+  }
+  return serialized;
 }
 
 std::vector<ConfigCache::SectionAndPropertyValue> ConfigCache::GetSectionNamesWithProperty(
     const std::string& property) const {
-  std::lock_guard<std::recursive_mutex> lock(mutex_);
+  std::shared_lock<std::shared_mutex> lock(mutex_);
   std::vector<SectionAndPropertyValue> result;
-  for (auto* config_section : {&information_sections_, &persistent_devices_}) {
-    for (const auto& elem : *config_section) {
-      auto it = elem.second.find(property);
-      if (it != elem.second.end()) {
-        result.emplace_back(SectionAndPropertyValue{.section = elem.first, .property = it->second});
-        continue;
-      }
+  auto id = property_names_.Find(property);
+  if (!id) {
+    return result;
+  }
+  for (const auto& elem : information_sections_) {
+    auto value = elem.second.Get(*id);
+    if (value) {
+      result.emplace_back(SectionAndPropertyValue{.section = elem.first, .property = std::string(*value)});
+    }
+  }
+  for (const auto& elem : persistent_devices_) {
+    auto value = elem.second.Get(*id);
+    if (value) {
+      result.emplace_back(SectionAndPropertyValue{.section = ToSectionName(elem.first), .property = std::string(*value)});
     }
   }
   for (const auto& elem : temporary_devices_) {
-    auto it = elem.second.find(property);
-    if (it != elem.second.end()) {
-      result.emplace_back(SectionAndPropertyValue{.section = elem.first, .property = it->second});
-      continue;
+    auto value = elem.second.Get(*id);
+    if (value) {
+      result.emplace_back(SectionAndPropertyValue{.section = ToSectionName(elem.first), .property = std::string(*value)});
     }
   }
   return result;
@@ -418,14 +603,11 @@ std::vector<ConfigCache::SectionAndPropertyValue> ConfigCache::GetSectionNamesWi
 
 namespace {
 
-bool FixDeviceTypeInconsistencyInSection(
-    const std::string& section_name, common::ListMap<std::string, std::string>& device_section_entries) {
-  if (!hci::Address::IsValidAddress(section_name)) {
-    return false;
-  }
-  auto device_type_iter = device_section_entries.find("DevType");
-  if (device_type_iter != device_section_entries.end() &&
-      device_type_iter->second == std::to_string(hci::DeviceType::DUAL)) {
+bool FixDeviceTypeInconsistencyInSection(FlatSection& device_section_entries, PropertyNames& property_names) {
+  PropertyId device_type_id = property_names.Intern("DevType");
+  auto device_type = device_section_entries.Get(device_type_id);
+  std::string dual_device_type_str = std::to_string(hci::DeviceType::DUAL);
+  if (device_type && *device_type == dual_device_type_str) {
     // We might only have one of classic/LE keys for a dual device, but it is still a dual device,
     // so we should not change the DevType.
     return false;
@@ -436,50 +618,50 @@ bool FixDeviceTypeInconsistencyInSection(
   bool is_le = false;
   bool is_classic = false;
   // default
-  hci::DeviceType device_type = hci::DeviceType::BR_EDR;
-  for (const auto& entry : device_section_entries) {
-    if (kLePropertyNames.find(entry.first) != kLePropertyNames.end()) {
+  hci::DeviceType inferred_device_type = hci::DeviceType::BR_EDR;
+  device_section_entries.ForEach([&](PropertyId id, std::string_view) {
+    const std::string& name = property_names.Name(id);
+    if (kLePropertyNames.find(name) != kLePropertyNames.end()) {
       is_le = true;
     }
-    if (kClassicPropertyNames.find(entry.first) != kClassicPropertyNames.end()) {
+    if (kClassicPropertyNames.find(name) != kClassicPropertyNames.end()) {
       is_classic = true;
     }
-  }
+  });
   if (is_classic && is_le) {
-    device_type = hci::DeviceType::DUAL;
+    inferred_device_type = hci::DeviceType::DUAL;
   } else if (is_classic) {
-    device_type = hci::DeviceType::BR_EDR;
+    inferred_device_type = hci::DeviceType::BR_EDR;
   } else if (is_le) {
-    device_type = hci::DeviceType::LE;
-  }
-  bool inconsistent = true;
-  std::string device_type_str = std::to_string(device_type);
-  if (device_type_iter != device_section_entries.end()) {
-    inconsistent = device_type_str != device_type_iter->second;
-    if (inconsistent) {
-      device_type_iter->second = std::move(device_type_str);
-    }
-  } else {
-    device_section_entries.insert_or_assign("DevType", std::move(device_type_str));
+    inferred_device_type = hci::DeviceType::LE;
   }
-  return inconsistent;
+  std::string device_type_str = std::to_string(inferred_device_type);
+  if (device_type && *device_type == device_type_str) {
+    return false;
+  }
+  device_section_entries.Set(device_type_id, device_type_str);
+  return true;
 }
 
 }  // namespace
 
 bool ConfigCache::FixDeviceTypeInconsistencies() {
-  std::lock_guard<std::recursive_mutex> lock(mutex_);
+  std::unique_lock<std::shared_mutex> lock(mutex_);
+  // only device sections have a device type, information sections are never named after an address
   bool persistent_device_changed = false;
-  for (auto* config_section : {&information_sections_, &persistent_devices_}) {
-    for (auto& elem : *config_section) {
-      if (FixDeviceTypeInconsistencyInSection(elem.first, elem.second)) {
-        persistent_device_changed = true;
-      }
+  for (auto& elem : persistent_devices_) {
+    if (FixDeviceTypeInconsistencyInSection(elem.second, property_names_)) {
+      RecordChange(
+          MutationEntry::EntryType::SET,
+          ToSectionName(elem.first),
+          "DevType",
+          *elem.second.Get(*property_names_.Find("DevType")));
+      persistent_device_changed = true;
     }
   }
   bool temp_device_changed = false;
   for (auto& elem : temporary_devices_) {
-    if (FixDeviceTypeInconsistencyInSection(elem.first, elem.second)) {
+    if (FixDeviceTypeInconsistencyInSection(elem.second, property_names_)) {
       temp_device_changed = true;
     }
   }
@@ -491,36 +673,26 @@ bool ConfigCache::FixDeviceTypeInconsistencies() {
 
 bool ConfigCache::HasAtLeastOneMatchingPropertiesInSection(
     const std::string& section, const std::unordered_set<std::string_view>& property_names) const {
-  std::lock_guard<std::recursive_mutex> lock(mutex_);
-  const common::ListMap<std::string, std::string>* section_ptr;
-  if (!IsDeviceSection(section)) {
-    auto section_iter = information_sections_.find(section);
-    if (section_iter == information_sections_.end()) {
+  return ObserveSection(section, [this, &property_names](const FlatSection* properties, bool) {
+    if (properties == nullptr) {
       return false;
     }
-    section_ptr = &section_iter->second;
-  } else {
-    auto section_iter = persistent_devices_.find(section);
-    if (section_iter == persistent_devices_.end()) {
-      section_iter = temporary_devices_.find(section);
-      if (section_iter == temporary_devices_.end()) {
-        return false;
-      }
-    }
-    section_ptr = &section_iter->second;
-  }
-  for (const auto& property : *section_ptr) {
-    if (property_names.count(property.first) > 0) {
-      return true;
-    }
-  }
-  return false;
+    bool has_matching_property = false;
+    properties->ForEach([&](PropertyId id, std::string_view) {
+      has_matching_property = has_matching_property || property_names.count(property_names_.Name(id)) > 0;
+    });
+    return has_matching_property;
+  });
 }
 
 bool ConfigCache::IsPersistentSection(const std::string& section) const {
-  std::lock_guard<std::recursive_mutex> lock(mutex_);
-  return persistent_devices_.contains(section);
+  auto key = ToDeviceKey(section);
+  if (!key) {
+    return false;
+  }
+  std::shared_lock<std::shared_mutex> lock(mutex_);
+  return persistent_devices_.contains(*key);
 }
 
 }  // namespace storage
-}  // namespace bluetooth
\ No newline at end of file
+}  // namespace bluetooth
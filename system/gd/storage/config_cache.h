@@ -20,6 +20,7 @@
 #include <mutex>
 #include <optional>
 #include <queue>
+#include <shared_mutex>
 #include <string>
 #include <string_view>
 #include <unordered_set>
@@ -30,6 +31,7 @@
 #include "common/lru_cache.h"
 #include "hci/address.h"
 #include "os/utils.h"
+#include "storage/flat_section.h"
 #include "storage/mutation_entry.h"
 
 namespace bluetooth {
@@ -48,7 +50,10 @@ class Mutation;
 // The definition of persistent sections is up to the user and is defined through the |persistent_property_names|
 // argument. When these properties are link key properties, then persistent sections is equal to bonded devices
 //
-// This class is thread safe
+// Sections are stored as FlatSection, device sections being keyed by their packed MAC address.
+//
+// This class is thread safe. Observers of information sections and persistent devices share the lock, while
+// observers of temporary devices take it exclusively as they update the LRU order
 class ConfigCache {
  public:
   ConfigCache(size_t temp_device_capacity, std::unordered_set<std::string_view> persistent_property_names);
@@ -96,6 +101,19 @@ class ConfigCache {
     }
   };
   virtual std::vector<SectionAndPropertyValue> GetSectionNamesWithProperty(const std::string& property) const;
+  // A change to a section that is written to disk, as recorded after EnableChangeRecording()
+  struct Change {
+    MutationEntry::EntryType type;
+    std::string section;
+    std::string property;
+    std::string value;
+    bool operator==(const Change& rhs) const {
+      return type == rhs.type && section == rhs.section && property == rhs.property && value == rhs.value;
+    }
+    bool operator!=(const Change& rhs) const {
+      return !(*this == rhs);
+    }
+  };
 
   // modifiers
   // Commit all mutation entries in sequence while holding the config mutex
@@ -111,6 +129,11 @@ class ConfigCache {
   virtual void Clear();
   // Set a callback to notify interested party that a persistent config change has just happened
   virtual void SetPersistentConfigChangedCallback(std::function<void()> persistent_config_changed_callback);
+  // Start recording the changes made to sections that are written to disk, so that they can be saved incrementally
+  virtual void EnableChangeRecording();
+  // Return the changes recorded since the last call, in order. Return std::nullopt if some of them could not be
+  // recorded (e.g. after Clear()), in which case the whole config must be saved again
+  virtual std::optional<std::vector<Change>> TakeRecordedChanges();
 
   // Device config specific methods
   // TODO: methods here should be moved to a device specific config cache if this config cache is supposed to be generic
@@ -125,19 +148,64 @@ class ConfigCache {
   static const std::string kDefaultSectionName;
 
  private:
-  mutable std::recursive_mutex mutex_;
+  // Device sections are keyed by their MAC address packed in the 48 low bits, and a bit per hex digit that is an
+  // upper case letter above them, so that the section name can be restored exactly
+  using DeviceKey = uint64_t;
+  static std::optional<DeviceKey> ToDeviceKey(const std::string& section);
+  static std::string ToSectionName(DeviceKey key);
+
+  // Return the section named |section|, whose device key is |key|, among information sections and persistent devices.
+  // nullptr if not found
+  const FlatSection* FindPersistentSectionLocked(const std::string& section, std::optional<DeviceKey> key) const;
+  // Call |observer| with the section named |section|, or nullptr if not found, and whether it is a persistent device.
+  // Information sections and persistent devices are observed under the shared lock, temporary devices under the
+  // exclusive lock as finding them warms them up
+  template <typename Observer>
+  auto ObserveSection(const std::string& section, Observer observer) const;
+  std::optional<std::string_view> GetValueLocked(const FlatSection& properties, const std::string& property) const;
+  void SetPropertyLocked(std::string section, std::string property, std::string value);
+  bool RemoveSectionLocked(const std::string& section);
+  bool RemovePropertyLocked(const std::string& section, const std::string& property);
+  std::vector<std::string> GetPersistentSectionsLocked() const;
+  bool SectionsEqual(const FlatSection& lhs, const ConfigCache& rhs_cache, const FlatSection& rhs) const;
+
+  mutable std::shared_mutex mutex_;
   // A callback to notify interested party that a persistent config change has just happened, empty by default
   std::function<void()> persistent_config_changed_callback_;
   // A set of property names that if set would make a section persistent and if non of these properties are set, a
   // section would become temporary again
   std::unordered_set<std::string_view> persistent_property_names_;
+  // Names of the properties of all sections below
+  PropertyNames property_names_;
   // Common section that does not relate to remote device, will be written to disk
-  common::ListMap<std::string, common::ListMap<std::string, std::string>> information_sections_;
+  common::ListMap<std::string, FlatSection> information_sections_;
   // Information about persistent devices, normally paired, will be written to disk
-  common::ListMap<std::string, common::ListMap<std::string, std::string>> persistent_devices_;
+  common::ListMap<DeviceKey, FlatSection> persistent_devices_;
   // Information about temporary devices, normally unpaired, will not be written to disk, will be evicted automatically
   // if capacity exceeds given value during initialization
-  common::LruCache<std::string, common::ListMap<std::string, std::string>> temporary_devices_;
+  common::LruCache<DeviceKey, FlatSection> temporary_devices_;
+  // Changes made to persistent sections since the last TakeRecordedChanges(), only when change recording is enabled
+  bool is_recording_changes_ = false;
+  bool has_unrecorded_changes_ = false;
+  std::vector<Change> recorded_changes_;
+
+  // Convenience methods to keep track of persistent changes when change recording is enabled
+  inline void RecordChange(
+      MutationEntry::EntryType type,
+      std::string_view section,
+      std::string_view property = {},
+      std::string_view value = {}) {
+    if (is_recording_changes_) {
+      recorded_changes_.push_back(Change{
+          .type = type, .section = std::string(section), .property = std::string(property), .value = std::string(value)});
+    }
+  }
+  inline void RecordUnrecordableChange() {
+    if (is_recording_changes_) {
+      has_unrecorded_changes_ = true;
+      recorded_changes_.clear();
+    }
+  }
 
   // Convenience method to check if the callback is valid before calling it
   inline void PersistentConfigChangedCallback() const {
@@ -0,0 +1,178 @@
+/*
+ * Copyright 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <malloc.h>
+
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "storage/config_cache.h"
+#include "storage/device.h"
+
+using ::benchmark::State;
+
+namespace bluetooth {
+namespace storage {
+
+namespace {
+
+constexpr int kNumTemporaryDevices = 10000;
+constexpr int kNumPersistentDevices = 100;
+
+std::string DeviceAddress(int index) {
+  char address[18];
+  std::snprintf(
+      address, sizeof(address), "aa:bb:cc:%02x:%02x:%02x", (index >> 16) & 0xff, (index >> 8) & 0xff, index & 0xff);
+  return address;
+}
+
+// Properties of a device found during discovery
+void SetDiscoveredDeviceProperties(ConfigCache& cache, const std::string& section, int index) {
+  cache.SetProperty(section, "Name", "Device " + std::to_string(index));
+  cache.SetProperty(section, "DevClass", "5898764");
+  cache.SetProperty(section, "DevType", "3");
+  cache.SetProperty(section, "AddrType", "0");
+  cache.SetProperty(section, "Manufacturer", "15");
+  cache.SetProperty(section, "LmpVer", "12");
+  cache.SetProperty(section, "LmpSubVer", "8713");
+  cache.SetProperty(section, "Timestamp", std::to_string(1680000000 + index));
+}
+
+// Properties of a bonded device
+void SetBondedDeviceProperties(ConfigCache& cache, const std::string& section, int index) {
+  SetDiscoveredDeviceProperties(cache, section, index);
+  cache.SetProperty(section, "LinkKey", "fedcba0987654321fedcba0987654321");
+  cache.SetProperty(section, "LinkKeyType", "8");
+  cache.SetProperty(section, "PinLength", "0");
+  cache.SetProperty(section, "Service", "0000110a-0000-1000-8000-00805f9b34fb 0000110b-0000-1000-8000-00805f9b34fb");
+  cache.SetProperty(section, "LE_KEY_PENC", "fedcba0987654321fedcba09876543210011223344556677");
+  cache.SetProperty(section, "LE_KEY_PID", "fedcba0987654321fedcba0987654321aabbccddeeff00");
+}
+
+std::unique_ptr<ConfigCache> MakeConfigCache() {
+  auto cache = std::make_unique<ConfigCache>(kNumTemporaryDevices, Device::kLinkKeyProperties);
+  cache->SetProperty("Adapter", "Address", "01:02:03:ab:cd:ef");
+  for (int i = 0; i < kNumPersistentDevices; i++) {
+    SetBondedDeviceProperties(*cache, DeviceAddress(kNumTemporaryDevices + i), i);
+  }
+  for (int i = 0; i < kNumTemporaryDevices; i++) {
+    SetDiscoveredDeviceProperties(*cache, DeviceAddress(i), i);
+  }
+  return cache;
+}
+
+size_t AllocatedBytes() {
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+  return mallinfo2().uordblks;
+#else
+  return mallinfo().uordblks;
+#endif
+}
+
+}  // namespace
+
+static void BM_ConfigCacheMemoryPerTemporaryDevice(State& state) {
+  for (auto _ : state) {
+    state.PauseTiming();
+    size_t allocated_before = AllocatedBytes();
+    state.ResumeTiming();
+    ConfigCache cache(kNumTemporaryDevices, Device::kLinkKeyProperties);
+    for (int i = 0; i < kNumTemporaryDevices; i++) {
+      SetDiscoveredDeviceProperties(cache, DeviceAddress(i), i);
+    }
+    state.PauseTiming();
+    state.counters["bytes_per_device"] =
+        static_cast<double>(AllocatedBytes() - allocated_before) / kNumTemporaryDevices;
+    state.ResumeTiming();
+  }
+}
+BENCHMARK(BM_ConfigCacheMemoryPerTemporaryDevice)->Unit(benchmark::kMillisecond);
+
+class BM_ConfigCache : public ::benchmark::Fixture {
+ protected:
+  void SetUp(State& st) override {
+    ::benchmark::Fixture::SetUp(st);
+    if (st.thread_index() == 0) {
+      cache_ = MakeConfigCache();
+      for (int i = 0; i < kNumTemporaryDevices + kNumPersistentDevices; i++) {
+        sections_.push_back(DeviceAddress(i));
+      }
+    }
+  }
+
+  void TearDown(State& st) override {
+    if (st.thread_index() == 0) {
+      cache_.reset();
+      sections_.clear();
+    }
+    ::benchmark::Fixture::TearDown(st);
+  }
+
+  std::unique_ptr<ConfigCache> cache_;
+  std::vector<std::string> sections_;
+};
+
+BENCHMARK_DEFINE_F(BM_ConfigCache, GetTemporaryDeviceProperty)(State& state) {
+  int i = 0;
+  for (auto _ : state) {
+    auto value = cache_->GetProperty(sections_[i], "LmpSubVer");
+    benchmark::DoNotOptimize(value);
+    i = (i + 7919) % kNumTemporaryDevices;
+  }
+}
+BENCHMARK_REGISTER_F(BM_ConfigCache, GetTemporaryDeviceProperty);
+
+BENCHMARK_DEFINE_F(BM_ConfigCache, SetTemporaryDeviceProperty)(State& state) {
+  int i = 0;
+  for (auto _ : state) {
+    cache_->SetProperty(sections_[i], "Timestamp", "1690000000");
+    i = (i + 7919) % kNumTemporaryDevices;
+  }
+}
+BENCHMARK_REGISTER_F(BM_ConfigCache, SetTemporaryDeviceProperty);
+
+BENCHMARK_DEFINE_F(BM_ConfigCache, GetPersistentDeviceProperty)(State& state) {
+  int i = 0;
+  for (auto _ : state) {
+    auto value = cache_->GetProperty(sections_[kNumTemporaryDevices + i], "LinkKeyType");
+    benchmark::DoNotOptimize(value);
+    i = (i + 1) % kNumPersistentDevices;
+  }
+}
+BENCHMARK_REGISTER_F(BM_ConfigCache, GetPersistentDeviceProperty)->Threads(1)->Threads(4);
+
+BENCHMARK_DEFINE_F(BM_ConfigCache, SetPersistentDeviceProperty)(State& state) {
+  int i = 0;
+  for (auto _ : state) {
+    cache_->SetProperty(sections_[kNumTemporaryDevices + i], "Timestamp", "1690000000");
+    i = (i + 1) % kNumPersistentDevices;
+  }
+}
+BENCHMARK_REGISTER_F(BM_ConfigCache, SetPersistentDeviceProperty);
+
+BENCHMARK_DEFINE_F(BM_ConfigCache, SerializeToLegacyFormat)(State& state) {
+  for (auto _ : state) {
+    auto serialized = cache_->SerializeToLegacyFormat();
+    benchmark::DoNotOptimize(serialized);
+  }
+}
+BENCHMARK_REGISTER_F(BM_ConfigCache, SerializeToLegacyFormat);
+
+}  // namespace storage
+}  // namespace bluetooth
@@ -37,6 +37,8 @@ std::string GetTestAddress(int i) {
 
 using bluetooth::storage::ConfigCache;
 using bluetooth::storage::Device;
+using bluetooth::storage::MutationEntry;
+using Change = bluetooth::storage::ConfigCache::Change;
 using SectionAndPropertyValue = bluetooth::storage::ConfigCache::SectionAndPropertyValue;
 
 TEST(ConfigCacheTest, simple_set_get_test) {
@@ -131,6 +133,26 @@ TEST(ConfigCacheTest, mac_address_set_get_test) {
   ASSERT_FALSE(config.GetProperty("ABC", "B"));
 }
 
+TEST(ConfigCacheTest, mac_address_case_is_preserved_test) {
+  ConfigCache config(100, Device::kLinkKeyProperties);
+  config.SetProperty("aa:BB:cC:Dd:01:9f", "LinkKey", "AABBAABBCCDDEE");
+  config.SetProperty("aa:bb:cc:dd:01:9f", "B", "C");
+  ASSERT_THAT(config.GetPersistentSections(), ElementsAre("aa:BB:cC:Dd:01:9f"));
+  ASSERT_THAT(config.GetProperty("aa:bb:cc:dd:01:9f", "B"), Optional(StrEq("C")));
+  ASSERT_FALSE(config.HasProperty("aa:bb:cc:dd:01:9f", "LinkKey"));
+  ASSERT_EQ(config.SerializeToLegacyFormat(), "[aa:BB:cC:Dd:01:9f]\nLinkKey = AABBAABBCCDDEE\n\n");
+}
+
+TEST(ConfigCacheTest, is_device_section_test) {
+  ASSERT_TRUE(ConfigCache::IsDeviceSection("AA:BB:CC:DD:EE:FF"));
+  ASSERT_TRUE(ConfigCache::IsDeviceSection("01:23:45:67:89:ab"));
+  ASSERT_FALSE(ConfigCache::IsDeviceSection("Adapter"));
+  ASSERT_FALSE(ConfigCache::IsDeviceSection("AA:BB:CC:DD:EE"));
+  ASSERT_FALSE(ConfigCache::IsDeviceSection("AA:BB:CC:DD:EE:FG"));
+  ASSERT_FALSE(ConfigCache::IsDeviceSection("AA-BB-CC-DD-EE-FF"));
+  ASSERT_FALSE(ConfigCache::IsDeviceSection("AA:BB:CC:DD:EE: F"));
+}
+
 TEST(ConfigCacheTest, has_section_and_property_test) {
   ConfigCache config(100, Device::kLinkKeyProperties);
   config.SetProperty("A", "B", "C");
@@ -413,4 +435,73 @@ TEST(ConfigCacheTest, test_empty_persistent_properties) {
   ASSERT_THAT(config.GetPersistentSections(), ElementsAre());
 }
 
-}  // namespace testing
\ No newline at end of file
+TEST(ConfigCacheTest, test_no_change_recording_by_default) {
+  ConfigCache config(100, Device::kLinkKeyProperties);
+  config.SetProperty("A", "B", "C");
+  ASSERT_THAT(config.TakeRecordedChanges(), Optional(ElementsAre()));
+}
+
+TEST(ConfigCacheTest, test_change_recording) {
+  ConfigCache config(100, Device::kLinkKeyProperties);
+  config.EnableChangeRecording();
+  config.SetProperty("A", "B", "C");
+  // temporary devices are not written to disk
+  config.SetProperty("AA:BB:CC:DD:EE:FF", "B", "C");
+  config.RemoveProperty("AA:BB:CC:DD:EE:FF", "D");
+  // until they become persistent
+  config.SetProperty("AA:BB:CC:DD:EE:FF", "LinkKey", "D");
+  config.RemoveProperty("A", "B");
+  config.RemoveSection("AA:BB:CC:DD:EE:FF");
+  ASSERT_THAT(
+      config.TakeRecordedChanges(),
+      Optional(ElementsAre(
+          Change{.type = MutationEntry::EntryType::SET, .section = "A", .property = "B", .value = "C"},
+          Change{.type = MutationEntry::EntryType::SET, .section = "AA:BB:CC:DD:EE:FF", .property = "B", .value = "C"},
+          Change{
+              .type = MutationEntry::EntryType::SET,
+              .section = "AA:BB:CC:DD:EE:FF",
+              .property = "LinkKey",
+              .value = "D"},
+          Change{.type = MutationEntry::EntryType::REMOVE_PROPERTY, .section = "A", .property = "B"},
+          Change{.type = MutationEntry::EntryType::REMOVE_SECTION, .section = "AA:BB:CC:DD:EE:FF"})));
+  ASSERT_THAT(config.TakeRecordedChanges(), Optional(ElementsAre()));
+}
+
+TEST(ConfigCacheTest, test_change_recording_remove_section_with_property) {
+  ConfigCache config(100, Device::kLinkKeyProperties);
+  config.SetProperty("AA:BB:CC:DD:EE:FF", "LinkKey", "D");
+  config.SetProperty("AA:BB:CC:DD:EE:FF", "Restricted", "1");
+  config.SetProperty("AA:BB:CC:DD:EE:EF", "LinkKey", "D");
+  config.EnableChangeRecording();
+  config.RemoveSectionWithProperty("Restricted");
+  ASSERT_THAT(
+      config.TakeRecordedChanges(),
+      Optional(ElementsAre(Change{.type = MutationEntry::EntryType::REMOVE_SECTION, .section = "AA:BB:CC:DD:EE:FF"})));
+}
+
+TEST(ConfigCacheTest, test_change_recording_fix_device_type_inconsistencies) {
+  ConfigCache config(100, Device::kLinkKeyProperties);
+  config.SetProperty("AA:BB:CC:DD:EE:FF", "LinkKey", "D");
+  config.EnableChangeRecording();
+  ASSERT_TRUE(config.FixDeviceTypeInconsistencies());
+  ASSERT_THAT(
+      config.TakeRecordedChanges(),
+      Optional(ElementsAre(Change{
+          .type = MutationEntry::EntryType::SET,
+          .section = "AA:BB:CC:DD:EE:FF",
+          .property = "DevType",
+          .value = std::to_string(bluetooth::hci::DeviceType::BR_EDR)})));
+}
+
+TEST(ConfigCacheTest, test_change_recording_after_clear) {
+  ConfigCache config(100, Device::kLinkKeyProperties);
+  config.EnableChangeRecording();
+  config.SetProperty("A", "B", "C");
+  config.Clear();
+  config.SetProperty("A", "B", "D");
+  // Clear() cannot be recorded, the whole config must be saved
+  ASSERT_FALSE(config.TakeRecordedChanges());
+  ASSERT_THAT(config.TakeRecordedChanges(), Optional(ElementsAre()));
+}
+
+}  // namespace testing
@@ -0,0 +1,203 @@
+/*
+ * Copyright 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "storage/config_journal.h"
+
+#include "common/strings.h"
+#include "os/files.h"
+#include "os/log.h"
+
+namespace bluetooth {
+namespace storage {
+
+namespace {
+
+// One record per line, fields are separated by tabs, the value of a property being the last field of its record
+//   generation\t<generation>, first record of the batch, omitted for generation 0
+//   set\t<section>\t<property>\t<value>
+//   remove_property\t<section>\t<property>
+//   remove_section\t<section>
+//   commit
+const std::string kGenerationRecord = "generation";
+const std::string kSetRecord = "set";
+const std::string kRemovePropertyRecord = "remove_property";
+const std::string kRemoveSectionRecord = "remove_section";
+const std::string kCommitRecord = "commit";
+const std::string kFieldSeparator = "\t";
+
+bool IsValidField(const std::string& field) {
+  return field.find_first_of("\t\n") == std::string::npos;
+}
+
+std::optional<ConfigCache::Change> ParseRecord(const std::string& line) {
+  auto fields = common::StringSplit(line, kFieldSeparator, 4);
+  if (fields[0] == kSetRecord && fields.size() == 4) {
+    return ConfigCache::Change{
+        .type = MutationEntry::EntryType::SET, .section = fields[1], .property = fields[2], .value = fields[3]};
+  }
+  if (fields[0] == kRemovePropertyRecord && fields.size() == 3) {
+    return ConfigCache::Change{
+        .type = MutationEntry::EntryType::REMOVE_PROPERTY, .section = fields[1], .property = fields[2]};
+  }
+  if (fields[0] == kRemoveSectionRecord && fields.size() == 2) {
+    return ConfigCache::Change{.type = MutationEntry::EntryType::REMOVE_SECTION, .section = fields[1]};
+  }
+  return std::nullopt;
+}
+
+void ApplyChange(ConfigCache& cache, ConfigCache::Change change) {
+  switch (change.type) {
+    case MutationEntry::EntryType::SET:
+      cache.SetProperty(std::move(change.section), std::move(change.property), std::move(change.value));
+      break;
+    case MutationEntry::EntryType::REMOVE_PROPERTY:
+      cache.RemoveProperty(change.section, change.property);
+      break;
+    case MutationEntry::EntryType::REMOVE_SECTION:
+      cache.RemoveSection(change.section);
+      break;
+      // do not write a default case so that when a new enum is defined, compilation would fail automatically
+  }
+}
+
+}  // namespace
+
+ConfigJournal::ConfigJournal(std::string path) : path_(std::move(path)) {
+  ASSERT(!path_.empty());
+}
+
+std::optional<std::string> ConfigJournal::Serialize(
+    const std::vector<ConfigCache::Change>& changes, uint64_t generation) {
+  std::string serialized;
+  if (generation != 0) {
+    serialized.append(kGenerationRecord).append(kFieldSeparator).append(std::to_string(generation)).push_back('\n');
+  }
+  for (const auto& change : changes) {
+    if (!IsValidField(change.section) || !IsValidField(change.property) ||
+        change.value.find('\n') != std::string::npos) {
+      return std::nullopt;
+    }
+    switch (change.type) {
+      case MutationEntry::EntryType::SET:
+        serialized.append(kSetRecord)
+            .append(kFieldSeparator)
+            .append(change.section)
+            .append(kFieldSeparator)
+            .append(change.property)
+            .append(kFieldSeparator)
+            .append(change.value);
+        break;
+      case MutationEntry::EntryType::REMOVE_PROPERTY:
+        serialized.append(kRemovePropertyRecord)
+            .append(kFieldSeparator)
+            .append(change.section)
+            .append(kFieldSeparator)
+            .append(change.property);
+        break;
+      case MutationEntry::EntryType::REMOVE_SECTION:
+        serialized.append(kRemoveSectionRecord).append(kFieldSeparator).append(change.section);
+        break;
+        // do not write a default case so that when a new enum is defined, compilation would fail automatically
+    }
+    serialized.push_back('\n');
+  }
+  serialized.append(kCommitRecord).push_back('\n');
+  return serialized;
+}
+
+std::optional<size_t> ConfigJournal::Append(const std::vector<ConfigCache::Change>& changes, uint64_t generation) {
+  auto serialized = Serialize(changes, generation);
+  if (!serialized) {
+    LOG_WARN("changes cannot be written to journal '%s'", path_.c_str());
+    return std::nullopt;
+  }
+  if (!os::AppendToFile(path_, *serialized)) {
+    return std::nullopt;
+  }
+  return serialized->size();
+}
+
+size_t ConfigJournal::Replay(ConfigCache& cache, uint64_t generation) {
+  if (!os::FileExists(path_)) {
+    return 0;
+  }
+  auto journal = os::ReadSmallFile(path_);
+  if (!journal) {
+    return 0;
+  }
+  size_t num_applied = 0;
+  size_t num_skipped = 0;
+  std::vector<ConfigCache::Change> batch;
+  uint64_t batch_generation = 0;
+  std::string::size_type line_start = 0;
+  while (line_start < journal->size()) {
+    auto line_end = journal->find('\n', line_start);
+    if (line_end == std::string::npos) {
+      // the last record was not fully written
+      break;
+    }
+    auto line = journal->substr(line_start, line_end - line_start);
+    line_start = line_end + 1;
+    if (line == kCommitRecord) {
+      if (batch_generation == generation) {
+        for (auto& change : batch) {
+          ApplyChange(cache, std::move(change));
+        }
+        num_applied += batch.size();
+      } else {
+        num_skipped += batch.size();
+      }
+      batch.clear();
+      batch_generation = 0;
+      continue;
+    }
+    if (batch.empty() && line.rfind(kGenerationRecord + kFieldSeparator, 0) == 0) {
+      auto parsed_generation = common::Uint64FromString(line.substr(kGenerationRecord.size() + 1));
+      if (parsed_generation) {
+        batch_generation = *parsed_generation;
+        continue;
+      }
+    }
+    auto change = ParseRecord(line);
+    if (!change) {
+      LOG_WARN("corrupted record in journal '%s', ignoring the rest of it", path_.c_str());
+      line_start = journal->size();
+      break;
+    }
+    batch.push_back(std::move(*change));
+  }
+  if (!batch.empty() || line_start < journal->size()) {
+    LOG_WARN("dropped incomplete batch of changes at the end of journal '%s'", path_.c_str());
+  }
+  if (num_skipped > 0) {
+    LOG_INFO(
+        "skipped %zu changes of journal '%s' that don't apply to config generation %llu",
+        num_skipped,
+        path_.c_str(),
+        static_cast<unsigned long long>(generation));
+  }
+  return num_applied;
+}
+
+bool ConfigJournal::Delete() {
+  if (!os::FileExists(path_)) {
+    return false;
+  }
+  return os::RemoveFile(path_);
+}
+
+}  // namespace storage
+}  // namespace bluetooth
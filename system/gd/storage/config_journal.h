@@ -0,0 +1,59 @@
+/*
+ * Copyright 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "storage/config_cache.h"
+
+namespace bluetooth {
+namespace storage {
+
+// Append-only log of the changes made to a config since it was last written with LegacyConfigFile
+//
+// Each call to Append() adds a batch of changes terminated by a commit record. Replay() only applies complete
+// batches, so a batch that was partially written when the device crashed or lost power is dropped as a whole.
+//
+// Batches are tagged with the generation of the config they apply to, which changes every time the config is written
+// in full. Replay() skips batches of other generations, which are already part of the config when the device crashed
+// after writing the config but before deleting the journal. A batch without a generation record belongs to
+// generation 0.
+class ConfigJournal {
+ public:
+  static ConfigJournal FromPath(std::string path) {
+    return ConfigJournal(std::move(path));
+  }
+  explicit ConfigJournal(std::string path);
+  // Append |changes| as one batch of |generation| and sync them to disk, return the number of bytes written or
+  // std::nullopt on failure
+  std::optional<size_t> Append(const std::vector<ConfigCache::Change>& changes, uint64_t generation);
+  // Apply the complete batches of |generation| to |cache| in order, return the number of changes applied
+  size_t Replay(ConfigCache& cache, uint64_t generation);
+  bool Delete();
+
+  // Serialize |changes| as one batch of |generation|, return std::nullopt if they cannot be represented in the journal
+  static std::optional<std::string> Serialize(const std::vector<ConfigCache::Change>& changes, uint64_t generation);
+
+ private:
+  std::string path_;
+};
+
+}  // namespace storage
+}  // namespace bluetooth
@@ -0,0 +1,151 @@
+/*
+ * Copyright 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "storage/config_journal.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <filesystem>
+
+#include "os/files.h"
+#include "storage/device.h"
+
+namespace testing {
+
+using bluetooth::os::AppendToFile;
+using bluetooth::os::ReadSmallFile;
+using bluetooth::storage::ConfigCache;
+using bluetooth::storage::ConfigJournal;
+using bluetooth::storage::Device;
+using bluetooth::storage::MutationEntry;
+
+class ConfigJournalTest : public Test {
+ protected:
+  void SetUp() override {
+    temp_journal_ = std::filesystem::temp_directory_path() / "temp_config.journal";
+    std::filesystem::remove(temp_journal_);
+  }
+
+  void TearDown() override {
+    std::filesystem::remove(temp_journal_);
+  }
+
+  std::filesystem::path temp_journal_;
+};
+
+TEST_F(ConfigJournalTest, append_and_replay_loop_back_test) {
+  ConfigCache config(100, Device::kLinkKeyProperties);
+  config.EnableChangeRecording();
+  config.SetProperty("A", "B", "C");
+  config.SetProperty("AA:BB:CC:DD:EE:FF", "B", "C");
+  config.SetProperty("AA:BB:CC:DD:EE:FF", "LinkKey", "AABBAABBCCDDEE");
+  auto changes = config.TakeRecordedChanges();
+  ASSERT_TRUE(changes);
+  ASSERT_TRUE(ConfigJournal::FromPath(temp_journal_.string()).Append(*changes, 0));
+
+  config.SetProperty("A", "B", "value with\ttab");
+  config.SetProperty("A", "C", "");
+  config.RemoveProperty("AA:BB:CC:DD:EE:FF", "B");
+  config.SetProperty("CC:DD:EE:FF:00:11", "LinkKey", "AABBAABBCCDDEE");
+  config.RemoveSection("CC:DD:EE:FF:00:11");
+  changes = config.TakeRecordedChanges();
+  ASSERT_TRUE(changes);
+  ASSERT_TRUE(ConfigJournal::FromPath(temp_journal_.string()).Append(*changes, 0));
+
+  ConfigCache config_replayed(100, Device::kLinkKeyProperties);
+  EXPECT_EQ(ConfigJournal::FromPath(temp_journal_.string()).Replay(config_replayed, 0), 8u);
+  EXPECT_EQ(config, config_replayed);
+  EXPECT_THAT(config_replayed.GetProperty("A", "B"), Optional(StrEq("value with\ttab")));
+  EXPECT_THAT(config_replayed.GetProperty("A", "C"), Optional(StrEq("")));
+}
+
+TEST_F(ConfigJournalTest, append_size_test) {
+  std::vector<ConfigCache::Change> changes = {
+      {.type = MutationEntry::EntryType::SET, .section = "A", .property = "B", .value = "C"},
+      {.type = MutationEntry::EntryType::REMOVE_PROPERTY, .section = "A", .property = "B"},
+      {.type = MutationEntry::EntryType::REMOVE_SECTION, .section = "A"},
+  };
+  std::string expected = "set\tA\tB\tC\nremove_property\tA\tB\nremove_section\tA\ncommit\n";
+  EXPECT_THAT(ConfigJournal::Serialize(changes, 0), Optional(StrEq(expected)));
+  EXPECT_THAT(ConfigJournal::FromPath(temp_journal_.string()).Append(changes, 0), Optional(expected.size()));
+  EXPECT_THAT(ReadSmallFile(temp_journal_.string()), Optional(StrEq(expected)));
+}
+
+TEST_F(ConfigJournalTest, unrepresentable_changes_test) {
+  std::vector<ConfigCache::Change> changes = {
+      {.type = MutationEntry::EntryType::SET, .section = "A", .property = "B\tC", .value = "D"},
+  };
+  EXPECT_FALSE(ConfigJournal::Serialize(changes, 0));
+  EXPECT_FALSE(ConfigJournal::FromPath(temp_journal_.string()).Append(changes, 0));
+  EXPECT_FALSE(std::filesystem::exists(temp_journal_));
+}
+
+TEST_F(ConfigJournalTest, incomplete_batch_is_dropped_test) {
+  ASSERT_TRUE(AppendToFile(temp_journal_.string(), "set\tA\tB\tC\ncommit\n"));
+  // Batch without its commit record, as if the device crashed in the middle of writing it
+  ASSERT_TRUE(AppendToFile(temp_journal_.string(), "set\tA\tD\tE\nremove_prop"));
+
+  ConfigCache config(100, Device::kLinkKeyProperties);
+  EXPECT_EQ(ConfigJournal::FromPath(temp_journal_.string()).Replay(config, 0), 1u);
+  EXPECT_THAT(config.GetProperty("A", "B"), Optional(StrEq("C")));
+  EXPECT_FALSE(config.HasProperty("A", "D"));
+}
+
+TEST_F(ConfigJournalTest, corrupted_record_stops_replay_test) {
+  ASSERT_TRUE(AppendToFile(temp_journal_.string(), "set\tA\tB\tC\ncommit\n"));
+  ASSERT_TRUE(AppendToFile(temp_journal_.string(), "set\tA\tD\tE\ngarbage\ncommit\n"));
+  ASSERT_TRUE(AppendToFile(temp_journal_.string(), "set\tA\tF\tG\ncommit\n"));
+
+  ConfigCache config(100, Device::kLinkKeyProperties);
+  EXPECT_EQ(ConfigJournal::FromPath(temp_journal_.string()).Replay(config, 0), 1u);
+  EXPECT_THAT(config.GetProperty("A", "B"), Optional(StrEq("C")));
+  EXPECT_FALSE(config.HasProperty("A", "D"));
+  EXPECT_FALSE(config.HasProperty("A", "F"));
+}
+
+TEST_F(ConfigJournalTest, batches_of_other_generations_are_skipped_test) {
+  std::vector<ConfigCache::Change> changes = {
+      {.type = MutationEntry::EntryType::SET, .section = "A", .property = "B", .value = "C"},
+  };
+  EXPECT_THAT(ConfigJournal::Serialize(changes, 7), Optional(StrEq("generation\t7\nset\tA\tB\tC\ncommit\n")));
+  // Batches left by a config that was written in full, without deleting the journal afterwards
+  ASSERT_TRUE(AppendToFile(temp_journal_.string(), "set\tA\tB\tC\ncommit\n"));
+  ASSERT_TRUE(AppendToFile(temp_journal_.string(), "generation\t1\nset\tA\tD\tE\ncommit\n"));
+  changes = {
+      {.type = MutationEntry::EntryType::SET, .section = "A", .property = "F", .value = "G"},
+  };
+  ASSERT_TRUE(ConfigJournal::FromPath(temp_journal_.string()).Append(changes, 2));
+
+  ConfigCache config(100, Device::kLinkKeyProperties);
+  EXPECT_EQ(ConfigJournal::FromPath(temp_journal_.string()).Replay(config, 2), 1u);
+  EXPECT_FALSE(config.HasProperty("A", "B"));
+  EXPECT_FALSE(config.HasProperty("A", "D"));
+  EXPECT_THAT(config.GetProperty("A", "F"), Optional(StrEq("G")));
+
+  ConfigCache config_generation_0(100, Device::kLinkKeyProperties);
+  EXPECT_EQ(ConfigJournal::FromPath(temp_journal_.string()).Replay(config_generation_0, 0), 1u);
+  EXPECT_THAT(config_generation_0.GetProperty("A", "B"), Optional(StrEq("C")));
+  EXPECT_FALSE(config_generation_0.HasProperty("A", "F"));
+}
+
+TEST_F(ConfigJournalTest, replay_non_existing_journal_test) {
+  ConfigCache config(100, Device::kLinkKeyProperties);
+  EXPECT_EQ(ConfigJournal::FromPath(temp_journal_.string()).Replay(config, 0), 0u);
+  EXPECT_FALSE(ConfigJournal::FromPath(temp_journal_.string()).Delete());
+}
+
+}  // namespace testing
@@ -0,0 +1,98 @@
+/*
+ * Copyright 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "storage/flat_section.h"
+
+#include "os/log.h"
+
+namespace bluetooth {
+namespace storage {
+
+PropertyId PropertyNames::Intern(std::string_view name) {
+  auto iter = ids_.find(name);
+  if (iter != ids_.end()) {
+    return iter->second;
+  }
+  PropertyId id = names_.size();
+  const std::string& interned = names_.emplace_back(name);
+  ids_.emplace(interned, id);
+  return id;
+}
+
+std::optional<PropertyId> PropertyNames::Find(std::string_view name) const {
+  auto iter = ids_.find(name);
+  if (iter == ids_.end()) {
+    return std::nullopt;
+  }
+  return iter->second;
+}
+
+std::optional<size_t> FlatSection::FindIndex(PropertyId id) const {
+  // Sections have a few dozen properties at most, a linear scan of the contiguous ids is the fastest look up
+  for (size_t i = 0; i < properties_.size(); i++) {
+    if (properties_[i].id == id) {
+      return i;
+    }
+  }
+  return std::nullopt;
+}
+
+std::optional<std::string_view> FlatSection::Get(PropertyId id) const {
+  auto index = FindIndex(id);
+  if (!index) {
+    return std::nullopt;
+  }
+  return ValueOf(properties_[*index]);
+}
+
+void FlatSection::Set(PropertyId id, std::string_view value) {
+  auto index = FindIndex(id);
+  if (!index) {
+    ASSERT(values_.size() + value.size() <= UINT32_MAX);
+    properties_.push_back(Property{
+        .id = id, .offset = static_cast<uint32_t>(values_.size()), .size = static_cast<uint32_t>(value.size())});
+    values_.append(value);
+    return;
+  }
+  auto& property = properties_[*index];
+  if (property.size != value.size()) {
+    ASSERT(values_.size() - property.size + value.size() <= UINT32_MAX);
+    int64_t delta = static_cast<int64_t>(value.size()) - property.size;
+    for (size_t i = *index + 1; i < properties_.size(); i++) {
+      properties_[i].offset += delta;
+    }
+  }
+  values_.replace(property.offset, property.size, value);
+  property.size = value.size();
+}
+
+std::optional<std::string> FlatSection::Extract(PropertyId id) {
+  auto index = FindIndex(id);
+  if (!index) {
+    return std::nullopt;
+  }
+  const auto property = properties_[*index];
+  std::string value = values_.substr(property.offset, property.size);
+  values_.erase(property.offset, property.size);
+  properties_.erase(properties_.begin() + *index);
+  for (size_t i = *index; i < properties_.size(); i++) {
+    properties_[i].offset -= property.size;
+  }
+  return value;
+}
+
+}  // namespace storage
+}  // namespace bluetooth
@@ -0,0 +1,110 @@
+/*
+ * Copyright 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace bluetooth {
+namespace storage {
+
+using PropertyId = uint32_t;
+
+// Interned property names of a config
+//
+// A config has a few dozen distinct property names shared by thousands of sections, hence sections refer to them by
+// id instead of holding their own copy.
+//
+// NOT THREAD SAFE
+class PropertyNames {
+ public:
+  PropertyNames() = default;
+  PropertyNames(const PropertyNames&) = delete;
+  PropertyNames& operator=(const PropertyNames&) = delete;
+  PropertyNames(PropertyNames&&) noexcept = default;
+  PropertyNames& operator=(PropertyNames&&) noexcept = default;
+
+  // Return the id of |name|, interning it if needed
+  PropertyId Intern(std::string_view name);
+  // Return the id of |name|, std::nullopt if it was never interned
+  std::optional<PropertyId> Find(std::string_view name) const;
+  const std::string& Name(PropertyId id) const {
+    return names_[id];
+  }
+
+ private:
+  // std::deque does not move its elements when growing, hence |ids_| can refer to them
+  std::deque<std::string> names_;
+  std::unordered_map<std::string_view, PropertyId> ids_;
+};
+
+// Properties of a config section, kept in insertion order
+//
+// Property values are stored back to back in a single buffer, so that a section takes two allocations no matter how
+// many properties it has.
+//
+// NOT THREAD SAFE
+class FlatSection {
+ public:
+  // Return the value of |id|, std::nullopt if not present. The view is invalidated by any modification of the section
+  std::optional<std::string_view> Get(PropertyId id) const;
+  bool Contains(PropertyId id) const {
+    return FindIndex(id).has_value();
+  }
+  // Set the value of |id|, appending it after the existing properties if not present
+  void Set(PropertyId id, std::string_view value);
+  // Remove |id|, return its value if it was present
+  std::optional<std::string> Extract(PropertyId id);
+
+  size_t size() const {
+    return properties_.size();
+  }
+  bool empty() const {
+    return properties_.empty();
+  }
+
+  // Call |visitor| with the id and value of each property, in insertion order
+  template <typename Visitor>
+  void ForEach(Visitor visitor) const {
+    for (const auto& property : properties_) {
+      visitor(property.id, ValueOf(property));
+    }
+  }
+
+ private:
+  struct Property {
+    PropertyId id;
+    uint32_t offset;
+    uint32_t size;
+  };
+
+  std::optional<size_t> FindIndex(PropertyId id) const;
+  std::string_view ValueOf(const Property& property) const {
+    return std::string_view(values_).substr(property.offset, property.size);
+  }
+
+  std::vector<Property> properties_;
+  // Values of |properties_|, in the same order
+  std::string values_;
+};
+
+}  // namespace storage
+}  // namespace bluetooth
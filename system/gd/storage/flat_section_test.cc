@@ -0,0 +1,114 @@
+/*
+ * Copyright 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "storage/flat_section.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace testing {
+
+using bluetooth::storage::FlatSection;
+using bluetooth::storage::PropertyId;
+using bluetooth::storage::PropertyNames;
+
+std::vector<std::pair<PropertyId, std::string>> Properties(const FlatSection& section) {
+  std::vector<std::pair<PropertyId, std::string>> properties;
+  section.ForEach(
+      [&properties](PropertyId id, std::string_view value) { properties.emplace_back(id, std::string(value)); });
+  return properties;
+}
+
+TEST(PropertyNamesTest, intern_test) {
+  PropertyNames names;
+  PropertyId a = names.Intern("A");
+  PropertyId b = names.Intern("B");
+  EXPECT_NE(a, b);
+  EXPECT_EQ(names.Intern("A"), a);
+  EXPECT_EQ(names.Name(a), "A");
+  EXPECT_EQ(names.Name(b), "B");
+  EXPECT_THAT(names.Find("B"), Optional(b));
+  EXPECT_FALSE(names.Find("C"));
+}
+
+TEST(PropertyNamesTest, names_survive_growth_test) {
+  PropertyNames names;
+  PropertyId first = names.Intern("first");
+  for (int i = 0; i < 1000; i++) {
+    names.Intern("name" + std::to_string(i));
+  }
+  EXPECT_THAT(names.Find("first"), Optional(first));
+  EXPECT_THAT(names.Find("name999"), Optional(names.Intern("name999")));
+  EXPECT_EQ(names.Name(first), "first");
+}
+
+TEST(FlatSectionTest, empty_test) {
+  FlatSection section;
+  EXPECT_TRUE(section.empty());
+  EXPECT_EQ(section.size(), 0u);
+  EXPECT_FALSE(section.Get(0));
+  EXPECT_FALSE(section.Contains(0));
+  EXPECT_FALSE(section.Extract(0));
+}
+
+TEST(FlatSectionTest, set_get_test) {
+  FlatSection section;
+  section.Set(1, "one");
+  section.Set(2, "");
+  section.Set(3, "three");
+  EXPECT_EQ(section.size(), 3u);
+  EXPECT_THAT(section.Get(1), Optional(Eq("one")));
+  EXPECT_THAT(section.Get(2), Optional(Eq("")));
+  EXPECT_THAT(section.Get(3), Optional(Eq("three")));
+  EXPECT_TRUE(section.Contains(2));
+  EXPECT_FALSE(section.Contains(4));
+}
+
+TEST(FlatSectionTest, overwrite_keeps_order_test) {
+  FlatSection section;
+  section.Set(1, "one");
+  section.Set(2, "two");
+  section.Set(3, "three");
+  // longer, shorter and same size values move the values after them
+  section.Set(1, "one hundred");
+  EXPECT_THAT(Properties(section), ElementsAre(Pair(1, "one hundred"), Pair(2, "two"), Pair(3, "three")));
+  section.Set(2, "");
+  EXPECT_THAT(Properties(section), ElementsAre(Pair(1, "one hundred"), Pair(2, ""), Pair(3, "three")));
+  section.Set(3, "THREE");
+  EXPECT_THAT(Properties(section), ElementsAre(Pair(1, "one hundred"), Pair(2, ""), Pair(3, "THREE")));
+}
+
+TEST(FlatSectionTest, extract_test) {
+  FlatSection section;
+  section.Set(1, "one");
+  section.Set(2, "two");
+  section.Set(3, "three");
+  EXPECT_THAT(section.Extract(2), Optional(StrEq("two")));
+  EXPECT_FALSE(section.Extract(2));
+  EXPECT_THAT(Properties(section), ElementsAre(Pair(1, "one"), Pair(3, "three")));
+  section.Set(2, "deux");
+  EXPECT_THAT(Properties(section), ElementsAre(Pair(1, "one"), Pair(3, "three"), Pair(2, "deux")));
+  EXPECT_THAT(section.Extract(1), Optional(StrEq("one")));
+  EXPECT_THAT(section.Extract(3), Optional(StrEq("three")));
+  EXPECT_THAT(section.Extract(2), Optional(StrEq("deux")));
+  EXPECT_TRUE(section.empty());
+}
+
+}  // namespace testing
@@ -23,6 +23,7 @@
 #include <utility>
 
 #include "common/bind.h"
+#include "common/strings.h"
 #include "metrics/counter_metrics.h"
 #include "os/alarm.h"
 #include "os/files.h"
@@ -30,6 +31,7 @@
 #include "os/parameter_provider.h"
 #include "os/system_properties.h"
 #include "storage/config_cache.h"
+#include "storage/config_journal.h"
 #include "storage/legacy_config_file.h"
 #include "storage/mutation.h"
 
@@ -49,6 +51,8 @@ static const std::chrono::milliseconds kDefaultConfigSaveDelay = std::chrono::mi
 // Writing a config to disk takes a minimum 10 ms on a decent x86_64 machine, and 20 ms if including backup file
 // The config saving delay must be bigger than this value to avoid overwhelming the disk
 static const std::chrono::milliseconds kMinConfigSaveDelay = std::chrono::milliseconds(20);
+// How often to log the number of bytes written to disk
+static const std::chrono::minutes kWriteStatisticsPeriod = std::chrono::minutes(60);
 
 const int kConfigFileComparePass = 1;
 const int kConfigBackupComparePass = 2;
@@ -59,6 +63,8 @@ const std::string StorageModule::kInfoSection = "Info";
 const std::string StorageModule::kFileSourceProperty = "FileSource";
 const std::string StorageModule::kTimeCreatedProperty = "TimeCreated";
 const std::string StorageModule::kTimeCreatedFormat = "%Y-%m-%d %H:%M:%S";
+// Incremented every time the config is written in full, see ConfigJournal
+const std::string StorageModule::kConfigGenerationProperty = "ConfigGeneration";
 
 const std::string StorageModule::kAdapterSection = "Adapter";
 
@@ -75,6 +81,8 @@ StorageModule::StorageModule(
       is_single_user_mode_(is_single_user_mode) {
   // e.g. "/data/misc/bluedroid/bt_config.conf" to "/data/misc/bluedroid/bt_config.bak"
   config_backup_path_ = config_file_path_.substr(0, config_file_path_.find_last_of('.')) + ".bak";
+  // e.g. "/data/misc/bluedroid/bt_config.conf" to "/data/misc/bluedroid/bt_config.journal"
+  config_journal_path_ = config_file_path_.substr(0, config_file_path_.find_last_of('.')) + ".journal";
   ASSERT_LOG(
       config_save_delay > kMinConfigSaveDelay,
       "Config save delay of %lld ms is not enough, must be at least %lld ms to avoid overwhelming the disk",
@@ -99,6 +107,19 @@ struct StorageModule::impl {
   ConfigCache cache_;
   ConfigCache memory_only_cache_;
   bool has_pending_config_save_ = false;
+  // Set when the whole config must be written on the next save, e.g. when it was not read from the config file alone
+  bool is_compaction_needed_ = false;
+  // Generation of the config last written in full, the journal only holds changes made since
+  uint64_t config_generation_ = 0;
+  // Size of the journal, and size of the config when it was last written in full
+  size_t journal_size_ = 0;
+  size_t config_size_ = 0;
+  // Bytes written to disk since |write_statistics_start_|, along with the bytes that rewriting the config and its
+  // backup on every save would have written
+  std::chrono::steady_clock::time_point write_statistics_start_ = std::chrono::steady_clock::now();
+  size_t journal_bytes_written_ = 0;
+  size_t config_bytes_written_ = 0;
+  size_t full_rewrite_bytes_ = 0;
 };
 
 Mutation StorageModule::Modify() {
@@ -112,7 +133,7 @@ void StorageModule::SaveDelayed() {
     return;
   }
   pimpl_->config_save_alarm_.Schedule(
-      common::BindOnce(&StorageModule::SaveImmediately, common::Unretained(this)), config_save_delay_);
+      common::BindOnce(&StorageModule::SaveChanges, common::Unretained(this)), config_save_delay_);
   pimpl_->has_pending_config_save_ = true;
 }
 
@@ -122,20 +143,84 @@ void StorageModule::SaveImmediately() {
     pimpl_->config_save_alarm_.Cancel();
     pimpl_->has_pending_config_save_ = false;
   }
-  // 1. rename old config to backup name
+  // Batches already in the journal belong to the previous generation, so they are not replayed on top of the config
+  // written below if the device crashes before the journal is deleted
+  pimpl_->config_generation_++;
+  pimpl_->cache_.SetProperty(kInfoSection, kConfigGenerationProperty, std::to_string(pimpl_->config_generation_));
+  // Changes recorded so far are part of the config written below
+  pimpl_->cache_.TakeRecordedChanges();
+  std::string serialized = pimpl_->cache_.SerializeToLegacyFormat();
+  // 1. rename old config to backup name, the journal applies to both of them
   if (os::FileExists(config_file_path_)) {
     ASSERT(os::RenameFile(config_file_path_, config_backup_path_));
   }
   // 2. write in-memory config to disk, if failed, backup can still be used
-  ASSERT(LegacyConfigFile::FromPath(config_file_path_).Write(pimpl_->cache_));
+  ASSERT(os::WriteToFile(config_file_path_, serialized));
   // 3. now write back up to disk as well
-  ASSERT(LegacyConfigFile::FromPath(config_backup_path_).Write(pimpl_->cache_));
+  ASSERT(os::WriteToFile(config_backup_path_, serialized));
   // 4. save checksum if it is running in common criteria mode
   if (bluetooth::os::ParameterProvider::GetBtKeystoreInterface() != nullptr &&
       bluetooth::os::ParameterProvider::IsCommonCriteriaMode()) {
     bluetooth::os::ParameterProvider::GetBtKeystoreInterface()->set_encrypt_key_or_remove_key(
         kConfigFilePrefix, kConfigFileHash);
   }
+  // 5. changes in the journal are in the config now. Until it is deleted, its batches are skipped because they belong
+  // to the previous generation
+  ConfigJournal::FromPath(config_journal_path_).Delete();
+  pimpl_->is_compaction_needed_ = false;
+  pimpl_->journal_size_ = 0;
+  pimpl_->config_size_ = serialized.size();
+  pimpl_->config_bytes_written_ += 2 * serialized.size();
+  pimpl_->full_rewrite_bytes_ += 2 * serialized.size();
+  LogWriteStatistics();
+}
+
+void StorageModule::SaveChanges() {
+  std::lock_guard<std::recursive_mutex> lock(mutex_);
+  pimpl_->has_pending_config_save_ = false;
+  auto changes = pimpl_->cache_.TakeRecordedChanges();
+  // The checksum saved in common criteria mode only covers the config file, so the journal cannot be used
+  bool is_common_criteria_mode = bluetooth::os::ParameterProvider::GetBtKeystoreInterface() != nullptr &&
+                                 bluetooth::os::ParameterProvider::IsCommonCriteriaMode();
+  // Compact the journal once it is bigger than the config, so that the config files are rewritten at most once per
+  // config size worth of changes and replaying the journal stays cheap
+  if (!changes || pimpl_->is_compaction_needed_ || is_common_criteria_mode ||
+      pimpl_->journal_size_ >= pimpl_->config_size_) {
+    SaveImmediately();
+    return;
+  }
+  if (changes->empty()) {
+    return;
+  }
+  auto bytes_written = ConfigJournal::FromPath(config_journal_path_).Append(*changes, pimpl_->config_generation_);
+  if (!bytes_written) {
+    // Changes that are not in the journal must be saved in the config file
+    SaveImmediately();
+    return;
+  }
+  pimpl_->journal_size_ += *bytes_written;
+  pimpl_->journal_bytes_written_ += *bytes_written;
+  pimpl_->full_rewrite_bytes_ += 2 * pimpl_->config_size_;
+  LogWriteStatistics();
+}
+
+void StorageModule::LogWriteStatistics() {
+  auto now = std::chrono::steady_clock::now();
+  if (now - pimpl_->write_statistics_start_ < kWriteStatisticsPeriod) {
+    return;
+  }
+  LOG_INFO(
+      "wrote %zu bytes to the config journal and %zu bytes to the config files in the last %lld minutes, rewriting "
+      "the config files on every save would have written %zu bytes",
+      pimpl_->journal_bytes_written_,
+      pimpl_->config_bytes_written_,
+      static_cast<long long>(
+          std::chrono::duration_cast<std::chrono::minutes>(now - pimpl_->write_statistics_start_).count()),
+      pimpl_->full_rewrite_bytes_);
+  pimpl_->write_statistics_start_ = now;
+  pimpl_->journal_bytes_written_ = 0;
+  pimpl_->config_bytes_written_ = 0;
+  pimpl_->full_rewrite_bytes_ = 0;
 }
 
 void StorageModule::Clear() {
@@ -154,6 +239,7 @@ void StorageModule::Start() {
     LOG_INFO("%s is true, delete config files", kFactoryResetProperty.c_str());
     LegacyConfigFile::FromPath(config_file_path_).Delete();
     LegacyConfigFile::FromPath(config_backup_path_).Delete();
+    ConfigJournal::FromPath(config_journal_path_).Delete();
     os::SetSystemProperty(kFactoryResetProperty, "false");
   }
   if (!is_config_checksum_pass(kConfigFileComparePass)) {
@@ -171,14 +257,27 @@ void StorageModule::Start() {
     // Make sure to update the file, since it wasn't read from the config_file_path_
     save_needed = true;
   }
+  uint64_t config_generation = 0;
   if (!config || !config->HasSection(kAdapterSection)) {
     LOG_WARN("cannot load backup config at %s; creating new empty ones", config_backup_path_.c_str());
     config.emplace(temp_devices_capacity_, Device::kLinkKeyProperties);
     file_source = "Empty";
+  } else {
+    auto generation = config->GetProperty(kInfoSection, kConfigGenerationProperty);
+    config_generation = generation ? common::Uint64FromString(*generation).value_or(0) : 0;
+    ConfigJournal::FromPath(config_journal_path_).Replay(*config, config_generation);
+  }
+  if (os::FileExists(config_journal_path_)) {
+    // Fold the changes saved since the config was last written in full into the config file, and delete the journal
+    // before anything is appended to it. A batch torn by a crash may be left at its end, new batches would follow it
+    // and be lost on the next replay
+    save_needed = true;
   }
   if (!file_source.empty()) {
     config->SetProperty(kInfoSection, kFileSourceProperty, std::move(file_source));
   }
+  // Changes from now on can be saved to the journal
+  config->EnableChangeRecording();
   // Cleanup temporary pairings if we have left guest mode
   if (!is_restricted_mode_) {
     config->RemoveSectionWithProperty("Restricted");
@@ -195,9 +294,13 @@ void StorageModule::Start() {
   config->FixDeviceTypeInconsistencies();
   // TODO (b/158035889) Migrate metrics module to GD
   pimpl_ = std::make_unique<impl>(GetHandler(), std::move(config.value()), temp_devices_capacity_);
+  pimpl_->config_generation_ = config_generation;
   if (save_needed) {
     // Set a timer and write the new config file to disk.
+    pimpl_->is_compaction_needed_ = true;
     SaveDelayed();
+  } else {
+    pimpl_->config_size_ = pimpl_->cache_.SerializeToLegacyFormat().size();
   }
   pimpl_->cache_.SetPersistentConfigChangedCallback(
       [this] { this->CallOn(this, &StorageModule::SaveDelayed); });
@@ -208,8 +311,8 @@ void StorageModule::Start() {
 
 void StorageModule::Stop() {
   std::lock_guard<std::recursive_mutex> lock(mutex_);
-  if (pimpl_->has_pending_config_save_) {
-    // Save pending changes before stopping the module.
+  if (pimpl_->has_pending_config_save_ || pimpl_->journal_size_ > 0) {
+    // Save pending changes and compact the journal before stopping the module.
     SaveImmediately();
   }
   if (bluetooth::os::ParameterProvider::GetBtKeystoreInterface() != nullptr) {
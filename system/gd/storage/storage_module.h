@@ -51,6 +51,7 @@ class StorageModule : public bluetooth::Module {
   static const std::string kFileSourceProperty;
   static const std::string kTimeCreatedProperty;
   static const std::string kTimeCreatedFormat;
+  static const std::string kConfigGenerationProperty;
 
   static const std::string kAdapterSection;
 
@@ -125,15 +126,18 @@ class StorageModule : public bluetooth::Module {
   ConfigCache* GetMemoryOnlyConfigCache();
   // Normally, underlying config will be saved at most 3 seconds after the first config change in a series of changes
   // This method triggers the delayed saving automatically, the delay is equal to |config_save_delay_|
+  // Changes are appended to a journal next to the config file, which is compacted into the config file once it gets
+  // bigger than the config itself, see SaveChanges()
   void SaveDelayed();
   // In some cases, one may want to save the config immediately to disk. Call this method with caution as it runs
-  // immediately on the calling thread
+  // immediately on the calling thread. This rewrites the whole config file and its backup, and removes the journal
   void SaveImmediately();
   // remove all content in this config cache, restore it to the state after the explicit constructor
   void Clear();
 
   // Create the storage module where:
-  // - config_file_path is the path to the config file on disk, a .bak file will be created with the original
+  // - config_file_path is the path to the config file on disk, a .bak file will be created with the original, and a
+  //   .journal file will be created for the changes made since then
   // - config_save_delay is the duration after which to dump config to disk after SaveDelayed() is called
   // - temp_devices_capacity is the number of temporary, typically unpaired devices to hold in a memory based LRU
   // - is_restricted_mode and is_single_user_mode are flags from upper layer
@@ -176,10 +180,15 @@ class StorageModule : public bluetooth::Module {
 
  private:
   struct impl;
+  // Append changes made since the last save to the journal, or compact the journal into the config file
+  void SaveChanges();
+  void LogWriteStatistics();
+
   mutable std::recursive_mutex mutex_;
   std::unique_ptr<impl> pimpl_;
   std::string config_file_path_;
   std::string config_backup_path_;
+  std::string config_journal_path_;
   std::chrono::milliseconds config_save_delay_;
   size_t temp_devices_capacity_;
   bool is_restricted_mode_;
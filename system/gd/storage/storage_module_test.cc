@@ -31,6 +31,7 @@
 #include "os/fake_timer/fake_timerfd.h"
 #include "os/files.h"
 #include "storage/config_cache.h"
+#include "storage/config_journal.h"
 #include "storage/device.h"
 #include "storage/legacy_config_file.h"
 
@@ -40,6 +41,7 @@ using bluetooth::TestModuleRegistry;
 using bluetooth::hci::Address;
 using bluetooth::os::fake_timer::fake_timerfd_advance;
 using bluetooth::storage::ConfigCache;
+using bluetooth::storage::ConfigJournal;
 using bluetooth::storage::Device;
 using bluetooth::storage::LegacyConfigFile;
 using bluetooth::storage::StorageModule;
@@ -107,9 +109,11 @@ class StorageModuleTest : public Test {
     temp_dir_ = std::filesystem::temp_directory_path();
     temp_config_ = temp_dir_ / "temp_config.txt";
     temp_backup_config_ = temp_dir_ / "temp_config.bak";
+    temp_journal_ = temp_dir_ / "temp_config.journal";
     DeleteConfigFiles();
     ASSERT_FALSE(std::filesystem::exists(temp_config_));
     ASSERT_FALSE(std::filesystem::exists(temp_backup_config_));
+    ASSERT_FALSE(std::filesystem::exists(temp_journal_));
   }
 
   void TearDown() override {
@@ -124,6 +128,20 @@ class StorageModuleTest : public Test {
     if (std::filesystem::exists(temp_backup_config_)) {
       ASSERT_TRUE(std::filesystem::remove(temp_backup_config_));
     }
+    if (std::filesystem::exists(temp_journal_)) {
+      ASSERT_TRUE(std::filesystem::remove(temp_journal_));
+    }
+  }
+
+  // Read the config as the storage module would after a crash, from the config file and the journal
+  std::optional<ConfigCache> ReadConfigAndJournal() {
+    auto config = LegacyConfigFile::FromPath(temp_config_.string()).Read(kTestTempDevicesCapacity);
+    if (config) {
+      auto generation = config->GetProperty(StorageModule::kInfoSection, StorageModule::kConfigGenerationProperty);
+      ConfigJournal::FromPath(temp_journal_.string())
+          .Replay(*config, generation ? std::stoull(*generation) : 0);
+    }
+    return config;
   }
 
   void FakeTimerAdvance(std::chrono::milliseconds time) {
@@ -146,6 +164,7 @@ class StorageModuleTest : public Test {
   std::filesystem::path temp_dir_;
   std::filesystem::path temp_config_;
   std::filesystem::path temp_backup_config_;
+  std::filesystem::path temp_journal_;
 };
 
 TEST_F(StorageModuleTest, empty_config_no_op_test) {
@@ -234,7 +253,7 @@ TEST_F(StorageModuleTest, save_config_test) {
   ASSERT_THAT(storage->GetPropertyPublic("01:02:03:ab:cd:ea", "name"), Optional(StrEq("foo")));
   ASSERT_TRUE(WaitForReactorIdle(kTestConfigSaveDelay));
 
-  auto config = LegacyConfigFile::FromPath(temp_config_.string()).Read(kTestTempDevicesCapacity);
+  auto config = ReadConfigAndJournal();
   ASSERT_TRUE(config);
   ASSERT_THAT(config->GetProperty("01:02:03:ab:cd:ea", "name"), Optional(StrEq("foo")));
 
@@ -242,7 +261,7 @@ TEST_F(StorageModuleTest, save_config_test) {
   storage->RemovePropertyPublic("01:02:03:ab:cd:ea", "name");
   ASSERT_TRUE(WaitForReactorIdle(kTestConfigSaveDelay));
   LOG_INFO("After waiting 2");
-  config = LegacyConfigFile::FromPath(temp_config_.string()).Read(kTestTempDevicesCapacity);
+  config = ReadConfigAndJournal();
   ASSERT_TRUE(config);
   ASSERT_FALSE(config->HasProperty("01:02:03:ab:cd:ea", "name"));
 
@@ -250,7 +269,7 @@ TEST_F(StorageModuleTest, save_config_test) {
   storage->RemoveSectionPublic("01:02:03:ab:cd:ea");
   ASSERT_TRUE(WaitForReactorIdle(kTestConfigSaveDelay));
   LOG_INFO("After waiting 3");
-  config = LegacyConfigFile::FromPath(temp_config_.string()).Read(kTestTempDevicesCapacity);
+  config = ReadConfigAndJournal();
   ASSERT_TRUE(config);
   ASSERT_FALSE(config->HasSection("01:02:03:ab:cd:ea"));
 
@@ -259,6 +278,11 @@ TEST_F(StorageModuleTest, save_config_test) {
 
   // Verify states after test
   ASSERT_TRUE(std::filesystem::exists(temp_config_));
+  // Journal is compacted into the config file on stop
+  ASSERT_FALSE(std::filesystem::exists(temp_journal_));
+  config = LegacyConfigFile::FromPath(temp_config_.string()).Read(kTestTempDevicesCapacity);
+  ASSERT_TRUE(config);
+  ASSERT_FALSE(config->HasSection("01:02:03:ab:cd:ea"));
 }
 
 TEST_F(StorageModuleTest, get_bonded_devices_test) {
@@ -331,4 +355,148 @@ TEST_F(StorageModuleTest, no_config_causes_a_write) {
   ASSERT_TRUE(std::filesystem::exists(temp_config_));
 }
 
-}  // namespace testing
\ No newline at end of file
+TEST_F(StorageModuleTest, changes_are_saved_to_journal) {
+  // Prepare config file
+  ASSERT_TRUE(bluetooth::os::WriteToFile(temp_config_.string(), kReadTestConfig));
+
+  // Set up
+  auto* storage = new TestStorageModule(temp_config_.string(), kTestConfigSaveDelay, false, false);
+  test_registry_.InjectTestModule(&StorageModule::Factory, storage);
+
+  // Change a property
+  storage->SetPropertyPublic("01:02:03:ab:cd:ea", "name", "foo");
+  ASSERT_TRUE(WaitForReactorIdle(kTestConfigSaveDelay));
+
+  // Config file is left untouched, the change is in the journal along with the DevType fixed when loading the config
+  ASSERT_THAT(bluetooth::os::ReadSmallFile(temp_config_.string()), Optional(StrEq(kReadTestConfig)));
+  ASSERT_FALSE(std::filesystem::exists(temp_backup_config_));
+  ASSERT_THAT(
+      bluetooth::os::ReadSmallFile(temp_journal_.string()),
+      Optional(StrEq("set\t01:02:03:ab:cd:ea\tDevType\t1\n"
+                     "set\t01:02:03:ab:cd:ea\tname\tfoo\n"
+                     "commit\n")));
+
+  // Tear down
+  test_registry_.StopAll();
+}
+
+TEST_F(StorageModuleTest, journal_is_compacted_when_bigger_than_config) {
+  // Prepare config file
+  ASSERT_TRUE(bluetooth::os::WriteToFile(temp_config_.string(), kReadTestConfig));
+
+  // Set up
+  auto* storage = new TestStorageModule(temp_config_.string(), kTestConfigSaveDelay, false, false);
+  test_registry_.InjectTestModule(&StorageModule::Factory, storage);
+
+  // Each save appends about 50 bytes to the journal, the config is about 600 bytes
+  for (int i = 0; i < 20; i++) {
+    storage->SetPropertyPublic("01:02:03:ab:cd:ea", "name", "foo" + std::to_string(i));
+    ASSERT_TRUE(WaitForReactorIdle(kTestConfigSaveDelay));
+    auto journal_size = std::filesystem::exists(temp_journal_) ? std::filesystem::file_size(temp_journal_) : 0;
+    ASSERT_LE(journal_size, kReadTestConfig.size() + 128);
+  }
+
+  // Config file was compacted at least once
+  auto config = LegacyConfigFile::FromPath(temp_config_.string()).Read(kTestTempDevicesCapacity);
+  ASSERT_TRUE(config);
+  ASSERT_THAT(config->GetProperty("01:02:03:ab:cd:ea", "name"), Optional(StrNe("hello world")));
+  ASSERT_TRUE(std::filesystem::exists(temp_backup_config_));
+  config = ReadConfigAndJournal();
+  ASSERT_TRUE(config);
+  ASSERT_THAT(config->GetProperty("01:02:03:ab:cd:ea", "name"), Optional(StrEq("foo19")));
+
+  // Tear down
+  test_registry_.StopAll();
+}
+
+TEST_F(StorageModuleTest, journal_is_replayed_on_start) {
+  // Prepare config file and the journal left by a crash, with a batch that was not fully written
+  ASSERT_TRUE(bluetooth::os::WriteToFile(temp_config_.string(), kReadTestConfig));
+  ASSERT_TRUE(bluetooth::os::AppendToFile(
+      temp_journal_.string(),
+      "set\t01:02:03:ab:cd:ea\tname\tfoo\ncommit\n"
+      "set\t01:02:03:ab:cd:eb\tLinkKey\tfedcba0987654321fedcba0987654329\ncommit\n"
+      "remove_section\t01:02:03:ab:cd:ea\n"));
+
+  // Set up
+  auto* storage = new TestStorageModule(temp_config_.string(), kTestConfigSaveDelay, false, false);
+  test_registry_.InjectTestModule(&StorageModule::Factory, storage);
+
+  ASSERT_THAT(storage->GetPropertyPublic("01:02:03:ab:cd:ea", "name"), Optional(StrEq("foo")));
+  ASSERT_THAT(storage->GetPersistentSectionsPublic(), ElementsAre("01:02:03:ab:cd:ea", "01:02:03:ab:cd:eb"));
+
+  // Replayed journal is compacted into the config file
+  ASSERT_TRUE(WaitForReactorIdle(kTestConfigSaveDelay));
+  ASSERT_FALSE(std::filesystem::exists(temp_journal_));
+  auto config = LegacyConfigFile::FromPath(temp_config_.string()).Read(kTestTempDevicesCapacity);
+  ASSERT_TRUE(config);
+  ASSERT_THAT(config->GetProperty("01:02:03:ab:cd:ea", "name"), Optional(StrEq("foo")));
+  ASSERT_TRUE(config->HasSection("01:02:03:ab:cd:eb"));
+
+  // Tear down
+  test_registry_.StopAll();
+}
+
+TEST_F(StorageModuleTest, journal_with_torn_batch_is_compacted_before_appending) {
+  // Prepare config file and the journal left by a crash, with only a batch that was not fully written
+  ASSERT_TRUE(bluetooth::os::WriteToFile(temp_config_.string(), kReadTestConfig));
+  ASSERT_TRUE(bluetooth::os::AppendToFile(
+      temp_journal_.string(), "remove_section\t01:02:03:ab:cd:ea\nset\t01:02:03:ab:cd:eb\tLinkKey\tfedcba"));
+
+  // Set up
+  auto* storage = new TestStorageModule(temp_config_.string(), kTestConfigSaveDelay, false, false);
+  test_registry_.InjectTestModule(&StorageModule::Factory, storage);
+  ASSERT_TRUE(WaitForReactorIdle(kTestConfigSaveDelay));
+  ASSERT_FALSE(std::filesystem::exists(temp_journal_));
+
+  // New batches start a new journal instead of following the torn batch
+  storage->SetPropertyPublic("01:02:03:ab:cd:ea", "name", "foo");
+  ASSERT_TRUE(WaitForReactorIdle(kTestConfigSaveDelay));
+  ASSERT_THAT(
+      bluetooth::os::ReadSmallFile(temp_journal_.string()),
+      Optional(StrEq("generation\t1\n"
+                     "set\t01:02:03:ab:cd:ea\tname\tfoo\n"
+                     "commit\n")));
+  auto config = ReadConfigAndJournal();
+  ASSERT_TRUE(config);
+  ASSERT_THAT(config->GetProperty("01:02:03:ab:cd:ea", "name"), Optional(StrEq("foo")));
+  ASSERT_THAT(
+      config->GetProperty("01:02:03:ab:cd:ea", "LinkKey"), Optional(StrEq("fedcba0987654321fedcba0987654328")));
+  ASSERT_FALSE(config->HasSection("01:02:03:ab:cd:eb"));
+
+  // Tear down
+  test_registry_.StopAll();
+}
+
+TEST_F(StorageModuleTest, stale_journal_is_not_replayed_after_compaction) {
+  // Prepare config file
+  ASSERT_TRUE(bluetooth::os::WriteToFile(temp_config_.string(), kReadTestConfig));
+
+  auto* storage = new TestStorageModule(temp_config_.string(), kTestConfigSaveDelay, false, false);
+  test_registry_.InjectTestModule(&StorageModule::Factory, storage);
+  storage->SetPropertyPublic("01:02:03:ab:cd:ea", "name", "foo");
+  ASSERT_TRUE(WaitForReactorIdle(kTestConfigSaveDelay));
+  auto journal = bluetooth::os::ReadSmallFile(temp_journal_.string());
+  ASSERT_TRUE(journal);
+
+  // Not in the journal, the config is written in full on stop
+  storage->SetPropertyPublic("01:02:03:ab:cd:ea", "name", "bar");
+  test_registry_.StopAll();
+  ASSERT_FALSE(std::filesystem::exists(temp_journal_));
+  auto config = LegacyConfigFile::FromPath(temp_config_.string()).Read(kTestTempDevicesCapacity);
+  ASSERT_TRUE(config);
+  ASSERT_THAT(
+      config->GetProperty(StorageModule::kInfoSection, StorageModule::kConfigGenerationProperty),
+      Optional(StrEq("1")));
+
+  // As if the device crashed after writing the config, before deleting the journal
+  ASSERT_TRUE(bluetooth::os::WriteToFile(temp_journal_.string(), *journal));
+  storage = new TestStorageModule(temp_config_.string(), kTestConfigSaveDelay, false, false);
+  test_registry_.InjectTestModule(&StorageModule::Factory, storage);
+  ASSERT_THAT(storage->GetPropertyPublic("01:02:03:ab:cd:ea", "name"), Optional(StrEq("bar")));
+
+  // Tear down
+  test_registry_.StopAll();
+}
+
+}  // namespace testing
@@ -1029,6 +1029,24 @@ struct shim::legacy::Acl::impl {
         subrate_min, subrate_max, max_latency, cont_num, sup_tout);
   }
 
+  void SetTxLatencyClass(HciHandle handle,
+                         tBTM_ACL_TX_LATENCY_CLASS latency_class) {
+    hci::acl_manager::LatencyClass gd_latency_class;
+    switch (latency_class) {
+      case BTM_ACL_TX_ISOCHRONOUS_ADJACENT:
+        gd_latency_class = hci::acl_manager::LatencyClass::ISOCHRONOUS_ADJACENT;
+        break;
+      case BTM_ACL_TX_INTERACTIVE:
+        gd_latency_class = hci::acl_manager::LatencyClass::INTERACTIVE;
+        break;
+      default:
+        gd_latency_class = hci::acl_manager::LatencyClass::BULK;
+        break;
+    }
+    GetAclManager()->SetAclTxSchedulingParameters(handle, gd_latency_class,
+                                                  /* weight */ 1);
+  }
+
   void SetConnectionEncryption(HciHandle handle, hci::Enable enable) {
     ASSERT_LOG(IsClassicAcl(handle), "handle %d is not a classic connection",
                handle);
@@ -1833,6 +1851,12 @@ void shim::legacy::Acl::LeSubrateRequest(uint16_t hci_handle,
                    subrate_min, subrate_max, max_latency, cont_num, sup_tout);
 }
 
+void shim::legacy::Acl::SetTxLatencyClass(
+    uint16_t hci_handle, tBTM_ACL_TX_LATENCY_CLASS latency_class) {
+  handler_->CallOn(pimpl_.get(), &Acl::impl::SetTxLatencyClass, hci_handle,
+                   latency_class);
+}
+
 void shim::legacy::Acl::DumpConnectionHistory(int fd) const {
   pimpl_->DumpConnectionHistory(fd);
 }
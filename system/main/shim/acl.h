@@ -30,6 +30,7 @@
 #include "main/shim/link_connection_interface.h"
 #include "main/shim/link_policy_interface.h"
 #include "stack/include/bt_types.h"
+#include "stack/include/btm_api_types.h"
 #include "types/raw_address.h"
 
 using LeRandCallback = base::Callback<void(uint64_t)>;
@@ -111,6 +112,8 @@ class Acl : public hci::acl_manager::ConnectionCallbacks,
   void LeSubrateRequest(uint16_t hci_handle, uint16_t subrate_min,
                         uint16_t subrate_max, uint16_t max_latency,
                         uint16_t cont_num, uint16_t sup_tout);
+  void SetTxLatencyClass(uint16_t hci_handle,
+                         tBTM_ACL_TX_LATENCY_CLASS latency_class);
 
   void WriteData(uint16_t hci_handle,
                  std::unique_ptr<packet::RawBuilder> packet);
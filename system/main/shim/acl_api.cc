@@ -159,6 +159,11 @@ void bluetooth::shim::ACL_LeSubrateRequest(
       hci_handle, subrate_min, subrate_max, max_latency, cont_num, sup_tout);
 }
 
+void bluetooth::shim::ACL_SetTxLatencyClass(
+    uint16_t hci_handle, tBTM_ACL_TX_LATENCY_CLASS latency_class) {
+  Stack::GetInstance()->GetAcl()->SetTxLatencyClass(hci_handle, latency_class);
+}
+
 void bluetooth::shim::ACL_RemoteNameRequest(const RawAddress& addr,
                                             uint8_t page_scan_rep_mode,
                                             uint8_t page_scan_mode,
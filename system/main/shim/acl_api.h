@@ -20,6 +20,7 @@
 
 #include "stack/include/bt_hdr.h"
 #include "stack/include/bt_types.h"
+#include "stack/include/btm_api_types.h"
 #include "stack/include/hci_error_code.h"
 #include "types/ble_address_with_type.h"
 #include "types/raw_address.h"
@@ -59,6 +60,8 @@ void ACL_LeSetDefaultSubrate(uint16_t subrate_min, uint16_t subrate_max,
 void ACL_LeSubrateRequest(uint16_t hci_handle, uint16_t subrate_min,
                           uint16_t subrate_max, uint16_t max_latency,
                           uint16_t cont_num, uint16_t sup_tout);
+void ACL_SetTxLatencyClass(uint16_t hci_handle,
+                           tBTM_ACL_TX_LATENCY_CLASS latency_class);
 
 void ACL_RemoteNameRequest(const RawAddress& bd_addr,
                            uint8_t page_scan_rep_mode, uint8_t page_scan_mode,
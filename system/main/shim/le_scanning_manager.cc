@@ -24,6 +24,7 @@
 #include <hardware/bluetooth.h>
 #include <stdio.h>
 
+#include <algorithm>
 #include <unordered_set>
 
 #include "advertise_data_parser.h"
@@ -38,6 +39,7 @@
 #include "main/shim/helpers.h"
 #include "main/shim/le_scanning_manager.h"
 #include "main/shim/shim.h"
+#include "os/system_properties.h"
 #include "stack/btm/btm_int_types.h"
 #include "stack/include/btm_log_history.h"
 #include "storage/device.h"
@@ -62,6 +64,12 @@ constexpr uint8_t kFilterLogicAnd = 0x01;
 constexpr uint8_t kLowestRssiValue = 129;
 constexpr uint16_t kAllowAllFilter = 0x00;
 constexpr uint16_t kListLogicOr = 0x01;
+// Report deduplication of the scanners, which the Java layer doesn't configure.
+// A zero interval, the default, disables it.
+constexpr char kScanDeduplicationIntervalProperty[] =
+    "bluetooth.core.le.scan_deduplication_interval_ms";
+constexpr char kScanDeduplicationRssiThresholdProperty[] =
+    "bluetooth.core.le.scan_deduplication_rssi_threshold";
 
 class DefaultScanningCallback : public ::ScanningCallbacks {
   void OnScannerRegistered(const bluetooth::Uuid app_uuid, uint8_t scanner_id,
@@ -523,6 +531,20 @@ void BleScannerInterfaceImpl::RegisterCallbacks(ScanningCallbacks* callbacks) {
 void BleScannerInterfaceImpl::OnScannerRegistered(
     const bluetooth::hci::Uuid app_uuid, bluetooth::hci::ScannerId scanner_id,
     ScanningStatus status) {
+  if (status == ScanningStatus::SUCCESS) {
+    static const uint32_t deduplication_interval_ms =
+        bluetooth::os::GetSystemPropertyUint32(
+            kScanDeduplicationIntervalProperty, 0);
+    static const uint8_t deduplication_rssi_threshold =
+        std::min<uint32_t>(bluetooth::os::GetSystemPropertyUint32(
+                               kScanDeduplicationRssiThresholdProperty, 0),
+                           UINT8_MAX);
+    if (deduplication_interval_ms > 0) {
+      bluetooth::shim::GetScanning()->SetScanDeduplicationParameters(
+          scanner_id, deduplication_interval_ms, deduplication_rssi_threshold);
+    }
+  }
+
   auto uuid = bluetooth::Uuid::From128BitBE(app_uuid.To128BitBE());
   do_in_jni_thread(FROM_HERE,
                    base::Bind(&ScanningCallbacks::OnScannerRegistered,
@@ -15,12 +15,15 @@
 //   empty sections.
 // - Duplicate keys in a section will overwrite previous values.
 // - All strings are case sensitive.
+// - Sections and keys are kept in insertion order, and indexed by name for
+//   O(1) lookups.
 
 #include <stdbool.h>
-#include <list>
 #include <memory>
 #include <string>
 
+#include "osi/include/indexed_list.h"
+
 // The default section name to use if a key/value pair is not defined within
 // a section.
 #define CONFIG_DEFAULT_SECTION "Global"
@@ -32,15 +35,16 @@ struct entry_t {
 
 struct section_t {
   std::string name;
-  std::list<entry_t> entries;
+  indexed_list<entry_t, &entry_t::key> entries;
   void Set(std::string key, std::string value);
-  std::list<entry_t>::iterator Find(const std::string& key);
+  indexed_list<entry_t, &entry_t::key>::iterator Find(const std::string& key);
   bool Has(const std::string& key);
 };
 
 struct config_t {
-  std::list<section_t> sections;
-  std::list<section_t>::iterator Find(const std::string& section);
+  indexed_list<section_t, &section_t::name> sections;
+  indexed_list<section_t, &section_t::name>::iterator Find(
+      const std::string& section);
   bool Has(const std::string& section);
 };
 
@@ -0,0 +1,158 @@
+/*
+ *  Copyright 2023 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#pragma once
+
+#include <initializer_list>
+#include <list>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+
+// A std::list of |T| that is also indexed by the std::string member |Key| of
+// its elements. Iteration follows insertion order like the plain list, so
+// that files saved from it are deterministic, while find() is O(1).
+//
+// Implementation notes:
+// - The index refers to the keys stored in the list nodes, so the |Key| of an
+//   element must not be modified once it is in the list.
+// - Elements with duplicate keys are allowed; find() returns the first one,
+//   like a linear search would.
+template <typename T, std::string T::*Key>
+class indexed_list {
+ public:
+  using value_type = T;
+  using size_type = typename std::list<T>::size_type;
+  using reference = T&;
+  using const_reference = const T&;
+  using iterator = typename std::list<T>::iterator;
+  using const_iterator = typename std::list<T>::const_iterator;
+
+  indexed_list() = default;
+
+  indexed_list(std::initializer_list<T> init) {
+    for (const T& value : init) push_back(value);
+  }
+
+  indexed_list(const indexed_list& other) : list_(other.list_) { reindex(); }
+
+  // Moving a std::list keeps its nodes, so the index stays valid
+  indexed_list(indexed_list&& other) noexcept
+      : list_(std::move(other.list_)), index_(std::move(other.index_)) {
+    other.clear();
+  }
+
+  indexed_list& operator=(const indexed_list& other) {
+    if (this != &other) {
+      list_ = other.list_;
+      reindex();
+    }
+    return *this;
+  }
+
+  indexed_list& operator=(indexed_list&& other) noexcept {
+    if (this != &other) {
+      list_ = std::move(other.list_);
+      index_ = std::move(other.index_);
+      other.clear();
+    }
+    return *this;
+  }
+
+  iterator begin() { return list_.begin(); }
+  const_iterator begin() const { return list_.begin(); }
+  const_iterator cbegin() const { return list_.cbegin(); }
+  iterator end() { return list_.end(); }
+  const_iterator end() const { return list_.end(); }
+  const_iterator cend() const { return list_.cend(); }
+
+  bool empty() const { return list_.empty(); }
+  size_type size() const { return list_.size(); }
+
+  reference front() { return list_.front(); }
+  const_reference front() const { return list_.front(); }
+  reference back() { return list_.back(); }
+  const_reference back() const { return list_.back(); }
+
+  iterator find(const std::string& key) {
+    auto it = index_.find(key);
+    return it == index_.end() ? list_.end() : it->second;
+  }
+
+  const_iterator find(const std::string& key) const {
+    auto it = index_.find(key);
+    return it == index_.end() ? list_.end() : const_iterator(it->second);
+  }
+
+  void push_back(const T& value) { emplace_back(value); }
+  void push_back(T&& value) { emplace_back(std::move(value)); }
+
+  template <typename... Args>
+  reference emplace_back(Args&&... args) {
+    list_.emplace_back(std::forward<Args>(args)...);
+    iterator it = std::prev(list_.end());
+    index_.emplace(key_of(*it), it);
+    return *it;
+  }
+
+  iterator erase(const_iterator pos) {
+    unindex(pos);
+    return list_.erase(pos);
+  }
+
+  void pop_front() { erase(list_.begin()); }
+
+  void clear() {
+    index_.clear();
+    list_.clear();
+  }
+
+  // Sorting relinks the nodes without moving them, the index stays valid
+  template <typename Compare>
+  void sort(Compare comp) {
+    list_.sort(comp);
+  }
+
+ private:
+  static const std::string& key_of(const T& value) { return value.*Key; }
+
+  void reindex() {
+    index_.clear();
+    for (iterator it = list_.begin(); it != list_.end(); ++it) {
+      index_.emplace(key_of(*it), it);
+    }
+  }
+
+  void unindex(const_iterator pos) {
+    const std::string& key = key_of(*pos);
+    auto it = index_.find(key);
+    if (it == index_.end() || it->second != pos) return;
+    index_.erase(it);
+    // Only happens if elements share a key, fall back to the next one
+    if (index_.size() + 1 < list_.size()) {
+      for (iterator other = list_.begin(); other != list_.end(); ++other) {
+        if (other != pos && key_of(*other) == key) {
+          index_.emplace(key_of(*other), other);
+          break;
+        }
+      }
+    }
+  }
+
+  std::list<T> list_;
+  std::unordered_map<std::string_view, iterator> index_;
+};
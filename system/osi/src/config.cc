@@ -31,37 +31,33 @@
 #include <sys/stat.h>
 #include <unistd.h>
 
-#include <sstream>
 #include <type_traits>
 
 #include "check.h"
 
 void section_t::Set(std::string key, std::string value) {
-  for (entry_t& entry : entries) {
-    if (entry.key == key) {
-      entry.value = value;
-      return;
-    }
+  auto entry = entries.find(key);
+  if (entry != entries.end()) {
+    entry->value = std::move(value);
+    return;
   }
   // add a new key to the section
   entries.emplace_back(
       entry_t{.key = std::move(key), .value = std::move(value)});
 }
 
-std::list<entry_t>::iterator section_t::Find(const std::string& key) {
-  return std::find_if(
-      entries.begin(), entries.end(),
-      [&key](const entry_t& entry) { return entry.key == key; });
+indexed_list<entry_t, &entry_t::key>::iterator section_t::Find(
+    const std::string& key) {
+  return entries.find(key);
 }
 
 bool section_t::Has(const std::string& key) {
   return Find(key) != entries.end();
 }
 
-std::list<section_t>::iterator config_t::Find(const std::string& section) {
-  return std::find_if(
-      sections.begin(), sections.end(),
-      [&section](const section_t& sec) { return sec.name == section; });
+indexed_list<section_t, &section_t::name>::iterator config_t::Find(
+    const std::string& section) {
+  return sections.find(section);
 }
 
 bool config_t::Has(const std::string& key) {
@@ -74,9 +70,7 @@ template <typename T,
           class = typename std::enable_if<std::is_same<
               config_t, typename std::remove_const<T>::type>::value>>
 static auto section_find(T& config, const std::string& section) {
-  return std::find_if(
-      config.sections.begin(), config.sections.end(),
-      [&section](const section_t& sec) { return sec.name == section; });
+  return config.sections.find(section);
 }
 
 static const entry_t* entry_find(const config_t& config,
@@ -85,11 +79,10 @@ static const entry_t* entry_find(const config_t& config,
   auto sec = section_find(config, section);
   if (sec == config.sections.end()) return nullptr;
 
-  for (const entry_t& entry : sec->entries) {
-    if (entry.key == key) return &entry;
-  }
+  auto entry = sec->entries.find(key);
+  if (entry == sec->entries.end()) return nullptr;
 
-  return nullptr;
+  return &*entry;
 }
 
 std::unique_ptr<config_t> config_new_empty(void) {
@@ -224,14 +217,14 @@ void config_set_string(config_t* config, const std::string& section,
     value_no_newline = value;
   }
 
-  for (entry_t& entry : sec->entries) {
-    if (entry.key == key) {
-      entry.value = value_no_newline;
-      return;
-    }
+  auto entry = sec->entries.find(key);
+  if (entry != sec->entries.end()) {
+    entry->value = std::move(value_no_newline);
+    return;
   }
 
-  sec->entries.emplace_back(entry_t{.key = key, .value = value_no_newline});
+  sec->entries.emplace_back(
+      entry_t{.key = key, .value = std::move(value_no_newline)});
 }
 
 bool config_remove_section(config_t* config, const std::string& section) {
@@ -250,15 +243,11 @@ bool config_remove_key(config_t* config, const std::string& section,
   auto sec = section_find(*config, section);
   if (sec == config->sections.end()) return false;
 
-  for (auto entry = sec->entries.begin(); entry != sec->entries.end();
-       ++entry) {
-    if (entry->key == key) {
-      sec->entries.erase(entry);
-      return true;
-    }
-  }
+  auto entry = sec->entries.find(key);
+  if (entry == sec->entries.end()) return false;
 
-  return false;
+  sec->entries.erase(entry);
+  return true;
 }
 
 bool config_save(const config_t& config, const std::string& filename) {
@@ -275,7 +264,7 @@ bool config_save(const config_t& config, const std::string& filename) {
   //    This ensures directory entries are up-to-date.
   int dir_fd = -1;
   FILE* fp = nullptr;
-  std::stringstream serialized;
+  std::string serialized;
 
   // Build temp config file based on config file (e.g. bt_config.conf.new).
   const std::string temp_filename = filename + ".new";
@@ -303,15 +292,17 @@ bool config_save(const config_t& config, const std::string& filename) {
   }
 
   for (const section_t& section : config.sections) {
-    serialized << "[" << section.name << "]" << std::endl;
+    serialized.append("[").append(section.name).append("]\n");
 
     for (const entry_t& entry : section.entries)
-      serialized << entry.key << " = " << entry.value << std::endl;
+      serialized.append(entry.key).append(" = ").append(entry.value).append(
+          "\n");
 
-    serialized << std::endl;
+    serialized.append("\n");
   }
 
-  if (fprintf(fp, "%s", serialized.str().c_str()) < 0) {
+  if (fwrite(serialized.data(), 1, serialized.size(), fp) !=
+      serialized.size()) {
     LOG(ERROR) << __func__ << ": unable to write to file '" << temp_filename
                << "': " << strerror(errno);
     goto error;
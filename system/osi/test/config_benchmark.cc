@@ -0,0 +1,126 @@
+/*
+ *  Copyright 2023 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+#include <stdio.h>
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "osi/include/config.h"
+
+using ::benchmark::State;
+
+// Load, lookup, update and save of a bt_config.conf sized like the one of a
+// device that has seen a lot of peers: 1000 device sections of 30 keys each.
+
+namespace {
+
+constexpr int kNumSections = 1000;
+constexpr int kNumKeysPerSection = 30;
+
+const std::filesystem::path kConfigFile =
+    std::filesystem::temp_directory_path() / "config_benchmark.conf";
+
+std::string section_name(int index) {
+  char name[18];
+  snprintf(name, sizeof(name), "aa:bb:cc:%02x:%02x:%02x", (index >> 16) & 0xff,
+           (index >> 8) & 0xff, index & 0xff);
+  return name;
+}
+
+std::string key_name(int index) { return "Key" + std::to_string(index); }
+
+std::unique_ptr<config_t> make_config() {
+  std::unique_ptr<config_t> config = config_new_empty();
+  for (int section = 0; section < kNumSections; section++) {
+    for (int key = 0; key < kNumKeysPerSection; key++) {
+      config_set_int(config.get(), section_name(section), key_name(key),
+                     section * key);
+    }
+  }
+  return config;
+}
+
+// Visits the sections in an order unrelated to the file order
+int nth_section(int n) { return (n * 7919) % kNumSections; }
+
+}  // namespace
+
+static void BM_ConfigLoad(State& state) {
+  config_save(*make_config(), kConfigFile);
+  for (auto _ : state) {
+    std::unique_ptr<config_t> config = config_new(kConfigFile.c_str());
+    benchmark::DoNotOptimize(config);
+  }
+  std::filesystem::remove(kConfigFile);
+}
+
+static void BM_ConfigGetString(State& state) {
+  std::unique_ptr<config_t> config = make_config();
+  std::vector<std::string> sections;
+  std::vector<std::string> keys;
+  for (int i = 0; i < kNumSections; i++) {
+    sections.push_back(section_name(nth_section(i)));
+  }
+  for (int i = 0; i < kNumKeysPerSection; i++) {
+    keys.push_back(key_name(i));
+  }
+  int n = 0;
+  for (auto _ : state) {
+    const std::string* value =
+        config_get_string(*config, sections[n % kNumSections],
+                          keys[n % kNumKeysPerSection], nullptr);
+    benchmark::DoNotOptimize(value);
+    n++;
+  }
+}
+
+static void BM_ConfigSetString(State& state) {
+  std::unique_ptr<config_t> config = make_config();
+  std::vector<std::string> sections;
+  for (int i = 0; i < kNumSections; i++) {
+    sections.push_back(section_name(nth_section(i)));
+  }
+  const std::string key = key_name(kNumKeysPerSection - 1);
+  int n = 0;
+  for (auto _ : state) {
+    config_set_string(config.get(), sections[n % kNumSections], key, "value");
+    n++;
+  }
+}
+
+static void BM_ConfigSave(State& state) {
+  std::unique_ptr<config_t> config = make_config();
+  for (auto _ : state) {
+    config_save(*config, kConfigFile);
+  }
+  std::filesystem::remove(kConfigFile);
+}
+
+BENCHMARK(BM_ConfigLoad)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_ConfigGetString);
+BENCHMARK(BM_ConfigSetString);
+BENCHMARK(BM_ConfigSave)->Unit(benchmark::kMillisecond);
+
+int main(int argc, char** argv) {
+  ::benchmark::Initialize(&argc, argv);
+  if (::benchmark::ReportUnrecognizedArguments(argc, argv)) {
+    return 1;
+  }
+  ::benchmark::RunSpecifiedBenchmarks();
+}
@@ -134,6 +134,62 @@ TEST_F(ConfigTest, section_set) {
   EXPECT_EQ(entry_iter->value, "bar");
 }
 
+TEST_F(ConfigTest, config_find_after_remove_and_readd) {
+  std::unique_ptr<config_t> config = config_new(CONFIG_FILE);
+  ASSERT_NE(config, nullptr);
+  EXPECT_TRUE(config_remove_section(config.get(), "DID"));
+  EXPECT_EQ(config->Find("DID"), config->sections.end());
+  config_set_string(config.get(), "DID", "version", "0x0001");
+  auto section_iter = config->Find("DID");
+  ASSERT_NE(section_iter, config->sections.end());
+  EXPECT_EQ(section_iter->name, "DID");
+  // Re-added sections go to the end of the save order
+  EXPECT_EQ(&config->sections.back(), &*section_iter);
+  EXPECT_EQ(section_iter->entries.size(), 1u);
+}
+
+TEST_F(ConfigTest, config_find_duplicate_section) {
+  std::unique_ptr<config_t> config = config_new_empty();
+  config->sections.push_back(section_t{.name = "dup"});
+  config->sections.back().Set("key", "first");
+  config->sections.push_back(section_t{.name = "dup"});
+  config->sections.back().Set("key", "second");
+
+  // First one wins, as with a linear search
+  EXPECT_EQ(*config_get_string(*config, "dup", "key", nullptr), "first");
+  EXPECT_TRUE(config_remove_section(config.get(), "dup"));
+  EXPECT_EQ(*config_get_string(*config, "dup", "key", nullptr), "second");
+  EXPECT_TRUE(config_remove_section(config.get(), "dup"));
+  EXPECT_FALSE(config_has_section(*config, "dup"));
+}
+
+TEST_F(ConfigTest, config_copy_and_move_keep_index) {
+  std::unique_ptr<config_t> config = config_new(CONFIG_FILE);
+  ASSERT_NE(config, nullptr);
+
+  config_t copy = *config;
+  config_set_string(&copy, "DID", "version", "0x0001");
+  EXPECT_EQ(config_get_int(copy, "DID", "version", 0), 0x0001);
+  EXPECT_EQ(config_get_int(*config, "DID", "version", 0), 0x1436);
+
+  config_t moved = std::move(copy);
+  EXPECT_EQ(config_get_int(moved, "DID", "version", 0), 0x0001);
+  EXPECT_TRUE(config_remove_key(&moved, "DID", "version"));
+  EXPECT_FALSE(config_has_key(moved, "DID", "version"));
+}
+
+TEST_F(ConfigTest, section_sort_keeps_index) {
+  std::unique_ptr<config_t> config = config_new(CONFIG_FILE);
+  ASSERT_NE(config, nullptr);
+  auto section_iter = config->Find("DID");
+  ASSERT_NE(section_iter, config->sections.end());
+  section_iter->entries.sort(
+      [](const entry_t& a, const entry_t& b) { return a.key < b.key; });
+  EXPECT_EQ(section_iter->entries.front().key, "HiSyncId");
+  EXPECT_EQ(config_get_int(*config, "DID", "productId", 0), 0x1200);
+  EXPECT_EQ(section_iter->Find("version")->value, "0x1436");
+}
+
 TEST_F(ConfigTest, config_new_empty) {
   std::unique_ptr<config_t> config = config_new_empty();
   EXPECT_TRUE(config.get() != NULL);
@@ -1383,6 +1383,27 @@ uint8_t BTM_GetPeerSCA(const RawAddress& remote_bda, tBT_TRANSPORT transport) {
   return (0xFF);
 }
 
+/*******************************************************************************
+ *
+ * Function         BTM_SetAclTxLatencyClass
+ *
+ * Description      This function is called to set the latency class used to
+ *                  schedule the ACL data sent to the peer device against the
+ *                  other links
+ *
+ ******************************************************************************/
+void BTM_SetAclTxLatencyClass(const RawAddress& remote_bda,
+                              tBT_TRANSPORT transport,
+                              tBTM_ACL_TX_LATENCY_CLASS latency_class) {
+  tACL_CONN* p = internal_.btm_bda_to_acl(remote_bda, transport);
+  if (p == nullptr) {
+    LOG_WARN("Unable to find active acl");
+    return;
+  }
+
+  bluetooth::shim::ACL_SetTxLatencyClass(p->hci_handle, latency_class);
+}
+
 /*******************************************************************************
  *
  * Function         btm_rejectlist_role_change_device
@@ -25,6 +25,10 @@
 #include <base/functional/bind.h>
 #include <string.h>
 
+#include <algorithm>
+#include <array>
+#include <vector>
+
 #include "btm_ble_int.h"
 #include "device/include/controller.h"
 #include "gap_api.h"
@@ -107,6 +111,7 @@ bool btm_ble_init_pseudo_addr(tBTM_SEC_DEV_REC* p_dev_rec,
                               const RawAddress& new_pseudo_addr) {
   if (p_dev_rec->ble.pseudo_addr.IsEmpty()) {
     p_dev_rec->ble.pseudo_addr = new_pseudo_addr;
+    btm_sec_reindex_dev_rec(p_dev_rec);
     return true;
   }
 
@@ -154,37 +159,139 @@ bool btm_ble_addr_resolvable(const RawAddress& rpa,
   return false;
 }
 
-/** This function match the random address to the appointed device record,
- * starting from calculating IRK. If the record index exceeds the maximum record
- * number, matching failed and send a callback. */
-static bool btm_ble_match_random_bda(void* data, void* context) {
-  tBTM_SEC_DEV_REC* p_dev_rec = static_cast<tBTM_SEC_DEV_REC*>(data);
-  RawAddress* random_bda = static_cast<RawAddress*>(context);
+namespace {
+
+/* Records able to resolve RPAs, in the order of btm_cb.sec_dev_rec, with the
+ * round keys of their IRK in a separate array to encrypt with all of them in
+ * one go */
+struct tBTM_BLE_IRK_ENTRY {
+  const tBTM_SEC_DEV_REC* p_dev_rec;
+  Octet16 irk;
+};
+
+struct tBTM_BLE_RPA_CACHE_ENTRY {
+  RawAddress rpa;
+  size_t irk_index;
+};
+
+constexpr size_t kRpaNotResolved = SIZE_MAX;
+/* Advertisers seen the most recently while scanning */
+constexpr size_t kRpaCacheSize = 32;
+/* Number of IRKs encrypted at once, before looking for a match */
+constexpr size_t kIrkBatchSize = 8;
+
+struct {
+  std::vector<tBTM_BLE_IRK_ENTRY> irks;
+  std::vector<crypto_toolbox::Aes128RoundKeys> round_keys;
+  /* Recently resolved and unresolved RPAs, valid as long as |irks| is
+   * unchanged */
+  std::array<tBTM_BLE_RPA_CACHE_ENTRY, kRpaCacheSize> rpa_cache;
+  size_t rpa_cache_size = 0;
+  size_t rpa_cache_next = 0;
+} btm_ble_rpa_resolver;
+
+bool btm_ble_can_resolve_rpa(const tBTM_SEC_DEV_REC* p_dev_rec) {
+  return (p_dev_rec->device_type & BT_DEVICE_TYPE_BLE) &&
+         (p_dev_rec->ble.key_type & BTM_LE_KEY_PID);
+}
 
-  if (!(p_dev_rec->device_type & BT_DEVICE_TYPE_BLE) ||
-      !(p_dev_rec->ble.key_type & BTM_LE_KEY_PID))
-    // Match fails preconditions
-    return true;
+/* Update the IRKs from the security records. Records and keys are modified
+ * directly all over the stack, hence this is done before each resolution, the
+ * keys are only expanded again when they changed */
+void btm_ble_sync_irks() {
+  auto& resolver = btm_ble_rpa_resolver;
+  size_t count = 0;
+  bool changed = false;
 
-  if (rpa_matches_irk(*random_bda, p_dev_rec->ble.keys.irk)) {
-    // Matched
-    return false;
+  list_node_t* end = list_end(btm_cb.sec_dev_rec);
+  for (list_node_t* node = list_begin(btm_cb.sec_dev_rec); node != end;
+       node = list_next(node)) {
+    const tBTM_SEC_DEV_REC* p_dev_rec =
+        static_cast<const tBTM_SEC_DEV_REC*>(list_node(node));
+    if (!btm_ble_can_resolve_rpa(p_dev_rec)) continue;
+
+    const Octet16& irk = p_dev_rec->ble.keys.irk;
+    if (count < resolver.irks.size() &&
+        resolver.irks[count].p_dev_rec == p_dev_rec &&
+        resolver.irks[count].irk == irk) {
+      count++;
+      continue;
+    }
+
+    changed = true;
+    if (count < resolver.irks.size()) {
+      resolver.irks[count] = {p_dev_rec, irk};
+      resolver.round_keys[count] = crypto_toolbox::aes_128_expand_key(irk);
+    } else {
+      resolver.irks.push_back({p_dev_rec, irk});
+      resolver.round_keys.push_back(crypto_toolbox::aes_128_expand_key(irk));
+    }
+    count++;
   }
 
-  // This item not a match, continue iteration
-  return true;
+  if (count != resolver.irks.size()) {
+    changed = true;
+    resolver.irks.resize(count);
+    resolver.round_keys.resize(count);
+  }
+  if (changed) {
+    resolver.rpa_cache_size = 0;
+  }
 }
 
+/* Returns the index of the first IRK resolving |rpa|, or kRpaNotResolved */
+size_t btm_ble_find_irk_index(const RawAddress& rpa) {
+  auto& resolver = btm_ble_rpa_resolver;
+  for (size_t i = 0; i < resolver.rpa_cache_size; i++) {
+    if (resolver.rpa_cache[i].rpa == rpa) return resolver.rpa_cache[i].irk_index;
+  }
+
+  /* use the 3 MSB of bd address as prand */
+  Octet16 prand{0};
+  prand[0] = rpa.address[2];
+  prand[1] = rpa.address[1];
+  prand[2] = rpa.address[0];
+
+  size_t irk_index = kRpaNotResolved;
+  std::array<Octet16, kIrkBatchSize> x;
+  for (size_t batch = 0;
+       batch < resolver.irks.size() && irk_index == kRpaNotResolved;
+       batch += kIrkBatchSize) {
+    size_t batch_size =
+        std::min(kIrkBatchSize, resolver.irks.size() - batch);
+    /* generate X = E irk(R0, R1, R2) for each IRK */
+    crypto_toolbox::aes_128_multi_key(&resolver.round_keys[batch], batch_size,
+                                      prand, x.data());
+    for (size_t i = 0; i < batch_size; i++) {
+      /* compare with the hash, the 3 LSO of the random address */
+      if (x[i][0] == rpa.address[5] && x[i][1] == rpa.address[4] &&
+          x[i][2] == rpa.address[3]) {
+        irk_index = batch + i;
+        break;
+      }
+    }
+  }
+
+  resolver.rpa_cache[resolver.rpa_cache_next] = {rpa, irk_index};
+  resolver.rpa_cache_next = (resolver.rpa_cache_next + 1) % kRpaCacheSize;
+  resolver.rpa_cache_size =
+      std::min(resolver.rpa_cache_size + 1, kRpaCacheSize);
+  return irk_index;
+}
+
+}  // namespace
+
 /** This function is called to resolve a random address.
  * Returns pointer to the security record of the device whom a random address is
  * matched to.
  */
 tBTM_SEC_DEV_REC* btm_ble_resolve_random_addr(const RawAddress& random_bda) {
   if (btm_cb.sec_dev_rec == nullptr) return nullptr;
-  list_node_t* n = list_foreach(btm_cb.sec_dev_rec, btm_ble_match_random_bda,
-                                (void*)&random_bda);
-  return (n == nullptr) ? (nullptr)
-                        : (static_cast<tBTM_SEC_DEV_REC*>(list_node(n)));
+  btm_ble_sync_irks();
+  size_t irk_index = btm_ble_find_irk_index(random_bda);
+  if (irk_index == kRpaNotResolved) return nullptr;
+  return const_cast<tBTM_SEC_DEV_REC*>(
+      btm_ble_rpa_resolver.irks[irk_index].p_dev_rec);
 }
 
 /*******************************************************************************
@@ -45,6 +45,8 @@
 
 extern tBTM_CB btm_cb;
 void gatt_consolidate(const RawAddress& identity_addr, const RawAddress& rpa);
+bool btm_ble_init_pseudo_addr(tBTM_SEC_DEV_REC* p_dev_rec,
+                              const RawAddress& new_pseudo_addr);
 
 namespace {
 
@@ -84,6 +86,7 @@ bool BTM_SecAddDevice(const RawAddress& bd_addr, DEV_CLASS dev_class,
 
     p_dev_rec->bd_addr = bd_addr;
     p_dev_rec->hci_handle = BTM_GetHCIConnHandle(bd_addr, BT_TRANSPORT_BR_EDR);
+    btm_sec_reindex_dev_rec(p_dev_rec);
 
     /* use default value for background connection params */
     /* update conn params, use default value for background connection params */
@@ -139,9 +142,43 @@ bool BTM_SecAddDevice(const RawAddress& bd_addr, DEV_CLASS dev_class,
   return true;
 }
 
+/* Remove all cached look ups resolving to |p_dev_rec|, its fields may have
+ * changed since they were cached */
+static void btm_sec_unindex_dev_rec(const tBTM_SEC_DEV_REC* p_dev_rec) {
+  for (auto it = btm_cb.sec_dev_rec_by_address.begin();
+       it != btm_cb.sec_dev_rec_by_address.end();) {
+    if (it->second == p_dev_rec) {
+      it = btm_cb.sec_dev_rec_by_address.erase(it);
+    } else {
+      it++;
+    }
+  }
+  for (auto it = btm_cb.sec_dev_rec_by_handle.begin();
+       it != btm_cb.sec_dev_rec_by_handle.end();) {
+    if (it->second == p_dev_rec) {
+      it = btm_cb.sec_dev_rec_by_handle.erase(it);
+    } else {
+      it++;
+    }
+  }
+}
+
+void btm_sec_reindex_dev_rec(const tBTM_SEC_DEV_REC* p_dev_rec) {
+  btm_cb.sec_dev_rec_by_address.erase(p_dev_rec->bd_addr);
+  btm_cb.sec_dev_rec_by_address.erase(p_dev_rec->ble.pseudo_addr);
+  btm_cb.sec_dev_rec_by_handle.erase(p_dev_rec->hci_handle);
+  btm_cb.sec_dev_rec_by_handle.erase(p_dev_rec->ble_hci_handle);
+}
+
+void btm_sec_clear_dev_rec_index() {
+  btm_cb.sec_dev_rec_by_address.clear();
+  btm_cb.sec_dev_rec_by_handle.clear();
+}
+
 void wipe_secrets_and_remove(tBTM_SEC_DEV_REC* p_dev_rec) {
   p_dev_rec->link_key.fill(0);
   memset(&p_dev_rec->ble.keys, 0, sizeof(tBTM_SEC_BLE_KEYS));
+  btm_sec_unindex_dev_rec(p_dev_rec);
   list_remove(btm_cb.sec_dev_rec, p_dev_rec);
 }
 
@@ -279,6 +316,7 @@ tBTM_SEC_DEV_REC* btm_sec_alloc_dev(const RawAddress& bd_addr) {
 
   p_dev_rec->ble_hci_handle = BTM_GetHCIConnHandle(bd_addr, BT_TRANSPORT_LE);
   p_dev_rec->hci_handle = BTM_GetHCIConnHandle(bd_addr, BT_TRANSPORT_BR_EDR);
+  btm_sec_reindex_dev_rec(p_dev_rec);
 
   return (p_dev_rec);
 }
@@ -351,8 +389,22 @@ bool is_handle_equal(void* data, void* context) {
  *
  ******************************************************************************/
 tBTM_SEC_DEV_REC* btm_find_dev_by_handle(uint16_t handle) {
+  auto cached = btm_cb.sec_dev_rec_by_handle.find(handle);
+  if (cached != btm_cb.sec_dev_rec_by_handle.end() &&
+      !is_handle_equal(cached->second, &handle)) {
+    return cached->second;
+  }
+
   list_node_t* n = list_foreach(btm_cb.sec_dev_rec, is_handle_equal, &handle);
-  if (n) return static_cast<tBTM_SEC_DEV_REC*>(list_node(n));
+  if (n) {
+    tBTM_SEC_DEV_REC* p_dev_rec = static_cast<tBTM_SEC_DEV_REC*>(list_node(n));
+    /* Disconnected records all share the invalid handle, and any of them may
+     * become the first one to match it */
+    if (handle != HCI_INVALID_HANDLE) {
+      btm_cb.sec_dev_rec_by_handle[handle] = p_dev_rec;
+    }
+    return p_dev_rec;
+  }
 
   return NULL;
 }
@@ -382,9 +434,45 @@ bool is_address_equal(void* data, void* context) {
 tBTM_SEC_DEV_REC* btm_find_dev(const RawAddress& bd_addr) {
   if (btm_cb.sec_dev_rec == nullptr) return nullptr;
 
+  /* Records are only ever appended to the list, hence the first record found
+   * for an address stays the first one until a record changes its address,
+   * handles or keys, which drops the cached look ups, see
+   * btm_sec_reindex_dev_rec(). The cached record is still checked in case its
+   * fields were changed in between */
+  auto cached = btm_cb.sec_dev_rec_by_address.find(bd_addr);
+  if (cached != btm_cb.sec_dev_rec_by_address.end() &&
+      !is_address_equal(cached->second, (void*)&bd_addr)) {
+    return cached->second;
+  }
+
+  if (BTM_BLE_IS_RESOLVE_BDA(bd_addr)) {
+    /* Resolve the RPA against the IRKs of all the records at once, instead of
+     * one record at a time in is_address_equal(). The first record matching
+     * the address or its pseudo address still takes precedence. */
+    tBTM_SEC_DEV_REC* p_irk_rec = btm_ble_resolve_random_addr(bd_addr);
+    list_node_t* end = list_end(btm_cb.sec_dev_rec);
+    for (list_node_t* node = list_begin(btm_cb.sec_dev_rec); node != end;
+         node = list_next(node)) {
+      tBTM_SEC_DEV_REC* p_dev_rec =
+          static_cast<tBTM_SEC_DEV_REC*>(list_node(node));
+      if (p_dev_rec->bd_addr != bd_addr &&
+          p_dev_rec->ble.pseudo_addr != bd_addr) {
+        if (p_dev_rec != p_irk_rec) continue;
+        btm_ble_init_pseudo_addr(p_dev_rec, bd_addr);
+      }
+      btm_cb.sec_dev_rec_by_address[bd_addr] = p_dev_rec;
+      return p_dev_rec;
+    }
+    return NULL;
+  }
+
   list_node_t* n =
       list_foreach(btm_cb.sec_dev_rec, is_address_equal, (void*)&bd_addr);
-  if (n) return static_cast<tBTM_SEC_DEV_REC*>(list_node(n));
+  if (n) {
+    tBTM_SEC_DEV_REC* p_dev_rec = static_cast<tBTM_SEC_DEV_REC*>(list_node(n));
+    btm_cb.sec_dev_rec_by_address[bd_addr] = p_dev_rec;
+    return p_dev_rec;
+  }
 
   return NULL;
 }
@@ -409,6 +497,14 @@ static bool has_lenc_and_address_is_equal(void* data, void* context) {
 tBTM_SEC_DEV_REC* btm_find_dev_with_lenc(const RawAddress& bd_addr) {
   if (btm_cb.sec_dev_rec == nullptr) return nullptr;
 
+  /* The first record matching the address is also the first one with an LTK
+   * matching it, when it has an LTK */
+  auto cached = btm_cb.sec_dev_rec_by_address.find(bd_addr);
+  if (cached != btm_cb.sec_dev_rec_by_address.end() &&
+      !has_lenc_and_address_is_equal(cached->second, (void*)&bd_addr)) {
+    return cached->second;
+  }
+
   list_node_t* n = list_foreach(btm_cb.sec_dev_rec, has_lenc_and_address_is_equal,
                                 (void*)&bd_addr);
   if (n) return static_cast<tBTM_SEC_DEV_REC*>(list_node(n));
@@ -456,6 +552,7 @@ void btm_consolidate_dev(tBTM_SEC_DEV_REC* p_target_rec) {
       /* remove the combined record */
       wipe_secrets_and_remove(p_dev_rec);
       // p_dev_rec gets freed in list_remove, we should not  access it further
+      btm_sec_reindex_dev_rec(p_target_rec);
       continue;
     }
 
@@ -520,6 +617,7 @@ void btm_dev_consolidate_existing_connections(const RawAddress& bd_addr) {
 
       RawAddress ble_conn_addr = p_dev_rec->bd_addr;
       p_target_rec->ble_hci_handle = p_dev_rec->ble_hci_handle;
+      btm_sec_reindex_dev_rec(p_target_rec);
 
       /* remove the old LE record */
       wipe_secrets_and_remove(p_dev_rec);
@@ -123,6 +123,30 @@ tBTM_SEC_DEV_REC* btm_find_dev(const RawAddress& bd_addr);
  ******************************************************************************/
 tBTM_SEC_DEV_REC* btm_find_dev_with_lenc(const RawAddress& bd_addr);
 
+/*******************************************************************************
+ *
+ * Function         btm_sec_reindex_dev_rec
+ *
+ * Description      Drop the cached look ups of the address and handles of
+ *                  |p_dev_rec|. Must be called after changing its bd_addr,
+ *                  ble.pseudo_addr, hci_handle or ble_hci_handle, so that
+ *                  btm_find_dev() and btm_find_dev_by_handle() keep returning
+ *                  the first matching record of the device database
+ *
+ ******************************************************************************/
+void btm_sec_reindex_dev_rec(const tBTM_SEC_DEV_REC* p_dev_rec);
+
+/*******************************************************************************
+ *
+ * Function         btm_sec_clear_dev_rec_index
+ *
+ * Description      Drop all cached look ups of the device database. Must be
+ *                  called when records may start matching other addresses,
+ *                  e.g. when an IRK is learnt
+ *
+ ******************************************************************************/
+void btm_sec_clear_dev_rec_index();
+
 /*******************************************************************************
  *
  * Function         btm_consolidate_dev
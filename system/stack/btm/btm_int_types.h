@@ -21,6 +21,7 @@
 #include <cstdint>
 #include <memory>
 #include <string>
+#include <unordered_map>
 
 #include "gd/common/circular_buffer.h"
 #include "osi/include/allocator.h"
@@ -278,6 +279,10 @@ typedef struct tBTM_CB {
   uint8_t disc_reason{0};           /* for legacy devices */
   tBTM_SEC_SERV_REC sec_serv_rec[BTM_SEC_MAX_SERVICE_RECORDS];
   list_t* sec_dev_rec{nullptr}; /* list of tBTM_SEC_DEV_REC */
+  /* Records of sec_dev_rec previously found by address and by connection
+   * handle, see btm_find_dev() */
+  std::unordered_map<RawAddress, tBTM_SEC_DEV_REC*> sec_dev_rec_by_address;
+  std::unordered_map<uint16_t, tBTM_SEC_DEV_REC*> sec_dev_rec_by_handle;
   tBTM_SEC_SERV_REC* p_out_serv{nullptr};
   tBTM_MKEY_CALLBACK* mkey_cback{nullptr};
 
@@ -359,6 +364,8 @@ typedef struct tBTM_CB {
       *((tBTM_SEC_DEV_REC*)ptr) = {};
       osi_free(ptr);
     });
+    sec_dev_rec_by_address.clear();
+    sec_dev_rec_by_handle.clear();
 
     /* Initialize BTM component structures */
     btm_inq_vars.Init(); /* Inquiry Database and Structures */
@@ -387,6 +394,8 @@ typedef struct tBTM_CB {
 
     list_free(sec_dev_rec);
     sec_dev_rec = nullptr;
+    sec_dev_rec_by_address.clear();
+    sec_dev_rec_by_handle.clear();
 
     alarm_free(sec_collision_timer);
     sec_collision_timer = nullptr;
@@ -24,6 +24,13 @@
 #include "stack/include/btm_api_types.h"
 
 #define BTM_MSBC_CODE_SIZE 240
+#define BTM_MSBC_FS 120 /* Frame Size */
+
+/* Used by PLC */
+#define BTM_PLC_WL 256 /* 16ms - Window Length for pattern matching */
+#define BTM_PLC_TL 64  /* 4ms - Template Length for matching */
+#define BTM_PLC_HL \
+  (BTM_PLC_WL + BTM_MSBC_FS - 1) /* Length of History buffer required */
 
 constexpr uint16_t kMaxScoLinks = static_cast<uint16_t>(BTM_MAX_SCO_LINKS);
 
@@ -110,6 +117,15 @@ size_t encode(int16_t* data, size_t len);
  */
 size_t dequeue_packet(const uint8_t** output);
 
+/* Find the samples of the PLC history best matching the template, made of the
+ * last BTM_PLC_TL samples of the history, by normalized cross-correlation.
+ * Args:
+ *    hist - Pointer to the BTM_PLC_HL samples of the history.
+ * Returns:
+ *    The offset in hist of the best match, in [0, BTM_PLC_WL).
+ */
+int plc_pattern_match(const int16_t* hist);
+
 }  // namespace bluetooth::audio::sco::wbs
 
 #ifndef CASE_RETURN_TEXT
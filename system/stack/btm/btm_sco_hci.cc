@@ -23,6 +23,12 @@
 #include <cfloat>
 #include <memory>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
 // Define before including log.h
 #define LOG_TAG "sco_hci"
 
@@ -30,10 +36,13 @@
 #include "btif/include/stack_manager.h"
 #include "osi/include/allocator.h"
 #include "osi/include/log.h"
+#include "osi/include/properties.h"
 #include "stack/btm/btm_sco.h"
 #include "udrv/include/uipc.h"
 
 #define SCO_DATA_READ_POLL_MS 10
+// Move the PCM to shared memory, when the audio server supports it
+#define SCO_SHM_RING_PROPERTY "bluetooth.audio.host_shm_ring.enabled"
 #define SCO_HOST_DATA_PATH "/var/run/bluetooth/audio/.sco_data"
 // TODO(b/198260375): Make SCO data owner group configurable.
 #define SCO_HOST_DATA_GROUP "bluetooth-audio"
@@ -47,14 +56,8 @@
 
 /* Used by PLC */
 #define BTM_MSBC_SAMPLE_SIZE 2 /* 2 bytes*/
-#define BTM_MSBC_FS 120        /* Frame Size */
-
-#define BTM_PLC_WL 256 /* 16ms - Window Length for pattern matching */
-#define BTM_PLC_TL 64  /* 4ms - Template Length for matching */
-#define BTM_PLC_HL \
-  (BTM_PLC_WL + BTM_MSBC_FS - 1) /* Length of History buffer required */
-#define BTM_PLC_SBCRL 36         /* SBC Reconvergence sample Length */
-#define BTM_PLC_OLAL 16          /* OverLap-Add Length */
+#define BTM_PLC_SBCRL 36       /* SBC Reconvergence sample Length */
+#define BTM_PLC_OLAL 16        /* OverLap-Add Length */
 
 /* Disable the PLC when there are more than threshold of lost packets in the
  * window */
@@ -76,6 +79,10 @@ void sco_data_cb(tUIPC_CH_ID, tUIPC_EVENT event) {
                  NULL);
       UIPC_Ioctl(*sco_uipc, UIPC_CH_ID_AV_AUDIO, UIPC_SET_READ_POLL_TMO,
                  reinterpret_cast<void*>(SCO_DATA_READ_POLL_MS));
+      if (osi_property_get_bool(SCO_SHM_RING_PROPERTY, false)) {
+        UIPC_Ioctl(*sco_uipc, UIPC_CH_ID_AV_AUDIO, UIPC_SET_SHM_RING,
+                   reinterpret_cast<void*>(UIPC_SHM_DEFAULT_RING_SIZE));
+      }
       break;
     default:
       break;
@@ -173,6 +180,73 @@ static int16_t f_to_s16(float input) {
          : input < INT16_MIN ? INT16_MIN
                              : (int16_t)input;
 }
+
+static int64_t plc_dot_product_c(const int16_t* x, const int16_t* y) {
+  int64_t sum = 0;
+  for (int i = 0; i < BTM_PLC_TL; i++) sum += x[i] * y[i];
+  return sum;
+}
+
+/* Exact dot product of BTM_PLC_TL samples. The SSE2 sums of two products
+ * overflow when the four samples are INT16_MIN: the caller falls back to
+ * plc_dot_product_c() when the template holds INT16_MIN. */
+static int64_t plc_dot_product(const int16_t* x, const int16_t* y) {
+#if defined(__SSE2__)
+  __m128i sum = _mm_setzero_si128();
+  for (int i = 0; i < BTM_PLC_TL; i += 8) {
+    __m128i p = _mm_madd_epi16(_mm_loadu_si128((const __m128i*)&x[i]),
+                               _mm_loadu_si128((const __m128i*)&y[i]));
+    __m128i sign = _mm_srai_epi32(p, 31);
+    sum = _mm_add_epi64(sum, _mm_unpacklo_epi32(p, sign));
+    sum = _mm_add_epi64(sum, _mm_unpackhi_epi32(p, sign));
+  }
+  int64_t s[2];
+  _mm_storeu_si128((__m128i*)s, sum);
+  return s[0] + s[1];
+#elif defined(__ARM_NEON)
+  int64x2_t sum = vdupq_n_s64(0);
+  for (int i = 0; i < BTM_PLC_TL; i += 8) {
+    int16x8_t a = vld1q_s16(&x[i]);
+    int16x8_t b = vld1q_s16(&y[i]);
+    sum = vpadalq_s32(sum, vmull_s16(vget_low_s16(a), vget_low_s16(b)));
+    sum = vpadalq_s32(sum, vmull_s16(vget_high_s16(a), vget_high_s16(b)));
+  }
+  return vgetq_lane_s64(sum, 0) + vgetq_lane_s64(sum, 1);
+#else
+  return plc_dot_product_c(x, y);
+#endif
+}
+
+/* The energies of the template and of the window are computed once, the
+ * energy of the window then slides along the history. They are kept in
+ * integers, so that the sliding does not accumulate rounding errors. Only
+ * the normalization is done in float. */
+int plc_pattern_match(const int16_t* hist) {
+  const int16_t* x = &hist[BTM_PLC_HL - BTM_PLC_TL];
+  int64_t x2 = 0, y2 = 0;
+  bool exact_simd = true;
+
+  for (int i = 0; i < BTM_PLC_TL; i++) {
+    x2 += x[i] * x[i];
+    y2 += hist[i] * hist[i];
+    exact_simd &= x[i] != INT16_MIN;
+  }
+
+  int best = 0;
+  float cn, max_cn = FLT_MIN;
+
+  for (int i = 0; i < BTM_PLC_WL; i++) {
+    int64_t sum = exact_simd ? plc_dot_product(x, &hist[i])
+                             : plc_dot_product_c(x, &hist[i]);
+    cn = (float)sum / sqrtf((float)x2 * (float)y2);
+    if (cn > max_cn) {
+      best = i;
+      max_cn = cn;
+    }
+    y2 += hist[i + BTM_PLC_TL] * hist[i + BTM_PLC_TL] - hist[i] * hist[i];
+  }
+  return best;
+}
 /* This structure tracks the packet loss for last PLC_WINDOW_SIZE of packets */
 struct tBTM_MSBC_BTM_PLC_WINDOW {
   bool loss_hist[BTM_PLC_WINDOW_SIZE]; /* The packet loss history of receiving
@@ -238,31 +312,6 @@ struct tBTM_MSBC_PLC {
     }
   }
 
-  float cross_correlation(int16_t* x, int16_t* y) {
-    float sum = 0, x2 = 0, y2 = 0;
-
-    for (int i = 0; i < BTM_PLC_TL; i++) {
-      sum += ((float)x[i]) * y[i];
-      x2 += ((float)x[i]) * x[i];
-      y2 += ((float)y[i]) * y[i];
-    }
-    return sum / sqrtf(x2 * y2);
-  }
-
-  int pattern_match(int16_t* hist) {
-    int best = 0;
-    float cn, max_cn = FLT_MIN;
-
-    for (int i = 0; i < BTM_PLC_WL; i++) {
-      cn = cross_correlation(&hist[BTM_PLC_HL - BTM_PLC_TL], &hist[i]);
-      if (cn > max_cn) {
-        best = i;
-        max_cn = cn;
-      }
-    }
-    return best;
-  }
-
   float amplitude_match(int16_t* x, int16_t* y) {
     uint32_t sum_x = 0, sum_y = 0;
     float scaler;
@@ -310,7 +359,7 @@ struct tBTM_MSBC_PLC {
     if (!pl_window->is_packet_loss_too_high()) {
       if (handled_bad_frames == 0) {
         /* Finds the best matching samples and amplitude */
-        best_lag = pattern_match(hist) + BTM_PLC_TL;
+        best_lag = plc_pattern_match(hist) + BTM_PLC_TL;
         best_match_hist = &hist[best_lag];
         scaler =
             amplitude_match(&hist[BTM_PLC_HL - BTM_MSBC_FS], best_match_hist);
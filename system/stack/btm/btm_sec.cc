@@ -1585,6 +1585,7 @@ tBTM_STATUS btm_sec_l2cap_access_req_by_requirement(
   tBTM_SEC_DEV_REC* p_dev_rec = btm_find_or_alloc_dev(bd_addr);
 
   p_dev_rec->hci_handle = BTM_GetHCIConnHandle(bd_addr, BT_TRANSPORT_BR_EDR);
+  btm_sec_reindex_dev_rec(p_dev_rec);
 
   if ((!is_originator) && (security_required & BTM_SEC_MODE4_LEVEL4)) {
     bool local_supports_sc =
@@ -3785,6 +3786,7 @@ void btm_sec_connected(const RawAddress& bda, uint16_t handle,
   }
 
   p_dev_rec->hci_handle = handle;
+  btm_sec_reindex_dev_rec(p_dev_rec);
   btm_acl_created(bda, handle, assigned_role, BT_TRANSPORT_BR_EDR);
 
   /* role may not be correct here, it will be updated by l2cap, but we need to
@@ -18,6 +18,7 @@
 #include <base/logging.h>
 
 #include "check.h"
+#include "gd/crypto_toolbox/aes_round_keys.h"
 #include "stack/include/bt_octets.h"
 #include "stack/include/bt_types.h"
 
@@ -37,6 +38,12 @@ uint32_t g2(const uint8_t* u, const uint8_t* v, const Octet16& x,
 Octet16 ltk_to_link_key(const Octet16& ltk, bool use_h7);
 Octet16 link_key_to_ltk(const Octet16& link_key, bool use_h7);
 
+/* AES-128 with expanded keys, shared with the gd crypto toolbox */
+using bluetooth::crypto_toolbox::Aes128RoundKeys;
+using bluetooth::crypto_toolbox::aes_128_expand_key;
+using bluetooth::crypto_toolbox::aes_128_multi_key;
+using bluetooth::crypto_toolbox::aes_cmac;
+
 /* This function computes AES_128(key, message). |key| must be 128bit.
  * |message| can be at most 16 bytes long, it's length in bytes is given in
  * |length| */
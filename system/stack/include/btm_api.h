@@ -770,6 +770,19 @@ void BTM_RequestPeerSCA(const RawAddress& remote_bda, tBT_TRANSPORT transport);
  ******************************************************************************/
 uint8_t BTM_GetPeerSCA(const RawAddress& remote_bda, tBT_TRANSPORT transport);
 
+/*******************************************************************************
+ *
+ * Function         BTM_SetAclTxLatencyClass
+ *
+ * Description      This function is called to set the latency class used to
+ *                  schedule the ACL data sent to the peer device against the
+ *                  other links
+ *
+ ******************************************************************************/
+void BTM_SetAclTxLatencyClass(const RawAddress& remote_bda,
+                              tBT_TRANSPORT transport,
+                              tBTM_ACL_TX_LATENCY_CLASS latency_class);
+
 /*******************************************************************************
  *
  * Function         BTM_DeleteStoredLinkKey
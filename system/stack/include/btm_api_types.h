@@ -95,6 +95,14 @@ typedef enum : uint8_t {
   BTM_BLE_SEC_ENCRYPT_MITM = 3,
 } tBTM_BLE_SEC_ACT;
 
+/* Latency class of the ACL data sent on a link. The links of a class are
+ * served before the links of the next classes. */
+typedef enum : uint8_t {
+  BTM_ACL_TX_ISOCHRONOUS_ADJACENT = 0, /* e.g. LE Audio control */
+  BTM_ACL_TX_INTERACTIVE = 1,          /* e.g. HID reports */
+  BTM_ACL_TX_BULK = 2,                 /* default */
+} tBTM_ACL_TX_LATENCY_CLASS;
+
 /*******************************************************************************
  * BTM Services MACROS handle array of uint32_t bits for more than 32 services
  ******************************************************************************/
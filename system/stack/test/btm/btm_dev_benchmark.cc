@@ -0,0 +1,155 @@
+/*
+ * Copyright 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <string>
+#include <vector>
+
+#include "btif/include/btif_hh.h"
+#include "hci/include/hci_layer.h"
+#include "stack/btm/btm_ble_int.h"
+#include "stack/btm/btm_dev.h"
+#include "stack/btm/btm_int_types.h"
+#include "stack/crypto_toolbox/crypto_toolbox.h"
+#include "stack/include/hcidefs.h"
+#include "stack/l2cap/l2c_int.h"
+#include "types/raw_address.h"
+
+using ::benchmark::State;
+
+extern tBTM_CB btm_cb;
+
+uint8_t btif_trace_level = BT_TRACE_LEVEL_NONE;
+uint8_t appl_trace_level = BT_TRACE_LEVEL_NONE;
+btif_hh_cb_t btif_hh_cb;
+tL2C_CB l2cb;
+
+const hci_t* hci_layer_get_interface() { return nullptr; }
+
+const std::string kSmpOptions("mock smp options");
+const std::string kBroadcastAudioConfigOptions(
+    "mock broadcast audio config options");
+
+namespace {
+
+// Device database filled up with bonded LE devices, each connected over both
+// transports, as in an event storm with many peers
+class BtmDevBenchmark : public ::benchmark::Fixture {
+ public:
+  void SetUp(State& st) override {
+    ::benchmark::Fixture::SetUp(st);
+    btm_cb.Init(BTM_SEC_MODE_SC);
+    for (uint16_t i = 0; i < BTM_SEC_MAX_DEVICE_RECORDS; i++) {
+      tBTM_SEC_DEV_REC* p_dev_rec = btm_sec_allocate_dev_rec();
+      p_dev_rec->bd_addr = RawAddress({0xA0, 0xB0, 0xC0, 0xD0, 0x00,
+                                       static_cast<uint8_t>(i)});
+      p_dev_rec->hci_handle = 2 * i;
+      p_dev_rec->ble_hci_handle = 2 * i + 1;
+      p_dev_rec->device_type = BT_DEVICE_TYPE_DUMO;
+      p_dev_rec->ble.key_type = BTM_LE_KEY_PID | BTM_LE_KEY_PENC;
+      p_dev_rec->ble.keys.irk.fill(static_cast<uint8_t>(i + 1));
+      btm_sec_reindex_dev_rec(p_dev_rec);
+      addresses_.push_back(p_dev_rec->bd_addr);
+    }
+    // Resolvable private address of the last device
+    uint8_t prand[3] = {0x11, 0x22, 0x43};
+    Octet16 irk;
+    irk.fill(BTM_SEC_MAX_DEVICE_RECORDS);
+    Octet16 hash = crypto_toolbox::aes_128(irk, prand, 3);
+    rpa_ = RawAddress(
+        {prand[2], prand[1], prand[0], hash[2], hash[1], hash[0]});
+  }
+
+  void TearDown(State& st) override {
+    btm_cb.Free();
+    addresses_.clear();
+    ::benchmark::Fixture::TearDown(st);
+  }
+
+  std::vector<RawAddress> addresses_;
+  RawAddress rpa_;
+};
+
+}  // namespace
+
+BENCHMARK_DEFINE_F(BtmDevBenchmark, btm_find_dev)(State& state) {
+  size_t i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(btm_find_dev(addresses_[i]));
+    i = (i + 1) % addresses_.size();
+  }
+}
+BENCHMARK_REGISTER_F(BtmDevBenchmark, btm_find_dev);
+
+BENCHMARK_DEFINE_F(BtmDevBenchmark, btm_find_dev_by_handle)(State& state) {
+  uint16_t handle = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(btm_find_dev_by_handle(handle));
+    handle = (handle + 1) % (2 * BTM_SEC_MAX_DEVICE_RECORDS);
+  }
+}
+BENCHMARK_REGISTER_F(BtmDevBenchmark, btm_find_dev_by_handle);
+
+BENCHMARK_DEFINE_F(BtmDevBenchmark, btm_find_dev_with_rpa)(State& state) {
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(btm_find_dev(rpa_));
+  }
+}
+BENCHMARK_REGISTER_F(BtmDevBenchmark, btm_find_dev_with_rpa);
+
+BENCHMARK_DEFINE_F(BtmDevBenchmark, btm_find_dev_unknown)(State& state) {
+  const RawAddress unknown({0xA0, 0xB0, 0xC0, 0xD0, 0xEE, 0xEE});
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(btm_find_dev(unknown));
+  }
+}
+BENCHMARK_REGISTER_F(BtmDevBenchmark, btm_find_dev_unknown);
+
+// Resolution of RPAs from advertisers that are not bonded, with only the first
+// |state.range(0)| devices having an IRK. There are more RPAs than the
+// resolver caches so that each resolution goes through all the IRKs.
+BENCHMARK_DEFINE_F(BtmDevBenchmark, btm_ble_resolve_random_addr)
+(State& state) {
+  list_node_t* end = list_end(btm_cb.sec_dev_rec);
+  int64_t num_irks = 0;
+  for (list_node_t* node = list_begin(btm_cb.sec_dev_rec); node != end;
+       node = list_next(node)) {
+    tBTM_SEC_DEV_REC* p_dev_rec =
+        static_cast<tBTM_SEC_DEV_REC*>(list_node(node));
+    if (num_irks++ >= state.range(0)) {
+      p_dev_rec->ble.key_type = BTM_LE_KEY_PENC;
+    }
+  }
+
+  std::vector<RawAddress> unknown_rpas;
+  for (uint8_t i = 0; i < 64; i++) {
+    unknown_rpas.push_back(RawAddress({0x43, 0x22, i, 0x33, 0x44, 0x55}));
+  }
+  size_t i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(btm_ble_resolve_random_addr(unknown_rpas[i]));
+    i = (i + 1) % unknown_rpas.size();
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK_REGISTER_F(BtmDevBenchmark, btm_ble_resolve_random_addr)
+    ->Arg(1)
+    ->Arg(8)
+    ->Arg(32)
+    ->Arg(BTM_SEC_MAX_DEVICE_RECORDS);
+
+BENCHMARK_MAIN();
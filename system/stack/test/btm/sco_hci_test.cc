@@ -20,8 +20,11 @@
 #include <gtest/gtest.h>
 
 #include <algorithm>
+#include <cfloat>
+#include <cmath>
 #include <map>
 #include <memory>
+#include <vector>
 
 #include "btif/include/core_callbacks.h"
 #include "btif/include/stack_manager.h"
@@ -430,4 +433,147 @@ TEST_F(ScoHciWbsWithInitCleanTest, WbsPlc) {
   }
 }
 
+// Normalized cross-correlation of the template at an offset of the history,
+// computed in float, as the PLC did before the incremental search
+float PlcCrossCorrelationReference(const int16_t* hist, int offset) {
+  const int16_t* x = &hist[BTM_PLC_HL - BTM_PLC_TL];
+  const int16_t* y = &hist[offset];
+  float sum = 0, x2 = 0, y2 = 0;
+
+  for (int i = 0; i < BTM_PLC_TL; i++) {
+    sum += ((float)x[i]) * y[i];
+    x2 += ((float)x[i]) * x[i];
+    y2 += ((float)y[i]) * y[i];
+  }
+  return sum / sqrtf(x2 * y2);
+}
+
+int PlcPatternMatchReference(const int16_t* hist) {
+  int best = 0;
+  float cn, max_cn = FLT_MIN;
+
+  for (int i = 0; i < BTM_PLC_WL; i++) {
+    cn = PlcCrossCorrelationReference(hist, i);
+    if (cn > max_cn) {
+      best = i;
+      max_cn = cn;
+    }
+  }
+  return best;
+}
+
+TEST_F(ScoHciWbsTest, WbsPlcPatternMatch) {
+  std::vector<std::vector<int16_t>> histories;
+  uint32_t seed = 1;
+  auto noise = [&seed](int amplitude) {
+    seed = seed * 1664525 + 1013904223;
+    return (int)(seed >> 16) % (2 * amplitude + 1) - amplitude;
+  };
+
+  // Tones with noise, loud enough to be clipped for the last ones
+  for (int amplitude : {0, 1, 100, 8000, 32767, 40000}) {
+    for (float period : {16.0f, 37.5f, 91.0f}) {
+      std::vector<int16_t> hist(BTM_PLC_HL);
+      for (int i = 0; i < BTM_PLC_HL; i++) {
+        float v = amplitude * sinf(2 * M_PI * i / period) + noise(64);
+        hist[i] = std::clamp(v, (float)INT16_MIN, (float)INT16_MAX);
+      }
+      histories.push_back(hist);
+    }
+  }
+
+  // Loud noise, a burst followed by silence, and full scale square waves
+  std::vector<int16_t> hist(BTM_PLC_HL);
+  std::generate(hist.begin(), hist.end(), [&] { return noise(32767); });
+  histories.push_back(hist);
+  std::fill(hist.begin(), hist.end(), 0);
+  for (int i = 0; i < BTM_PLC_TL; i++) hist[i] = noise(30000);
+  histories.push_back(hist);
+  for (int i = 0; i < BTM_PLC_HL; i++) hist[i] = (i / 8) % 2 ? INT16_MIN : 100;
+  histories.push_back(hist);
+  for (int i = 0; i < BTM_PLC_HL; i++)
+    hist[i] = (i / 8) % 2 ? INT16_MIN : INT16_MAX;
+  histories.push_back(hist);
+
+  for (size_t n = 0; n < histories.size(); n++) {
+    const int16_t* hist = histories[n].data();
+    int best = bluetooth::audio::sco::wbs::plc_pattern_match(hist);
+    int expected = PlcPatternMatchReference(hist);
+    ASSERT_THAT(best, AllOf(Ge(0), Le(BTM_PLC_WL - 1))) << "history " << n;
+
+    // The offsets may only differ between matches of equal correlation,
+    // the reference accumulating rounding errors in float
+    if (best != expected) {
+      EXPECT_NEAR(PlcCrossCorrelationReference(hist, best),
+                  PlcCrossCorrelationReference(hist, expected), 1e-5)
+          << "history " << n << " offset " << best << " instead of "
+          << expected;
+    }
+  }
+}
+
+TEST_F(ScoHciWbsWithInitCleanTest, WbsPlcLossPattern) {
+  const int num_pkts = 120;
+  // Isolated losses, and a burst of two, after 20 packets of history
+  const std::vector<int> lost_pkts = {20, 27, 41, 42, 55, 68, 76, 89, 103, 110};
+  int16_t data[BTM_MSBC_FS];
+  const uint8_t* encoded = nullptr;
+  const uint8_t* decoded = nullptr;
+  uint8_t invalid_pkt[60] = {0};
+  std::vector<std::vector<uint8_t>> pkts;
+  std::vector<int16_t> expect_pcm, plc_pcm;
+
+  // A voiced like signal: a fundamental and two harmonics
+  for (int i = 0, sample_idx = 0; i < num_pkts; i++) {
+    for (int j = 0; j < BTM_MSBC_FS; j++, sample_idx++) {
+      float t = 2 * M_PI * sample_idx * 180 / 16000;
+      data[j] = 6000 * sinf(t) + 3000 * sinf(2 * t + 1) + 1500 * sinf(3 * t);
+    }
+    ASSERT_EQ(bluetooth::audio::sco::wbs::encode(data, sizeof(data)),
+              sizeof(data));
+    ASSERT_EQ(bluetooth::audio::sco::wbs::dequeue_packet(&encoded), size_t(60));
+    pkts.emplace_back(encoded, encoded + 60);
+  }
+
+  for (bool lossy : {false, true}) {
+    bluetooth::audio::sco::wbs::cleanup();
+    bluetooth::audio::sco::wbs::init(60);
+    auto& pcm = lossy ? plc_pcm : expect_pcm;
+
+    for (int i = 0; i < num_pkts; i++) {
+      bool lost = lossy && std::find(lost_pkts.begin(), lost_pkts.end(), i) !=
+                               lost_pkts.end();
+      ASSERT_EQ(bluetooth::audio::sco::wbs::enqueue_packet(
+                    lost ? invalid_pkt : pkts[i].data(), 60, false),
+                size_t(60));
+      ASSERT_EQ(bluetooth::audio::sco::wbs::decode(&decoded),
+                size_t(BTM_MSBC_CODE_SIZE));
+      pcm.insert(pcm.end(), (const int16_t*)decoded,
+                 (const int16_t*)(decoded + BTM_MSBC_CODE_SIZE));
+    }
+  }
+
+  int num_decoded_frames;
+  double packet_loss_ratio;
+  ASSERT_TRUE(bluetooth::audio::sco::wbs::fill_plc_stats(&num_decoded_frames,
+                                                         &packet_loss_ratio));
+  ASSERT_EQ(num_decoded_frames, num_pkts);
+  ASSERT_EQ(packet_loss_ratio, (double)lost_pkts.size() / num_pkts);
+
+  // Signal to noise ratio of the concealed frames and of the frames following
+  // them, where the decoder converges back to the received signal
+  double signal = 0, noise = 0;
+  for (int i : lost_pkts) {
+    for (int j = i * BTM_MSBC_FS; j < (i + 2) * BTM_MSBC_FS; j++) {
+      double error = plc_pcm[j] - expect_pcm[j];
+      signal += (double)expect_pcm[j] * expect_pcm[j];
+      noise += error * error;
+    }
+  }
+  // About 16.8 dB with the float pattern matching the PLC started with, and
+  // 0 dB if the lost frames were muted
+  double snr_db = 10 * log10(signal / noise);
+  EXPECT_GE(snr_db, 15.0);
+}
+
 }  // namespace
@@ -0,0 +1,89 @@
+/*
+ * Copyright 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <cfloat>
+#include <cmath>
+#include <vector>
+
+#include "stack/btm/btm_sco.h"
+
+using ::benchmark::State;
+
+namespace {
+
+// A voiced like history: a fundamental, two harmonics and some noise
+std::vector<int16_t> MakeHistory() {
+  std::vector<int16_t> hist(BTM_PLC_HL);
+  uint32_t seed = 1;
+  for (int i = 0; i < BTM_PLC_HL; i++) {
+    seed = seed * 1664525 + 1013904223;
+    float t = 2 * M_PI * i * 180 / 16000;
+    hist[i] = 6000 * sinf(t) + 3000 * sinf(2 * t + 1) + 1500 * sinf(3 * t) +
+              (int)(seed >> 23) - 256;
+  }
+  return hist;
+}
+
+// The pattern matching the PLC started with: a full normalized
+// cross-correlation, in float, for every offset
+int PatternMatchFloat(const int16_t* hist) {
+  const int16_t* x = &hist[BTM_PLC_HL - BTM_PLC_TL];
+  int best = 0;
+  float cn, max_cn = FLT_MIN;
+
+  for (int i = 0; i < BTM_PLC_WL; i++) {
+    const int16_t* y = &hist[i];
+    float sum = 0, x2 = 0, y2 = 0;
+    for (int j = 0; j < BTM_PLC_TL; j++) {
+      sum += ((float)x[j]) * y[j];
+      x2 += ((float)x[j]) * x[j];
+      y2 += ((float)y[j]) * y[j];
+    }
+    cn = sum / sqrtf(x2 * y2);
+    if (cn > max_cn) {
+      best = i;
+      max_cn = cn;
+    }
+  }
+  return best;
+}
+
+}  // namespace
+
+/* Items are lost frames, the search runs once per burst of losses */
+static void BM_PlcPatternMatchFloat(State& state) {
+  auto hist = MakeHistory();
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(hist.data());
+    benchmark::DoNotOptimize(PatternMatchFloat(hist.data()));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+static void BM_PlcPatternMatch(State& state) {
+  auto hist = MakeHistory();
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(hist.data());
+    benchmark::DoNotOptimize(
+        bluetooth::audio::sco::wbs::plc_pattern_match(hist.data()));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_PlcPatternMatchFloat);
+BENCHMARK(BM_PlcPatternMatch);
@@ -31,11 +31,13 @@
 #include "internal_include/stack_config.h"
 #include "osi/include/allocator.h"
 #include "osi/include/osi.h"
+#include "stack/btm/btm_ble_int.h"
 #include "stack/btm/btm_dev.h"
 #include "stack/btm/btm_int_types.h"
 #include "stack/btm/btm_sco.h"
 #include "stack/btm/btm_sec.h"
 #include "stack/btm/security_device_record.h"
+#include "stack/crypto_toolbox/crypto_toolbox.h"
 #include "stack/include/acl_api.h"
 #include "stack/include/acl_hci_link_interface.h"
 #include "stack/include/btm_client_interface.h"
@@ -455,3 +457,132 @@ TEST_F(StackBtmWithInitFreeTest, wipe_secrets_and_remove) {
 
   wipe_secrets_and_remove(device_record);
 }
+
+TEST_F(StackBtmWithInitFreeTest, btm_find_dev_by_address_and_handle) {
+  RawAddress bd_addr = RawAddress({0xA1, 0xA2, 0xA3, 0xA4, 0xA5, 0xA6});
+  RawAddress new_bd_addr = RawAddress({0xB1, 0xB2, 0xB3, 0xB4, 0xB5, 0xB6});
+  const uint16_t classic_handle = 0x1234;
+  const uint16_t ble_handle = 0x0987;
+
+  tBTM_SEC_DEV_REC* other_record = btm_sec_allocate_dev_rec();
+  other_record->bd_addr = RawAddress({0xC1, 0xC2, 0xC3, 0xC4, 0xC5, 0xC6});
+  other_record->hci_handle = HCI_INVALID_HANDLE;
+  other_record->ble_hci_handle = HCI_INVALID_HANDLE;
+  tBTM_SEC_DEV_REC* device_record = btm_sec_allocate_dev_rec();
+  device_record->bd_addr = bd_addr;
+  device_record->hci_handle = classic_handle;
+  device_record->ble_hci_handle = ble_handle;
+  btm_sec_reindex_dev_rec(device_record);
+
+  // Look ups are repeated to go through the cached records
+  for (int i = 0; i < 2; i++) {
+    ASSERT_EQ(device_record, btm_find_dev(bd_addr));
+    ASSERT_EQ(device_record, btm_find_dev_by_handle(classic_handle));
+    ASSERT_EQ(device_record, btm_find_dev_by_handle(ble_handle));
+    ASSERT_EQ(other_record, btm_find_dev_by_handle(HCI_INVALID_HANDLE));
+    ASSERT_EQ(nullptr, btm_find_dev(new_bd_addr));
+  }
+
+  device_record->bd_addr = new_bd_addr;
+  device_record->hci_handle = HCI_INVALID_HANDLE;
+  btm_sec_reindex_dev_rec(device_record);
+  ASSERT_EQ(nullptr, btm_find_dev(bd_addr));
+  ASSERT_EQ(device_record, btm_find_dev(new_bd_addr));
+  ASSERT_EQ(nullptr, btm_find_dev_by_handle(classic_handle));
+  ASSERT_EQ(other_record, btm_find_dev_by_handle(HCI_INVALID_HANDLE));
+
+  wipe_secrets_and_remove(device_record);
+  ASSERT_EQ(nullptr, btm_find_dev(new_bd_addr));
+  ASSERT_EQ(nullptr, btm_find_dev_by_handle(ble_handle));
+}
+
+TEST_F(StackBtmWithInitFreeTest, btm_find_dev_returns_first_record) {
+  RawAddress bd_addr = RawAddress({0xA1, 0xA2, 0xA3, 0xA4, 0xA5, 0xA6});
+
+  tBTM_SEC_DEV_REC* first_record = btm_sec_allocate_dev_rec();
+  tBTM_SEC_DEV_REC* second_record = btm_sec_allocate_dev_rec();
+  second_record->bd_addr = bd_addr;
+  second_record->ble.key_type = BTM_LE_KEY_LENC;
+  btm_sec_reindex_dev_rec(second_record);
+  ASSERT_EQ(second_record, btm_find_dev(bd_addr));
+  ASSERT_EQ(second_record, btm_find_dev_with_lenc(bd_addr));
+
+  // The first record now matches too and takes precedence
+  first_record->ble.pseudo_addr = bd_addr;
+  btm_sec_reindex_dev_rec(first_record);
+  ASSERT_EQ(first_record, btm_find_dev(bd_addr));
+  ASSERT_EQ(second_record, btm_find_dev_with_lenc(bd_addr));
+
+  wipe_secrets_and_remove(first_record);
+  ASSERT_EQ(second_record, btm_find_dev(bd_addr));
+}
+
+namespace {
+
+RawAddress make_rpa(const Octet16& irk, uint8_t rand) {
+  uint8_t prand[3] = {rand, 0x22, 0x43};
+  Octet16 hash = crypto_toolbox::aes_128(irk, prand, 3);
+  return RawAddress({prand[2], prand[1], prand[0], hash[2], hash[1], hash[0]});
+}
+
+tBTM_SEC_DEV_REC* allocate_dev_rec_with_irk(const RawAddress& bd_addr,
+                                            uint8_t irk_byte) {
+  tBTM_SEC_DEV_REC* p_dev_rec = btm_sec_allocate_dev_rec();
+  p_dev_rec->bd_addr = bd_addr;
+  p_dev_rec->device_type = BT_DEVICE_TYPE_BLE;
+  p_dev_rec->ble.key_type = BTM_LE_KEY_PID;
+  p_dev_rec->ble.keys.irk.fill(irk_byte);
+  btm_sec_reindex_dev_rec(p_dev_rec);
+  return p_dev_rec;
+}
+
+}  // namespace
+
+TEST_F(StackBtmWithInitFreeTest, btm_ble_resolve_random_addr) {
+  Octet16 irk_1, irk_2, irk_3;
+  irk_1.fill(1);
+  irk_2.fill(2);
+  irk_3.fill(3);
+
+  // More records than IRKs resolved at once
+  std::vector<tBTM_SEC_DEV_REC*> records;
+  for (uint8_t i = 0; i < 20; i++) {
+    records.push_back(allocate_dev_rec_with_irk(
+        RawAddress({0xA1, 0xA2, 0xA3, 0xA4, 0xA5, i}), 0x10 + i));
+  }
+  tBTM_SEC_DEV_REC* record_1 = allocate_dev_rec_with_irk(
+      RawAddress({0xB1, 0xB2, 0xB3, 0xB4, 0xB5, 0xB6}), 1);
+  tBTM_SEC_DEV_REC* record_2 = allocate_dev_rec_with_irk(
+      RawAddress({0xC1, 0xC2, 0xC3, 0xC4, 0xC5, 0xC6}), 2);
+
+  RawAddress rpa_1 = make_rpa(irk_1, 0x11);
+  RawAddress rpa_2 = make_rpa(irk_2, 0x11);
+  RawAddress rpa_3 = make_rpa(irk_3, 0x11);
+
+  // Resolutions are repeated to go through the cached RPAs
+  for (int i = 0; i < 2; i++) {
+    ASSERT_EQ(record_1, btm_ble_resolve_random_addr(rpa_1));
+    ASSERT_EQ(record_2, btm_ble_resolve_random_addr(rpa_2));
+    ASSERT_EQ(nullptr, btm_ble_resolve_random_addr(rpa_3));
+  }
+
+  // A new IRK resolves RPAs that were not resolved before
+  records[5]->ble.keys.irk = irk_3;
+  ASSERT_EQ(records[5], btm_ble_resolve_random_addr(rpa_3));
+
+  // The first record with an IRK takes precedence
+  records[3]->ble.keys.irk = irk_2;
+  ASSERT_EQ(records[3], btm_ble_resolve_random_addr(rpa_2));
+  ASSERT_EQ(records[3], btm_find_dev(rpa_2));
+  ASSERT_EQ(rpa_2, records[3]->ble.pseudo_addr);
+
+  // Records without an IRK are ignored
+  record_1->ble.key_type = 0;
+  ASSERT_EQ(nullptr, btm_ble_resolve_random_addr(rpa_1));
+  record_1->ble.key_type = BTM_LE_KEY_PID;
+  ASSERT_EQ(record_1, btm_ble_resolve_random_addr(rpa_1));
+
+  wipe_secrets_and_remove(record_1);
+  ASSERT_EQ(nullptr, btm_ble_resolve_random_addr(rpa_1));
+  ASSERT_EQ(nullptr, btm_find_dev(rpa_1));
+}
@@ -100,3 +100,7 @@ void bluetooth::shim::ACL_LeSubrateRequest(
     uint16_t max_latency, uint16_t cont_num, uint16_t sup_tout) {
   inc_func_call_count(__func__);
 }
+void bluetooth::shim::ACL_SetTxLatencyClass(
+    uint16_t hci_handle, tBTM_ACL_TX_LATENCY_CLASS latency_class) {
+  inc_func_call_count(__func__);
+}
@@ -153,7 +153,8 @@ void config_set_uint64(config_t* config, const std::string& section,
   inc_func_call_count(__func__);
   test::mock::osi_config::config_set_uint64(config, section, key, value);
 }
-std::list<section_t>::iterator config_t::Find(const std::string& section) {
+indexed_list<section_t, &section_t::name>::iterator config_t::Find(
+    const std::string& section) {
   inc_func_call_count(__func__);
   return test::mock::osi_config::config_t_Find(section);
 }
@@ -161,7 +162,8 @@ bool config_t::Has(const std::string& key) {
   inc_func_call_count(__func__);
   return test::mock::osi_config::config_t_Has(key);
 }
-std::list<entry_t>::iterator section_t::Find(const std::string& key) {
+indexed_list<entry_t, &entry_t::key>::iterator section_t::Find(
+    const std::string& key) {
   inc_func_call_count(__func__);
   return test::mock::osi_config::section_t_Find(key);
 }
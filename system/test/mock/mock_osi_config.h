@@ -329,12 +329,14 @@ extern struct config_set_uint64 config_set_uint64;
 
 // Name: config_t::Find
 // Params: const std::string& section
-// Return: std::list<section_t>::iterator
+// Return: indexed_list<section_t, &section_t::name>::iterator
 struct config_t_Find {
-  std::list<section_t> section_;
-  std::function<std::list<section_t>::iterator(const std::string& section)>
+  indexed_list<section_t, &section_t::name> section_;
+  std::function<indexed_list<section_t, &section_t::name>::iterator(
+      const std::string& section)>
       body{[this](const std::string& section) { return section_.begin(); }};
-  std::list<section_t>::iterator operator()(const std::string& section) {
+  indexed_list<section_t, &section_t::name>::iterator operator()(
+      const std::string& section) {
     return body(section);
   };
 };
@@ -353,12 +355,14 @@ extern struct config_t_Has config_t_Has;
 
 // Name: section_t_Find
 // Params: const std::string& key
-// Return: std::list<entry_t>::iterator
+// Return: indexed_list<entry_t, &entry_t::key>::iterator
 struct section_t_Find {
-  std::list<entry_t> list_;
-  std::function<std::list<entry_t>::iterator(const std::string& key)> body{
-      [this](const std::string& key) { return list_.begin(); }};
-  std::list<entry_t>::iterator operator()(const std::string& key) {
+  indexed_list<entry_t, &entry_t::key> list_;
+  std::function<indexed_list<entry_t, &entry_t::key>::iterator(
+      const std::string& key)>
+      body{[this](const std::string& key) { return list_.begin(); }};
+  indexed_list<entry_t, &entry_t::key>::iterator operator()(
+      const std::string& key) {
     return body(key);
   };
 };
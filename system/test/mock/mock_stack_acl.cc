@@ -104,6 +104,7 @@ struct ACL_RegisterClient ACL_RegisterClient;
 struct ACL_UnregisterClient ACL_UnregisterClient;
 struct BTM_ReadConnectionAddr BTM_ReadConnectionAddr;
 struct BTM_RequestPeerSCA BTM_RequestPeerSCA;
+struct BTM_SetAclTxLatencyClass BTM_SetAclTxLatencyClass;
 struct BTM_acl_after_controller_started BTM_acl_after_controller_started;
 struct BTM_block_role_switch_for BTM_block_role_switch_for;
 struct BTM_block_sniff_mode_for BTM_block_sniff_mode_for;
@@ -438,6 +439,13 @@ void BTM_RequestPeerSCA(const RawAddress& remote_bda, tBT_TRANSPORT transport) {
   inc_func_call_count(__func__);
   test::mock::stack_acl::BTM_RequestPeerSCA(remote_bda, transport);
 }
+void BTM_SetAclTxLatencyClass(const RawAddress& remote_bda,
+                              tBT_TRANSPORT transport,
+                              tBTM_ACL_TX_LATENCY_CLASS latency_class) {
+  inc_func_call_count(__func__);
+  test::mock::stack_acl::BTM_SetAclTxLatencyClass(remote_bda, transport,
+                                                  latency_class);
+}
 void BTM_acl_after_controller_started(const controller_t* controller) {
   inc_func_call_count(__func__);
   test::mock::stack_acl::BTM_acl_after_controller_started(controller);
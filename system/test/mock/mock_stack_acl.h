@@ -645,6 +645,21 @@ struct BTM_RequestPeerSCA {
   };
 };
 extern struct BTM_RequestPeerSCA BTM_RequestPeerSCA;
+// Name: BTM_SetAclTxLatencyClass
+// Params: const RawAddress& remote_bda, tBT_TRANSPORT transport,
+// tBTM_ACL_TX_LATENCY_CLASS latency_class
+// Returns: void
+struct BTM_SetAclTxLatencyClass {
+  std::function<void(const RawAddress& remote_bda, tBT_TRANSPORT transport,
+                     tBTM_ACL_TX_LATENCY_CLASS latency_class)>
+      body{[](const RawAddress& remote_bda, tBT_TRANSPORT transport,
+              tBTM_ACL_TX_LATENCY_CLASS latency_class) { ; }};
+  void operator()(const RawAddress& remote_bda, tBT_TRANSPORT transport,
+                  tBTM_ACL_TX_LATENCY_CLASS latency_class) {
+    body(remote_bda, transport, latency_class);
+  };
+};
+extern struct BTM_SetAclTxLatencyClass BTM_SetAclTxLatencyClass;
 // Name: BTM_acl_after_controller_started
 // Params: const controller_t* controller
 // Returns: void
@@ -16,7 +16,7 @@
 
 /*
  * Generated mock file from original source file
- *   Functions generated:16
+ *   Functions generated:18
  */
 
 #include "test/mock/mock_stack_btm_dev.h"
@@ -120,6 +120,10 @@ void btm_consolidate_dev(tBTM_SEC_DEV_REC* p_target_rec) {
 void wipe_secrets_and_remove(tBTM_SEC_DEV_REC* p_dev_rec) {
   inc_func_call_count(__func__);
 }
+void btm_sec_reindex_dev_rec(const tBTM_SEC_DEV_REC* p_dev_rec) {
+  inc_func_call_count(__func__);
+}
+void btm_sec_clear_dev_rec_index() { inc_func_call_count(__func__); }
 void btm_dev_consolidate_existing_connections(const RawAddress& bd_addr) {
   inc_func_call_count(__func__);
 }
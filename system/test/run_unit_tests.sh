@@ -25,6 +25,7 @@ known_tests=(
   net_test_stack_smp
   net_test_types
   net_test_osi
+  net_test_udrv_uipc
   net_test_performance
   net_test_stack_rfcomm
   net_test_gatt_conn_multiplexing
@@ -56,17 +56,15 @@ struct StringComparison {
 };
 std::map<const char*, bool, StringComparison> fake_osi_bool_props_map;
 
-std::list<entry_t>::iterator section_t::Find(const std::string& key) {
+indexed_list<entry_t, &entry_t::key>::iterator section_t::Find(
+    const std::string& key) {
   inc_func_call_count(__func__);
-  return std::find_if(
-      entries.begin(), entries.end(),
-      [&key](const entry_t& entry) { return entry.key == key; });
+  return entries.find(key);
 }
-std::list<section_t>::iterator config_t::Find(const std::string& section) {
+indexed_list<section_t, &section_t::name>::iterator config_t::Find(
+    const std::string& section) {
   inc_func_call_count(__func__);
-  return std::find_if(
-      sections.begin(), sections.end(),
-      [&section](const section_t& sec) { return sec.name == section; });
+  return sections.find(section);
 }
 
 bool checksum_save(const std::string& checksum, const std::string& filename) {
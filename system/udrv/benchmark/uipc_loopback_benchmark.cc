@@ -0,0 +1,174 @@
+/*
+ * Copyright 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <future>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "osi/include/socket_utils/sockets.h"
+#include "udrv/include/uipc.h"
+
+using ::benchmark::State;
+
+namespace {
+
+std::unique_ptr<tUIPC_STATE> uipc;
+std::promise<void> channel_open;
+bool use_shm_ring;
+
+int64_t NowNs() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+void DataCallback(tUIPC_CH_ID ch_id, tUIPC_EVENT event) {
+  if (event != UIPC_OPEN_EVT) return;
+
+  UIPC_Ioctl(*uipc, ch_id, UIPC_REG_REMOVE_ACTIVE_READSET, nullptr);
+  UIPC_Ioctl(*uipc, ch_id, UIPC_SET_READ_POLL_TMO,
+             reinterpret_cast<void*>(DEFAULT_READ_POLL_TMO_MS));
+  if (use_shm_ring)
+    UIPC_Ioctl(*uipc, ch_id, UIPC_SET_SHM_RING,
+               reinterpret_cast<void*>(UIPC_SHM_DEFAULT_RING_SIZE));
+  channel_open.set_value();
+}
+
+// Stand-in for the audio server: sends packets stamped with their send
+// time, at the pace of the audio clock
+void Producer(const std::string& path, int num_packets, size_t packet_size,
+              int period_us) {
+  int fd = osi_socket_local_client(path.c_str(),
+#ifdef __ANDROID__
+                                   ANDROID_SOCKET_NAMESPACE_ABSTRACT,
+#else
+                                   ANDROID_SOCKET_NAMESPACE_FILESYSTEM,
+#endif
+                                   SOCK_STREAM);
+  if (fd < 0) return;
+
+  tUIPC_SHM* shm = use_shm_ring ? UIPC_ShmConnect(fd) : nullptr;
+  std::vector<uint8_t> packet(packet_size);
+  int64_t start_ns = NowNs();
+
+  for (int i = 0; i < num_packets; i++) {
+    int64_t send_ns = start_ns + (int64_t)i * period_us * 1000;
+    struct timespec ts = {(time_t)(send_ns / 1000000000),
+                          (long)(send_ns % 1000000000)};
+    clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr);
+
+    int64_t now_ns = NowNs();
+    memcpy(packet.data(), &now_ns, sizeof(now_ns));
+    ssize_t ret =
+        shm ? UIPC_ShmWrite(shm, packet.data(), packet.size(), fd,
+                            DEFAULT_READ_POLL_TMO_MS)
+            : send(fd, packet.data(), packet.size(), MSG_NOSIGNAL);
+    if (ret != (ssize_t)packet.size()) break;
+  }
+
+  /* Let the reader drain the data before the hang-up */
+  usleep(100 * 1000);
+  UIPC_ShmFree(shm);
+  close(fd);
+}
+
+// Latency from the write of a packet by the audio server, to the end of its
+// read by the stack
+void BM_Loopback(State& state, bool shm_ring) {
+  size_t packet_size = state.range(0);
+  int period_us = state.range(1);
+  int num_packets = state.max_iterations;
+  std::string path = "/tmp/.uipc_loopback_" + std::to_string(getpid());
+
+  use_shm_ring = shm_ring;
+  channel_open = std::promise<void>();
+  uipc = UIPC_Init();
+  UIPC_Open(*uipc, UIPC_CH_ID_AV_AUDIO, DataCallback, path.c_str());
+
+  std::thread producer(Producer, path, num_packets, packet_size, period_us);
+  channel_open.get_future().wait();
+
+  std::vector<uint8_t> packet(packet_size);
+  std::vector<double> latencies_us;
+  latencies_us.reserve(num_packets);
+
+  for (auto _ : state) {
+    uint32_t n =
+        UIPC_Read(*uipc, UIPC_CH_ID_AV_AUDIO, packet.data(), packet.size());
+    int64_t now_ns = NowNs();
+    if (n != packet.size()) {
+      state.SkipWithError("short read");
+      break;
+    }
+
+    int64_t send_ns;
+    memcpy(&send_ns, packet.data(), sizeof(send_ns));
+    latencies_us.push_back((now_ns - send_ns) / 1000.);
+  }
+
+  UIPC_Close(*uipc, UIPC_CH_ID_ALL);
+  producer.join();
+  uipc = nullptr;
+  unlink(path.c_str());
+
+  if (latencies_us.empty()) return;
+
+  double mean = 0, var = 0;
+  for (double v : latencies_us) mean += v;
+  mean /= latencies_us.size();
+  for (double v : latencies_us) var += (v - mean) * (v - mean);
+
+  std::sort(latencies_us.begin(), latencies_us.end());
+  state.counters["latency_us"] = mean;
+  state.counters["p99_us"] = latencies_us[latencies_us.size() * 99 / 100];
+  state.counters["jitter_us"] = std::sqrt(var / latencies_us.size());
+}
+
+void BM_LoopbackSocket(State& state) { BM_Loopback(state, false); }
+void BM_LoopbackShmRing(State& state) { BM_Loopback(state, true); }
+
+}  // namespace
+
+// Small packets every ms, and 10 ms of 48 KHz stereo every 10 ms
+BENCHMARK(BM_LoopbackSocket)
+    ->Args({480, 1000})
+    ->Iterations(2000)
+    ->UseRealTime()
+    ->MeasureProcessCPUTime();
+BENCHMARK(BM_LoopbackShmRing)
+    ->Args({480, 1000})
+    ->Iterations(2000)
+    ->UseRealTime()
+    ->MeasureProcessCPUTime();
+BENCHMARK(BM_LoopbackSocket)
+    ->Args({1920, 10000})
+    ->Iterations(300)
+    ->UseRealTime()
+    ->MeasureProcessCPUTime();
+BENCHMARK(BM_LoopbackShmRing)
+    ->Args({1920, 10000})
+    ->Iterations(300)
+    ->UseRealTime()
+    ->MeasureProcessCPUTime();
@@ -24,6 +24,7 @@
 #include <mutex>
 
 #include "stack/include/bt_hdr.h"
+#include "uipc_shm.h"
 
 #define UIPC_CH_ID_AV_CTRL 0
 #define UIPC_CH_ID_AV_AUDIO 1
@@ -51,6 +52,9 @@ typedef enum {
 #define UIPC_REQ_RX_FLUSH 1
 #define UIPC_REG_REMOVE_ACTIVE_READSET 3
 #define UIPC_SET_READ_POLL_TMO 4
+/* Move the data of a connected channel to shared memory rings of the size
+ * given as parameter, see uipc_shm.h. The audio server shall support it. */
+#define UIPC_SET_SHM_RING 5
 
 typedef void(tUIPC_RCV_CBACK)(
     tUIPC_CH_ID ch_id,
@@ -80,6 +84,9 @@ struct tUIPC_STATE {
   int signal_fds[2];
 
   tUIPC_CHAN ch[UIPC_CH_NUM];
+
+  /* Shared memory rings of the channels, kept alive by the readers */
+  std::shared_ptr<tUIPC_SHM> shm[UIPC_CH_NUM];
 };
 
 /**
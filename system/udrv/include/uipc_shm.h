@@ -0,0 +1,96 @@
+/******************************************************************************
+ *
+ *  Copyright 2023 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+#ifndef UIPC_SHM_H
+#define UIPC_SHM_H
+
+#include <stdint.h>
+#include <sys/types.h>
+
+/*
+ * Shared memory data path of a UIPC channel.
+ *
+ * The stack and the audio server exchange PCM through two single producer,
+ * single consumer rings in a sealed memfd: one from the audio server to the
+ * stack, one from the stack to the audio server. Reads and writes only copy
+ * to or from the shared memory while there is data or space. A side waits
+ * on an eventfd only when it runs out of data or space, and the other side
+ * signals it once, when the ring crosses the level it waits for.
+ *
+ * The stack creates the rings when the channel is connected, and passes
+ * the memfd and the eventfds over the UIPC socket, in a single message:
+ * the audio server shall call UIPC_ShmConnect() on the socket before it
+ * sends or receives any audio. The socket is kept to detect hang-ups.
+ */
+
+/* First 4 bytes of the message passing the file descriptors */
+#define UIPC_SHM_MAGIC 0x55495348 /* "UISH" */
+#define UIPC_SHM_VERSION 1
+
+/* Default size of each ring */
+#define UIPC_SHM_DEFAULT_RING_SIZE (32 * 1024)
+
+typedef struct tUIPC_SHM tUIPC_SHM;
+
+/**
+ * Create the rings on the stack side, and pass them to the audio server
+ *
+ * @param sock_fd Connected UIPC socket
+ * @param ring_size Size of each ring, rounded up to a power of 2
+ * @return the rings, or NULL on failure
+ */
+tUIPC_SHM* UIPC_ShmCreate(int sock_fd, uint32_t ring_size);
+
+/**
+ * Receive the rings on the audio server side
+ *
+ * @param sock_fd UIPC socket connected to the stack
+ * @return the rings, or NULL on failure
+ */
+tUIPC_SHM* UIPC_ShmConnect(int sock_fd);
+
+/**
+ * Unmap the rings and close the file descriptors
+ */
+void UIPC_ShmFree(tUIPC_SHM* shm);
+
+/**
+ * Read from the incoming ring, waiting for the data up to a timeout
+ *
+ * @param sock_fd Socket polled for hang-ups while waiting
+ * @param tmo_ms Timeout while no data is received
+ * @return the number of bytes read, -1 when the socket is detached
+ */
+ssize_t UIPC_ShmRead(tUIPC_SHM* shm, uint8_t* p_buf, uint32_t len, int sock_fd,
+                     int tmo_ms);
+
+/**
+ * Write to the outgoing ring, waiting for space up to a timeout
+ *
+ * @param sock_fd Socket polled for hang-ups while waiting
+ * @param tmo_ms Timeout while no space is released
+ * @return the number of bytes written, -1 when the socket is detached
+ */
+ssize_t UIPC_ShmWrite(tUIPC_SHM* shm, const uint8_t* p_buf, uint32_t len,
+                      int sock_fd, int tmo_ms);
+
+/**
+ * Discard the data of the incoming ring
+ */
+void UIPC_ShmFlush(tUIPC_SHM* shm);
+
+#endif /* UIPC_SHM_H */
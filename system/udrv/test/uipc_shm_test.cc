@@ -0,0 +1,320 @@
+/*
+ * Copyright 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "udrv/include/uipc_shm.h"
+
+#include <dirent.h>
+#include <gtest/gtest.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <future>
+#include <thread>
+#include <vector>
+
+namespace {
+
+/* Smallest ring, rounded up from anything smaller */
+constexpr uint32_t kRingSize = 1024;
+constexpr int kShortTmoMs = 20;
+constexpr int kLongTmoMs = 5000;
+
+/* Layout of the message passing the file descriptors */
+struct ShmMsg {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t ring_size;
+};
+
+std::vector<uint8_t> MakeData(size_t size, uint8_t seed) {
+  std::vector<uint8_t> data(size);
+  for (size_t i = 0; i < size; i++)
+    data[i] = (uint8_t)(seed + i * 7 + i / 251);
+  return data;
+}
+
+int CountOpenFds() {
+  int count = 0;
+  DIR* dir = opendir("/proc/self/fd");
+  if (dir == nullptr) return -1;
+  while (readdir(dir) != nullptr) count++;
+  closedir(dir);
+  return count;
+}
+
+/* Send |msg_size| bytes of |msg| with |num_fds| eventfds attached */
+void SendMsg(int sock_fd, const ShmMsg& msg, size_t msg_size, int num_fds) {
+  std::vector<int> fds(num_fds);
+  for (int& fd : fds) fd = eventfd(0, EFD_CLOEXEC);
+
+  struct iovec iov = {const_cast<ShmMsg*>(&msg), msg_size};
+  std::vector<char> control(CMSG_SPACE(num_fds * sizeof(int)));
+  struct msghdr mh;
+  memset(&mh, 0, sizeof(mh));
+  mh.msg_iov = &iov;
+  mh.msg_iovlen = 1;
+  if (num_fds > 0) {
+    mh.msg_control = control.data();
+    mh.msg_controllen = control.size();
+    struct cmsghdr* cmsg = CMSG_FIRSTHDR(&mh);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(num_fds * sizeof(int));
+    memcpy(CMSG_DATA(cmsg), fds.data(), num_fds * sizeof(int));
+  }
+
+  ASSERT_EQ((ssize_t)msg_size, sendmsg(sock_fd, &mh, MSG_NOSIGNAL));
+  for (int fd : fds) close(fd);
+}
+
+}  // namespace
+
+class UipcShmTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM, 0, sock_));
+    stack_ = UIPC_ShmCreate(sock_[0], 1);
+    ASSERT_NE(nullptr, stack_);
+    peer_ = UIPC_ShmConnect(sock_[1]);
+    ASSERT_NE(nullptr, peer_);
+  }
+
+  void TearDown() override {
+    UIPC_ShmFree(stack_);
+    UIPC_ShmFree(peer_);
+    for (int fd : sock_)
+      if (fd >= 0) close(fd);
+  }
+
+  ssize_t StackRead(uint8_t* buf, uint32_t len, int tmo_ms) {
+    return UIPC_ShmRead(stack_, buf, len, sock_[0], tmo_ms);
+  }
+
+  ssize_t PeerWrite(const std::vector<uint8_t>& data, int tmo_ms) {
+    return UIPC_ShmWrite(peer_, data.data(), data.size(), sock_[1], tmo_ms);
+  }
+
+  int sock_[2] = {-1, -1};
+  tUIPC_SHM* stack_ = nullptr;
+  tUIPC_SHM* peer_ = nullptr;
+};
+
+TEST_F(UipcShmTest, exchange_both_directions) {
+  auto to_stack = MakeData(300, 1);
+  ASSERT_EQ((ssize_t)to_stack.size(), PeerWrite(to_stack, kShortTmoMs));
+  std::vector<uint8_t> buf(to_stack.size());
+  ASSERT_EQ((ssize_t)buf.size(), StackRead(buf.data(), buf.size(), 0));
+  EXPECT_EQ(to_stack, buf);
+
+  auto to_peer = MakeData(200, 2);
+  ASSERT_EQ((ssize_t)to_peer.size(),
+            UIPC_ShmWrite(stack_, to_peer.data(), to_peer.size(), sock_[0],
+                          kShortTmoMs));
+  buf.resize(to_peer.size());
+  ASSERT_EQ((ssize_t)buf.size(),
+            UIPC_ShmRead(peer_, buf.data(), buf.size(), sock_[1], 0));
+  EXPECT_EQ(to_peer, buf);
+}
+
+TEST_F(UipcShmTest, wraparound) {
+  /* Chunks that are not a divisor of the ring size, so that the copies are
+   * split at every possible offset of the end of the ring */
+  std::vector<uint8_t> buf(700);
+  for (int i = 0; i < 50; i++) {
+    auto data = MakeData(buf.size(), i);
+    ASSERT_EQ((ssize_t)data.size(), PeerWrite(data, kShortTmoMs));
+    ASSERT_EQ((ssize_t)buf.size(), StackRead(buf.data(), buf.size(), 0));
+    ASSERT_EQ(data, buf) << "chunk " << i;
+  }
+}
+
+TEST_F(UipcShmTest, partial_read_at_timeout) {
+  auto data = MakeData(100, 3);
+  ASSERT_EQ((ssize_t)data.size(), PeerWrite(data, kShortTmoMs));
+
+  std::vector<uint8_t> buf(200);
+  ASSERT_EQ((ssize_t)data.size(),
+            StackRead(buf.data(), buf.size(), kShortTmoMs));
+  buf.resize(data.size());
+  EXPECT_EQ(data, buf);
+
+  ASSERT_EQ(0, StackRead(buf.data(), buf.size(), kShortTmoMs));
+}
+
+TEST_F(UipcShmTest, partial_write_at_timeout) {
+  auto data = MakeData(kRingSize + 500, 4);
+  ASSERT_EQ((ssize_t)kRingSize, PeerWrite(data, kShortTmoMs));
+  ASSERT_EQ(0, PeerWrite(data, kShortTmoMs));
+
+  std::vector<uint8_t> buf(kRingSize);
+  ASSERT_EQ((ssize_t)buf.size(), StackRead(buf.data(), buf.size(), 0));
+  EXPECT_TRUE(std::equal(buf.begin(), buf.end(), data.begin()));
+}
+
+TEST_F(UipcShmTest, reader_is_woken_up_at_its_level) {
+  auto data = MakeData(3 * kRingSize + 100, 5);
+  std::vector<uint8_t> buf(data.size());
+
+  /* The reader waits for more than a ring, hence is woken up when the ring
+   * is full, then for the rest */
+  auto reader = std::async(std::launch::async, [&] {
+    return StackRead(buf.data(), buf.size(), kLongTmoMs);
+  });
+
+  for (size_t offset = 0; offset < data.size(); offset += 100) {
+    std::vector<uint8_t> chunk(
+        data.begin() + offset,
+        data.begin() + std::min(offset + 100, data.size()));
+    ASSERT_EQ((ssize_t)chunk.size(), PeerWrite(chunk, kLongTmoMs));
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+
+  ASSERT_EQ((ssize_t)data.size(), reader.get());
+  EXPECT_EQ(data, buf);
+}
+
+TEST_F(UipcShmTest, writer_is_woken_up_at_its_level) {
+  auto data = MakeData(4 * kRingSize, 6);
+
+  auto writer = std::async(std::launch::async,
+                           [&] { return PeerWrite(data, kLongTmoMs); });
+
+  std::vector<uint8_t> buf;
+  std::vector<uint8_t> chunk(100);
+  while (buf.size() < data.size()) {
+    size_t len = std::min(chunk.size(), data.size() - buf.size());
+    ASSERT_EQ((ssize_t)len, StackRead(chunk.data(), len, kLongTmoMs));
+    buf.insert(buf.end(), chunk.begin(), chunk.begin() + len);
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+
+  ASSERT_EQ((ssize_t)data.size(), writer.get());
+  EXPECT_EQ(data, buf);
+}
+
+TEST_F(UipcShmTest, flush_discards_the_data) {
+  auto data = MakeData(500, 7);
+  ASSERT_EQ((ssize_t)data.size(), PeerWrite(data, kShortTmoMs));
+
+  UIPC_ShmFlush(stack_);
+
+  std::vector<uint8_t> buf(data.size());
+  ASSERT_EQ(0, StackRead(buf.data(), buf.size(), kShortTmoMs));
+
+  auto next = MakeData(300, 8);
+  ASSERT_EQ((ssize_t)next.size(), PeerWrite(next, kShortTmoMs));
+  buf.resize(next.size());
+  ASSERT_EQ((ssize_t)buf.size(), StackRead(buf.data(), buf.size(), 0));
+  EXPECT_EQ(next, buf);
+}
+
+TEST_F(UipcShmTest, flush_wakes_up_the_writer) {
+  auto data = MakeData(2 * kRingSize, 9);
+
+  auto writer = std::async(std::launch::async,
+                           [&] { return PeerWrite(data, kLongTmoMs); });
+
+  /* Let the writer fill the ring and wait for space */
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  UIPC_ShmFlush(stack_);
+
+  std::vector<uint8_t> buf(kRingSize);
+  ASSERT_EQ((ssize_t)buf.size(),
+            StackRead(buf.data(), buf.size(), kLongTmoMs));
+  ASSERT_EQ((ssize_t)data.size(), writer.get());
+  EXPECT_TRUE(std::equal(buf.begin(), buf.end(), data.begin() + kRingSize));
+}
+
+TEST_F(UipcShmTest, read_detects_hang_up) {
+  close(sock_[1]);
+  sock_[1] = -1;
+
+  std::vector<uint8_t> buf(100);
+  auto start = std::chrono::steady_clock::now();
+  ASSERT_EQ(-1, StackRead(buf.data(), buf.size(), kLongTmoMs));
+  EXPECT_LT(std::chrono::steady_clock::now() - start,
+            std::chrono::milliseconds(kLongTmoMs));
+}
+
+TEST_F(UipcShmTest, write_detects_hang_up) {
+  auto data = MakeData(kRingSize + 1, 10);
+  close(sock_[0]);
+  sock_[0] = -1;
+
+  auto start = std::chrono::steady_clock::now();
+  ASSERT_EQ(-1, PeerWrite(data, kLongTmoMs));
+  EXPECT_LT(std::chrono::steady_clock::now() - start,
+            std::chrono::milliseconds(kLongTmoMs));
+}
+
+class UipcShmConnectTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM, 0, sock_));
+    num_fds_ = CountOpenFds();
+  }
+
+  void TearDown() override {
+    /* The file descriptors received with a malformed message are closed */
+    EXPECT_EQ(num_fds_, CountOpenFds());
+    close(sock_[0]);
+    close(sock_[1]);
+  }
+
+  int sock_[2] = {-1, -1};
+  int num_fds_ = 0;
+};
+
+TEST_F(UipcShmConnectTest, rejects_message_without_fds) {
+  ShmMsg msg = {UIPC_SHM_MAGIC, UIPC_SHM_VERSION, kRingSize};
+  SendMsg(sock_[0], msg, sizeof(msg), 0);
+  ASSERT_EQ(nullptr, UIPC_ShmConnect(sock_[1]));
+}
+
+TEST_F(UipcShmConnectTest, rejects_short_message) {
+  ShmMsg msg = {UIPC_SHM_MAGIC, UIPC_SHM_VERSION, kRingSize};
+  SendMsg(sock_[0], msg, sizeof(msg.magic), 5);
+  ASSERT_EQ(nullptr, UIPC_ShmConnect(sock_[1]));
+}
+
+TEST_F(UipcShmConnectTest, rejects_missing_fds) {
+  ShmMsg msg = {UIPC_SHM_MAGIC, UIPC_SHM_VERSION, kRingSize};
+  SendMsg(sock_[0], msg, sizeof(msg), 2);
+  ASSERT_EQ(nullptr, UIPC_ShmConnect(sock_[1]));
+}
+
+TEST_F(UipcShmConnectTest, rejects_bad_magic) {
+  ShmMsg msg = {UIPC_SHM_MAGIC + 1, UIPC_SHM_VERSION, kRingSize};
+  SendMsg(sock_[0], msg, sizeof(msg), 5);
+  ASSERT_EQ(nullptr, UIPC_ShmConnect(sock_[1]));
+}
+
+TEST_F(UipcShmConnectTest, rejects_bad_ring_size) {
+  ShmMsg msg = {UIPC_SHM_MAGIC, UIPC_SHM_VERSION, kRingSize + 1};
+  SendMsg(sock_[0], msg, sizeof(msg), 5);
+  ASSERT_EQ(nullptr, UIPC_ShmConnect(sock_[1]));
+}
+
+TEST_F(UipcShmConnectTest, rejects_memory_smaller_than_the_rings) {
+  /* Valid message, but the first fd is an eventfd instead of the memfd */
+  ShmMsg msg = {UIPC_SHM_MAGIC, UIPC_SHM_VERSION, kRingSize};
+  SendMsg(sock_[0], msg, sizeof(msg), 5);
+  ASSERT_EQ(nullptr, UIPC_ShmConnect(sock_[1]));
+}
@@ -200,6 +200,7 @@ static int uipc_main_init(tUIPC_STATE& uipc) {
     p->fd = UIPC_DISCONNECTED;
     p->task_evt_flags = 0;
     p->cback = NULL;
+    uipc.shm[i].reset();
   }
 
   return 0;
@@ -243,6 +244,7 @@ static int uipc_check_fd_locked(tUIPC_STATE& uipc, tUIPC_CH_ID ch_id) {
       close(uipc.ch[ch_id].fd);
       FD_CLR(uipc.ch[ch_id].fd, &uipc.active_set);
       uipc.ch[ch_id].fd = UIPC_DISCONNECTED;
+      uipc.shm[ch_id].reset();
     }
 
     uipc.ch[ch_id].fd = accept_server_socket(uipc.ch[ch_id].srvfd);
@@ -331,6 +333,11 @@ static void uipc_flush_ch_locked(tUIPC_STATE& uipc, tUIPC_CH_ID ch_id) {
     return;
   }
 
+  if (uipc.shm[ch_id]) {
+    UIPC_ShmFlush(uipc.shm[ch_id].get());
+    return;
+  }
+
   while (1) {
     int ret;
     OSI_NO_INTR(ret = poll(&pfd, 1, 1));
@@ -390,6 +397,7 @@ static int uipc_close_ch_locked(tUIPC_STATE& uipc, tUIPC_CH_ID ch_id) {
     close(uipc.ch[ch_id].fd);
     FD_CLR(uipc.ch[ch_id].fd, &uipc.active_set);
     uipc.ch[ch_id].fd = UIPC_DISCONNECTED;
+    uipc.shm[ch_id].reset();
     wakeup = 1;
   }
 
@@ -584,6 +592,14 @@ bool UIPC_Send(tUIPC_STATE& uipc, tUIPC_CH_ID ch_id,
 
   std::lock_guard<std::recursive_mutex> lock(uipc.mutex);
 
+  if (ch_id < UIPC_CH_NUM && uipc.shm[ch_id]) {
+    ssize_t n =
+        UIPC_ShmWrite(uipc.shm[ch_id].get(), p_buf, msglen, uipc.ch[ch_id].fd,
+                      uipc.ch[ch_id].read_poll_tmo_ms);
+    if (n < 0) uipc_close_locked(uipc, ch_id);
+    return n == msglen;
+  }
+
   ssize_t ret;
   OSI_NO_INTR(ret = write(uipc.ch[ch_id].fd, p_buf, msglen));
   if (ret < 0) {
@@ -620,6 +636,23 @@ uint32_t UIPC_Read(tUIPC_STATE& uipc, tUIPC_CH_ID ch_id, uint8_t* p_buf,
     return 0;
   }
 
+  std::shared_ptr<tUIPC_SHM> shm;
+  {
+    std::lock_guard<std::recursive_mutex> lock(uipc.mutex);
+    shm = uipc.shm[ch_id];
+  }
+
+  if (shm) {
+    ssize_t n = UIPC_ShmRead(shm.get(), p_buf, len, fd,
+                             uipc.ch[ch_id].read_poll_tmo_ms);
+    if (n < 0) {
+      std::lock_guard<std::recursive_mutex> lock(uipc.mutex);
+      uipc_close_locked(uipc, ch_id);
+      return 0;
+    }
+    return n;
+  }
+
   while (n_read < (int)len) {
     pfd.fd = fd;
     pfd.events = POLLIN | POLLHUP;
@@ -704,6 +737,18 @@ bool UIPC_Ioctl(tUIPC_STATE& uipc, tUIPC_CH_ID ch_id, uint32_t request,
                 uipc.ch[ch_id].read_poll_tmo_ms);
       break;
 
+    case UIPC_SET_SHM_RING:
+      if (ch_id >= UIPC_CH_NUM || uipc.ch[ch_id].fd == UIPC_DISCONNECTED) {
+        LOG_ERROR("UIPC_SET_SHM_RING : channel %d not connected", ch_id);
+        return false;
+      }
+      uipc.shm[ch_id].reset(
+          UIPC_ShmCreate(uipc.ch[ch_id].fd, (uint32_t)(intptr_t)param),
+          UIPC_ShmFree);
+      LOG_DEBUG("UIPC_SET_SHM_RING : CH %d, %s", ch_id,
+                uipc.shm[ch_id] ? "enabled" : "failed");
+      return uipc.shm[ch_id] != nullptr;
+
     default:
       LOG_DEBUG("UIPC_Ioctl : request not handled (%d)", request);
       break;
@@ -0,0 +1,510 @@
+/******************************************************************************
+ *
+ *  Copyright 2023 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+/*****************************************************************************
+ *
+ *  Filename:      uipc_shm.cc
+ *
+ *  Description:   Shared memory PCM rings of the UIPC channels
+ *
+ *****************************************************************************/
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <new>
+
+// Define before including log.h
+#define LOG_TAG "uipc"
+
+#include "osi/include/log.h"
+#include "osi/include/osi.h"
+#include "uipc_shm.h"
+
+/*****************************************************************************
+ *  Constants & Macros
+ *****************************************************************************/
+
+#define UIPC_SHM_RING_TO_STACK 0
+#define UIPC_SHM_RING_TO_PEER 1
+#define UIPC_SHM_NUM_RINGS 2
+
+/* Eventfds of a ring, signaled to its reader and to its writer */
+#define UIPC_SHM_EFD_DATA 0
+#define UIPC_SHM_EFD_SPACE 1
+
+/* The memfd, followed by the eventfds of the rings */
+#define UIPC_SHM_NUM_FDS (1 + 2 * UIPC_SHM_NUM_RINGS)
+
+#define UIPC_SHM_MIN_RING_SIZE 1024
+#define UIPC_SHM_MAX_RING_SIZE (1 << 22)
+
+#define UIPC_SHM_CACHE_LINE 64
+
+/*****************************************************************************
+ *  Local type definitions
+ *****************************************************************************/
+
+/* Control of a ring, in shared memory. The positions are free running; the
+ * fields written by the writer and by the reader are on distinct cache
+ * lines. A side sets its "waiting" flag and the level it waits for before
+ * sleeping on its eventfd; the other side clears the flag and signals the
+ * eventfd when the level is crossed. */
+typedef struct {
+  alignas(UIPC_SHM_CACHE_LINE) std::atomic<uint32_t> write_pos;
+  std::atomic<uint32_t> writer_waiting;
+  std::atomic<uint32_t> writer_level;
+
+  alignas(UIPC_SHM_CACHE_LINE) std::atomic<uint32_t> read_pos;
+  std::atomic<uint32_t> reader_waiting;
+  std::atomic<uint32_t> reader_level;
+} tUIPC_SHM_RING_CTRL;
+
+/* Start of the shared memory, followed by the data of the rings */
+typedef struct {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t ring_size;
+  tUIPC_SHM_RING_CTRL ring[UIPC_SHM_NUM_RINGS];
+} tUIPC_SHM_HDR;
+
+/* Message passing the file descriptors */
+typedef struct {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t ring_size;
+} tUIPC_SHM_MSG;
+
+static_assert(std::atomic<uint32_t>::is_always_lock_free,
+              "The ring positions are shared between processes");
+
+#define UIPC_SHM_DATA_OFFSET                           \
+  ((sizeof(tUIPC_SHM_HDR) + UIPC_SHM_CACHE_LINE - 1) & \
+   ~(size_t)(UIPC_SHM_CACHE_LINE - 1))
+
+/* A ring, as seen by this process. The size and the data pointer are local,
+ * so that a misbehaving peer cannot get them out of the mapping. */
+typedef struct {
+  tUIPC_SHM_RING_CTRL* ctrl;
+  uint8_t* data;
+  int data_efd;
+  int space_efd;
+} tUIPC_SHM_RING;
+
+struct tUIPC_SHM {
+  void* map;
+  size_t map_size;
+  uint32_t ring_size;
+  int fds[UIPC_SHM_NUM_FDS];
+
+  tUIPC_SHM_RING in;  /* Read by this process */
+  tUIPC_SHM_RING out; /* Written by this process */
+};
+
+/*****************************************************************************
+ *   Helper functions
+ *****************************************************************************/
+
+static size_t uipc_shm_map_size(uint32_t ring_size) {
+  return UIPC_SHM_DATA_OFFSET + (size_t)UIPC_SHM_NUM_RINGS * ring_size;
+}
+
+static void uipc_shm_close_fds(int* fds, int num_fds) {
+  for (int i = 0; i < num_fds; i++)
+    if (fds[i] >= 0) close(fds[i]);
+}
+
+static tUIPC_SHM* uipc_shm_setup(void* map, size_t map_size,
+                                 uint32_t ring_size, const int* fds,
+                                 int ring_in, int ring_out) {
+  tUIPC_SHM* shm = new tUIPC_SHM;
+  tUIPC_SHM_HDR* hdr = (tUIPC_SHM_HDR*)map;
+  uint8_t* data = (uint8_t*)map + UIPC_SHM_DATA_OFFSET;
+
+  shm->map = map;
+  shm->map_size = map_size;
+  shm->ring_size = ring_size;
+  memcpy(shm->fds, fds, sizeof(shm->fds));
+
+  shm->in.ctrl = &hdr->ring[ring_in];
+  shm->in.data = data + ring_in * ring_size;
+  shm->in.data_efd = fds[1 + 2 * ring_in + UIPC_SHM_EFD_DATA];
+  shm->in.space_efd = fds[1 + 2 * ring_in + UIPC_SHM_EFD_SPACE];
+
+  shm->out.ctrl = &hdr->ring[ring_out];
+  shm->out.data = data + ring_out * ring_size;
+  shm->out.data_efd = fds[1 + 2 * ring_out + UIPC_SHM_EFD_DATA];
+  shm->out.space_efd = fds[1 + 2 * ring_out + UIPC_SHM_EFD_SPACE];
+
+  return shm;
+}
+
+/* Signal the other side, when it waits for a level that is now reached */
+static void uipc_shm_wake(std::atomic<uint32_t>& waiting,
+                          const std::atomic<uint32_t>& level, uint32_t amount,
+                          int efd) {
+  if (!waiting.load() || amount < level.load(std::memory_order_relaxed))
+    return;
+
+  if (waiting.exchange(0)) eventfd_write(efd, 1);
+}
+
+/* Sleep until the other side signals |efd|, or the socket is detached.
+ * Return 1 when signaled, 0 on timeout and -1 on hang-up. */
+static int uipc_shm_wait(int efd, int sock_fd, int tmo_ms) {
+  struct pollfd pfd[2];
+  pfd[0].fd = efd;
+  pfd[0].events = POLLIN;
+  pfd[1].fd = sock_fd;
+  pfd[1].events = 0;
+
+  int ret;
+  OSI_NO_INTR(ret = poll(pfd, 2, tmo_ms));
+  if (ret == 0) {
+    LOG_WARN("poll timeout (%d ms)", tmo_ms);
+    return 0;
+  }
+  if (ret < 0) {
+    LOG_ERROR("%s(): poll() failed: return %d errno %d (%s)", __func__, ret,
+              errno, strerror(errno));
+    return 0;
+  }
+
+  if (pfd[1].revents & (POLLHUP | POLLERR | POLLNVAL)) {
+    LOG_WARN("poll : channel detached remotely");
+    return -1;
+  }
+
+  if (pfd[0].revents & POLLIN) {
+    eventfd_t value;
+    eventfd_read(efd, &value);
+  }
+
+  return 1;
+}
+
+/*******************************************************************************
+ **
+ ** Function         UIPC_ShmCreate
+ **
+ ** Description      Create the rings and pass them to the audio server
+ **
+ ** Returns          the rings, or NULL on failure
+ **
+ ******************************************************************************/
+tUIPC_SHM* UIPC_ShmCreate(int sock_fd, uint32_t ring_size) {
+  uint32_t size = UIPC_SHM_MIN_RING_SIZE;
+  while (size < ring_size && size < UIPC_SHM_MAX_RING_SIZE) size <<= 1;
+
+  size_t map_size = uipc_shm_map_size(size);
+  int fds[UIPC_SHM_NUM_FDS];
+  memset(fds, -1, sizeof(fds));
+
+  /* The size is sealed, the audio server cannot truncate the memory under
+   * our feet */
+  fds[0] = memfd_create("uipc_shm", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+  if (fds[0] < 0 || ftruncate(fds[0], map_size) < 0 ||
+      fcntl(fds[0], F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL) <
+          0) {
+    LOG_ERROR("failed to create the shared memory (%s)", strerror(errno));
+    uipc_shm_close_fds(fds, UIPC_SHM_NUM_FDS);
+    return NULL;
+  }
+
+  for (int i = 1; i < UIPC_SHM_NUM_FDS; i++) {
+    fds[i] = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (fds[i] < 0) {
+      LOG_ERROR("failed to create eventfd (%s)", strerror(errno));
+      uipc_shm_close_fds(fds, UIPC_SHM_NUM_FDS);
+      return NULL;
+    }
+  }
+
+  void* map =
+      mmap(NULL, map_size, PROT_READ | PROT_WRITE, MAP_SHARED, fds[0], 0);
+  if (map == MAP_FAILED) {
+    LOG_ERROR("failed to map the shared memory (%s)", strerror(errno));
+    uipc_shm_close_fds(fds, UIPC_SHM_NUM_FDS);
+    return NULL;
+  }
+
+  tUIPC_SHM_HDR* hdr = new (map) tUIPC_SHM_HDR();
+  hdr->magic = UIPC_SHM_MAGIC;
+  hdr->version = UIPC_SHM_VERSION;
+  hdr->ring_size = size;
+
+  /* Pass the file descriptors */
+  tUIPC_SHM_MSG msg = {UIPC_SHM_MAGIC, UIPC_SHM_VERSION, size};
+  struct iovec iov = {&msg, sizeof(msg)};
+  union {
+    char buf[CMSG_SPACE(sizeof(fds))];
+    struct cmsghdr align;
+  } control;
+  memset(&control, 0, sizeof(control));
+
+  struct msghdr mh;
+  memset(&mh, 0, sizeof(mh));
+  mh.msg_iov = &iov;
+  mh.msg_iovlen = 1;
+  mh.msg_control = control.buf;
+  mh.msg_controllen = sizeof(control.buf);
+
+  struct cmsghdr* cmsg = CMSG_FIRSTHDR(&mh);
+  cmsg->cmsg_level = SOL_SOCKET;
+  cmsg->cmsg_type = SCM_RIGHTS;
+  cmsg->cmsg_len = CMSG_LEN(sizeof(fds));
+  memcpy(CMSG_DATA(cmsg), fds, sizeof(fds));
+
+  ssize_t ret;
+  OSI_NO_INTR(ret = sendmsg(sock_fd, &mh, MSG_NOSIGNAL));
+  if (ret != (ssize_t)sizeof(msg)) {
+    LOG_ERROR("failed to pass the shared memory (%s)", strerror(errno));
+    munmap(map, map_size);
+    uipc_shm_close_fds(fds, UIPC_SHM_NUM_FDS);
+    return NULL;
+  }
+
+  LOG_DEBUG("UIPC_ShmCreate : fd %d, ring size %u", sock_fd, size);
+
+  return uipc_shm_setup(map, map_size, size, fds, UIPC_SHM_RING_TO_STACK,
+                        UIPC_SHM_RING_TO_PEER);
+}
+
+/*******************************************************************************
+ **
+ ** Function         UIPC_ShmConnect
+ **
+ ** Description      Receive the rings from the stack
+ **
+ ** Returns          the rings, or NULL on failure
+ **
+ ******************************************************************************/
+tUIPC_SHM* UIPC_ShmConnect(int sock_fd) {
+  tUIPC_SHM_MSG msg;
+  struct iovec iov = {&msg, sizeof(msg)};
+  union {
+    char buf[CMSG_SPACE(UIPC_SHM_NUM_FDS * sizeof(int))];
+    struct cmsghdr align;
+  } control;
+
+  struct msghdr mh;
+  memset(&mh, 0, sizeof(mh));
+  mh.msg_iov = &iov;
+  mh.msg_iovlen = 1;
+  mh.msg_control = control.buf;
+  mh.msg_controllen = sizeof(control.buf);
+
+  ssize_t ret;
+  OSI_NO_INTR(ret = recvmsg(sock_fd, &mh, MSG_CMSG_CLOEXEC));
+
+  int fds[UIPC_SHM_NUM_FDS];
+  memset(fds, -1, sizeof(fds));
+
+  struct cmsghdr* cmsg = ret > 0 ? CMSG_FIRSTHDR(&mh) : NULL;
+  if (cmsg != NULL && cmsg->cmsg_level == SOL_SOCKET &&
+      cmsg->cmsg_type == SCM_RIGHTS) {
+    size_t num_fds = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+    if (num_fds > UIPC_SHM_NUM_FDS) num_fds = UIPC_SHM_NUM_FDS;
+    memcpy(fds, CMSG_DATA(cmsg), num_fds * sizeof(int));
+  }
+
+  if (ret != (ssize_t)sizeof(msg) || msg.magic != UIPC_SHM_MAGIC ||
+      msg.version != UIPC_SHM_VERSION || fds[UIPC_SHM_NUM_FDS - 1] < 0 ||
+      msg.ring_size < UIPC_SHM_MIN_RING_SIZE ||
+      msg.ring_size > UIPC_SHM_MAX_RING_SIZE ||
+      (msg.ring_size & (msg.ring_size - 1))) {
+    LOG_ERROR("invalid shared memory message");
+    uipc_shm_close_fds(fds, UIPC_SHM_NUM_FDS);
+    return NULL;
+  }
+
+  size_t map_size = uipc_shm_map_size(msg.ring_size);
+  struct stat st;
+  if (fstat(fds[0], &st) < 0 || (size_t)st.st_size < map_size) {
+    LOG_ERROR("invalid shared memory size");
+    uipc_shm_close_fds(fds, UIPC_SHM_NUM_FDS);
+    return NULL;
+  }
+
+  void* map =
+      mmap(NULL, map_size, PROT_READ | PROT_WRITE, MAP_SHARED, fds[0], 0);
+  if (map == MAP_FAILED) {
+    LOG_ERROR("failed to map the shared memory (%s)", strerror(errno));
+    uipc_shm_close_fds(fds, UIPC_SHM_NUM_FDS);
+    return NULL;
+  }
+
+  return uipc_shm_setup(map, map_size, msg.ring_size, fds,
+                        UIPC_SHM_RING_TO_PEER, UIPC_SHM_RING_TO_STACK);
+}
+
+/*******************************************************************************
+ **
+ ** Function         UIPC_ShmFree
+ **
+ ** Description      Unmap the rings and close the file descriptors
+ **
+ ** Returns          void
+ **
+ ******************************************************************************/
+void UIPC_ShmFree(tUIPC_SHM* shm) {
+  if (shm == NULL) return;
+
+  munmap(shm->map, shm->map_size);
+  uipc_shm_close_fds(shm->fds, UIPC_SHM_NUM_FDS);
+  delete shm;
+}
+
+/*******************************************************************************
+ **
+ ** Function         UIPC_ShmRead
+ **
+ ** Description      Read from the incoming ring
+ **
+ ** Returns          the number of bytes read, -1 when detached
+ **
+ ******************************************************************************/
+ssize_t UIPC_ShmRead(tUIPC_SHM* shm, uint8_t* p_buf, uint32_t len,
+                     int sock_fd, int tmo_ms) {
+  tUIPC_SHM_RING_CTRL* ctrl = shm->in.ctrl;
+  const uint32_t size = shm->ring_size;
+  uint32_t n_read = 0;
+
+  while (n_read < len) {
+    uint32_t rd = ctrl->read_pos.load(std::memory_order_relaxed);
+    uint32_t avail = ctrl->write_pos.load(std::memory_order_acquire) - rd;
+    if (avail > size) avail = size;
+
+    if (avail == 0) {
+      /* Wait for the data left to read, or a full ring */
+      uint32_t level = len - n_read < size ? len - n_read : size;
+      ctrl->reader_level.store(level, std::memory_order_relaxed);
+      ctrl->reader_waiting.store(1);
+
+      if (ctrl->write_pos.load() != rd) {
+        ctrl->reader_waiting.store(0);
+        continue;
+      }
+
+      int ret = uipc_shm_wait(shm->in.data_efd, sock_fd, tmo_ms);
+      if (ret <= 0) {
+        ctrl->reader_waiting.store(0);
+        if (ret < 0) return -1;
+        break;
+      }
+      continue;
+    }
+
+    uint32_t n = len - n_read < avail ? len - n_read : avail;
+    uint32_t offset = rd & (size - 1);
+    uint32_t first = n < size - offset ? n : size - offset;
+    memcpy(p_buf + n_read, shm->in.data + offset, first);
+    memcpy(p_buf + n_read + first, shm->in.data, n - first);
+
+    ctrl->read_pos.store(rd + n);
+    n_read += n;
+
+    uipc_shm_wake(ctrl->writer_waiting, ctrl->writer_level,
+                  size - (ctrl->write_pos.load() - (rd + n)),
+                  shm->in.space_efd);
+  }
+
+  return n_read;
+}
+
+/*******************************************************************************
+ **
+ ** Function         UIPC_ShmWrite
+ **
+ ** Description      Write to the outgoing ring
+ **
+ ** Returns          the number of bytes written, -1 when detached
+ **
+ ******************************************************************************/
+ssize_t UIPC_ShmWrite(tUIPC_SHM* shm, const uint8_t* p_buf, uint32_t len,
+                      int sock_fd, int tmo_ms) {
+  tUIPC_SHM_RING_CTRL* ctrl = shm->out.ctrl;
+  const uint32_t size = shm->ring_size;
+  uint32_t n_written = 0;
+
+  while (n_written < len) {
+    uint32_t wr = ctrl->write_pos.load(std::memory_order_relaxed);
+    uint32_t fill = wr - ctrl->read_pos.load(std::memory_order_acquire);
+    uint32_t space = fill < size ? size - fill : 0;
+
+    if (space == 0) {
+      /* Wait for the space of the data left to write, or an empty ring */
+      uint32_t level = len - n_written < size ? len - n_written : size;
+      ctrl->writer_level.store(level, std::memory_order_relaxed);
+      ctrl->writer_waiting.store(1);
+
+      if (wr - ctrl->read_pos.load() < size) {
+        ctrl->writer_waiting.store(0);
+        continue;
+      }
+
+      int ret = uipc_shm_wait(shm->out.space_efd, sock_fd, tmo_ms);
+      if (ret <= 0) {
+        ctrl->writer_waiting.store(0);
+        if (ret < 0) return -1;
+        break;
+      }
+      continue;
+    }
+
+    uint32_t n = len - n_written < space ? len - n_written : space;
+    uint32_t offset = wr & (size - 1);
+    uint32_t first = n < size - offset ? n : size - offset;
+    memcpy(shm->out.data + offset, p_buf + n_written, first);
+    memcpy(shm->out.data, p_buf + n_written + first, n - first);
+
+    ctrl->write_pos.store(wr + n);
+    n_written += n;
+
+    uipc_shm_wake(ctrl->reader_waiting, ctrl->reader_level,
+                  wr + n - ctrl->read_pos.load(), shm->out.data_efd);
+  }
+
+  return n_written;
+}
+
+/*******************************************************************************
+ **
+ ** Function         UIPC_ShmFlush
+ **
+ ** Description      Discard the data of the incoming ring
+ **
+ ** Returns          void
+ **
+ ******************************************************************************/
+void UIPC_ShmFlush(tUIPC_SHM* shm) {
+  tUIPC_SHM_RING_CTRL* ctrl = shm->in.ctrl;
+  uint32_t wr = ctrl->write_pos.load(std::memory_order_acquire);
+
+  ctrl->read_pos.store(wr);
+  uipc_shm_wake(ctrl->writer_waiting, ctrl->writer_level, shm->ring_size,
+                shm->in.space_efd);
+}